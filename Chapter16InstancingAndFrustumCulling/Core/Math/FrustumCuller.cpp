@@ -0,0 +1,206 @@
+#include "pch.h"
+#include "FrustumCuller.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+using namespace Math;
+
+void BoundingBoxSoA::Clear( void )
+{
+    m_CenterX.clear(); m_CenterY.clear(); m_CenterZ.clear();
+    m_ExtentX.clear(); m_ExtentY.clear(); m_ExtentZ.clear();
+}
+
+void BoundingBoxSoA::Reserve( uint32_t Count )
+{
+    m_CenterX.reserve(Count); m_CenterY.reserve(Count); m_CenterZ.reserve(Count);
+    m_ExtentX.reserve(Count); m_ExtentY.reserve(Count); m_ExtentZ.reserve(Count);
+}
+
+void BoundingBoxSoA::Resize( uint32_t Count )
+{
+    m_CenterX.resize(Count); m_CenterY.resize(Count); m_CenterZ.resize(Count);
+    m_ExtentX.resize(Count); m_ExtentY.resize(Count); m_ExtentZ.resize(Count);
+}
+
+uint32_t BoundingBoxSoA::Add( const DirectX::BoundingBox& box )
+{
+    uint32_t Index = GetCount();
+    Resize(Index + 1);
+    Set(Index, box);
+    return Index;
+}
+
+void BoundingBoxSoA::Set( uint32_t Index, const DirectX::BoundingBox& box )
+{
+    m_CenterX[Index] = box.Center.x;
+    m_CenterY[Index] = box.Center.y;
+    m_CenterZ[Index] = box.Center.z;
+    m_ExtentX[Index] = box.Extents.x;
+    m_ExtentY[Index] = box.Extents.y;
+    m_ExtentZ[Index] = box.Extents.z;
+}
+
+namespace
+{
+    // Boxes per ThreadPool job. Below this the whole set is culled on the calling thread.
+    const uint32_t kCullChunkSize = 16 * 1024;
+
+    struct CullPlanes
+    {
+        float N[3][6];      // plane normals, one array per component
+        float AbsN[3][6];   // |n|, projects the extents onto the normal
+        float D[6];
+    };
+
+    // A box is outside when even its corner furthest along the plane normal is behind it:
+    //     dot(n, c) + d + dot(|n|, e) < 0
+    // Writes the indices of the surviving boxes in [Begin, End) to Out, returns how many.
+    uint32_t CullRange( const CullPlanes& P, const BoundingBoxSoA& Boxes, uint32_t Begin, uint32_t End, uint32_t* Out )
+    {
+        const float* CX = Boxes.CenterX();
+        const float* CY = Boxes.CenterY();
+        const float* CZ = Boxes.CenterZ();
+        const float* EX = Boxes.ExtentX();
+        const float* EY = Boxes.ExtentY();
+        const float* EZ = Boxes.ExtentZ();
+
+        uint32_t NumVisible = 0;
+        uint32_t i = Begin;
+
+#if defined(__AVX__)
+        for (; i + 8 <= End; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(CX + i), cy = _mm256_loadu_ps(CY + i), cz = _mm256_loadu_ps(CZ + i);
+            __m256 ex = _mm256_loadu_ps(EX + i), ey = _mm256_loadu_ps(EY + i), ez = _mm256_loadu_ps(EZ + i);
+
+            __m256 Outside = _mm256_setzero_ps();
+            for (int p = 0; p < 6; ++p)
+            {
+                __m256 Dist = _mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(cx, _mm256_set1_ps(P.N[0][p])),
+                    _mm256_mul_ps(cy, _mm256_set1_ps(P.N[1][p]))),
+                    _mm256_add_ps(_mm256_mul_ps(cz, _mm256_set1_ps(P.N[2][p])), _mm256_set1_ps(P.D[p])));
+                __m256 Radius = _mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(ex, _mm256_set1_ps(P.AbsN[0][p])),
+                    _mm256_mul_ps(ey, _mm256_set1_ps(P.AbsN[1][p]))),
+                    _mm256_mul_ps(ez, _mm256_set1_ps(P.AbsN[2][p])));
+                Outside = _mm256_or_ps(Outside, _mm256_cmp_ps(_mm256_add_ps(Dist, Radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+            }
+
+            // branch-free compaction: always write, only advance for visible lanes
+            uint32_t Mask = ~(uint32_t)_mm256_movemask_ps(Outside) & 0xFF;
+            for (uint32_t k = 0; k < 8; ++k)
+            {
+                Out[NumVisible] = i + k;
+                NumVisible += (Mask >> k) & 1;
+            }
+        }
+#else
+        for (; i + 4 <= End; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(CX + i), cy = _mm_loadu_ps(CY + i), cz = _mm_loadu_ps(CZ + i);
+            __m128 ex = _mm_loadu_ps(EX + i), ey = _mm_loadu_ps(EY + i), ez = _mm_loadu_ps(EZ + i);
+
+            __m128 Outside = _mm_setzero_ps();
+            for (int p = 0; p < 6; ++p)
+            {
+                __m128 Dist = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(cx, _mm_set1_ps(P.N[0][p])),
+                    _mm_mul_ps(cy, _mm_set1_ps(P.N[1][p]))),
+                    _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(P.N[2][p])), _mm_set1_ps(P.D[p])));
+                __m128 Radius = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(ex, _mm_set1_ps(P.AbsN[0][p])),
+                    _mm_mul_ps(ey, _mm_set1_ps(P.AbsN[1][p]))),
+                    _mm_mul_ps(ez, _mm_set1_ps(P.AbsN[2][p])));
+                Outside = _mm_or_ps(Outside, _mm_cmplt_ps(_mm_add_ps(Dist, Radius), _mm_setzero_ps()));
+            }
+
+            uint32_t Mask = ~(uint32_t)_mm_movemask_ps(Outside) & 0xF;
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+                Out[NumVisible] = i + k;
+                NumVisible += (Mask >> k) & 1;
+            }
+        }
+#endif
+
+        // remainder
+        for (; i < End; ++i)
+        {
+            bool Outside = false;
+            for (int p = 0; p < 6; ++p)
+            {
+                float Dist = CX[i] * P.N[0][p] + CY[i] * P.N[1][p] + CZ[i] * P.N[2][p] + P.D[p];
+                float Radius = EX[i] * P.AbsN[0][p] + EY[i] * P.AbsN[1][p] + EZ[i] * P.AbsN[2][p];
+                Outside |= Dist + Radius < 0.0f;
+            }
+            Out[NumVisible] = i;
+            NumVisible += Outside ? 0 : 1;
+        }
+
+        return NumVisible;
+    }
+}
+
+uint32_t Math::CullBoxes( const float Planes[6][4], const BoundingBoxSoA& Boxes, std::vector<uint32_t>& Visible )
+{
+    CullPlanes P;
+    for (int p = 0; p < 6; ++p)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            P.N[c][p] = Planes[p][c];
+            P.AbsN[c][p] = std::fabs(Planes[p][c]);
+        }
+        P.D[p] = Planes[p][3];
+    }
+
+    const uint32_t Count = Boxes.GetCount();
+    Visible.resize(Count);
+
+    if (Count <= kCullChunkSize)
+    {
+        Visible.resize(CullRange(P, Boxes, 0, Count, Visible.data()));
+        return (uint32_t)Visible.size();
+    }
+
+    // each chunk compacts into its own slice of Visible, then the slices are packed together
+    const uint32_t NumChunks = (Count + kCullChunkSize - 1) / kCullChunkSize;
+    std::vector<uint32_t> ChunkVisible(NumChunks);
+
+    ThreadPool::ParallelFor(0, (int)NumChunks, [&](int Chunk)
+    {
+        uint32_t Begin = Chunk * kCullChunkSize;
+        uint32_t End = (std::min)(Begin + kCullChunkSize, Count);
+        ChunkVisible[Chunk] = CullRange(P, Boxes, Begin, End, Visible.data() + Begin);
+    });
+
+    uint32_t NumVisible = ChunkVisible[0];
+    for (uint32_t Chunk = 1; Chunk < NumChunks; ++Chunk)
+    {
+        const uint32_t* Src = Visible.data() + Chunk * kCullChunkSize;
+        std::copy(Src, Src + ChunkVisible[Chunk], Visible.data() + NumVisible);
+        NumVisible += ChunkVisible[Chunk];
+    }
+
+    Visible.resize(NumVisible);
+    return NumVisible;
+}
+
+uint32_t Math::CullBoxes( const Frustum& WorldFrustum, const BoundingBoxSoA& Boxes, std::vector<uint32_t>& Visible )
+{
+    float Planes[6][4];
+    for (int p = 0; p < 6; ++p)
+    {
+        Vector4 Plane = Vector4(WorldFrustum.GetFrustumPlane((Frustum::PlaneID)p));
+        Planes[p][0] = Plane.GetX();
+        Planes[p][1] = Plane.GetY();
+        Planes[p][2] = Plane.GetZ();
+        Planes[p][3] = Plane.GetW();
+    }
+
+    return CullBoxes(Planes, Boxes, Visible);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Frustum.h"
+#include <cstdint>
+#include <vector>
+#include <DirectXCollision.h>
+
+namespace Math
+{
+    // World-space axis aligned boxes stored as a structure of arrays, so the culler can load
+    // the same component of eight boxes with one instruction. Static geometry fills this once;
+    // anything that moves only rewrites its own slot with Set.
+    class BoundingBoxSoA
+    {
+    public:
+        void Clear( void );
+        void Reserve( uint32_t Count );
+        void Resize( uint32_t Count );
+
+        uint32_t Add( const DirectX::BoundingBox& box );
+        void Set( uint32_t Index, const DirectX::BoundingBox& box );
+
+        uint32_t GetCount( void ) const { return (uint32_t)m_CenterX.size(); }
+
+        const float* CenterX( void ) const { return m_CenterX.data(); }
+        const float* CenterY( void ) const { return m_CenterY.data(); }
+        const float* CenterZ( void ) const { return m_CenterZ.data(); }
+        const float* ExtentX( void ) const { return m_ExtentX.data(); }
+        const float* ExtentY( void ) const { return m_ExtentY.data(); }
+        const float* ExtentZ( void ) const { return m_ExtentZ.data(); }
+
+    private:
+        std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+        std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+    };
+
+    // Tests every box against the six planes of a world-space frustum and writes the indices of
+    // the boxes that are not completely outside to Visible, in ascending order. Eight boxes per
+    // iteration with AVX, four with SSE. Large sets are split into chunks on the ThreadPool.
+    // Returns the number of visible boxes.
+    uint32_t CullBoxes( const Frustum& WorldFrustum, const BoundingBoxSoA& Boxes, std::vector<uint32_t>& Visible );
+
+    // Same test on planes given as (nx, ny, nz, d), inside where dot(n, p) + d >= 0
+    uint32_t CullBoxes( const float Planes[6][4], const BoundingBoxSoA& Boxes, std::vector<uint32_t>& Visible );
+
+} // namespace Math
@@ -0,0 +1,268 @@
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace MeshFile;
+using DirectX::XMFLOAT3;
+
+namespace
+{
+    const uint64_t kBlobAlignment = 64;
+
+    uint64_t AlignBlob(uint64_t Offset)
+    {
+        return (Offset + kBlobAlignment - 1) & ~(kBlobAlignment - 1);
+    }
+
+    bool BlobInFile(uint64_t Offset, uint64_t Size, uint64_t FileSize)
+    {
+        return Offset % kBlobAlignment == 0 && Offset <= FileSize && Size <= FileSize - Offset;
+    }
+
+    bool LodsInIndices(const Header& H)
+    {
+        if (H.LodCount == 0 || H.LodCount > kMaxLods)
+            return false;
+
+        for (uint32_t i = 0; i < H.LodCount; ++i)
+        {
+            if (H.Lods[i].StartIndex > H.IndexCount || H.Lods[i].IndexCount > H.IndexCount - H.Lods[i].StartIndex)
+                return false;
+        }
+        return true;
+    }
+
+    // Tangents from the texture coordinates where they are usable. The book's models carry no
+    // texture coordinates, so vertices left without one get any unit vector perpendicular to the normal.
+    void ComputeTangents(const std::vector<Vertex>& Vertices, const std::vector<uint32_t>& Indices, std::vector<XMFLOAT3>& Tangents)
+    {
+        Tangents.assign(Vertices.size(), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+        for (size_t t = 0; t + 2 < Indices.size(); t += 3)
+        {
+            const Vertex& V0 = Vertices[Indices[t + 0]];
+            const Vertex& V1 = Vertices[Indices[t + 1]];
+            const Vertex& V2 = Vertices[Indices[t + 2]];
+
+            float E1[3] = { V1.Position.x - V0.Position.x, V1.Position.y - V0.Position.y, V1.Position.z - V0.Position.z };
+            float E2[3] = { V2.Position.x - V0.Position.x, V2.Position.y - V0.Position.y, V2.Position.z - V0.Position.z };
+            float DU1 = V1.Tex.x - V0.Tex.x, DV1 = V1.Tex.y - V0.Tex.y;
+            float DU2 = V2.Tex.x - V0.Tex.x, DV2 = V2.Tex.y - V0.Tex.y;
+
+            float Det = DU1 * DV2 - DU2 * DV1;
+            if (std::fabs(Det) < 1e-12f)
+                continue;
+
+            float R = 1.0f / Det;
+            float T[3] = { (E1[0] * DV2 - E2[0] * DV1) * R, (E1[1] * DV2 - E2[1] * DV1) * R, (E1[2] * DV2 - E2[2] * DV1) * R };
+            for (int k = 0; k < 3; ++k)
+            {
+                XMFLOAT3& Out = Tangents[Indices[t + k]];
+                Out.x += T[0]; Out.y += T[1]; Out.z += T[2];
+            }
+        }
+
+        for (size_t i = 0; i < Vertices.size(); ++i)
+        {
+            const XMFLOAT3& N = Vertices[i].Normal;
+            XMFLOAT3& T = Tangents[i];
+
+            // Gram-Schmidt against the normal
+            float NdotT = N.x * T.x + N.y * T.y + N.z * T.z;
+            T.x -= N.x * NdotT; T.y -= N.y * NdotT; T.z -= N.z * NdotT;
+
+            float Length = std::sqrt(T.x * T.x + T.y * T.y + T.z * T.z);
+            if (Length < 1e-6f)
+            {
+                // cross the normal with whichever axis it is least aligned with
+                if (std::fabs(N.x) < 0.9f)
+                    T = XMFLOAT3(0.0f, N.z, -N.y);
+                else
+                    T = XMFLOAT3(-N.z, 0.0f, N.x);
+                Length = std::sqrt(T.x * T.x + T.y * T.y + T.z * T.z);
+                if (Length < 1e-6f)
+                {
+                    T = XMFLOAT3(1.0f, 0.0f, 0.0f);
+                    continue;
+                }
+            }
+
+            T.x /= Length; T.y /= Length; T.z /= Length;
+        }
+    }
+}
+
+bool Mesh::Load(const std::wstring& FileName)
+{
+    Unload();
+
+    if (!m_File.Open(FileName))
+        return false;
+
+    const uint64_t FileSize = m_File.GetSize();
+    const Header* H = (const Header*)m_File.GetData();
+
+    bool Valid = FileSize >= sizeof(Header)
+        && H->Magic == kMagic
+        && H->Version == kVersion
+        && H->VertexStride == sizeof(Vertex)
+        && (H->IndexSize == 2 || H->IndexSize == 4)
+        && H->FileSize == FileSize
+        && LodsInIndices(*H)
+        && BlobInFile(H->VertexOffset, (uint64_t)H->VertexCount * sizeof(Vertex), FileSize)
+        && BlobInFile(H->TangentOffset, (uint64_t)H->VertexCount * sizeof(XMFLOAT3), FileSize)
+        && BlobInFile(H->IndexOffset, (uint64_t)H->IndexCount * H->IndexSize, FileSize);
+
+    if (!Valid)
+    {
+        m_File.Close();
+        return false;
+    }
+
+    m_Header = H;
+    return true;
+}
+
+bool Mesh::LoadOrConvert(const std::wstring& CacheFile, const std::wstring& TextFile)
+{
+    std::error_code Error;
+    auto TextTime = std::filesystem::last_write_time(TextFile, Error);
+    bool HasText = !Error;
+    auto CacheTime = std::filesystem::last_write_time(CacheFile, Error);
+    bool Stale = HasText && (Error || CacheTime < TextTime);
+
+    if (!Stale && Load(CacheFile))
+        return true;
+
+    return HasText && ConvertTextModel(TextFile, CacheFile) && Load(CacheFile);
+}
+
+void Mesh::Unload(void)
+{
+    m_Header = nullptr;
+    m_File.Close();
+}
+
+bool MeshFile::ConvertTextModel(const std::wstring& TextFile, const std::wstring& OutputFile)
+{
+    std::filesystem::path TextPath(TextFile);
+    std::ifstream fin(TextPath);
+    if (!fin)
+        return false;
+
+    uint32_t VertexCount = 0;
+    uint32_t TriangleCount = 0;
+    std::string ignore;
+
+    fin >> ignore >> VertexCount;
+    fin >> ignore >> TriangleCount;
+    fin >> ignore >> ignore >> ignore >> ignore;
+
+    Header H = {};
+    H.Magic = kMagic;
+    H.Version = kVersion;
+    H.VertexCount = VertexCount;
+    H.VertexStride = sizeof(Vertex);
+    H.IndexCount = 3 * TriangleCount;
+    H.IndexSize = VertexCount <= 0xFFFF ? 2 : 4;
+    for (int a = 0; a < 3; ++a)
+    {
+        H.BoundsMin[a] = INFINITY;
+        H.BoundsMax[a] = -INFINITY;
+    }
+
+    std::vector<Vertex> Vertices(VertexCount);
+    for (Vertex& V : Vertices)
+    {
+        fin >> V.Position.x >> V.Position.y >> V.Position.z;
+        fin >> V.Normal.x >> V.Normal.y >> V.Normal.z;
+
+        // Model does not have texture coordinates, so just zero them out.
+        V.Tex = { 0.0f, 0.0f };
+
+        const float* P = &V.Position.x;
+        for (int a = 0; a < 3; ++a)
+        {
+            H.BoundsMin[a] = (std::min)(H.BoundsMin[a], P[a]);
+            H.BoundsMax[a] = (std::max)(H.BoundsMax[a], P[a]);
+        }
+    }
+
+    fin >> ignore;
+    fin >> ignore;
+    fin >> ignore;
+
+    std::vector<uint32_t> Indices(H.IndexCount);
+    for (uint32_t& Index : Indices)
+        fin >> Index;
+
+    if (!fin || Indices.empty())
+        return false;
+
+    for (uint32_t Index : Indices)
+    {
+        if (Index >= VertexCount)
+            return false;
+    }
+
+    // the expensive part of loading a model, done once here instead of at every start: the
+    // coarser levels go after the reordered full detail indices and share its vertices
+    Utility::OptimizeMesh(Vertices, Indices, &Vertex::Position);
+
+    std::vector<XMFLOAT3> Tangents;
+    ComputeTangents(Vertices, Indices, Tangents);
+
+    std::vector<Utility::MeshLod> Lods = Utility::GenerateLods(Indices, &Vertices[0].Position.x, sizeof(Vertex),
+        Vertices.size(), kMaxLods);
+
+    H.VertexCount = (uint32_t)Vertices.size();
+    H.IndexCount = (uint32_t)Indices.size();
+    H.LodCount = (uint32_t)Lods.size();
+    for (uint32_t i = 0; i < H.LodCount; ++i)
+        H.Lods[i] = { Lods[i].StartIndex, Lods[i].IndexCount, Lods[i].Error };
+
+    H.VertexOffset = AlignBlob(sizeof(Header));
+    H.TangentOffset = AlignBlob(H.VertexOffset + (uint64_t)H.VertexCount * sizeof(Vertex));
+    H.IndexOffset = AlignBlob(H.TangentOffset + (uint64_t)H.VertexCount * sizeof(XMFLOAT3));
+    H.FileSize = H.IndexOffset + (uint64_t)H.IndexCount * H.IndexSize;
+
+    std::vector<char> Blob((size_t)H.FileSize, 0);
+    memcpy(Blob.data(), &H, sizeof(Header));
+    memcpy(Blob.data() + H.VertexOffset, Vertices.data(), Vertices.size() * sizeof(Vertex));
+    memcpy(Blob.data() + H.TangentOffset, Tangents.data(), Tangents.size() * sizeof(XMFLOAT3));
+
+    if (H.IndexSize == 2)
+    {
+        uint16_t* Dest = (uint16_t*)(Blob.data() + H.IndexOffset);
+        for (size_t i = 0; i < Indices.size(); ++i)
+            Dest[i] = (uint16_t)Indices[i];
+    }
+    else
+    {
+        memcpy(Blob.data() + H.IndexOffset, Indices.data(), Indices.size() * sizeof(uint32_t));
+    }
+
+    // write to a temporary name first so a reader never maps a half written file
+    std::filesystem::path Output(OutputFile);
+    std::filesystem::path Temp = Output;
+    Temp += L".tmp";
+
+    {
+        std::ofstream fout(Temp, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!fout)
+            return false;
+        fout.write(Blob.data(), Blob.size());
+        if (!fout)
+            return false;
+    }
+
+    std::error_code Error;
+    std::filesystem::rename(Temp, Output, Error);
+    return !Error;
+}
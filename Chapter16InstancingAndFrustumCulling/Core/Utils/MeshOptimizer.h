@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Utility
+{
+    // Post-transform cache behaviour of an index buffer, simulated with a FIFO cache.
+    struct VertexCacheStats
+    {
+        float ACMR;             // vertices transformed per triangle, 0.5 at best, 3 at worst
+        float ATVR;             // vertices transformed per vertex referenced, 1 at best
+        float Overfetch;        // vertex buffer bytes read per byte referenced, 1 at best
+    };
+
+    // CacheSize is the number of vertices the post-transform cache holds. Overfetch assumes
+    // VertexSize byte vertices read through a 4 KB direct mapped cache of 64 byte lines.
+    VertexCacheStats AnalyzeVertexCache(const uint32_t* Indices, size_t IndexCount, size_t VertexCount,
+        size_t VertexSize, uint32_t CacheSize = 16);
+
+    // Reorders triangles for the post-transform cache with Tipsify (Sander, Nehab and Barczak,
+    // "Fast triangle reordering for vertex locality and reduced overdraw", 2007). Clusters, if
+    // given, receives the first triangle of every run that started from a dead end, which is
+    // where OptimizeOverdraw is allowed to cut the result.
+    void OptimizeVertexCache(uint32_t* Destination, const uint32_t* Indices, size_t IndexCount, size_t VertexCount,
+        uint32_t CacheSize = 16, std::vector<uint32_t>* Clusters = nullptr);
+
+    // Splits the clusters of OptimizeVertexCache further wherever the cache is doing no worse
+    // than Threshold times its ACMR, then draws the clusters facing away from the middle of the
+    // mesh first, since those are the ones likely to hide the rest. Positions are three floats,
+    // PositionStride bytes apart.
+    void OptimizeOverdraw(uint32_t* Indices, size_t IndexCount, const float* Positions, size_t PositionStride,
+        size_t VertexCount, const std::vector<uint32_t>& Clusters, uint32_t CacheSize = 16, float Threshold = 1.05f);
+
+    // Renumbers the vertices in the order the indices first use them and rewrites the indices.
+    // Remap maps each old vertex to its new one, or to kUnusedVertex for vertices no triangle
+    // refers to; those are dropped. Returns the number of vertices left.
+    static const uint32_t kUnusedVertex = 0xFFFFFFFF;
+    size_t OptimizeVertexFetch(uint32_t* Indices, size_t IndexCount, size_t VertexCount, std::vector<uint32_t>& Remap);
+
+    template <typename VertexType>
+    void RemapVertices(std::vector<VertexType>& Vertices, const std::vector<uint32_t>& Remap, size_t NewVertexCount)
+    {
+        std::vector<VertexType> Remapped(NewVertexCount);
+        for (size_t i = 0; i < Vertices.size(); ++i)
+        {
+            if (Remap[i] != kUnusedVertex)
+                Remapped[Remap[i]] = Vertices[i];
+        }
+        Vertices.swap(Remapped);
+    }
+
+    struct MeshOptimizeReport
+    {
+        VertexCacheStats Before;
+        VertexCacheStats After;
+    };
+
+    // Runs the three passes above on a triangle list before it is uploaded. Position names the
+    // member holding the vertex position, e.g. &Vertex::position. A higher OverdrawThreshold
+    // cuts more clusters, which sorts better for overdraw but costs ACMR. A mesh that already
+    // comes in a cache-friendly order can lose more to the cuts than Tipsify wins back; it
+    // keeps its triangle order then, so ACMR and ATVR never get worse, and only its vertices
+    // are renumbered.
+    template <typename VertexType, typename PositionType>
+    MeshOptimizeReport OptimizeMesh(std::vector<VertexType>& Vertices, std::vector<uint32_t>& Indices,
+        PositionType VertexType::* Position, uint32_t CacheSize = 16, float OverdrawThreshold = 1.05f)
+    {
+        MeshOptimizeReport Report;
+        Report.Before = AnalyzeVertexCache(Indices.data(), Indices.size(), Vertices.size(), sizeof(VertexType), CacheSize);
+        if (Indices.empty())
+        {
+            Report.After = Report.Before;
+            return Report;
+        }
+
+        std::vector<uint32_t> Reordered(Indices.size());
+        std::vector<uint32_t> Clusters;
+        OptimizeVertexCache(Reordered.data(), Indices.data(), Indices.size(), Vertices.size(), CacheSize, &Clusters);
+
+        const float* Positions = reinterpret_cast<const float*>(&(Vertices[0].*Position));
+        OptimizeOverdraw(Reordered.data(), Reordered.size(), Positions, sizeof(VertexType), Vertices.size(), Clusters,
+            CacheSize, OverdrawThreshold);
+
+        if (AnalyzeVertexCache(Reordered.data(), Reordered.size(), Vertices.size(), sizeof(VertexType), CacheSize).ACMR >
+            Report.Before.ACMR)
+        {
+            Reordered = Indices;
+        }
+
+        std::vector<uint32_t> Remap;
+        size_t NewVertexCount = OptimizeVertexFetch(Reordered.data(), Reordered.size(), Vertices.size(), Remap);
+        RemapVertices(Vertices, Remap, NewVertexCount);
+
+        Indices.swap(Reordered);
+        Report.After = AnalyzeVertexCache(Indices.data(), Indices.size(), Vertices.size(), sizeof(VertexType), CacheSize);
+        return Report;
+    }
+}
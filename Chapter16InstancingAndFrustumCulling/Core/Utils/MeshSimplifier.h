@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Utility
+{
+    // Quadric error edge collapse (Garland and Heckbert, "Surface simplification using quadric
+    // error metrics", 1997). A vertex only ever collapses onto one of its neighbours, so the
+    // result indexes the same vertices as the input and can share its vertex buffer.
+    //
+    // Vertices on an open border only move along it, and vertices sharing their position with
+    // another one (texture or normal seams) never move, so the mesh does not crack.
+    //
+    // Stops at TargetIndexCount indices or before the first collapse over TargetError, whichever
+    // comes first, and returns the number of indices written to Destination. Errors are
+    // root mean square distances to the planes around a vertex, in the units of Positions;
+    // ResultError receives the largest one accepted.
+    size_t SimplifyMesh(uint32_t* Destination, const uint32_t* Indices, size_t IndexCount,
+        const float* Positions, size_t PositionStride, size_t VertexCount,
+        size_t TargetIndexCount, float TargetError, float* ResultError = nullptr);
+
+    struct MeshLod
+    {
+        uint32_t StartIndex;
+        uint32_t IndexCount;
+        float Error;            // distance from the full detail mesh, 0 for the first level
+    };
+
+    // Appends up to LodCount - 1 coarser levels to Indices, each simplified from the one before
+    // to Ratio of its triangles and reordered for the vertex cache. The first level is Indices
+    // as passed in. Stops early once a level can no longer be reduced by much.
+    std::vector<MeshLod> GenerateLods(std::vector<uint32_t>& Indices, const float* Positions, size_t PositionStride,
+        size_t VertexCount, uint32_t LodCount, float Ratio = 0.5f);
+}
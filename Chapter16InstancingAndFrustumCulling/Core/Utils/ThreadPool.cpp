@@ -0,0 +1,213 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    class WorkerPool
+    {
+    public:
+        ~WorkerPool() { Shutdown(); }
+
+        void Initialize(uint32_t NumThreads)
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            if (!m_Workers.empty())
+                return;
+
+            if (NumThreads == 0)
+                NumThreads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+            m_Exit = false;
+            for (uint32_t i = 0; i < NumThreads; ++i)
+                m_Workers.emplace_back([this] { WorkerLoop(); });
+        }
+
+        void Shutdown(void)
+        {
+            {
+                std::lock_guard<std::mutex> LockGuard(m_Mutex);
+                m_Exit = true;
+            }
+            m_JobReady.notify_all();
+
+            for (auto& Worker : m_Workers)
+                Worker.join();
+            m_Workers.clear();
+        }
+
+        uint32_t WorkerCount(void)
+        {
+            std::lock_guard<std::mutex> LockGuard(m_Mutex);
+            return (uint32_t)m_Workers.size();
+        }
+
+        // Owner tags the job so that RunPendingJob can pick it out of the queue again
+        void Submit(std::function<void()> Job, const void* Owner = nullptr)
+        {
+            {
+                std::lock_guard<std::mutex> LockGuard(m_Mutex);
+                m_Jobs.push_back({ std::move(Job), Owner });
+            }
+            m_JobReady.notify_one();
+        }
+
+        // Executes the oldest queued job submitted with Owner on the calling thread, returns
+        // false if no worker left one.
+        bool RunPendingJob(const void* Owner)
+        {
+            std::function<void()> Job;
+            {
+                std::lock_guard<std::mutex> LockGuard(m_Mutex);
+                auto Iter = std::find_if(m_Jobs.begin(), m_Jobs.end(),
+                    [Owner](const QueuedJob& Queued) { return Queued.Owner == Owner; });
+                if (Iter == m_Jobs.end())
+                    return false;
+                Job = std::move(Iter->Job);
+                m_Jobs.erase(Iter);
+            }
+            Job();
+            return true;
+        }
+
+    private:
+
+        struct QueuedJob
+        {
+            std::function<void()> Job;
+            const void* Owner;
+        };
+
+        void WorkerLoop(void)
+        {
+            for (;;)
+            {
+                std::function<void()> Job;
+                {
+                    std::unique_lock<std::mutex> Lock(m_Mutex);
+                    m_JobReady.wait(Lock, [this] { return m_Exit || !m_Jobs.empty(); });
+                    if (m_Exit && m_Jobs.empty())
+                        return;
+                    Job = std::move(m_Jobs.front().Job);
+                    m_Jobs.pop_front();
+                }
+                Job();
+            }
+        }
+
+        std::vector<std::thread> m_Workers;
+        std::deque<QueuedJob> m_Jobs;
+        std::mutex m_Mutex;
+        std::condition_variable m_JobReady;
+        bool m_Exit = false;
+    };
+
+    WorkerPool& GetPool(void)
+    {
+        static WorkerPool s_Pool;
+        return s_Pool;
+    }
+
+    // Shared between the caller of ParallelFor and the helper jobs it submits.
+    struct ParallelForState
+    {
+        std::atomic<int> NextIndex;
+        std::atomic<int> ActiveHelpers;
+        int End;
+        int Grain;
+        const std::function<void(int, int)>* Body;
+
+        void Drain(void)
+        {
+            for (;;)
+            {
+                int ChunkBegin = NextIndex.fetch_add(Grain);
+                if (ChunkBegin >= End)
+                    return;
+                (*Body)(ChunkBegin, std::min(ChunkBegin + Grain, End));
+            }
+        }
+    };
+}
+
+void ThreadPool::Initialize(uint32_t NumThreads)
+{
+    GetPool().Initialize(NumThreads);
+}
+
+void ThreadPool::Shutdown(void)
+{
+    GetPool().Shutdown();
+}
+
+uint32_t ThreadPool::GetWorkerCount(void)
+{
+    Initialize();
+    return GetPool().WorkerCount();
+}
+
+void ThreadPool::Submit(std::function<void()> Job)
+{
+    Initialize();
+    GetPool().Submit(std::move(Job));
+}
+
+void ThreadPool::ParallelForRange(int Begin, int End, const std::function<void(int, int)>& Body, int Grain)
+{
+    if (Begin >= End)
+        return;
+
+    Grain = std::max(Grain, 1);
+    int NumChunks = (End - Begin + Grain - 1) / Grain;
+
+    // not worth waking anybody up
+    if (NumChunks == 1)
+    {
+        Body(Begin, End);
+        return;
+    }
+
+    int NumHelpers = (int)std::min<uint32_t>(GetWorkerCount(), (uint32_t)NumChunks - 1);
+
+    ParallelForState State;
+    State.NextIndex = Begin;
+    State.ActiveHelpers = NumHelpers;
+    State.End = End;
+    State.Grain = Grain;
+    State.Body = &Body;
+
+    for (int i = 0; i < NumHelpers; ++i)
+    {
+        GetPool().Submit([&State]
+        {
+            State.Drain();
+            State.ActiveHelpers.fetch_sub(1, std::memory_order_release);
+        }, &State);
+    }
+
+    State.Drain();
+
+    // the helpers reference State on our stack, so wait for all of them. The ones no worker
+    // has started yet are run here: they find nothing left and return at once, and a nested
+    // ParallelFor never waits on a helper stuck in the queue. Unrelated jobs are left to the
+    // workers, the caller may be the render thread and must not pick up a texture load.
+    while (State.ActiveHelpers.load(std::memory_order_acquire) > 0)
+    {
+        if (!GetPool().RunPendingJob(&State))
+            std::this_thread::yield();
+    }
+}
+
+void ThreadPool::ParallelFor(int Begin, int End, const std::function<void(int)>& Body, int Grain)
+{
+    ParallelForRange(Begin, End, [&Body](int ChunkBegin, int ChunkEnd)
+    {
+        for (int i = ChunkBegin; i < ChunkEnd; ++i)
+            Body(i);
+    }, Grain);
+}
@@ -12,6 +12,7 @@
 #include "TextureManager.h"
 #include "DescriptorHeap.h"
 #include <fstream>
+#include "MeshFile.h"
 #include <d3dcompiler.h>
 
 using namespace Graphics;
@@ -204,7 +205,20 @@ void GameApp::DrawRenderItems(GraphicsContext& gfxContext, std::vector<RenderIte
 		gfxContext.SetVertexBuffer(0, iter->Geo->m_VertexBuffer.VertexBufferView());
 		gfxContext.SetIndexBuffer(iter->Geo->m_IndexBuffer.IndexBufferView());
 
-		gfxContext.DrawIndexedInstanced(iter->IndexCount, iter->InstanceCount, iter->StartIndexLocation, iter->BaseVertexLocation, 0);
+		// SV_InstanceID restarts at 0 for every draw, so each level's run of the instance
+		// buffer is bound at its own offset
+		UINT firstInstance = iter->FirstInstance;
+		for (size_t lod = 0; lod < iter->Lods.size(); ++lod)
+		{
+			UINT count = iter->LodInstanceCounts[lod];
+			if (count == 0)
+				continue;
+
+			const SubmeshGeometry* submesh = iter->Lods[lod];
+			gfxContext.SetBufferSRV(1, InstBuffer, (UINT64)firstInstance * sizeof(Instances));
+			gfxContext.DrawIndexedInstanced(submesh->IndexCount, count, submesh->StartIndexLocation, submesh->BaseVertexLocation, 0);
+			firstInstance += count;
+		}
 	}
 }
 
@@ -221,9 +235,13 @@ void GameApp::BuildRenderItems()
 	skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
 	skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
 	skullRitem->Bound = skullRitem->Geo->DrawArgs["skull"].Bound;
+	skullRitem->Lods.push_back(&skullRitem->Geo->DrawArgs["skull"]);
+	for (int i = 1; skullRitem->Geo->DrawArgs.count("skull_lod" + std::to_string(i)) != 0; ++i)
+		skullRitem->Lods.push_back(&skullRitem->Geo->DrawArgs["skull_lod" + std::to_string(i)]);
 	const int n = 5;
 
 	skullRitem->inst.resize(n*n*n);
+	skullRitem->InstanceLods.assign(n*n*n, 0);
 	skullRitem->InstanceCount = 5 * 5 * 5;
 
 	float width = 200.0f;
@@ -257,6 +275,15 @@ void GameApp::BuildRenderItems()
 	}
 
 
+	// instances never move, transform the local bound into world space once
+	skullRitem->InstanceBounds.Resize((uint32_t)skullRitem->inst.size());
+	for (UINT i = 0; i < (UINT)skullRitem->inst.size(); ++i)
+	{
+		BoundingBox worldBound;
+		skullRitem->Bound.Transform(worldBound, XMLoadFloat4x4(&skullRitem->inst[i].World));
+		skullRitem->InstanceBounds.Set(i, worldBound);
+	}
+
 	m_LayerRenders[(int)RenderLayer::Opaque].push_back(skullRitem.get());
 
 	m_AllRenders.push_back(std::move(skullRitem));
@@ -264,67 +291,48 @@ void GameApp::BuildRenderItems()
 
 void GameApp::BuildSkullGeometry()
 {
-	std::ifstream fin("../Models/skull.txt");
-
-	if (!fin)
+	// skull.mesh is converted from skull.txt the first time (or whenever the text is newer) and
+	// memory mapped afterwards, the vertex and index blobs go to the gpu buffers as they are.
+	// The conversion also simplifies the skull, its coarser levels follow the full detail indices
+	MeshFile::Mesh mesh;
+	if (!mesh.LoadOrConvert(L"../Models/skull.mesh", L"../Models/skull.txt"))
 	{
 		MessageBox(0, L"Models/skull.txt not found.", 0, 0);
 		return;
 	}
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-	XMFLOAT3 vMinf(INFINITY, INFINITY, INFINITY);
-	XMFLOAT3 vMaxf(-INFINITY, -INFINITY, -INFINITY);
-
-	XMVECTOR vMin = XMLoadFloat3(&vMinf);
-	XMVECTOR vMax = XMLoadFloat3(&vMaxf);
-
-	std::vector<Vertex> vertices(vcount);
-	for (UINT i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].position.x >> vertices[i].position.y >> vertices[i].position.z;
-		fin >> vertices[i].normal.x >> vertices[i].normal.y >> vertices[i].normal.z;
-
-		// Model does not have texture coordinates, so just zero them out.
-		vertices[i].tex = { 0.0f, 0.0f };
-
-		XMVECTOR P = XMLoadFloat3(&vertices[i].position);
-
-		vMin = XMVectorMin(vMin, P);
-		vMax = XMVectorMax(vMax, P);
-	}
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
+	static_assert(sizeof(Vertex) == sizeof(MeshFile::Vertex), "Vertex no longer matches the mesh file layout");
 
-	std::vector<std::int32_t> indices(3 * tcount);
-	for (UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-	}
-
-	fin.close();
+	const MeshFile::Header& header = mesh.GetHeader();
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->name = "skullGeo";
-	geo->m_VertexBuffer.Create(L"vertex buff", (UINT)vertices.size(), sizeof(Vertex), vertices.data());
-	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), sizeof(std::int32_t), indices.data());
+	geo->m_VertexBuffer.Create(L"vertex buff", mesh.GetVertexCount(), sizeof(Vertex), mesh.GetVertices());
+	geo->m_IndexBuffer.Create(L"Index Buffer", mesh.GetIndexCount(), mesh.GetIndexSize(), mesh.GetIndices());
+
+	XMVECTOR vMin = XMVectorSet(header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2], 0.0f);
+	XMVECTOR vMax = XMVectorSet(header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2], 0.0f);
 
 	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
+	submesh.IndexCount = mesh.GetLod(0).IndexCount;
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
 	XMStoreFloat3(&submesh.Bound.Center, 0.5f * (vMax + vMin));
 	XMStoreFloat3(&submesh.Bound.Extents, 0.5f * (vMax - vMin));
 
+	for (UINT i = 1; i < mesh.GetLodCount(); ++i)
+	{
+		const MeshFile::Lod& level = mesh.GetLod(i);
+
+		SubmeshGeometry lod = submesh;
+		lod.IndexCount = level.IndexCount;
+		lod.StartIndexLocation = level.StartIndex;
+		lod.LodError = level.Error;
+		geo->DrawArgs["skull_lod" + std::to_string(i)] = std::move(lod);
+
+		Utility::Printf("skull LOD %u: %u triangles, error %.3f\n", i, level.IndexCount / 3, level.Error);
+	}
+
 	geo->DrawArgs["skull"] = std::move(submesh);
 
 	m_Geometry["skullGeo"] = std::move(geo);
@@ -448,52 +456,96 @@ void GameApp::LoadTextures()
 		m_srvs.push_back(t.GetSRV());
 }
 
+// A level is good enough while its error covers less than a pixel on screen. Going coarser
+// takes a clear margin under that, so an instance sitting at a switch distance keeps its level.
+static UINT SelectLod(const std::vector<const SubmeshGeometry*>& lods, UINT lod, float pixelsPerError)
+{
+	const float maxPixelError = 1.0f;
+	const float coarserPixelError = 0.75f;
+
+	lod = (std::min)(lod, (UINT)lods.size() - 1);
+	while (lod > 0 && lods[lod]->LodError * pixelsPerError > maxPixelError)
+		--lod;
+	while (lod + 1 < lods.size() && lods[lod + 1]->LodError * pixelsPerError <= coarserPixelError)
+		++lod;
+	return lod;
+}
+
+float GameApp::LodPixelsPerError(FXMMATRIX world)
+{
+	// pixels covered by one unit of length one unit in front of the camera
+	float pixelsPerUnit = g_DisplayHeight / (2.0f * tanf(camera.GetFOV() * 0.5f));
+
+	// errors are in object space, the largest axis scale takes them to world space
+	float scale = (std::max)({ XMVectorGetX(XMVector3Length(world.r[0])),
+		XMVectorGetX(XMVector3Length(world.r[1])),
+		XMVectorGetX(XMVector3Length(world.r[2])) });
+	XMVECTOR eye = camera.GetPosition();
+	float distance = (std::max)(XMVectorGetX(XMVector3Length(world.r[3] - eye)), camera.GetNearClip());
+	return scale * pixelsPerUnit / distance;
+}
+
 void GameApp::UpdateInstanceIndex(float deltaT)
 {
-	XMMATRIX view = camera.GetViewMatrix();
-	XMVECTOR vDet = XMMatrixDeterminant(view);
-	XMMATRIX invView = XMMatrixInverse(&vDet, view);
+	// the instance bounds are already in world space, so every instance is tested against
+	// the same world-space frustum instead of inverting its world matrix
+	const Math::Frustum& worldFrustum = camera.GetWorldSpaceFrustum();
 
 	std::vector<Instances> visibleInstance;
+	UINT lodTriangles = 0, fullTriangles = 0;
 	for (auto& e : m_LayerRenders[(int)RenderLayer::Opaque])
 	{
 		const auto& inst = e->inst;
-		Utility::Printf("total Instance counts : %u \n", inst.size());
-		for (UINT i = 0; i < (UINT)inst.size(); ++i)
+
+		if (m_bFrustumCulling)
 		{
-			XMMATRIX world = XMLoadFloat4x4(&inst[i].World);
-			XMMATRIX texTransform = XMLoadFloat4x4(&inst[i].TexTransform);
-			XMMATRIX matTransform = XMLoadFloat4x4(&inst[i].MatTransform);
+			m_VisibleInstances.resize(inst.size());
+			for (UINT i = 0; i < (UINT)inst.size(); ++i)
+				m_VisibleInstances[i] = i;
+		}
+		else
+		{
+			Math::CullBoxes(worldFrustum, e->InstanceBounds, m_VisibleInstances);
+		}
 
-			XMVECTOR wDet = XMMatrixDeterminant(world);
-			XMMATRIX invWorld = XMMatrixInverse(&wDet, world);
+		// pick a level for every visible instance, then lay them out level by level so each
+		// level is drawn with one instanced draw
+		const UINT levels = (UINT)e->Lods.size();
+		e->LodInstanceCounts.assign(levels, 0);
+		for (uint32_t i : m_VisibleInstances)
+		{
+			e->InstanceLods[i] = SelectLod(e->Lods, e->InstanceLods[i], LodPixelsPerError(XMLoadFloat4x4(&inst[i].World)));
+			++e->LodInstanceCounts[e->InstanceLods[i]];
+		}
 
-			// View space to the object's local space.
-			XMMATRIX viewToLocal = XMMatrixMultiply(invView, invWorld);
+		e->FirstInstance = (UINT)visibleInstance.size();
+		e->InstanceCount = (UINT)m_VisibleInstances.size();
+		visibleInstance.resize(visibleInstance.size() + m_VisibleInstances.size());
 
-			// Transform the camera frustum from view space to the object's local space.
-			
-			//BoundingFrustum localSpaceFrustum;
-			//mCamFrustum.Transform(localSpaceFrustum, viewToLocal);
+		std::vector<UINT> next(levels, e->FirstInstance);
+		for (UINT lod = 1; lod < levels; ++lod)
+			next[lod] = next[lod - 1] + e->LodInstanceCounts[lod - 1];
 
-			//if ((localSpaceFrustum.Contains(e->Bound) != DirectX::DISJOINT) || m_bFrustumCulling)
-			if ((frustum.Intersection(e->Bound, viewToLocal)) || m_bFrustumCulling)
-			{
-				Instances temp;
-				XMStoreFloat4x4(&temp.World, XMMatrixTranspose(world));
-				XMStoreFloat4x4(&temp.TexTransform, XMMatrixTranspose(texTransform));
-				XMStoreFloat4x4(&temp.MatTransform, XMMatrixTranspose(matTransform));
-				temp.MaterialIndex = inst[i].MaterialIndex;
-				visibleInstance.push_back(std::move(temp));
-			}
+		for (uint32_t i : m_VisibleInstances)
+		{
+			Instances& temp = visibleInstance[next[e->InstanceLods[i]]++];
+			XMStoreFloat4x4(&temp.World, XMMatrixTranspose(XMLoadFloat4x4(&inst[i].World)));
+			XMStoreFloat4x4(&temp.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&inst[i].TexTransform)));
+			XMStoreFloat4x4(&temp.MatTransform, XMMatrixTranspose(XMLoadFloat4x4(&inst[i].MatTransform)));
+			temp.MaterialIndex = inst[i].MaterialIndex;
 		}
 
-		e->InstanceCount = visibleInstance.size();
+		for (UINT lod = 0; lod < levels; ++lod)
+		{
+			lodTriangles += e->LodInstanceCounts[lod] * (e->Lods[lod]->IndexCount / 3);
+			fullTriangles += e->LodInstanceCounts[lod] * (e->Lods[0]->IndexCount / 3);
+		}
 	}
 
 	InstBuffer.Create(L"Instance buffer", (UINT)visibleInstance.size(), sizeof(Instances), visibleInstance.data());
 	
 	Utility::Printf("Instance counts after culling : %u \n", visibleInstance.size());
+	Utility::Printf("LOD: %u of %u triangles\n", lodTriangles, fullTriangles);
 }
 
 void GameApp::UpdateCamera(float deltaT)
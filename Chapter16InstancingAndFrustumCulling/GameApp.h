@@ -13,6 +13,7 @@
 
 #include <DirectXCollision.h>
 #include "FrustumCulling.h"
+#include "Math/FrustumCuller.h"
 
 enum class RenderLayer : int
 {
@@ -36,6 +37,9 @@ struct RenderItem
 
 	DirectX::BoundingBox Bound;
 
+	// world-space bounds of every instance, same order as inst
+	Math::BoundingBoxSoA InstanceBounds;
+
 	MeshGeometry* Geo = nullptr;
 
 	Material* Mat = nullptr;
@@ -48,6 +52,15 @@ struct RenderItem
 	UINT StartIndexLocation = 0;
 	UINT BaseVertexLocation = 0;
 
+	// full detail first, every item has at least that one. The visible instances are grouped by
+	// the level they are drawn at, each level one instanced draw over its run of the instance
+	// buffer starting at FirstInstance
+	std::vector<const SubmeshGeometry*> Lods;
+	std::vector<UINT> LodInstanceCounts;
+	UINT FirstInstance = 0;
+
+	// level each instance was drawn at last frame, same order as inst
+	std::vector<UINT> InstanceLods;
 };
 
 class GraphicsContext;
@@ -77,6 +90,7 @@ private:
 
 	void UpdateInstanceIndex(float deltaT);
 	void UpdateCamera(float deltaT);
+	float LodPixelsPerError(DirectX::FXMMATRIX world);
 
 	RootSignature m_RootSignature;
 
@@ -101,6 +115,9 @@ private:
 	FrustumCulling cameraFrustum;
 	MyBoundingFrustum frustum;
 
+	// indices of the instances that survived culling, reused every frame
+	std::vector<uint32_t> m_VisibleInstances;
+
 	// switch render scene
 	bool m_bFrustumCulling = true;
 
@@ -0,0 +1,119 @@
+#include "TestHarness.h"
+#include "ReferenceCull.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+// Culling 100k to 1M instances of one model scattered around the camera: the path
+// UpdateInstanceIndex took before, which inverts every world matrix and asks
+// BoundingFrustum::Contains about the local box, against CullBoxes over world-space bounds.
+// The Contains path here is the scalar stand-in of Headless/DirectXCollision.h rather than
+// the SIMD code of DirectXMath, so the speedup is larger than on Windows; the ns/instance of
+// CullBoxes are the number to compare.
+
+namespace
+{
+    struct Instances
+    {
+        std::vector<DirectX::XMFLOAT4X4> Worlds;
+        Math::BoundingBoxSoA Bounds;
+    };
+
+    // The same density of instances at every count, so about the same share of them is visible
+    void Scatter(uint32_t Count, const DirectX::BoundingBox& LocalBox, Instances& Out)
+    {
+        std::mt19937 Rng(Count);
+        const float HalfSize = 10.0f * std::cbrt((float)Count);
+        std::uniform_real_distribution<float> Position(-HalfSize, HalfSize);
+        std::uniform_real_distribution<float> Scale(0.5f, 2.0f);
+        std::uniform_real_distribution<float> Angle(-3.14f, 3.14f);
+
+        Out.Worlds.resize(Count);
+        Out.Bounds.Resize(Count);
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            const float X = Position(Rng), Y = Position(Rng), Z = Position(Rng);
+            Out.Worlds[i] = Reference::Placement(Angle(Rng), Scale(Rng), X, Y, Z);
+
+            DirectX::BoundingBox WorldBox;
+            LocalBox.Transform(WorldBox, Out.Worlds[i]);
+            Out.Bounds.Set(i, WorldBox);
+        }
+    }
+
+    void CullContains(const DirectX::BoundingFrustum& ViewFrustum, const DirectX::XMFLOAT4X4& CameraToWorld,
+        const DirectX::BoundingBox& LocalBox, const Instances& Scene, std::vector<uint32_t>& Visible)
+    {
+        Visible.clear();
+        for (uint32_t i = 0; i < (uint32_t)Scene.Worlds.size(); ++i)
+        {
+            if (Reference::IsVisibleLocal(ViewFrustum, CameraToWorld, Scene.Worlds[i], LocalBox))
+                Visible.push_back(i);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const double Scale = Test::GetScale(argc, argv);
+    const int CullFrames = std::max(2, (int)(50 * Scale));
+    const int ContainsFrames = std::max(1, (int)(5 * Scale));
+
+    // the skull model is about this size
+    const DirectX::BoundingBox LocalBox(DirectX::XMFLOAT3(0.0f, 0.4f, 0.1f), DirectX::XMFLOAT3(3.5f, 3.0f, 4.0f));
+    const DirectX::BoundingFrustum ViewFrustum = Reference::PerspectiveFrustum(0.25f * 3.14159265f, 16.0f / 9.0f,
+        1.0f, 1000.0f);
+    const DirectX::XMFLOAT4X4 CameraToWorld = Reference::CameraToWorld(0.0f, 5.0f, -20.0f, 0.3f, 0.1f);
+
+    DirectX::BoundingFrustum WorldFrustum;
+    ViewFrustum.Transform(WorldFrustum, CameraToWorld);
+    float Planes[6][4];
+    Reference::InsidePlanes(WorldFrustum, Planes);
+
+    ThreadPool::Initialize();
+    printf("%d + %d frames, %u workers besides the caller, %u cores\n", ContainsFrames, CullFrames,
+        ThreadPool::GetWorkerCount(), std::thread::hardware_concurrency());
+
+    for (uint32_t Full : { 100000u, 250000u, 1000000u })
+    {
+        const uint32_t Count = std::max(1000u, (uint32_t)(Full * Scale));
+        Instances Scene;
+        Scatter(Count, LocalBox, Scene);
+
+        std::vector<uint32_t> ContainsVisible, CullVisible;
+        Test::Timer ContainsTimer;
+        for (int Frame = 0; Frame < ContainsFrames; ++Frame)
+            CullContains(ViewFrustum, CameraToWorld, LocalBox, Scene, ContainsVisible);
+        const double ContainsNs = ContainsTimer.Seconds() * 1e9 / ((double)Count * ContainsFrames);
+
+        Test::Timer CullTimer;
+        for (int Frame = 0; Frame < CullFrames; ++Frame)
+            Math::CullBoxes(Planes, Scene.Bounds, CullVisible);
+        const double CullNs = CullTimer.Seconds() * 1e9 / ((double)Count * CullFrames);
+
+        // the world box holds the rotated local box, so CullBoxes keeps all Contains keeps,
+        // short of instances that touch a plane
+        uint32_t Missing = 0;
+        for (uint32_t i : ContainsVisible)
+        {
+            if (!std::binary_search(CullVisible.begin(), CullVisible.end(), i))
+            {
+                double Margin;
+                Reference::IsVisible(Planes, Scene.Bounds, i, Margin);
+                CHECK(Margin < 0.05);
+                ++Missing;
+            }
+        }
+        CHECK(Missing * 100 <= ContainsVisible.size());
+        CHECK(CullVisible.size() >= ContainsVisible.size() - Missing);
+
+        printf("%8u instances\n", Count);
+        printf("  Contains:   %7.2f ns/instance, %u visible\n", ContainsNs, (uint32_t)ContainsVisible.size());
+        printf("  CullBoxes:  %7.2f ns/instance, %u visible  %6.1fx\n", CullNs, (uint32_t)CullVisible.size(),
+            ContainsNs / CullNs);
+    }
+
+    ThreadPool::Shutdown();
+    return Test::Finish("BenchCullBoxes");
+}
@@ -0,0 +1,248 @@
+#include "TestHarness.h"
+#include "ReferenceCull.h"
+#include "ThreadPool.h"
+#include <random>
+
+// CullBoxes against the scalar test in ReferenceCull.h, at counts that leave every remainder
+// of the SIMD loop and that cross the chunks it hands to the ThreadPool, and against the
+// per-instance BoundingFrustum::Contains path GameApp used before. Built twice: against the
+// default SSE culler, and as CullBoxesTestAVX against the AVX one.
+
+namespace
+{
+    // Boxes closer to a plane than this may go either way in float
+    const double kAmbiguous = 1e-3;
+
+    // Random camera frusta and boxes all over the space they look into
+    struct Scene
+    {
+        DirectX::BoundingFrustum ViewFrustum;
+        DirectX::XMFLOAT4X4 CameraToWorld;
+        float Planes[6][4];
+    };
+
+    Scene RandomScene(std::mt19937& Rng)
+    {
+        std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+        auto Range = [&](float Lo, float Hi) { return Lo + (Hi - Lo) * Unit(Rng); };
+
+        Scene S;
+        S.ViewFrustum = Reference::PerspectiveFrustum(Range(0.5f, 1.5f), Range(0.8f, 2.0f), Range(0.1f, 1.0f),
+            Range(50.0f, 150.0f));
+        S.CameraToWorld = Reference::CameraToWorld(Range(-20.0f, 20.0f), Range(-20.0f, 20.0f), Range(-20.0f, 20.0f),
+            Range(-3.14f, 3.14f), Range(-1.0f, 1.0f));
+
+        DirectX::BoundingFrustum WorldFrustum;
+        S.ViewFrustum.Transform(WorldFrustum, S.CameraToWorld);
+        Reference::InsidePlanes(WorldFrustum, S.Planes);
+        return S;
+    }
+
+    void RandomBoxes(std::mt19937& Rng, uint32_t Count, Math::BoundingBoxSoA& Boxes)
+    {
+        std::uniform_real_distribution<float> Position(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> Extent(0.05f, 5.0f);
+        Boxes.Clear();
+        Boxes.Reserve(Count);
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            Boxes.Add(DirectX::BoundingBox(DirectX::XMFLOAT3(Position(Rng), Position(Rng), Position(Rng)),
+                DirectX::XMFLOAT3(Extent(Rng), Extent(Rng), Extent(Rng))));
+        }
+    }
+
+    bool IsAscending(const std::vector<uint32_t>& Visible, uint32_t Count)
+    {
+        for (size_t k = 0; k < Visible.size(); ++k)
+        {
+            if (Visible[k] >= Count || (k > 0 && Visible[k] <= Visible[k - 1]))
+                return false;
+        }
+        return true;
+    }
+
+    // Every box the reference is sure about got the same answer; returns how many were not
+    uint32_t CompareWithReference(const float Planes[6][4], const Math::BoundingBoxSoA& Boxes,
+        const std::vector<uint32_t>& Visible)
+    {
+        uint32_t Ambiguous = 0;
+        size_t k = 0;
+        for (uint32_t i = 0; i < Boxes.GetCount(); ++i)
+        {
+            const bool Culled = !(k < Visible.size() && Visible[k] == i);
+            if (!Culled)
+                ++k;
+
+            double Margin;
+            const bool Expected = Reference::IsVisible(Planes, Boxes, i, Margin);
+            if (Margin < kAmbiguous)
+                ++Ambiguous;
+            else
+                CHECK(Expected == !Culled);
+        }
+        return Ambiguous;
+    }
+}
+
+// dot(n, p) + d == 0 counts as inside, in the SIMD loop and the remainder alike
+static void TestTouchingIsVisible(void)
+{
+    float Planes[6][4] = {};
+    Planes[0][0] = 1.0f;            // x >= 0
+    for (int p = 1; p < 6; ++p)
+        Planes[p][3] = 1.0f;        // everywhere
+
+    Math::BoundingBoxSoA Boxes;
+    const uint32_t Count = 19;
+    for (uint32_t i = 0; i < Count; ++i)
+    {
+        // even boxes end exactly on the plane, odd ones half a unit behind it
+        const float X = i % 2 == 0 ? -1.0f : -1.5f;
+        Boxes.Add(DirectX::BoundingBox(DirectX::XMFLOAT3(X, 3.0f, -2.0f), DirectX::XMFLOAT3(1.0f, 0.5f, 0.5f)));
+    }
+
+    std::vector<uint32_t> Visible;
+    CHECK(Math::CullBoxes(Planes, Boxes, Visible) == (Count + 1) / 2);
+    CHECK(Visible.size() == (Count + 1) / 2);
+    for (size_t k = 0; k < Visible.size(); ++k)
+        CHECK(Visible[k] == 2 * k);
+}
+
+static void TestAgainstReference(void)
+{
+    std::mt19937 Rng(16);
+    const uint32_t Counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 17, 1000, 16 * 1024, 16 * 1024 + 1, 3 * 16 * 1024 + 5, 100000 };
+
+    // left over from a larger cull, CullBoxes must not keep any of it
+    std::vector<uint32_t> Visible(200000, ~0u);
+    uint32_t Total = 0, Ambiguous = 0;
+    for (uint32_t Count : Counts)
+    {
+        for (int Trial = 0; Trial < 4; ++Trial)
+        {
+            Scene S = RandomScene(Rng);
+            Math::BoundingBoxSoA Boxes;
+            RandomBoxes(Rng, Count, Boxes);
+
+            const uint32_t NumVisible = Math::CullBoxes(S.Planes, Boxes, Visible);
+            CHECK(NumVisible == Visible.size());
+            CHECK(IsAscending(Visible, Count));
+            Ambiguous += CompareWithReference(S.Planes, Boxes, Visible);
+            Total += Count;
+        }
+    }
+
+    // near misses are rare, not a way for a broken culler to pass
+    CHECK(Ambiguous * 1000 < Total);
+}
+
+// The overload taking a Frustum reads the same planes
+static void TestFrustumOverload(void)
+{
+    std::mt19937 Rng(17);
+    for (uint32_t Count : { 13u, 40000u })
+    {
+        Scene S = RandomScene(Rng);
+        Math::BoundingBoxSoA Boxes;
+        RandomBoxes(Rng, Count, Boxes);
+
+        Math::Frustum F;
+        for (int p = 0; p < 6; ++p)
+        {
+            F.SetFrustumPlane((Math::Frustum::PlaneID)p,
+                Math::Vector4(S.Planes[p][0], S.Planes[p][1], S.Planes[p][2], S.Planes[p][3]));
+        }
+
+        std::vector<uint32_t> FromPlanes, FromFrustum;
+        Math::CullBoxes(S.Planes, Boxes, FromPlanes);
+        Math::CullBoxes(F, Boxes, FromFrustum);
+        CHECK(FromPlanes == FromFrustum);
+    }
+}
+
+// World bounds built the way GameApp builds them, culled in world space, against the frustum
+// moved into the local space of every instance. Without rotation the world box is the local
+// box moved and scaled, so both paths agree; with it the world box is larger and CullBoxes
+// keeps everything Contains keeps.
+static void TestMatchesContainsPath(void)
+{
+    std::mt19937 Rng(18);
+    std::uniform_real_distribution<float> Position(-80.0f, 80.0f);
+    std::uniform_real_distribution<float> Scale(0.5f, 3.0f);
+    std::uniform_real_distribution<float> Angle(-3.14f, 3.14f);
+    const DirectX::BoundingBox LocalBox(DirectX::XMFLOAT3(0.2f, 1.0f, -0.3f), DirectX::XMFLOAT3(2.0f, 1.5f, 2.5f));
+    const uint32_t Count = 20000;
+
+    for (bool Rotated : { false, true })
+    {
+        Scene S = RandomScene(Rng);
+        std::vector<DirectX::XMFLOAT4X4> Worlds(Count);
+        Math::BoundingBoxSoA Boxes;
+        Boxes.Resize(Count);
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            Worlds[i] = Reference::Placement(Rotated ? Angle(Rng) : 0.0f, Scale(Rng), Position(Rng), Position(Rng),
+                Position(Rng));
+            DirectX::BoundingBox WorldBox;
+            LocalBox.Transform(WorldBox, Worlds[i]);
+            Boxes.Set(i, WorldBox);
+        }
+
+        std::vector<uint32_t> Visible;
+        Math::CullBoxes(S.Planes, Boxes, Visible);
+
+        // the local-space path rounds differently, so it gets a wider margin
+        uint32_t NumContains = 0, Ambiguous = 0;
+        size_t k = 0;
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            const bool Culled = !(k < Visible.size() && Visible[k] == i);
+            if (!Culled)
+                ++k;
+
+            const bool Contains = Reference::IsVisibleLocal(S.ViewFrustum, S.CameraToWorld, Worlds[i], LocalBox);
+            NumContains += Contains ? 1 : 0;
+
+            double Margin;
+            Reference::IsVisible(S.Planes, Boxes, i, Margin);
+            if (Margin < 0.05)
+            {
+                ++Ambiguous;
+                continue;
+            }
+            if (Rotated)
+                CHECK(!Contains || !Culled);
+            else
+                CHECK(Contains == !Culled);
+        }
+
+        CHECK(NumContains > 0);
+        CHECK(Visible.size() + Ambiguous >= NumContains);
+        CHECK(Ambiguous * 100 < Count);
+    }
+}
+
+int main(void)
+{
+#if defined(CULL_BOXES_AVX) && (defined(__GNUC__) || defined(__clang__))
+    if (!__builtin_cpu_supports("avx"))
+    {
+        printf("CullBoxesTestAVX: no AVX on this CPU, skipped\n");
+        return 0;
+    }
+#endif
+
+    ThreadPool::Initialize(2);
+
+    TestTouchingIsVisible();
+    TestAgainstReference();
+    TestFrustumOverload();
+    TestMatchesContainsPath();
+
+    ThreadPool::Shutdown();
+#if defined(CULL_BOXES_AVX)
+    return Test::Finish("CullBoxesTestAVX");
+#else
+    return Test::Finish("CullBoxesTest");
+#endif
+}
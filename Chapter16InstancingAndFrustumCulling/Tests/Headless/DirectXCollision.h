@@ -0,0 +1,207 @@
+#pragma once
+
+#include "DirectXMath.h"
+#include <algorithm>
+#include <cmath>
+
+// Stands in for <DirectXCollision.h>: BoundingBox, and BoundingFrustum with the Transform and
+// Contains(BoundingBox) the instance loop of GameApp used before the culler, written out in
+// scalar code step for step as DirectXCollision.inl does them. Matrices are XMFLOAT4X4 in
+// place of XMMATRIX, row vectors as in DirectXMath.
+namespace DirectX
+{
+    enum ContainmentType
+    {
+        DISJOINT = 0,
+        INTERSECTS = 1,
+        CONTAINS = 2
+    };
+
+    namespace Internal
+    {
+        inline float Dot3(const float A[3], const float B[3])
+        {
+            return A[0] * B[0] + A[1] * B[1] + A[2] * B[2];
+        }
+
+        inline void Cross3(const float A[3], const float B[3], float Out[3])
+        {
+            Out[0] = A[1] * B[2] - A[2] * B[1];
+            Out[1] = A[2] * B[0] - A[0] * B[2];
+            Out[2] = A[0] * B[1] - A[1] * B[0];
+        }
+
+        // XMVector3Rotate: q v q*
+        inline void Rotate(const float V[3], const XMFLOAT4& Q, float Out[3])
+        {
+            const float U[3] = { Q.x, Q.y, Q.z };
+            float T[3], UT[3];
+            Cross3(U, V, T);
+            for (int i = 0; i < 3; ++i)
+                T[i] *= 2.0f;
+            Cross3(U, T, UT);
+            for (int i = 0; i < 3; ++i)
+                Out[i] = V[i] + Q.w * T[i] + UT[i];
+        }
+
+        // XMQuaternionMultiply(Q1, Q2): rotation Q1 followed by Q2
+        inline XMFLOAT4 Multiply(const XMFLOAT4& Q1, const XMFLOAT4& Q2)
+        {
+            return XMFLOAT4(
+                Q2.w * Q1.x + Q2.x * Q1.w + Q2.y * Q1.z - Q2.z * Q1.y,
+                Q2.w * Q1.y - Q2.x * Q1.z + Q2.y * Q1.w + Q2.z * Q1.x,
+                Q2.w * Q1.z + Q2.x * Q1.y - Q2.y * Q1.x + Q2.z * Q1.w,
+                Q2.w * Q1.w - Q2.x * Q1.x - Q2.y * Q1.y - Q2.z * Q1.z);
+        }
+
+        // XMQuaternionRotationMatrix of an orthonormal 3x3, row vectors
+        inline XMFLOAT4 RotationQuaternion(const float M[3][3])
+        {
+            const float Trace = M[0][0] + M[1][1] + M[2][2];
+            if (Trace > 0.0f)
+            {
+                float S = std::sqrt(Trace + 1.0f) * 2.0f;
+                return XMFLOAT4((M[1][2] - M[2][1]) / S, (M[2][0] - M[0][2]) / S, (M[0][1] - M[1][0]) / S, 0.25f * S);
+            }
+            if (M[0][0] > M[1][1] && M[0][0] > M[2][2])
+            {
+                float S = std::sqrt(1.0f + M[0][0] - M[1][1] - M[2][2]) * 2.0f;
+                return XMFLOAT4(0.25f * S, (M[0][1] + M[1][0]) / S, (M[0][2] + M[2][0]) / S, (M[1][2] - M[2][1]) / S);
+            }
+            if (M[1][1] > M[2][2])
+            {
+                float S = std::sqrt(1.0f + M[1][1] - M[0][0] - M[2][2]) * 2.0f;
+                return XMFLOAT4((M[0][1] + M[1][0]) / S, 0.25f * S, (M[1][2] + M[2][1]) / S, (M[2][0] - M[0][2]) / S);
+            }
+            float S = std::sqrt(1.0f + M[2][2] - M[0][0] - M[1][1]) * 2.0f;
+            return XMFLOAT4((M[0][2] + M[2][0]) / S, (M[1][2] + M[2][1]) / S, 0.25f * S, (M[0][1] - M[1][0]) / S);
+        }
+
+        // Internal::XMPlaneTransform followed by XMPlaneNormalize
+        inline XMFLOAT4 TransformPlane(float Nx, float Ny, float Nz, float D, const XMFLOAT4& Rotation,
+            const XMFLOAT3& Translation)
+        {
+            const float N[3] = { Nx, Ny, Nz };
+            const float T[3] = { Translation.x, Translation.y, Translation.z };
+            float R[3];
+            Rotate(N, Rotation, R);
+            D -= Dot3(R, T);
+
+            const float InvLength = 1.0f / std::sqrt(Dot3(R, R));
+            return XMFLOAT4(R[0] * InvLength, R[1] * InvLength, R[2] * InvLength, D * InvLength);
+        }
+    }
+
+    struct BoundingBox
+    {
+        XMFLOAT3 Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        XMFLOAT3 Extents = XMFLOAT3(1.0f, 1.0f, 1.0f);
+
+        BoundingBox() = default;
+        BoundingBox(const XMFLOAT3& center, const XMFLOAT3& extents) : Center(center), Extents(extents) {}
+
+        // The box around the eight transformed corners
+        void Transform(BoundingBox& Out, const XMFLOAT4X4& M) const
+        {
+            float Min[3] = { INFINITY, INFINITY, INFINITY };
+            float Max[3] = { -INFINITY, -INFINITY, -INFINITY };
+            for (int Corner = 0; Corner < 8; ++Corner)
+            {
+                const float P[3] =
+                {
+                    Center.x + (Corner & 1 ? Extents.x : -Extents.x),
+                    Center.y + (Corner & 2 ? Extents.y : -Extents.y),
+                    Center.z + (Corner & 4 ? Extents.z : -Extents.z)
+                };
+                for (int c = 0; c < 3; ++c)
+                {
+                    float V = P[0] * M.m[0][c] + P[1] * M.m[1][c] + P[2] * M.m[2][c] + M.m[3][c];
+                    Min[c] = std::min(Min[c], V);
+                    Max[c] = std::max(Max[c], V);
+                }
+            }
+            Out.Center = XMFLOAT3((Min[0] + Max[0]) * 0.5f, (Min[1] + Max[1]) * 0.5f, (Min[2] + Max[2]) * 0.5f);
+            Out.Extents = XMFLOAT3((Max[0] - Min[0]) * 0.5f, (Max[1] - Min[1]) * 0.5f, (Max[2] - Min[2]) * 0.5f);
+        }
+    };
+
+    struct BoundingFrustum
+    {
+        XMFLOAT3 Origin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        XMFLOAT4 Orientation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        float RightSlope = 1.0f;
+        float LeftSlope = -1.0f;
+        float TopSlope = 1.0f;
+        float BottomSlope = -1.0f;
+        float Near = 0.0f;
+        float Far = 1.0f;
+
+        // Rotation and translation of M applied to the frustum, its largest axis scale to the
+        // near and far distances
+        void Transform(BoundingFrustum& Out, const XMFLOAT4X4& M) const
+        {
+            float Rotation[3][3];
+            float ScaleSq = 0.0f;
+            for (int r = 0; r < 3; ++r)
+            {
+                const float Row[3] = { M.m[r][0], M.m[r][1], M.m[r][2] };
+                const float LengthSq = Internal::Dot3(Row, Row);
+                const float InvLength = 1.0f / std::sqrt(LengthSq);
+                for (int c = 0; c < 3; ++c)
+                    Rotation[r][c] = Row[c] * InvLength;
+                ScaleSq = std::max(ScaleSq, LengthSq);
+            }
+
+            const XMFLOAT4 NewOrientation = Internal::Multiply(Orientation, Internal::RotationQuaternion(Rotation));
+            const XMFLOAT3 NewOrigin(
+                Origin.x * M.m[0][0] + Origin.y * M.m[1][0] + Origin.z * M.m[2][0] + M.m[3][0],
+                Origin.x * M.m[0][1] + Origin.y * M.m[1][1] + Origin.z * M.m[2][1] + M.m[3][1],
+                Origin.x * M.m[0][2] + Origin.y * M.m[1][2] + Origin.z * M.m[2][2] + M.m[3][2]);
+            const float Scale = std::sqrt(ScaleSq);
+
+            Out.Origin = NewOrigin;
+            Out.Orientation = NewOrientation;
+            Out.Near = Near * Scale;
+            Out.Far = Far * Scale;
+            Out.RightSlope = RightSlope;
+            Out.LeftSlope = LeftSlope;
+            Out.TopSlope = TopSlope;
+            Out.BottomSlope = BottomSlope;
+        }
+
+        // Normalized planes with the outside in front, as DirectXCollision builds them
+        void GetPlanes(XMFLOAT4* NearPlane, XMFLOAT4* FarPlane, XMFLOAT4* RightPlane, XMFLOAT4* LeftPlane,
+            XMFLOAT4* TopPlane, XMFLOAT4* BottomPlane) const
+        {
+            *NearPlane = Internal::TransformPlane(0.0f, 0.0f, -1.0f, Near, Orientation, Origin);
+            *FarPlane = Internal::TransformPlane(0.0f, 0.0f, 1.0f, -Far, Orientation, Origin);
+            *RightPlane = Internal::TransformPlane(1.0f, 0.0f, -RightSlope, 0.0f, Orientation, Origin);
+            *LeftPlane = Internal::TransformPlane(-1.0f, 0.0f, LeftSlope, 0.0f, Orientation, Origin);
+            *TopPlane = Internal::TransformPlane(0.0f, 1.0f, -TopSlope, 0.0f, Orientation, Origin);
+            *BottomPlane = Internal::TransformPlane(0.0f, -1.0f, BottomSlope, 0.0f, Orientation, Origin);
+        }
+
+        // The six planes built from the origin and orientation, then BoundingBox::ContainedBy
+        ContainmentType Contains(const BoundingBox& Box) const
+        {
+            XMFLOAT4 Planes[6];
+            GetPlanes(&Planes[0], &Planes[1], &Planes[2], &Planes[3], &Planes[4], &Planes[5]);
+
+            const float C[3] = { Box.Center.x, Box.Center.y, Box.Center.z };
+            const float E[3] = { Box.Extents.x, Box.Extents.y, Box.Extents.z };
+            bool AllInside = true;
+            for (const XMFLOAT4& P : Planes)
+            {
+                const float N[3] = { P.x, P.y, P.z };
+                const float AbsN[3] = { std::fabs(P.x), std::fabs(P.y), std::fabs(P.z) };
+                const float Dist = Internal::Dot3(C, N) + P.w;
+                const float Radius = Internal::Dot3(E, AbsN);
+                if (Dist > Radius)
+                    return DISJOINT;
+                AllInside = AllInside && Dist < -Radius;
+            }
+            return AllInside ? CONTAINS : INTERSECTS;
+        }
+    };
+}
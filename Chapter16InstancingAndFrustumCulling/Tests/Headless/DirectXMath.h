@@ -0,0 +1,27 @@
+#pragma once
+
+// The storage types of DirectXMath that the culler and its tests use; the headless build has
+// no Windows SDK.
+namespace DirectX
+{
+    struct XMFLOAT3
+    {
+        float x, y, z;
+
+        XMFLOAT3() = default;
+        XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+    };
+
+    struct XMFLOAT4
+    {
+        float x, y, z, w;
+
+        XMFLOAT4() = default;
+        XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+    };
+
+    struct XMFLOAT4X4
+    {
+        float m[4][4];
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Stands in for Core/Math/Frustum.h, which is built on the SIMD types of DirectXMath: just the
+// planes, as the overload of CullBoxes taking a Frustum reads them. Inside is where
+// dot(n, p) + d >= 0, as BoundingPlane has it.
+
+namespace Math
+{
+    class Vector4
+    {
+    public:
+        Vector4() : m_x(0.0f), m_y(0.0f), m_z(0.0f), m_w(0.0f) {}
+        Vector4( float x, float y, float z, float w ) : m_x(x), m_y(y), m_z(z), m_w(w) {}
+
+        float GetX() const { return m_x; }
+        float GetY() const { return m_y; }
+        float GetZ() const { return m_z; }
+        float GetW() const { return m_w; }
+
+    private:
+        float m_x, m_y, m_z, m_w;
+    };
+
+    class Frustum
+    {
+    public:
+        enum PlaneID
+        {
+            kNearPlane, kFarPlane, kLeftPlane, kRightPlane, kTopPlane, kBottomPlane
+        };
+
+        Vector4 GetFrustumPlane( PlaneID id ) const { return m_FrustumPlanes[id]; }
+        void SetFrustumPlane( PlaneID id, const Vector4& Plane ) { m_FrustumPlanes[id] = Plane; }
+
+    private:
+        Vector4 m_FrustumPlanes[6];
+    };
+}
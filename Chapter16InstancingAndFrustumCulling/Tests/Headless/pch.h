@@ -0,0 +1,16 @@
+#pragma once
+
+// Stands in for Core/Utils/pch.h when the device-free parts of Core are built for the
+// headless tests. It comes first on the include path, so "pch.h" resolves here.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Failed assertions end the test run, the message says where
+#define ASSERT( isFalse, ... ) \
+    if (!(bool)(isFalse)) { \
+        fprintf(stderr, "\nAssertion failed in %s @ %d\n--> '%s' is false\n", __FILE__, __LINE__, #isFalse); \
+        abort(); \
+    }
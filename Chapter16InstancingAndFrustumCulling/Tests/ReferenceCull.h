@@ -0,0 +1,149 @@
+#pragma once
+
+#include "FrustumCuller.h"
+#include <algorithm>
+#include <cmath>
+
+// Scalar counterparts of CullBoxes: the same plane test in double precision, and the path
+// GameApp::UpdateInstanceIndex took per instance before the culler, which inverts the world
+// matrix, moves the camera frustum into the local space of the instance and asks
+// BoundingFrustum::Contains about the local box.
+namespace Reference
+{
+    // Visible unless some plane has the whole box behind it. Margin is how far the answer is
+    // from changing, in the units of the planes: the nearest plane of a visible box, the
+    // farthest of a culled one. Float code may answer either way when it is tiny.
+    inline bool IsVisible(const float Planes[6][4], const float C[3], const float E[3], double& Margin)
+    {
+        double Nearest = INFINITY, Behind = 0.0;
+        for (int p = 0; p < 6; ++p)
+        {
+            const double Dist = (double)C[0] * Planes[p][0] + (double)C[1] * Planes[p][1] +
+                (double)C[2] * Planes[p][2] + Planes[p][3];
+            const double Radius = (double)E[0] * std::fabs(Planes[p][0]) + (double)E[1] * std::fabs(Planes[p][1]) +
+                (double)E[2] * std::fabs(Planes[p][2]);
+            Nearest = std::min(Nearest, Dist + Radius);
+            Behind = std::max(Behind, -(Dist + Radius));
+        }
+        Margin = Nearest >= 0.0 ? Nearest : Behind;
+        return Nearest >= 0.0;
+    }
+
+    inline bool IsVisible(const float Planes[6][4], const Math::BoundingBoxSoA& Boxes, uint32_t i, double& Margin)
+    {
+        const float C[3] = { Boxes.CenterX()[i], Boxes.CenterY()[i], Boxes.CenterZ()[i] };
+        const float E[3] = { Boxes.ExtentX()[i], Boxes.ExtentY()[i], Boxes.ExtentZ()[i] };
+        return IsVisible(Planes, C, E, Margin);
+    }
+
+    // Planes of a frustum with the inside in front, as CullBoxes takes them
+    inline void InsidePlanes(const DirectX::BoundingFrustum& Frustum, float Planes[6][4])
+    {
+        DirectX::XMFLOAT4 Outside[6];
+        Frustum.GetPlanes(&Outside[0], &Outside[1], &Outside[2], &Outside[3], &Outside[4], &Outside[5]);
+        for (int p = 0; p < 6; ++p)
+        {
+            Planes[p][0] = -Outside[p].x;
+            Planes[p][1] = -Outside[p].y;
+            Planes[p][2] = -Outside[p].z;
+            Planes[p][3] = -Outside[p].w;
+        }
+    }
+
+    inline DirectX::XMFLOAT4X4 Multiply(const DirectX::XMFLOAT4X4& A, const DirectX::XMFLOAT4X4& B)
+    {
+        DirectX::XMFLOAT4X4 M;
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+                M.m[r][c] = A.m[r][0] * B.m[0][c] + A.m[r][1] * B.m[1][c] + A.m[r][2] * B.m[2][c] + A.m[r][3] * B.m[3][c];
+        }
+        return M;
+    }
+
+    // General inverse by cofactors, as XMMatrixInverse computes it
+    inline DirectX::XMFLOAT4X4 Inverse(const DirectX::XMFLOAT4X4& In)
+    {
+        const float* m = &In.m[0][0];
+        float Inv[16];
+
+        Inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+        Inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+        Inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+        Inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+        Inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+        Inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+        Inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+        Inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+        Inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+        Inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+        Inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+        Inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+        Inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+        Inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+        Inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+        Inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+        const float InvDet = 1.0f / (m[0] * Inv[0] + m[1] * Inv[4] + m[2] * Inv[8] + m[3] * Inv[12]);
+        DirectX::XMFLOAT4X4 Out;
+        for (int i = 0; i < 16; ++i)
+            (&Out.m[0][0])[i] = Inv[i] * InvDet;
+        return Out;
+    }
+
+    // One instance the way UpdateInstanceIndex tested it: ViewFrustum is in view space,
+    // InvView takes view space to world
+    inline bool IsVisibleLocal(const DirectX::BoundingFrustum& ViewFrustum, const DirectX::XMFLOAT4X4& InvView,
+        const DirectX::XMFLOAT4X4& World, const DirectX::BoundingBox& LocalBox)
+    {
+        DirectX::XMFLOAT4X4 ViewToLocal = Multiply(InvView, Inverse(World));
+        DirectX::BoundingFrustum LocalFrustum;
+        ViewFrustum.Transform(LocalFrustum, ViewToLocal);
+        return LocalFrustum.Contains(LocalBox) != DirectX::DISJOINT;
+    }
+
+    // Camera at Eye turned by Yaw about y, then Pitch about x: its view-to-world matrix, rows
+    // right, up, forward and position
+    inline DirectX::XMFLOAT4X4 CameraToWorld(float EyeX, float EyeY, float EyeZ, float Yaw, float Pitch)
+    {
+        const float cy = std::cos(Yaw), sy = std::sin(Yaw), cp = std::cos(Pitch), sp = std::sin(Pitch);
+        DirectX::XMFLOAT4X4 M =
+        { {
+            { cy, 0.0f, -sy, 0.0f },
+            { sy * sp, cp, cy * sp, 0.0f },
+            { sy * cp, -sp, cy * cp, 0.0f },
+            { EyeX, EyeY, EyeZ, 1.0f },
+        } };
+        return M;
+    }
+
+    // View-space frustum of a perspective camera, like BoundingFrustum::CreateFromMatrix gives
+    inline DirectX::BoundingFrustum PerspectiveFrustum(float FovY, float Aspect, float NearZ, float FarZ)
+    {
+        DirectX::BoundingFrustum F;
+        const float TanY = std::tan(FovY * 0.5f);
+        F.TopSlope = TanY;
+        F.BottomSlope = -TanY;
+        F.RightSlope = TanY * Aspect;
+        F.LeftSlope = -TanY * Aspect;
+        F.Near = NearZ;
+        F.Far = FarZ;
+        return F;
+    }
+
+    // Rotation about y, uniform scale and translation, row-vector convention
+    inline DirectX::XMFLOAT4X4 Placement(float Angle, float Scale, float X, float Y, float Z)
+    {
+        DirectX::XMFLOAT4X4 M = {};
+        M.m[0][0] = std::cos(Angle) * Scale;
+        M.m[0][2] = -std::sin(Angle) * Scale;
+        M.m[1][1] = Scale;
+        M.m[2][0] = std::sin(Angle) * Scale;
+        M.m[2][2] = std::cos(Angle) * Scale;
+        M.m[3][0] = X;
+        M.m[3][1] = Y;
+        M.m[3][2] = Z;
+        M.m[3][3] = 1.0f;
+        return M;
+    }
+}
@@ -33,7 +33,9 @@ struct SubmeshGeometry
 	UINT IndexCount = 0;
 	UINT StartIndexLocation = 0;
 	INT BaseVertexLocation = 0;
-	
+
+	// object space distance from the full detail submesh, for the coarser levels of a LOD chain
+	float LodError = 0.0f;
 };
 
 struct MeshGeometry
@@ -0,0 +1,536 @@
+#include "pch.h"
+#include "BVH.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Math;
+using DirectX::XMFLOAT3;
+
+namespace
+{
+    const uint32_t kNumBins = 16;
+    const uint32_t kMaxLeafSize = 8;
+    // relative cost of visiting a node against testing one primitive
+    const float kTraversalCost = 1.0f;
+    const uint32_t kStackSize = 128;
+
+    struct Bounds
+    {
+        float Min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float Max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        void Grow( const float P[3] )
+        {
+            for (int a = 0; a < 3; ++a)
+            {
+                Min[a] = (std::min)(Min[a], P[a]);
+                Max[a] = (std::max)(Max[a], P[a]);
+            }
+        }
+
+        void Grow( const Bounds& B )
+        {
+            for (int a = 0; a < 3; ++a)
+            {
+                Min[a] = (std::min)(Min[a], B.Min[a]);
+                Max[a] = (std::max)(Max[a], B.Max[a]);
+            }
+        }
+
+        float HalfArea( void ) const
+        {
+            if (Min[0] > Max[0])
+                return 0.0f;
+            float dx = Max[0] - Min[0], dy = Max[1] - Min[1], dz = Max[2] - Min[2];
+            return dx * dy + dy * dz + dz * dx;
+        }
+    };
+
+    struct BuildPrimitive
+    {
+        Bounds Box;
+        float Centroid[3];
+    };
+
+    // Binned SAH over Primitives. Order receives the primitive indices in leaf order.
+    void BuildNodes( std::vector<BuildPrimitive>& Primitives, std::vector<uint32_t>& Order, std::vector<BVHNode>& Nodes )
+    {
+        const uint32_t NumPrimitives = (uint32_t)Primitives.size();
+
+        Order.resize(NumPrimitives);
+        for (uint32_t i = 0; i < NumPrimitives; ++i)
+            Order[i] = i;
+
+        Nodes.clear();
+        if (NumPrimitives == 0)
+            return;
+
+        Nodes.reserve(2 * NumPrimitives);
+        Nodes.push_back({});
+        Nodes[0].LeftFirst = 0;
+        Nodes[0].Count = NumPrimitives;
+
+        std::vector<uint32_t> Stack(1, 0);
+
+        while (!Stack.empty())
+        {
+            const uint32_t NodeIndex = Stack.back();
+            Stack.pop_back();
+            const uint32_t First = Nodes[NodeIndex].LeftFirst;
+            const uint32_t Count = Nodes[NodeIndex].Count;
+
+            Bounds NodeBounds, CentroidBounds;
+            for (uint32_t i = First; i < First + Count; ++i)
+            {
+                NodeBounds.Grow(Primitives[Order[i]].Box);
+                CentroidBounds.Grow(Primitives[Order[i]].Centroid);
+            }
+
+            BVHNode& Node = Nodes[NodeIndex];
+            for (int a = 0; a < 3; ++a)
+            {
+                Node.Min[a] = NodeBounds.Min[a];
+                Node.Max[a] = NodeBounds.Max[a];
+            }
+
+            if (Count == 1)
+                continue;
+
+            // find the cheapest bin boundary on any axis
+            int BestAxis = -1;
+            uint32_t BestSplit = 0;
+            float BestCost = FLT_MAX;
+
+            for (int a = 0; a < 3; ++a)
+            {
+                const float Extent = CentroidBounds.Max[a] - CentroidBounds.Min[a];
+                if (Extent <= 0.0f)
+                    continue;
+
+                const float Scale = kNumBins / Extent;
+
+                Bounds BinBounds[kNumBins];
+                uint32_t BinCount[kNumBins] = {};
+                for (uint32_t i = First; i < First + Count; ++i)
+                {
+                    const BuildPrimitive& P = Primitives[Order[i]];
+                    uint32_t Bin = (std::min)(kNumBins - 1, (uint32_t)((P.Centroid[a] - CentroidBounds.Min[a]) * Scale));
+                    BinBounds[Bin].Grow(P.Box);
+                    ++BinCount[Bin];
+                }
+
+                // sweep from the right first so the left sweep can evaluate every split in one pass
+                float RightArea[kNumBins - 1];
+                uint32_t RightCount[kNumBins - 1];
+                Bounds Right;
+                uint32_t Sum = 0;
+                for (uint32_t b = kNumBins - 1; b > 0; --b)
+                {
+                    Right.Grow(BinBounds[b]);
+                    Sum += BinCount[b];
+                    RightArea[b - 1] = Right.HalfArea();
+                    RightCount[b - 1] = Sum;
+                }
+
+                Bounds Left;
+                Sum = 0;
+                for (uint32_t b = 0; b < kNumBins - 1; ++b)
+                {
+                    Left.Grow(BinBounds[b]);
+                    Sum += BinCount[b];
+                    if (Sum == 0 || RightCount[b] == 0)
+                        continue;
+
+                    float Cost = Left.HalfArea() * Sum + RightArea[b] * RightCount[b];
+                    if (Cost < BestCost)
+                    {
+                        BestCost = Cost;
+                        BestAxis = a;
+                        BestSplit = b;
+                    }
+                }
+            }
+
+            const float LeafCost = (float)Count;
+            const float NodeArea = NodeBounds.HalfArea();
+            const float SplitCost = NodeArea > 0.0f ? kTraversalCost + BestCost / NodeArea : FLT_MAX;
+
+            uint32_t* Begin = Order.data() + First;
+            uint32_t* End = Begin + Count;
+            uint32_t* Mid = nullptr;
+
+            if (BestAxis >= 0 && (SplitCost < LeafCost || Count > kMaxLeafSize))
+            {
+                const float Scale = kNumBins / (CentroidBounds.Max[BestAxis] - CentroidBounds.Min[BestAxis]);
+                const float MinC = CentroidBounds.Min[BestAxis];
+                Mid = std::partition(Begin, End, [&](uint32_t i)
+                {
+                    uint32_t Bin = (std::min)(kNumBins - 1, (uint32_t)((Primitives[i].Centroid[BestAxis] - MinC) * Scale));
+                    return Bin <= BestSplit;
+                });
+            }
+            else if (Count > kMaxLeafSize)
+            {
+                // every centroid is in the same spot, SAH cannot separate them
+                Mid = Begin + Count / 2;
+            }
+            else
+            {
+                continue;
+            }
+
+            const uint32_t LeftCount = (uint32_t)(Mid - Begin);
+            const uint32_t LeftIndex = (uint32_t)Nodes.size();
+            Nodes.resize(Nodes.size() + 2);
+
+            Nodes[LeftIndex].LeftFirst = First;
+            Nodes[LeftIndex].Count = LeftCount;
+            Nodes[LeftIndex + 1].LeftFirst = First + LeftCount;
+            Nodes[LeftIndex + 1].Count = Count - LeftCount;
+
+            Nodes[NodeIndex].LeftFirst = LeftIndex;
+            Nodes[NodeIndex].Count = 0;
+
+            Stack.push_back(LeftIndex + 1);
+            Stack.push_back(LeftIndex);
+        }
+    }
+
+    struct RayData
+    {
+        float Origin[3];
+        float Direction[3];
+        float InvDirection[3];
+
+        explicit RayData( const BVHRay& Ray )
+        {
+            Origin[0] = Ray.Origin.x; Origin[1] = Ray.Origin.y; Origin[2] = Ray.Origin.z;
+            Direction[0] = Ray.Direction.x; Direction[1] = Ray.Direction.y; Direction[2] = Ray.Direction.z;
+            for (int a = 0; a < 3; ++a)
+                InvDirection[a] = 1.0f / Direction[a];
+        }
+    };
+
+    // Entry distance of the ray into the node box, FLT_MAX on a miss or if it starts beyond MaxT
+    inline float IntersectNode( const BVHNode& Node, const RayData& Ray, float MaxT )
+    {
+        float TMin = 0.0f, TMax = MaxT;
+        for (int a = 0; a < 3; ++a)
+        {
+            float T0 = (Node.Min[a] - Ray.Origin[a]) * Ray.InvDirection[a];
+            float T1 = (Node.Max[a] - Ray.Origin[a]) * Ray.InvDirection[a];
+            // written so a NaN from 0 * inf leaves the interval unchanged
+            TMin = (std::max)(TMin, (std::min)(T0, T1));
+            TMax = (std::min)(TMax, (std::max)(T0, T1));
+        }
+        return TMin <= TMax ? TMin : FLT_MAX;
+    }
+
+    inline void Sub( float Out[3], const float A[3], const float B[3] )
+    {
+        Out[0] = A[0] - B[0]; Out[1] = A[1] - B[1]; Out[2] = A[2] - B[2];
+    }
+
+    inline void Cross( float Out[3], const float A[3], const float B[3] )
+    {
+        Out[0] = A[1] * B[2] - A[2] * B[1];
+        Out[1] = A[2] * B[0] - A[0] * B[2];
+        Out[2] = A[0] * B[1] - A[1] * B[0];
+    }
+
+    inline float Dot( const float A[3], const float B[3] )
+    {
+        return A[0] * B[0] + A[1] * B[1] + A[2] * B[2];
+    }
+
+    inline const float* AsFloats( const XMFLOAT3& V ) { return &V.x; }
+
+    // Two-sided Moller-Trumbore, the same convention as DirectX::TriangleTests::Intersects
+    inline bool IntersectTriangle( const RayData& Ray, const XMFLOAT3& V0, const XMFLOAT3& E1, const XMFLOAT3& E2, float& T )
+    {
+        float P[3], S[3], Q[3];
+        Cross(P, Ray.Direction, AsFloats(E2));
+        const float Det = Dot(AsFloats(E1), P);
+        if (std::fabs(Det) < 1e-20f)
+            return false;
+
+        const float InvDet = 1.0f / Det;
+        Sub(S, Ray.Origin, AsFloats(V0));
+        const float U = Dot(S, P) * InvDet;
+        if (U < 0.0f || U > 1.0f)
+            return false;
+
+        Cross(Q, S, AsFloats(E1));
+        const float V = Dot(Ray.Direction, Q) * InvDet;
+        if (V < 0.0f || U + V > 1.0f)
+            return false;
+
+        T = Dot(AsFloats(E2), Q) * InvDet;
+        return T > 0.0f;
+    }
+
+    // Walks Nodes nearest child first; TestLeaf(First, Count, MaxT) tests a leaf and returns
+    // the closest hit distance it found, or MaxT if nothing got closer.
+    template <typename LeafFunc>
+    bool Traverse( const std::vector<BVHNode>& Nodes, const RayData& Ray, float& MaxT, LeafFunc TestLeaf )
+    {
+        if (Nodes.empty() || IntersectNode(Nodes[0], Ray, MaxT) == FLT_MAX)
+            return false;
+
+        bool Hit = false;
+        uint32_t Stack[kStackSize];
+        uint32_t StackSize = 0;
+        uint32_t NodeIndex = 0;
+
+        for (;;)
+        {
+            const BVHNode& Node = Nodes[NodeIndex];
+            if (Node.IsLeaf())
+            {
+                float T = TestLeaf(Node.LeftFirst, Node.Count, MaxT);
+                if (T < MaxT)
+                {
+                    MaxT = T;
+                    Hit = true;
+                }
+            }
+            else
+            {
+                uint32_t Near = Node.LeftFirst, Far = Node.LeftFirst + 1;
+                float TNear = IntersectNode(Nodes[Near], Ray, MaxT);
+                float TFar = IntersectNode(Nodes[Far], Ray, MaxT);
+                if (TFar < TNear)
+                {
+                    std::swap(Near, Far);
+                    std::swap(TNear, TFar);
+                }
+
+                if (TNear != FLT_MAX)
+                {
+                    if (TFar != FLT_MAX)
+                    {
+                        ASSERT(StackSize < kStackSize, "BVH deeper than the traversal stack");
+                        Stack[StackSize++] = Far;
+                    }
+                    NodeIndex = Near;
+                    continue;
+                }
+            }
+
+            // pop, dropping nodes that now start behind the closest hit
+            bool Found = false;
+            while (StackSize > 0)
+            {
+                NodeIndex = Stack[--StackSize];
+                if (IntersectNode(Nodes[NodeIndex], Ray, MaxT) != FLT_MAX)
+                {
+                    Found = true;
+                    break;
+                }
+            }
+            if (!Found)
+                break;
+        }
+
+        return Hit;
+    }
+}
+
+void TriangleBVH::Clear( void )
+{
+    m_Nodes.clear();
+    m_Triangles.clear();
+}
+
+void TriangleBVH::Build( const void* Positions, uint32_t Stride, uint32_t NumVertices,
+    const int32_t* Indices, uint32_t NumIndices, int32_t BaseVertex )
+{
+    const uint32_t NumTriangles = NumIndices / 3;
+
+    auto Position = [&](uint32_t i) -> const float*
+    {
+        int32_t Vertex = Indices[i] + BaseVertex;
+        ASSERT(Vertex >= 0 && (uint32_t)Vertex < NumVertices);
+        return (const float*)((const uint8_t*)Positions + (size_t)Vertex * Stride);
+    };
+
+    std::vector<BuildPrimitive> Primitives(NumTriangles);
+    for (uint32_t t = 0; t < NumTriangles; ++t)
+    {
+        BuildPrimitive& P = Primitives[t];
+        P.Box.Grow(Position(t * 3 + 0));
+        P.Box.Grow(Position(t * 3 + 1));
+        P.Box.Grow(Position(t * 3 + 2));
+        for (int a = 0; a < 3; ++a)
+            P.Centroid[a] = 0.5f * (P.Box.Min[a] + P.Box.Max[a]);
+    }
+
+    std::vector<uint32_t> Order;
+    BuildNodes(Primitives, Order, m_Nodes);
+
+    m_Triangles.resize(NumTriangles);
+    for (uint32_t i = 0; i < NumTriangles; ++i)
+    {
+        const uint32_t t = Order[i];
+        const float* P0 = Position(t * 3 + 0);
+        const float* P1 = Position(t * 3 + 1);
+        const float* P2 = Position(t * 3 + 2);
+
+        Triangle& Tri = m_Triangles[i];
+        Tri.V0 = XMFLOAT3(P0[0], P0[1], P0[2]);
+        Tri.E1 = XMFLOAT3(P1[0] - P0[0], P1[1] - P0[1], P1[2] - P0[2]);
+        Tri.E2 = XMFLOAT3(P2[0] - P0[0], P2[1] - P0[1], P2[2] - P0[2]);
+        Tri.Index = t;
+    }
+}
+
+bool TriangleBVH::Intersect( const BVHRay& Ray, BVHHit& Hit ) const
+{
+    const RayData R(Ray);
+    uint32_t Closest = ~0u;
+
+    bool Found = Traverse(m_Nodes, R, Hit.T, [&](uint32_t First, uint32_t Count, float MaxT)
+    {
+        for (uint32_t i = First; i < First + Count; ++i)
+        {
+            const Triangle& Tri = m_Triangles[i];
+            float T;
+            if (IntersectTriangle(R, Tri.V0, Tri.E1, Tri.E2, T) && T < MaxT)
+            {
+                MaxT = T;
+                Closest = Tri.Index;
+            }
+        }
+        return MaxT;
+    });
+
+    if (Found)
+        Hit.Triangle = Closest;
+    return Found;
+}
+
+void InstanceBVH::Clear( void )
+{
+    m_Mesh = nullptr;
+    m_Nodes.clear();
+    m_Instances.clear();
+}
+
+void InstanceBVH::Build( const TriangleBVH& Mesh, const DirectX::XMFLOAT4X4* Worlds, uint32_t NumInstances, uint32_t Stride )
+{
+    Clear();
+    if (Mesh.IsEmpty())
+        return;
+
+    m_Mesh = &Mesh;
+
+    const BVHNode& Root = Mesh.GetRoot();
+    float Center[3], Extent[3];
+    for (int a = 0; a < 3; ++a)
+    {
+        Center[a] = 0.5f * (Root.Min[a] + Root.Max[a]);
+        Extent[a] = 0.5f * (Root.Max[a] - Root.Min[a]);
+    }
+
+    std::vector<BuildPrimitive> Primitives(NumInstances);
+    std::vector<Instance> Unordered(NumInstances);
+
+    for (uint32_t i = 0; i < NumInstances; ++i)
+    {
+        const DirectX::XMFLOAT4X4& W = *(const DirectX::XMFLOAT4X4*)((const uint8_t*)Worlds + (size_t)i * Stride);
+
+        // world space box of the mesh root: transformed center plus the extents projected on |M|
+        BuildPrimitive& P = Primitives[i];
+        for (int c = 0; c < 3; ++c)
+        {
+            float WorldCenter = W.m[3][c], WorldExtent = 0.0f;
+            for (int r = 0; r < 3; ++r)
+            {
+                WorldCenter += Center[r] * W.m[r][c];
+                WorldExtent += Extent[r] * std::fabs(W.m[r][c]);
+            }
+            P.Box.Min[c] = WorldCenter - WorldExtent;
+            P.Box.Max[c] = WorldCenter + WorldExtent;
+            P.Centroid[c] = WorldCenter;
+        }
+
+        // rows are basis vectors in the row-vector convention, invert the 3x3 by its adjugate
+        const float (*M)[4] = W.m;
+        float Cofactor[3][3];
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                const int r0 = (r + 1) % 3, r1 = (r + 2) % 3, c0 = (c + 1) % 3, c1 = (c + 2) % 3;
+                Cofactor[r][c] = M[r0][c0] * M[r1][c1] - M[r0][c1] * M[r1][c0];
+            }
+        }
+        const float Det = M[0][0] * Cofactor[0][0] + M[0][1] * Cofactor[0][1] + M[0][2] * Cofactor[0][2];
+        ASSERT(std::fabs(Det) > 0.0f, "Instance world matrix is singular");
+        const float InvDet = 1.0f / Det;
+
+        Instance& Inst = Unordered[i];
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+                Inst.WorldToLocal[r][c] = Cofactor[c][r] * InvDet;
+            Inst.Translation[r] = M[3][r];
+        }
+        Inst.Index = i;
+    }
+
+    std::vector<uint32_t> Order;
+    BuildNodes(Primitives, Order, m_Nodes);
+
+    m_Instances.resize(NumInstances);
+    for (uint32_t i = 0; i < NumInstances; ++i)
+        m_Instances[i] = Unordered[Order[i]];
+}
+
+bool InstanceBVH::Intersect( const BVHRay& WorldRay, BVHHit& Hit ) const
+{
+    if (m_Mesh == nullptr)
+        return false;
+
+    const RayData R(WorldRay);
+    uint32_t ClosestInstance = ~0u, ClosestTriangle = ~0u;
+
+    bool Found = Traverse(m_Nodes, R, Hit.T, [&](uint32_t First, uint32_t Count, float MaxT)
+    {
+        for (uint32_t i = First; i < First + Count; ++i)
+        {
+            const Instance& Inst = m_Instances[i];
+
+            // local = (world - translation) * WorldToLocal, direction without the translation
+            float O[3];
+            Sub(O, R.Origin, Inst.Translation);
+
+            float LocalOrigin[3], LocalDirection[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                LocalOrigin[c] = O[0] * Inst.WorldToLocal[0][c] + O[1] * Inst.WorldToLocal[1][c] + O[2] * Inst.WorldToLocal[2][c];
+                LocalDirection[c] = R.Direction[0] * Inst.WorldToLocal[0][c] + R.Direction[1] * Inst.WorldToLocal[1][c] + R.Direction[2] * Inst.WorldToLocal[2][c];
+            }
+
+            BVHRay LocalRay = { XMFLOAT3(LocalOrigin[0], LocalOrigin[1], LocalOrigin[2]),
+                XMFLOAT3(LocalDirection[0], LocalDirection[1], LocalDirection[2]) };
+
+            BVHHit LocalHit;
+            LocalHit.T = MaxT;
+            if (m_Mesh->Intersect(LocalRay, LocalHit))
+            {
+                MaxT = LocalHit.T;
+                ClosestInstance = Inst.Index;
+                ClosestTriangle = LocalHit.Triangle;
+            }
+        }
+        return MaxT;
+    });
+
+    if (Found)
+    {
+        Hit.Instance = ClosestInstance;
+        Hit.Triangle = ClosestTriangle;
+    }
+    return Found;
+}
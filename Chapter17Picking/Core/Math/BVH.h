@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+namespace Math
+{
+    // Ray for the BVH queries. Direction does not need to be unit length: hit distances are
+    // measured in multiples of it, which keeps them comparable after an affine transform into
+    // an instance's local space.
+    struct BVHRay
+    {
+        DirectX::XMFLOAT3 Origin;
+        DirectX::XMFLOAT3 Direction;
+    };
+
+    struct BVHHit
+    {
+        float T = FLT_MAX;          // only hits closer than this are reported
+        uint32_t Instance = ~0u;
+        uint32_t Triangle = ~0u;    // triangle index in the source index buffer, i.e. first index / 3
+
+        bool IsValid( void ) const { return Triangle != ~0u; }
+    };
+
+    // Node layout used by both levels, 32 bytes so two share a cache line. The nodes are stored
+    // depth first and the two children of an interior node are adjacent, so one index reaches both.
+    struct BVHNode
+    {
+        float Min[3];
+        uint32_t LeftFirst;     // interior: left child, the right child is LeftFirst + 1. leaf: first primitive
+        float Max[3];
+        uint32_t Count;         // primitives in a leaf, 0 for interior nodes
+
+        bool IsLeaf( void ) const { return Count != 0; }
+    };
+
+    // Bottom level: triangles of one mesh in its local space, split with a binned SAH.
+    // Everything is CPU side, nothing here touches the device.
+    class TriangleBVH
+    {
+    public:
+        // Positions are read Stride bytes apart (e.g. sizeof(Vertex)), indices are offset by BaseVertex.
+        void Build( const void* Positions, uint32_t Stride, uint32_t NumVertices,
+            const int32_t* Indices, uint32_t NumIndices, int32_t BaseVertex = 0 );
+        void Clear( void );
+
+        // Closest triangle hit by Ray closer than Hit.T. Updates T and Triangle and returns true
+        // when one is found; Hit.Instance is left alone.
+        bool Intersect( const BVHRay& Ray, BVHHit& Hit ) const;
+
+        bool IsEmpty( void ) const { return m_Nodes.empty(); }
+        uint32_t GetNodeCount( void ) const { return (uint32_t)m_Nodes.size(); }
+        uint32_t GetTriangleCount( void ) const { return (uint32_t)m_Triangles.size(); }
+        const BVHNode& GetRoot( void ) const { return m_Nodes[0]; }
+
+    private:
+        // Stored in leaf order as one vertex plus two edges, ready for the Moller-Trumbore test
+        struct Triangle
+        {
+            DirectX::XMFLOAT3 V0;
+            DirectX::XMFLOAT3 E1;
+            DirectX::XMFLOAT3 E2;
+            uint32_t Index;
+        };
+
+        std::vector<BVHNode> m_Nodes;
+        std::vector<Triangle> m_Triangles;
+    };
+
+    // Top level: instances of one TriangleBVH placed by their world matrices. A query walks the
+    // instance boxes nearest first, moves the ray into the local space of each candidate and
+    // skips every box that starts beyond the closest hit found so far.
+    class InstanceBVH
+    {
+    public:
+        // Worlds are row-vector DirectX matrices read Stride bytes apart, so the World member of
+        // a per-instance struct can be passed directly. Mesh must outlive this object.
+        void Build( const TriangleBVH& Mesh, const DirectX::XMFLOAT4X4* Worlds, uint32_t NumInstances,
+            uint32_t Stride = sizeof(DirectX::XMFLOAT4X4) );
+        void Clear( void );
+
+        // Hit.T is in units of WorldRay.Direction. Hit.Instance is the index of the world matrix.
+        bool Intersect( const BVHRay& WorldRay, BVHHit& Hit ) const;
+
+        bool IsEmpty( void ) const { return m_Nodes.empty(); }
+        uint32_t GetNodeCount( void ) const { return (uint32_t)m_Nodes.size(); }
+
+    private:
+        struct Instance
+        {
+            float WorldToLocal[3][3];   // inverse of the upper 3x3 of the world matrix
+            float Translation[3];       // world translation, removed before WorldToLocal
+            uint32_t Index;
+        };
+
+        const TriangleBVH* m_Mesh = nullptr;
+        std::vector<BVHNode> m_Nodes;
+        std::vector<Instance> m_Instances;
+    };
+
+} // namespace Math
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <DirectXMath.h>
+
+// Binary mesh cache. A .mesh file is a fixed header followed by 64-byte aligned blobs that are
+// laid out exactly as the GPU buffers want them, so loading is mapping the file and checking
+// the header: no parsing, no intermediate copies before GpuBuffer::Create.
+//
+//   Header | Vertex[VertexCount] | XMFLOAT3 tangent[VertexCount] | index[IndexCount]
+//
+// Indices are 16-bit whenever every vertex is addressable with them, 32-bit otherwise. The
+// index blob holds every level of detail one after the other, full detail first, all of them
+// indexing the same vertices; Header::Lods says where each level starts.
+namespace MeshFile
+{
+    const uint32_t kMagic = 0x4853454D;     // "MESH"
+    const uint32_t kVersion = 2;
+    const uint32_t kMaxLods = 5;
+
+    struct Vertex
+    {
+        DirectX::XMFLOAT3 Position;
+        DirectX::XMFLOAT3 Normal;
+        DirectX::XMFLOAT2 Tex;
+    };
+
+    struct Lod
+    {
+        uint32_t StartIndex;
+        uint32_t IndexCount;
+        float Error;                // object space distance from the full detail level
+    };
+
+    struct Header
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t VertexCount;
+        uint32_t VertexStride;      // sizeof(Vertex) of the writer, checked on load
+        uint32_t IndexCount;        // of every level together
+        uint32_t IndexSize;         // 2 or 4 bytes
+        float BoundsMin[3];
+        float BoundsMax[3];
+        uint32_t LodCount;
+        Lod Lods[kMaxLods];
+        uint64_t VertexOffset;
+        uint64_t TangentOffset;
+        uint64_t IndexOffset;
+        uint64_t FileSize;
+    };
+
+    // A .mesh file mapped into memory. Every pointer returned points into the mapping and stays
+    // valid until Unload or destruction.
+    class Mesh
+    {
+    public:
+        // Maps FileName and validates the header and blob ranges.
+        bool Load(const std::wstring& FileName);
+
+        // Loads CacheFile, and when it is missing or stale converts TextFile into it first.
+        bool LoadOrConvert(const std::wstring& CacheFile, const std::wstring& TextFile);
+
+        void Unload(void);
+
+        bool IsLoaded(void) const { return m_Header != nullptr; }
+        const Header& GetHeader(void) const { return *m_Header; }
+
+        uint32_t GetVertexCount(void) const { return m_Header->VertexCount; }
+        uint32_t GetIndexCount(void) const { return m_Header->IndexCount; }
+        uint32_t GetIndexSize(void) const { return m_Header->IndexSize; }
+        uint32_t GetLodCount(void) const { return m_Header->LodCount; }
+        const Lod& GetLod(uint32_t i) const { return m_Header->Lods[i]; }
+
+        const Vertex* GetVertices(void) const { return (const Vertex*)(m_File.GetData() + m_Header->VertexOffset); }
+        const DirectX::XMFLOAT3* GetTangents(void) const { return (const DirectX::XMFLOAT3*)(m_File.GetData() + m_Header->TangentOffset); }
+        const void* GetIndices(void) const { return m_File.GetData() + m_Header->IndexOffset; }
+
+        uint32_t GetIndex(uint32_t i) const
+        {
+            return m_Header->IndexSize == 2 ? ((const uint16_t*)GetIndices())[i] : ((const uint32_t*)GetIndices())[i];
+        }
+
+    private:
+        Utility::MappedFile m_File;
+        const Header* m_Header = nullptr;
+    };
+
+    // Offline conversion from the book's text format ("VertexCount:", "TriangleCount:", one
+    // "px py pz nx ny nz" line per vertex, then three indices per triangle). Reorders the mesh
+    // for the vertex cache, simplifies it into up to kMaxLods levels, computes the bounds and
+    // per-vertex tangents and writes OutputFile.
+    bool ConvertTextModel(const std::wstring& TextFile, const std::wstring& OutputFile);
+
+} // namespace MeshFile
@@ -12,6 +12,7 @@
 #include "TextureManager.h"
 #include "DescriptorHeap.h"
 #include <fstream>
+#include "MeshFile.h"
 #include <d3dcompiler.h>
 
 using namespace Graphics;
@@ -212,7 +213,26 @@ void GameApp::DrawRenderItems(GraphicsContext& gfxContext, std::vector<RenderIte
 		gfxContext.SetVertexBuffer(0, iter->Geo->m_VertexBuffer.VertexBufferView());
 		gfxContext.SetIndexBuffer(iter->Geo->m_IndexBuffer.IndexBufferView());
 
-		gfxContext.DrawIndexedInstanced(iter->IndexCount, iter->InstanceCount, iter->StartIndexLocation, iter->BaseVertexLocation, 0);
+		if (iter->Lods.empty())
+		{
+			gfxContext.DrawIndexedInstanced(iter->IndexCount, iter->InstanceCount, iter->StartIndexLocation, iter->BaseVertexLocation, 0);
+			continue;
+		}
+
+		// SV_InstanceID restarts at 0 for every draw, so each level's run of the instance
+		// buffer is bound at its own offset
+		UINT firstInstance = iter->FirstInstance;
+		for (size_t lod = 0; lod < iter->Lods.size(); ++lod)
+		{
+			UINT count = iter->LodInstanceCounts[lod];
+			if (count == 0)
+				continue;
+
+			const SubmeshGeometry* submesh = iter->Lods[lod];
+			gfxContext.SetBufferSRV(1, InstBuffer, (UINT64)firstInstance * sizeof(Instances));
+			gfxContext.DrawIndexedInstanced(submesh->IndexCount, count, submesh->StartIndexLocation, submesh->BaseVertexLocation, 0);
+			firstInstance += count;
+		}
 	}
 }
 
@@ -229,9 +249,13 @@ void GameApp::BuildRenderItems()
 	skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["car"].StartIndexLocation;
 	skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["car"].BaseVertexLocation;
 	skullRitem->Bound = skullRitem->Geo->DrawArgs["car"].Bound;
+	skullRitem->Lods.push_back(&skullRitem->Geo->DrawArgs["car"]);
+	for (int i = 1; skullRitem->Geo->DrawArgs.count("car_lod" + std::to_string(i)) != 0; ++i)
+		skullRitem->Lods.push_back(&skullRitem->Geo->DrawArgs["car_lod" + std::to_string(i)]);
 	const int n = 5;
 
 	skullRitem->inst.resize(n*n*n);
+	skullRitem->InstanceLods.assign(n*n*n, 0);
 	skullRitem->InstanceCount = 5 * 5 * 5;
 
 	float width = 200.0f;
@@ -265,6 +289,8 @@ void GameApp::BuildRenderItems()
 	}
 
 
+	skullRitem->InstanceBvh.Build(skullRitem->Geo->Bvh, &skullRitem->inst[0].World, (UINT)skullRitem->inst.size(), sizeof(Instances));
+
 	auto pickedRitem = std::make_unique<RenderItem>();
 	pickedRitem->World = XMMatrixIdentity();
 	pickedRitem->TexTransform = XMMatrixIdentity();
@@ -282,7 +308,7 @@ void GameApp::BuildRenderItems()
 	pickedRitem->StartIndexLocation = 0;
 	pickedRitem->BaseVertexLocation = 0;
 
-	mPickedRitem = skullRitem.get();
+	mPickedRitem = pickedRitem.get();
 
 	m_LayerRenders[(int)RenderLayer::Opaque].push_back(skullRitem.get());
 	m_LayerRenders[(int)RenderLayer::Picking].push_back(pickedRitem.get());
@@ -293,71 +319,58 @@ void GameApp::BuildRenderItems()
 
 void GameApp::BuildCarGeometry()
 {
-	std::ifstream fin("../Models/car.txt");
-
-	if (!fin)
+	// car.mesh is converted from car.txt the first time (or whenever the text is newer) and
+	// memory mapped afterwards, the vertex and index blobs go to the gpu buffers as they are.
+	// The conversion also simplifies the car, its coarser levels follow the full detail indices
+	MeshFile::Mesh mesh;
+	if (!mesh.LoadOrConvert(L"../Models/car.mesh", L"../Models/car.txt"))
 	{
-		MessageBox(0, L"Models/skull.txt not found.", 0, 0);
+		MessageBox(0, L"Models/car.txt not found.", 0, 0);
 		return;
 	}
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
+	static_assert(sizeof(Vertex) == sizeof(MeshFile::Vertex), "Vertex no longer matches the mesh file layout");
 
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-	XMFLOAT3 vMinf(INFINITY, INFINITY, INFINITY);
-	XMFLOAT3 vMaxf(-INFINITY, -INFINITY, -INFINITY);
-
-	XMVECTOR vMin = XMLoadFloat3(&vMinf);
-	XMVECTOR vMax = XMLoadFloat3(&vMaxf);
-
-	std::vector<Vertex> vertices(vcount);
-	for (UINT i = 0; i < vcount; ++i)
-	{
-		fin >> vertices[i].position.x >> vertices[i].position.y >> vertices[i].position.z;
-		fin >> vertices[i].normal.x >> vertices[i].normal.y >> vertices[i].normal.z;
-
-		// Model does not have texture coordinates, so just zero them out.
-		vertices[i].tex = { 0.0f, 0.0f };
-
-		XMVECTOR P = XMLoadFloat3(&vertices[i].position);
-
-		vMin = XMVectorMin(vMin, P);
-		vMax = XMVectorMax(vMax, P);
-	}
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-	std::vector<std::int32_t> indices(3 * tcount);
-	for (UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-	}
-
-	fin.close();
+	const MeshFile::Header& header = mesh.GetHeader();
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->name = "carGeo";
-	geo->m_VertexBuffer.Create(L"vertex buff", (UINT)vertices.size(), sizeof(Vertex), vertices.data());
-	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), sizeof(std::int32_t), indices.data());
+	geo->m_VertexBuffer.Create(L"vertex buff", mesh.GetVertexCount(), sizeof(Vertex), mesh.GetVertices());
+	geo->m_IndexBuffer.Create(L"Index Buffer", mesh.GetIndexCount(), mesh.GetIndexSize(), mesh.GetIndices());
+
+	XMVECTOR vMin = XMVectorSet(header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2], 0.0f);
+	XMVECTOR vMax = XMVectorSet(header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2], 0.0f);
 
 	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
+	submesh.IndexCount = mesh.GetLod(0).IndexCount;
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
 	XMStoreFloat3(&submesh.Bound.Center, 0.5f * (vMax + vMin));
 	XMStoreFloat3(&submesh.Bound.Extents, 0.5f * (vMax - vMin));
 
+	for (UINT i = 1; i < mesh.GetLodCount(); ++i)
+	{
+		const MeshFile::Lod& level = mesh.GetLod(i);
+
+		SubmeshGeometry lod = submesh;
+		lod.IndexCount = level.IndexCount;
+		lod.StartIndexLocation = level.StartIndex;
+		lod.LodError = level.Error;
+		geo->DrawArgs["car_lod" + std::to_string(i)] = std::move(lod);
+
+		Utility::Printf("car LOD %u: %u triangles, error %.3f\n", i, level.IndexCount / 3, level.Error);
+	}
+
 	geo->DrawArgs["car"] = std::move(submesh);
 
-	geo->vertices = std::move(vertices);
-	geo->indices = std::move(indices);
+	// picking keeps a cpu copy of the full detail level, a picked triangle is highlighted from it
+	const Vertex* vertices = (const Vertex*)mesh.GetVertices();
+	geo->vertices.assign(vertices, vertices + mesh.GetVertexCount());
+	geo->indices.resize(mesh.GetLod(0).IndexCount);
+	for (UINT i = 0; i < mesh.GetLod(0).IndexCount; ++i)
+		geo->indices[i] = (std::int32_t)mesh.GetIndex(i);
+
+	geo->Bvh.Build(&geo->vertices[0].position, sizeof(Vertex), (UINT)geo->vertices.size(), geo->indices.data(), (UINT)geo->indices.size());
 
 	m_Geometry["carGeo"] = std::move(geo);
 }
@@ -480,6 +493,35 @@ void GameApp::LoadTextures()
 		m_srvs.push_back(t.GetSRV());
 }
 
+// A level is good enough while its error covers less than a pixel on screen. Going coarser
+// takes a clear margin under that, so an instance sitting at a switch distance keeps its level.
+static UINT SelectLod(const std::vector<const SubmeshGeometry*>& lods, UINT lod, float pixelsPerError)
+{
+	const float maxPixelError = 1.0f;
+	const float coarserPixelError = 0.75f;
+
+	lod = (std::min)(lod, (UINT)lods.size() - 1);
+	while (lod > 0 && lods[lod]->LodError * pixelsPerError > maxPixelError)
+		--lod;
+	while (lod + 1 < lods.size() && lods[lod + 1]->LodError * pixelsPerError <= coarserPixelError)
+		++lod;
+	return lod;
+}
+
+float GameApp::LodPixelsPerError(FXMMATRIX world)
+{
+	// pixels covered by one unit of length one unit in front of the camera
+	float pixelsPerUnit = g_DisplayHeight / (2.0f * tanf(camera.GetFOV() * 0.5f));
+
+	// errors are in object space, the largest axis scale takes them to world space
+	float scale = (std::max)({ XMVectorGetX(XMVector3Length(world.r[0])),
+		XMVectorGetX(XMVector3Length(world.r[1])),
+		XMVectorGetX(XMVector3Length(world.r[2])) });
+	XMVECTOR eye = camera.GetPosition();
+	float distance = (std::max)(XMVectorGetX(XMVector3Length(world.r[3] - eye)), camera.GetNearClip());
+	return scale * pixelsPerUnit / distance;
+}
+
 void GameApp::UpdateInstanceIndex(float deltaT)
 {
 	XMMATRIX view = camera.GetViewMatrix();
@@ -487,15 +529,16 @@ void GameApp::UpdateInstanceIndex(float deltaT)
 	XMMATRIX invView = XMMatrixInverse(&vDet, view);
 
 	std::vector<Instances> visibleInstance;
+	UINT lodTriangles = 0, fullTriangles = 0;
 	for (auto& e : m_LayerRenders[(int)RenderLayer::Opaque])
 	{
 		const auto& inst = e->inst;
 		Utility::Printf("total Instance counts : %u \n", inst.size());
+
+		m_VisibleInstances.clear();
 		for (UINT i = 0; i < (UINT)inst.size(); ++i)
 		{
 			XMMATRIX world = XMLoadFloat4x4(&inst[i].World);
-			XMMATRIX texTransform = XMLoadFloat4x4(&inst[i].TexTransform);
-			XMMATRIX matTransform = XMLoadFloat4x4(&inst[i].MatTransform);
 
 			XMVECTOR wDet = XMMatrixDeterminant(world);
 			XMMATRIX invWorld = XMMatrixInverse(&wDet, world);
@@ -509,22 +552,47 @@ void GameApp::UpdateInstanceIndex(float deltaT)
 			mCamFrustum.Transform(localSpaceFrustum, viewToLocal);
 
 			if ((localSpaceFrustum.Contains(e->Bound) != DirectX::DISJOINT) || m_bFrustumCulling)
-			{
-				Instances temp;
-				XMStoreFloat4x4(&temp.World, XMMatrixTranspose(world));
-				XMStoreFloat4x4(&temp.TexTransform, XMMatrixTranspose(texTransform));
-				XMStoreFloat4x4(&temp.MatTransform, XMMatrixTranspose(matTransform));
-				temp.MaterialIndex = inst[i].MaterialIndex;
-				visibleInstance.push_back(std::move(temp));
-			}
+				m_VisibleInstances.push_back(i);
+		}
+
+		// pick a level for every visible instance, then lay them out level by level so each
+		// level is drawn with one instanced draw
+		const UINT levels = (UINT)e->Lods.size();
+		e->LodInstanceCounts.assign(levels, 0);
+		for (UINT i : m_VisibleInstances)
+		{
+			e->InstanceLods[i] = SelectLod(e->Lods, e->InstanceLods[i], LodPixelsPerError(XMLoadFloat4x4(&inst[i].World)));
+			++e->LodInstanceCounts[e->InstanceLods[i]];
+		}
+
+		e->FirstInstance = (UINT)visibleInstance.size();
+		e->InstanceCount = (UINT)m_VisibleInstances.size();
+		visibleInstance.resize(visibleInstance.size() + m_VisibleInstances.size());
+
+		std::vector<UINT> next(levels, e->FirstInstance);
+		for (UINT lod = 1; lod < levels; ++lod)
+			next[lod] = next[lod - 1] + e->LodInstanceCounts[lod - 1];
+
+		for (UINT i : m_VisibleInstances)
+		{
+			Instances& temp = visibleInstance[next[e->InstanceLods[i]]++];
+			XMStoreFloat4x4(&temp.World, XMMatrixTranspose(XMLoadFloat4x4(&inst[i].World)));
+			XMStoreFloat4x4(&temp.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&inst[i].TexTransform)));
+			XMStoreFloat4x4(&temp.MatTransform, XMMatrixTranspose(XMLoadFloat4x4(&inst[i].MatTransform)));
+			temp.MaterialIndex = inst[i].MaterialIndex;
 		}
 
-		e->InstanceCount = visibleInstance.size();
+		for (UINT lod = 0; lod < levels; ++lod)
+		{
+			lodTriangles += e->LodInstanceCounts[lod] * (e->Lods[lod]->IndexCount / 3);
+			fullTriangles += e->LodInstanceCounts[lod] * (e->Lods[0]->IndexCount / 3);
+		}
 	}
 
 	InstBuffer.Create(L"Instance buffer", (UINT)visibleInstance.size(), sizeof(Instances), visibleInstance.data());
 	
 	Utility::Printf("Instance counts after culling : %u \n", visibleInstance.size());
+	Utility::Printf("LOD: %u of %u triangles\n", lodTriangles, fullTriangles);
 }
 
 void GameApp::UpdateCamera(float deltaT)
@@ -577,21 +645,20 @@ void GameApp::Pick()
 	if (!GameInput::IsPressed(GameInput::kMouse0))
 		return;
 	POINT point = GameInput::GetCurPos();
-	// Make each pixel correspond to a quarter of a degree.
 
 	XMFLOAT4X4 P;
 	XMStoreFloat4x4(&P, camera.GetProjMatrix());
 	// compute picking ray in view sapce
-	float vx = (+0.2 * point.x / g_DisplayWidth  - 1.0f) / P(0,0);
-	float vy = (-0.2 * point.y / g_DisplayHeight + 1.0f) / P(1,1);
+	float vx = (+2.0f * point.x / g_DisplayWidth  - 1.0f) / P(0,0);
+	float vy = (-2.0f * point.y / g_DisplayHeight + 1.0f) / P(1,1);
 
-	// ray definition in view space
-	XMVECTOR rayOrigin = XMVectorSet(0.0, 0.0, 0.0, 1.0);
-	XMVECTOR rayDir    = XMVectorSet(vx,  vy,  1.0, 0.0);
+	// the camera looks down -z in view space, the ray goes to world space with the camera rotation
+	Math::Vector3 rayDir = camera.GetRotation() * Math::Vector3(vx, vy, -1.0f);
+	Math::Vector3 rayOrigin = camera.GetPosition();
 
-	XMMATRIX V = camera.GetViewMatrix();
-	auto det = XMMatrixDeterminant(V);
-	XMMATRIX invView = XMMatrixInverse(&det, V);
+	Math::BVHRay ray;
+	XMStoreFloat3(&ray.Origin, rayOrigin);
+	XMStoreFloat3(&ray.Direction, rayDir);
 
 	// assume nothing is picked to start, so the picked render-item is invisible
 
@@ -599,78 +666,30 @@ void GameApp::Pick()
 
 	// check if we pick an opaque render item. A real app might keep a separate "picking list"
 	// of objects that can be selected.
+	// the instance bvh only visits instances whose box the ray enters before the closest hit
+	// so far, and only their triangle bvh leaves along the ray are tested
+	Math::BVHHit hit;
+	RenderItem* pickedItem = nullptr;
 	for (auto ri : m_LayerRenders[(int)RenderLayer::Opaque])
 	{
-		for (int i = 0; i < ri->InstanceCount; ++i)
-		{
-			auto item = ri->inst[i];
-
-			XMMATRIX W = XMLoadFloat4x4(&item.World);
-			auto det = XMMatrixDeterminant(W);
-			XMMATRIX invWorld = XMMatrixInverse(&det, W);
-			// tranform ray to view space of mesh
-			XMMATRIX toLocal = XMMatrixMultiply(invView, invWorld);
-
-			rayOrigin = XMVector3TransformCoord(rayOrigin, toLocal);
-			rayDir = XMVector3TransformNormal(rayDir, toLocal);
-
-			// make the ray direction unit length for the intersection tests;
-			rayDir = XMVector3Normalize(rayDir);
-
-			// If we hit the bounding box of the Mesh, then we might have picked a Mesh triangle,
-		// so do the ray/triangle tests.
-		//
-		// If we did not hit the bounding box, then it is impossible that we hit 
-		// the Mesh, so do not waste effort doing ray/triangle tests.
-			float tmin = 0.0;
-			if (ri->Bound.Intersects(rayOrigin, rayDir, tmin))
-			{
-				auto vertices = ri->Geo->vertices;
-				auto indices = ri->Geo->indices;
-
-				UINT triCount = ri->IndexCount / 3;
-
-				tmin = INFINITY;
-				for (UINT i = 0; i < triCount; ++i)
-				{
-					// Indices for this triangle.
-					UINT i0 = indices[i * 3 + 0];
-					UINT i1 = indices[i * 3 + 1];
-					UINT i2 = indices[i * 3 + 2];
-
-					// Vertices for this triangle.
-					XMVECTOR v0 = XMLoadFloat3(&vertices[i0].position);
-					XMVECTOR v1 = XMLoadFloat3(&vertices[i1].position);
-					XMVECTOR v2 = XMLoadFloat3(&vertices[i2].position);
-
-					float t = 0.0f;
-					if (TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t))
-					{
-						// this is the new nearest picked triangle
-						if (t < tmin)
-						{
-							tmin = t;
-							UINT pickedTriangle = i;
-
-							mPickedRitem->Visible = true;
-							mPickedRitem->IndexCount = ri->IndexCount;
-							mPickedRitem->BaseVertexLocation = 0;
-							// offset to the pick triangle in the mesh index buffer;
-							mPickedRitem->StartIndexLocation = 0;
-
-							//Picked render item needs same world matrix as object picked.
-							mPickedRitem->InstanceCount = 1;
-							Instances temp = item;
-
-							temp.MaterialIndex = 6;
-							XMMATRIX m = XMMatrixIdentity() * XMMatrixScaling(1.1, 1.1, 1.1);
-							XMStoreFloat4x4(&temp.World, m);
-							mPickedRitem->inst.resize(1);
-							mPickedRitem->inst[0] = std::move(temp);
-						}
-					}
-				}
-			}
-		}
+		if (ri->InstanceBvh.Intersect(ray, hit))
+			pickedItem = ri;
 	}
+
+	if (pickedItem == nullptr)
+		return;
+
+	mPickedRitem->Visible = true;
+	mPickedRitem->Geo = pickedItem->Geo;
+	mPickedRitem->IndexCount = 3;
+	mPickedRitem->BaseVertexLocation = pickedItem->BaseVertexLocation;
+	// offset to the pick triangle in the mesh index buffer;
+	mPickedRitem->StartIndexLocation = pickedItem->StartIndexLocation + 3 * hit.Triangle;
+
+	//Picked render item needs same world matrix as object picked.
+	mPickedRitem->InstanceCount = 1;
+	Instances temp = pickedItem->inst[hit.Instance];
+	temp.MaterialIndex = 6;
+	mPickedRitem->inst.resize(1);
+	mPickedRitem->inst[0] = std::move(temp);
 }
@@ -31,6 +31,8 @@ struct RenderItem
 	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 
 	std::vector<Instances> inst;
+	// world-space bvh over inst, built on Geo->Bvh
+	Math::InstanceBVH InstanceBvh;
 	bool Visible = true;
 	DirectX::BoundingBox Bound;
 
@@ -46,6 +48,15 @@ struct RenderItem
 	UINT StartIndexLocation = 0;
 	UINT BaseVertexLocation = 0;
 
+	// full detail first, empty for items drawn as they are, like the picked triangle. The visible
+	// instances are grouped by the level they are drawn at, each level one instanced draw over
+	// its run of the instance buffer starting at FirstInstance
+	std::vector<const SubmeshGeometry*> Lods;
+	std::vector<UINT> LodInstanceCounts;
+	UINT FirstInstance = 0;
+
+	// level each instance was drawn at last frame, same order as inst
+	std::vector<UINT> InstanceLods;
 };
 
 class GraphicsContext;
@@ -75,6 +86,7 @@ private:
 
 	void UpdateInstanceIndex(float deltaT);
 	void UpdateCamera(float deltaT);
+	float LodPixelsPerError(DirectX::FXMMATRIX world);
 
 	void Pick();
 
@@ -99,6 +111,9 @@ private:
 	
 	BoundingFrustum mCamFrustum;
 
+	// indices of the instances that survived culling, reused every frame
+	std::vector<UINT> m_VisibleInstances;
+
 	// switch render scene
 	bool m_bFrustumCulling = true;
 
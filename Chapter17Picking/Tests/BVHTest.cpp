@@ -0,0 +1,151 @@
+#include "TestHarness.h"
+#include "ReferencePick.h"
+#include <random>
+
+using namespace Math;
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4X4;
+
+static XMFLOAT4X4 Identity(void)
+{
+    XMFLOAT4X4 M = {};
+    M.m[0][0] = M.m[1][1] = M.m[2][2] = M.m[3][3] = 1.0f;
+    return M;
+}
+
+// Rotation about y, non-uniform scale and translation, row-vector convention
+static XMFLOAT4X4 Placement(float Angle, float Scale, float X, float Y, float Z)
+{
+    XMFLOAT4X4 M = {};
+    M.m[0][0] = std::cos(Angle) * Scale;
+    M.m[0][2] = -std::sin(Angle) * Scale;
+    M.m[1][1] = 1.2f * Scale;
+    M.m[2][0] = std::sin(Angle) * Scale;
+    M.m[2][2] = std::cos(Angle) * Scale;
+    M.m[3][0] = X;
+    M.m[3][1] = Y;
+    M.m[3][2] = Z;
+    M.m[3][3] = 1.0f;
+    return M;
+}
+
+static bool SameHit(const BVHHit& A, const BVHHit& B)
+{
+    if (A.IsValid() != B.IsValid())
+        return false;
+    return !A.IsValid() || std::fabs(A.T - B.T) <= 1e-4f * B.T;
+}
+
+int main(void)
+{
+    std::mt19937 Rng(3);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+    // a soup of small triangles with an interleaved stride, like positions inside a Vertex
+    struct Vertex { XMFLOAT3 Pos; float Pad[5]; };
+    const uint32_t NumTriangles = 2000;
+    std::vector<Vertex> Vertices;
+    std::vector<XMFLOAT3> Positions;
+    std::vector<int32_t> Indices;
+    for (uint32_t i = 0; i < NumTriangles; ++i)
+    {
+        const float Center[3] = { Unit(Rng) * 5.0f, Unit(Rng) * 5.0f, Unit(Rng) * 5.0f };
+        for (int k = 0; k < 3; ++k)
+        {
+            XMFLOAT3 P(Center[0] + Unit(Rng) * 0.3f, Center[1] + Unit(Rng) * 0.3f, Center[2] + Unit(Rng) * 0.3f);
+            Vertices.push_back({ P, {} });
+            Positions.push_back(P);
+            Indices.push_back((int32_t)(3 * i + k));
+        }
+    }
+
+    TriangleBVH Mesh;
+    CHECK(Mesh.IsEmpty());
+    Mesh.Build(Vertices.data(), sizeof(Vertex), (uint32_t)Vertices.size(), Indices.data(), (uint32_t)Indices.size());
+    CHECK(Mesh.GetTriangleCount() == NumTriangles);
+    CHECK(Mesh.GetNodeCount() > 1 && Mesh.GetNodeCount() < 2 * NumTriangles);
+
+    // the root box bounds every vertex
+    const BVHNode& Root = Mesh.GetRoot();
+    for (const XMFLOAT3& P : Positions)
+    {
+        CHECK(P.x >= Root.Min[0] && P.x <= Root.Max[0]);
+        CHECK(P.y >= Root.Min[1] && P.y <= Root.Max[1]);
+        CHECK(P.z >= Root.Min[2] && P.z <= Root.Max[2]);
+    }
+
+    // one instance at the origin: the top level must agree with the bottom level alone
+    const std::vector<XMFLOAT4X4> One(1, Identity());
+    InstanceBVH Single;
+    Single.Build(Mesh, One.data(), 1);
+    for (int q = 0; q < 200; ++q)
+    {
+        BVHRay Ray{ XMFLOAT3(Unit(Rng) * 6.0f, Unit(Rng) * 6.0f, -20.0f), XMFLOAT3(Unit(Rng) * 0.2f, Unit(Rng) * 0.2f, 1.0f) };
+        BVHHit Local, World;
+        Mesh.Intersect(Ray, Local);
+        Single.Intersect(Ray, World);
+        const BVHHit Expected = Reference::Pick(Ray, Positions, Indices, One);
+        CHECK(SameHit(Local, Expected));
+        CHECK(SameHit(World, Expected));
+        CHECK(!Local.IsValid() || Local.Triangle == Expected.Triangle);
+        CHECK(!World.IsValid() || World.Instance == 0);
+    }
+
+    // rotated, scaled instances on a grid
+    std::vector<XMFLOAT4X4> Worlds;
+    for (int i = 0; i < 27; ++i)
+        Worlds.push_back(Placement(0.3f * i, 0.5f + 0.02f * i, (i % 3) * 20.0f - 20.0f, ((i / 3) % 3) * 20.0f - 20.0f, (i / 9) * 20.0f - 20.0f));
+
+    InstanceBVH Grid;
+    Grid.Build(Mesh, Worlds.data(), (uint32_t)Worlds.size());
+    CHECK(!Grid.IsEmpty());
+
+    int Hits = 0;
+    for (int q = 0; q < 300; ++q)
+    {
+        BVHRay Ray{ XMFLOAT3(Unit(Rng) * 30.0f, Unit(Rng) * 30.0f, -100.0f), XMFLOAT3(Unit(Rng) * 0.2f, Unit(Rng) * 0.2f, 1.0f) };
+        if (q % 2)
+        {
+            // unnormalized directions: T stays in units of the direction
+            Ray.Direction.x *= 3.0f;
+            Ray.Direction.y *= 3.0f;
+            Ray.Direction.z *= 3.0f;
+        }
+
+        BVHHit Hit;
+        Grid.Intersect(Ray, Hit);
+        const BVHHit Expected = Reference::Pick(Ray, Positions, Indices, Worlds);
+        CHECK(SameHit(Hit, Expected));
+        CHECK(!Hit.IsValid() || Hit.Instance == Expected.Instance);
+        Hits += Hit.IsValid();
+
+        // a hit limit below the closest hit reports nothing and leaves the limit alone
+        if (Expected.IsValid())
+        {
+            BVHHit Limited;
+            Limited.T = 0.5f * Expected.T;
+            CHECK(!Grid.Intersect(Ray, Limited));
+            CHECK(Limited.T == 0.5f * Expected.T && !Limited.IsValid());
+        }
+    }
+    CHECK(Hits > 0);
+
+    // pointing away from everything
+    BVHRay Away{ XMFLOAT3(0.0f, 0.0f, -100.0f), XMFLOAT3(0.0f, 0.0f, -1.0f) };
+    BVHHit Miss;
+    CHECK(!Grid.Intersect(Away, Miss));
+    CHECK(!Miss.IsValid());
+
+    // a ray starting inside an instance box still finds the hits ahead of it
+    BVHRay Inside{ XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f) };
+    BVHHit InsideHit;
+    Grid.Intersect(Inside, InsideHit);
+    CHECK(SameHit(InsideHit, Reference::Pick(Inside, Positions, Indices, Worlds)));
+
+    Grid.Clear();
+    CHECK(Grid.IsEmpty());
+    BVHHit Cleared;
+    CHECK(!Grid.Intersect(Inside, Cleared));
+
+    return Test::Finish("BVHTest");
+}
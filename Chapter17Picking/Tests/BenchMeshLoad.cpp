@@ -0,0 +1,121 @@
+#include "TestHarness.h"
+#include "MeshFile.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+// Loading a model the two ways GameApp::BuildCarGeometry can, the skull unless another text
+// model follows the scale: converting the text model, which parses it, reorders it for the
+// vertex cache, builds the LODs and writes the .mesh file, as happens when the cache is
+// missing or older than the text; and LoadOrConvert finding the cache up to date and mapping
+// it. Each mapped load also reads every vertex and index once, as creating the GPU buffers
+// from the mapping does, so the pages it faults in are paid for. The cache goes to the
+// temporary directory and is removed afterwards.
+
+namespace
+{
+    // Sums every byte the GPU buffers are created from
+    uint64_t TouchMesh(const MeshFile::Mesh& Mesh)
+    {
+        const MeshFile::Header& H = Mesh.GetHeader();
+        const unsigned char* Begin = (const unsigned char*)Mesh.GetVertices();
+        const unsigned char* End = (const unsigned char*)Mesh.GetIndices() + (size_t)H.IndexCount * H.IndexSize;
+
+        uint64_t Sum = 0;
+        for (const unsigned char* p = Begin; p < End; ++p)
+            Sum += *p;
+        return Sum;
+    }
+
+    // What the game relies on: every index addresses a vertex, the LODs lie in the index
+    // blob with full detail first, and the bounds hold every vertex
+    void CheckMesh(const MeshFile::Mesh& Mesh)
+    {
+        const MeshFile::Header& H = Mesh.GetHeader();
+        CHECK(H.VertexCount > 0 && H.IndexCount > 0 && H.IndexCount % 3 == 0);
+        CHECK(H.LodCount >= 1 && Mesh.GetLod(0).StartIndex == 0 && Mesh.GetLod(0).Error == 0.0f);
+
+        uint32_t MaxIndex = 0;
+        for (uint32_t i = 0; i < H.IndexCount; ++i)
+            MaxIndex = std::max(MaxIndex, Mesh.GetIndex(i));
+        CHECK(MaxIndex < H.VertexCount);
+
+        for (uint32_t i = 1; i < H.LodCount; ++i)
+            CHECK(Mesh.GetLod(i).IndexCount < Mesh.GetLod(i - 1).IndexCount);
+
+        bool InBounds = true;
+        const MeshFile::Vertex* Vertices = Mesh.GetVertices();
+        for (uint32_t i = 0; i < H.VertexCount; ++i)
+        {
+            const float* P = &Vertices[i].Position.x;
+            for (int a = 0; a < 3; ++a)
+                InBounds = InBounds && P[a] >= H.BoundsMin[a] && P[a] <= H.BoundsMax[a];
+        }
+        CHECK(InBounds);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const double Scale = Test::GetScale(argc, argv);
+    const std::filesystem::path TextPath = argc > 2 ? argv[2] : "../Models/skull.txt";
+    const std::filesystem::path CachePath = std::filesystem::temp_directory_path() / "BenchMeshLoad.mesh";
+    const std::wstring TextFile = TextPath.wstring();
+    const std::wstring CacheFile = CachePath.wstring();
+
+    if (!std::filesystem::exists(TextPath))
+    {
+        fprintf(stderr, "%s not found\n", TextPath.string().c_str());
+        return 1;
+    }
+
+    const int NumConverts = std::max(1, (int)(10 * Scale));
+    const int NumLoads = std::max(20, (int)(1000 * Scale));
+
+    Test::Timer ConvertTimer;
+    for (int i = 0; i < NumConverts; ++i)
+        CHECK(MeshFile::ConvertTextModel(TextFile, CacheFile));
+    const double ConvertMs = ConvertTimer.Seconds() * 1e3 / NumConverts;
+
+    // the cache is newer than the text now, so LoadOrConvert only maps it
+    const auto CacheTime = std::filesystem::last_write_time(CachePath);
+    MeshFile::Mesh Mesh;
+    uint64_t FirstSum = 0;
+    Test::Timer LoadTimer;
+    for (int i = 0; i < NumLoads; ++i)
+    {
+        CHECK(Mesh.LoadOrConvert(CacheFile, TextFile));
+        const uint64_t Sum = TouchMesh(Mesh);
+        if (i == 0)
+            FirstSum = Sum;
+        CHECK(Sum == FirstSum);
+        Mesh.Unload();
+    }
+    const double LoadMs = LoadTimer.Seconds() * 1e3 / NumLoads;
+    CHECK(std::filesystem::last_write_time(CachePath) == CacheTime);
+
+    CHECK(Mesh.LoadOrConvert(CacheFile, TextFile));
+    CheckMesh(Mesh);
+    const MeshFile::Header H = Mesh.GetHeader();
+    Mesh.Unload();
+
+    // a cache older than the text is converted again before it is loaded
+    std::filesystem::last_write_time(CachePath, std::filesystem::last_write_time(TextPath) - std::chrono::hours(1));
+    Test::Timer StaleTimer;
+    CHECK(Mesh.LoadOrConvert(CacheFile, TextFile));
+    const double StaleMs = StaleTimer.Seconds() * 1e3;
+    CHECK(std::filesystem::last_write_time(CachePath) >= std::filesystem::last_write_time(TextPath));
+    CHECK(Mesh.IsLoaded() && TouchMesh(Mesh) == FirstSum);
+    Mesh.Unload();
+
+    std::error_code Error;
+    std::filesystem::remove(CachePath, Error);
+
+    printf("%s: %u vertices, %u indices in %u levels, %llu byte cache\n", TextPath.string().c_str(), H.VertexCount,
+        H.IndexCount, H.LodCount, (unsigned long long)H.FileSize);
+    printf("  ConvertTextModel:        %9.3f ms over %d runs\n", ConvertMs, NumConverts);
+    printf("  LoadOrConvert, stale:    %9.3f ms\n", StaleMs);
+    printf("  LoadOrConvert, cached:   %9.3f ms over %d runs  %7.1fx\n", LoadMs, NumLoads, ConvertMs / LoadMs);
+
+    return Test::Finish("BenchMeshLoad");
+}
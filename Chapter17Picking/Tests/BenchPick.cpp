@@ -0,0 +1,125 @@
+#include "TestHarness.h"
+#include "ReferencePick.h"
+#include <fstream>
+#include <random>
+#include <string>
+
+using namespace Math;
+using DirectX::XMFLOAT3;
+using DirectX::XMFLOAT4X4;
+
+// Picking in the 5x5x5 instance grid of GameApp with the skull as the mesh: rays from a camera
+// outside the grid through random pixels, the two-level BVH against testing every triangle of
+// every instance. The brute force pass only runs on a subset of the rays, it is slow.
+
+// Models/*.txt: "VertexCount: n", "TriangleCount: n", then the position and normal of each
+// vertex and three indices per triangle, each list between braces
+static bool LoadModel(const char* Path, std::vector<XMFLOAT3>& Positions, std::vector<int32_t>& Indices)
+{
+    std::ifstream File(Path);
+    if (!File)
+        return false;
+
+    std::string Ignore;
+    uint32_t NumVertices = 0, NumTriangles = 0;
+    File >> Ignore >> NumVertices >> Ignore >> NumTriangles;
+    File >> Ignore >> Ignore >> Ignore >> Ignore;
+
+    Positions.resize(NumVertices);
+    for (XMFLOAT3& P : Positions)
+    {
+        float Normal[3];
+        File >> P.x >> P.y >> P.z >> Normal[0] >> Normal[1] >> Normal[2];
+    }
+
+    File >> Ignore >> Ignore >> Ignore;
+    Indices.resize(3 * NumTriangles);
+    for (int32_t& Index : Indices)
+        File >> Index;
+
+    return (bool)File;
+}
+
+int main(int argc, char** argv)
+{
+    const double Scale = Test::GetScale(argc, argv);
+    const char* Path = argc > 2 ? argv[2] : "../Models/skull.txt";
+
+    std::vector<XMFLOAT3> Positions;
+    std::vector<int32_t> Indices;
+    if (!LoadModel(Path, Positions, Indices))
+    {
+        fprintf(stderr, "%s not found\n", Path);
+        return 1;
+    }
+
+    // the grid of GameApp::BuildRenderItems: 5x5x5, 200 units on a side
+    const int n = 5;
+    const float Size = 200.0f;
+    std::vector<XMFLOAT4X4> Worlds;
+    for (int k = 0; k < n; ++k)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                XMFLOAT4X4 M = {};
+                M.m[0][0] = M.m[1][1] = M.m[2][2] = M.m[3][3] = 1.0f;
+                M.m[3][0] = -0.5f * Size + j * Size / (n - 1);
+                M.m[3][1] = -0.5f * Size + i * Size / (n - 1);
+                M.m[3][2] = -0.5f * Size + k * Size / (n - 1);
+                Worlds.push_back(M);
+            }
+        }
+    }
+
+    Test::Timer BuildTimer;
+    TriangleBVH Mesh;
+    Mesh.Build(Positions.data(), sizeof(XMFLOAT3), (uint32_t)Positions.size(), Indices.data(), (uint32_t)Indices.size());
+    InstanceBVH Grid;
+    Grid.Build(Mesh, Worlds.data(), (uint32_t)Worlds.size());
+    const double BuildMs = BuildTimer.Seconds() * 1e3;
+
+    // the camera a little outside the grid, each ray aimed near a random instance so most
+    // of them hit, the way the user clicks on a skull
+    std::mt19937 Rng(9);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    const int NumRays = std::max(10, (int)(100000 * Scale));
+    const XMFLOAT3 Eye(10.0f, 20.0f, -180.0f);
+    std::vector<BVHRay> Rays(NumRays);
+    for (BVHRay& Ray : Rays)
+    {
+        const float (&Target)[4] = Worlds[Rng() % Worlds.size()].m[3];
+        Ray.Origin = Eye;
+        Ray.Direction = XMFLOAT3(Target[0] + 4.0f * Unit(Rng) - Eye.x, Target[1] + 4.0f * Unit(Rng) - Eye.y,
+            Target[2] + 4.0f * Unit(Rng) - Eye.z);
+    }
+
+    Test::Timer BvhTimer;
+    std::vector<BVHHit> Hits(NumRays);
+    int NumHits = 0;
+    for (int i = 0; i < NumRays; ++i)
+    {
+        Grid.Intersect(Rays[i], Hits[i]);
+        NumHits += Hits[i].IsValid();
+    }
+    const double BvhUs = BvhTimer.Seconds() * 1e6 / NumRays;
+
+    const int NumChecked = std::max(2, std::min(NumRays, (int)(40 * Scale)));
+    Test::Timer BruteTimer;
+    for (int i = 0; i < NumChecked; ++i)
+    {
+        const BVHHit Expected = Reference::Pick(Rays[i], Positions, Indices, Worlds);
+        CHECK(Hits[i].IsValid() == Expected.IsValid());
+        CHECK(!Expected.IsValid() || std::fabs(Hits[i].T - Expected.T) <= 1e-4f * Expected.T);
+        CHECK(!Expected.IsValid() || Hits[i].Instance == Expected.Instance);
+    }
+    const double BruteUs = BruteTimer.Seconds() * 1e6 / NumChecked;
+
+    printf("%zu triangles x %zu instances, build %.1f ms, %u + %u nodes\n", Indices.size() / 3, Worlds.size(),
+        BuildMs, Mesh.GetNodeCount(), Grid.GetNodeCount());
+    printf("  bvh:         %8.2f us/pick over %d rays, %d hits\n", BvhUs, NumRays, NumHits);
+    printf("  brute force: %8.0f us/pick over %d rays\n", BruteUs, NumChecked);
+
+    return Test::Finish("BenchPick");
+}
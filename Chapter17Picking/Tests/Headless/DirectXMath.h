@@ -0,0 +1,27 @@
+#pragma once
+
+// The storage types of DirectXMath that BVH.h and MeshFile.h use; the headless build has no
+// Windows SDK.
+namespace DirectX
+{
+    struct XMFLOAT2
+    {
+        float x, y;
+
+        XMFLOAT2() = default;
+        XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+    };
+
+    struct XMFLOAT3
+    {
+        float x, y, z;
+
+        XMFLOAT3() = default;
+        XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+    };
+
+    struct XMFLOAT4X4
+    {
+        float m[4][4];
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "BVH.h"
+#include <cmath>
+
+// Brute force counterpart of the BVH queries: every triangle of every instance moved to world
+// space and tested with Moller-Trumbore, closest hit kept. Hit.T is in units of the ray
+// direction like the BVH reports it.
+namespace Reference
+{
+    inline bool IntersectTriangle(const float O[3], const float D[3], const float A[3], const float B[3],
+        const float C[3], float& T)
+    {
+        const float E1[3] = { B[0] - A[0], B[1] - A[1], B[2] - A[2] };
+        const float E2[3] = { C[0] - A[0], C[1] - A[1], C[2] - A[2] };
+        const float P[3] = { D[1] * E2[2] - D[2] * E2[1], D[2] * E2[0] - D[0] * E2[2], D[0] * E2[1] - D[1] * E2[0] };
+        const float Det = E1[0] * P[0] + E1[1] * P[1] + E1[2] * P[2];
+        if (std::fabs(Det) < 1e-20f)
+            return false;
+
+        const float S[3] = { O[0] - A[0], O[1] - A[1], O[2] - A[2] };
+        const float U = (S[0] * P[0] + S[1] * P[1] + S[2] * P[2]) / Det;
+        if (U < 0.0f || U > 1.0f)
+            return false;
+
+        const float Q[3] = { S[1] * E1[2] - S[2] * E1[1], S[2] * E1[0] - S[0] * E1[2], S[0] * E1[1] - S[1] * E1[0] };
+        const float V = (D[0] * Q[0] + D[1] * Q[1] + D[2] * Q[2]) / Det;
+        if (V < 0.0f || U + V > 1.0f)
+            return false;
+
+        T = (E2[0] * Q[0] + E2[1] * Q[1] + E2[2] * Q[2]) / Det;
+        return T > 0.0f;
+    }
+
+    inline Math::BVHHit Pick(const Math::BVHRay& Ray, const std::vector<DirectX::XMFLOAT3>& Positions,
+        const std::vector<int32_t>& Indices, const std::vector<DirectX::XMFLOAT4X4>& Worlds)
+    {
+        const float O[3] = { Ray.Origin.x, Ray.Origin.y, Ray.Origin.z };
+        const float D[3] = { Ray.Direction.x, Ray.Direction.y, Ray.Direction.z };
+
+        Math::BVHHit Hit;
+        for (uint32_t Instance = 0; Instance < (uint32_t)Worlds.size(); ++Instance)
+        {
+            const float (&M)[4][4] = Worlds[Instance].m;
+            for (uint32_t Triangle = 0; Triangle < (uint32_t)Indices.size() / 3; ++Triangle)
+            {
+                float P[3][3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    const DirectX::XMFLOAT3& V = Positions[Indices[3 * Triangle + k]];
+                    for (int c = 0; c < 3; ++c)
+                        P[k][c] = V.x * M[0][c] + V.y * M[1][c] + V.z * M[2][c] + M[3][c];
+                }
+
+                float T;
+                if (IntersectTriangle(O, D, P[0], P[1], P[2], T) && T < Hit.T)
+                {
+                    Hit.T = T;
+                    Hit.Instance = Instance;
+                    Hit.Triangle = Triangle;
+                }
+            }
+        }
+        return Hit;
+    }
+}
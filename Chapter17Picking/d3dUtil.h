@@ -2,6 +2,7 @@
 #include <DirectXMath.h>
 #include <string>
 #include "GpuBuffer.h"
+#include "Math/BVH.h"
 
 #include <DirectXCollision.h>
 
@@ -33,7 +34,9 @@ struct SubmeshGeometry
 	UINT IndexCount = 0;
 	UINT StartIndexLocation = 0;
 	INT BaseVertexLocation = 0;
-	
+
+	// object space distance from the full detail submesh, for the coarser levels of a LOD chain
+	float LodError = 0.0f;
 };
 
 struct MeshGeometry
@@ -47,6 +50,9 @@ struct MeshGeometry
 	std::vector<Vertex> vertices;
 	std::vector<std::int32_t> indices;
 
+	// cpu bvh over the triangles above, for picking
+	Math::TriangleBVH Bvh;
+
 	std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
 
 };
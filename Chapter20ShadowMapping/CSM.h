@@ -1,26 +1,40 @@
 #pragma once
 #include "DepthBuffer.h"
+#include "Camera.h"
+#include "ShadowCascades.h"
 #include <DirectXCollision.h>
 
+// 级联阴影
+// Every cascade is an orthographic projection fit to a sphere around its slice of the view
+// frustum and snapped to whole texels, so its size does not change as the camera turns and
+// its texels do not crawl as the camera moves. Past the first kAlwaysUpdated cascades a map is
+// kept until its slice leaves it or a moving caster dirties it, see Utility::CascadeScheduler.
 class CSM
 {
 public:
+	static const UINT kMaxCascades = 5;
+
 	CSM(UINT width, UINT height, DXGI_FORMAT format, UINT nums);
 	CSM(const CSM& rhs) = delete;
 	CSM& operator=(const CSM& rhs) = delete;
 	~CSM();
 
-	std::vector<DirectX::XMVECTOR> CSM::setFrustumCornersWorldSpace(DirectX::XMMATRIX proj, DirectX::XMMATRIX view);
-
-	DirectX::XMMATRIX setLightSpaceMatrix(
-		float NearZ,
-		float FarZ);
+	// Fits the cascades to the camera and decides which maps to redraw this frame. movedCasters
+	// are world space bounds of the casters that moved since the last call, where they were
+	// and where they are now.
+	void Update(DirectX::XMFLOAT3 lightDir, const Math::Camera& camera,
+		const DirectX::BoundingSphere* movedCasters, size_t movedCount);
 
-	DirectX::XMMATRIX SetPerspectiveMatrix(float verticalFovRadians, float aspectHeightOverWidth, float nearZClip, float farZClip);
+	// split tuning: 0 uniform, 1 logarithmic; nothing past shadowDistance casts shadows
+	void SetSplitLambda(float lambda) { m_SplitLambda = lambda; }
+	float GetSplitLambda() const { return m_SplitLambda; }
+	void SetShadowDistance(float distance) { m_ShadowDistance = distance; }
+	float GetShadowDistance() const { return m_ShadowDistance; }
 
-	void divideFrustums(float NearZ, float FarZ);
+	bool NeedsRedraw(int i) const { return m_Redraw[i]; }
 
-	void setToLightDir(DirectX::XMFLOAT3 _lightDir, float fov, float aspect, DirectX::XMMATRIX cameraView);
+	// far view distance of cascade i
+	float GetSplit(int i) const { return m_Splits[i]; }
 
 	DepthBuffer& GetShadowBuffer(int i) { return m_ShadowMaps[i]; }
 
@@ -35,15 +49,21 @@ public:
 	D3D12_VIEWPORT Viewport() const { return m_Viewport; }
 	D3D12_RECT ScissorRect() const { return m_ScissorRect; }
 
-	DirectX::XMMATRIX GetLightView(int i ) const { return m_LightView[i]; }
+	// the projection a cascade was drawn with, to draw and to sample it
+	DirectX::XMMATRIX GetLightView(int i) const { return m_LightView; }
 	DirectX::XMMATRIX GetLightProj(int i) const { return m_LightProjection[i]; }
 	DirectX::XMMATRIX GetShadowTransform(int i) const { return m_ShadowTransform[i]; }
 
 	UINT GetLevels() const { return m_Levels; }
 
+	Utility::CascadeScheduler::Stats TakeStats() { return m_Scheduler.TakeStats(); }
 
 private:
 
+	// cascades redrawn every frame, and how many of the others may catch up with moving casters per frame
+	static const UINT kAlwaysUpdated = 1;
+	static const UINT kMaxCachedUpdates = 1;
+
 	// depth texture array
 	std::vector<DepthBuffer> m_ShadowMaps;
 	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_DSV;
@@ -57,12 +77,20 @@ private:
 	D3D12_VIEWPORT m_Viewport;
 	D3D12_RECT m_ScissorRect;
 
-	DirectX::XMVECTOR m_LightDir;
-	float m_FOV;
-	float m_AspectRatio;
-	DirectX::XMMATRIX m_CameraView;
-	std::vector<DirectX::XMMATRIX> m_LightView;
-	std::vector<DirectX::XMMATRIX> m_LightProjection;
-	std::vector<DirectX::XMMATRIX> m_ShadowTransform;
+	float m_SplitLambda = 0.75f;
+	float m_ShadowDistance = 100.0f;
+	// how far toward the light casters of a cascade may be, tune this to the scene
+	float m_CasterDistance = 50.0f;
+	// cached cascades are fit this much larger so the camera can move a little before they have to
+	float m_CachedPadding = 0.15f;
+
+	Utility::CascadeScheduler m_Scheduler;
+	DirectX::XMFLOAT3 m_LightDir = { 0.0f, 0.0f, 0.0f };
+	float m_Splits[kMaxCascades] = {};
+	bool m_Redraw[kMaxCascades] = {};
+
+	// rotation only, the texel grid of every cascade is fixed in the world
+	DirectX::XMMATRIX m_LightView;
+	DirectX::XMMATRIX m_LightProjection[kMaxCascades];
+	DirectX::XMMATRIX m_ShadowTransform[kMaxCascades];
 };
-
@@ -0,0 +1,169 @@
+#include "ShadowCascades.h"
+#include <cmath>
+
+void Utility::ComputeCascadeSplits(float NearZ, float FarZ, uint32_t Count, float Lambda, float* Splits)
+{
+    for (uint32_t i = 1; i <= Count; ++i)
+    {
+        float Fraction = (float)i / (float)Count;
+        float Logarithmic = NearZ * std::pow(FarZ / NearZ, Fraction);
+        float Uniform = NearZ + (FarZ - NearZ) * Fraction;
+        Splits[i - 1] = Lambda * Logarithmic + (1.0f - Lambda) * Uniform;
+    }
+    Splits[Count - 1] = FarZ;
+}
+
+void Utility::FitCascadeSphere(float NearZ, float FarZ, float TanX, float TanY, float& Center, float& Radius)
+{
+    // corners are k * z off the axis at distance z; the center equally far from the near and
+    // far corners is at (n + f) (1 + k^2) / 2, past the far plane the far cap alone decides
+    float K2 = TanX * TanX + TanY * TanY;
+    Center = 0.5f * (NearZ + FarZ) * (1.0f + K2);
+    if (Center >= FarZ)
+    {
+        Center = FarZ;
+        Radius = FarZ * std::sqrt(K2);
+    }
+    else
+    {
+        float Along = NearZ - Center;
+        Radius = std::sqrt(NearZ * NearZ * K2 + Along * Along);
+    }
+}
+
+Utility::CascadeProjection Utility::SnapCascade(const float Center[3], float Radius, uint32_t Resolution, float CasterDistance)
+{
+    CascadeProjection Projection;
+    Projection.TexelSize = 2.0f * Radius / (float)Resolution;
+    Projection.Radius = Radius;
+    Projection.CasterDistance = CasterDistance;
+    for (int i = 0; i < 3; ++i)
+        Projection.Texel[i] = (int32_t)std::floor(Center[i] / Projection.TexelSize + 0.5f);
+    return Projection;
+}
+
+bool Utility::SameCascadeProjection(const CascadeProjection& A, const CascadeProjection& B)
+{
+    return A.Texel[0] == B.Texel[0] && A.Texel[1] == B.Texel[1] && A.Texel[2] == B.Texel[2] &&
+        A.TexelSize == B.TexelSize && A.Radius == B.Radius && A.CasterDistance == B.CasterDistance;
+}
+
+void Utility::GetCascadeBounds(const CascadeProjection& Projection, float Min[3], float Max[3])
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        float Center = (float)Projection.Texel[i] * Projection.TexelSize;
+        Min[i] = Center - Projection.Radius;
+        Max[i] = Center + Projection.Radius;
+    }
+    Min[2] -= Projection.CasterDistance;
+}
+
+bool Utility::CascadeContains(const CascadeProjection& Projection, const float Center[3], float Radius)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        float Offset = std::fabs(Center[i] - (float)Projection.Texel[i] * Projection.TexelSize);
+        if (Offset + Radius > Projection.Radius)
+            return false;
+    }
+    return true;
+}
+
+bool Utility::CascadeOverlaps(const CascadeProjection& Projection, const float Center[3], float Radius)
+{
+    float Min[3], Max[3];
+    GetCascadeBounds(Projection, Min, Max);
+
+    float Distance2 = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        float Outside = Center[i] < Min[i] ? Min[i] - Center[i] : (Center[i] > Max[i] ? Center[i] - Max[i] : 0.0f);
+        Distance2 += Outside * Outside;
+    }
+    return Distance2 <= Radius * Radius;
+}
+
+Utility::CascadeScheduler::CascadeScheduler(uint32_t Count, uint32_t AlwaysUpdated, uint32_t MaxCachedUpdates)
+    : m_Cascades(Count), m_AlwaysUpdated(AlwaysUpdated), m_MaxCachedUpdates(MaxCachedUpdates)
+{
+    Invalidate();
+}
+
+void Utility::CascadeScheduler::Invalidate()
+{
+    for (Cascade& C : m_Cascades)
+    {
+        C.Projection = {};
+        C.Valid = false;
+        C.Pending = false;
+        C.PendingSince = 0;
+    }
+}
+
+void Utility::CascadeScheduler::Update(const CascadeProjection* Fitted, const float (*Slices)[4], const bool* Dirty, bool* Redraw)
+{
+    ++m_Frame;
+    ++m_Stats.Frames;
+
+    // cascades that have to move are drawn whatever the budget says, they take from it though
+    uint32_t Moved = 0;
+    for (uint32_t i = 0; i < m_Cascades.size(); ++i)
+    {
+        Cascade& C = m_Cascades[i];
+        Redraw[i] = false;
+
+        bool Cached = i >= m_AlwaysUpdated;
+        if (!Cached || !C.Valid || !CascadeContains(C.Projection, Slices[i], Slices[i][3]))
+        {
+            if (Cached && C.Valid)
+                ++Moved;
+            C.Projection = Fitted[i];
+            C.Valid = true;
+            C.Pending = false;
+            Redraw[i] = true;
+        }
+        else if (Dirty[i] && !C.Pending)
+        {
+            C.Pending = true;
+            C.PendingSince = m_Frame;
+        }
+    }
+    m_Stats.Moved += Moved;
+
+    uint32_t Budget = m_MaxCachedUpdates > Moved ? m_MaxCachedUpdates - Moved : 0;
+    for (; Budget > 0; --Budget)
+    {
+        // the one waiting longest, the nearer of two that wait as long
+        Cascade* Oldest = nullptr;
+        uint32_t OldestIndex = 0;
+        for (uint32_t i = m_AlwaysUpdated; i < m_Cascades.size(); ++i)
+        {
+            Cascade& C = m_Cascades[i];
+            if (C.Pending && (Oldest == nullptr || C.PendingSince < Oldest->PendingSince))
+            {
+                Oldest = &C;
+                OldestIndex = i;
+            }
+        }
+        if (Oldest == nullptr)
+            break;
+
+        Oldest->Pending = false;
+        Redraw[OldestIndex] = true;
+        ++m_Stats.Refreshed;
+    }
+
+    for (uint32_t i = 0; i < m_Cascades.size(); ++i)
+    {
+        m_Stats.Redrawn += Redraw[i] ? 1 : 0;
+        m_Stats.Waiting += m_Cascades[i].Pending ? 1 : 0;
+    }
+}
+
+Utility::CascadeScheduler::Stats Utility::CascadeScheduler::TakeStats()
+{
+    Stats Result = m_Stats;
+    m_Stats = {};
+    return Result;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Utility
+{
+    // Far distances of Count cascades splitting [NearZ, FarZ], Splits[Count - 1] == FarZ. Lambda
+    // blends the logarithmic split (1, the same texel density all along the view) with the
+    // uniform one (0), which keeps the first cascade from getting too short.
+    void ComputeCascadeSplits(float NearZ, float FarZ, uint32_t Count, float Lambda, float* Splits);
+
+    // Smallest sphere around the slice [NearZ, FarZ] of a symmetric view frustum, TanX and TanY
+    // the tangents of its half angles. Center is the distance of the sphere's center along the
+    // view direction. Neither depends on where the camera looks, so the projection fit to the
+    // sphere keeps its size while the camera turns.
+    void FitCascadeSphere(float NearZ, float FarZ, float TanX, float TanY, float& Center, float& Radius);
+
+    // An orthographic projection of a square map along the light, in the light's view space
+    // (x and y across the map, z away from the light). Its center sits on the texel grid.
+    struct CascadeProjection
+    {
+        int32_t Texel[3];           // center in texels, equal for equal projections
+        float TexelSize;
+        float Radius;               // half the side of the square, and half the depth range
+        float CasterDistance;       // the depth range reaches this much further toward the light
+    };
+
+    // Projection of Resolution texels across for a light space sphere. The center snaps to whole
+    // texels so the texels stay on the same world positions while the sphere moves, which is
+    // what keeps the shadow edges from crawling.
+    CascadeProjection SnapCascade(const float Center[3], float Radius, uint32_t Resolution, float CasterDistance);
+
+    bool SameCascadeProjection(const CascadeProjection& A, const CascadeProjection& B);
+
+    // Light space box the projection covers, casters included
+    void GetCascadeBounds(const CascadeProjection& Projection, float Min[3], float Max[3]);
+
+    // Whether a light space sphere of receivers is inside the square and the depth range
+    // without the caster distance
+    bool CascadeContains(const CascadeProjection& Projection, const float Center[3], float Radius);
+
+    // Whether a light space sphere touches anything the projection draws
+    bool CascadeOverlaps(const CascadeProjection& Projection, const float Center[3], float Radius);
+
+    // Decides which cascades of a cached cascaded shadow map to redraw in a frame.
+    //
+    // The first AlwaysUpdated cascades are fit and redrawn every frame. The others keep the
+    // projection they were drawn with while it still holds their slice, so Fitted is padded for
+    // them, and are only redrawn when it does not or when a moving caster dirtied them. Dirty
+    // cascades wait in line, at most MaxCachedUpdates of them a frame minus the ones that had
+    // to move, oldest first; until then they are sampled as they were drawn.
+    class CascadeScheduler
+    {
+    public:
+        struct Stats
+        {
+            uint32_t Frames;
+            uint32_t Redrawn;       // all cascades drawn
+            uint32_t Moved;         // cached cascades redrawn because their slice left them
+            uint32_t Refreshed;     // cached cascades redrawn for moving casters
+            uint32_t Waiting;       // frames dirty cascades spent waiting, summed
+        };
+
+        CascadeScheduler(uint32_t Count, uint32_t AlwaysUpdated, uint32_t MaxCachedUpdates);
+
+        // Every cascade is redrawn on the next Update, after the light turns for example
+        void Invalidate();
+
+        // Fitted is the projection each cascade would get this frame, Slices the light space
+        // sphere (x, y, z, radius) it has to cover and Dirty whether a moving caster touches
+        // GetProjection of it. Redraw says which cascades to draw with GetProjection now.
+        void Update(const CascadeProjection* Fitted, const float (*Slices)[4], const bool* Dirty, bool* Redraw);
+
+        // What the cascade holds, or will once it is redrawn
+        const CascadeProjection& GetProjection(uint32_t i) const { return m_Cascades[i].Projection; }
+        bool IsValid(uint32_t i) const { return m_Cascades[i].Valid; }
+
+        uint32_t GetCount() const { return (uint32_t)m_Cascades.size(); }
+        uint32_t GetAlwaysUpdated() const { return m_AlwaysUpdated; }
+
+        // Since the last call
+        Stats TakeStats();
+
+    private:
+        struct Cascade
+        {
+            CascadeProjection Projection;
+            bool Valid;
+            bool Pending;
+            uint64_t PendingSince;
+        };
+
+        std::vector<Cascade> m_Cascades;
+        uint32_t m_AlwaysUpdated;
+        uint32_t m_MaxCachedUpdates;
+        uint64_t m_Frame = 0;
+        Stats m_Stats = {};
+    };
+}
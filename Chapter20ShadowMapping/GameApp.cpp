@@ -59,6 +59,22 @@ void GameApp::Startup(void)
 	BuildShapeRenderItems();
 	BuildSkyboxRenderItems();
 
+	// items keep the bounds of the submesh they draw
+	for (auto& item : m_AllRenders)
+	{
+		for (auto& iter : item->Geo->DrawArgs)
+		{
+			const SubmeshGeometry& submesh = iter.second;
+			if (submesh.IndexCount == item->IndexCount && submesh.StartIndexLocation == item->StartIndexLocation &&
+				submesh.BaseVertexLocation == item->BaseVertexLocation)
+			{
+				item->Bounds = submesh.Bounds;
+				break;
+			}
+		}
+		XMStoreFloat4x4(&item->ShadowWorld, item->World);
+	}
+
 	// build cubemap camera
 	BuildCubeFaceCamera(0.0, 2.0, 0.0);
 
@@ -101,11 +117,6 @@ void GameApp::Update(float deltaT)
 	// update shadow info
 	UpdateShadowTranform(deltaT);
 
-	// update CSM info
-	m_CSM->setToLightDir(passConstant.Lights[0].Direction, camera.GetFOV(), camera.GetAspectRatio(), camera.GetViewMatrix());
-	m_CSM->divideFrustums(camera.GetNearClip(), camera.GetFarClip());
-
-
 	totalTime += deltaT * 0.1;
 	// animate the skull around the center sphere
 	XMMATRIX skullScale = XMMatrixScaling(0.2f, 0.2f, 0.2f);
@@ -117,10 +128,29 @@ void GameApp::Update(float deltaT)
 
 	m_SkullRitem->World = skullScale * skullLocalRotate * skullOffset * skullGlobalRotate;
 
+	// update CSM info, after everything that moves casters
+	UpdateCascades();
+
 	// switch the scene
 	if (GameInput::IsFirstPressed(GameInput::kKey_f1))
 		m_bRenderShapes = !m_bRenderShapes;
 
+	// tune the cascade splits between uniform and logarithmic
+	if (GameInput::IsFirstPressed(GameInput::kKey_f2) || GameInput::IsFirstPressed(GameInput::kKey_f3))
+	{
+		float lambda = m_CSM->GetSplitLambda() + (GameInput::IsFirstPressed(GameInput::kKey_f2) ? -0.05f : 0.05f);
+		m_CSM->SetSplitLambda(lambda < 0.0f ? 0.0f : (lambda > 1.0f ? 1.0f : lambda));
+		Utility::Printf("CSM split lambda %.2f\n", m_CSM->GetSplitLambda());
+	}
+
+	// how often the cached cascades were redrawn
+	if (GameInput::IsFirstPressed(GameInput::kKey_f4))
+	{
+		Utility::CascadeScheduler::Stats stats = m_CSM->TakeStats();
+		Utility::Printf("CSM %u frames: %u cascades drawn, %u moved, %u refreshed for moving casters, %u waited\n",
+			stats.Frames, stats.Redrawn, stats.Moved, stats.Refreshed, stats.Waiting);
+	}
+
 	
 
 }
@@ -169,6 +199,11 @@ void GameApp::RenderScene(void)
 	{
 		XMStoreFloat4x4(&passConstant.CSShadowTransform[i], XMMatrixTranspose(m_CSM->GetShadowTransform(i)));
 	}
+	// cascades past the last split leave the rest of the view unshadowed
+	float splits[4] = {};
+	for (int i = 0; i < m_CSM->GetLevels() && i < 4; ++i)
+		splits[i] = m_CSM->GetSplit(i);
+	passConstant.CascadeSplits = XMFLOAT4(splits);
 
 	XMStoreFloat3(&passConstant.eyePosW, camera.GetPosition());
 	gfxContext.SetDynamicConstantBufferView(1, sizeof(passConstant), &passConstant);
@@ -451,6 +486,10 @@ void GameApp::DrawSceneToCSM(GraphicsContext& gfxContext)
 
 	for (int i = 0; i < m_CSM->GetLevels(); ++i)
 	{
+		// cached cascades still hold what they were drawn with
+		if (!m_CSM->NeedsRedraw(i))
+			continue;
+
 		// transition buffer to depth write
 		gfxContext.TransitionResource(m_CSM->GetShadowBuffer(i), D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
 
@@ -972,6 +1011,13 @@ void GameApp::BuildShapeGeometry()
 	geo->m_VertexBuffer.Create(L"vertex buff", (UINT)vertices.size(), sizeof(Vertex), vertices.data());
 	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), sizeof(std::uint16_t), indices.data());
 
+	// object space bounds, the shadow cascades track moving casters with them
+	BoundingSphere::CreateFromPoints(boxSubmesh.Bounds, box.Vertices.size(), &vertices[boxVertexOffset].position, sizeof(Vertex));
+	BoundingSphere::CreateFromPoints(gridSubmesh.Bounds, grid.Vertices.size(), &vertices[gridVertexOffset].position, sizeof(Vertex));
+	BoundingSphere::CreateFromPoints(sphereSubmesh.Bounds, sphere.Vertices.size(), &vertices[sphereVertexOffset].position, sizeof(Vertex));
+	BoundingSphere::CreateFromPoints(cylinderSubmesh.Bounds, cylinder.Vertices.size(), &vertices[cylinderVertexOffset].position, sizeof(Vertex));
+	BoundingSphere::CreateFromPoints(quadSubmesh.Bounds, quad.Vertices.size(), &vertices[quadVertexOffset].position, sizeof(Vertex));
+
 	geo->DrawArgs["box"] = std::move(boxSubmesh);
 	geo->DrawArgs["grid"] = std::move(gridSubmesh);
 	geo->DrawArgs["sphere"] = std::move(sphereSubmesh);
@@ -1081,6 +1127,7 @@ void GameApp::BuildSkullGeometry()
 	submesh.IndexCount = (UINT)indices.size();
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
+	BoundingSphere::CreateFromPoints(submesh.Bounds, vertices.size(), &vertices[0].position, sizeof(Vertex));
 
 	geo->DrawArgs["skull"] = std::move(submesh);
 
@@ -1431,6 +1478,36 @@ void GameApp::UpdateShadowTranform(float deltaT)
 	m_shadowMap->SetToLightSpaceView(passConstant.Lights[0].Direction, mSceneBounds);
 }
 
+void GameApp::UpdateCascades()
+{
+	// casters that moved since the last frame dirty the cached cascades where they were and where they are
+	m_MovedCasters.clear();
+	for (RenderItem* item : m_ShapeRenders[(int)RenderLayer::Shadow])
+	{
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, item->World);
+		if (memcmp(&world, &item->ShadowWorld, sizeof(world)) == 0)
+			continue;
+
+		if (item->Bounds.Radius < 0.0f)
+		{
+			// no bounds, it could be anywhere
+			m_MovedCasters.push_back(BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), FLT_MAX));
+		}
+		else
+		{
+			BoundingSphere before, after;
+			item->Bounds.Transform(before, XMLoadFloat4x4(&item->ShadowWorld));
+			item->Bounds.Transform(after, item->World);
+			m_MovedCasters.push_back(before);
+			m_MovedCasters.push_back(after);
+		}
+		item->ShadowWorld = world;
+	}
+
+	m_CSM->Update(passConstant.Lights[0].Direction, camera, m_MovedCasters.data(), m_MovedCasters.size());
+}
+
 void GameApp::AnimateMaterials(float deltaT)
 {
 	XMFLOAT4X4 matTrans;
@@ -48,6 +48,9 @@ struct RenderItem
 	UINT StartIndexLocation = 0;
 	UINT BaseVertexLocation = 0;
 
+	// bounds of the submesh drawn, and World when the shadow cascades last looked at it
+	DirectX::BoundingSphere Bounds = DirectX::BoundingSphere({ 0.0f, 0.0f, 0.0f }, -1.0f);
+	DirectX::XMFLOAT4X4 ShadowWorld;
 };
 
 class GraphicsContext;
@@ -98,6 +101,7 @@ private:
 	void UpdateCamera(float deltaT);
 	void UpdateWaves(float deltaT);
 	void UpdateShadowTranform(float deltaT);
+	void UpdateCascades();
 	void AnimateMaterials(float deltaT);
 
 	RootSignature m_RootSignature;
@@ -150,6 +154,8 @@ private:
 	std::unique_ptr<ShadowMap> m_shadowMap;
 	std::unique_ptr<Blur> m_BlurMap;
 	std::unique_ptr<CSM> m_CSM;
+	// casters that moved this frame, where they were and where they are
+	std::vector<DirectX::BoundingSphere> m_MovedCasters;
 
 	// camera
 	Math::Camera camera;
@@ -0,0 +1,207 @@
+#include "TestHarness.h"
+#include "ShadowCascades.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Splits grow monotonically up to the far plane, uniform at lambda 0 and logarithmic at 1. The
+// sphere around a slice holds its eight corners and is the smallest one centered on the view
+// axis. Snapped projections start on whole texels, keep their projection while the sphere moves
+// less than half a texel and only shift Texel when the world moves by whole texels. Then the
+// scheduler over a hand-written sequence of frames: who is redrawn, in which order, and the
+// stats it counts.
+
+using namespace Utility;
+
+namespace
+{
+    // Distance from a point on the view axis to the farthest corner of the slice
+    float FarthestCorner(float NearZ, float FarZ, float TanX, float TanY, float Center)
+    {
+        const float Spread = TanX * TanX + TanY * TanY;
+        float Farthest = 0.0f;
+        for (float z : { NearZ, FarZ })
+            Farthest = std::max(Farthest, std::sqrt(z * z * Spread + (z - Center) * (z - Center)));
+        return Farthest;
+    }
+}
+
+static void TestSplits(void)
+{
+    float Splits[4];
+    ComputeCascadeSplits(1.0f, 100.0f, 4, 0.0f, Splits);
+    CHECK(std::fabs(Splits[0] - 25.75f) < 1e-4f && std::fabs(Splits[1] - 50.5f) < 1e-4f && Splits[3] == 100.0f);
+
+    ComputeCascadeSplits(1.0f, 100.0f, 4, 1.0f, Splits);
+    CHECK(std::fabs(Splits[0] - std::sqrt(10.0f)) < 1e-4f && std::fabs(Splits[1] - 10.0f) < 1e-4f && Splits[3] == 100.0f);
+
+    for (float Lambda = 0.0f; Lambda <= 1.0f; Lambda += 0.125f)
+    {
+        ComputeCascadeSplits(0.5f, 300.0f, 4, Lambda, Splits);
+        CHECK(Splits[0] > 0.5f && Splits[0] < Splits[1] && Splits[1] < Splits[2] && Splits[2] < Splits[3]);
+        CHECK(Splits[3] == 300.0f);
+    }
+}
+
+static void TestSphere(void)
+{
+    std::mt19937 Random(3);
+    std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+    for (int i = 0; i < 10000; ++i)
+    {
+        const float NearZ = 0.1f + 20.0f * Unit(Random), FarZ = NearZ + 0.01f + 200.0f * Unit(Random);
+        const float TanX = 0.05f + 2.0f * Unit(Random), TanY = 0.05f + 2.0f * Unit(Random);
+        float Center, Radius;
+        FitCascadeSphere(NearZ, FarZ, TanX, TanY, Center, Radius);
+
+        // every corner inside, the farthest one on the sphere
+        const float Farthest = FarthestCorner(NearZ, FarZ, TanX, TanY, Center);
+        CHECK(Farthest <= Radius * (1.0f + 1e-5f));
+        CHECK(std::fabs(Farthest - Radius) <= Radius * 1e-5f);
+
+        // moving the center along the axis either way only reaches further
+        for (float Step : { -0.01f * Radius, 0.01f * Radius })
+            CHECK(FarthestCorner(NearZ, FarZ, TanX, TanY, Center + Step) >= Radius * (1.0f - 1e-5f));
+    }
+}
+
+static void TestSnap(void)
+{
+    std::mt19937 Random(5);
+    std::uniform_real_distribution<float> Unit(0.0f, 1.0f);
+    for (int i = 0; i < 10000; ++i)
+    {
+        const float Center[3] = { 200.0f * Unit(Random) - 100.0f, 200.0f * Unit(Random) - 100.0f, 200.0f * Unit(Random) - 100.0f };
+        const float Radius = 1.0f + 30.0f * Unit(Random);
+        const CascadeProjection Projection = SnapCascade(Center, Radius, 2048, 10.0f);
+
+        float Min[3], Max[3];
+        GetCascadeBounds(Projection, Min, Max);
+        for (int k = 0; k < 2; ++k)
+        {
+            const float Texels = Min[k] / Projection.TexelSize;
+            CHECK(std::fabs(Texels - std::round(Texels)) < 1e-2f);
+            CHECK(std::fabs(Center[k] - 0.5f * (Min[k] + Max[k])) <= 0.55f * Projection.TexelSize);
+        }
+        CHECK(std::fabs(Max[0] - Min[0] - 2.0f * Radius) < 1e-3f * Radius);
+        CHECK(std::fabs(Max[2] - Min[2] - (2.0f * Radius + 10.0f)) < 1e-3f * Radius);
+
+        // a fit less than half a texel from the snapped center keeps the projection, one further
+        // away does not
+        const float Snapped[3] = { Projection.Texel[0] * Projection.TexelSize, Projection.Texel[1] * Projection.TexelSize,
+            Projection.Texel[2] * Projection.TexelSize };
+        const float Near[3] = { Snapped[0] + 0.3f * Projection.TexelSize, Snapped[1] - 0.3f * Projection.TexelSize,
+            Snapped[2] + 0.2f * Projection.TexelSize };
+        const float Far[3] = { Snapped[0] + 0.7f * Projection.TexelSize, Snapped[1], Snapped[2] };
+        CHECK(SameCascadeProjection(Projection, SnapCascade(Near, Radius, 2048, 10.0f)));
+        CHECK(!SameCascadeProjection(Projection, SnapCascade(Far, Radius, 2048, 10.0f)));
+    }
+}
+
+// Moving the world by whole texels only shifts Texel, so shadow texels stay put in the world
+static void TestTranslation(void)
+{
+    const float Center[3] = { 3.3f, -7.1f, 12.0f };
+    const CascadeProjection Projection = SnapCascade(Center, 16.0f, 2048, 0.0f);
+    for (int k = -50; k <= 50; ++k)
+    {
+        const float Moved[3] = { Center[0] + k * Projection.TexelSize, Center[1] - 2 * k * Projection.TexelSize, Center[2] };
+        const CascadeProjection Shifted = SnapCascade(Moved, 16.0f, 2048, 0.0f);
+        CHECK(Shifted.Texel[0] - Projection.Texel[0] == k && Shifted.Texel[1] - Projection.Texel[1] == -2 * k);
+    }
+}
+
+static void TestContainment(void)
+{
+    const float Origin[3] = { 0.0f, 0.0f, 0.0f };
+    const CascadeProjection Projection = SnapCascade(Origin, 10.0f, 1024, 20.0f);
+
+    const float Inside[3] = { 5.0f, 5.0f, 5.0f };
+    CHECK(CascadeContains(Projection, Inside, 4.9f) && !CascadeContains(Projection, Inside, 5.1f));
+
+    // toward the light only casters are drawn, receivers are not covered there
+    const float Casters[3] = { 0.0f, 0.0f, -12.0f };
+    CHECK(!CascadeContains(Projection, Casters, 1.0f) && CascadeOverlaps(Projection, Casters, 1.0f));
+
+    const float Beyond[3] = { 0.0f, 0.0f, -31.0f };
+    CHECK(!CascadeOverlaps(Projection, Beyond, 0.9f) && CascadeOverlaps(Projection, Beyond, 1.1f));
+
+    // off a corner of the square the distance is to the corner, sqrt(2) away
+    const float Corner[3] = { 11.0f, 11.0f, 0.0f };
+    CHECK(!CascadeOverlaps(Projection, Corner, 1.4f) && CascadeOverlaps(Projection, Corner, 1.42f));
+}
+
+// Four cascades, the first redrawn every frame, one cached cascade redrawn a frame at most
+static void TestScheduler(void)
+{
+    const uint32_t Count = 4;
+    CascadeScheduler Scheduler(Count, 1, 1);
+    CascadeProjection Fitted[Count];
+    float Slices[Count][4];
+    bool Dirty[Count] = {}, Redraw[Count];
+    for (uint32_t i = 0; i < Count; ++i)
+    {
+        Slices[i][0] = Slices[i][1] = Slices[i][2] = 0.0f;
+        Slices[i][3] = 5.0f * (i + 1);
+        Fitted[i] = SnapCascade(Slices[i], Slices[i][3] * (i != 0 ? 1.2f : 1.0f), 1024, 10.0f);
+    }
+
+    // the first frame draws everything, then only the first cascade
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(Redraw[0] && Redraw[1] && Redraw[2] && Redraw[3]);
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(Redraw[0] && !Redraw[1] && !Redraw[2] && !Redraw[3]);
+
+    // a move inside the padding keeps the cached ones
+    for (uint32_t i = 0; i < Count; ++i)
+        Slices[i][0] += 0.5f;
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(Redraw[0] && !Redraw[1] && !Redraw[2] && !Redraw[3]);
+
+    // a caster dirties all three cached cascades: one a frame, oldest first, then by index
+    Dirty[1] = Dirty[2] = Dirty[3] = true;
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(Redraw[1] && !Redraw[2] && !Redraw[3]);
+    Dirty[1] = Dirty[2] = Dirty[3] = false;
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(!Redraw[1] && Redraw[2] && !Redraw[3]);
+
+    // dirty again, but newer than the third
+    Dirty[1] = true;
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(!Redraw[1] && !Redraw[2] && Redraw[3]);
+    Dirty[1] = false;
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(Redraw[1] && !Redraw[2] && !Redraw[3]);
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(!Redraw[1] && !Redraw[2] && !Redraw[3]);
+
+    // a slice leaving its projection is redrawn with the new fit and takes the frame's budget
+    Dirty[2] = true;
+    Slices[3][0] += 20.0f;
+    Fitted[3] = SnapCascade(Slices[3], Slices[3][3] * 1.2f, 1024, 10.0f);
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(Redraw[3] && !Redraw[2] && SameCascadeProjection(Scheduler.GetProjection(3), Fitted[3]));
+    Dirty[2] = false;
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(Redraw[2] && !Redraw[3]);
+
+    const CascadeScheduler::Stats Stats = Scheduler.TakeStats();
+    CHECK(Stats.Frames == 10 && Stats.Moved == 1 && Stats.Refreshed == 5);
+    CHECK(Scheduler.TakeStats().Frames == 0);
+
+    Scheduler.Invalidate();
+    Scheduler.Update(Fitted, Slices, Dirty, Redraw);
+    CHECK(Redraw[0] && Redraw[1] && Redraw[2] && Redraw[3]);
+}
+
+int main(void)
+{
+    TestSplits();
+    TestSphere();
+    TestSnap();
+    TestTranslation();
+    TestContainment();
+    TestScheduler();
+    return Test::Finish("ShadowCascadesTest");
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Just enough for the headless tests: CHECK reports a failure and carries on, so one run
+// lists every broken case, and Test::Finish turns the count into the exit code ctest reads.
+// Benchmarks take an optional scale on the command line; ctest runs them small as a smoke
+// test, run them by hand for real numbers.
+namespace Test
+{
+    inline std::atomic<int>& Failures(void)
+    {
+        static std::atomic<int> s_Failures{ 0 };
+        return s_Failures;
+    }
+
+    inline int Finish(const char* Name)
+    {
+        int Count = Failures().load();
+        if (Count == 0)
+            printf("%s: ok\n", Name);
+        else
+            printf("%s: %d failed checks\n", Name, Count);
+        return Count == 0 ? 0 : 1;
+    }
+
+    // Scale for benchmarks: argv[1] if given, otherwise 1
+    inline double GetScale(int argc, char** argv)
+    {
+        return argc > 1 ? atof(argv[1]) : 1.0;
+    }
+
+    class Timer
+    {
+    public:
+        Timer(void) : m_Start(std::chrono::steady_clock::now()) {}
+
+        double Seconds(void) const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_Start;
+    };
+}
+
+#define CHECK( Condition ) \
+    do { \
+        if (!(Condition)) { \
+            fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #Condition); \
+            ++Test::Failures(); \
+        } \
+    } while (0)
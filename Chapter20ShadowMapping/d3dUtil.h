@@ -1,5 +1,6 @@
 #pragma once
 #include <DirectXMath.h>
+#include <DirectXCollision.h>
 #include <string>
 #include "GpuBuffer.h"
 
@@ -33,7 +34,9 @@ struct SubmeshGeometry
 	UINT IndexCount = 0;
 	UINT StartIndexLocation = 0;
 	INT BaseVertexLocation = 0;
-	
+
+	// object space, a negative radius when nobody worked it out
+	DirectX::BoundingSphere Bounds = DirectX::BoundingSphere({ 0.0f, 0.0f, 0.0f }, -1.0f);
 };
 
 struct MeshGeometry
@@ -95,4 +98,6 @@ __declspec(align(16)) struct PassConstants
 	float fogRange = 100.0;
 	float pad1;
 	float pad2;
+	// far view distance of each cascade, the vertex shader picks the cascade with them
+	DirectX::XMFLOAT4 CascadeSplits = { 0.0f, 0.0f, 0.0f, 0.0f };
 };
\ No newline at end of file
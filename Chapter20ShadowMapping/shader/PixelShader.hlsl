@@ -5,6 +5,10 @@ float CSM_PCF(float4 shadowPosH, float bias, float index)
 {
     shadowPosH.xyz /= shadowPosH.w;
     
+    // past the last cascade, nothing casts shadows there
+    if (any(shadowPosH.xyz < 0.0) || any(shadowPosH.xyz > 1.0))
+        return 1.0;
+    
     float curDepth = shadowPosH.z;
     
     // PCF
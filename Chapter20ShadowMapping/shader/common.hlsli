@@ -40,6 +40,7 @@ struct PassConstants
     float gFogRange;
     float pad1;
     float pad2;
+    float4 gCascadeSplits;  // far view distance of each cascade
 };
 
 struct MaterialData
@@ -105,14 +105,33 @@ void Blur::CreateComputeRootSig()
 void Blur::Execute(DepthBuffer& input, int BlurCount)
 {
 
+	// vsm writes Output0, then every blur ping-pongs horizontally into Output1 and back
+	m_Barriers.Reset();
+	m_Barriers.AddPass();
+	m_Barriers.Read(input, D3D12_RESOURCE_STATE_GENERIC_READ);
+	m_Barriers.Write(Output0, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	for (int i = 0; i < BlurCount; ++i)
+	{
+		m_Barriers.AddPass();
+		m_Barriers.Read(Output0, D3D12_RESOURCE_STATE_GENERIC_READ);
+		m_Barriers.Write(Output1, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_Barriers.AddPass();
+		m_Barriers.Read(Output1, D3D12_RESOURCE_STATE_GENERIC_READ);
+		m_Barriers.Write(Output0, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+	m_Barriers.Leave(Output0, D3D12_RESOURCE_STATE_GENERIC_READ);
+	m_Barriers.Leave(Output1, D3D12_RESOURCE_STATE_GENERIC_READ);
+	m_Barriers.Solve();
+
+	uint32_t pass = 0;
+
 	ComputeContext& CScontext = ComputeContext::Begin(L"blur compute");
 
 	//---------------------------------
 	// vsm pass
 	//---------------------------------
 	CScontext.SetRootSignature(m_ComputeRootSig);
-	CScontext.TransitionResource(input, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-	CScontext.TransitionResource(Output0, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+	m_Barriers.IssueBarriers(CScontext, pass++);
 
 	//CScontext.SetPipelineState(m_PSOs["evsm"]);
 	CScontext.SetPipelineState(m_PSOs["vsm"]);
@@ -123,8 +142,7 @@ void Blur::Execute(DepthBuffer& input, int BlurCount)
 	UINT NumGroupsX = (UINT)ceilf(input.GetWidth() / 16.0f);
 	UINT NumGroupsY = (UINT)ceilf(input.GetHeight() / 16.0f);
 	CScontext.Dispatch(NumGroupsX, NumGroupsY, 1);
-	CScontext.TransitionResource(Output0, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-	
+
 	for (int i = 0; i < BlurCount; ++i)
 	{
 		//---------------------------------
@@ -138,8 +156,7 @@ void Blur::Execute(DepthBuffer& input, int BlurCount)
 		// horizontal pass
 		CScontext.SetPipelineState(m_PSOs["horz"]);
 
-		CScontext.TransitionResource(Output0, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-		CScontext.TransitionResource(Output1, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+		m_Barriers.IssueBarriers(CScontext, pass++);
 
 		CScontext.SetDynamicDescriptor(1, 0, Output0.GetSRV());
 		CScontext.SetDynamicDescriptor(2, 0, Output1.GetUAV());
@@ -151,8 +168,7 @@ void Blur::Execute(DepthBuffer& input, int BlurCount)
 		// vertical pass
 		CScontext.SetPipelineState(m_PSOs["vert"]);
 
-		CScontext.TransitionResource(Output0, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
-		CScontext.TransitionResource(Output1, D3D12_RESOURCE_STATE_GENERIC_READ, true);
+		m_Barriers.IssueBarriers(CScontext, pass++);
 
 		CScontext.SetDynamicDescriptor(1, 0, Output1.GetSRV());
 		CScontext.SetDynamicDescriptor(2, 0, Output0.GetUAV());
@@ -162,8 +178,7 @@ void Blur::Execute(DepthBuffer& input, int BlurCount)
 		CScontext.Dispatch(m_Width, NumGroupsY, 1);
 	}
 
-	CScontext.TransitionResource(Output0, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-	CScontext.TransitionResource(Output1, D3D12_RESOURCE_STATE_GENERIC_READ, true);
+	m_Barriers.IssueBarriers(CScontext, pass);
 
 	CScontext.Finish(true);
 }
@@ -171,6 +186,24 @@ void Blur::Execute(DepthBuffer& input, int BlurCount)
 void Blur::GenerateMipMaps()
 {
 	if (m_MipNums <= 1) return;
+
+	// per mip: Output0 into Output1, then Output1 back into Output0
+	m_Barriers.Reset();
+	for (UINT mip = 1; mip < m_MipNums; ++mip)
+	{
+		m_Barriers.AddPass();
+		m_Barriers.Read(Output0, D3D12_RESOURCE_STATE_GENERIC_READ);
+		m_Barriers.Write(Output1, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		m_Barriers.AddPass();
+		m_Barriers.Read(Output1, D3D12_RESOURCE_STATE_GENERIC_READ);
+		m_Barriers.Write(Output0, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+	m_Barriers.Leave(Output0, D3D12_RESOURCE_STATE_GENERIC_READ);
+	m_Barriers.Leave(Output1, D3D12_RESOURCE_STATE_GENERIC_READ);
+	m_Barriers.Solve();
+
+	uint32_t pass = 0;
+
 	ComputeContext& CScontext = ComputeContext::Begin(L"mipmap CS");
 
 	CScontext.SetRootSignature(m_MipmapRootSig);
@@ -184,8 +217,7 @@ void Blur::GenerateMipMaps()
 
 		CScontext.SetPipelineState(m_PSOs["mipmap"]);
 
-		CScontext.TransitionResource(Output1, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
-		CScontext.TransitionResource(Output0, D3D12_RESOURCE_STATE_GENERIC_READ, true);
+		m_Barriers.IssueBarriers(CScontext, pass++);
 
 		// output0 mip0写入input1的mip1
 		CScontext.SetConstants(0, mip-1, m_MipNums, SrcWidth, DstWidth);
@@ -197,8 +229,7 @@ void Blur::GenerateMipMaps()
 		UINT NumGroupsY = (UINT)ceilf(DstHeight / 16.0f);
 		CScontext.Dispatch(NumGroupsX, NumGroupsY, 1);
 
-		CScontext.TransitionResource(Output0, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
-		CScontext.TransitionResource(Output1, D3D12_RESOURCE_STATE_GENERIC_READ, true);
+		m_Barriers.IssueBarriers(CScontext, pass++);
 		
 		// input1 mip 1 写入 input0 mip 1
 		CScontext.SetConstants(0, mip, m_MipNums, SrcWidth, DstWidth);
@@ -208,11 +239,10 @@ void Blur::GenerateMipMaps()
 		NumGroupsX = (UINT)ceilf(DstWidth / 16.0f);
 		NumGroupsY = (UINT)ceilf(DstHeight / 16.0f);
 		CScontext.Dispatch(NumGroupsX, NumGroupsY, 1);
-
-		CScontext.TransitionResource(Output0, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-		CScontext.TransitionResource(Output1, D3D12_RESOURCE_STATE_GENERIC_READ, true);
 	}
 
+	m_Barriers.IssueBarriers(CScontext, pass);
+
 	CScontext.Finish(true);
 }
 
@@ -4,6 +4,7 @@
 #include "DepthBuffer.h"
 #include "PipelineState.h"
 #include "CommandContext.h"
+#include "ResourceStateTracker.h"
 
 class Blur
 {
@@ -42,6 +43,9 @@ private:
 	RootSignature m_ComputeRootSig;
 	RootSignature m_MipmapRootSig;
 
+	// the passes of Execute and GenerateMipMaps, declared before either records
+	ResourceStateTracker m_Barriers;
+
 	std::unordered_map<std::string, ComputePSO> m_PSOs;
 };
 
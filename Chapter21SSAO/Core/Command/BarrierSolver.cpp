@@ -0,0 +1,233 @@
+#include "pch.h"
+#include "BarrierSolver.h"
+
+void BarrierSolver::Reset(void)
+{
+	m_Resources.clear();
+	m_Passes.clear();
+	m_Accesses.clear();
+	m_Transitions.clear();
+	m_Barriers.clear();
+	m_BoundaryOffsets.clear();
+	m_Stats = Stats();
+}
+
+uint32_t BarrierSolver::AddResource(uint32_t InitialState)
+{
+	ResourceInfo Info = {};
+	Info.InitialState = InitialState;
+	Info.State = InitialState;
+	m_Resources.push_back(Info);
+	return (uint32_t)m_Resources.size() - 1;
+}
+
+void BarrierSolver::AddPass(uint32_t ListIndex)
+{
+	Pass NewPass;
+	NewPass.ListIndex = ListIndex;
+	NewPass.FirstAccess = (uint32_t)m_Accesses.size();
+	NewPass.NumAccesses = 0;
+	m_Passes.push_back(NewPass);
+}
+
+void BarrierSolver::Read(uint32_t Resource, uint32_t State)
+{
+	ASSERT(State != 0 && (State & ~kReadOnlyStates) == 0, "Not a read state");
+	DeclareAccess(Resource, State, false);
+}
+
+void BarrierSolver::Write(uint32_t Resource, uint32_t State)
+{
+	DeclareAccess(Resource, State, true);
+}
+
+void BarrierSolver::SetFinalState(uint32_t Resource, uint32_t State)
+{
+	ASSERT(Resource < m_Resources.size());
+	m_Resources[Resource].FinalState = State;
+	m_Resources[Resource].HasFinalState = true;
+}
+
+void BarrierSolver::DeclareAccess(uint32_t Resource, uint32_t State, bool Write)
+{
+	ASSERT(!m_Passes.empty(), "Reads and writes belong to a pass");
+	ASSERT(Resource < m_Resources.size());
+
+	Pass& Current = m_Passes.back();
+
+	// A resource declared more than once by a pass is used in one state for all of it: the
+	// combined read state, or the written state when it is also written
+	for (uint32_t i = Current.FirstAccess; i < Current.FirstAccess + Current.NumAccesses; ++i)
+	{
+		Access& Existing = m_Accesses[i];
+		if (Existing.Resource != Resource)
+			continue;
+
+		if (Write && Existing.Write)
+			ASSERT(State == Existing.State, "A pass can only write a resource in one state");
+
+		if (Write)
+			Existing.State = State;
+		else if (!Existing.Write)
+			Existing.State |= State;
+		Existing.Write = Existing.Write || Write;
+		return;
+	}
+
+	Access NewAccess = { Resource, State, Write };
+	m_Accesses.push_back(NewAccess);
+	++Current.NumAccesses;
+}
+
+uint32_t BarrierSolver::ListOfBoundary(uint32_t Boundary) const
+{
+	// the barriers after the last pass go at the end of its list
+	if (m_Passes.empty())
+		return 0;
+	return m_Passes[Boundary < m_Passes.size() ? Boundary : m_Passes.size() - 1].ListIndex;
+}
+
+void BarrierSolver::SolveAccess(uint32_t PassIndex, const Access& A)
+{
+	ResourceInfo& R = m_Resources[A.Resource];
+
+	// nothing to wait for before the first use in the frame
+	const uint32_t Earliest = R.LastPass == kNoPass ? 0 : R.LastPass + 1;
+
+	if (!A.Write)
+	{
+		if ((R.State & A.State) == A.State)
+		{
+			++m_Stats.Elided;
+		}
+		else if (R.ReadTransition != kNoTransition)
+		{
+			// still only read since the last transition, have that one cover this read too
+			m_Transitions[R.ReadTransition].StateAfter |= A.State;
+			R.State |= A.State;
+			++m_Stats.Elided;
+		}
+		else
+		{
+			PendingTransition T = { A.Resource, R.State, A.State, Earliest, PassIndex, false };
+			R.ReadTransition = (uint32_t)m_Transitions.size();
+			m_Transitions.push_back(T);
+			R.State = A.State;
+		}
+	}
+	else
+	{
+		if (R.State != A.State)
+		{
+			PendingTransition T = { A.Resource, R.State, A.State, Earliest, PassIndex, false };
+			m_Transitions.push_back(T);
+			R.State = A.State;
+		}
+		else if ((A.State & kUnorderedAccess) != 0 && R.LastPass != kNoPass)
+		{
+			// UAV to UAV, the previous pass's writes must land first
+			PendingTransition T = { A.Resource, R.State, R.State, PassIndex, PassIndex, true };
+			m_Transitions.push_back(T);
+		}
+		else
+		{
+			++m_Stats.Elided;
+		}
+
+		R.ReadTransition = kNoTransition;
+	}
+
+	R.LastPass = PassIndex;
+	R.LastWasWrite = A.Write;
+}
+
+void BarrierSolver::Solve(void)
+{
+	const uint32_t NumPasses = (uint32_t)m_Passes.size();
+
+	m_Transitions.clear();
+	m_Barriers.clear();
+	m_Stats = Stats();
+
+	for (ResourceInfo& R : m_Resources)
+	{
+		R.State = R.InitialState;
+		R.LastPass = kNoPass;
+		R.LastWasWrite = false;
+		R.ReadTransition = kNoTransition;
+	}
+
+	for (uint32_t p = 0; p < NumPasses; ++p)
+	{
+		const Pass& P = m_Passes[p];
+		for (uint32_t i = P.FirstAccess; i < P.FirstAccess + P.NumAccesses; ++i)
+			SolveAccess(p, m_Accesses[i]);
+	}
+
+	for (uint32_t r = 0; r < (uint32_t)m_Resources.size(); ++r)
+	{
+		ResourceInfo& R = m_Resources[r];
+		if (!R.HasFinalState || R.State == R.FinalState)
+			continue;
+
+		// a read state the final one extends can be entered straight away
+		if (R.ReadTransition != kNoTransition && (R.FinalState & ~kReadOnlyStates) == 0 &&
+			(R.FinalState & R.State) == R.State)
+		{
+			m_Transitions[R.ReadTransition].StateAfter = R.FinalState;
+		}
+		else
+		{
+			PendingTransition T = { r, R.State, R.FinalState, R.LastPass == kNoPass ? 0 : R.LastPass + 1, NumPasses, false };
+			m_Transitions.push_back(T);
+		}
+		R.State = R.FinalState;
+	}
+
+	// Place the transitions, then bucket them by boundary keeping their order within one
+	std::vector<std::pair<uint32_t, Barrier>> Placed;
+	Placed.reserve(m_Transitions.size() * 2);
+
+	for (const PendingTransition& T : m_Transitions)
+	{
+		if (T.UAV)
+		{
+			Placed.push_back({ T.Boundary, { T.Resource, kUAV, T.StateBefore, T.StateAfter } });
+			++m_Stats.UAVBarriers;
+		}
+		else if (T.EarliestBoundary < T.Boundary && ListOfBoundary(T.EarliestBoundary) == ListOfBoundary(T.Boundary))
+		{
+			Placed.push_back({ T.EarliestBoundary, { T.Resource, kBeginOnly, T.StateBefore, T.StateAfter } });
+			Placed.push_back({ T.Boundary, { T.Resource, kEndOnly, T.StateBefore, T.StateAfter } });
+			++m_Stats.SplitTransitions;
+		}
+		else
+		{
+			Placed.push_back({ T.Boundary, { T.Resource, kTransition, T.StateBefore, T.StateAfter } });
+			++m_Stats.Transitions;
+		}
+	}
+
+	m_BoundaryOffsets.assign(NumPasses + 2, 0);
+	for (auto& P : Placed)
+		++m_BoundaryOffsets[P.first + 1];
+	for (uint32_t b = 0; b <= NumPasses; ++b)
+	{
+		if (m_BoundaryOffsets[b + 1] != 0)
+			++m_Stats.BarrierCalls;
+		m_BoundaryOffsets[b + 1] += m_BoundaryOffsets[b];
+	}
+
+	m_Barriers.resize(Placed.size());
+	std::vector<uint32_t> Next(m_BoundaryOffsets.begin(), m_BoundaryOffsets.end() - 1);
+	for (auto& P : Placed)
+		m_Barriers[Next[P.first]++] = P.second;
+}
+
+const BarrierSolver::Barrier* BarrierSolver::GetBarriers(uint32_t Boundary, uint32_t& NumBarriers) const
+{
+	ASSERT(Boundary + 1 < m_BoundaryOffsets.size(), "Solve first");
+
+	NumBarriers = m_BoundaryOffsets[Boundary + 1] - m_BoundaryOffsets[Boundary];
+	return m_Barriers.data() + m_BoundaryOffsets[Boundary];
+}
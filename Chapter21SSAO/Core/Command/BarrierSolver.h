@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Works out the barriers a sequence of passes needs from what each pass reads and writes.
+//
+// States are D3D12_RESOURCE_STATES bit masks, but nothing here touches D3D, so the solver runs
+// without a device. Resources are plain indices, the caller maps them to its own objects.
+//
+// Only state changes emit a transition. Consecutive passes reading a resource in different
+// read states share one transition into the combined state, and a UAV written by one pass and
+// touched again by the next gets a UAV barrier. A transition whose resource sits idle for a
+// pass or more is split: BEGIN right after its last use, END right before its next one, as
+// long as both ends land in the same command list.
+//
+// Barriers are grouped by boundary. Boundary i is issued before pass i, boundary NumPasses
+// after the last pass, so each boundary is meant to go down as a single ResourceBarrier call.
+class BarrierSolver
+{
+public:
+	// D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+	static const uint32_t kUnorderedAccess = 0x8;
+
+	// GENERIC_READ plus DEPTH_READ: the states that can be combined with each other
+	static const uint32_t kReadOnlyStates = 0xAE3;
+
+	enum BarrierType { kTransition, kBeginOnly, kEndOnly, kUAV };
+
+	struct Barrier
+	{
+		uint32_t Resource;
+		BarrierType Type;
+		uint32_t StateBefore;
+		uint32_t StateAfter;
+	};
+
+	struct Stats
+	{
+		uint32_t Transitions;		// full transitions
+		uint32_t SplitTransitions;	// BEGIN/END pairs, counted once
+		uint32_t UAVBarriers;
+		uint32_t BarrierCalls;		// boundaries with at least one barrier
+		uint32_t Elided;			// declared accesses that needed no barrier
+	};
+
+	void Reset(void);
+
+	// InitialState is the state the resource is in before the first pass
+	uint32_t AddResource(uint32_t InitialState);
+
+	// Starts a pass, the reads and writes that follow belong to it. Passes recorded into
+	// different command lists must pass different ListIndex values.
+	void AddPass(uint32_t ListIndex = 0);
+
+	// State must be made of kReadOnlyStates
+	void Read(uint32_t Resource, uint32_t State);
+	void Write(uint32_t Resource, uint32_t State);
+
+	// State the resource has to be in once the last pass is done
+	void SetFinalState(uint32_t Resource, uint32_t State);
+
+	void Solve(void);
+
+	uint32_t GetPassCount(void) const { return (uint32_t)m_Passes.size(); }
+
+	// Boundary goes from 0 to GetPassCount()
+	const Barrier* GetBarriers(uint32_t Boundary, uint32_t& NumBarriers) const;
+
+	uint32_t GetFinalState(uint32_t Resource) const { return m_Resources[Resource].State; }
+
+	const Stats& GetStats(void) const { return m_Stats; }
+
+private:
+	static const uint32_t kNoPass = 0xFFFFFFFF;
+	static const uint32_t kNoTransition = 0xFFFFFFFF;
+
+	struct ResourceInfo
+	{
+		uint32_t InitialState;
+		uint32_t FinalState;	// 0 with HasFinalState false means don't care
+		bool HasFinalState;
+
+		// progress of Solve
+		uint32_t State;
+		uint32_t LastPass;
+		bool LastWasWrite;
+		uint32_t ReadTransition;	// transition into the current read state, widened by later reads
+	};
+
+	struct Access
+	{
+		uint32_t Resource;
+		uint32_t State;
+		bool Write;
+	};
+
+	struct Pass
+	{
+		uint32_t ListIndex;
+		uint32_t FirstAccess;
+		uint32_t NumAccesses;
+	};
+
+	// Placed once every pass has been seen, later reads may still widen StateAfter
+	struct PendingTransition
+	{
+		uint32_t Resource;
+		uint32_t StateBefore;
+		uint32_t StateAfter;
+		uint32_t EarliestBoundary;
+		uint32_t Boundary;
+		bool UAV;
+	};
+
+	void DeclareAccess(uint32_t Resource, uint32_t State, bool Write);
+	void SolveAccess(uint32_t PassIndex, const Access& A);
+	uint32_t ListOfBoundary(uint32_t Boundary) const;
+
+	std::vector<ResourceInfo> m_Resources;
+	std::vector<Pass> m_Passes;
+	std::vector<Access> m_Accesses;
+
+	std::vector<PendingTransition> m_Transitions;
+	std::vector<Barrier> m_Barriers;				// sorted by boundary
+	std::vector<uint32_t> m_BoundaryOffsets;		// GetPassCount() + 2 entries into m_Barriers
+	Stats m_Stats = {};
+};
@@ -8,6 +8,12 @@
 
 using namespace Graphics;
 
+namespace
+{
+    std::mutex s_StateStatsMutex;
+    StateChangeStats s_StateStats;
+}
+
 void ContextManager::DestroyAllContexts(void)
 {
     for (uint32_t i = 0; i < 4; ++i)
@@ -48,11 +54,11 @@ void ContextManager::FreeContext(CommandContext* UsedContext)
 }
 
 CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
-    m_Type(Type),
     m_DynamicViewDescriptorHeap(*this, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
     m_DynamicSamplerDescriptorHeap(*this, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER),
     m_CpuLinearAllocator(kCpuWritable), /*upload buffer*/
-    m_GpuLinearAllocator(kGpuExclusive)/*default buffer*/
+    m_GpuLinearAllocator(kGpuExclusive), /*default buffer*/
+    m_Type(Type)
 {
     m_OwningManager = nullptr;
     m_CommandList = nullptr;
@@ -63,6 +69,8 @@ CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
     m_CurComputeRootSignature = nullptr;
     m_CurPipelineState = nullptr;
     m_NumBarriersToFlush = 0;
+
+    InvalidateCachedState();
 }
 
 void CommandContext::CopyBuffer(GpuResource& Dest, GpuResource& Src)
@@ -88,15 +96,17 @@ void CommandContext::CopySubresource(GpuResource& Dest, UINT DestSubIndex, GpuRe
     {
         Dest.GetResource(),
         D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
-        DestSubIndex
+        {}
     };
+    DestLocation.SubresourceIndex = DestSubIndex;
 
     D3D12_TEXTURE_COPY_LOCATION SrcLocation =
     {
         Src.GetResource(),
         D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
-        SrcSubIndex
+        {}
     };
+    SrcLocation.SubresourceIndex = SrcSubIndex;
 
     m_CommandList->CopyTextureRegion(&DestLocation, 0, 0, 0, &SrcLocation, nullptr);
 }
@@ -176,15 +186,17 @@ void CommandContext::InitializeTextureArraySlice(GpuResource& Dest, UINT SliceIn
         {
             Dest.GetResource(),
             D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
-            SubResourceIndex + i
+            {}
         };
+        destCopyLocation.SubresourceIndex = SubResourceIndex + i;
 
         D3D12_TEXTURE_COPY_LOCATION srcCopyLocation =
         {
             Src.GetResource(),
             D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
-            i
+            {}
         };
+        srcCopyLocation.SubresourceIndex = i;
 
         Context.m_CommandList->CopyTextureRegion(&destCopyLocation, 0, 0, 0, &srcCopyLocation, nullptr);
     }
@@ -267,10 +279,35 @@ void CommandContext::FlushResourceBarriers(void)
     if (m_NumBarriersToFlush > 0)
     {
         m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
+        CountBarriers(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
         m_NumBarriersToFlush = 0;
     }
 }
 
+void CommandContext::ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* Barriers)
+{
+    FlushResourceBarriers();
+
+    if (NumBarriers > 0)
+    {
+        m_CommandList->ResourceBarrier(NumBarriers, Barriers);
+        CountBarriers(NumBarriers, Barriers);
+    }
+}
+
+void CommandContext::CountBarriers(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* Barriers)
+{
+    m_StateStats.BarrierCalls++;
+    for (UINT i = 0; i < NumBarriers; ++i)
+    {
+        // the END half of a split barrier completes one already counted
+        if (Barriers[i].Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+            m_StateStats.SplitBarriers++;
+        else if (Barriers[i].Flags != D3D12_RESOURCE_BARRIER_FLAG_END_ONLY)
+            m_StateStats.Barriers++;
+    }
+}
+
 void CommandContext::SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type, ID3D12DescriptorHeap* HeapPtr)
 {
     if (m_CurrentDescriptorHeaps[Type] != HeapPtr)
@@ -301,10 +338,14 @@ void CommandContext::SetPipelineState(const PSO& PSO)
 {
     ID3D12PipelineState* PipelineState = PSO.GetPipelineStateObject();
     if (PipelineState == m_CurPipelineState)
+    {
+        m_StateStats.Skipped[StateChangeStats::kPipelineState]++;
         return;
+    }
 
     m_CommandList->SetPipelineState(PipelineState);
     m_CurPipelineState = PipelineState;
+    m_StateStats.Issued[StateChangeStats::kPipelineState]++;
 }
 
 void CommandContext::SetPredication(ID3D12Resource* Buffer, UINT64 BufferOffset, D3D12_PREDICATION_OP Op)
@@ -340,9 +381,27 @@ void CommandContext::Reset(void)
     m_CurPipelineState = nullptr;
     m_NumBarriersToFlush = 0;
 
+    InvalidateCachedState();
     BindDescriptorHeaps();
 }
 
+void CommandContext::InvalidateCachedState(void)
+{
+    m_CurPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    ZeroMemory(m_CurVertexBuffers, sizeof(m_CurVertexBuffers));
+    ZeroMemory(&m_CurIndexBuffer, sizeof(m_CurIndexBuffer));
+}
+
+StateChangeStats CommandContext::GetStateChangeStats(bool Reset)
+{
+    std::lock_guard<std::mutex> LockGuard(s_StateStatsMutex);
+
+    StateChangeStats Stats = s_StateStats;
+    if (Reset)
+        s_StateStats.Reset();
+    return Stats;
+}
+
 CommandContext::~CommandContext(void)
 {
     if (m_CommandList != nullptr)
@@ -375,6 +434,10 @@ uint64_t CommandContext::Flush(bool WaitForCompletion)
     // reset the command list and restore previous state
     m_CommandList->Reset(m_CurrentAllocator, nullptr);
 
+    // the reset list starts with no pipeline state and nothing bound to the input assembler
+    m_CurPipelineState = nullptr;
+    InvalidateCachedState();
+
     return FenceValue;
 }
 
@@ -390,13 +453,7 @@ uint64_t CommandContext::Finish(bool WaitForCompletion)
     CommandQueue& Queue = g_CommandManager.GetQueue(m_Type);
 
     uint64_t FenceValue = Queue.ExecuteCommandList(m_CommandList);
-    Queue.DiscardAllocator(FenceValue, m_CurrentAllocator);
-    m_CurrentAllocator = nullptr;
-
-    m_CpuLinearAllocator.CleanupUsedPages(FenceValue);
-    m_GpuLinearAllocator.CleanupUsedPages(FenceValue);
-    m_DynamicViewDescriptorHeap.CleanupUsedHeaps(FenceValue);
-    m_DynamicSamplerDescriptorHeap.CleanupUsedHeaps(FenceValue);
+    Release(FenceValue);
 
     if (WaitForCompletion)
         g_CommandManager.WaitForFence(FenceValue);
@@ -406,6 +463,56 @@ uint64_t CommandContext::Finish(bool WaitForCompletion)
     return FenceValue;
 }
 
+uint64_t CommandContext::FinishBatch(CommandContext* const Contexts[], UINT NumContexts, bool WaitForCompletion)
+{
+    ASSERT(NumContexts > 0 && NumContexts <= 64, "Too many contexts in one batch");
+
+    D3D12_COMMAND_LIST_TYPE Type = Contexts[0]->m_Type;
+    ASSERT(Type == D3D12_COMMAND_LIST_TYPE_DIRECT || Type == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+
+    ID3D12CommandList* Lists[64];
+    for (UINT i = 0; i < NumContexts; ++i)
+    {
+        ASSERT(Contexts[i]->m_Type == Type, "Batched contexts must target the same queue");
+        ASSERT(Contexts[i]->m_CurrentAllocator != nullptr);
+
+        Contexts[i]->FlushResourceBarriers();
+        Lists[i] = Contexts[i]->m_CommandList;
+    }
+
+    CommandQueue& Queue = g_CommandManager.GetQueue(Type);
+
+    uint64_t FenceValue = Queue.ExecuteCommandLists(NumContexts, Lists);
+    for (UINT i = 0; i < NumContexts; ++i)
+        Contexts[i]->Release(FenceValue);
+
+    if (WaitForCompletion)
+        g_CommandManager.WaitForFence(FenceValue);
+
+    for (UINT i = 0; i < NumContexts; ++i)
+        g_ContextManager.FreeContext(Contexts[i]);
+
+    return FenceValue;
+}
+
+void CommandContext::Release(uint64_t FenceValue)
+{
+    // everything this context used may be recycled once FenceValue completes
+    g_CommandManager.GetQueue(m_Type).DiscardAllocator(FenceValue, m_CurrentAllocator);
+    m_CurrentAllocator = nullptr;
+
+    m_CpuLinearAllocator.CleanupUsedPages(FenceValue);
+    m_GpuLinearAllocator.CleanupUsedPages(FenceValue);
+    m_DynamicViewDescriptorHeap.CleanupUsedHeaps(FenceValue);
+    m_DynamicSamplerDescriptorHeap.CleanupUsedHeaps(FenceValue);
+
+    {
+        std::lock_guard<std::mutex> LockGuard(s_StateStatsMutex);
+        s_StateStats += m_StateStats;
+    }
+    m_StateStats.Reset();
+}
+
 void CommandContext::Initialize(void)
 {
     g_CommandManager.CreateNewCommandList(m_Type, &m_CommandList, &m_CurrentAllocator);
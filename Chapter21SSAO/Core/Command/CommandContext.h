@@ -9,11 +9,13 @@
 #include "LinearAllocator.h"
 #include "DynamicDescriptorHeap.h"
 #include "CubeMapBuffer.h"
+#include "CommandSignature.h"
 
 #include <queue>
 
 class CommandContext;
 class GraphicsContext;
+class ComputeContext;
 class RootSignature;
 
 class PSO;
@@ -61,6 +63,45 @@ private:
 	std::mutex sm_ContextAllocationMutex;
 };
 
+// State setting calls that reached the command list versus those dropped because the same
+// state was already bound. Each context counts its own, Finish folds them into a global total.
+struct StateChangeStats
+{
+	enum StateType { kPipelineState, kPrimitiveTopology, kVertexBuffer, kIndexBuffer, kNumStateTypes };
+
+	uint32_t Issued[kNumStateTypes];
+	uint32_t Skipped[kNumStateTypes];
+
+	// resource barriers, split ones counted by their BEGIN half, and ResourceBarrier calls
+	uint32_t Barriers;
+	uint32_t SplitBarriers;
+	uint32_t BarrierCalls;
+
+	StateChangeStats(void) { Reset(); }
+
+	void Reset(void)
+	{
+		memset(Issued, 0, sizeof(Issued));
+		memset(Skipped, 0, sizeof(Skipped));
+		Barriers = 0;
+		SplitBarriers = 0;
+		BarrierCalls = 0;
+	}
+
+	StateChangeStats& operator+=(const StateChangeStats& rhs)
+	{
+		for (int i = 0; i < kNumStateTypes; ++i)
+		{
+			Issued[i] += rhs.Issued[i];
+			Skipped[i] += rhs.Skipped[i];
+		}
+		Barriers += rhs.Barriers;
+		SplitBarriers += rhs.SplitBarriers;
+		BarrierCalls += rhs.BarrierCalls;
+		return *this;
+	}
+};
+
 struct NonCopyable
 {
 	NonCopyable() = default;
@@ -76,6 +117,9 @@ private:
 	CommandContext(D3D12_COMMAND_LIST_TYPE Type);
 
 	void Reset(void);
+	void Release(uint64_t FenceValue);
+	// forget cached command list state, after the list has been reset
+	void InvalidateCachedState(void);
 
 public:
 	~CommandContext(void);
@@ -90,6 +134,9 @@ public:
 	// Flush existing commands and release the current context
 	uint64_t Finish(bool WaitForCompletion = false);
 
+	// Finish several contexts with a single ExecuteCommandLists, in array order
+	static uint64_t FinishBatch(CommandContext* const Contexts[], UINT NumContexts, bool WaitForCompletion = false);
+
 	// Prepare to render by reserving a command list and command allocator
 	void Initialize(void);
 
@@ -129,15 +176,23 @@ public:
 
 	void FlushResourceBarriers(void);
 
+	// Issues prepared barriers as one call, after any buffered ones. The resources' tracked
+	// states are left alone, see ResourceStateTracker.
+	void ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* Barriers);
+
 	void SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type, ID3D12DescriptorHeap* HeapPtr);
 	void SetDescriptorHeaps(UINT HeapCount, D3D12_DESCRIPTOR_HEAP_TYPE Type[], ID3D12DescriptorHeap* HeapPtrs[]);
 	void SetPipelineState(const PSO& PSO);
 
 	void SetPredication(ID3D12Resource* Buffer, UINT64 BufferOffset, D3D12_PREDICATION_OP Op);
 
+	// Totals of every context finished since the last call
+	static StateChangeStats GetStateChangeStats(bool Reset = true);
+
 protected:
 
 	void BindDescriptorHeaps(void);
+	void CountBarriers(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* Barriers);
 
 	CommandListManager* m_OwningManager;
 	ID3D12GraphicsCommandList* m_CommandList;
@@ -147,6 +202,14 @@ protected:
 	ID3D12RootSignature* m_CurComputeRootSignature;
 	ID3D12PipelineState* m_CurPipelineState;
 
+	// input assembler state last set on the command list
+	static const UINT kMaxCachedVertexBuffers = 4;
+	D3D12_PRIMITIVE_TOPOLOGY m_CurPrimitiveTopology;
+	D3D12_VERTEX_BUFFER_VIEW m_CurVertexBuffers[kMaxCachedVertexBuffers];
+	D3D12_INDEX_BUFFER_VIEW m_CurIndexBuffer;
+
+	StateChangeStats m_StateStats;
+
 	DynamicDescriptorHeap m_DynamicViewDescriptorHeap;		// HEAP_TYPE_CBV_SRV_UAV
 	DynamicDescriptorHeap m_DynamicSamplerDescriptorHeap;	// HEAP_TYPE_SAMPLER
 
@@ -212,8 +275,12 @@ public:
 	void SetDynamicConstantBufferView(UINT RootIndex, size_t BufferSize, const void* BufferData);
 	void SetBufferSRV(UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset = 0);
 	void SetBufferUAV(UINT RootIndex, const GpuBuffer& UAV, UINT64 Offset = 0);
+	void SetShaderResourceView(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS SRV);
 	void SetDescriptorTable(UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE FirstHandle);
 
+	// Binds the bindless heap and points RootIndex, an unbounded SRV range, at its persistent slots
+	void SetBindlessTable(UINT RootIndex);
+
 	void SetDynamicDescriptor(UINT RootIndex, UINT Offset, D3D12_CPU_DESCRIPTOR_HANDLE Handle);
 	void SetDynamicDescriptors(UINT RootIndex, UINT Offset, UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[]);
 	void SetDynamicSampler(UINT RootIndex, UINT Offset, D3D12_CPU_DESCRIPTOR_HANDLE Handle);
@@ -234,6 +301,12 @@ public:
 	void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation,
 		INT BaseVertexLocation, UINT StartInstanceLocation);
 
+	// Up to MaxCommands commands laid out as CommandSig says; with a counter buffer the GPU
+	// reads the actual number from the uint at CounterOffset. Argument buffers must be in
+	// D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT.
+	void ExecuteIndirect(CommandSignature& CommandSig, GpuBuffer& ArgumentBuffer, uint64_t ArgumentStartOffset = 0,
+		uint32_t MaxCommands = 1, GpuBuffer* CommandCounterBuffer = nullptr, uint64_t CounterOffset = 0);
+
 private:
 
 };
@@ -259,6 +332,7 @@ public:
 	void SetDynamicSRV(UINT RootIndex, size_t BufferSize, const void* BufferData);
 	void SetBufferSRV(UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset = 0);
 	void SetBufferUAV(UINT RootIndex, const GpuBuffer& UAV, UINT64 Offset = 0);
+	void SetShaderResourceView(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS SRV);
 	void SetDescriptorTable(UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE FirstHandle);
 
 	void SetDynamicDescriptor(UINT RootIndex, UINT Offset, D3D12_CPU_DESCRIPTOR_HANDLE Handle);
@@ -305,6 +379,16 @@ inline void GraphicsContext::DrawIndexedInstanced(UINT IndexCountPerInstance, UI
 	m_DynamicSamplerDescriptorHeap.CommitGraphicsRootDescriptorTables(m_CommandList);
 	m_CommandList->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
 }
+
+inline void GraphicsContext::ExecuteIndirect(CommandSignature& CommandSig, GpuBuffer& ArgumentBuffer, uint64_t ArgumentStartOffset,
+	uint32_t MaxCommands, GpuBuffer* CommandCounterBuffer, uint64_t CounterOffset)
+{
+	FlushResourceBarriers();
+	m_DynamicViewDescriptorHeap.CommitGraphicsRootDescriptorTables(m_CommandList);
+	m_DynamicSamplerDescriptorHeap.CommitGraphicsRootDescriptorTables(m_CommandList);
+	m_CommandList->ExecuteIndirect(CommandSig.GetSignature(), MaxCommands, ArgumentBuffer.GetResource(), ArgumentStartOffset,
+		CommandCounterBuffer == nullptr ? nullptr : CommandCounterBuffer->GetResource(), CounterOffset);
+}
 inline void GraphicsContext::SetVertexBuffer(UINT Slot, const D3D12_VERTEX_BUFFER_VIEW& VBView)
 {
 	SetVertexBuffers(Slot, 1, &VBView);
@@ -312,17 +396,41 @@ inline void GraphicsContext::SetVertexBuffer(UINT Slot, const D3D12_VERTEX_BUFFE
 
 inline void GraphicsContext::SetVertexBuffers(UINT StartSlot, UINT Count, const D3D12_VERTEX_BUFFER_VIEW VBViews[])
 {
+	bool Cached = StartSlot + Count <= kMaxCachedVertexBuffers;
+	if (Cached && memcmp(&m_CurVertexBuffers[StartSlot], VBViews, Count * sizeof(D3D12_VERTEX_BUFFER_VIEW)) == 0)
+	{
+		m_StateStats.Skipped[StateChangeStats::kVertexBuffer]++;
+		return;
+	}
+
+	for (UINT i = 0; i < Count && StartSlot + i < kMaxCachedVertexBuffers; ++i)
+		m_CurVertexBuffers[StartSlot + i] = VBViews[i];
+
 	m_CommandList->IASetVertexBuffers(StartSlot, Count, VBViews);
+	m_StateStats.Issued[StateChangeStats::kVertexBuffer]++;
 }
 
 inline void GraphicsContext::SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& IBView)
 {
-	m_CommandList->IASetIndexBuffer(&IBView);
+	SetIndexBuffer(&IBView);
 }
 
 inline void GraphicsContext::SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW IBView[])
 {
+	// nullptr unbinds, which the cache records as an all zero view
+	D3D12_INDEX_BUFFER_VIEW NewView = {};
+	if (IBView != nullptr)
+		NewView = *IBView;
+
+	if (memcmp(&m_CurIndexBuffer, &NewView, sizeof(NewView)) == 0)
+	{
+		m_StateStats.Skipped[StateChangeStats::kIndexBuffer]++;
+		return;
+	}
+
+	m_CurIndexBuffer = NewView;
 	m_CommandList->IASetIndexBuffer(IBView);
+	m_StateStats.Issued[StateChangeStats::kIndexBuffer]++;
 }
 
 inline void GraphicsContext::SetDescriptorTable(UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE FirstHandle)
@@ -330,6 +438,12 @@ inline void GraphicsContext::SetDescriptorTable(UINT RootIndex, D3D12_GPU_DESCRI
 	m_CommandList->SetGraphicsRootDescriptorTable(RootIndex, FirstHandle);
 }
 
+inline void GraphicsContext::SetBindlessTable(UINT RootIndex)
+{
+	SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, Graphics::g_BindlessHeap.GetHeapPointer());
+	m_CommandList->SetGraphicsRootDescriptorTable(RootIndex, Graphics::g_BindlessHeap.GetTableStart());
+}
+
 inline void GraphicsContext::SetDynamicSamplers(UINT RootIndex, UINT Offset, UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[])
 {
 	m_DynamicSamplerDescriptorHeap.SetGraphicsDescriptorHandles(RootIndex, Offset, Count, Handles);
@@ -358,6 +472,11 @@ inline void GraphicsContext::SetBufferUAV(UINT RootIndex, const GpuBuffer& UAV,
 	m_CommandList->SetGraphicsRootUnorderedAccessView(RootIndex, UAV.GetGpuVirtualAddress() + Offset);
 }
 
+inline void GraphicsContext::SetShaderResourceView(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS SRV)
+{
+	m_CommandList->SetGraphicsRootShaderResourceView(RootIndex, SRV);
+}
+
 inline void GraphicsContext::SetBufferSRV(UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset)
 {
 	ASSERT((SRV.m_UsageState & (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) != 0);
@@ -378,7 +497,7 @@ inline void GraphicsContext::SetDynamicVB(UINT Slot, size_t NumVertices, size_t
 	VBView.SizeInBytes = (UINT)BufferSize;
 	VBView.StrideInBytes = (UINT)VertexStride;
 
-	m_CommandList->IASetVertexBuffers(Slot, 1, &VBView);
+	SetVertexBuffer(Slot, VBView);
 }
 
 inline void GraphicsContext::SetDynamicIB(size_t IndexCount, const uint16_t* IndexData)
@@ -395,7 +514,7 @@ inline void GraphicsContext::SetDynamicIB(size_t IndexCount, const uint16_t* Ind
 	IBView.SizeInBytes = (UINT)(IndexCount * sizeof(uint16_t));
 	IBView.Format = DXGI_FORMAT_R16_UINT;
 
-	m_CommandList->IASetIndexBuffer(&IBView);
+	SetIndexBuffer(IBView);
 }
 
 inline void GraphicsContext::SetDynamicSRV(UINT RootIndex, size_t BufferSize, const void* BufferData)
@@ -471,7 +590,15 @@ inline void GraphicsContext::SetBlendFactor(Color BlendFactor)
 
 inline void GraphicsContext::SetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY Topology)
 {
+	if (Topology == m_CurPrimitiveTopology)
+	{
+		m_StateStats.Skipped[StateChangeStats::kPrimitiveTopology]++;
+		return;
+	}
+
+	m_CurPrimitiveTopology = Topology;
 	m_CommandList->IASetPrimitiveTopology(Topology);
+	m_StateStats.Issued[StateChangeStats::kPrimitiveTopology]++;
 }
 
 inline void ComputeContext::SetRootSignature(const RootSignature& RootSig)
@@ -555,6 +682,11 @@ inline void ComputeContext::SetBufferUAV(UINT RootIndex, const GpuBuffer& UAV, U
 	m_CommandList->SetComputeRootUnorderedAccessView(RootIndex, UAV.GetGpuVirtualAddress() + Offset);
 }
 
+inline void ComputeContext::SetShaderResourceView(UINT RootIndex, D3D12_GPU_VIRTUAL_ADDRESS SRV)
+{
+	m_CommandList->SetComputeRootShaderResourceView(RootIndex, SRV);
+}
+
 inline void ComputeContext::Dispatch(size_t GroupCountX, size_t GroupCountY, size_t GroupCountZ)
 {
 	FlushResourceBarriers();
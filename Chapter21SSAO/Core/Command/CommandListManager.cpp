@@ -1,12 +1,12 @@
 #include "CommandListManager.h"
 #include "CommandAllocatorPool.h"
 #include "GraphicsCore.h"
+#include "Fence.h"
 
 CommandQueue::CommandQueue(D3D12_COMMAND_LIST_TYPE Type) :
 	m_Type(Type),
 	m_AllocatorPool(Type),
 	m_CommandQueue(nullptr),
-	m_pFence(nullptr),
 	m_NextFenceValue((uint64_t)Type << 56 | 1),
 	m_LastCompletedFenceValue((uint64_t)Type << 56)
 {
@@ -32,13 +32,7 @@ void CommandQueue::Create(ID3D12Device* pDevice)
 	m_CommandQueue->SetName(L"CommandListManager::m_CommandQueue");
 
 	// create Fence
-	ASSERT_SUCCEEDED(pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, MY_IID_PPV_ARGS(&m_pFence)));
-	m_pFence->SetName(L"CommandListManager::m_pFence");
-
-	m_pFence->Signal((uint64_t)m_Type << 56);
-	// create event for fence to synchronize
-	m_FenceEventHandle = CreateEvent(nullptr, false, false, nullptr);
-	ASSERT(m_FenceEventHandle != NULL);
+	m_Fence.reset(new D3D12Fence(pDevice, m_CommandQueue, (uint64_t)m_Type << 56));
 
 	// create allocator for commandList
 	m_AllocatorPool.Create(pDevice);
@@ -49,15 +43,12 @@ void CommandQueue::Create(ID3D12Device* pDevice)
 
 void CommandQueue::ShutDown()
 {
-	if (m_CommandQueue == nullptr)
+	if (m_Fence == nullptr)
 		return;
 
 	m_AllocatorPool.Shutdown();
 
-	CloseHandle(m_FenceEventHandle);
-
-	m_pFence->Release();
-	m_pFence = nullptr;
+	m_Fence.reset();
 
 	m_CommandQueue->Release();
 	m_CommandQueue = nullptr;
@@ -66,28 +57,38 @@ void CommandQueue::ShutDown()
 uint64_t CommandQueue::IncrementFence(void)
 {
 	std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
-	m_CommandQueue->Signal(m_pFence, m_NextFenceValue);
+	m_Fence->Signal(m_NextFenceValue);
 	return m_NextFenceValue++;
 }
 
 bool CommandQueue::IsFenceComplete(uint64_t FenceValue)
 {
-	if (FenceValue > m_LastCompletedFenceValue)
-		m_LastCompletedFenceValue = std::max(m_LastCompletedFenceValue, m_pFence->GetCompletedValue());
+	if (FenceValue > m_LastCompletedFenceValue.load(std::memory_order_acquire))
+		UpdateCompletedFenceValue(m_Fence->GetCompletedValue());
 
-	return FenceValue <= m_LastCompletedFenceValue;
+	return FenceValue <= m_LastCompletedFenceValue.load(std::memory_order_acquire);
+}
+
+void CommandQueue::UpdateCompletedFenceValue(uint64_t CompletedValue)
+{
+	// several recording threads poll fences concurrently, never move the cached value backwards
+	uint64_t Cached = m_LastCompletedFenceValue.load(std::memory_order_relaxed);
+	while (Cached < CompletedValue &&
+		!m_LastCompletedFenceValue.compare_exchange_weak(Cached, CompletedValue, std::memory_order_acq_rel))
+	{
+	}
 }
 
 void CommandQueue::StallForFence(uint64_t FenceValue)
 {
 	CommandQueue& Producer = Graphics::g_CommandManager.GetQueue((D3D12_COMMAND_LIST_TYPE)(FenceValue >> 56));
-	m_CommandQueue->Wait(Producer.m_pFence, FenceValue);
+	m_CommandQueue->Wait(Producer.m_Fence->GetNativeFence(), FenceValue);
 }
 
 void CommandQueue::StallForProducer(CommandQueue& Producer)
 {
 	ASSERT(Producer.m_NextFenceValue > 0);
-	m_CommandQueue->Wait(Producer.m_pFence, Producer.m_NextFenceValue - 1);
+	m_CommandQueue->Wait(Producer.m_Fence->GetNativeFence(), Producer.m_NextFenceValue - 1);
 }
 
 void CommandQueue::WaitForFence(uint64_t FenceValue)
@@ -95,13 +96,8 @@ void CommandQueue::WaitForFence(uint64_t FenceValue)
 	if (IsFenceComplete(FenceValue))
 		return;
 
-	{
-		std::lock_guard<std::mutex> LockGuard(m_EventMutex);
-
-		m_pFence->SetEventOnCompletion(FenceValue, m_FenceEventHandle);
-		WaitForSingleObject(m_FenceEventHandle, INFINITE);
-		m_LastCompletedFenceValue = FenceValue;
-	}
+	m_Fence->WaitForValue(FenceValue);
+	UpdateCompletedFenceValue(FenceValue);
 }
 
 uint64_t CommandQueue::ExecuteCommandList(ID3D12CommandList* List)
@@ -111,7 +107,23 @@ uint64_t CommandQueue::ExecuteCommandList(ID3D12CommandList* List)
 	ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)List)->Close());
 
 	m_CommandQueue->ExecuteCommandLists(1, &List);
-	m_CommandQueue->Signal(m_pFence, m_NextFenceValue);
+	m_Fence->Signal(m_NextFenceValue);
+
+	return m_NextFenceValue++;
+}
+
+uint64_t CommandQueue::ExecuteCommandLists(UINT NumLists, ID3D12CommandList* const* Lists)
+{
+	ASSERT(NumLists > 0);
+
+	std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
+
+	for (UINT i = 0; i < NumLists; ++i)
+		ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)Lists[i])->Close());
+
+	// one submission, executed in array order, signaled once
+	m_CommandQueue->ExecuteCommandLists(NumLists, Lists);
+	m_Fence->Signal(m_NextFenceValue);
 
 	return m_NextFenceValue++;
 }
@@ -119,7 +131,7 @@ uint64_t CommandQueue::ExecuteCommandList(ID3D12CommandList* List)
 ID3D12CommandAllocator* CommandQueue::RequestAllocator(void)
 {
 	// request current fence value
-	uint64_t CompletedFence = m_pFence->GetCompletedValue();
+	uint64_t CompletedFence = m_Fence->GetCompletedValue();
 
 	return m_AllocatorPool.RequestAllocator(CompletedFence);;
 }
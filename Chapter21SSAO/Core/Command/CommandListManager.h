@@ -1,6 +1,10 @@
 #pragma once
 #include "pch.h"
 #include "CommandAllocatorPool.h"
+#include <memory>
+#include <atomic>
+
+class Fence;
 
 class CommandQueue
 {
@@ -16,7 +20,7 @@ public:
 
 	inline bool IsReady()
 	{
-		return m_CommandQueue != nullptr;
+		return m_Fence != nullptr;
 	}
 
 	// Synchronize CPU and GPU
@@ -28,11 +32,19 @@ public:
 	void WaitForIdle(void) { WaitForFence(IncrementFence()); }
 
 	ID3D12CommandQueue* GetCommandQueue() { return m_CommandQueue; }
+	Fence* GetFence() { return m_Fence.get(); }
 
-	uint64_t GetNextFenceValue() { return m_NextFenceValue; }
+	// Read under the fence mutex, other threads may be submitting
+	uint64_t GetNextFenceValue()
+	{
+		std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
+		return m_NextFenceValue;
+	}
 private:
 
 	uint64_t ExecuteCommandList(ID3D12CommandList* List);
+	uint64_t ExecuteCommandLists(UINT NumLists, ID3D12CommandList* const* Lists);
+	void UpdateCompletedFenceValue(uint64_t CompletedValue);
 	ID3D12CommandAllocator* RequestAllocator(void);
 	void DiscardAllocator(uint64_t FenceValueForReset, ID3D12CommandAllocator* Allocator);
 
@@ -40,14 +52,12 @@ private:
 
 	CommandAllocatorPool m_AllocatorPool;
 	std::mutex m_FenceMutex;
-	std::mutex m_EventMutex;
 
 	ID3D12CommandQueue* m_CommandQueue;
 
-	ID3D12Fence* m_pFence;
+	std::unique_ptr<Fence> m_Fence;
 	uint64_t m_NextFenceValue;
-	uint64_t m_LastCompletedFenceValue;
-	HANDLE m_FenceEventHandle;
+	std::atomic<uint64_t> m_LastCompletedFenceValue;
 };
 
 class CommandListManager
@@ -0,0 +1,65 @@
+#include "CommandSignature.h"
+#include "RootSignature.h"
+#include "GraphicsCore.h"
+
+using namespace Graphics;
+
+void CommandSignature::Finalize(const RootSignature* RootSignature, UINT ByteStride)
+{
+    if (m_Finalized)
+        return;
+
+    UINT Stride = 0;
+    bool RequiresRootSignature = false;
+
+    for (UINT i = 0; i < m_NumParameters; ++i)
+    {
+        switch (m_ParamArray[i].GetDesc().Type)
+        {
+        case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW:
+            Stride += sizeof(D3D12_DRAW_ARGUMENTS);
+            break;
+        case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED:
+            Stride += sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+            break;
+        case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH:
+            Stride += sizeof(D3D12_DISPATCH_ARGUMENTS);
+            break;
+        case D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW:
+            Stride += sizeof(D3D12_VERTEX_BUFFER_VIEW);
+            break;
+        case D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW:
+            Stride += sizeof(D3D12_INDEX_BUFFER_VIEW);
+            break;
+        case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT:
+            Stride += m_ParamArray[i].GetDesc().Constant.Num32BitValuesToSet * 4;
+            RequiresRootSignature = true;
+            break;
+        case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW:
+        case D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW:
+        case D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW:
+            Stride += 8; // a GPU virtual address
+            RequiresRootSignature = true;
+            break;
+        }
+    }
+
+    D3D12_COMMAND_SIGNATURE_DESC CommandSignatureDesc;
+    CommandSignatureDesc.ByteStride = ByteStride != 0 ? ByteStride : Stride;
+    CommandSignatureDesc.NumArgumentDescs = m_NumParameters;
+    // IndirectParameter only wraps the desc, the array can be handed over as it is
+    CommandSignatureDesc.pArgumentDescs = (const D3D12_INDIRECT_ARGUMENT_DESC*)m_ParamArray.get();
+    CommandSignatureDesc.NodeMask = 1;
+
+    ID3D12RootSignature* pRootSig = nullptr;
+    if (RequiresRootSignature)
+    {
+        ASSERT(RootSignature != nullptr);
+        pRootSig = RootSignature->GetSignature();
+    }
+
+    ASSERT_SUCCEEDED(g_Device->CreateCommandSignature(&CommandSignatureDesc, pRootSig, MY_IID_PPV_ARGS(&m_Signature)));
+    m_Signature->SetName(L"CommandSignature");
+
+    m_Finalized = TRUE;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "pch.h"
+
+class RootSignature;
+
+// One argument of an indirect command
+class IndirectParameter
+{
+    friend class CommandSignature;
+
+public:
+    IndirectParameter()
+    {
+        m_IndirectParam.Type = (D3D12_INDIRECT_ARGUMENT_TYPE)0xFFFFFFFF;
+    }
+
+    void Draw(void)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+    }
+
+    void DrawIndexed(void)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+    }
+
+    void Dispatch(void)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+    }
+
+    void VertexBufferView(UINT Slot)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+        m_IndirectParam.VertexBuffer.Slot = Slot;
+    }
+
+    void IndexBufferView(void)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+    }
+
+    // root constants, they need the root signature at Finalize
+    void Constant(UINT RootParameterIndex, UINT DestOffsetIn32BitValues, UINT Num32BitValuesToSet)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        m_IndirectParam.Constant.RootParameterIndex = RootParameterIndex;
+        m_IndirectParam.Constant.DestOffsetIn32BitValues = DestOffsetIn32BitValues;
+        m_IndirectParam.Constant.Num32BitValuesToSet = Num32BitValuesToSet;
+    }
+
+    void ConstantBufferView(UINT RootParameterIndex)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW;
+        m_IndirectParam.ConstantBufferView.RootParameterIndex = RootParameterIndex;
+    }
+
+    void ShaderResourceView(UINT RootParameterIndex)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW;
+        m_IndirectParam.ShaderResourceView.RootParameterIndex = RootParameterIndex;
+    }
+
+    void UnorderedAccessView(UINT RootParameterIndex)
+    {
+        m_IndirectParam.Type = D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW;
+        m_IndirectParam.UnorderedAccessView.RootParameterIndex = RootParameterIndex;
+    }
+
+    const D3D12_INDIRECT_ARGUMENT_DESC& GetDesc(void) const { return m_IndirectParam; }
+
+protected:
+
+    D3D12_INDIRECT_ARGUMENT_DESC m_IndirectParam;
+};
+
+// Layout of the commands ExecuteIndirect reads from an argument buffer. The draw or dispatch
+// has to be the last parameter; the byte stride is the sum of the parameters unless given.
+class CommandSignature
+{
+public:
+
+    CommandSignature(UINT NumParams = 0) : m_Finalized(FALSE), m_NumParameters(NumParams)
+    {
+        Reset(NumParams);
+    }
+
+    void Destroy(void)
+    {
+        m_Signature = nullptr;
+        m_ParamArray = nullptr;
+    }
+
+    void Reset(UINT NumParams)
+    {
+        if (NumParams > 0)
+            m_ParamArray.reset(new IndirectParameter[NumParams]);
+        else
+            m_ParamArray = nullptr;
+
+        m_NumParameters = NumParams;
+    }
+
+    IndirectParameter& operator[](size_t EntryIndex)
+    {
+        ASSERT(EntryIndex < m_NumParameters);
+        return m_ParamArray.get()[EntryIndex];
+    }
+
+    const IndirectParameter& operator[](size_t EntryIndex) const
+    {
+        ASSERT(EntryIndex < m_NumParameters);
+        return m_ParamArray.get()[EntryIndex];
+    }
+
+    // RootSignature is required when a parameter changes root arguments
+    void Finalize(const RootSignature* RootSignature = nullptr, UINT ByteStride = 0);
+
+    ID3D12CommandSignature* GetSignature() const { return m_Signature.Get(); }
+
+protected:
+
+    BOOL m_Finalized;
+    UINT m_NumParameters;
+    std::unique_ptr<IndirectParameter[]> m_ParamArray;
+    Microsoft::WRL::ComPtr<ID3D12CommandSignature> m_Signature;
+};
@@ -0,0 +1,41 @@
+#include "Fence.h"
+
+D3D12Fence::D3D12Fence(ID3D12Device* pDevice, ID3D12CommandQueue* pQueue, uint64_t InitialValue) :
+	m_pQueue(pQueue),
+	m_pFence(nullptr)
+{
+	ASSERT_SUCCEEDED(pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, MY_IID_PPV_ARGS(&m_pFence)));
+	m_pFence->SetName(L"CommandListManager::m_pFence");
+
+	m_pFence->Signal(InitialValue);
+
+	// create event for fence to synchronize
+	m_FenceEventHandle = CreateEvent(nullptr, false, false, nullptr);
+	ASSERT(m_FenceEventHandle != NULL);
+}
+
+D3D12Fence::~D3D12Fence()
+{
+	CloseHandle(m_FenceEventHandle);
+
+	m_pFence->Release();
+	m_pFence = nullptr;
+}
+
+uint64_t D3D12Fence::GetCompletedValue(void)
+{
+	return m_pFence->GetCompletedValue();
+}
+
+void D3D12Fence::Signal(uint64_t Value)
+{
+	m_pQueue->Signal(m_pFence, Value);
+}
+
+void D3D12Fence::WaitForValue(uint64_t Value)
+{
+	std::lock_guard<std::mutex> LockGuard(m_EventMutex);
+
+	m_pFence->SetEventOnCompletion(Value, m_FenceEventHandle);
+	WaitForSingleObject(m_FenceEventHandle, INFINITE);
+}
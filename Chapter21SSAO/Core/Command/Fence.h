@@ -0,0 +1,44 @@
+#pragma once
+
+#include "pch.h"
+#include <mutex>
+
+// The part of a GPU fence the engine's recycling logic depends on: command allocators,
+// linear allocator pages and descriptor heaps are all retired against a fence value and
+// reused once it completes. CommandQueue talks to this interface, so the same bookkeeping
+// runs against a real ID3D12Fence or, in the headless tests, a CPU-only NullFence.
+class Fence
+{
+public:
+	virtual ~Fence() {}
+
+	virtual uint64_t GetCompletedValue(void) = 0;
+
+	// Queue-side signal, issued after the work it tracks has been submitted
+	virtual void Signal(uint64_t Value) = 0;
+
+	// Blocks the calling thread until Value has completed
+	virtual void WaitForValue(uint64_t Value) = 0;
+
+	// The underlying D3D12 fence for GPU-side waits, nullptr for headless fences
+	virtual ID3D12Fence* GetNativeFence(void) { return nullptr; }
+};
+
+class D3D12Fence : public Fence
+{
+public:
+	D3D12Fence(ID3D12Device* pDevice, ID3D12CommandQueue* pQueue, uint64_t InitialValue);
+	~D3D12Fence();
+
+	virtual uint64_t GetCompletedValue(void) override;
+	virtual void Signal(uint64_t Value) override;
+	virtual void WaitForValue(uint64_t Value) override;
+	virtual ID3D12Fence* GetNativeFence(void) override { return m_pFence; }
+
+private:
+	ID3D12CommandQueue* m_pQueue;
+	ID3D12Fence* m_pFence;
+
+	std::mutex m_EventMutex;
+	HANDLE m_FenceEventHandle;
+};
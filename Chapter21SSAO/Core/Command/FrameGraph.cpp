@@ -0,0 +1,83 @@
+#include "pch.h"
+#include "FrameGraph.h"
+#include "ThreadPool.h"
+#include <chrono>
+
+FrameGraph::Pass& FrameGraph::AddPass(const std::wstring& Name, RecordFunc Record)
+{
+	ASSERT(m_Passes.size() < 64, "Exceeded the number of contexts CommandContext::FinishBatch accepts");
+
+	m_Passes.emplace_back(new Pass);
+	Pass& NewPass = *m_Passes.back();
+	NewPass.m_Name = Name;
+	NewPass.m_Record = std::move(Record);
+	return NewPass;
+}
+
+void FrameGraph::ResolveBarriers(void)
+{
+	m_Tracker.Reset();
+
+	for (uint32_t i = 0; i < (uint32_t)m_Passes.size(); ++i)
+	{
+		// every pass records into a list of its own
+		m_Tracker.AddPass(i);
+
+		for (auto& D : m_Passes[i]->m_Declarations)
+		{
+			if (D.Type == Pass::kRead)
+				m_Tracker.Read(*D.Resource, D.State);
+			else if (D.Type == Pass::kWrite)
+				m_Tracker.Write(*D.Resource, D.State);
+			else
+				m_Tracker.Leave(*D.Resource, D.State);
+		}
+	}
+
+	m_Tracker.Solve();
+}
+
+uint64_t FrameGraph::Execute(bool Parallel)
+{
+	if (m_Passes.empty())
+		return 0;
+
+	ResolveBarriers();
+
+	auto Start = std::chrono::high_resolution_clock::now();
+
+	const int NumPasses = (int)m_Passes.size();
+	std::vector<CommandContext*> Contexts(NumPasses, nullptr);
+
+	auto RecordPass = [&](int i)
+	{
+		Pass& P = *m_Passes[i];
+
+		// ContextManager and the allocator pools are locked, contexts can be taken from any thread
+		GraphicsContext& Context = GraphicsContext::Begin(P.m_Name);
+
+		m_Tracker.IssueBarriers(Context, i);
+
+		P.m_Record(Context);
+
+		Context.FlushResourceBarriers();
+		if (i == NumPasses - 1)
+			m_Tracker.IssueBarriers(Context, NumPasses);
+
+		Contexts[i] = &Context;
+	};
+
+	if (Parallel)
+		ThreadPool::ParallelFor(0, NumPasses, RecordPass);
+	else
+	{
+		for (int i = 0; i < NumPasses; ++i)
+			RecordPass(i);
+	}
+
+	uint64_t FenceValue = CommandContext::FinishBatch(Contexts.data(), (UINT)NumPasses);
+
+	m_LastRecordTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Start).count();
+
+	return FenceValue;
+}
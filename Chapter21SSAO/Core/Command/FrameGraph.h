@@ -0,0 +1,86 @@
+#pragma once
+
+#include "pch.h"
+#include "CommandContext.h"
+#include "ResourceStateTracker.h"
+#include <functional>
+#include <vector>
+#include <string>
+
+// Records the passes of a frame into separate GraphicsContexts, in parallel on the ThreadPool,
+// and submits all of them with one ExecuteCommandLists in the order they were added.
+//
+// Passes run concurrently, so they must not call TransitionResource on anything another pass
+// touches: GpuResource::m_UsageState is shared. Instead each pass declares what it reads and
+// writes, and Leave gives the state a resource must be in once the whole graph is done.
+// Execute hands those to a ResourceStateTracker on the calling thread, before any recording
+// starts, and every pass opens with the barriers it needs in a single call.
+class FrameGraph
+{
+public:
+	typedef std::function<void(GraphicsContext&)> RecordFunc;
+
+	class Pass
+	{
+		friend class FrameGraph;
+
+	public:
+		Pass& Read(GpuResource& Resource, D3D12_RESOURCE_STATES State)
+		{
+			m_Declarations.push_back({ &Resource, State, kRead });
+			return *this;
+		}
+
+		Pass& Write(GpuResource& Resource, D3D12_RESOURCE_STATES State)
+		{
+			m_Declarations.push_back({ &Resource, State, kWrite });
+			return *this;
+		}
+
+		// State after the last pass of the graph, whichever pass declares it
+		Pass& Leave(GpuResource& Resource, D3D12_RESOURCE_STATES State)
+		{
+			m_Declarations.push_back({ &Resource, State, kLeave });
+			return *this;
+		}
+
+	private:
+		enum DeclarationType { kRead, kWrite, kLeave };
+
+		struct Declaration
+		{
+			GpuResource* Resource;
+			D3D12_RESOURCE_STATES State;
+			DeclarationType Type;
+		};
+
+		std::wstring m_Name;
+		RecordFunc m_Record;
+		std::vector<Declaration> m_Declarations;
+	};
+
+	// Passes are submitted in the order they are added, which must respect their dependencies.
+	Pass& AddPass(const std::wstring& Name, RecordFunc Record);
+
+	// Records every pass and submits them as one batch. Returns the fence of the batch.
+	// With Parallel false everything is recorded on the calling thread, same lists, same order.
+	uint64_t Execute(bool Parallel = true);
+
+	void Reset(void) { m_Passes.clear(); }
+
+	size_t GetPassCount(void) const { return m_Passes.size(); }
+
+	// CPU time spent recording in the last Execute, from the first context allocated to submission
+	double GetLastRecordTimeMs(void) const { return m_LastRecordTimeMs; }
+
+	// Barriers the last Execute needed
+	const BarrierSolver::Stats& GetLastBarrierStats(void) const { return m_Tracker.GetStats(); }
+
+private:
+	void ResolveBarriers(void);
+
+	// std::vector would move passes while a caller still holds the reference AddPass returned
+	std::vector<std::unique_ptr<Pass>> m_Passes;
+	ResourceStateTracker m_Tracker;
+	double m_LastRecordTimeMs = 0.0;
+};
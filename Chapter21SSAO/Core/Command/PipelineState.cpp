@@ -1,23 +1,38 @@
 #include "PipelineState.h"
 #include "GraphicsCore.h"
 #include "RootSignature.h"
-#include "Hash.h"
-
-#include <mutex>
-#include <map>
+#include "PipelineStateCache.h"
 
 using Math::IsAligned;
 using namespace Graphics;
 using Microsoft::WRL::ComPtr;
 using namespace std;
-static map< size_t, ComPtr<ID3D12PipelineState> > s_GraphicsPSOHashMap;
-static map< size_t, ComPtr<ID3D12PipelineState> > s_ComputePSOHashMap;
+static PSOCache s_GraphicsPSOCache;
+static PSOCache s_ComputePSOCache;
 
+static void PrintCacheStats(const char* Kind, const PSOCacheStats& Stats)
+{
+	Utility::Printf("%s PSO cache: %llu compiled in %.1f ms, %llu hits (%llu waited), %llu hash collisions\n",
+		Kind, Stats.Misses, Stats.CompileMs, Stats.Hits, Stats.Waits, Stats.Collisions);
+}
 
 void PSO::DesytroyAll(void)
 {
-	s_GraphicsPSOHashMap.clear();
-	s_ComputePSOHashMap.clear();
+	PrintCacheStats("Graphics", s_GraphicsPSOCache.GetStats());
+	PrintCacheStats("Compute", s_ComputePSOCache.GetStats());
+
+	s_GraphicsPSOCache.Clear();
+	s_ComputePSOCache.Clear();
+}
+
+PSOCacheStats PSO::GetGraphicsCacheStats(void)
+{
+	return s_GraphicsPSOCache.GetStats();
+}
+
+PSOCacheStats PSO::GetComputeCacheStats(void)
+{
+	return s_ComputePSOCache.GetStats();
 }
 
 GraphicsPSO::GraphicsPSO(const wchar_t* Name)
@@ -98,7 +113,9 @@ void GraphicsPSO::SetInputLayout(UINT NumElements, const D3D12_INPUT_ELEMENT_DES
 	{
 		D3D12_INPUT_ELEMENT_DESC* NewElements = (D3D12_INPUT_ELEMENT_DESC*)malloc(sizeof(D3D12_INPUT_ELEMENT_DESC) * NumElements);
 		memcpy(NewElements, pInputElementDescs, NumElements * sizeof(D3D12_INPUT_ELEMENT_DESC));
-		m_InputLayouts.reset((const D3D12_INPUT_ELEMENT_DESC*)NewElements);
+		// allocated with malloc, so it is freed with free
+		m_InputLayouts.reset((const D3D12_INPUT_ELEMENT_DESC*)NewElements,
+			[](const D3D12_INPUT_ELEMENT_DESC* Elements) { free(const_cast<D3D12_INPUT_ELEMENT_DESC*>(Elements)); });
 	}
 	else
 		m_InputLayouts = nullptr;
@@ -110,41 +127,34 @@ void GraphicsPSO::Finalize()
 	m_PSODesc.pRootSignature = m_RootSignature->GetSignature();
 	ASSERT(m_PSODesc.pRootSignature != nullptr);
 
-	m_PSODesc.InputLayout.pInputElementDescs = nullptr;
-	size_t HashCode = Utility::HashState(&m_PSODesc);
-	HashCode = Utility::HashState(m_InputLayouts.get(), m_PSODesc.InputLayout.NumElements, HashCode);
 	m_PSODesc.InputLayout.pInputElementDescs = m_InputLayouts.get();
-
-	ID3D12PipelineState** PSORef = nullptr;
-	bool firstCompile = false;
-	{
-		static mutex s_HashMapMutex;
-		lock_guard<mutex> CS(s_HashMapMutex);
-		auto iter = s_GraphicsPSOHashMap.find(HashCode);
-
-		if (iter == s_GraphicsPSOHashMap.end())
-		{
-			firstCompile = true;
-			PSORef = s_GraphicsPSOHashMap[HashCode].GetAddressOf();
-		}
-		else
-			PSORef = iter->second.GetAddressOf();
-	}
-	
-	if (firstCompile)
+	ASSERT(m_PSODesc.StreamOutput.NumEntries == 0 && m_PSODesc.StreamOutput.NumStrides == 0, "Stream output is not part of the PSO key");
+
+	// copied bytewise so the padding, zeroed in the constructor, stays zero
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC Flat;
+	memcpy(&Flat, &m_PSODesc, sizeof(Flat));
+	Flat.VS = Flat.PS = Flat.DS = Flat.HS = Flat.GS = D3D12_SHADER_BYTECODE{};
+	Flat.InputLayout.pInputElementDescs = nullptr;
+	Flat.CachedPSO = D3D12_CACHED_PIPELINE_STATE{};
+
+	PSOKey Key;
+	Key.AppendDesc(Flat);
+	Key.AppendInputLayout(m_PSODesc.InputLayout);
+	Key.AppendBytecode(m_PSODesc.VS);
+	Key.AppendBytecode(m_PSODesc.PS);
+	Key.AppendBytecode(m_PSODesc.DS);
+	Key.AppendBytecode(m_PSODesc.HS);
+	Key.AppendBytecode(m_PSODesc.GS);
+	Key.Finalize();
+
+	m_PSO = s_GraphicsPSOCache.FindOrCreate(std::move(Key), [this]
 	{
 		//ASSERT(m_PSODesc.DepthStencilState.DepthEnable != (m_PSODesc.DSVFormat == DXGI_FORMAT_UNKNOWN));
-		ASSERT_SUCCEEDED(g_Device->CreateGraphicsPipelineState(&m_PSODesc, MY_IID_PPV_ARGS(&m_PSO)));
-		s_GraphicsPSOHashMap[HashCode].Attach(m_PSO);
-		m_PSO->SetName(m_Name);
-	}
-	else
-	{
-		while (*PSORef == nullptr)
-			this_thread::yield();
-		m_PSO = *PSORef;
-	}
-
+		ID3D12PipelineState* NewPSO = nullptr;
+		ASSERT_SUCCEEDED(g_Device->CreateGraphicsPipelineState(&m_PSODesc, MY_IID_PPV_ARGS(&NewPSO)));
+		NewPSO->SetName(m_Name);
+		return NewPSO;
+	});
 }
 
 ComputePSO::ComputePSO(const wchar_t* Name)
@@ -160,35 +170,21 @@ void ComputePSO::Finalize()
 	m_PSODesc.pRootSignature = m_RootSignature->GetSignature();
 	ASSERT(m_PSODesc.pRootSignature != nullptr);
 
-	size_t HashCode = Utility::HashState(&m_PSODesc);
+	D3D12_COMPUTE_PIPELINE_STATE_DESC Flat;
+	memcpy(&Flat, &m_PSODesc, sizeof(Flat));
+	Flat.CS = D3D12_SHADER_BYTECODE{};
+	Flat.CachedPSO = D3D12_CACHED_PIPELINE_STATE{};
 
-	ID3D12PipelineState** PSORef = nullptr;
-	bool firstCompile = false;
-	{
-		static mutex s_HashMapMutex;
-		lock_guard<mutex> CS(s_HashMapMutex);
-		auto iter = s_ComputePSOHashMap.find(HashCode);
-
-		// Reserve space so the next inquiry will find that someone got here first.
-		if (iter == s_ComputePSOHashMap.end())
-		{
-			firstCompile = true;
-			PSORef = s_ComputePSOHashMap[HashCode].GetAddressOf();
-		}
-		else
-			PSORef = iter->second.GetAddressOf();
-	}
+	PSOKey Key;
+	Key.AppendDesc(Flat);
+	Key.AppendBytecode(m_PSODesc.CS);
+	Key.Finalize();
 
-	if (firstCompile)
-	{
-		ASSERT_SUCCEEDED(g_Device->CreateComputePipelineState(&m_PSODesc, MY_IID_PPV_ARGS(&m_PSO)));
-		s_ComputePSOHashMap[HashCode].Attach(m_PSO);
-		m_PSO->SetName(m_Name);
-	}
-	else
+	m_PSO = s_ComputePSOCache.FindOrCreate(std::move(Key), [this]
 	{
-		while (*PSORef == nullptr)
-			this_thread::yield();
-		m_PSO = *PSORef;
-	}
+		ID3D12PipelineState* NewPSO = nullptr;
+		ASSERT_SUCCEEDED(g_Device->CreateComputePipelineState(&m_PSODesc, MY_IID_PPV_ARGS(&NewPSO)));
+		NewPSO->SetName(m_Name);
+		return NewPSO;
+	});
 }
@@ -3,6 +3,7 @@
 #include "pch.h"
 
 #include <d3dcompiler.h>
+#include "PipelineStateCache.h"
 
 class RootSignature;
 class CommandContext;
@@ -14,6 +15,10 @@ public:
 
 	static void DesytroyAll(void);
 
+	// Lookup and compile counters of the shared pipeline caches since startup
+	static PSOCacheStats GetGraphicsCacheStats(void);
+	static PSOCacheStats GetComputeCacheStats(void);
+
 	void SetRootSignature(const RootSignature& BindMappings)
 	{
 		m_RootSignature = &BindMappings;
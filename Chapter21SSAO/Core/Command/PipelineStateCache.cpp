@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "PipelineStateCache.h"
+#include "Hash.h"
+#include <chrono>
+#include <cstring>
+
+void PSOKey::Append(const void* Data, size_t Size)
+{
+	// always a whole number of words, zero padded, so HashRange can walk it
+	size_t Offset = m_Words.size();
+	m_Words.resize(Offset + (Size + 3) / 4, 0);
+	if (Size > 0)
+		memcpy(m_Words.data() + Offset, Data, Size);
+}
+
+void PSOKey::AppendString(const char* String)
+{
+	// the length goes first so "AB"+"C" and "A"+"BC" differ
+	uint32_t Length = String != nullptr ? (uint32_t)strlen(String) : 0;
+	Append(&Length, sizeof(Length));
+	Append(String, Length);
+}
+
+void PSOKey::AppendBytecode(const D3D12_SHADER_BYTECODE& Bytecode)
+{
+	// Compared by content rather than address: a blob released after Finalize can have its
+	// memory reused by a different shader.
+	uint64_t Length = Bytecode.pShaderBytecode != nullptr ? Bytecode.BytecodeLength : 0;
+	Append(&Length, sizeof(Length));
+	Append(Bytecode.pShaderBytecode, (size_t)Length);
+}
+
+void PSOKey::AppendInputLayout(const D3D12_INPUT_LAYOUT_DESC& InputLayout)
+{
+	Append(&InputLayout.NumElements, sizeof(InputLayout.NumElements));
+	for (UINT i = 0; i < InputLayout.NumElements; ++i)
+	{
+		D3D12_INPUT_ELEMENT_DESC Element = InputLayout.pInputElementDescs[i];
+		AppendString(Element.SemanticName);
+		Element.SemanticName = nullptr;
+		Append(&Element, sizeof(Element));
+	}
+}
+
+void PSOKey::Finalize(void)
+{
+	m_Hash = Utility::HashRange(m_Words.data(), m_Words.data() + m_Words.size(), 2166136261U);
+}
+
+ID3D12PipelineState* PSOCache::FindOrCreate(PSOKey&& Key, const CreateFunc& Create)
+{
+	const size_t Hash = Key.GetHash();
+	Shard& S = m_Shards[(Hash ^ (Hash >> 17)) % kNumShards];
+
+	Entry* Found = nullptr;
+	bool FirstCompile = false;
+	{
+		std::lock_guard<std::mutex> Guard(S.Mutex);
+
+		auto Range = S.Entries.equal_range(Hash);
+		for (auto Iter = Range.first; Iter != Range.second; ++Iter)
+		{
+			if (Iter->second->Key == Key)
+			{
+				Found = Iter->second.get();
+				break;
+			}
+			++m_Collisions;
+		}
+
+		// Reserve the entry so the next inquiry will find that someone got here first
+		if (Found == nullptr)
+		{
+			std::unique_ptr<Entry> NewEntry(new Entry);
+			NewEntry->Key = std::move(Key);
+			Found = NewEntry.get();
+			S.Entries.emplace(Hash, std::move(NewEntry));
+			FirstCompile = true;
+		}
+	}
+
+	if (FirstCompile)
+	{
+		++m_Misses;
+
+		auto Start = std::chrono::high_resolution_clock::now();
+		ID3D12PipelineState* PSO = Create();
+		auto Elapsed = std::chrono::high_resolution_clock::now() - Start;
+		m_CompileMicroseconds += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Elapsed).count();
+
+		{
+			std::lock_guard<std::mutex> Guard(Found->Mutex);
+			Found->PSO.Attach(PSO);
+			Found->IsReady = true;
+		}
+		Found->Ready.notify_all();
+		return PSO;
+	}
+
+	++m_Hits;
+
+	std::unique_lock<std::mutex> Lock(Found->Mutex);
+	if (!Found->IsReady)
+	{
+		++m_Waits;
+		Found->Ready.wait(Lock, [Found] { return Found->IsReady; });
+	}
+	return Found->PSO.Get();
+}
+
+void PSOCache::Clear(void)
+{
+	for (Shard& S : m_Shards)
+	{
+		std::lock_guard<std::mutex> Guard(S.Mutex);
+		S.Entries.clear();
+	}
+}
+
+PSOCacheStats PSOCache::GetStats(void) const
+{
+	PSOCacheStats Stats;
+	Stats.Hits = m_Hits;
+	Stats.Misses = m_Misses;
+	Stats.Waits = m_Waits;
+	Stats.Collisions = m_Collisions;
+	Stats.CompileMs = m_CompileMicroseconds / 1000.0;
+	return Stats;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "pch.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct PSOCacheStats
+{
+	uint64_t Hits;			// lookups that found a pipeline, built or being built
+	uint64_t Misses;		// lookups that had to compile
+	uint64_t Waits;			// hits that blocked on another thread's compile
+	uint64_t Collisions;	// entries skipped because only the hash matched
+	double CompileMs;		// total time inside Create*PipelineState
+};
+
+// Canonical form of a pipeline description. The flat desc is copied with every pointer
+// cleared, then whatever those pointers referenced (input elements, semantic names, shader
+// bytecode) is appended by value, so two keys are equal exactly when the pipelines are.
+class PSOKey
+{
+public:
+	template <typename T> void AppendDesc(const T& Desc)
+	{
+		static_assert((sizeof(T) & 3) == 0 && alignof(T) >= 4, "State object is not word-aligned");
+		Append(&Desc, sizeof(T));
+	}
+
+	void Append(const void* Data, size_t Size);
+	void AppendString(const char* String);
+	void AppendBytecode(const D3D12_SHADER_BYTECODE& Bytecode);
+	void AppendInputLayout(const D3D12_INPUT_LAYOUT_DESC& InputLayout);
+
+	// Call once everything is appended
+	void Finalize(void);
+
+	size_t GetHash(void) const { return m_Hash; }
+	bool operator==(const PSOKey& Other) const { return m_Hash == Other.m_Hash && m_Words == Other.m_Words; }
+
+private:
+	std::vector<uint32_t> m_Words;
+	size_t m_Hash = 0;
+};
+
+// Thread-safe map from PSOKey to pipeline. Lookups lock one of kNumShards shards, so
+// threads finalizing unrelated PSOs rarely contend. The first thread to ask for a key
+// compiles it outside any shard lock; later threads block on that entry until it is ready.
+class PSOCache
+{
+public:
+	typedef std::function<ID3D12PipelineState*(void)> CreateFunc;
+
+	// Returns the pipeline for Key, calling Create only if no other thread has built or is
+	// building an identical one. The cache keeps the reference returned by Create.
+	ID3D12PipelineState* FindOrCreate(PSOKey&& Key, const CreateFunc& Create);
+
+	void Clear(void);
+	PSOCacheStats GetStats(void) const;
+
+private:
+	struct Entry
+	{
+		PSOKey Key;
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> PSO;
+
+		std::mutex Mutex;
+		std::condition_variable Ready;
+		bool IsReady = false;
+	};
+
+	struct Shard
+	{
+		std::mutex Mutex;
+		std::unordered_multimap<size_t, std::unique_ptr<Entry>> Entries;
+	};
+
+	static const uint32_t kNumShards = 16;
+	Shard m_Shards[kNumShards];
+
+	std::atomic<uint64_t> m_Hits{ 0 };
+	std::atomic<uint64_t> m_Misses{ 0 };
+	std::atomic<uint64_t> m_Waits{ 0 };
+	std::atomic<uint64_t> m_Collisions{ 0 };
+	std::atomic<uint64_t> m_CompileMicroseconds{ 0 };
+};
@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "ResourceStateTracker.h"
+#include "CommandContext.h"
+
+void ResourceStateTracker::Reset(void)
+{
+	m_PassLists.clear();
+	m_Declarations.clear();
+	m_Resources.clear();
+	m_Barriers.clear();
+	m_BoundaryOffsets.clear();
+	m_Solver.Reset();
+}
+
+void ResourceStateTracker::AddPass(uint32_t ListIndex)
+{
+	m_PassLists.push_back(ListIndex);
+}
+
+void ResourceStateTracker::Read(GpuResource& Resource, D3D12_RESOURCE_STATES State)
+{
+	Declare(Resource, State, kRead);
+}
+
+void ResourceStateTracker::Write(GpuResource& Resource, D3D12_RESOURCE_STATES State)
+{
+	Declare(Resource, State, kWrite);
+}
+
+void ResourceStateTracker::Leave(GpuResource& Resource, D3D12_RESOURCE_STATES State)
+{
+	Declare(Resource, State, kLeave);
+}
+
+void ResourceStateTracker::Declare(GpuResource& Resource, D3D12_RESOURCE_STATES State, DeclarationType Type)
+{
+	ASSERT(!m_PassLists.empty(), "Declarations belong to a pass");
+	m_Declarations.push_back({ (uint32_t)m_PassLists.size() - 1, &Resource, State, Type });
+}
+
+uint32_t ResourceStateTracker::SolverIndexOf(GpuResource& Resource)
+{
+	for (uint32_t i = 0; i < (uint32_t)m_Resources.size(); ++i)
+	{
+		if (m_Resources[i] == &Resource)
+			return i;
+	}
+
+	ASSERT(Resource.m_TransitioningState == (D3D12_RESOURCE_STATES)-1, "Finish split transitions before handing a resource to the tracker");
+
+	m_Resources.push_back(&Resource);
+	return m_Solver.AddResource(Resource.m_UsageState);
+}
+
+void ResourceStateTracker::Solve(void)
+{
+	m_Solver.Reset();
+	m_Resources.clear();
+
+	// declarations were made in pass order, replay them with the states as of now
+	uint32_t NextPass = 0;
+	for (const Declaration& D : m_Declarations)
+	{
+		while (NextPass <= D.Pass)
+			m_Solver.AddPass(m_PassLists[NextPass++]);
+
+		uint32_t Index = SolverIndexOf(*D.Resource);
+		if (D.Type == kRead)
+			m_Solver.Read(Index, D.State);
+		else if (D.Type == kWrite)
+			m_Solver.Write(Index, D.State);
+		else
+			m_Solver.SetFinalState(Index, D.State);
+	}
+	while (NextPass < (uint32_t)m_PassLists.size())
+		m_Solver.AddPass(m_PassLists[NextPass++]);
+
+	m_Solver.Solve();
+
+	const uint32_t NumPasses = (uint32_t)m_PassLists.size();
+	m_Barriers.clear();
+	m_BoundaryOffsets.resize(NumPasses + 2);
+	m_BoundaryOffsets[0] = 0;
+
+	for (uint32_t b = 0; b <= NumPasses; ++b)
+	{
+		uint32_t NumBarriers = 0;
+		const BarrierSolver::Barrier* Barriers = m_Solver.GetBarriers(b, NumBarriers);
+
+		for (uint32_t i = 0; i < NumBarriers; ++i)
+		{
+			const BarrierSolver::Barrier& B = Barriers[i];
+
+			D3D12_RESOURCE_BARRIER BarrierDesc = {};
+			if (B.Type == BarrierSolver::kUAV)
+			{
+				BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+				BarrierDesc.UAV.pResource = m_Resources[B.Resource]->GetResource();
+			}
+			else
+			{
+				BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+				BarrierDesc.Transition.pResource = m_Resources[B.Resource]->GetResource();
+				BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+				BarrierDesc.Transition.StateBefore = (D3D12_RESOURCE_STATES)B.StateBefore;
+				BarrierDesc.Transition.StateAfter = (D3D12_RESOURCE_STATES)B.StateAfter;
+
+				if (B.Type == BarrierSolver::kBeginOnly)
+					BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+				else if (B.Type == BarrierSolver::kEndOnly)
+					BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+			}
+			m_Barriers.push_back(BarrierDesc);
+		}
+
+		m_BoundaryOffsets[b + 1] = (uint32_t)m_Barriers.size();
+	}
+
+	// every split transition also ends within the passes, so the resources are settled after them
+	for (uint32_t i = 0; i < (uint32_t)m_Resources.size(); ++i)
+		m_Resources[i]->m_UsageState = (D3D12_RESOURCE_STATES)m_Solver.GetFinalState(i);
+}
+
+void ResourceStateTracker::IssueBarriers(CommandContext& Context, uint32_t Boundary) const
+{
+	ASSERT(Boundary + 1 < m_BoundaryOffsets.size(), "Solve first");
+
+	UINT NumBarriers = m_BoundaryOffsets[Boundary + 1] - m_BoundaryOffsets[Boundary];
+	if (NumBarriers > 0)
+		Context.ResourceBarrier(NumBarriers, m_Barriers.data() + m_BoundaryOffsets[Boundary]);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "pch.h"
+#include "BarrierSolver.h"
+#include <vector>
+
+class CommandContext;
+class GpuResource;
+
+// Barriers for a sequence of passes, worked out by BarrierSolver from what each pass declares
+// instead of hand-written TransitionResource calls.
+//
+// Every pass is declared before any of them records. Solve reads the states the resources are
+// in at that point and leaves each one in the state it will have after the last pass, so
+// TransitionResource keeps working on them afterwards. While recording, IssueBarriers(i) goes
+// before pass i and IssueBarriers(GetPassCount()) after the last one, one ResourceBarrier
+// call each.
+class ResourceStateTracker
+{
+public:
+	void Reset(void);
+
+	// Passes recorded into different command lists must pass different ListIndex values,
+	// split barriers never cross lists
+	void AddPass(uint32_t ListIndex = 0);
+
+	// Declared for the pass added last
+	void Read(GpuResource& Resource, D3D12_RESOURCE_STATES State);
+	void Write(GpuResource& Resource, D3D12_RESOURCE_STATES State);
+
+	// State the resource has to be in once the last pass is done
+	void Leave(GpuResource& Resource, D3D12_RESOURCE_STATES State);
+
+	void Solve(void);
+
+	void IssueBarriers(CommandContext& Context, uint32_t Boundary) const;
+
+	uint32_t GetPassCount(void) const { return (uint32_t)m_PassLists.size(); }
+
+	const BarrierSolver::Stats& GetStats(void) const { return m_Solver.GetStats(); }
+
+private:
+	enum DeclarationType { kRead, kWrite, kLeave };
+
+	struct Declaration
+	{
+		uint32_t Pass;
+		GpuResource* Resource;
+		D3D12_RESOURCE_STATES State;
+		DeclarationType Type;
+	};
+
+	void Declare(GpuResource& Resource, D3D12_RESOURCE_STATES State, DeclarationType Type);
+	uint32_t SolverIndexOf(GpuResource& Resource);
+
+	std::vector<uint32_t> m_PassLists;
+	std::vector<Declaration> m_Declarations;
+
+	// filled by Solve
+	BarrierSolver m_Solver;
+	std::vector<GpuResource*> m_Resources;				// by solver index
+	std::vector<D3D12_RESOURCE_BARRIER> m_Barriers;
+	std::vector<uint32_t> m_BoundaryOffsets;
+};
@@ -42,20 +42,20 @@ void RootSignature::InitStaticSampler(UINT Register, const D3D12_SAMPLER_DESC& N
     {
         WARN_ONCE_IF_NOT(
             // Transparent Black
-            NonStaticSamplerDesc.BorderColor[0] == 0.0f &&
+            (NonStaticSamplerDesc.BorderColor[0] == 0.0f &&
             NonStaticSamplerDesc.BorderColor[1] == 0.0f &&
             NonStaticSamplerDesc.BorderColor[2] == 0.0f &&
-            NonStaticSamplerDesc.BorderColor[3] == 0.0f ||
+            NonStaticSamplerDesc.BorderColor[3] == 0.0f) ||
             // Opaque Black
-            NonStaticSamplerDesc.BorderColor[0] == 0.0f &&
+            (NonStaticSamplerDesc.BorderColor[0] == 0.0f &&
             NonStaticSamplerDesc.BorderColor[1] == 0.0f &&
             NonStaticSamplerDesc.BorderColor[2] == 0.0f &&
-            NonStaticSamplerDesc.BorderColor[3] == 1.0f ||
+            NonStaticSamplerDesc.BorderColor[3] == 1.0f) ||
             // Opaque White
-            NonStaticSamplerDesc.BorderColor[0] == 1.0f &&
+            (NonStaticSamplerDesc.BorderColor[0] == 1.0f &&
             NonStaticSamplerDesc.BorderColor[1] == 1.0f &&
             NonStaticSamplerDesc.BorderColor[2] == 1.0f &&
-            NonStaticSamplerDesc.BorderColor[3] == 1.0f,
+            NonStaticSamplerDesc.BorderColor[3] == 1.0f),
             "Sampler border color does not match static sampler limitations");
 
         if (NonStaticSamplerDesc.BorderColor[3] == 1.0f)
@@ -78,7 +78,7 @@ void RootSignature::Finalize(const std::wstring& name, D3D12_ROOT_SIGNATURE_FLAG
     ASSERT(m_NumInitializedStaticSamplers == m_NumSamplers);
 
     // record rootSignature desc
-    D3D12_ROOT_SIGNATURE_DESC RootDesc;
+    D3D12_ROOT_SIGNATURE_DESC RootDesc = {};
     RootDesc.NumParameters = m_NumParameters;
     RootDesc.pParameters = (const D3D12_ROOT_PARAMETER*)m_ParamArray.get();
     RootDesc.NumStaticSamplers = m_NumSamplers;
@@ -105,9 +105,17 @@ void RootSignature::Finalize(const std::wstring& name, D3D12_ROOT_SIGNATURE_FLAG
             HashCode = Utility::HashState(RootParam.DescriptorTable.pDescriptorRanges,
                 RootParam.DescriptorTable.NumDescriptorRanges, HashCode);
 
+            // Unbounded ranges point straight into the bindless heap through SetDescriptorTable,
+            // the dynamic descriptor heap has nothing to stage for them
+            bool IsUnbounded = false;
+            for (UINT TableRange = 0; TableRange < RootParam.DescriptorTable.NumDescriptorRanges; ++TableRange)
+                IsUnbounded |= RootParam.DescriptorTable.pDescriptorRanges[TableRange].NumDescriptors == UINT_MAX;
+
             // 使用位图标记描述符表和采样器
             // We keep track of sampler descriptor tables separately from CBV_SRV_UAV descriptor tables
-            if (RootParam.DescriptorTable.pDescriptorRanges->RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER)
+            if (IsUnbounded)
+                continue;
+            else if (RootParam.DescriptorTable.pDescriptorRanges->RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER)
                 m_SamplerTableBitMap |= (1 << Param);
             else
                 m_DescriptorTableBitMap |= (1 << Param);
@@ -4,6 +4,7 @@
 #include "Display.h"
 #include "GameInput.h"
 #include "CommandListManager.h"
+#include "TextureManager.h"
 
 namespace GameCore
 {
@@ -28,6 +29,9 @@ namespace GameCore
 
     void UpdateApplication(IGameApp& game)
     {
+        // make textures streamed in since the last frame visible before anything records
+        TextureManager::Update();
+
         game.Update(0.1);
         game.RenderScene();
         GameInput::Update(0.1);
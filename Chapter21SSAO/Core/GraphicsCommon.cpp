@@ -1,4 +1,5 @@
 #include "GraphicsCommon.h"
+#include "GraphicsCore.h"
 #include "RootSignature.h"
 #include "PipelineState.h"
 #include "Texture.h"
@@ -34,6 +35,13 @@ namespace Graphics
         return DefaultTextures[texID].GetSRV();
     }
 
+    uint32_t DefaultTextureIndices[kNumDefaultTextures];
+    uint32_t GetDefaultTextureIndex(eDefaultTexture texID)
+    {
+        ASSERT(texID < kNumDefaultTextures);
+        return DefaultTextureIndices[texID];
+    }
+
 
     D3D12_RASTERIZER_DESC RasterizerDefault;	// Clockwise
     D3D12_RASTERIZER_DESC RasterizerDefaultMsaa;
@@ -113,6 +121,9 @@ void Graphics::InitializeCommonState(void)
     uint32_t BlackCubeTexels[6] = {};
     DefaultTextures[kBlackCubeMap].CreateCube(4, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, BlackCubeTexels);
 
+    for (uint32_t i = 0; i < kNumDefaultTextures; ++i)
+        DefaultTextureIndices[i] = g_BindlessHeap.Allocate(DefaultTextures[i].GetSRV());
+
     // Default rasterizer states
     RasterizerDefault.FillMode = D3D12_FILL_MODE_SOLID;
     RasterizerDefault.CullMode = D3D12_CULL_MODE_BACK;
@@ -217,7 +228,10 @@ void Graphics::InitializeCommonState(void)
 void Graphics::DestroyCommonState(void)
 {
     for (uint32_t i = 0; i < kNumDefaultTextures; ++i)
+    {
+        g_BindlessHeap.Free(DefaultTextureIndices[i]);
         DefaultTextures[i].Destroy();
+    }
 
 }
 
@@ -71,6 +71,8 @@ namespace Graphics
         kNumDefaultTextures
     };
     D3D12_CPU_DESCRIPTOR_HANDLE GetDefaultTexture(eDefaultTexture texID);
+    // Slot of the default texture in the bindless heap
+    uint32_t GetDefaultTextureIndex(eDefaultTexture texID);
 
     extern RootSignature g_CommonRS;
     extern GraphicsPSO g_DownsampleDepthPSO;
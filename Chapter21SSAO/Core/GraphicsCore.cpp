@@ -5,6 +5,8 @@
 #include "Display.h"
 #include "BufferManager.h"
 #include "GraphicsCommon.h"
+#include "PipelineState.h"
+#include "DynamicDescriptorHeap.h"
 
 namespace Graphics
 {
@@ -19,6 +21,8 @@ namespace Graphics
         D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
         D3D12_DESCRIPTOR_HEAP_TYPE_DSV
     };
+
+    BindlessDescriptorHeap g_BindlessHeap;
 }
 void Graphics::Initialize(bool RequireDXRSupport)
 {
@@ -209,6 +213,9 @@ void Graphics::Initialize(bool RequireDXRSupport)
     //
     g_CommandManager.Create(g_Device);
 
+    // before the default textures, which take the first persistent slots
+    g_BindlessHeap.Create(L"Bindless Heap");
+
     // init pso desc
     InitializeCommonState();
 
@@ -223,8 +230,11 @@ void Graphics::Shutdown(void)
     g_CommandManager.IdleGPU();
     g_CommandManager.ShutDown();
 
+    PSO::DesytroyAll();
     DescriptorAllocator::DestroyAll();
     g_ContextManager.DestroyAllContexts();
+    DynamicDescriptorHeap::DestroyAll();
+    g_BindlessHeap.Destroy();
     
     Display::Shutdown();
 
@@ -19,10 +19,15 @@ namespace Graphics
     extern ContextManager g_ContextManager;;
 
     extern DescriptorAllocator g_DescriptorAllocator[];
+    extern BindlessDescriptorHeap g_BindlessHeap;
     inline D3D12_CPU_DESCRIPTOR_HANDLE AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE Type, UINT Count = 1)
     {
         return g_DescriptorAllocator[Type].Allocate(Count);
     }
+    inline void FreeDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE Handle, D3D12_DESCRIPTOR_HEAP_TYPE Type, UINT Count = 1)
+    {
+        g_DescriptorAllocator[Type].Free(Handle, Count);
+    }
 
     extern ColorBuffer g_DisplayPlane[SWAP_CHAIN_BUFFER_COUNT];
     extern UINT g_CurrentBuffer;
@@ -1,13 +1,21 @@
 #include "ColorBuffer.h"
 #include "GraphicsCore.h"
 
+ColorBuffer::~ColorBuffer()
+{
+	Graphics::FreeDescriptor(m_RTVHandle, D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	Graphics::FreeDescriptor(m_SRVHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	for (int i = 0; i < _countof(m_UAVHandle); ++i)
+		Graphics::FreeDescriptor(m_UAVHandle[i], D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
 
 void ColorBuffer::CreateFromSwapChain(const std::wstring& Name, ID3D12Resource* BaseResource)
 {
 	AssociateWithResource(Graphics::g_Device, Name, BaseResource, D3D12_RESOURCE_STATE_PRESENT);
 
-	// get Descriptor Handle
-	m_RTVHandle = Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	// get Descriptor Handle, the swap chain buffers are recreated on every resize
+	if (m_RTVHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+		m_RTVHandle = Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 	Graphics::g_Device->CreateRenderTargetView(m_pResource.Get(), nullptr, m_RTVHandle);
 }
 
@@ -97,11 +105,10 @@ void ColorBuffer::CreateDerivedViews(ID3D12Device* Device, DXGI_FORMAT Format, u
 		SRVDesc.Texture2D.MostDetailedMip = 0;
 	}
 	// cpu visible descriptor heap 
-	if (m_SRVHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
-	{
+	if (m_RTVHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
 		m_RTVHandle = Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	if (m_SRVHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
 		m_SRVHandle = Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	}
 
 	ID3D12Resource* Resource = m_pResource.Get();
 
@@ -11,10 +11,13 @@ public:
 	{
 		m_RTVHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
 		m_SRVHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-		for (int i = 0; i < _countof(m_UAVHandle); ++i)
+		for (uint32_t i = 0; i < _countof(m_UAVHandle); ++i)
 			m_UAVHandle[i].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
 	}
 
+	// Views survive Destroy and are reused by the next Create, they are only freed here
+	~ColorBuffer();
+
 	// Create a color buffer from a swap chain buffer.  Unordered access is restricted.
 	void CreateFromSwapChain(const std::wstring& Name, ID3D12Resource* BaseResource);
 
@@ -65,8 +68,8 @@ protected:
 	// as the dimension 511 (0x1FF).
 	static inline uint32_t ComputeNumMips(uint32_t Width, uint32_t Height)
 	{
-		uint32_t HighBit;
-		_BitScanReverse((unsigned long*)&HighBit, Width | Height);
+		unsigned long HighBit;
+		_BitScanReverse(&HighBit, Width | Height);
 		return HighBit + 1;
 	}
 
@@ -1,6 +1,13 @@
 #include "CubeMapBuffer.h"
 #include "GraphicsCore.h"
 
+CubeMapBuffer::~CubeMapBuffer()
+{
+	Graphics::FreeDescriptor(m_SRVHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	for (int i = 0; i < _countof(m_RTVHandle); ++i)
+		Graphics::FreeDescriptor(m_RTVHandle[i], D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+}
+
 void CubeMapBuffer::Create(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumMips, DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr)
 {
 	D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, 6, NumMips, Format, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET); // six face
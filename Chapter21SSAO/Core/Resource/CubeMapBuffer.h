@@ -10,10 +10,12 @@ public:
 		m_ClearColor(ClearColor), m_NumMipMaps(0),m_SamleCount(1)
 	{
 		m_SRVHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-		for(int i =0; i < _countof(m_RTVHandle); ++i)
+		for(uint32_t i =0; i < _countof(m_RTVHandle); ++i)
 			m_RTVHandle[i].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
 	}
 
+	~CubeMapBuffer();
+
 	void Create(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumMips,
 		DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN);
 
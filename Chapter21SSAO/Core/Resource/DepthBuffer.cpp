@@ -1,6 +1,14 @@
 #include "DepthBuffer.h"
 #include "GraphicsCore.h"
 
+DepthBuffer::~DepthBuffer()
+{
+    for (int i = 0; i < _countof(m_hDSV); ++i)
+        Graphics::FreeDescriptor(m_hDSV[i], D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+    Graphics::FreeDescriptor(m_hDepthSRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    Graphics::FreeDescriptor(m_hStencilSRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
 void DepthBuffer::Create(const std::wstring& Name, uint32_t Width, uint32_t Height, DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr)
 {
 	Create(Name, Width, Height, 1, Format, VidMemPtr);
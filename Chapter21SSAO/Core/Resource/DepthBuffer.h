@@ -15,6 +15,9 @@ public:
         m_hStencilSRV.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
     }
 
+    // Views survive Destroy and are reused by the next Create, they are only freed here
+    ~DepthBuffer();
+
     // Create a depth buffer.  If an address is supplied, memory will not be allocated.
     // The vmem address allows you to alias buffers (which can be especially useful for
     // reusing ESRAM across a frame.)
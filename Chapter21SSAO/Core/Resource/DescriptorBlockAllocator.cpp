@@ -0,0 +1,234 @@
+#include "pch.h"
+#include "DescriptorBlockAllocator.h"
+
+namespace
+{
+    // Per-thread table from allocator serial to that thread's cache.  A slot whose serial
+    // does not match belongs to another allocator, or to one that has been reset since.
+    struct ThreadCacheSlot
+    {
+        uint64_t Serial;
+        void* Cache;
+    };
+
+    thread_local ThreadCacheSlot t_ThreadCacheSlots[8];
+
+    std::atomic<uint64_t> s_NextSerial{ 1 };
+}
+
+DescriptorBlockAllocator::DescriptorBlockAllocator(uint32_t HeapSize) :
+    m_HeapSize(HeapSize), m_NumSizeClasses(SizeClassOf(HeapSize) + 1),
+    m_Serial(s_NextSerial.fetch_add(1, std::memory_order_relaxed)),
+    m_DescriptorSize(0), m_NumHeaps(0), m_CurrentHandle(0), m_RemainingInHeap(0),
+    m_NumFree(0), m_NumPending(0)
+{
+    ASSERT(HeapSize != 0 && (HeapSize & (HeapSize - 1)) == 0, "Heap size must be a power of two");
+    ASSERT(m_NumSizeClasses <= kMaxSizeClasses);
+    static_assert(kMaxThreadCacheSlots == _countof(t_ThreadCacheSlots), "Slot table size mismatch");
+}
+
+uint32_t DescriptorBlockAllocator::SizeClassOf(uint32_t Count)
+{
+    uint32_t SizeClass = 0;
+    while ((1u << SizeClass) < Count)
+        ++SizeClass;
+    return SizeClass;
+}
+
+size_t DescriptorBlockAllocator::AllocateBlock(uint32_t Count)
+{
+    ASSERT(Count > 0 && Count <= m_HeapSize);
+
+    const uint32_t SizeClass = SizeClassOf(Count);
+    if (SizeClass != 0)
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        ReleaseCompletedLocked();
+        return AllocateLocked(SizeClass);
+    }
+
+    ThreadCache* Cache = GetThreadCache();
+    if (Cache->Free.empty())
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+        // Hand this thread's own frees back first, they are the likeliest to be recyclable
+        FlushRetiredLocked(*Cache);
+        ReleaseCompletedLocked();
+
+        // Fill up from what is already there, but only start a new heap for the first one
+        while (Cache->Free.size() < kThreadCacheBatch &&
+            (Cache->Free.empty() || !m_FreeBlocks[0].empty() || m_RemainingInHeap > 0))
+        {
+            Cache->Free.push_back(AllocateLocked(0));
+        }
+    }
+
+    size_t Handle = Cache->Free.back();
+    Cache->Free.pop_back();
+    Cache->FreeCount.store((uint32_t)Cache->Free.size(), std::memory_order_relaxed);
+    return Handle;
+}
+
+void DescriptorBlockAllocator::FreeBlock(size_t Handle, uint32_t Count)
+{
+    ASSERT(Count > 0 && Count <= m_HeapSize);
+
+    const uint32_t SizeClass = SizeClassOf(Count);
+    if (SizeClass != 0)
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        m_PendingBlocks.push_back({ GetRetireFence(), Handle, SizeClass });
+        m_NumPending += 1u << SizeClass;
+        return;
+    }
+
+    ThreadCache* Cache = GetThreadCache();
+    Cache->Retired.push_back(Handle);
+    Cache->RetiredCount.store((uint32_t)Cache->Retired.size(), std::memory_order_relaxed);
+
+    if (Cache->Retired.size() >= kThreadCacheBatch)
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        FlushRetiredLocked(*Cache);
+    }
+}
+
+void DescriptorBlockAllocator::Reset(void)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    // Orphans every thread's slot for this allocator
+    m_Serial.store(s_NextSerial.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+
+    m_DescriptorSize = 0;
+    m_NumHeaps = 0;
+    m_CurrentHandle = 0;
+    m_RemainingInHeap = 0;
+    m_NumFree = 0;
+    m_NumPending = 0;
+    for (uint32_t i = 0; i < m_NumSizeClasses; ++i)
+        m_FreeBlocks[i].clear();
+    m_PendingBlocks.clear();
+    m_ThreadCaches.clear();
+}
+
+DescriptorBlockAllocator::Stats DescriptorBlockAllocator::GetStats(void)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    Stats Result;
+    Result.NumHeaps = m_NumHeaps;
+    Result.FreeDescriptors = m_NumFree + m_RemainingInHeap;
+    Result.PendingDescriptors = m_NumPending;
+
+    for (auto& Cache : m_ThreadCaches)
+    {
+        Result.FreeDescriptors += Cache->FreeCount.load(std::memory_order_relaxed);
+        Result.PendingDescriptors += Cache->RetiredCount.load(std::memory_order_relaxed);
+    }
+
+    Result.LiveDescriptors = m_NumHeaps * m_HeapSize - Result.FreeDescriptors - Result.PendingDescriptors;
+    return Result;
+}
+
+DescriptorBlockAllocator::ThreadCache* DescriptorBlockAllocator::GetThreadCache(void)
+{
+    const uint64_t Serial = m_Serial.load(std::memory_order_relaxed);
+    ThreadCacheSlot& Slot = t_ThreadCacheSlots[Serial % kMaxThreadCacheSlots];
+    if (Slot.Serial == Serial)
+        return (ThreadCache*)Slot.Cache;
+
+    // First use on this thread, or the slot was taken by another allocator
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    const std::thread::id Self = std::this_thread::get_id();
+    ThreadCache* Cache = nullptr;
+    for (auto& Existing : m_ThreadCaches)
+    {
+        if (Existing->Owner == Self)
+        {
+            Cache = Existing.get();
+            break;
+        }
+    }
+
+    if (Cache == nullptr)
+    {
+        m_ThreadCaches.emplace_back(new ThreadCache);
+        Cache = m_ThreadCaches.back().get();
+        Cache->Owner = Self;
+        Cache->Free.reserve(kThreadCacheBatch);
+        Cache->Retired.reserve(kThreadCacheBatch);
+    }
+
+    Slot.Serial = Serial;
+    Slot.Cache = Cache;
+    return Cache;
+}
+
+size_t DescriptorBlockAllocator::AllocateLocked(uint32_t SizeClass)
+{
+    const uint32_t Size = 1u << SizeClass;
+
+    if (!m_FreeBlocks[SizeClass].empty())
+    {
+        size_t Handle = m_FreeBlocks[SizeClass].back();
+        m_FreeBlocks[SizeClass].pop_back();
+        m_NumFree -= Size;
+        return Handle;
+    }
+
+    if (m_RemainingInHeap < Size)
+    {
+        // Keep the tail of the current heap as smaller blocks rather than dropping it
+        while (m_RemainingInHeap > 0)
+        {
+            uint32_t TailClass = SizeClassOf(m_RemainingInHeap + 1) - 1;
+            m_FreeBlocks[TailClass].push_back(m_CurrentHandle);
+            m_CurrentHandle += ((size_t)1 << TailClass) * m_DescriptorSize;
+            m_RemainingInHeap -= 1u << TailClass;
+            m_NumFree += 1u << TailClass;
+        }
+
+        m_CurrentHandle = CreateHeap();
+        if (m_DescriptorSize == 0)
+            m_DescriptorSize = GetDescriptorSize();
+        m_RemainingInHeap = m_HeapSize;
+        ++m_NumHeaps;
+    }
+
+    size_t Handle = m_CurrentHandle;
+    m_CurrentHandle += (size_t)Size * m_DescriptorSize;
+    m_RemainingInHeap -= Size;
+    return Handle;
+}
+
+void DescriptorBlockAllocator::FlushRetiredLocked(ThreadCache& Cache)
+{
+    if (Cache.Retired.empty())
+        return;
+
+    // One fence for the whole batch.  It is at least as late as the one current when each
+    // descriptor was freed, so none of them comes back early.
+    const uint64_t FenceValue = GetRetireFence();
+    for (size_t Handle : Cache.Retired)
+        m_PendingBlocks.push_back({ FenceValue, Handle, 0 });
+
+    m_NumPending += (uint32_t)Cache.Retired.size();
+    Cache.Retired.clear();
+    Cache.RetiredCount.store(0, std::memory_order_relaxed);
+}
+
+void DescriptorBlockAllocator::ReleaseCompletedLocked(void)
+{
+    // Fences were taken in free order from one queue, so the first incomplete one ends the scan
+    while (!m_PendingBlocks.empty() && IsFenceComplete(m_PendingBlocks.front().FenceValue))
+    {
+        const PendingBlock& Block = m_PendingBlocks.front();
+        m_FreeBlocks[Block.SizeClass].push_back(Block.Handle);
+        m_NumFree += 1u << Block.SizeClass;
+        m_NumPending -= 1u << Block.SizeClass;
+        m_PendingBlocks.pop_front();
+    }
+}
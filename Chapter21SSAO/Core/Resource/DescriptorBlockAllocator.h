@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Recycling allocator for blocks of contiguous CPU descriptors carved out of fixed-size heaps.
+//
+// Requests are rounded up to a power of two and served from one free list per size class.
+// A freed block waits until the fence value current at the time of the free has completed
+// before it is handed out again.  Single descriptors, by far the most common request, go
+// through a small per-thread cache that is refilled and drained in batches, so the shared
+// mutex is taken once per kThreadCacheBatch allocations instead of once per allocation.
+//
+// Handles are opaque addresses: the derived class creates the heaps and supplies the fences,
+// this class does the bookkeeping and has no D3D dependency.
+class DescriptorBlockAllocator
+{
+public:
+    static const uint32_t kThreadCacheBatch = 32;
+
+    struct Stats
+    {
+        uint32_t NumHeaps;
+        uint32_t LiveDescriptors;       // handed out and not freed
+        uint32_t FreeDescriptors;       // ready to be handed out, thread caches included
+        uint32_t PendingDescriptors;    // freed, waiting on their fence
+    };
+
+    explicit DescriptorBlockAllocator(uint32_t HeapSize);
+    virtual ~DescriptorBlockAllocator() {}
+
+    DescriptorBlockAllocator(const DescriptorBlockAllocator&) = delete;
+    DescriptorBlockAllocator& operator=(const DescriptorBlockAllocator&) = delete;
+
+    // Count must be at most the heap size
+    size_t AllocateBlock(uint32_t Count);
+
+    // Count must match the one the block was allocated with
+    void FreeBlock(size_t Handle, uint32_t Count);
+
+    // Forgets every heap and block, thread caches included.  No other thread may be using
+    // the allocator meanwhile.
+    void Reset(void);
+
+    // Exact when no other thread is allocating, otherwise a close snapshot
+    Stats GetStats(void);
+
+protected:
+    // Creates a heap of the size passed to the constructor and returns the address of its
+    // first descriptor.  Called with the allocator's mutex held.
+    virtual size_t CreateHeap(void) = 0;
+
+    // Distance between two consecutive descriptors, only queried after CreateHeap
+    virtual uint32_t GetDescriptorSize(void) = 0;
+
+    // A fence value that completes after every command list recorded so far
+    virtual uint64_t GetRetireFence(void) = 0;
+
+    virtual bool IsFenceComplete(uint64_t FenceValue) = 0;
+
+private:
+    static const uint32_t kMaxSizeClasses = 32;
+    static const uint32_t kMaxThreadCacheSlots = 8;
+
+    struct PendingBlock
+    {
+        uint64_t FenceValue;
+        size_t Handle;
+        uint32_t SizeClass;
+    };
+
+    struct ThreadCache
+    {
+        std::thread::id Owner;
+        std::vector<size_t> Free;
+        std::vector<size_t> Retired;
+        // Mirrors of the vector sizes, written by the owner and read by GetStats
+        std::atomic<uint32_t> FreeCount{ 0 };
+        std::atomic<uint32_t> RetiredCount{ 0 };
+    };
+
+    static uint32_t SizeClassOf(uint32_t Count);
+
+    ThreadCache* GetThreadCache(void);
+    size_t AllocateLocked(uint32_t SizeClass);
+    void FlushRetiredLocked(ThreadCache& Cache);
+    void ReleaseCompletedLocked(void);
+
+    const uint32_t m_HeapSize;
+    const uint32_t m_NumSizeClasses;
+
+    // Distinguishes this allocator, and each Reset of it, in the per-thread slot table
+    std::atomic<uint64_t> m_Serial;
+
+    std::mutex m_Mutex;
+    uint32_t m_DescriptorSize;
+    uint32_t m_NumHeaps;
+    size_t m_CurrentHandle;
+    uint32_t m_RemainingInHeap;
+    uint32_t m_NumFree;
+    uint32_t m_NumPending;
+    std::vector<size_t> m_FreeBlocks[kMaxSizeClasses];
+    std::deque<PendingBlock> m_PendingBlocks;
+    std::vector<std::unique_ptr<ThreadCache>> m_ThreadCaches;
+};
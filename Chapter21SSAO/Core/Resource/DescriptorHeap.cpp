@@ -1,37 +1,60 @@
 #include "DescriptorHeap.h"
 #include "GraphicsCore.h"
+#include "CommandListManager.h"
 
 // declare the static members
 std::mutex DescriptorAllocator::sm_AllocationMutex;
 std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> DescriptorAllocator::sm_DescriptorHeapPool;
+bool DescriptorAllocator::sm_Destroyed = false;
 
 D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::Allocate(uint32_t Count)
 {
-    // m_CurrentHeap is null or not enough of heaps
-    if (m_CurrentHeap == nullptr || m_RemainingFreeHandles < Count)
-    {
-        // allocate new Heaps to store the descriptor
-        m_CurrentHeap = RequestNewHeap(m_Type);
-        m_CurrentHandle = m_CurrentHeap->GetCPUDescriptorHandleForHeapStart();
-        m_RemainingFreeHandles = sm_NumDescriptorsPerHeap;
-
-        if (m_DescriptorSize == 0)
-            m_DescriptorSize = Graphics::g_Device->GetDescriptorHandleIncrementSize(m_Type);
-    }
+    D3D12_CPU_DESCRIPTOR_HANDLE ret;
+    ret.ptr = AllocateBlock(Count);
+    return ret;
+}
 
-    D3D12_CPU_DESCRIPTOR_HANDLE ret = m_CurrentHandle;
-    // offset the heap handle
-    m_CurrentHandle.ptr += Count * m_DescriptorSize;
-    m_RemainingFreeHandles -= Count;
+void DescriptorAllocator::Free(D3D12_CPU_DESCRIPTOR_HANDLE Handle, uint32_t Count)
+{
+    // Global resources are destroyed after Graphics::Shutdown, possibly after the allocators
+    if (sm_Destroyed || Handle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        return;
 
-    return ret;
+    FreeBlock(Handle.ptr, Count);
 }
 
 void DescriptorAllocator::DestroyAll(void)
 {
+    sm_Destroyed = true;
+
+    for (uint32_t i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+        Graphics::g_DescriptorAllocator[i].Reset();
+
     sm_DescriptorHeapPool.clear();
 }
 
+size_t DescriptorAllocator::CreateHeap(void)
+{
+    return RequestNewHeap(m_Type)->GetCPUDescriptorHandleForHeapStart().ptr;
+}
+
+uint32_t DescriptorAllocator::GetDescriptorSize(void)
+{
+    return Graphics::g_Device->GetDescriptorHandleIncrementSize(m_Type);
+}
+
+// CPU descriptors are consumed when a command is recorded, so the fence only has to cover
+// recording that raced with the free.  The next graphics submission ends the current frame.
+uint64_t DescriptorAllocator::GetRetireFence(void)
+{
+    return Graphics::g_CommandManager.GetGraphicsQueue().GetNextFenceValue();
+}
+
+bool DescriptorAllocator::IsFenceComplete(uint64_t FenceValue)
+{
+    return Graphics::g_CommandManager.IsFenceComplete(FenceValue);
+}
+
 ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type)
 {
     // create new heaps
@@ -98,4 +121,86 @@ bool DescriptorHeap::ValidateHandle(const DescriptorHandle& DHandle) const
         return false;
 
     return true;
-}
\ No newline at end of file
+}
+
+//
+// BindlessDescriptorHeap implementation
+//
+void BindlessDescriptorHeap::Create(const std::wstring& Name)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC HeapDesc;
+    HeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    HeapDesc.NumDescriptors = kNumPersistentDescriptors + kNumDynamicDescriptors;
+    HeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    HeapDesc.NodeMask = 1;
+
+    ASSERT_SUCCEEDED(Graphics::g_Device->CreateDescriptorHeap(&HeapDesc, MY_IID_PPV_ARGS(m_Heap.ReleaseAndGetAddressOf())));
+
+#ifdef RELEASE
+    (void)Name;
+#else
+    m_Heap->SetName(Name.c_str());
+#endif
+
+    // Resource binding tier 1 limits a descriptor table to 128 SRVs
+    D3D12_FEATURE_DATA_D3D12_OPTIONS Options = {};
+    if (SUCCEEDED(Graphics::g_Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &Options, sizeof(Options)))
+        && Options.ResourceBindingTier < D3D12_RESOURCE_BINDING_TIER_2)
+    {
+        Utility::Print("WARNING:  Resource binding tier 1, unbounded descriptor tables are limited to 128 SRVs\n");
+    }
+
+    m_DescriptorSize = Graphics::g_Device->GetDescriptorHandleIncrementSize(HeapDesc.Type);
+    m_FirstHandle = DescriptorHandle(
+        m_Heap->GetCPUDescriptorHandleForHeapStart(),
+        m_Heap->GetGPUDescriptorHandleForHeapStart());
+
+    m_Indices.Reset(kNumPersistentDescriptors);
+    m_NextDynamicDescriptor = 0;
+}
+
+void BindlessDescriptorHeap::Destroy(void)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    m_Heap = nullptr;
+    m_Indices.Reset(0);
+    m_NextDynamicDescriptor = 0;
+}
+
+uint32_t BindlessDescriptorHeap::Allocate(D3D12_CPU_DESCRIPTOR_HANDLE Source)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    m_Indices.ReleaseCompleted([](uint64_t FenceValue) { return Graphics::g_CommandManager.IsFenceComplete(FenceValue); });
+
+    uint32_t Index = m_Indices.Allocate();
+    ASSERT(Index != DescriptorIndexAllocator::kInvalidIndex, "Bindless heap out of space.  Increase kNumPersistentDescriptors.");
+
+    Graphics::g_Device->CopyDescriptorsSimple(1, (*this)[Index], Source, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    return Index;
+}
+
+void BindlessDescriptorHeap::Free(uint32_t Index)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    // Textures can outlive the device at exit; there is nothing left to recycle then
+    if (m_Heap == nullptr || Index == DescriptorIndexAllocator::kInvalidIndex)
+        return;
+
+    // Signaled after every command list submitted so far
+    m_Indices.Free(Index, Graphics::g_CommandManager.GetGraphicsQueue().IncrementFence());
+}
+
+bool BindlessDescriptorHeap::AllocateDynamic(uint32_t Count, DescriptorHandle& FirstDescriptor)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    if (m_NextDynamicDescriptor + Count > kNumDynamicDescriptors)
+        return false;
+
+    FirstDescriptor = (*this)[kNumPersistentDescriptors + m_NextDynamicDescriptor];
+    m_NextDynamicDescriptor += Count;
+    return true;
+}
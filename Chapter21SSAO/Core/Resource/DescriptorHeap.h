@@ -1,36 +1,46 @@
 #pragma once
 #include "pch.h"
+#include "DescriptorBlockAllocator.h"
+#include "DescriptorIndexAllocator.h"
 
 // This is an unbounded resource descriptor allocator.  It is intended to provide space for CPU-visible
 // resource descriptors as resources are created.  For those that need to be made shader-visible, they
 // will need to be copied to a DescriptorHeap or a DynamicDescriptorHeap.
+//
+// Descriptors are recycled: whoever allocated them returns them with Free once the resource is
+// gone, and they are handed out again after the GPU has passed the frame they were freed in.
 
 // non shader visible heap such as RTV and DSV
 // 描述符堆是用于存储 CPU 可见的资源描述符的内存块。这些描述符定义了 GPU 可以访问的资源，如缓冲区和纹理
-class DescriptorAllocator
+class DescriptorAllocator : public DescriptorBlockAllocator
 {
 public:
 	DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE Type) :
-		m_Type(Type), m_CurrentHeap(nullptr), m_DescriptorSize(0)
+		DescriptorBlockAllocator(sm_NumDescriptorsPerHeap), m_Type(Type)
 	{
-		m_CurrentHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
 	}
 
 	D3D12_CPU_DESCRIPTOR_HANDLE Allocate(uint32_t Count);
 
+	// Count must match the allocation.  Ignored for null handles and after DestroyAll, so
+	// resources outliving the device may still free their descriptors.
+	void Free(D3D12_CPU_DESCRIPTOR_HANDLE Handle, uint32_t Count);
+
 	static void DestroyAll(void);
 
 protected:
 	static const uint32_t sm_NumDescriptorsPerHeap = 256;
 	static std::mutex sm_AllocationMutex;
 	static std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> sm_DescriptorHeapPool;
+	static bool sm_Destroyed;
 	static ID3D12DescriptorHeap* RequestNewHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type);
 
+	virtual size_t CreateHeap(void) override;
+	virtual uint32_t GetDescriptorSize(void) override;
+	virtual uint64_t GetRetireFence(void) override;
+	virtual bool IsFenceComplete(uint64_t FenceValue) override;
+
 	D3D12_DESCRIPTOR_HEAP_TYPE m_Type;
-	ID3D12DescriptorHeap* m_CurrentHeap;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_CurrentHandle;
-	uint32_t m_DescriptorSize;
-	uint32_t m_RemainingFreeHandles;
 };
 
 // This handle refers to a descriptor or a descriptor table (contiguous descriptors) that is shader visible.
@@ -110,3 +120,51 @@ private:
 	DescriptorHandle m_NextFreeHandle;
 };
 
+// One shader-visible CBV_SRV_UAV heap for the whole program.  The front holds descriptors that
+// live as long as their resources and keep the same index all along, so root signatures can
+// expose the heap as an unbounded range and shaders index it directly; nothing is copied per
+// frame for them.  The rest is handed to DynamicDescriptorHeap in pages, which keeps this heap
+// bound for every command list: switching CBV_SRV_UAV heaps would invalidate the tables that
+// point into the persistent part.
+class BindlessDescriptorHeap
+{
+public:
+	static const uint32_t kNumPersistentDescriptors = 4096;
+	static const uint32_t kNumDynamicDescriptors = 64 * 1024;
+
+	BindlessDescriptorHeap(void) : m_NextDynamicDescriptor(0) {}
+	~BindlessDescriptorHeap(void) { Destroy(); }
+
+	void Create(const std::wstring& DebugHeapName);
+	void Destroy(void);
+
+	bool IsCreated(void) const { return m_Heap != nullptr; }
+
+	// Copies Source into a free persistent slot and returns its index.  The slot is never
+	// written again until freed.
+	uint32_t Allocate(D3D12_CPU_DESCRIPTOR_HANDLE Source);
+
+	// The slot is reused after the GPU has finished everything submitted so far
+	void Free(uint32_t Index);
+
+	// Carves Count descriptors off the dynamic part.  Returns false once it is used up; the
+	// caller recycles the ranges it already owns from then on.
+	bool AllocateDynamic(uint32_t Count, DescriptorHandle& FirstDescriptor);
+
+	ID3D12DescriptorHeap* GetHeapPointer(void) const { return m_Heap.Get(); }
+	DescriptorHandle operator[] (uint32_t Index) const { return m_FirstHandle + Index * m_DescriptorSize; }
+
+	// Base of the persistent slots, for root parameters declared as an unbounded SRV range
+	D3D12_GPU_DESCRIPTOR_HANDLE GetTableStart(void) const { return m_FirstHandle; }
+
+	uint32_t GetLiveCount(void) const { return m_Indices.GetLiveCount(); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_Heap;
+	uint32_t m_DescriptorSize;
+	DescriptorHandle m_FirstHandle;
+
+	std::mutex m_Mutex;
+	DescriptorIndexAllocator m_Indices;
+	uint32_t m_NextDynamicDescriptor;
+};
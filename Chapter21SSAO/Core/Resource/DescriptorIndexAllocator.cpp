@@ -0,0 +1,42 @@
+#include "pch.h"
+#include "DescriptorIndexAllocator.h"
+
+void DescriptorIndexAllocator::Reset(uint32_t Capacity)
+{
+    m_Capacity = Capacity;
+    m_NextUnused = 0;
+    m_LiveCount = 0;
+    m_FreeIndices.clear();
+    m_PendingIndices.clear();
+}
+
+uint32_t DescriptorIndexAllocator::Allocate(void)
+{
+    uint32_t Index;
+
+    // Reuse the most recently released slot first, its descriptor is likely still in cache
+    if (!m_FreeIndices.empty())
+    {
+        Index = m_FreeIndices.back();
+        m_FreeIndices.pop_back();
+    }
+    else if (m_NextUnused < m_Capacity)
+    {
+        Index = m_NextUnused++;
+    }
+    else
+    {
+        return kInvalidIndex;
+    }
+
+    ++m_LiveCount;
+    return Index;
+}
+
+void DescriptorIndexAllocator::Free(uint32_t Index, uint64_t FenceValue)
+{
+    ASSERT(Index < m_NextUnused && m_LiveCount > 0);
+
+    --m_LiveCount;
+    m_PendingIndices.push_back(std::make_pair(FenceValue, Index));
+}
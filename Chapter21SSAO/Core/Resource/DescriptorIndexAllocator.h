@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+// Hands out the slots of a fixed-size descriptor range.  A freed slot only becomes available
+// again once the fence value it was freed with has completed, since command lists still in
+// flight may read the descriptor.  Pure bookkeeping without any D3D dependency, and not
+// thread-safe: the owner serializes access.
+class DescriptorIndexAllocator
+{
+public:
+    static const uint32_t kInvalidIndex = 0xFFFFFFFF;
+
+    explicit DescriptorIndexAllocator(uint32_t Capacity = 0) { Reset(Capacity); }
+
+    // Forgets every allocation, live or pending
+    void Reset(uint32_t Capacity);
+
+    // Returns kInvalidIndex when every slot is live or still waiting on its fence
+    uint32_t Allocate(void);
+
+    // FenceValue is signaled after the last command list that may read Index
+    void Free(uint32_t Index, uint64_t FenceValue);
+
+    // Makes the slots freed with a completed fence available again.  Slots are checked in
+    // the order they were freed and the scan stops at the first incomplete fence.
+    template <typename IsCompleteFunc>
+    void ReleaseCompleted(IsCompleteFunc IsComplete)
+    {
+        while (!m_PendingIndices.empty() && IsComplete(m_PendingIndices.front().first))
+        {
+            m_FreeIndices.push_back(m_PendingIndices.front().second);
+            m_PendingIndices.pop_front();
+        }
+    }
+
+    uint32_t GetCapacity(void) const { return m_Capacity; }
+    uint32_t GetLiveCount(void) const { return m_LiveCount; }
+    uint32_t GetPendingCount(void) const { return (uint32_t)m_PendingIndices.size(); }
+    uint32_t GetAvailableCount(void) const { return m_Capacity - m_LiveCount - GetPendingCount(); }
+
+private:
+    uint32_t m_Capacity;
+    uint32_t m_NextUnused;      // slots at and above this one were never handed out
+    uint32_t m_LiveCount;
+    std::vector<uint32_t> m_FreeIndices;
+    std::deque<std::pair<uint64_t, uint32_t>> m_PendingIndices;
+};
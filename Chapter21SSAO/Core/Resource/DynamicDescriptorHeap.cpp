@@ -14,10 +14,10 @@ using namespace Graphics;
 // static members
 std::mutex DynamicDescriptorHeap::sm_Mutex;
 std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> DynamicDescriptorHeap::sm_DescriptorHeapPool[2];
-std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> DynamicDescriptorHeap::sm_RetiredDescriptorHeaps[2];
-std::queue<ID3D12DescriptorHeap*> DynamicDescriptorHeap::sm_AvailableDescriptorHeaps[2];
+std::queue<std::pair<uint64_t, DynamicDescriptorHeap::DescriptorPage>> DynamicDescriptorHeap::sm_RetiredDescriptorHeaps[2];
+std::queue<DynamicDescriptorHeap::DescriptorPage> DynamicDescriptorHeap::sm_AvailableDescriptorHeaps[2];
 
-ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType)
+DynamicDescriptorHeap::DescriptorPage DynamicDescriptorHeap::RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType)
 {
 	std::lock_guard<std::mutex> LockGuard(sm_Mutex);
 
@@ -32,9 +32,23 @@ ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(D3D12_DESCRIP
 
 	if (!sm_AvailableDescriptorHeaps[idx].empty())
 	{
-		ID3D12DescriptorHeap* HeapPtr = sm_AvailableDescriptorHeaps[idx].front();
+		DescriptorPage Page = sm_AvailableDescriptorHeaps[idx].front();
 		sm_AvailableDescriptorHeaps[idx].pop();
-		return HeapPtr;
+		return Page;
+	}
+	else if (idx == 0 && g_BindlessHeap.IsCreated())
+	{
+		DescriptorPage Page;
+		Page.Heap = g_BindlessHeap.GetHeapPointer();
+		if (g_BindlessHeap.AllocateDynamic(kNumDescriptorsPerHeap, Page.FirstDescriptor))
+			return Page;
+
+		// The heap cannot grow, wait for the GPU to release the oldest page instead
+		ASSERT(!sm_RetiredDescriptorHeaps[idx].empty(), "Every dynamic page is in use.  Increase kNumDynamicDescriptors.");
+		g_CommandManager.WaitForFence(sm_RetiredDescriptorHeaps[idx].front().first);
+		Page = sm_RetiredDescriptorHeaps[idx].front().second;
+		sm_RetiredDescriptorHeaps[idx].pop();
+		return Page;
 	}
 	else
 	{
@@ -49,11 +63,16 @@ ID3D12DescriptorHeap* DynamicDescriptorHeap::RequestDescriptorHeap(D3D12_DESCRIP
 		ASSERT_SUCCEEDED(g_Device->CreateDescriptorHeap(&HeapDesc, MY_IID_PPV_ARGS(&HeapPtr)));
 		sm_DescriptorHeapPool[idx].emplace_back(HeapPtr);
 
-		return HeapPtr.Get();
+		DescriptorPage Page;
+		Page.Heap = HeapPtr.Get();
+		Page.FirstDescriptor = DescriptorHandle(
+			HeapPtr->GetCPUDescriptorHandleForHeapStart(),
+			HeapPtr->GetGPUDescriptorHandleForHeapStart());
+		return Page;
 	}
 }
 
-void DynamicDescriptorHeap::DiscardDescriptorHeaps(D3D12_DESCRIPTOR_HEAP_TYPE HeapType, uint64_t FenceValue, const std::vector<ID3D12DescriptorHeap*>& UsedHeaps)
+void DynamicDescriptorHeap::DiscardDescriptorHeaps(D3D12_DESCRIPTOR_HEAP_TYPE HeapType, uint64_t FenceValue, const std::vector<DescriptorPage>& UsedHeaps)
 {
 	std::lock_guard<std::mutex> LockGuard(sm_Mutex);
 
@@ -73,7 +92,10 @@ void DynamicDescriptorHeap::RetireCurrentHeap(void)
 	}
 
 	ASSERT(m_CurrentHeapPtr != nullptr);
-	m_RetiredHeaps.push_back(m_CurrentHeapPtr);
+	DescriptorPage Page;
+	Page.Heap = m_CurrentHeapPtr;
+	Page.FirstDescriptor = m_FirstDescriptor;
+	m_RetiredHeaps.push_back(Page);
 	m_CurrentHeapPtr = nullptr;
 	m_CurrentOffset = 0;
 }
@@ -109,10 +131,9 @@ inline ID3D12DescriptorHeap* DynamicDescriptorHeap::GetHeapPointer()
 	if (m_CurrentHeapPtr == nullptr)
 	{
 		ASSERT(m_CurrentOffset == 0);
-		m_CurrentHeapPtr = RequestDescriptorHeap(m_DescriptorType);
-		m_FirstDescriptor = DescriptorHandle(
-			m_CurrentHeapPtr->GetCPUDescriptorHandleForHeapStart(),
-			m_CurrentHeapPtr->GetGPUDescriptorHandleForHeapStart());
+		DescriptorPage Page = RequestDescriptorHeap(m_DescriptorType);
+		m_CurrentHeapPtr = Page.Heap;
+		m_FirstDescriptor = Page.FirstDescriptor;
 	}
 
 	return m_CurrentHeapPtr;
@@ -123,17 +144,17 @@ uint32_t DynamicDescriptorHeap::DescriptorHandleCache::ComputeStagedSize()
 {
 	// Sum the maximum assigned offsets of stale descriptor tables to determine total needed space.
 	uint32_t NeededSpace = 0;
-	uint32_t RootIndex;
+	unsigned long RootIndex;
 	uint32_t StaleParams = m_StaleRootParamsBitMap;
     // _BitScanReverse找到低位第一个设置为1的位
-	while (_BitScanForward((unsigned long*)&RootIndex, StaleParams))
+	while (_BitScanForward(&RootIndex, StaleParams))
 	{
         // 从位图中移除
 		StaleParams ^= (1 << RootIndex);
 
         // 找到描述符表中分配的最大偏移量
-		uint32_t MaxSetHandle;
-		ASSERT(TRUE == _BitScanReverse((unsigned long*)&MaxSetHandle, m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap),
+		unsigned long MaxSetHandle;
+		ASSERT(TRUE == _BitScanReverse(&MaxSetHandle, m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap),
 			"Root entry marked as stale but has no stale descriptors");
         // 计算所需空间，并加到总空间中。+1 是因为索引是从 0 开始的。
 		NeededSpace += MaxSetHandle + 1;
@@ -151,18 +172,18 @@ void DynamicDescriptorHeap::DescriptorHandleCache::CopyAndBindStaleTables(
     uint32_t TableSize[DescriptorHandleCache::kMaxNumDescriptorTables]; //保存每个描述符表的大小（需要的描述符数量
     uint32_t RootIndices[DescriptorHandleCache::kMaxNumDescriptorTables]; //记录根参数索引
     uint32_t NeededSpace = 0; //计算所需的描述符空间
-    uint32_t RootIndex; //用于存储当前遍历到的根参数索引
+    unsigned long RootIndex; //用于存储当前遍历到的根参数索引
 
     // 遍历需要更新的描述符表
     // Sum the maximum assigned offsets of stale descriptor tables to determine total needed space.
     uint32_t StaleParams = m_StaleRootParamsBitMap;
-    while (_BitScanForward((unsigned long*)&RootIndex, StaleParams))
+    while (_BitScanForward(&RootIndex, StaleParams))
     {
         RootIndices[StaleParamCount] = RootIndex;
         StaleParams ^= (1 << RootIndex);
 
-        uint32_t MaxSetHandle;
-        ASSERT(TRUE == _BitScanReverse((unsigned long*)&MaxSetHandle, m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap),
+        unsigned long MaxSetHandle;
+        ASSERT(TRUE == _BitScanReverse(&MaxSetHandle, m_RootDescriptorTable[RootIndex].AssignedHandlesBitMap),
             "Root entry marked as stale but has no stale descriptors");
 
         NeededSpace += MaxSetHandle + 1;
@@ -24,8 +24,12 @@ public:
 
 	static void DestroyAll(void)
 	{
-		sm_DescriptorHeapPool[0].clear();
-		sm_DescriptorHeapPool[1].clear();
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			sm_DescriptorHeapPool[i].clear();
+			sm_RetiredDescriptorHeaps[i] = {};
+			sm_AvailableDescriptorHeaps[i] = {};
+		}
 	}
 
 	void CleanupUsedHeaps(uint64_t fenceValue);
@@ -70,19 +74,27 @@ public:
 
 private:
 
+	// kNumDescriptorsPerHeap shader-visible descriptors: a heap of their own for samplers, a
+	// page of the bindless heap for views so that heap never has to be unbound
+	struct DescriptorPage
+	{
+		ID3D12DescriptorHeap* Heap;
+		DescriptorHandle FirstDescriptor;
+	};
+
 	// static members
 	static const uint32_t kNumDescriptorsPerHeap = 1024;
 	static std::mutex sm_Mutex;
 	static std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> sm_DescriptorHeapPool[2];
-	static std::queue<std::pair<uint64_t, ID3D12DescriptorHeap*>> sm_RetiredDescriptorHeaps[2];
-	static std::queue<ID3D12DescriptorHeap*> sm_AvailableDescriptorHeaps[2];
+	static std::queue<std::pair<uint64_t, DescriptorPage>> sm_RetiredDescriptorHeaps[2];
+	static std::queue<DescriptorPage> sm_AvailableDescriptorHeaps[2];
 
 	// static methods
 	// request the descriptor heap
-	static ID3D12DescriptorHeap* RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType);
+	static DescriptorPage RequestDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE HeapType);
 	// release the descriptor heap
 	static void DiscardDescriptorHeaps(D3D12_DESCRIPTOR_HEAP_TYPE HeapType, uint64_t FenceValue,
-		const std::vector<ID3D12DescriptorHeap*>& UsedHeaps);
+		const std::vector<DescriptorPage>& UsedHeaps);
 
 	// Non-static members
 	CommandContext& m_OwningContext;
@@ -91,7 +103,7 @@ private:
 	uint32_t m_DescriptorSize;
 	uint32_t m_CurrentOffset;
 	DescriptorHandle m_FirstDescriptor;
-	std::vector<ID3D12DescriptorHeap*> m_RetiredHeaps;
+	std::vector<DescriptorPage> m_RetiredHeaps;
 
 	// Describes a descriptor table entry :
 	// a region of the handle cache and which handles have been set
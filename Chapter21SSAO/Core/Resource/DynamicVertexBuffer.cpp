@@ -0,0 +1,75 @@
+#include "DynamicVertexBuffer.h"
+
+void DynamicVertexBuffer::Create(const std::wstring& Name, uint32_t NumVertices, uint32_t VertexStride, Fence& FrameFence,
+	uint32_t NumFrames)
+{
+	Destroy();
+
+	ASSERT(NumFrames > 0);
+
+	m_NumVertices = NumVertices;
+	m_VertexStride = VertexStride;
+	m_FrameSize = Math::AlignUp((size_t)NumVertices * VertexStride, 256);
+	m_NumFrames = NumFrames;
+	m_CurrentFrame = NumFrames - 1;
+
+	// calls Destroy, so the fence is set after it
+	UploadBuffer::Create(Name, m_FrameSize * NumFrames);
+	m_Fence = &FrameFence;
+
+	// no region has been read yet, and 0 is never ahead of a fence
+	m_FrameFences.assign(NumFrames, 0);
+
+	// upload heaps can stay mapped for the lifetime of the resource
+	m_CpuVirtualAddress = (uint8_t*)Map();
+}
+
+void DynamicVertexBuffer::Destroy(void)
+{
+	if (m_CpuVirtualAddress != nullptr)
+	{
+		// make sure the GPU is no longer reading any region
+		for (uint32_t Frame = 0; Frame < m_NumFrames; ++Frame)
+			WaitForFrame(Frame);
+
+		m_pResource->Unmap(0, nullptr);
+		m_CpuVirtualAddress = nullptr;
+	}
+
+	m_FrameFences.clear();
+	m_Fence = nullptr;
+	UploadBuffer::Destroy();
+}
+
+void* DynamicVertexBuffer::BeginFrame(void)
+{
+	ASSERT(m_CpuVirtualAddress != nullptr);
+
+	m_CurrentFrame = (m_CurrentFrame + 1) % m_NumFrames;
+
+	// normally already complete, this region was last submitted NumFrames frames ago
+	WaitForFrame(m_CurrentFrame);
+
+	return m_CpuVirtualAddress + m_CurrentFrame * m_FrameSize;
+}
+
+void DynamicVertexBuffer::EndFrame(uint64_t FenceValue)
+{
+	m_FrameFences[m_CurrentFrame] = FenceValue;
+}
+
+void DynamicVertexBuffer::WaitForFrame(uint32_t Frame)
+{
+	// D3D12Fence waits through an event, which is not worth it when the value has completed
+	if (m_Fence->GetCompletedValue() < m_FrameFences[Frame])
+		m_Fence->WaitForValue(m_FrameFences[Frame]);
+}
+
+D3D12_VERTEX_BUFFER_VIEW DynamicVertexBuffer::VertexBufferView(void) const
+{
+	D3D12_VERTEX_BUFFER_VIEW VBView;
+	VBView.BufferLocation = m_GpuVirtualAddress + m_CurrentFrame * m_FrameSize;
+	VBView.SizeInBytes = m_NumVertices * m_VertexStride;
+	VBView.StrideInBytes = m_VertexStride;
+	return VBView;
+}
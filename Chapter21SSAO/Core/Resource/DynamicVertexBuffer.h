@@ -0,0 +1,50 @@
+#pragma once
+
+#include "UploadBuffer.h"
+#include "GraphicsCore.h"
+#include "Fence.h"
+
+// A ring of NumFrames vertex regions in one persistently mapped upload buffer.
+// CPU-animated meshes write straight into the current region and bind it as a vertex
+// buffer; a region is only reused once the fence of the frame that last read it has passed.
+// FrameFence is the fence of the queue that reads the buffer, the values given to EndFrame
+// are values of that fence.
+class DynamicVertexBuffer : public UploadBuffer
+{
+public:
+	virtual ~DynamicVertexBuffer() { Destroy(); }
+
+	void Create(const std::wstring& Name, uint32_t NumVertices, uint32_t VertexStride, Fence& FrameFence,
+		uint32_t NumFrames = SWAP_CHAIN_BUFFER_COUNT);
+
+	virtual void Destroy(void) override;
+
+	// move to the next region and return its CPU address. only blocks if the GPU
+	// is still reading that region from NumFrames frames ago
+	void* BeginFrame(void);
+
+	// the fence value of the submission that reads the current region
+	void EndFrame(uint64_t FenceValue);
+
+	D3D12_VERTEX_BUFFER_VIEW VertexBufferView(void) const;
+
+	uint32_t GetVertexCount() const { return m_NumVertices; }
+	uint32_t GetVertexStride() const { return m_VertexStride; }
+
+private:
+
+	// waits for a region's last reader
+	void WaitForFrame(uint32_t Frame);
+
+	uint8_t* m_CpuVirtualAddress = nullptr;
+	Fence* m_Fence = nullptr;
+
+	uint32_t m_NumVertices = 0;
+	uint32_t m_VertexStride = 0;
+	size_t m_FrameSize = 0;
+
+	uint32_t m_NumFrames = 0;
+	uint32_t m_CurrentFrame = 0;
+	// fence value that must complete before frame region i can be rewritten
+	std::vector<uint64_t> m_FrameFences;
+};
@@ -5,6 +5,13 @@
 
 using namespace Graphics;
 
+GpuBuffer::~GpuBuffer()
+{
+	Destroy();
+	FreeDescriptor(m_UAV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	FreeDescriptor(m_SRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
 void GpuBuffer::Create(const std::wstring& name, uint32_t NumElements, uint32_t ElementSize,
 	const void* initialData)
 {
@@ -31,6 +38,12 @@ void GpuBuffer::Create(const std::wstring& name, uint32_t NumElements, uint32_t
 
 	m_GpuVirtualAddress = m_pResource->GetGPUVirtualAddress();
 
+#ifdef RELEASE
+	(void)name;
+#else
+	m_pResource->SetName(name.c_str());
+#endif
+
 	// if initial data is not null
 	if (initialData)
 		CommandContext::InitializeBuffer(*this, initialData, m_BufferSize);
@@ -65,6 +78,12 @@ void GpuBuffer::Create(const std::wstring& name, uint32_t NumElements, uint32_t
 
 	m_GpuVirtualAddress = m_pResource->GetGPUVirtualAddress();
 
+#ifdef RELEASE
+	(void)name;
+#else
+	m_pResource->SetName(name.c_str());
+#endif
+
 	// use upload heap to transfer data to GPU
 	CommandContext::InitializeBuffer(*this, srcData, srcOffset);
 
@@ -88,6 +107,12 @@ void GpuBuffer::CreatePlaced(const std::wstring& name, ID3D12Heap* pBackingHeap,
 
 	m_GpuVirtualAddress = m_pResource->GetGPUVirtualAddress();
 
+#ifdef RELEASE
+	(void)name;
+#else
+	m_pResource->SetName(name.c_str());
+#endif
+
 	if (initialData)
 		CommandContext::InitializeBuffer(*this, initialData, m_BufferSize);
 
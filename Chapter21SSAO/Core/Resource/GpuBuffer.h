@@ -3,13 +3,15 @@
 #include "pch.h"
 #include "GpuResource.h"
 
+class CommandContext;
 class UploadBuffer;
 
 class GpuBuffer : public GpuResource
 {
 public:
 
-	virtual ~GpuBuffer() { Destroy(); };
+	// The views survive Destroy and are reused by the next Create, they are only freed here
+	virtual ~GpuBuffer();
 
 	// create a buffer.
 	// if initial data is provided, it will be copied into the buffer using the default command context
@@ -29,6 +31,7 @@ public:
 
 	D3D12_GPU_VIRTUAL_ADDRESS RootConstantBufferView(void) const { return m_GpuVirtualAddress; }
 
+	// The caller owns the returned descriptor and returns it with Graphics::FreeDescriptor
 	D3D12_CPU_DESCRIPTOR_HANDLE CreateConstantBufferView(uint32_t Offset, uint32_t Size) const;
 
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView(size_t Offset, uint32_t Size, uint32_t Stride) const;
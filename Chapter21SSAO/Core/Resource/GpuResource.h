@@ -6,6 +6,7 @@ class GpuResource
     friend class CommandContext;
     friend class GraphicsContext;
     friend class ComputeContext;
+    friend class ResourceStateTracker;
 
 public:
     GpuResource() :
@@ -7,7 +7,8 @@ using namespace Graphics;
 // declare the static
 LinearAllocatorType LinearAllocatorPageManager::sm_AutoType = kGpuExclusive;
 
-LinearAllocatorPageManager::LinearAllocatorPageManager()
+LinearAllocatorPageManager::LinearAllocatorPageManager() :
+    PagePool(sm_AutoType == kGpuExclusive ? kGpuAllocatorPageSize : kCpuAllocatorPageSize)
 {
     m_AllocationType = sm_AutoType;
     sm_AutoType = (LinearAllocatorType)(sm_AutoType + 1); // cpu
@@ -16,60 +17,30 @@ LinearAllocatorPageManager::LinearAllocatorPageManager()
 
 LinearAllocatorPageManager LinearAllocator::sm_PageManager[2];
 
-LinearAllocationPage* LinearAllocatorPageManager::RequestPage()
+void LinearAllocatorPageManager::DiscardPages(uint64_t FenceValue, const std::vector<LinearAllocationPage*>& UsedPages)
 {
-    std::lock_guard<std::mutex> LockGuard(m_Mutex);
-    
-    // check used pages and make sure GPU completed , then make it available
-    while (!m_RetiredPages.empty() && g_CommandManager.IsFenceComplete(m_RetiredPages.front().first))
-    {
-        m_AvailablePages.push(m_RetiredPages.front().second);
-        m_RetiredPages.pop();
-    }
+    if (UsedPages.empty())
+        return;
 
-    LinearAllocationPage* PagePtr = nullptr;
-
-    // find in availabel pages
-    if (!m_AvailablePages.empty())
-    {
-        PagePtr = m_AvailablePages.front();
-        m_AvailablePages.pop();
-    }
-    else
-    {
-        PagePtr = CreateNewPage();
-        m_PagePool.emplace_back(PagePtr);
-    }
+    // link them up so the whole batch goes onto the retired list at once
+    for (size_t i = 0; i + 1 < UsedPages.size(); ++i)
+        UsedPages[i]->m_NextPooled = UsedPages[i + 1];
+    UsedPages.back()->m_NextPooled = nullptr;
 
-    return PagePtr;
+    PagePool::DiscardPages(FenceValue, UsedPages.front());
 }
 
-void LinearAllocatorPageManager::DiscardPages(uint64_t FenceValue, const std::vector<LinearAllocationPage*>& UsedPages)
+void LinearAllocatorPageManager::DestroyPage(PoolPage* Page)
 {
-    std::lock_guard<std::mutex> LockGuard(m_Mutex);
-    for (auto iter = UsedPages.begin(); iter != UsedPages.end(); ++iter)
-        m_RetiredPages.push(std::make_pair(FenceValue, *iter));
+    delete static_cast<LinearAllocationPage*>(Page);
 }
 
-void LinearAllocatorPageManager::FreeLargePages(uint64_t FenceValue, const std::vector<LinearAllocationPage*>& LargePages)
+bool LinearAllocatorPageManager::IsFenceComplete(uint64_t FenceValue)
 {
-    std::lock_guard<std::mutex> LockGuard(m_Mutex);
-
-    while (!m_DeletionQueue.empty() && g_CommandManager.IsFenceComplete(m_DeletionQueue.front().first))
-    {
-        delete m_DeletionQueue.front().second; // delete the pointer
-        m_DeletionQueue.pop();
-    }
-
-    for (auto iter = LargePages.begin(); iter != LargePages.end(); iter++)
-    {
-        // unmapping the cpu 
-        (*iter)->Unmap();
-        m_DeletionQueue.push(std::make_pair(FenceValue, *iter));
-    }
+    return g_CommandManager.IsFenceComplete(FenceValue);
 }
 
-LinearAllocationPage* LinearAllocatorPageManager::CreateNewPage(size_t PageSize)
+PoolPage* LinearAllocatorPageManager::CreatePage(size_t PageSize)
 {
     D3D12_HEAP_PROPERTIES HeapProps;
     HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
@@ -93,14 +64,14 @@ LinearAllocationPage* LinearAllocatorPageManager::CreateNewPage(size_t PageSize)
     if (m_AllocationType == kGpuExclusive)
     {
         HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-        ResourceDesc.Width = PageSize == 0 ? kGpuAllocatorPageSize : PageSize;
+        ResourceDesc.Width = PageSize;
         ResourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
         DefaultUsage = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
     }
     else
     {
         HeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
-        ResourceDesc.Width = PageSize == 0 ? kCpuAllocatorPageSize : PageSize;
+        ResourceDesc.Width = PageSize;
         ResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
         DefaultUsage = D3D12_RESOURCE_STATE_GENERIC_READ;
     }
@@ -155,8 +126,8 @@ DynAlloc LinearAllocator::Allocate(size_t SizeInBytes, size_t Alignment)
 
 DynAlloc LinearAllocator::AllocateLargePage(size_t SizeInBytes)
 {
-    LinearAllocationPage* OneOff = sm_PageManager[m_AllocationType].CreateNewPage(SizeInBytes);
-    m_LargePageList.push_back(OneOff);
+    LinearAllocationPage* OneOff = sm_PageManager[m_AllocationType].RequestLargePage(SizeInBytes);
+    m_RetiredPages.push_back(OneOff);
 
     DynAlloc ret(*OneOff, 0, SizeInBytes);
     ret.DataPtr = OneOff->m_CpuVirtualAddress;
@@ -176,7 +147,4 @@ void LinearAllocator::CleanupUsedPages(uint64_t FenceID)
 
     sm_PageManager[m_AllocationType].DiscardPages(FenceID, m_RetiredPages);
     m_RetiredPages.clear();
-
-    sm_PageManager[m_AllocationType].FreeLargePages(FenceID, m_LargePageList);
-    m_LargePageList.clear();
-}
\ No newline at end of file
+}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "GpuResource.h"
-#include <queue>
+#include "PagePool.h"
 
 // constant blocks must be multiples of 16 constants @ 16 bytes each
 #define DEFAULT_ALIGN 256
@@ -20,7 +20,7 @@ struct DynAlloc
 	D3D12_GPU_VIRTUAL_ADDRESS GpuAddress; // GPU-visible address
 };
 
-class LinearAllocationPage : public GpuResource
+class LinearAllocationPage final : public GpuResource, public PoolPage
 {
 public:
 
@@ -76,37 +76,32 @@ enum
 	kCpuAllocatorPageSize = 0x200000	// 2MB
 };
 
-class LinearAllocatorPageManager
+// Pages are shared by every LinearAllocator of one type.  Recording threads request and
+// discard them without taking a lock, see PagePool.
+class LinearAllocatorPageManager : public PagePool
 {
 public:
 	LinearAllocatorPageManager();
 
 	// request pages
-	LinearAllocationPage* RequestPage(void);
+	LinearAllocationPage* RequestPage(void) { return static_cast<LinearAllocationPage*>(PagePool::RequestPage()); }
 
-	// create new page with size
-	LinearAllocationPage* CreateNewPage(size_t PageSize = 0);
+	// "Large" pages come from a pool of their own, sized in powers of two
+	LinearAllocationPage* RequestLargePage(size_t PageSize) { return static_cast<LinearAllocationPage*>(PagePool::RequestLargePage(PageSize)); }
 
-	// Discarded pages will get recycled.  This is for fixed size pages.
+	// Discarded pages, fixed size or large, will get recycled once the fence has passed.
 	void DiscardPages(uint64_t FenceID, const std::vector<LinearAllocationPage*>& Pages);
 
-	// Freed pages will be destroyed once their fence has passed.  This is for single-use,
-   // "large" pages.
-	void FreeLargePages(uint64_t FenceValue, const std::vector<LinearAllocationPage*>& Pages);
-
-	void Destroy(void) { m_PagePool.clear(); }
+protected:
+	virtual PoolPage* CreatePage(size_t PageSize) override;
+	virtual void DestroyPage(PoolPage* Page) override;
+	virtual bool IsFenceComplete(uint64_t FenceValue) override;
 
 private:
 
 	static LinearAllocatorType sm_AutoType;
 
 	LinearAllocatorType m_AllocationType;
-	std::vector<std::unique_ptr<LinearAllocationPage>> m_PagePool;
-	std::queue<std::pair<uint64_t, LinearAllocationPage*>> m_RetiredPages;
-	std::queue<std::pair<uint64_t, LinearAllocationPage*>> m_DeletionQueue;
-
-	std::queue<LinearAllocationPage*> m_AvailablePages;
-	std::mutex m_Mutex;
 };
 
 
@@ -133,6 +128,9 @@ public:
 		sm_PageManager[1].Destroy();
 	}
 
+	// Page counts and sizes, with their high-water marks, of all allocators of a type
+	static PagePool::Stats GetStats(LinearAllocatorType Type) { return sm_PageManager[Type].GetStats(); }
+
 private:
 
 	DynAlloc AllocateLargePage(size_t SizeInBytes);
@@ -145,7 +143,7 @@ private:
 	size_t m_CurOffset;
 	LinearAllocationPage* m_CurPage;
 
+	// full pages and large pages, discarded together at the next cleanup
 	std::vector<LinearAllocationPage*> m_RetiredPages;
-	std::vector<LinearAllocationPage*> m_LargePageList;
 };
 
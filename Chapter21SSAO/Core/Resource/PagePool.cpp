@@ -0,0 +1,390 @@
+#include "pch.h"
+#include "PagePool.h"
+
+namespace
+{
+    // Per-thread table from pool serial to that thread's cache.  A slot whose serial does not
+    // match belongs to another pool, or to one that has been destroyed since.
+    struct ThreadCacheSlot
+    {
+        uint64_t Serial;
+        void* Cache;
+    };
+
+    thread_local ThreadCacheSlot t_ThreadCacheSlots[4];
+
+    std::atomic<uint64_t> s_NextSerial{ 1 };
+
+    template <typename T>
+    void RaisePeak(std::atomic<T>& Peak, T Value)
+    {
+        T Current = Peak.load(std::memory_order_relaxed);
+        while (Current < Value && !Peak.compare_exchange_weak(Current, Value, std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+PagePool::PagePool(size_t PageSize) :
+    m_PageSize(PageSize), m_Serial(s_NextSerial.fetch_add(1, std::memory_order_relaxed)),
+    m_RetiredHead(&m_RetiredStub), m_RetiredTail(&m_RetiredStub), m_AvailablePages(nullptr),
+    m_NumPages(0), m_PeakPages(0), m_NumBytes(0), m_PeakBytes(0), m_PagesInUse(0), m_PeakPagesInUse(0),
+    m_LargePagesCreated(0), m_LargePagesReused(0)
+{
+    for (uint32_t i = 0; i < kNumLargeBuckets; ++i)
+    {
+        m_LargePages[i].store(nullptr, std::memory_order_relaxed);
+        m_NumLargePages[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void PagePool::PushList(std::atomic<PoolPage*>& Head, PoolPage* First, PoolPage* Last)
+{
+    PoolPage* Next = Head.load(std::memory_order_relaxed);
+    do
+    {
+        Last->m_NextPooled = Next;
+    } while (!Head.compare_exchange_weak(Next, First, std::memory_order_release, std::memory_order_relaxed));
+}
+
+uint32_t PagePool::LargeBucketOf(size_t Size)
+{
+    uint32_t Bucket = 0;
+    while (((size_t)1 << Bucket) < Size)
+        ++Bucket;
+    return Bucket;
+}
+
+PoolPage* PagePool::RequestPage(void)
+{
+    ThreadCache* Cache = GetThreadCache();
+
+    for (uint32_t Retry = 0; Cache->NumPages == 0; ++Retry)
+    {
+        const bool Reclaimed = ReclaimRetiredPages(Cache);
+        if (Cache->NumPages > 0)
+            break;
+
+        // Take everything available, keep what fits and put the rest back
+        PoolPage* List = m_AvailablePages.exchange(nullptr, std::memory_order_acquire);
+        while (List != nullptr && Cache->NumPages < kMaxCachedPages)
+        {
+            Cache->Pages[Cache->NumPages++] = List;
+            List = List->m_NextPooled;
+        }
+
+        if (List != nullptr)
+        {
+            PoolPage* Last = List;
+            while (Last->m_NextPooled != nullptr)
+                Last = Last->m_NextPooled;
+            PushList(m_AvailablePages, List, Last);
+        }
+
+        if (Reclaimed || Retry == kMaxReclaimRetries)
+            break;
+
+        // The queue may hold pages that are ready, let whoever is in the way finish with it
+        std::this_thread::yield();
+    }
+
+    PoolPage* Page = Cache->NumPages > 0 ? Cache->Pages[--Cache->NumPages] : NewPage(m_PageSize);
+    Page->m_NextPooled = nullptr;
+    MarkInUse();
+    return Page;
+}
+
+PoolPage* PagePool::RequestLargePage(size_t Size)
+{
+    ASSERT(Size > m_PageSize);
+
+    const uint32_t Bucket = LargeBucketOf(Size);
+    ASSERT(Bucket < kNumLargeBuckets);
+
+    PoolPage* Page = nullptr;
+    for (uint32_t Retry = 0; ; ++Retry)
+    {
+        const bool Reclaimed = ReclaimRetiredPages(nullptr);
+        Page = m_LargePages[Bucket].exchange(nullptr, std::memory_order_acquire);
+        if (Page != nullptr || Reclaimed || Retry == kMaxReclaimRetries)
+            break;
+        std::this_thread::yield();
+    }
+
+    if (Page != nullptr)
+    {
+        if (Page->m_NextPooled != nullptr)
+        {
+            PoolPage* Last = Page->m_NextPooled;
+            while (Last->m_NextPooled != nullptr)
+                Last = Last->m_NextPooled;
+            PushList(m_LargePages[Bucket], Page->m_NextPooled, Last);
+        }
+
+        m_NumLargePages[Bucket].fetch_sub(1, std::memory_order_relaxed);
+        m_LargePagesReused.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        Page = NewPage((size_t)1 << Bucket);
+        m_LargePagesCreated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Page->m_NextPooled = nullptr;
+    MarkInUse();
+    return Page;
+}
+
+void PagePool::DiscardPages(uint64_t FenceValue, PoolPage* Pages)
+{
+    if (Pages == nullptr)
+        return;
+
+    uint32_t Count = 1;
+    PoolPage* Last = Pages;
+    Last->m_RetireFence = FenceValue;
+    while (Last->m_NextPooled != nullptr)
+    {
+        Last->m_NextRetired.store(Last->m_NextPooled, std::memory_order_relaxed);
+        Last = Last->m_NextPooled;
+        Last->m_RetireFence = FenceValue;
+        ++Count;
+    }
+
+    m_PagesInUse.fetch_sub(Count, std::memory_order_relaxed);
+    PushRetired(Pages, Last);
+}
+
+void PagePool::Destroy(void)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    // Orphans every thread's slot for this pool
+    m_Serial.store(s_NextSerial.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+
+    for (PoolPage* Page : m_AllPages)
+        DestroyPage(Page);
+    m_AllPages.clear();
+    m_ThreadCaches.clear();
+
+    m_RetiredStub.m_NextRetired.store(nullptr, std::memory_order_relaxed);
+    m_RetiredHead = &m_RetiredStub;
+    m_RetiredTail.store(&m_RetiredStub, std::memory_order_relaxed);
+    m_AvailablePages.store(nullptr, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < kNumLargeBuckets; ++i)
+    {
+        m_LargePages[i].store(nullptr, std::memory_order_relaxed);
+        m_NumLargePages[i].store(0, std::memory_order_relaxed);
+    }
+
+    m_NumPages.store(0, std::memory_order_relaxed);
+    m_NumBytes.store(0, std::memory_order_relaxed);
+    m_PagesInUse.store(0, std::memory_order_relaxed);
+}
+
+PagePool::Stats PagePool::GetStats(void) const
+{
+    Stats Result;
+    Result.NumPages = m_NumPages.load(std::memory_order_relaxed);
+    Result.PeakPages = m_PeakPages.load(std::memory_order_relaxed);
+    Result.NumBytes = m_NumBytes.load(std::memory_order_relaxed);
+    Result.PeakBytes = m_PeakBytes.load(std::memory_order_relaxed);
+    Result.PagesInUse = m_PagesInUse.load(std::memory_order_relaxed);
+    Result.PeakPagesInUse = m_PeakPagesInUse.load(std::memory_order_relaxed);
+    Result.LargePagesCreated = m_LargePagesCreated.load(std::memory_order_relaxed);
+    Result.LargePagesReused = m_LargePagesReused.load(std::memory_order_relaxed);
+    return Result;
+}
+
+PagePool::ThreadCache* PagePool::GetThreadCache(void)
+{
+    const uint64_t Serial = m_Serial.load(std::memory_order_relaxed);
+    ThreadCacheSlot& Slot = t_ThreadCacheSlots[Serial % _countof(t_ThreadCacheSlots)];
+    if (Slot.Serial == Serial)
+        return (ThreadCache*)Slot.Cache;
+
+    // First use on this thread, or the slot was taken by another pool
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+
+    const std::thread::id Self = std::this_thread::get_id();
+    ThreadCache* Cache = nullptr;
+    for (auto& Existing : m_ThreadCaches)
+    {
+        if (Existing->Owner == Self)
+        {
+            Cache = Existing.get();
+            break;
+        }
+    }
+
+    if (Cache == nullptr)
+    {
+        m_ThreadCaches.emplace_back(new ThreadCache);
+        Cache = m_ThreadCaches.back().get();
+        Cache->Owner = Self;
+    }
+
+    Slot.Serial = Serial;
+    Slot.Cache = Cache;
+    return Cache;
+}
+
+void PagePool::PushRetired(PoolPage* First, PoolPage* Last)
+{
+    // Linking the previous tail to First publishes the batch.  Until then the consumer sees the
+    // queue end at the previous tail.
+    Last->m_NextRetired.store(nullptr, std::memory_order_relaxed);
+    PoolPage* Prev = m_RetiredTail.exchange(Last, std::memory_order_acq_rel);
+    Prev->m_NextRetired.store(First, std::memory_order_release);
+}
+
+PoolPage* PagePool::PopCompletedRetired(uint64_t& CheckedFence, bool& CheckedComplete, bool& Stalled)
+{
+    PoolPage* Head = m_RetiredHead;
+    PoolPage* Next = Head->m_NextRetired.load(std::memory_order_acquire);
+
+    if (Head == &m_RetiredStub)
+    {
+        if (Next == nullptr)
+        {
+            Stalled = m_RetiredTail.load(std::memory_order_acquire) != Head;
+            return nullptr;
+        }
+        m_RetiredHead = Next;
+        Head = Next;
+        Next = Next->m_NextRetired.load(std::memory_order_acquire);
+    }
+
+    // Pages discarded together share a fence, test it once for all of them
+    if (Head->m_RetireFence != CheckedFence || CheckedFence == 0)
+    {
+        CheckedFence = Head->m_RetireFence;
+        CheckedComplete = IsFenceComplete(CheckedFence);
+    }
+    if (!CheckedComplete)
+        return nullptr;
+
+    if (Next != nullptr)
+    {
+        m_RetiredHead = Next;
+        return Head;
+    }
+
+    // Head is the last page.  Put the stub behind it so it can be unlinked, unless a push is
+    // halfway through, in which case it is left for the next time.
+    if (m_RetiredTail.load(std::memory_order_acquire) != Head)
+    {
+        Stalled = true;
+        return nullptr;
+    }
+
+    PushRetired(&m_RetiredStub, &m_RetiredStub);
+
+    Next = Head->m_NextRetired.load(std::memory_order_acquire);
+    if (Next == nullptr)
+    {
+        Stalled = true;
+        return nullptr;
+    }
+
+    m_RetiredHead = Next;
+    return Head;
+}
+
+bool PagePool::ReclaimRetiredPages(ThreadCache* Cache)
+{
+    // Somebody else is draining the queue and will make the pages available to everyone
+    if (m_Reclaiming.test_and_set(std::memory_order_acquire))
+        return false;
+
+    PoolPage* ReadyFirst = nullptr;
+    PoolPage* ReadyLast = nullptr;
+    uint64_t CheckedFence = 0;
+    bool CheckedComplete = false;
+    bool Stalled = false;
+
+    while (PoolPage* Page = PopCompletedRetired(CheckedFence, CheckedComplete, Stalled))
+    {
+        Page->m_NextPooled = nullptr;
+
+        if (Page->m_PageSize != m_PageSize)
+        {
+            PoolLargePage(Page);
+        }
+        else if (Cache != nullptr && Cache->NumPages < kMaxCachedPages)
+        {
+            Cache->Pages[Cache->NumPages++] = Page;
+        }
+        else
+        {
+            if (ReadyLast != nullptr)
+                ReadyLast->m_NextPooled = Page;
+            else
+                ReadyFirst = Page;
+            ReadyLast = Page;
+        }
+    }
+
+    m_Reclaiming.clear(std::memory_order_release);
+
+    if (ReadyFirst != nullptr)
+        PushList(m_AvailablePages, ReadyFirst, ReadyLast);
+
+    // A push halfway through hides whatever was discarded after it
+    return !Stalled;
+}
+
+void PagePool::PoolLargePage(PoolPage* Page)
+{
+    const uint32_t Bucket = LargeBucketOf(Page->m_PageSize);
+
+    // A burst of large allocations should not pin its memory forever
+    if (m_NumLargePages[Bucket].fetch_add(1, std::memory_order_relaxed) >= kMaxPooledLargePages)
+    {
+        m_NumLargePages[Bucket].fetch_sub(1, std::memory_order_relaxed);
+        DeletePage(Page);
+        return;
+    }
+
+    PushList(m_LargePages[Bucket], Page, Page);
+}
+
+PoolPage* PagePool::NewPage(size_t Size)
+{
+    PoolPage* Page = CreatePage(Size);
+    Page->m_PageSize = Size;
+
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        m_AllPages.push_back(Page);
+    }
+
+    RaisePeak(m_PeakPages, m_NumPages.fetch_add(1, std::memory_order_relaxed) + 1);
+    RaisePeak(m_PeakBytes, m_NumBytes.fetch_add(Size, std::memory_order_relaxed) + Size);
+    return Page;
+}
+
+void PagePool::DeletePage(PoolPage* Page)
+{
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        for (size_t i = 0; i < m_AllPages.size(); ++i)
+        {
+            if (m_AllPages[i] == Page)
+            {
+                m_AllPages[i] = m_AllPages.back();
+                m_AllPages.pop_back();
+                break;
+            }
+        }
+    }
+
+    m_NumPages.fetch_sub(1, std::memory_order_relaxed);
+    m_NumBytes.fetch_sub(Page->m_PageSize, std::memory_order_relaxed);
+    DestroyPage(Page);
+}
+
+void PagePool::MarkInUse(void)
+{
+    RaisePeak(m_PeakPagesInUse, m_PagesInUse.fetch_add(1, std::memory_order_relaxed) + 1);
+}
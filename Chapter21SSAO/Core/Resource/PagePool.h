@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Links and fence of a page while it sits in one of PagePool's lists
+struct PoolPage
+{
+    PoolPage* m_NextPooled = nullptr;
+    std::atomic<PoolPage*> m_NextRetired{ nullptr };
+    uint64_t m_RetireFence = 0;
+    size_t m_PageSize = 0;
+};
+
+// Recycles fixed-size pages, and pages larger than that in power-of-two size buckets, once
+// the GPU is done with them.
+//
+// Discarded pages go into a lock-free intrusive queue, so they come out in the order of their
+// fences and recycling stops at the first one still in flight.  Any thread may push to it;
+// draining it is left to whichever thread gets there first, the others never wait.  Ready
+// pages sit in lock-free stacks that are only ever pushed to or emptied as a whole, so there
+// is no ABA hazard.  Every thread also keeps a couple of ready pages of its own, which is
+// where most requests are served from.  The mutex guards page creation and destruction only.
+//
+// Creating and destroying pages and testing fences is left to the derived class.
+class PagePool
+{
+public:
+    static const uint32_t kMaxCachedPages = 2;          // per thread
+    static const uint32_t kMaxPooledLargePages = 4;     // per size bucket, the rest is destroyed
+
+    struct Stats
+    {
+        uint32_t NumPages;              // fixed and large pages alive
+        uint32_t PeakPages;
+        uint64_t NumBytes;              // combined size of those pages
+        uint64_t PeakBytes;
+        uint32_t PagesInUse;            // requested and not discarded yet
+        uint32_t PeakPagesInUse;
+        uint32_t LargePagesCreated;
+        uint32_t LargePagesReused;
+    };
+
+    explicit PagePool(size_t PageSize);
+    virtual ~PagePool() {}
+
+    PagePool(const PagePool&) = delete;
+    PagePool& operator=(const PagePool&) = delete;
+
+    PoolPage* RequestPage(void);
+
+    // Size exceeds the page size.  The page returned is the next power of two at least that big.
+    PoolPage* RequestLargePage(size_t Size);
+
+    // Pages is a list linked through m_NextPooled, any mix of fixed and large pages.  They are
+    // handed out again once FenceValue has completed.
+    void DiscardPages(uint64_t FenceValue, PoolPage* Pages);
+
+    // Destroys every page.  Nothing may be using the pool or holding on to its pages.
+    void Destroy(void);
+
+    Stats GetStats(void) const;
+
+protected:
+    virtual PoolPage* CreatePage(size_t Size) = 0;
+    virtual void DestroyPage(PoolPage* Page) = 0;
+    virtual bool IsFenceComplete(uint64_t FenceValue) = 0;
+
+private:
+    static const uint32_t kNumLargeBuckets = 48;
+
+    // Times a request yields to a thread that holds up the retired queue before giving up and
+    // creating a page
+    static const uint32_t kMaxReclaimRetries = 4;
+
+    struct ThreadCache
+    {
+        std::thread::id Owner;
+        uint32_t NumPages = 0;
+        PoolPage* Pages[kMaxCachedPages];
+    };
+
+    static void PushList(std::atomic<PoolPage*>& Head, PoolPage* First, PoolPage* Last);
+    static uint32_t LargeBucketOf(size_t Size);
+
+    ThreadCache* GetThreadCache(void);
+    void PushRetired(PoolPage* First, PoolPage* Last);
+    PoolPage* PopCompletedRetired(uint64_t& CheckedFence, bool& CheckedComplete, bool& Stalled);
+    // False when the queue could not be looked at in full, because another thread is draining
+    // it or a push to it is halfway through
+    bool ReclaimRetiredPages(ThreadCache* Cache);
+    void PoolLargePage(PoolPage* Page);
+    PoolPage* NewPage(size_t Size);
+    void DeletePage(PoolPage* Page);
+    void MarkInUse(void);
+
+    const size_t m_PageSize;
+
+    // Distinguishes this pool, and each Destroy of it, in the per-thread slot table
+    std::atomic<uint64_t> m_Serial;
+
+    // Multi-producer queue with a stub node.  Producers only touch the tail, the head belongs
+    // to whoever holds m_Reclaiming.
+    PoolPage m_RetiredStub;
+    PoolPage* m_RetiredHead;
+    std::atomic<PoolPage*> m_RetiredTail;
+    std::atomic_flag m_Reclaiming = ATOMIC_FLAG_INIT;
+
+    std::atomic<PoolPage*> m_AvailablePages;
+    std::atomic<PoolPage*> m_LargePages[kNumLargeBuckets];
+    std::atomic<uint32_t> m_NumLargePages[kNumLargeBuckets];
+
+    std::atomic<uint32_t> m_NumPages;
+    std::atomic<uint32_t> m_PeakPages;
+    std::atomic<uint64_t> m_NumBytes;
+    std::atomic<uint64_t> m_PeakBytes;
+    std::atomic<uint32_t> m_PagesInUse;
+    std::atomic<uint32_t> m_PeakPagesInUse;
+    std::atomic<uint32_t> m_LargePagesCreated;
+    std::atomic<uint32_t> m_LargePagesReused;
+
+    std::mutex m_Mutex;
+    std::vector<PoolPage*> m_AllPages;
+    std::vector<std::unique_ptr<ThreadCache>> m_ThreadCaches;
+};
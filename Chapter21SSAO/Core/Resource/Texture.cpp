@@ -6,6 +6,11 @@
 
 using namespace Graphics;
 
+Texture::~Texture()
+{
+    FreeDescriptor(m_hCpuDescriptorHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
 //--------------------------------------------------------------------------------------
 // Return the BPP for a particular format
 //--------------------------------------------------------------------------------------
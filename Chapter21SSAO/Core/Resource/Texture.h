@@ -9,8 +9,12 @@ class Texture : public GpuResource
 public:
 	Texture() { m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN; }
 
+	// Takes ownership of Handle, it is freed with the texture
 	Texture(D3D12_CPU_DESCRIPTOR_HANDLE Handle) : m_hCpuDescriptorHandle(Handle) {}
 
+	// Destroy keeps the descriptor for the next Create, it is only freed here
+	~Texture();
+
 	// create a 1-level textures
 	void Create2D(size_t RowPitchBytes, size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitData);
 	void CreateCube(size_t RowPitchBytes, size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitData);
@@ -19,12 +23,6 @@ public:
 	bool CreateDDSFromMemory(const void* memBuffer, size_t fileSize, bool sRGB);
 	void CreatePIXImageFromMemory(const void* memBuffer, size_t fileSize);
 
-	virtual void Destroy() override
-	{
-		GpuResource::Destroy();
-		m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-	}
-
 	const D3D12_CPU_DESCRIPTOR_HANDLE& GetSRV() const { return m_hCpuDescriptorHandle; }
 
 	uint32_t GetWidth() const { return m_Width; }
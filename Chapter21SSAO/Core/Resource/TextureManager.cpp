@@ -16,21 +16,32 @@
 #include "DDSTextureLoader.h"
 #include "Texture.h"
 #include "Utility.h"
-#include "FileUtility.h"
+#include "MappedFile.h"
 #include "GraphicsCommon.h"
 #include "CommandContext.h"
+#include "GraphicsCore.h"
+#include "ThreadPool.h"
 #include <map>
-#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 using namespace std;
 using namespace Graphics;
-using Utility::ByteArray;
 
 //
 // A ManagedTexture allows for multiple threads to request a Texture load of the same
 // file.  It also contains a reference count of the Texture so that it can be freed
 // when it is no longer referenced.
 //
+// The public descriptor is allocated up front and holds a copy of the fallback texture
+// until the load is published, so its handle never changes.  Asynchronous loads create
+// their SRV in a second, staged descriptor that Publish() copies over the public one.
+//
+// Publish() also gives the texture its slot in the bindless heap.  That slot is written once,
+// so shaders never see it change under frames in flight; until then GetBindlessIndex()
+// answers with the fallback's slot.
+//
 // Raw ManagedTexture pointers are not exposed to clients.  
 //
 class ManagedTexture : public Texture
@@ -38,20 +49,30 @@ class ManagedTexture : public Texture
     friend class TextureRef;
 
 public:
-    ManagedTexture( const wstring& FileName );
+    ManagedTexture( const wstring& FileName, eDefaultTexture fallback );
+    ~ManagedTexture();
 
-    void WaitForLoad(void) const;
-    void CreateFromMemory(ByteArray memory, eDefaultTexture fallback, bool sRGB);
+    void WaitForLoad(void);
+    void CreateFromFile(const wstring& fileName, bool sRGB, bool staged);
+    void Publish(void);
 
 private:
 
     bool IsValid(void) const { return m_IsValid; }
-    void Unload();
+    uint32_t GetBindlessIndex(void) const { return m_IsValid ? m_BindlessIndex : GetDefaultTextureIndex(m_Fallback); }
+    void Release();
 
     std::wstring m_MapKey;		// For deleting from the map later
-    bool m_IsValid;
+    eDefaultTexture m_Fallback;
+    uint32_t m_BindlessIndex;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_hStagedSRV;
+    bool m_LoadSucceeded;
+    std::atomic<bool> m_IsValid;
+    std::atomic<size_t> m_ReferenceCount;
+
     bool m_IsLoading;
-    size_t m_ReferenceCount;
+    std::mutex m_LoadMutex;
+    std::condition_variable m_LoadDone;
 };
 
 namespace TextureManager
@@ -59,111 +80,175 @@ namespace TextureManager
     wstring s_RootPath = L"";
     map<wstring, std::unique_ptr<ManagedTexture>> s_TextureCache;
 
+    // Asynchronous loads that finished uploading and wait for Update() to publish them
+    mutex s_PendingMutex;
+    condition_variable s_PendingDone;
+    vector<TextureRef> s_PendingPublish;
+    uint32_t s_InFlightLoads = 0;
+
     void Initialize( const wstring& TextureLibRoot )
     {
         s_RootPath = TextureLibRoot;
     }
 
+    mutex s_Mutex;
+
     void Shutdown( void )
     {
+        WaitForAllLoads();
+
+        lock_guard<mutex> Guard(s_Mutex);
         s_TextureCache.clear();
     }
 
-    mutex s_Mutex;
+    wstring MakeKey( const wstring& fileName, bool forceSRGB )
+    {
+        return forceSRGB ? fileName + L"_sRGB" : fileName;
+    }
 
-    ManagedTexture* FindOrLoadTexture( const wstring& fileName, eDefaultTexture fallback, bool forceSRGB )
+    TextureRef FindOrLoadTexture( const wstring& fileName, eDefaultTexture fallback, bool forceSRGB )
     {
+        wstring key = MakeKey(fileName, forceSRGB);
         ManagedTexture* tex = nullptr;
+        TextureRef ref;
 
         {
             lock_guard<mutex> Guard(s_Mutex);
 
-            wstring key = fileName;
-            if (forceSRGB)
-                key += L"_sRGB";
-
-            // Search for an existing managed texture
+            // Take the reference under the lock so the texture cannot be destroyed in between
             auto iter = s_TextureCache.find(key);
             if (iter != s_TextureCache.end())
             {
-                // If a texture was already created make sure it has finished loading before
-                // returning a point to it.
-                tex = iter->second.get();
-                tex->WaitForLoad();
-                return tex;
+                ref = TextureRef(iter->second.get());
             }
             else
             {
-                // If it's not found, create a new managed texture and start loading it
-                tex = new ManagedTexture(key);
+                tex = new ManagedTexture(key, fallback);
                 s_TextureCache[key].reset(tex);
+                ref = TextureRef(tex);
             }
         }
 
-        Utility::ByteArray ba = Utility::ReadFileSync( s_RootPath + fileName );
-        tex->CreateFromMemory(ba, fallback, forceSRGB);
-
-        // This was the first time it was requested, so indicate that the caller must read the file
-        return tex;
-    }
+        if (tex == nullptr)
+        {
+            // If a texture was already requested make sure it has finished loading before
+            // returning it.  An asynchronous load may still be waiting for Update(), but a
+            // synchronous caller expects a usable texture, so publish it now.
+            ManagedTexture* existing = const_cast<ManagedTexture*>((const ManagedTexture*)ref.Get());
+            existing->WaitForLoad();
+            existing->Publish();
+            return ref;
+        }
 
-    void DestroyTexture(const wstring& key)
-    {
-        lock_guard<mutex> Guard(s_Mutex);
+        tex->CreateFromFile(s_RootPath + fileName, forceSRGB, false);
+        tex->Publish();
 
-        auto iter = s_TextureCache.find(key);
-        if (iter != s_TextureCache.end())
-            s_TextureCache.erase(iter);
+        return ref;
     }
 
 } // namespace TextureManager
 
-ManagedTexture::ManagedTexture( const wstring& FileName )
-    : m_MapKey(FileName), m_IsValid(false), m_IsLoading(true), m_ReferenceCount(0)
+ManagedTexture::ManagedTexture( const wstring& FileName, eDefaultTexture fallback )
+    : m_MapKey(FileName), m_Fallback(fallback), m_BindlessIndex(DescriptorIndexAllocator::kInvalidIndex),
+    m_LoadSucceeded(false), m_IsValid(false), m_ReferenceCount(0), m_IsLoading(true)
 {
-    m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
+    m_hStagedSRV.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
+
+    m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    g_Device->CopyDescriptorsSimple(1, m_hCpuDescriptorHandle, GetDefaultTexture(fallback),
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 }
 
-void ManagedTexture::CreateFromMemory(ByteArray ba, eDefaultTexture fallback, bool forceSRGB)
+ManagedTexture::~ManagedTexture()
 {
-    if (ba->size() == 0)
-    {
-        m_hCpuDescriptorHandle = GetDefaultTexture(fallback);
-    }
-    else
+    g_BindlessHeap.Free(m_BindlessIndex);
+    FreeDescriptor(m_hStagedSRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+void ManagedTexture::CreateFromFile(const wstring& fileName, bool forceSRGB, bool staged)
+{
+    // Mapped, not read: the texels go from the page cache straight into upload memory
+    Utility::MappedFile file;
+    if (file.Open(fileName))
     {
-        // We probably have a texture to load, so let's allocate a new descriptor
-        m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        // Nothing reads the staged descriptor before the load is published, so the worker may
+        // write it.  The public one keeps showing the fallback meanwhile.
+        D3D12_CPU_DESCRIPTOR_HANDLE target = m_hCpuDescriptorHandle;
+        if (staged)
+        {
+            m_hStagedSRV = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+            target = m_hStagedSRV;
+        }
 
-        if ( SUCCEEDED( CreateDDSTextureFromMemory( g_Device, (const uint8_t*)ba->data(), ba->size(),
-            0, forceSRGB, m_pResource.GetAddressOf(), m_hCpuDescriptorHandle) ) )
+        // The upload inside is waited on, so the resource is ready to sample on return
+        if ( SUCCEEDED( CreateDDSTextureFromMemory( g_Device, (const uint8_t*)file.GetData(), file.GetSize(),
+            0, forceSRGB, m_pResource.GetAddressOf(), target) ) )
         {
             m_UsageState = D3D12_RESOURCE_STATE_GENERIC_READ;
-            m_IsValid = true;
+            m_LoadSucceeded = true;
             D3D12_RESOURCE_DESC desc = GetResource()->GetDesc();
             m_Width = (uint32_t)desc.Width;
             m_Height = desc.Height;
             m_Depth = desc.DepthOrArraySize;
         }
-        else
-        {
-            g_Device->CopyDescriptorsSimple(1, m_hCpuDescriptorHandle, GetDefaultTexture(fallback),
-                D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-        }
     }
 
-    m_IsLoading = false;
+    {
+        lock_guard<mutex> Guard(m_LoadMutex);
+        m_IsLoading = false;
+    }
+    m_LoadDone.notify_all();
 }
 
-void ManagedTexture::WaitForLoad( void ) const
+void ManagedTexture::Publish( void )
 {
-    while ((volatile bool&)m_IsLoading)
-        this_thread::yield();
+    // Update() and a synchronous request for the same file may both get here
+    lock_guard<mutex> Guard(m_LoadMutex);
+
+    if (!m_LoadSucceeded || m_IsValid)
+        return;
+
+    if (m_hStagedSRV.ptr != D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+    {
+        g_Device->CopyDescriptorsSimple(1, m_hCpuDescriptorHandle, m_hStagedSRV,
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        // Nothing reads the staged copy again
+        FreeDescriptor(m_hStagedSRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        m_hStagedSRV.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
+    }
+
+    m_BindlessIndex = g_BindlessHeap.Allocate(m_hCpuDescriptorHandle);
+
+    m_IsValid = true;
 }
 
-void ManagedTexture::Unload()
+void ManagedTexture::WaitForLoad( void )
 {
-    TextureManager::DestroyTexture(m_MapKey);
+    unique_lock<mutex> Lock(m_LoadMutex);
+    m_LoadDone.wait(Lock, [this] { return !m_IsLoading; });
+}
+
+void ManagedTexture::Release()
+{
+    // While other references remain, dropping one needs no lock
+    size_t count = m_ReferenceCount.load();
+    while (count > 1)
+    {
+        if (m_ReferenceCount.compare_exchange_weak(count, count - 1))
+            return;
+    }
+
+    // Maybe the last one.  New references come from the cache under s_Mutex, so under it a
+    // count that reached zero stays there and nobody else deletes the texture first.  Erase
+    // by iterator: the key lives in the texture being destroyed.
+    lock_guard<mutex> Guard(TextureManager::s_Mutex);
+    if (--m_ReferenceCount == 0)
+    {
+        auto iter = TextureManager::s_TextureCache.find(m_MapKey);
+        if (iter != TextureManager::s_TextureCache.end())
+            TextureManager::s_TextureCache.erase(iter);
+    }
 }
 
 TextureRef::TextureRef( const TextureRef& ref ) : m_ref(ref.m_ref)
@@ -180,27 +265,29 @@ TextureRef::TextureRef( ManagedTexture* tex ) : m_ref(tex)
 
 TextureRef::~TextureRef()
 {
-    if (m_ref != nullptr && --m_ref->m_ReferenceCount == 0)
-        m_ref->Unload();
+    if (m_ref != nullptr)
+        m_ref->Release();
 }
 
 void TextureRef::operator= (std::nullptr_t)
 {
     if (m_ref != nullptr)
-        --m_ref->m_ReferenceCount;
+        m_ref->Release();
 
     m_ref = nullptr;
 }
 
-void TextureRef::operator= (TextureRef& rhs)
+void TextureRef::operator= (const TextureRef& rhs)
 {
-    if (m_ref != nullptr)
-        --m_ref->m_ReferenceCount;
+    ManagedTexture* old = m_ref;
 
     m_ref = rhs.m_ref;
 
     if (m_ref != nullptr)
         ++m_ref->m_ReferenceCount;
+
+    if (old != nullptr)
+        old->Release();
 }
 
 bool TextureRef::IsValid() const
@@ -227,6 +314,14 @@ D3D12_CPU_DESCRIPTOR_HANDLE TextureRef::GetSRV() const
         return GetDefaultTexture(kMagenta2D);
 }
 
+uint32_t TextureRef::GetBindlessIndex() const
+{
+    if (m_ref != nullptr)
+        return m_ref->GetBindlessIndex();
+    else
+        return GetDefaultTextureIndex(kMagenta2D);
+}
+
 
 TextureRef TextureManager::LoadDDSFromFile( const wstring& filePath, bool forceSRGB, eDefaultTexture fallback)
 {
@@ -237,3 +332,77 @@ TextureRef TextureManager::LoadDDSFromFile( const string& filePath, eDefaultText
 {
     return LoadDDSFromFile(Utility::UTF8ToWideString(filePath), forceSRGB, fallback);
 }
+
+TextureRef TextureManager::LoadDDSFromFileAsync( const wstring& filePath, bool forceSRGB, eDefaultTexture fallback)
+{
+    wstring key = MakeKey(filePath, forceSRGB);
+    ManagedTexture* tex = nullptr;
+    TextureRef ref;
+
+    {
+        lock_guard<mutex> Guard(s_Mutex);
+
+        // Already requested, whether it finished or not: share it
+        auto iter = s_TextureCache.find(key);
+        if (iter != s_TextureCache.end())
+            return TextureRef(iter->second.get());
+
+        tex = new ManagedTexture(key, fallback);
+        s_TextureCache[key].reset(tex);
+        ref = TextureRef(tex);
+    }
+
+    {
+        lock_guard<mutex> Guard(s_PendingMutex);
+        ++s_InFlightLoads;
+    }
+
+    // The job's copy of the reference keeps the texture alive even if the caller drops it
+    wstring fullPath = s_RootPath + filePath;
+    ThreadPool::Submit([ref, tex, fullPath, forceSRGB]() mutable
+    {
+        tex->CreateFromFile(fullPath, forceSRGB, true);
+
+        {
+            lock_guard<mutex> Guard(s_PendingMutex);
+            // Hand the reference over before the count drops, so that nothing outlives Shutdown()
+            s_PendingPublish.push_back(ref);
+            ref = nullptr;
+            --s_InFlightLoads;
+        }
+        s_PendingDone.notify_all();
+    });
+
+    return ref;
+}
+
+void TextureManager::Update( void )
+{
+    vector<TextureRef> ready;
+
+    {
+        lock_guard<mutex> Guard(s_PendingMutex);
+        ready.swap(s_PendingPublish);
+    }
+
+    // Dropping the references may destroy textures nobody wants anymore, which takes s_Mutex,
+    // so this happens outside s_PendingMutex.
+    for (TextureRef& ref : ready)
+        const_cast<ManagedTexture*>((const ManagedTexture*)ref.Get())->Publish();
+}
+
+uint32_t TextureManager::GetPendingLoadCount( void )
+{
+    lock_guard<mutex> Guard(s_PendingMutex);
+    return s_InFlightLoads;
+}
+
+void TextureManager::WaitForAllLoads( void )
+{
+    {
+        unique_lock<mutex> Lock(s_PendingMutex);
+        s_PendingDone.wait(Lock, [] { return s_InFlightLoads == 0; });
+    }
+
+    Update();
+}
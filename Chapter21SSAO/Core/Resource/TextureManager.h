@@ -40,6 +40,23 @@ namespace TextureManager
     // texture cannot be found, ref->IsValid() will return false.
     TextureRef LoadDDSFromFile( const std::wstring& filePath, bool sRGB = false, eDefaultTexture fallback = kMagenta2D);
     TextureRef LoadDDSFromFile( const std::string& filePath, eDefaultTexture fallback = kMagenta2D, bool sRGB = false );
+
+    // Returns immediately.  The reference owns its descriptor from the start, holding a copy of
+    // the fallback texture, and the file is read and uploaded on the ThreadPool.  Once the upload
+    // has completed, the next Update() writes the real SRV into that same descriptor, so handles
+    // copied out of GetSRV() early pick up the texture without being refreshed.  IsValid() turns
+    // true at that point.
+    TextureRef LoadDDSFromFileAsync( const std::wstring& filePath, bool sRGB = false, eDefaultTexture fallback = kMagenta2D);
+
+    // Publishes the SRVs of every asynchronous load that has finished uploading.  Called once per
+    // frame before the application updates, on the thread that records rendering commands.
+    void Update(void);
+
+    // Number of asynchronous loads still reading or uploading
+    uint32_t GetPendingLoadCount(void);
+
+    // Blocks until every asynchronous load has finished, then publishes them
+    void WaitForAllLoads(void);
 }
 
 // Forward declaration; private implementation
@@ -59,7 +76,7 @@ public:
     ~TextureRef();
 
     void operator= (std::nullptr_t);
-    void operator= (TextureRef& rhs);
+    void operator= (const TextureRef& rhs);
 
     // Check that this points to a valid texture (which loaded successfully)
     bool IsValid() const;
@@ -68,6 +85,10 @@ public:
     // returns a valid descriptor handle (specified by the fallback)
     D3D12_CPU_DESCRIPTOR_HANDLE GetSRV() const;
 
+    // Gets the slot in the bindless heap.  Until the texture is published (or if it failed
+    // to load) this is the slot of the fallback texture, so read it again every frame.
+    uint32_t GetBindlessIndex() const;
+
     // Get the texture pointer.  Client is responsible to not dereference
     // null pointers.
     const Texture* Get( void ) const;
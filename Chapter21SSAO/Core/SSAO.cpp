@@ -58,39 +58,6 @@ SSAO::~SSAO()
 	m_SSAOMap.Destroy();
 }
 
-void SSAO::ComputeSSAO(GraphicsContext& gfxContext,DepthBuffer& depthMap)
-{
-	gfxContext.SetViewportAndScissor(m_Viewport, m_ScissorRect);
-
-	gfxContext.TransitionResource(m_SSAOMap, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
-
-	gfxContext.TransitionResource(m_NormalMap, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-	gfxContext.TransitionResource(depthMap, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-
-	// clear ssao map
-	gfxContext.ClearColor(m_SSAOMap);
-
-	// binding render target
-	gfxContext.SetRenderTarget(m_SSAOMap.GetRTV());
-
-	// set Root Signature
-	gfxContext.SetRootSignature(m_RootSig);
-	// set PSO
-	gfxContext.SetPipelineState(m_PSO);
-	// set SRV CBV 
-	gfxContext.SetDynamicConstantBufferView(0, sizeof(SsaoPassConstants), &m_ssaoCB);
-	gfxContext.SetDynamicDescriptor(1, 0, m_NormalMap.GetSRV());
-	gfxContext.SetDynamicDescriptor(2, 0, depthMap.GetDepthSRV());
-
-	// draw fullscreen quad
-	gfxContext.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	gfxContext.SetVertexBuffers(0, 0, nullptr);
-	gfxContext.SetIndexBuffer(nullptr);
-	gfxContext.DrawInstanced(6, 1, 0, 0);
-
-	gfxContext.TransitionResource(m_SSAOMap, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-}
-
 void SSAO::UpdateCB(Math::Camera& camera)
 {
 	XMMATRIX proj = camera.GetProjMatrix();
@@ -45,8 +45,6 @@ public:
 	D3D12_VIEWPORT Viewport() const { return m_Viewport; }
 	D3D12_RECT ScissorRect() const { return m_ScissorRect; }
 
-	void ComputeSSAO(GraphicsContext& gfxContext,DepthBuffer& depthMap);
-
 	void UpdateCB(Math::Camera& camera);
 
 private:
@@ -0,0 +1,74 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//--------------------------------------------------------------------------------------
+//
+// Validates a DDS file in memory and works out where each subresource lives in it.
+// Needs no device or command context, so a loader can size and create the resource
+// first and then read the texels straight out of a mapped file.
+//
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <d3d12.h>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4005)
+#endif
+#include <stdint.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <vector>
+
+struct DDSSubresourceLayout
+{
+    size_t Offset;          // from the start of the file, magic included
+    size_t RowPitch;        // bytes per row of pixels, or of 4x4 blocks for BC formats
+    size_t SlicePitch;      // bytes per depth slice
+    size_t NumRows;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Depth;
+};
+
+struct DDSTextureLayout
+{
+    uint32_t ResourceDimension = 0;     // D3D12_RESOURCE_DIMENSION
+    DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+    uint32_t Width = 0;                 // of the largest mip kept
+    uint32_t Height = 0;
+    uint32_t Depth = 0;
+    uint32_t MipCount = 0;              // mips kept, after SkippedMips
+    uint32_t ArraySize = 0;             // six per cube for cube maps
+    uint32_t SkippedMips = 0;           // leading mips larger than maxsize
+    bool IsCubeMap = false;
+
+    // ArraySize * MipCount entries in D3D12 subresource order
+    std::vector<DDSSubresourceLayout> Subresources;
+};
+
+// Checks the magic, header sizes, format and dimension limits, and that every subresource
+// fits inside ddsDataSize.  Mips with a dimension above maxsize (0 = no limit) are dropped
+// from the layout.
+HRESULT GetDDSTextureLayout( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                             _In_ size_t ddsDataSize,
+                             _In_ size_t maxsize,
+                             _Out_ DDSTextureLayout& layout );
+
+size_t BitsPerPixel( _In_ DXGI_FORMAT fmt );
+
+void GetSurfaceInfo( _In_ size_t width,
+                     _In_ size_t height,
+                     _In_ DXGI_FORMAT fmt,
+                     _Out_opt_ size_t* outNumBytes,
+                     _Out_opt_ size_t* outRowBytes,
+                     _Out_opt_ size_t* outNumRows );
@@ -22,10 +22,14 @@
 
 #include <d3d12.h>
 
+#ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4005)
+#endif
 #include <stdint.h>
+#ifdef _MSC_VER
 #pragma warning(pop)
+#endif
 
 enum DDS_ALPHA_MODE
 {
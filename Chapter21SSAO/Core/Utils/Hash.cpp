@@ -0,0 +1,208 @@
+#include "pch.h"
+#include "Hash.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HASH_X86 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define HASH_X86 0
+#endif
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define HASH_ARM64 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <arm_acle.h>
+#endif
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#else
+#define HASH_ARM64 0
+#endif
+
+// GCC and Clang only emit CRC instructions inside functions that ask for them; MSVC always
+// does.  That keeps the rest of the build at its baseline instruction set.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define HASH_TARGET(Features)
+#else
+#define HASH_TARGET(Features) __attribute__((target(Features)))
+#endif
+
+namespace
+{
+    typedef size_t (*HashRangeFunc)(const uint32_t*, const uint32_t*, size_t);
+
+    const uint64_t kMul0 = 0x9E3779B97F4A7C15ull;
+    const uint64_t kMul1 = 0xBF58476D1CE4E5B9ull;
+    const uint64_t kMul2 = 0x94D049BB133111EBull;
+
+    inline uint64_t Load64(const uint32_t* Ptr)
+    {
+        uint64_t Value;
+        memcpy(&Value, Ptr, sizeof(Value));
+        return Value;
+    }
+
+    inline uint64_t RotateLeft(uint64_t Value, int Bits)
+    {
+        return (Value << Bits) | (Value >> (64 - Bits));
+    }
+
+    // splitmix64 finalizer: every input bit affects every output bit
+    inline uint64_t Avalanche(uint64_t Hash)
+    {
+        Hash = (Hash ^ (Hash >> 30)) * kMul1;
+        Hash = (Hash ^ (Hash >> 27)) * kMul2;
+        return Hash ^ (Hash >> 31);
+    }
+
+    // Portable path: one multiply-rotate-multiply round per 64-bit word
+    size_t HashRangeScalar(const uint32_t* Begin, const uint32_t* End, size_t Hash)
+    {
+        uint64_t H = (uint64_t)Hash ^ ((uint64_t)(End - Begin) * kMul0);
+
+        const uint32_t* Iter = Begin;
+        for (; Iter + 2 <= End; Iter += 2)
+            H = RotateLeft(H ^ (Load64(Iter) * kMul0), 29) * kMul1;
+
+        if (Iter < End)
+            H = RotateLeft(H ^ (*Iter * kMul0), 29) * kMul1;
+
+        return (size_t)Avalanche(H);
+    }
+
+#if HASH_X86
+
+#define HASH_CRC_TARGET HASH_TARGET("sse4.2")
+#define HASH_CRC_NAME "SSE4.2 CRC32"
+
+    HASH_CRC_TARGET inline uint32_t CrcStep64(uint32_t Crc, const uint32_t* Ptr)
+    {
+#if defined(_M_X64) || defined(__x86_64__)
+        return (uint32_t)_mm_crc32_u64(Crc, Load64(Ptr));
+#else
+        return _mm_crc32_u32(_mm_crc32_u32(Crc, Ptr[0]), Ptr[1]);
+#endif
+    }
+
+    HASH_CRC_TARGET inline uint32_t CrcStep32(uint32_t Crc, uint32_t Word)
+    {
+        return _mm_crc32_u32(Crc, Word);
+    }
+
+    bool CpuSupportsCRC32(void)
+    {
+#ifdef _MSC_VER
+        int Info[4];
+        __cpuid(Info, 1);
+        return (Info[2] & (1 << 20)) != 0;
+#else
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+
+#elif HASH_ARM64
+
+#define HASH_CRC_TARGET HASH_TARGET("crc")
+#define HASH_CRC_NAME "ARMv8 CRC32"
+
+    HASH_CRC_TARGET inline uint32_t CrcStep64(uint32_t Crc, const uint32_t* Ptr)
+    {
+        return __crc32cd(Crc, Load64(Ptr));
+    }
+
+    HASH_CRC_TARGET inline uint32_t CrcStep32(uint32_t Crc, uint32_t Word)
+    {
+        return __crc32cw(Crc, Word);
+    }
+
+    bool CpuSupportsCRC32(void)
+    {
+#if defined(_WIN32)
+        return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__linux__)
+        return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#elif defined(__APPLE__)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+#endif
+
+#if HASH_X86 || HASH_ARM64
+
+    // CRC32C takes one u64 per cycle but each step waits about three cycles on the previous
+    // one, so three streams over consecutive thirds of the input run side by side.  Their
+    // three 32-bit results are folded into one 64-bit hash.
+    HASH_CRC_TARGET size_t HashRangeCRC32(const uint32_t* Begin, const uint32_t* End, size_t Hash)
+    {
+        const size_t NumWords = End - Begin;
+        const size_t Third = NumWords / 6 * 2;
+
+        uint32_t Crc0 = (uint32_t)Hash;
+        uint32_t Crc1 = (uint32_t)((uint64_t)Hash >> 32);
+        uint32_t Crc2 = (uint32_t)Hash ^ 0x9E3779B9u;
+
+        const uint32_t* Iter0 = Begin;
+        const uint32_t* Iter1 = Begin + Third;
+        const uint32_t* Iter2 = Begin + 2 * Third;
+        for (const uint32_t* const End0 = Iter1; Iter0 < End0; Iter0 += 2, Iter1 += 2, Iter2 += 2)
+        {
+            Crc0 = CrcStep64(Crc0, Iter0);
+            Crc1 = CrcStep64(Crc1, Iter1);
+            Crc2 = CrcStep64(Crc2, Iter2);
+        }
+
+        // up to five words that don't split three ways
+        for (; Iter2 + 2 <= End; Iter2 += 2)
+            Crc2 = CrcStep64(Crc2, Iter2);
+        if (Iter2 < End)
+            Crc2 = CrcStep32(Crc2, *Iter2);
+
+        uint64_t H = ((uint64_t)Crc1 << 32 | Crc0) ^ (Crc2 * kMul0) ^ (NumWords * kMul1);
+        return (size_t)Avalanche(H);
+    }
+
+#endif
+
+    struct Implementation
+    {
+        HashRangeFunc Func;
+        const char* Name;
+    };
+
+    Implementation SelectImplementation(void)
+    {
+#if HASH_X86 || HASH_ARM64
+        if (CpuSupportsCRC32())
+            return { HashRangeCRC32, HASH_CRC_NAME };
+#endif
+        return { HashRangeScalar, "Scalar" };
+    }
+
+    const Implementation& GetImplementation(void)
+    {
+        // thread-safe, and safe to reach from other static initializers
+        static const Implementation s_Implementation = SelectImplementation();
+        return s_Implementation;
+    }
+}
+
+size_t Utility::HashRange(const uint32_t* const Begin, const uint32_t* const End, size_t Hash)
+{
+    return GetImplementation().Func(Begin, End, Hash);
+}
+
+const char* Utility::GetHashRangeImplementation(void)
+{
+    return GetImplementation().Name;
+}
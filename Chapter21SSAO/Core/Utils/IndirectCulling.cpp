@@ -0,0 +1,89 @@
+#include "IndirectCulling.h"
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    // D3D flushes 32 bit float denormals to zero on the input and output of arithmetic, the CPU
+    // keeps them; going through these for every step makes both round the same way
+    float Flush(float Value)
+    {
+        return std::fabs(Value) < FLT_MIN ? 0.0f * Value : Value;
+    }
+
+    float Mul(float A, float B)
+    {
+        return Flush(Flush(A) * Flush(B));
+    }
+
+    float Add(float A, float B)
+    {
+        return Flush(Flush(A) + Flush(B));
+    }
+
+    const float* WorldOf(const float* Worlds, size_t WorldStride, uint32_t ObjectIndex)
+    {
+        return (const float*)((const char*)Worlds + ObjectIndex * WorldStride);
+    }
+}
+
+bool Utility::IsInstanceVisible(const IndirectInstance& Instance, const float World[16], const float Planes[6][4])
+{
+    if (!(Instance.Radius >= 0.0f))
+        return true;
+
+    // World holds the transpose, so W[i][j] of the row vector matrix is World[j * 4 + i]
+    auto W = [World](int i, int j) { return World[j * 4 + i]; };
+
+    const float* C = Instance.Center;
+    float Center[3];
+    for (int j = 0; j < 3; ++j)
+        Center[j] = Add(Add(Add(Mul(C[0], W(0, j)), Mul(C[1], W(1, j))), Mul(C[2], W(2, j))), W(3, j));
+
+    // squared length of the longest axis, the sphere grows by that much at most
+    float Scale2 = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        float Length2 = Add(Add(Mul(W(i, 0), W(i, 0)), Mul(W(i, 1), W(i, 1))), Mul(W(i, 2), W(i, 2)));
+        Scale2 = Length2 > Scale2 ? Length2 : Scale2;
+    }
+    float Radius2 = Mul(Mul(Instance.Radius, Instance.Radius), Scale2);
+
+    for (int p = 0; p < 6; ++p)
+    {
+        const float* Plane = Planes[p];
+        float Distance = Add(Add(Add(Mul(Plane[0], Center[0]), Mul(Plane[1], Center[1])), Mul(Plane[2], Center[2])), Plane[3]);
+        if (Distance < 0.0f && Mul(Distance, Distance) > Radius2)
+            return false;
+    }
+    return true;
+}
+
+void Utility::CullInstances(const IndirectInstance* Instances, const IndirectBatch* Batches, size_t BatchCount,
+    const float* Worlds, size_t WorldStride, const float Planes[6][4],
+    IndirectDrawCommand* Commands, uint32_t* Counts)
+{
+    for (size_t b = 0; b < BatchCount; ++b)
+    {
+        const IndirectBatch& Batch = Batches[b];
+
+        // the shader takes the batch kIndirectCullGroupSize instances at a time and places them
+        // by a prefix sum, which comes down to keeping them in order
+        uint32_t Written = 0;
+        for (uint32_t i = 0; i < Batch.InstanceCount; ++i)
+        {
+            const IndirectInstance& Instance = Instances[Batch.FirstInstance + i];
+            if (!IsInstanceVisible(Instance, WorldOf(Worlds, WorldStride, Instance.ObjectIndex), Planes))
+                continue;
+
+            IndirectDrawCommand& Command = Commands[Batch.FirstInstance + Written++];
+            Command.ObjectIndex = Instance.ObjectIndex;
+            Command.IndexCountPerInstance = Instance.IndexCount;
+            Command.InstanceCount = 1;
+            Command.StartIndexLocation = Instance.StartIndexLocation;
+            Command.BaseVertexLocation = Instance.BaseVertexLocation;
+            Command.StartInstanceLocation = 0;
+        }
+        Counts[b] = Written;
+    }
+}
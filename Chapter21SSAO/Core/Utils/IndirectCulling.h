@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Utility
+{
+    // One draw the GPU may cull. The sphere is in object space; a negative radius is never culled.
+    // Same layout as IndirectInstance in CSCullInstances.hlsl.
+    struct IndirectInstance
+    {
+        float Center[3];
+        float Radius;
+        uint32_t ObjectIndex;
+        uint32_t IndexCount;
+        uint32_t StartIndexLocation;
+        int32_t BaseVertexLocation;
+    };
+
+    // Instances [FirstInstance, FirstInstance + InstanceCount) share pipeline state and buffers
+    // and go out with one ExecuteIndirect. Padded to 16 bytes for the structured buffer.
+    struct IndirectBatch
+    {
+        uint32_t FirstInstance;
+        uint32_t InstanceCount;
+        uint32_t Pad[2];
+    };
+
+    // What the command signature reads per draw: the object index root constant, followed by
+    // the D3D12_DRAW_INDEXED_ARGUMENTS
+    struct IndirectDrawCommand
+    {
+        uint32_t ObjectIndex;
+        uint32_t IndexCountPerInstance;
+        uint32_t InstanceCount;
+        uint32_t StartIndexLocation;
+        int32_t BaseVertexLocation;
+        uint32_t StartInstanceLocation;
+    };
+
+    // Threads of a group of CSCullInstances.hlsl; one group compacts one batch
+    static const uint32_t kIndirectCullGroupSize = 64;
+
+    // World is the transposed world matrix as the object constants hold it, Planes are world
+    // space as from ExtractFrustumPlanes. The sphere grows by the largest axis scale and is out
+    // when it is entirely behind one plane. It compares squares to stay clear of sqrt, and
+    // rounds and flushes denormals step by step in the order the shader does, so both agree
+    // bit for bit.
+    bool IsInstanceVisible(const IndirectInstance& Instance, const float World[16], const float Planes[6][4]);
+
+    // The CPU reference of CSCullInstances.hlsl. For every batch the visible instances are
+    // written in order to Commands[FirstInstance...] and their number to Counts[batch]; the
+    // other commands of the batch are left alone. Worlds holds the world matrix of object
+    // index i at WorldStride * i bytes.
+    void CullInstances(const IndirectInstance* Instances, const IndirectBatch* Batches, size_t BatchCount,
+        const float* Worlds, size_t WorldStride, const float Planes[6][4],
+        IndirectDrawCommand* Commands, uint32_t* Counts);
+}
@@ -0,0 +1,118 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <filesystem>
+#endif
+
+using namespace Utility;
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::wstring& FileName)
+{
+    Close();
+
+    HANDLE File = CreateFileW(FileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (File == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+    {
+        CloseHandle(File);
+        return false;
+    }
+
+    HANDLE Mapping = CreateFileMappingW(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (Mapping == nullptr)
+    {
+        CloseHandle(File);
+        return false;
+    }
+
+    void* View = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+    if (View == nullptr)
+    {
+        CloseHandle(Mapping);
+        CloseHandle(File);
+        return false;
+    }
+
+    m_File = File;
+    m_Mapping = Mapping;
+    m_Data = (const std::byte*)View;
+    m_Size = (size_t)FileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::Close(void)
+{
+    if (m_Data != nullptr)
+        UnmapViewOfFile(m_Data);
+    if (m_Mapping != nullptr)
+        CloseHandle(m_Mapping);
+    if (m_File != nullptr)
+        CloseHandle(m_File);
+
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Mapping = nullptr;
+    m_File = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::wstring& FileName)
+{
+    Close();
+
+    int File = open(std::filesystem::path(FileName).c_str(), O_RDONLY);
+    if (File < 0)
+        return false;
+
+    struct stat FileStat;
+    if (fstat(File, &FileStat) != 0 || FileStat.st_size == 0)
+    {
+        close(File);
+        return false;
+    }
+
+    void* View = mmap(nullptr, (size_t)FileStat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+    if (View == MAP_FAILED)
+    {
+        close(File);
+        return false;
+    }
+
+    m_File = File;
+    m_Data = (const std::byte*)View;
+    m_Size = (size_t)FileStat.st_size;
+    return true;
+}
+
+void MappedFile::Close(void)
+{
+    if (m_Data != nullptr)
+        munmap((void*)m_Data, m_Size);
+    if (m_File >= 0)
+        close(m_File);
+
+    m_Data = nullptr;
+    m_Size = 0;
+    m_File = -1;
+}
+
+#endif
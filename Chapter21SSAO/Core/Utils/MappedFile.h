@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Utility
+{
+    // Read-only memory mapping of a whole file. The view stays valid until Close or destruction,
+    // so loaders can point straight into it instead of reading the file into a buffer first.
+    class MappedFile
+    {
+    public:
+        MappedFile() {}
+        ~MappedFile() { Close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::wstring& FileName);
+        void Close(void);
+
+        bool IsOpen(void) const { return m_Data != nullptr; }
+        const std::byte* GetData(void) const { return m_Data; }
+        size_t GetSize(void) const { return m_Size; }
+
+    private:
+        const std::byte* m_Data = nullptr;
+        size_t m_Size = 0;
+
+#ifdef _WIN32
+        void* m_File = nullptr;
+        void* m_Mapping = nullptr;
+#else
+        int m_File = -1;
+#endif
+    };
+
+} // namespace Utility
@@ -0,0 +1,355 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // FIFO post-transform cache kept as the time each vertex went in, so a lookup is one
+    // subtraction and flushing it is bumping the clock
+    class FifoCache
+    {
+    public:
+        FifoCache(size_t VertexCount, uint32_t CacheSize)
+            : m_Stamps(VertexCount, 0), m_Time(CacheSize + 1), m_CacheSize(CacheSize) {}
+
+        // true when the vertex had to be transformed
+        bool Access(uint32_t Vertex)
+        {
+            if (m_Time - m_Stamps[Vertex] <= m_CacheSize)
+                return false;
+            m_Stamps[Vertex] = m_Time++;
+            return true;
+        }
+
+        void Flush(void) { m_Time += m_CacheSize + 1; }
+
+    private:
+        std::vector<uint32_t> m_Stamps;
+        uint32_t m_Time;
+        uint32_t m_CacheSize;
+    };
+
+    // Triangles using each vertex
+    struct Adjacency
+    {
+        std::vector<uint32_t> Offsets;
+        std::vector<uint32_t> Counts;
+        std::vector<uint32_t> Triangles;
+
+        Adjacency(const uint32_t* Indices, size_t IndexCount, size_t VertexCount)
+            : Offsets(VertexCount, 0), Counts(VertexCount, 0), Triangles(IndexCount)
+        {
+            for (size_t i = 0; i < IndexCount; ++i)
+                Counts[Indices[i]]++;
+
+            uint32_t Offset = 0;
+            for (size_t v = 0; v < VertexCount; ++v)
+            {
+                Offsets[v] = Offset;
+                Offset += Counts[v];
+            }
+
+            std::vector<uint32_t> Next(Offsets);
+            for (size_t i = 0; i < IndexCount; ++i)
+                Triangles[Next[Indices[i]]++] = (uint32_t)(i / 3);
+        }
+    };
+
+    void TriangleCentroidAndNormal(const float* Positions, size_t Stride, const uint32_t* Triangle,
+        float Centroid[3], float Normal[3])
+    {
+        const float* P[3];
+        for (int i = 0; i < 3; ++i)
+            P[i] = (const float*)((const char*)Positions + Triangle[i] * Stride);
+
+        float E1[3], E2[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            Centroid[i] = (P[0][i] + P[1][i] + P[2][i]) / 3.0f;
+            E1[i] = P[1][i] - P[0][i];
+            E2[i] = P[2][i] - P[0][i];
+        }
+
+        // length is twice the area, so sums of these are area weighted
+        Normal[0] = E1[1] * E2[2] - E1[2] * E2[1];
+        Normal[1] = E1[2] * E2[0] - E1[0] * E2[2];
+        Normal[2] = E1[0] * E2[1] - E1[1] * E2[0];
+    }
+}
+
+Utility::VertexCacheStats Utility::AnalyzeVertexCache(const uint32_t* Indices, size_t IndexCount, size_t VertexCount,
+    size_t VertexSize, uint32_t CacheSize)
+{
+    VertexCacheStats Stats = {};
+    if (IndexCount < 3)
+        return Stats;
+
+    const size_t kLineSize = 64;
+    const size_t kLineCount = 4096 / kLineSize;
+
+    FifoCache Cache(VertexCount, CacheSize);
+    std::vector<size_t> Lines(kLineCount, ~(size_t)0);
+    std::vector<bool> Referenced(VertexCount, false);
+
+    size_t Transformed = 0;
+    size_t Unique = 0;
+    size_t BytesFetched = 0;
+
+    for (size_t i = 0; i < IndexCount; ++i)
+    {
+        uint32_t Vertex = Indices[i];
+        if (!Referenced[Vertex])
+        {
+            Referenced[Vertex] = true;
+            ++Unique;
+        }
+
+        if (!Cache.Access(Vertex))
+            continue;
+        ++Transformed;
+
+        // only a vertex that has to be transformed is read from the vertex buffer
+        size_t First = Vertex * VertexSize / kLineSize;
+        size_t Last = (Vertex * VertexSize + VertexSize - 1) / kLineSize;
+        for (size_t Line = First; Line <= Last; ++Line)
+        {
+            if (Lines[Line % kLineCount] != Line)
+            {
+                Lines[Line % kLineCount] = Line;
+                BytesFetched += kLineSize;
+            }
+        }
+    }
+
+    Stats.ACMR = (float)Transformed / (float)(IndexCount / 3);
+    Stats.ATVR = (float)Transformed / (float)Unique;
+    Stats.Overfetch = (float)BytesFetched / (float)(Unique * VertexSize);
+    return Stats;
+}
+
+void Utility::OptimizeVertexCache(uint32_t* Destination, const uint32_t* Indices, size_t IndexCount, size_t VertexCount,
+    uint32_t CacheSize, std::vector<uint32_t>* Clusters)
+{
+    const size_t TriangleCount = IndexCount / 3;
+    if (Clusters != nullptr)
+        Clusters->clear();
+    if (TriangleCount == 0)
+        return;
+
+    Adjacency Adj(Indices, TriangleCount * 3, VertexCount);
+
+    std::vector<uint32_t> Live(Adj.Counts);
+    std::vector<uint32_t> Stamps(VertexCount, 0);
+    std::vector<bool> Emitted(TriangleCount, false);
+    std::vector<uint32_t> DeadEnds;
+    std::vector<uint32_t> Candidates;
+
+    uint32_t Time = CacheSize + 1;
+    uint32_t Cursor = 0;
+    size_t Output = 0;
+
+    int64_t Fanning = Indices[0];
+    if (Clusters != nullptr)
+        Clusters->push_back(0);
+
+    while (Fanning >= 0)
+    {
+        // emit every triangle left around the fanning vertex
+        Candidates.clear();
+
+        const uint32_t* Triangles = Adj.Triangles.data() + Adj.Offsets[(size_t)Fanning];
+        for (uint32_t i = 0; i < Adj.Counts[(size_t)Fanning]; ++i)
+        {
+            uint32_t Triangle = Triangles[i];
+            if (Emitted[Triangle])
+                continue;
+
+            for (int Corner = 0; Corner < 3; ++Corner)
+            {
+                uint32_t Vertex = Indices[Triangle * 3 + Corner];
+                Destination[Output++] = Vertex;
+                DeadEnds.push_back(Vertex);
+                Candidates.push_back(Vertex);
+                Live[Vertex]--;
+
+                if (Time - Stamps[Vertex] > CacheSize)
+                    Stamps[Vertex] = Time++;
+            }
+            Emitted[Triangle] = true;
+        }
+
+        // Next fanning vertex: the one of those with triangles left that has been in the cache
+        // longest, as long as fanning it will not push it out
+        int64_t Best = -1;
+        int64_t BestPriority = -1;
+        for (uint32_t Vertex : Candidates)
+        {
+            if (Live[Vertex] == 0)
+                continue;
+
+            int64_t Priority = 0;
+            if (Time - Stamps[Vertex] + 2 * Live[Vertex] <= CacheSize)
+                Priority = Time - Stamps[Vertex];
+
+            if (Priority > BestPriority)
+            {
+                Best = Vertex;
+                BestPriority = Priority;
+            }
+        }
+
+        if (Best >= 0)
+        {
+            Fanning = Best;
+            continue;
+        }
+
+        // Dead end, go back to recently used vertices, then to whatever is left in input order
+        Fanning = -1;
+        while (!DeadEnds.empty())
+        {
+            uint32_t Vertex = DeadEnds.back();
+            DeadEnds.pop_back();
+            if (Live[Vertex] > 0)
+            {
+                Fanning = Vertex;
+                break;
+            }
+        }
+
+        while (Fanning < 0 && Cursor < VertexCount)
+        {
+            if (Live[Cursor] > 0)
+                Fanning = Cursor;
+            ++Cursor;
+        }
+
+        if (Fanning >= 0 && Clusters != nullptr)
+            Clusters->push_back((uint32_t)(Output / 3));
+    }
+}
+
+void Utility::OptimizeOverdraw(uint32_t* Indices, size_t IndexCount, const float* Positions, size_t PositionStride,
+    size_t VertexCount, const std::vector<uint32_t>& Clusters, uint32_t CacheSize, float Threshold)
+{
+    const size_t TriangleCount = IndexCount / 3;
+    if (TriangleCount == 0 || Clusters.empty())
+        return;
+
+    // Each cluster starts with an empty cache once the clusters are reordered, so cut one
+    // wherever the part since the last cut has an ACMR close enough to that of the whole
+    FifoCache Cache(VertexCount, CacheSize);
+    std::vector<uint32_t> Starts;
+
+    for (size_t c = 0; c < Clusters.size(); ++c)
+    {
+        const uint32_t Begin = Clusters[c];
+        const uint32_t End = c + 1 < Clusters.size() ? Clusters[c + 1] : (uint32_t)TriangleCount;
+
+        Cache.Flush();
+        uint32_t ClusterMisses = 0;
+        for (uint32_t t = Begin; t < End; ++t)
+        {
+            for (int Corner = 0; Corner < 3; ++Corner)
+                ClusterMisses += Cache.Access(Indices[t * 3 + Corner]) ? 1 : 0;
+        }
+        const float Limit = Threshold * (float)ClusterMisses / (float)(End - Begin);
+
+        Starts.push_back(Begin);
+        Cache.Flush();
+        uint32_t Misses = 0;
+        uint32_t First = Begin;
+        for (uint32_t t = Begin; t < End; ++t)
+        {
+            for (int Corner = 0; Corner < 3; ++Corner)
+                Misses += Cache.Access(Indices[t * 3 + Corner]) ? 1 : 0;
+
+            if (t + 1 < End && (float)Misses <= Limit * (float)(t + 1 - First))
+            {
+                Starts.push_back(t + 1);
+                Cache.Flush();
+                Misses = 0;
+                First = t + 1;
+            }
+        }
+    }
+
+    const size_t ClusterCount = Starts.size();
+    Starts.push_back((uint32_t)TriangleCount);
+
+    // area weighted centroid and normal of every cluster and of the whole mesh
+    std::vector<float> ClusterCentroids(ClusterCount * 3, 0.0f);
+    std::vector<float> ClusterNormals(ClusterCount * 3, 0.0f);
+    std::vector<float> ClusterAreas(ClusterCount, 0.0f);
+    float MeshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float MeshArea = 0.0f;
+
+    for (size_t c = 0; c < ClusterCount; ++c)
+    {
+        for (uint32_t t = Starts[c]; t < Starts[c + 1]; ++t)
+        {
+            float Centroid[3], Normal[3];
+            TriangleCentroidAndNormal(Positions, PositionStride, Indices + t * 3, Centroid, Normal);
+
+            float Area = std::sqrt(Normal[0] * Normal[0] + Normal[1] * Normal[1] + Normal[2] * Normal[2]);
+            for (int i = 0; i < 3; ++i)
+            {
+                ClusterCentroids[c * 3 + i] += Centroid[i] * Area;
+                ClusterNormals[c * 3 + i] += Normal[i];
+                MeshCentroid[i] += Centroid[i] * Area;
+            }
+            ClusterAreas[c] += Area;
+            MeshArea += Area;
+        }
+    }
+
+    if (MeshArea > 0.0f)
+    {
+        for (int i = 0; i < 3; ++i)
+            MeshCentroid[i] /= MeshArea;
+    }
+
+    // The further out a cluster sits along its own normal, the more of the mesh it can cover
+    std::vector<float> Keys(ClusterCount, 0.0f);
+    for (size_t c = 0; c < ClusterCount; ++c)
+    {
+        const float* N = &ClusterNormals[c * 3];
+        float Length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+        if (ClusterAreas[c] <= 0.0f || Length <= 0.0f)
+            continue;
+
+        float Key = 0.0f;
+        for (int i = 0; i < 3; ++i)
+            Key += (ClusterCentroids[c * 3 + i] / ClusterAreas[c] - MeshCentroid[i]) * N[i];
+        Keys[c] = Key / Length;
+    }
+
+    std::vector<uint32_t> Order(ClusterCount);
+    for (size_t c = 0; c < ClusterCount; ++c)
+        Order[c] = (uint32_t)c;
+    std::stable_sort(Order.begin(), Order.end(), [&Keys](uint32_t A, uint32_t B) { return Keys[A] > Keys[B]; });
+
+    std::vector<uint32_t> Source(Indices, Indices + TriangleCount * 3);
+    size_t Output = 0;
+    for (uint32_t c : Order)
+    {
+        for (uint32_t i = Starts[c] * 3; i < Starts[c + 1] * 3; ++i)
+            Indices[Output++] = Source[i];
+    }
+}
+
+size_t Utility::OptimizeVertexFetch(uint32_t* Indices, size_t IndexCount, size_t VertexCount, std::vector<uint32_t>& Remap)
+{
+    Remap.assign(VertexCount, kUnusedVertex);
+
+    uint32_t NextVertex = 0;
+    for (size_t i = 0; i < IndexCount; ++i)
+    {
+        uint32_t& Index = Indices[i];
+        if (Remap[Index] == kUnusedVertex)
+            Remap[Index] = NextVertex++;
+        Index = Remap[Index];
+    }
+
+    return NextVertex;
+}
@@ -0,0 +1,405 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    struct Vector3
+    {
+        double x, y, z;
+    };
+
+    Vector3 operator-(const Vector3& A, const Vector3& B) { return { A.x - B.x, A.y - B.y, A.z - B.z }; }
+    double Dot(const Vector3& A, const Vector3& B) { return A.x * B.x + A.y * B.y + A.z * B.z; }
+    Vector3 Cross(const Vector3& A, const Vector3& B)
+    {
+        return { A.y * B.z - A.z * B.y, A.z * B.x - A.x * B.z, A.x * B.y - A.y * B.x };
+    }
+
+    // Sum of squared distances to a set of weighted planes, kept as the symmetric 4x4 matrix.
+    // Dividing by Weight turns it into a mean squared distance.
+    struct Quadric
+    {
+        double A2, B2, C2, AB, AC, BC, AD, BD, CD, D2;
+        double Weight;
+
+        void AddPlane(const Vector3& N, double D, double W)
+        {
+            A2 += W * N.x * N.x; B2 += W * N.y * N.y; C2 += W * N.z * N.z;
+            AB += W * N.x * N.y; AC += W * N.x * N.z; BC += W * N.y * N.z;
+            AD += W * N.x * D; BD += W * N.y * D; CD += W * N.z * D;
+            D2 += W * D * D;
+            Weight += W;
+        }
+
+        void Add(const Quadric& Q)
+        {
+            A2 += Q.A2; B2 += Q.B2; C2 += Q.C2; AB += Q.AB; AC += Q.AC; BC += Q.BC;
+            AD += Q.AD; BD += Q.BD; CD += Q.CD; D2 += Q.D2; Weight += Q.Weight;
+        }
+
+        double Evaluate(const Vector3& P) const
+        {
+            double E = A2 * P.x * P.x + B2 * P.y * P.y + C2 * P.z * P.z
+                + 2.0 * (AB * P.x * P.y + AC * P.x * P.z + BC * P.y * P.z)
+                + 2.0 * (AD * P.x + BD * P.y + CD * P.z) + D2;
+            return std::max(E, 0.0);
+        }
+    };
+
+    enum VertexKind : uint8_t { kManifold, kBorder, kLocked };
+
+    // border planes stand up from the surface along open edges, weighted up so borders keep their shape
+    const double kBorderWeight = 10.0;
+
+    // a collapse may not turn a triangle further than this (cosine of about 75 degrees)
+    const double kMinNormalDot = 0.25;
+
+    uint64_t EdgeKey(uint32_t A, uint32_t B) { return ((uint64_t)A << 32) | B; }
+
+    class Simplifier
+    {
+    public:
+        Simplifier(const float* Positions, size_t Stride, size_t VertexCount)
+            : m_Positions(VertexCount), m_Kinds(VertexCount, kManifold), m_Quadrics(VertexCount)
+        {
+            for (size_t v = 0; v < VertexCount; ++v)
+            {
+                const float* P = (const float*)((const char*)Positions + v * Stride);
+                m_Positions[v] = { P[0], P[1], P[2] };
+            }
+        }
+
+        void Classify(const uint32_t* Indices, size_t IndexCount);
+        void BuildQuadrics(const uint32_t* Indices, size_t IndexCount);
+        size_t CollapsePass(uint32_t* Indices, size_t IndexCount, size_t TargetIndexCount, double MaxCost, double& PassCost);
+
+    private:
+        struct Collapse
+        {
+            uint32_t From;
+            uint32_t To;
+            double Cost;
+        };
+
+        void BuildEdges(const uint32_t* Indices, size_t IndexCount);
+        bool FlipsTriangles(const uint32_t* Indices, uint32_t From, uint32_t To) const;
+
+        std::vector<Vector3> m_Positions;
+        std::vector<VertexKind> m_Kinds;
+        std::vector<Quadric> m_Quadrics;
+        std::unordered_map<uint64_t, uint32_t> m_Edges;     // half edges of the current mesh, for border tests
+
+        // triangles around every vertex, rebuilt each pass
+        std::vector<uint32_t> m_Offsets;
+        std::vector<uint32_t> m_Counts;
+        std::vector<uint32_t> m_Triangles;
+    };
+
+    void Simplifier::BuildEdges(const uint32_t* Indices, size_t IndexCount)
+    {
+        m_Edges.clear();
+        m_Edges.reserve(IndexCount);
+        for (size_t i = 0; i < IndexCount; ++i)
+        {
+            uint32_t A = Indices[i];
+            uint32_t B = Indices[i - i % 3 + (i + 1) % 3];
+            m_Edges[EdgeKey(A, B)]++;
+        }
+    }
+
+    void Simplifier::Classify(const uint32_t* Indices, size_t IndexCount)
+    {
+        const size_t VertexCount = m_Positions.size();
+
+        // several vertices at one position are an attribute seam
+        std::unordered_map<uint64_t, uint32_t> FirstAtPosition;
+        std::vector<uint32_t> Used(VertexCount, 0);
+        for (size_t i = 0; i < IndexCount; ++i)
+            Used[Indices[i]] = 1;
+
+        for (size_t v = 0; v < VertexCount; ++v)
+        {
+            if (!Used[v])
+                continue;
+
+            float P[3] = { (float)m_Positions[v].x, (float)m_Positions[v].y, (float)m_Positions[v].z };
+            uint32_t Bits[3];
+            memcpy(Bits, P, sizeof(Bits));
+            uint64_t Hash = (Bits[0] * 73856093ull) ^ (Bits[1] * 19349663ull) ^ (Bits[2] * 83492791ull);
+
+            auto It = FirstAtPosition.emplace(Hash, (uint32_t)v);
+            if (!It.second)
+            {
+                const Vector3& Other = m_Positions[It.first->second];
+                if (Other.x == m_Positions[v].x && Other.y == m_Positions[v].y && Other.z == m_Positions[v].z)
+                {
+                    m_Kinds[v] = kLocked;
+                    m_Kinds[It.first->second] = kLocked;
+                }
+            }
+        }
+
+        BuildEdges(Indices, IndexCount);
+
+        // an edge without its opposite is on a border, one used more than once is not manifold
+        for (auto& Edge : m_Edges)
+        {
+            uint32_t A = (uint32_t)(Edge.first >> 32);
+            uint32_t B = (uint32_t)Edge.first;
+            auto Opposite = m_Edges.find(EdgeKey(B, A));
+
+            if (Edge.second > 1 || (Opposite != m_Edges.end() && Opposite->second > 1))
+            {
+                m_Kinds[A] = kLocked;
+                m_Kinds[B] = kLocked;
+            }
+            else if (Opposite == m_Edges.end())
+            {
+                if (m_Kinds[A] == kManifold)
+                    m_Kinds[A] = kBorder;
+                if (m_Kinds[B] == kManifold)
+                    m_Kinds[B] = kBorder;
+            }
+        }
+    }
+
+    void Simplifier::BuildQuadrics(const uint32_t* Indices, size_t IndexCount)
+    {
+        memset(m_Quadrics.data(), 0, m_Quadrics.size() * sizeof(Quadric));
+
+        for (size_t t = 0; t + 2 < IndexCount; t += 3)
+        {
+            const Vector3& P0 = m_Positions[Indices[t + 0]];
+            const Vector3& P1 = m_Positions[Indices[t + 1]];
+            const Vector3& P2 = m_Positions[Indices[t + 2]];
+
+            Vector3 N = Cross(P1 - P0, P2 - P0);
+            double Length = std::sqrt(Dot(N, N));
+            if (Length == 0.0)
+                continue;
+            N = { N.x / Length, N.y / Length, N.z / Length };
+
+            // area weighted, so small triangles do not count as much as large ones
+            const double Area = 0.5 * Length;
+            for (int Corner = 0; Corner < 3; ++Corner)
+                m_Quadrics[Indices[t + Corner]].AddPlane(N, -Dot(N, P0), Area);
+
+            for (int Corner = 0; Corner < 3; ++Corner)
+            {
+                uint32_t A = Indices[t + Corner];
+                uint32_t B = Indices[t + (Corner + 1) % 3];
+                if (m_Edges.find(EdgeKey(B, A)) != m_Edges.end())
+                    continue;
+
+                Vector3 Edge = m_Positions[B] - m_Positions[A];
+                double EdgeLength = std::sqrt(Dot(Edge, Edge));
+                if (EdgeLength == 0.0)
+                    continue;
+
+                Vector3 BorderNormal = Cross(Edge, N);
+                BorderNormal = { BorderNormal.x / EdgeLength, BorderNormal.y / EdgeLength, BorderNormal.z / EdgeLength };
+                double D = -Dot(BorderNormal, m_Positions[A]);
+
+                m_Quadrics[A].AddPlane(BorderNormal, D, kBorderWeight * EdgeLength * EdgeLength);
+                m_Quadrics[B].AddPlane(BorderNormal, D, kBorderWeight * EdgeLength * EdgeLength);
+            }
+        }
+    }
+
+    bool Simplifier::FlipsTriangles(const uint32_t* Indices, uint32_t From, uint32_t To) const
+    {
+        const uint32_t* Triangles = m_Triangles.data() + m_Offsets[From];
+        for (uint32_t i = 0; i < m_Counts[From]; ++i)
+        {
+            const uint32_t* T = Indices + Triangles[i] * 3;
+            if (T[0] == To || T[1] == To || T[2] == To)
+                continue;   // one of the triangles the collapse removes
+
+            Vector3 P[3], Q[3];
+            for (int Corner = 0; Corner < 3; ++Corner)
+            {
+                P[Corner] = m_Positions[T[Corner]];
+                Q[Corner] = T[Corner] == From ? m_Positions[To] : P[Corner];
+            }
+
+            Vector3 Before = Cross(P[1] - P[0], P[2] - P[0]);
+            Vector3 After = Cross(Q[1] - Q[0], Q[2] - Q[0]);
+            double Scale = std::sqrt(Dot(Before, Before) * Dot(After, After));
+            if (Scale == 0.0 || Dot(Before, After) < kMinNormalDot * Scale)
+                return true;
+        }
+        return false;
+    }
+
+    size_t Simplifier::CollapsePass(uint32_t* Indices, size_t IndexCount, size_t TargetIndexCount, double MaxCost, double& PassCost)
+    {
+        const size_t VertexCount = m_Positions.size();
+        const size_t TriangleCount = IndexCount / 3;
+
+        // collapses along a border make new border edges
+        BuildEdges(Indices, IndexCount);
+
+        m_Counts.assign(VertexCount, 0);
+        m_Offsets.resize(VertexCount);
+        m_Triangles.resize(IndexCount);
+        for (size_t i = 0; i < IndexCount; ++i)
+            m_Counts[Indices[i]]++;
+        uint32_t Offset = 0;
+        for (size_t v = 0; v < VertexCount; ++v)
+        {
+            m_Offsets[v] = Offset;
+            Offset += m_Counts[v];
+        }
+        std::vector<uint32_t> Next(m_Offsets);
+        for (size_t i = 0; i < IndexCount; ++i)
+            m_Triangles[Next[Indices[i]]++] = (uint32_t)(i / 3);
+
+        // every half edge a vertex could collapse along, cheapest first
+        std::vector<Collapse> Candidates;
+        Candidates.reserve(IndexCount);
+        for (size_t t = 0; t < TriangleCount; ++t)
+        {
+            for (int Corner = 0; Corner < 3; ++Corner)
+            {
+                uint32_t From = Indices[t * 3 + Corner];
+                uint32_t To = Indices[t * 3 + (Corner + 1) % 3];
+
+                for (int Direction = 0; Direction < 2; ++Direction, std::swap(From, To))
+                {
+                    if (m_Kinds[From] == kLocked || From == To)
+                        continue;
+
+                    // a border vertex stays on the border, and only moves along it
+                    if (m_Kinds[From] == kBorder &&
+                        (m_Kinds[To] != kBorder || (m_Edges.find(EdgeKey(From, To)) != m_Edges.end() &&
+                            m_Edges.find(EdgeKey(To, From)) != m_Edges.end())))
+                        continue;
+
+                    Quadric Q = m_Quadrics[From];
+                    Q.Add(m_Quadrics[To]);
+                    double Cost = Q.Weight > 0.0 ? Q.Evaluate(m_Positions[To]) / Q.Weight : 0.0;
+                    Candidates.push_back({ From, To, Cost });
+                }
+            }
+        }
+
+        std::sort(Candidates.begin(), Candidates.end(), [](const Collapse& A, const Collapse& B) { return A.Cost < B.Cost; });
+
+        // A collapse takes out about two triangles. Everything around a collapse is left alone
+        // for the rest of the pass, so the flip tests see the triangles as they will be.
+        const size_t Wanted = std::max<size_t>((IndexCount - TargetIndexCount) / 6, 1);
+        std::vector<uint32_t> Remap(VertexCount);
+        for (size_t v = 0; v < VertexCount; ++v)
+            Remap[v] = (uint32_t)v;
+        std::vector<uint8_t> Touched(VertexCount, 0);
+
+        size_t Collapsed = 0;
+        PassCost = 0.0;
+        for (const Collapse& C : Candidates)
+        {
+            if (C.Cost > MaxCost || Collapsed >= Wanted)
+                break;
+            if (Touched[C.From] || Touched[C.To])
+                continue;
+            if (FlipsTriangles(Indices, C.From, C.To))
+                continue;
+
+            Remap[C.From] = C.To;
+            m_Quadrics[C.To].Add(m_Quadrics[C.From]);
+            PassCost = std::max(PassCost, C.Cost);
+            ++Collapsed;
+
+            const uint32_t* Triangles = m_Triangles.data() + m_Offsets[C.From];
+            for (uint32_t i = 0; i < m_Counts[C.From]; ++i)
+            {
+                for (int Corner = 0; Corner < 3; ++Corner)
+                    Touched[Indices[Triangles[i] * 3 + Corner]] = 1;
+            }
+        }
+
+        if (Collapsed == 0)
+            return IndexCount;
+
+        size_t Written = 0;
+        for (size_t t = 0; t < TriangleCount; ++t)
+        {
+            uint32_t A = Remap[Indices[t * 3 + 0]];
+            uint32_t B = Remap[Indices[t * 3 + 1]];
+            uint32_t C = Remap[Indices[t * 3 + 2]];
+            if (A == B || B == C || C == A)
+                continue;
+
+            Indices[Written++] = A;
+            Indices[Written++] = B;
+            Indices[Written++] = C;
+        }
+        return Written;
+    }
+}
+
+size_t Utility::SimplifyMesh(uint32_t* Destination, const uint32_t* Indices, size_t IndexCount,
+    const float* Positions, size_t PositionStride, size_t VertexCount,
+    size_t TargetIndexCount, float TargetError, float* ResultError)
+{
+    IndexCount -= IndexCount % 3;
+    memcpy(Destination, Indices, IndexCount * sizeof(uint32_t));
+
+    Simplifier S(Positions, PositionStride, VertexCount);
+    S.Classify(Destination, IndexCount);
+    S.BuildQuadrics(Destination, IndexCount);
+
+    const double MaxCost = (double)TargetError * TargetError;
+    double Cost = 0.0;
+
+    while (IndexCount > TargetIndexCount)
+    {
+        double PassCost = 0.0;
+        size_t Remaining = S.CollapsePass(Destination, IndexCount, TargetIndexCount, MaxCost, PassCost);
+        if (Remaining == IndexCount)
+            break;
+
+        IndexCount = Remaining;
+        Cost = std::max(Cost, PassCost);
+    }
+
+    if (ResultError != nullptr)
+        *ResultError = (float)std::sqrt(Cost);
+    return IndexCount;
+}
+
+std::vector<Utility::MeshLod> Utility::GenerateLods(std::vector<uint32_t>& Indices, const float* Positions,
+    size_t PositionStride, size_t VertexCount, uint32_t LodCount, float Ratio)
+{
+    std::vector<MeshLod> Lods;
+    Lods.push_back({ 0, (uint32_t)Indices.size(), 0.0f });
+
+    std::vector<uint32_t> Simplified;
+    while (Lods.size() < LodCount)
+    {
+        const MeshLod& Previous = Lods.back();
+
+        const size_t Target = (size_t)(Previous.IndexCount / 3 * Ratio) * 3;
+        Simplified.resize(Previous.IndexCount);
+
+        float Error = 0.0f;
+        size_t Count = SimplifyMesh(Simplified.data(), Indices.data() + Previous.StartIndex, Previous.IndexCount,
+            Positions, PositionStride, VertexCount, Target, FLT_MAX, &Error);
+
+        // not worth a level of its own
+        if (Count == 0 || Count > Previous.IndexCount - (Previous.IndexCount - Target) / 2)
+            break;
+
+        // errors are measured against the level before, so they add up along the chain
+        MeshLod Lod = { (uint32_t)Indices.size(), (uint32_t)Count, Previous.Error + Error };
+        Indices.resize(Indices.size() + Count);
+        OptimizeVertexCache(Indices.data() + Lod.StartIndex, Simplified.data(), Count, VertexCount);
+        Lods.push_back(Lod);
+    }
+
+    return Lods;
+}
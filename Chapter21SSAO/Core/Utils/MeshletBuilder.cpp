@@ -0,0 +1,256 @@
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    const float* PositionOf(const float* Positions, size_t Stride, uint32_t Vertex)
+    {
+        return (const float*)((const char*)Positions + Vertex * Stride);
+    }
+
+    void ComputeBounds(Utility::MeshletBounds& Bounds, const Utility::MeshletMesh& Mesh, const Utility::Meshlet& M,
+        const float* Positions, size_t Stride)
+    {
+        const uint32_t* Vertices = Mesh.Vertices.data() + M.VertexOffset;
+        const uint8_t* Triangles = Mesh.Triangles.data() + M.TriangleOffset;
+
+        // sphere around the box of the vertices
+        float Min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float Max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t v = 0; v < M.VertexCount; ++v)
+        {
+            const float* P = PositionOf(Positions, Stride, Vertices[v]);
+            for (int i = 0; i < 3; ++i)
+            {
+                Min[i] = std::min(Min[i], P[i]);
+                Max[i] = std::max(Max[i], P[i]);
+            }
+        }
+
+        float RadiusSq = 0.0f;
+        for (int i = 0; i < 3; ++i)
+            Bounds.Center[i] = 0.5f * (Min[i] + Max[i]);
+        for (uint32_t v = 0; v < M.VertexCount; ++v)
+        {
+            const float* P = PositionOf(Positions, Stride, Vertices[v]);
+            float Dx = P[0] - Bounds.Center[0], Dy = P[1] - Bounds.Center[1], Dz = P[2] - Bounds.Center[2];
+            RadiusSq = std::max(RadiusSq, Dx * Dx + Dy * Dy + Dz * Dz);
+        }
+        Bounds.Radius = std::sqrt(RadiusSq);
+
+        // cone axis is the mean of the unit triangle normals, its width the one furthest from it
+        std::vector<float> Normals(M.TriangleCount * 3, 0.0f);
+        float Axis[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < M.TriangleCount; ++t)
+        {
+            const float* P0 = PositionOf(Positions, Stride, Vertices[Triangles[t * 3 + 0]]);
+            const float* P1 = PositionOf(Positions, Stride, Vertices[Triangles[t * 3 + 1]]);
+            const float* P2 = PositionOf(Positions, Stride, Vertices[Triangles[t * 3 + 2]]);
+
+            float E1[3] = { P1[0] - P0[0], P1[1] - P0[1], P1[2] - P0[2] };
+            float E2[3] = { P2[0] - P0[0], P2[1] - P0[1], P2[2] - P0[2] };
+            float* N = &Normals[t * 3];
+            N[0] = E1[1] * E2[2] - E1[2] * E2[1];
+            N[1] = E1[2] * E2[0] - E1[0] * E2[2];
+            N[2] = E1[0] * E2[1] - E1[1] * E2[0];
+
+            float Length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+            if (Length == 0.0f)
+                continue;   // degenerate, faces nowhere
+            for (int i = 0; i < 3; ++i)
+            {
+                N[i] /= Length;
+                Axis[i] += N[i];
+            }
+        }
+
+        float AxisLength = std::sqrt(Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2]);
+        float MinDot = 1.0f;
+        if (AxisLength > 0.0f)
+        {
+            for (int i = 0; i < 3; ++i)
+                Axis[i] /= AxisLength;
+            for (uint32_t t = 0; t < M.TriangleCount; ++t)
+            {
+                const float* N = &Normals[t * 3];
+                if (N[0] != 0.0f || N[1] != 0.0f || N[2] != 0.0f)
+                    MinDot = std::min(MinDot, N[0] * Axis[0] + N[1] * Axis[1] + N[2] * Axis[2]);
+            }
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            Bounds.ConeAxis[i] = Axis[i];
+            Bounds.ConeApex[i] = Bounds.Center[i];
+        }
+
+        // a cone wider than about 84 degrees each way is never going to cull anything
+        if (AxisLength == 0.0f || MinDot <= 0.1f)
+        {
+            Bounds.ConeCutoff = 1.0f;
+            return;
+        }
+        Bounds.ConeCutoff = std::sqrt(1.0f - MinDot * MinDot);
+
+        // Move the apex back along the axis until it is behind every triangle, then an eye
+        // inside the cone past it sees all of them from behind
+        float Back = 0.0f;
+        for (uint32_t t = 0; t < M.TriangleCount; ++t)
+        {
+            const float* N = &Normals[t * 3];
+            const float* P0 = PositionOf(Positions, Stride, Vertices[Triangles[t * 3]]);
+            float Dn = N[0] * Axis[0] + N[1] * Axis[1] + N[2] * Axis[2];
+            if (Dn <= 0.0f)
+                continue;
+
+            float Dc = (Bounds.Center[0] - P0[0]) * N[0] + (Bounds.Center[1] - P0[1]) * N[1] + (Bounds.Center[2] - P0[2]) * N[2];
+            Back = std::max(Back, Dc / Dn);
+        }
+
+        for (int i = 0; i < 3; ++i)
+            Bounds.ConeApex[i] = Bounds.Center[i] - Axis[i] * Back;
+    }
+}
+
+void Utility::BuildMeshlets(MeshletMesh& Mesh, const uint32_t* Indices, size_t IndexCount,
+    const float* Positions, size_t PositionStride, size_t VertexCount)
+{
+    Mesh.Meshlets.clear();
+    Mesh.Bounds.clear();
+    Mesh.Vertices.clear();
+    Mesh.Triangles.clear();
+
+    // slot of each vertex in the meshlet being filled, 0xFF when it is not in it yet
+    std::vector<uint8_t> Slots(VertexCount, 0xFF);
+
+    Meshlet Current = {};
+    auto Finish = [&]()
+    {
+        if (Current.TriangleCount == 0)
+            return;
+        for (uint32_t v = 0; v < Current.VertexCount; ++v)
+            Slots[Mesh.Vertices[Current.VertexOffset + v]] = 0xFF;
+
+        Mesh.Meshlets.push_back(Current);
+        Current.VertexOffset = (uint32_t)Mesh.Vertices.size();
+        Current.TriangleOffset = (uint32_t)Mesh.Triangles.size();
+        Current.VertexCount = 0;
+        Current.TriangleCount = 0;
+    };
+
+    for (size_t t = 0; t + 2 < IndexCount; t += 3)
+    {
+        const uint32_t* Triangle = Indices + t;
+
+        const uint32_t A = Triangle[0], B = Triangle[1], C = Triangle[2];
+        uint32_t NewVertices = (Slots[A] == 0xFF ? 1 : 0) + (Slots[B] == 0xFF && B != A ? 1 : 0) +
+            (Slots[C] == 0xFF && C != A && C != B ? 1 : 0);
+
+        if (Current.VertexCount + NewVertices > kMaxMeshletVertices || Current.TriangleCount == kMaxMeshletTriangles)
+            Finish();
+
+        for (int Corner = 0; Corner < 3; ++Corner)
+        {
+            uint8_t& Slot = Slots[Triangle[Corner]];
+            if (Slot == 0xFF)
+            {
+                Slot = (uint8_t)Current.VertexCount++;
+                Mesh.Vertices.push_back(Triangle[Corner]);
+            }
+            Mesh.Triangles.push_back(Slot);
+        }
+        ++Current.TriangleCount;
+    }
+    Finish();
+
+    Mesh.Bounds.resize(Mesh.Meshlets.size());
+    for (size_t m = 0; m < Mesh.Meshlets.size(); ++m)
+        ComputeBounds(Mesh.Bounds[m], Mesh, Mesh.Meshlets[m], Positions, PositionStride);
+}
+
+void Utility::ExtractFrustumPlanes(const float Matrix[16], float Planes[6][4])
+{
+    // clip = v * M, so each clip coordinate is v dotted with a column
+    auto Column = [Matrix](int c, float Out[4])
+    {
+        for (int r = 0; r < 4; ++r)
+            Out[r] = Matrix[r * 4 + c];
+    };
+
+    float X[4], Y[4], Z[4], W[4];
+    Column(0, X);
+    Column(1, Y);
+    Column(2, Z);
+    Column(3, W);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        Planes[0][i] = W[i] + X[i];     // left
+        Planes[1][i] = W[i] - X[i];     // right
+        Planes[2][i] = W[i] + Y[i];     // bottom
+        Planes[3][i] = W[i] - Y[i];     // top
+        Planes[4][i] = Z[i];            // near
+        Planes[5][i] = W[i] - Z[i];     // far
+    }
+
+    for (int p = 0; p < 6; ++p)
+    {
+        float Length = std::sqrt(Planes[p][0] * Planes[p][0] + Planes[p][1] * Planes[p][1] + Planes[p][2] * Planes[p][2]);
+        if (Length > 0.0f)
+        {
+            for (int i = 0; i < 4; ++i)
+                Planes[p][i] /= Length;
+        }
+    }
+}
+
+size_t Utility::CullMeshlets(const MeshletMesh& Mesh, const float Planes[6][4], const float* Eye,
+    uint32_t* Destination, MeshletCullStats& Stats)
+{
+    size_t Written = 0;
+
+    for (size_t m = 0; m < Mesh.Meshlets.size(); ++m)
+    {
+        const Meshlet& M = Mesh.Meshlets[m];
+        const MeshletBounds& B = Mesh.Bounds[m];
+
+        ++Stats.Meshlets;
+        Stats.Triangles += M.TriangleCount;
+
+        bool Outside = false;
+        for (int p = 0; p < 6 && !Outside; ++p)
+        {
+            const float* Plane = Planes[p];
+            Outside = Plane[0] * B.Center[0] + Plane[1] * B.Center[1] + Plane[2] * B.Center[2] + Plane[3] < -B.Radius;
+        }
+        if (Outside)
+        {
+            ++Stats.OutsideFrustum;
+            Stats.TrianglesRejected += M.TriangleCount;
+            continue;
+        }
+
+        if (Eye != nullptr)
+        {
+            float View[3] = { B.ConeApex[0] - Eye[0], B.ConeApex[1] - Eye[1], B.ConeApex[2] - Eye[2] };
+            float Length = std::sqrt(View[0] * View[0] + View[1] * View[1] + View[2] * View[2]);
+
+            // strictly greater, so a cutoff of 1 never culls
+            if (View[0] * B.ConeAxis[0] + View[1] * B.ConeAxis[1] + View[2] * B.ConeAxis[2] > B.ConeCutoff * Length)
+            {
+                ++Stats.BackFacing;
+                Stats.TrianglesRejected += M.TriangleCount;
+                continue;
+            }
+        }
+
+        const uint32_t* Vertices = Mesh.Vertices.data() + M.VertexOffset;
+        const uint8_t* Triangles = Mesh.Triangles.data() + M.TriangleOffset;
+        for (uint32_t i = 0; i < M.TriangleCount * 3; ++i)
+            Destination[Written++] = Vertices[Triangles[i]];
+    }
+
+    return Written;
+}
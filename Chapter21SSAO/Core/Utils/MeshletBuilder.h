@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace Utility
+{
+    // A cluster of at most kMaxMeshletVertices vertices and kMaxMeshletTriangles triangles.
+    // Triangles index the cluster's own vertex list, which indexes the mesh's vertices.
+    static const uint32_t kMaxMeshletVertices = 64;
+    static const uint32_t kMaxMeshletTriangles = 124;
+
+    struct Meshlet
+    {
+        uint32_t VertexOffset;      // into MeshletMesh::Vertices
+        uint32_t TriangleOffset;    // into MeshletMesh::Triangles, three entries per triangle
+        uint32_t VertexCount;
+        uint32_t TriangleCount;
+    };
+
+    // Bounding sphere, and the cone every triangle normal of the cluster falls in. The cluster
+    // faces away from any eye position with dot(normalize(ConeApex - Eye), ConeAxis) > ConeCutoff.
+    // Clusters whose normals spread too far for that to ever hold have a ConeCutoff of 1.
+    struct MeshletBounds
+    {
+        float Center[3];
+        float Radius;
+        float ConeApex[3];
+        float ConeAxis[3];
+        float ConeCutoff;
+    };
+
+    struct MeshletMesh
+    {
+        std::vector<Meshlet> Meshlets;
+        std::vector<MeshletBounds> Bounds;
+        std::vector<uint32_t> Vertices;
+        std::vector<uint8_t> Triangles;
+    };
+
+    // Splits a triangle list into meshlets in index order, so it pays to reorder the indices
+    // for the vertex cache first. Positions are three floats, PositionStride bytes apart.
+    void BuildMeshlets(MeshletMesh& Mesh, const uint32_t* Indices, size_t IndexCount,
+        const float* Positions, size_t PositionStride, size_t VertexCount);
+
+    struct MeshletCullStats
+    {
+        uint32_t Meshlets;
+        uint32_t BackFacing;
+        uint32_t OutsideFrustum;
+        uint32_t Triangles;
+        uint32_t TrianglesRejected;
+    };
+
+    // Planes of the clip volume of a row vector matrix (DirectXMath order, z from 0 to w), as
+    // (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside and (a, b, c) of unit length.
+    // Passing the world * view * projection matrix gives them in object space.
+    void ExtractFrustumPlanes(const float Matrix[16], float Planes[6][4]);
+
+    // Writes the triangles of the meshlets that are inside the frustum and face Eye to
+    // Destination as one index list, and returns its length. Planes and Eye are in the space
+    // of the positions the meshlets were built from; a null Eye skips the cone test, which is
+    // only exact when nothing scales the mesh unevenly. Destination must hold every triangle.
+    size_t CullMeshlets(const MeshletMesh& Mesh, const float Planes[6][4], const float* Eye,
+        uint32_t* Destination, MeshletCullStats& Stats);
+}
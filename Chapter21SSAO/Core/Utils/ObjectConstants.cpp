@@ -0,0 +1,69 @@
+#include "ObjectConstants.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define OBJECT_CONSTANTS_SSE 1
+#endif
+
+namespace
+{
+#ifdef OBJECT_CONSTANTS_SSE
+
+    // All three matrices are loaded before any store, so the destination sees twelve
+    // consecutive 16-byte writes
+    void WriteMatrices(const Utility::ObjectConstantsSource& Source, Utility::PackedObjectConstants& Dest)
+    {
+        const float* Src[3] = { Source.World, Source.TexTransform, Source.MatTransform };
+        float* Dst[3] = { Dest.World, Dest.TexTransform, Dest.MatTransform };
+
+        __m128 Rows[3][4];
+        for (int m = 0; m < 3; ++m)
+        {
+            for (int r = 0; r < 4; ++r)
+                Rows[m][r] = _mm_load_ps(Src[m] + 4 * r);
+        }
+        for (int m = 0; m < 3; ++m)
+        {
+            _MM_TRANSPOSE4_PS(Rows[m][0], Rows[m][1], Rows[m][2], Rows[m][3]);
+            for (int r = 0; r < 4; ++r)
+                _mm_store_ps(Dst[m] + 4 * r, Rows[m][r]);
+        }
+    }
+
+#else
+
+    void WriteMatrices(const Utility::ObjectConstantsSource& Source, Utility::PackedObjectConstants& Dest)
+    {
+        const float* Src[3] = { Source.World, Source.TexTransform, Source.MatTransform };
+        float* Dst[3] = { Dest.World, Dest.TexTransform, Dest.MatTransform };
+
+        for (int m = 0; m < 3; ++m)
+        {
+            for (int i = 0; i < 16; ++i)
+                Dst[m][i] = Src[m][(i % 4) * 4 + i / 4];
+        }
+    }
+
+#endif
+}
+
+void Utility::PackObjectConstants(PackedObjectConstants* Block, const ObjectConstantsSource* Sources, size_t Count)
+{
+    for (size_t i = 0; i < Count; ++i)
+    {
+        const ObjectConstantsSource& Source = Sources[i];
+        PackedObjectConstants& Dest = Block[Source.Slot];
+
+        WriteMatrices(Source, Dest);
+        Dest.MaterialIndex = Source.MaterialIndex;
+        Dest.ObjPad[0] = Dest.ObjPad[1] = Dest.ObjPad[2] = 0;
+        Dest.PositionScale[0] = Source.PositionScale[0];
+        Dest.PositionScale[1] = Source.PositionScale[1];
+        Dest.PositionScale[2] = Source.PositionScale[2];
+        Dest.PositionScale[3] = 0.0f;
+        Dest.PositionBias[0] = Source.PositionBias[0];
+        Dest.PositionBias[1] = Source.PositionBias[1];
+        Dest.PositionBias[2] = Source.PositionBias[2];
+        Dest.PositionBias[3] = 0.0f;
+    }
+}
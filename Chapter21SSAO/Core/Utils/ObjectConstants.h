@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Utility
+{
+    // ObjConstants of d3dUtil.h without DirectXMath: one element of the StructuredBuffer the
+    // shaders index with the object index root constant, matrices column-major for HLSL.
+    struct alignas(16) PackedObjectConstants
+    {
+        float World[16];
+        float TexTransform[16];
+        float MatTransform[16];
+        uint32_t MaterialIndex;
+        uint32_t ObjPad[3];
+        float PositionScale[4];
+        float PositionBias[4];
+    };
+    static_assert(sizeof(PackedObjectConstants) == 240, "Layout differs from ObjConstants");
+
+    // One render item. Matrices are row-major and 16-byte aligned, as XMMATRIX keeps them.
+    struct ObjectConstantsSource
+    {
+        const float* World;
+        const float* TexTransform;
+        const float* MatTransform;
+        const float* PositionScale;     // xyz
+        const float* PositionBias;      // xyz
+        uint32_t MaterialIndex;
+        uint32_t Slot;                  // element of the block written
+    };
+
+    // Writes the element of each source into Block, transposing its matrices. Each element is
+    // written front to back and nothing is read back, so Block may be write-combined upload memory.
+    void PackObjectConstants(PackedObjectConstants* Block, const ObjectConstantsSource* Sources, size_t Count);
+}
@@ -0,0 +1,49 @@
+#include "RadixSort.h"
+#include <cstring>
+
+void Utility::RadixSort(std::vector<SortEntry>& Entries, std::vector<SortEntry>& Scratch)
+{
+    const size_t Count = Entries.size();
+    if (Count < 2)
+        return;
+
+    // one histogram per byte, all gathered in a single read of the keys
+    uint32_t Histograms[8][256];
+    memset(Histograms, 0, sizeof(Histograms));
+
+    for (size_t i = 0; i < Count; ++i)
+    {
+        uint64_t Key = Entries[i].Key;
+        for (int Byte = 0; Byte < 8; ++Byte)
+            Histograms[Byte][(Key >> (Byte * 8)) & 0xFF]++;
+    }
+
+    Scratch.resize(Count);
+    SortEntry* Src = Entries.data();
+    SortEntry* Dst = Scratch.data();
+
+    for (int Byte = 0; Byte < 8; ++Byte)
+    {
+        uint32_t* Histogram = Histograms[Byte];
+
+        // all keys share this byte, the pass would not move anything
+        if (Histogram[(Src[0].Key >> (Byte * 8)) & 0xFF] == Count)
+            continue;
+
+        uint32_t Offset = 0;
+        for (int Bucket = 0; Bucket < 256; ++Bucket)
+        {
+            uint32_t BucketCount = Histogram[Bucket];
+            Histogram[Bucket] = Offset;
+            Offset += BucketCount;
+        }
+
+        for (size_t i = 0; i < Count; ++i)
+            Dst[Histogram[(Src[i].Key >> (Byte * 8)) & 0xFF]++] = Src[i];
+
+        std::swap(Src, Dst);
+    }
+
+    if (Src != Entries.data())
+        memcpy(Entries.data(), Src, Count * sizeof(SortEntry));
+}
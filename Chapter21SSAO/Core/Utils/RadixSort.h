@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Utility
+{
+    // 64-bit sort key with the index of whatever it was built from.
+    struct SortEntry
+    {
+        uint64_t Key;
+        uint32_t Index;
+    };
+
+    // Stable LSD radix sort on Key, 8 bits per pass. Passes where every key has the same
+    // byte are skipped, so keys that only vary in a few bytes cost only a few passes.
+    // Scratch is resized as needed and can be kept around to avoid reallocating every frame.
+    void RadixSort(std::vector<SortEntry>& Entries, std::vector<SortEntry>& Scratch);
+}
@@ -0,0 +1,500 @@
+#include "TerrainQuadtree.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    uint64_t NodeKey(uint32_t Level, uint32_t X, uint32_t Z)
+    {
+        return (uint64_t)Level << 48 | (uint64_t)X << 24 | Z;
+    }
+
+    // west, east, south, north, in the order of the TerrainEdge bits
+    const int kEdgeDx[4] = { -1, 1, 0, 0 };
+    const int kEdgeDz[4] = { 0, 0, -1, 1 };
+
+    class Quadtree
+    {
+    public:
+        explicit Quadtree(const Utility::TerrainDesc& Desc) : m_Desc(Desc) {}
+
+        bool IsSplit(uint32_t Level, uint32_t X, uint32_t Z) const
+        {
+            return m_Split.count(NodeKey(Level, X, Z)) != 0;
+        }
+
+        void Split(uint32_t Level, uint32_t X, uint32_t Z)
+        {
+            m_Split.insert(NodeKey(Level, X, Z));
+        }
+
+        // the neighbour of a node across Edge, false past the border of the terrain
+        static bool Neighbour(uint32_t Level, uint32_t X, uint32_t Z, int Edge, uint32_t& NX, uint32_t& NZ)
+        {
+            int64_t Count = (int64_t)1 << Level;
+            int64_t Nx = (int64_t)X + kEdgeDx[Edge];
+            int64_t Nz = (int64_t)Z + kEdgeDz[Edge];
+            if (Nx < 0 || Nz < 0 || Nx >= Count || Nz >= Count)
+                return false;
+            NX = (uint32_t)Nx;
+            NZ = (uint32_t)Nz;
+            return true;
+        }
+
+        // A leaf must split when the neighbour on one side has split children along the shared edge
+        bool NeedsSplit(uint32_t Level, uint32_t X, uint32_t Z) const
+        {
+            if (Level >= m_Desc.MaxDepth)
+                return false;
+
+            for (int Edge = 0; Edge < 4; ++Edge)
+            {
+                uint32_t NX, NZ;
+                if (!Neighbour(Level, X, Z, Edge, NX, NZ) || !IsSplit(Level, NX, NZ))
+                    continue;
+
+                // children of the neighbour on the side facing this node
+                for (uint32_t i = 0; i < 2; ++i)
+                {
+                    uint32_t CX = NX * 2 + (kEdgeDx[Edge] == 0 ? i : (kEdgeDx[Edge] < 0 ? 1 : 0));
+                    uint32_t CZ = NZ * 2 + (kEdgeDz[Edge] == 0 ? i : (kEdgeDz[Edge] < 0 ? 1 : 0));
+                    if (IsSplit(Level + 1, CX, CZ))
+                        return true;
+                }
+            }
+            return false;
+        }
+
+        void CollectLeaves(uint32_t Level, uint32_t X, uint32_t Z, std::vector<Utility::TerrainPatch>& Leaves) const
+        {
+            if (IsSplit(Level, X, Z))
+            {
+                for (uint32_t c = 0; c < 4; ++c)
+                    CollectLeaves(Level + 1, X * 2 + (c & 1), Z * 2 + (c >> 1), Leaves);
+                return;
+            }
+
+            Utility::TerrainPatch Patch = {};
+            Patch.Level = Level;
+            Patch.X = X;
+            Patch.Z = Z;
+
+            // a neighbour whose parent did not split is not in the tree, the leaf there is coarser
+            for (int Edge = 0; Edge < 4; ++Edge)
+            {
+                uint32_t NX, NZ;
+                if (Level > 0 && Neighbour(Level, X, Z, Edge, NX, NZ) && !IsSplit(Level - 1, NX >> 1, NZ >> 1))
+                    Patch.StitchMask |= 1u << Edge;
+            }
+            Leaves.push_back(Patch);
+        }
+
+    private:
+        const Utility::TerrainDesc& m_Desc;
+        std::unordered_set<uint64_t> m_Split;
+    };
+
+    float Distance(const Utility::TerrainDesc& Desc, const float Eye[3], uint32_t Level, uint32_t X, uint32_t Z,
+        const Utility::TerrainHeightRange& HeightRange)
+    {
+        float Size = Desc.Size / (float)(1u << Level);
+        float MinX = Desc.Origin[0] + X * Size;
+        float MinZ = Desc.Origin[1] + Z * Size;
+
+        float Dx = std::max(std::max(MinX - Eye[0], Eye[0] - (MinX + Size)), 0.0f);
+        float Dz = std::max(std::max(MinZ - Eye[2], Eye[2] - (MinZ + Size)), 0.0f);
+        float Dy = 0.0f;
+
+        float Range[2];
+        if (HeightRange && HeightRange(Level, X, Z, Range))
+            Dy = std::max(std::max(Range[0] - Eye[1], Eye[1] - Range[1]), 0.0f);
+
+        return std::sqrt(Dx * Dx + Dy * Dy + Dz * Dz);
+    }
+
+    void SelectNode(const Utility::TerrainDesc& Desc, const float Eye[3], uint32_t Level, uint32_t X, uint32_t Z,
+        const Utility::TerrainHeightRange& HeightRange, Quadtree& Tree)
+    {
+        float Size = Desc.Size / (float)(1u << Level);
+        if (Level >= Desc.MaxDepth || Distance(Desc, Eye, Level, X, Z, HeightRange) >= Desc.SplitFactor * Size)
+            return;
+
+        Tree.Split(Level, X, Z);
+        for (uint32_t c = 0; c < 4; ++c)
+            SelectNode(Desc, Eye, Level + 1, X * 2 + (c & 1), Z * 2 + (c >> 1), HeightRange, Tree);
+    }
+}
+
+void Utility::GenerateTerrainPatch(const TerrainDesc& Desc, uint32_t Level, uint32_t X, uint32_t Z,
+    TerrainVertex* Vertices, float BoundsMin[3], float BoundsMax[3])
+{
+    const uint32_t N = Desc.PatchQuads;
+    const uint32_t Shift = Desc.MaxDepth - Level;
+    const float FinestStep = Desc.Size / (float)(N << Desc.MaxDepth);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        BoundsMin[i] = FLT_MAX;
+        BoundsMax[i] = -FLT_MAX;
+    }
+
+    for (uint32_t Row = 0; Row <= N; ++Row)
+    {
+        for (uint32_t Column = 0; Column <= N; ++Column)
+        {
+            TerrainVertex& V = Vertices[Row * (N + 1) + Column];
+
+            // the same lattice point gives the same floats whatever the level of the patch
+            uint32_t Gx = (X * N + Column) << Shift;
+            uint32_t Gz = (Z * N + Row) << Shift;
+            float x = Desc.Origin[0] + Gx * FinestStep;
+            float z = Desc.Origin[1] + Gz * FinestStep;
+
+            V.Position[0] = x;
+            V.Position[1] = Desc.Height(x, z);
+            V.Position[2] = z;
+
+            if (Desc.Normal)
+            {
+                Desc.Normal(x, z, V.Normal);
+            }
+            else
+            {
+                float h = FinestStep;
+                V.Normal[0] = (Desc.Height(x - h, z) - Desc.Height(x + h, z)) / (2.0f * h);
+                V.Normal[1] = 1.0f;
+                V.Normal[2] = (Desc.Height(x, z - h) - Desc.Height(x, z + h)) / (2.0f * h);
+                float Length = std::sqrt(V.Normal[0] * V.Normal[0] + 1.0f + V.Normal[2] * V.Normal[2]);
+                for (int i = 0; i < 3; ++i)
+                    V.Normal[i] /= Length;
+            }
+
+            // +x along the surface, (1, dh/dx, 0) of a heightfield
+            float TangentLength = std::sqrt(V.Normal[0] * V.Normal[0] + V.Normal[1] * V.Normal[1]);
+            V.Tangent[0] = TangentLength > 0.0f ? V.Normal[1] / TangentLength : 1.0f;
+            V.Tangent[1] = TangentLength > 0.0f ? -V.Normal[0] / TangentLength : 0.0f;
+            V.Tangent[2] = 0.0f;
+
+            // v runs against z, as on the grids of GeometryGenerator
+            V.TexC[0] = x / Desc.TextureTile;
+            V.TexC[1] = -z / Desc.TextureTile;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                BoundsMin[i] = std::min(BoundsMin[i], V.Position[i]);
+                BoundsMax[i] = std::max(BoundsMax[i], V.Position[i]);
+            }
+        }
+    }
+}
+
+void Utility::BuildTerrainIndices(uint32_t PatchQuads, std::vector<uint32_t>& Indices, TerrainIndexRange Ranges[16])
+{
+    const uint32_t N = PatchQuads;
+    Indices.clear();
+
+    for (uint32_t Mask = 0; Mask < 16; ++Mask)
+    {
+        auto Index = [N, Mask](uint32_t Row, uint32_t Column)
+        {
+            if ((Mask & kTerrainWest) && Column == 0 && (Row & 1))
+                --Row;
+            if ((Mask & kTerrainEast) && Column == N && (Row & 1))
+                --Row;
+            if ((Mask & kTerrainSouth) && Row == 0 && (Column & 1))
+                --Column;
+            if ((Mask & kTerrainNorth) && Row == N && (Column & 1))
+                --Column;
+            return Row * (N + 1) + Column;
+        };
+
+        auto Triangle = [&Indices](uint32_t A, uint32_t B, uint32_t C)
+        {
+            if (A == B || B == C || C == A)
+                return;
+            Indices.push_back(A);
+            Indices.push_back(B);
+            Indices.push_back(C);
+        };
+
+        Ranges[Mask].StartIndex = (uint32_t)Indices.size();
+        for (uint32_t Row = 0; Row < N; ++Row)
+        {
+            for (uint32_t Column = 0; Column < N; ++Column)
+            {
+                // facing +y: one step in z, then one in x
+                uint32_t A = Index(Row, Column);
+                uint32_t B = Index(Row + 1, Column);
+                uint32_t C = Index(Row, Column + 1);
+                uint32_t D = Index(Row + 1, Column + 1);
+
+                // in the corner between two stitched sides both B and C move, and A would be left
+                // on the line between them; the other diagonal keeps both triangles whole
+                if (B != (Row + 1) * (N + 1) + Column && C != Row * (N + 1) + Column + 1)
+                {
+                    Triangle(A, B, D);
+                    Triangle(A, D, C);
+                }
+                else
+                {
+                    Triangle(A, B, C);
+                    Triangle(C, B, D);
+                }
+            }
+        }
+        Ranges[Mask].IndexCount = (uint32_t)Indices.size() - Ranges[Mask].StartIndex;
+    }
+}
+
+void Utility::SelectTerrainPatches(const TerrainDesc& Desc, const float Eye[3], std::vector<TerrainPatch>& Leaves,
+    const TerrainHeightRange& HeightRange)
+{
+    Quadtree Tree(Desc);
+    SelectNode(Desc, Eye, 0, 0, 0, HeightRange, Tree);
+
+    // Split leaves next to much finer ones until no two neighbours are more than a level apart.
+    // Splits only ever spread outwards from the eye, a few rounds settle it.
+    for (bool Changed = true; Changed; )
+    {
+        Changed = false;
+        Leaves.clear();
+        Tree.CollectLeaves(0, 0, 0, Leaves);
+        for (const TerrainPatch& Leaf : Leaves)
+        {
+            if (Tree.NeedsSplit(Leaf.Level, Leaf.X, Leaf.Z))
+            {
+                Tree.Split(Leaf.Level, Leaf.X, Leaf.Z);
+                Changed = true;
+            }
+        }
+    }
+}
+
+void Utility::CullTerrainPatches(const std::vector<TerrainPatch>& Patches, const float Planes[6][4], std::vector<uint32_t>& Visible)
+{
+    Visible.clear();
+    for (uint32_t i = 0; i < (uint32_t)Patches.size(); ++i)
+    {
+        const TerrainPatch& P = Patches[i];
+
+        // the corner of the box furthest along each plane normal
+        bool Outside = false;
+        for (int p = 0; p < 6 && !Outside; ++p)
+        {
+            const float* Plane = Planes[p];
+            float Far = Plane[3];
+            for (int a = 0; a < 3; ++a)
+                Far += Plane[a] * (Plane[a] >= 0.0f ? P.BoundsMax[a] : P.BoundsMin[a]);
+            Outside = Far < 0.0f;
+        }
+
+        if (!Outside)
+            Visible.push_back(i);
+    }
+}
+
+Utility::TerrainStreamer::TerrainStreamer(const TerrainDesc& Desc) : m_Desc(Desc)
+{
+    m_FreeSlots.reserve(Desc.MaxResidentPatches);
+    for (uint32_t Slot = Desc.MaxResidentPatches; Slot-- > 0; )
+        m_FreeSlots.push_back(Slot);
+}
+
+Utility::TerrainStreamer::~TerrainStreamer()
+{
+    Flush();
+    for (Job* J : m_Finished)
+        delete J;
+}
+
+void Utility::TerrainStreamer::Flush()
+{
+    std::unique_lock<std::mutex> Lock(m_JobMutex);
+    m_JobDone.wait(Lock, [this] { return m_Finished.size() == m_JobsRunning; });
+}
+
+bool Utility::TerrainStreamer::ReserveSlot(uint32_t& Slot, const std::unordered_set<uint64_t>& Selected,
+    const std::function<bool(uint64_t)>& IsFenceComplete)
+{
+    if (!m_FreeSlots.empty())
+    {
+        Slot = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        return true;
+    }
+
+    // the least recently wanted patch that is neither drawn, selected nor still read by the GPU
+    auto Victim = m_Entries.end();
+    for (auto Iter = m_Entries.begin(); Iter != m_Entries.end(); ++Iter)
+    {
+        const Entry& E = Iter->second;
+        if (E.State != kResident || Selected.count(Iter->first) || m_Drawn.count(Iter->first))
+            continue;
+        if (Victim != m_Entries.end() && E.LastWanted >= Victim->second.LastWanted)
+            continue;
+        if (E.LastFence != 0 && !IsFenceComplete(E.LastFence))
+            continue;
+        Victim = Iter;
+    }
+
+    if (Victim == m_Entries.end())
+        return false;
+
+    Slot = Victim->second.Slot;
+    m_Entries.erase(Victim);
+    ++m_Evicted;
+    return true;
+}
+
+bool Utility::TerrainStreamer::Update(const float Eye[3], const std::function<bool(uint64_t)>& IsFenceComplete)
+{
+    ++m_UpdateCount;
+
+    std::vector<Job*> Finished;
+    {
+        std::lock_guard<std::mutex> Lock(m_JobMutex);
+        Finished.swap(m_Finished);
+        m_JobsRunning -= (uint32_t)Finished.size();
+    }
+    for (Job* J : Finished)
+    {
+        Entry& E = m_Entries[J->Key];
+        E.State = kGenerated;
+        std::copy(J->BoundsMin, J->BoundsMin + 3, E.BoundsMin);
+        std::copy(J->BoundsMax, J->BoundsMax + 3, E.BoundsMax);
+        m_Uploads.push_back({ E.Slot, std::move(J->Vertices) });
+        ++m_Generated;
+        delete J;
+    }
+
+    // a patch not generated yet takes the height range of its closest generated ancestor
+    auto HeightRange = [this](uint32_t Level, uint32_t X, uint32_t Z, float Range[2])
+    {
+        for (uint32_t l = Level + 1; l-- > 0; X >>= 1, Z >>= 1)
+        {
+            auto Iter = m_Entries.find(NodeKey(l, X, Z));
+            if (Iter != m_Entries.end() && Iter->second.State != kPending)
+            {
+                Range[0] = Iter->second.BoundsMin[1];
+                Range[1] = Iter->second.BoundsMax[1];
+                return true;
+            }
+        }
+        return false;
+    };
+    SelectTerrainPatches(m_Desc, Eye, m_Selection, HeightRange);
+
+    std::unordered_set<uint64_t> Selected;
+    std::vector<const TerrainPatch*> Missing;
+    bool Complete = true;
+    for (const TerrainPatch& P : m_Selection)
+    {
+        uint64_t Key = NodeKey(P.Level, P.X, P.Z);
+        Selected.insert(Key);
+
+        auto Iter = m_Entries.find(Key);
+        if (Iter != m_Entries.end())
+        {
+            Iter->second.LastWanted = m_UpdateCount;
+            if (Iter->second.State == kResident)
+                continue;
+        }
+        else
+        {
+            Missing.push_back(&P);
+        }
+        Complete = false;
+    }
+
+    // coarse patches first, they cover the most ground
+    std::stable_sort(Missing.begin(), Missing.end(),
+        [](const TerrainPatch* A, const TerrainPatch* B) { return A->Level < B->Level; });
+
+    for (const TerrainPatch* P : Missing)
+    {
+        uint32_t Slot;
+        if (m_JobsRunning >= m_Desc.MaxPendingPatches || !ReserveSlot(Slot, Selected, IsFenceComplete))
+            break;
+
+        uint64_t Key = NodeKey(P->Level, P->X, P->Z);
+        Entry& E = m_Entries[Key];
+        E = {};
+        E.State = kPending;
+        E.Slot = Slot;
+        E.LastWanted = m_UpdateCount;
+
+        Job* J = new Job;
+        J->Key = Key;
+        J->Vertices.resize(TerrainVerticesPerPatch(m_Desc.PatchQuads));
+
+        {
+            std::lock_guard<std::mutex> Lock(m_JobMutex);
+            ++m_JobsRunning;
+        }
+
+        uint32_t Level = P->Level, X = P->X, Z = P->Z;
+        ThreadPool::Submit([this, J, Level, X, Z]
+        {
+            GenerateTerrainPatch(m_Desc, Level, X, Z, J->Vertices.data(), J->BoundsMin, J->BoundsMax);
+
+            std::lock_guard<std::mutex> Lock(m_JobMutex);
+            m_Finished.push_back(J);
+            m_JobDone.notify_all();
+        });
+    }
+
+    if (Complete)
+    {
+        m_Patches = m_Selection;
+        for (TerrainPatch& P : m_Patches)
+        {
+            const Entry& E = m_Entries[NodeKey(P.Level, P.X, P.Z)];
+            P.Slot = E.Slot;
+            std::copy(E.BoundsMin, E.BoundsMin + 3, P.BoundsMin);
+            std::copy(E.BoundsMax, E.BoundsMax + 3, P.BoundsMax);
+        }
+        m_Drawn.swap(Selected);
+    }
+
+    for (uint64_t Key : m_Drawn)
+        m_Entries[Key].LastWanted = m_UpdateCount;
+
+    return Complete;
+}
+
+void Utility::TerrainStreamer::TakeUploads(std::vector<Upload>& Uploads)
+{
+    Uploads.clear();
+    Uploads.swap(m_Uploads);
+
+    for (auto& Iter : m_Entries)
+    {
+        if (Iter.second.State == kGenerated)
+            Iter.second.State = kResident;
+    }
+}
+
+void Utility::TerrainStreamer::RetireFrame(uint64_t FenceValue)
+{
+    for (uint64_t Key : m_Drawn)
+        m_Entries[Key].LastFence = FenceValue;
+}
+
+Utility::TerrainStreamer::Stats Utility::TerrainStreamer::GetStats() const
+{
+    Stats S = {};
+    S.Selected = (uint32_t)m_Selection.size();
+    S.Drawn = (uint32_t)m_Patches.size();
+    for (auto& Iter : m_Entries)
+    {
+        if (Iter.second.State == kResident)
+            ++S.Resident;
+        else
+            ++S.Pending;
+    }
+    S.Generated = m_Generated;
+    S.Evicted = m_Evicted;
+    return S;
+}
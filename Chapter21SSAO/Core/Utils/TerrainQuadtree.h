@@ -0,0 +1,193 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Utility
+{
+    // Same layout as the Vertex of the samples: position, normal, texture coordinates, tangent
+    struct TerrainVertex
+    {
+        float Position[3];
+        float Normal[3];
+        float TexC[2];
+        float Tangent[3];
+    };
+
+    // A heightfield over the square [Origin, Origin + Size] in x and z, split into a quadtree of
+    // patches that all have PatchQuads x PatchQuads quads, so a level is twice as detailed as
+    // the one above it. Level 0 is the whole square, level MaxDepth the finest.
+    struct TerrainDesc
+    {
+        float Origin[2];
+        float Size;
+        uint32_t MaxDepth;
+        uint32_t PatchQuads;            // a power of two, at least 2
+        float SplitFactor;              // a patch splits while the eye is closer than this many times its size
+        float TextureTile;              // units per repeat of the texture
+        uint32_t MaxResidentPatches;    // slots in the vertex pool, room for two selections
+        uint32_t MaxPendingPatches;     // generation jobs in flight at once
+
+        // Height(x, z) and optionally Normal(x, z, n); without Normal the normals come from
+        // central differences at the finest spacing. Both are called from worker threads.
+        std::function<float(float, float)> Height;
+        std::function<void(float, float, float[3])> Normal;
+    };
+
+    // Bits of TerrainPatch::StitchMask, set for the sides whose neighbour is one level coarser
+    enum TerrainEdge
+    {
+        kTerrainWest = 1,       // -x
+        kTerrainEast = 2,       // +x
+        kTerrainSouth = 4,      // -z
+        kTerrainNorth = 8       // +z
+    };
+
+    struct TerrainPatch
+    {
+        uint32_t Level;
+        uint32_t X;             // column and row of the patch among the 2^Level of its level
+        uint32_t Z;
+        uint32_t StitchMask;
+        uint32_t Slot;          // its vertices start at Slot * TerrainVerticesPerPatch
+        float BoundsMin[3];
+        float BoundsMax[3];
+    };
+
+    inline uint32_t TerrainVerticesPerPatch(uint32_t PatchQuads)
+    {
+        return (PatchQuads + 1) * (PatchQuads + 1);
+    }
+
+    // Vertices of one patch, rows of increasing z of PatchQuads + 1 vertices of increasing x.
+    // Positions come from integer coordinates on the finest lattice, so patches of different
+    // levels produce bit identical positions and normals along the edges they share.
+    void GenerateTerrainPatch(const TerrainDesc& Desc, uint32_t Level, uint32_t X, uint32_t Z,
+        TerrainVertex* Vertices, float BoundsMin[3], float BoundsMax[3]);
+
+    struct TerrainIndexRange
+    {
+        uint32_t StartIndex;
+        uint32_t IndexCount;
+    };
+
+    // One triangle list per stitch mask, all in Indices. Along a side with its bit set every odd
+    // vertex is merged into the even one before it, which leaves exactly the edges of the
+    // coarser neighbour; the triangles that collapse are left out.
+    void BuildTerrainIndices(uint32_t PatchQuads, std::vector<uint32_t>& Indices, TerrainIndexRange Ranges[16]);
+
+    // Height range of a patch when known. Patches it does not know are taken to be at eye height.
+    typedef std::function<bool(uint32_t Level, uint32_t X, uint32_t Z, float Range[2])> TerrainHeightRange;
+
+    // Leaves of the quadtree for Eye, balanced so neighbouring leaves are at most one level apart,
+    // with their stitch masks. Slot and bounds are left for the caller.
+    void SelectTerrainPatches(const TerrainDesc& Desc, const float Eye[3], std::vector<TerrainPatch>& Leaves,
+        const TerrainHeightRange& HeightRange = nullptr);
+
+    // Indices of the patches whose bounds are not entirely outside one of the planes, given as
+    // by ExtractFrustumPlanes in the space of the terrain
+    void CullTerrainPatches(const std::vector<TerrainPatch>& Patches, const float Planes[6][4], std::vector<uint32_t>& Visible);
+
+    // Keeps the patches around the eye generated, on the thread pool, in a fixed pool of slots.
+    //
+    // Update selects the patches for the eye and starts jobs for the ones that are missing; the
+    // patches drawn only switch to a new selection once all of it is resident, so what is drawn
+    // is always complete and crack free, just a little late while the eye moves fast. Slots of
+    // patches nobody wants any more are reused least recently wanted first, once the GPU is done
+    // with the last frame that drew them. The pool has to hold the patches drawn and the ones
+    // selected at the same time, or a selection that cannot fit never gets drawn.
+    class TerrainStreamer
+    {
+    public:
+        struct Upload
+        {
+            uint32_t Slot;
+            std::vector<TerrainVertex> Vertices;
+        };
+
+        struct Stats
+        {
+            uint32_t Selected;      // leaves of the last selection
+            uint32_t Drawn;         // leaves drawn, those of an earlier selection while it streams in
+            uint32_t Resident;
+            uint32_t Pending;       // jobs running and uploads not taken yet
+            uint32_t Generated;     // since the start
+            uint32_t Evicted;
+        };
+
+        explicit TerrainStreamer(const TerrainDesc& Desc);
+        ~TerrainStreamer();
+
+        TerrainStreamer(const TerrainStreamer&) = delete;
+        TerrainStreamer& operator=(const TerrainStreamer&) = delete;
+
+        // Returns true when the patches drawn are the ones selected for Eye
+        bool Update(const float Eye[3], const std::function<bool(uint64_t)>& IsFenceComplete);
+
+        // Patches generated since the last call. They count as resident from now on, so their
+        // vertices must be copied to their slots before any later frame draws.
+        void TakeUploads(std::vector<Upload>& Uploads);
+
+        // The patches to draw, all resident
+        const std::vector<TerrainPatch>& GetPatches() const { return m_Patches; }
+
+        // The slots of GetPatches are read by the GPU until FenceValue completes
+        void RetireFrame(uint64_t FenceValue);
+
+        // Waits for every job started so far
+        void Flush();
+
+        const TerrainDesc& GetDesc() const { return m_Desc; }
+        Stats GetStats() const;
+
+    private:
+        enum EntryState { kPending, kGenerated, kResident };
+
+        struct Entry
+        {
+            EntryState State;
+            uint32_t Slot;
+            float BoundsMin[3];
+            float BoundsMax[3];
+            uint64_t LastFence;     // of the last frame that drew it
+            uint64_t LastWanted;    // Update count when it was last selected or drawn
+        };
+
+        struct Job
+        {
+            uint64_t Key;
+            std::vector<TerrainVertex> Vertices;
+            float BoundsMin[3];
+            float BoundsMax[3];
+        };
+
+        bool ReserveSlot(uint32_t& Slot, const std::unordered_set<uint64_t>& Selected,
+            const std::function<bool(uint64_t)>& IsFenceComplete);
+
+        TerrainDesc m_Desc;
+
+        std::unordered_map<uint64_t, Entry> m_Entries;
+        std::vector<uint32_t> m_FreeSlots;
+        std::vector<Upload> m_Uploads;
+
+        std::vector<TerrainPatch> m_Patches;
+        std::unordered_set<uint64_t> m_Drawn;
+        std::vector<TerrainPatch> m_Selection;
+        uint64_t m_UpdateCount = 0;
+
+        // finished jobs, filled by the workers
+        std::mutex m_JobMutex;
+        std::condition_variable m_JobDone;
+        std::vector<Job*> m_Finished;
+        uint32_t m_JobsRunning = 0;
+
+        uint32_t m_Generated = 0;
+        uint32_t m_Evicted = 0;
+    };
+}
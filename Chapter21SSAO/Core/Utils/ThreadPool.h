@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// A small fixed-size worker pool built only on the standard library, so CPU-side
+// systems (wave simulation, culling, loaders) do not depend on PPL.
+namespace ThreadPool
+{
+    // Starts the workers. Called lazily on first use; NumThreads == 0 picks hardware_concurrency - 1.
+    void Initialize(uint32_t NumThreads = 0);
+    void Shutdown(void);
+
+    uint32_t GetWorkerCount(void);
+
+    // Fire-and-forget job.
+    void Submit(std::function<void()> Job);
+
+    // Runs Body(i) for i in [Begin, End) split into chunks of Grain indices. The calling
+    // thread takes part and the call returns once every index has been processed.
+    // Safe to nest: the waiting caller runs its own helper jobs that no worker has picked up,
+    // never jobs submitted by anybody else.
+    void ParallelFor(int Begin, int End, const std::function<void(int)>& Body, int Grain = 1);
+
+    // Same as ParallelFor but Body receives a [ChunkBegin, ChunkEnd) range.
+    void ParallelForRange(int Begin, int End, const std::function<void(int, int)>& Body, int Grain = 1);
+}
@@ -0,0 +1,255 @@
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const float* Element(const float* Base, size_t Stride, size_t Vertex)
+    {
+        return (const float*)((const char*)Base + Vertex * Stride);
+    }
+
+    uint32_t FloatBits(float Value)
+    {
+        uint32_t Bits;
+        memcpy(&Bits, &Value, sizeof(Bits));
+        return Bits;
+    }
+
+    float BitsFloat(uint32_t Bits)
+    {
+        float Value;
+        memcpy(&Value, &Bits, sizeof(Value));
+        return Value;
+    }
+
+    // what the input assembler does with an R16_SNORM, -32768 and -32767 both map to -1
+    float SnormToFloat(int16_t Value)
+    {
+        return std::max(Value / 32767.0f, -1.0f);
+    }
+
+    float Normalize(float Vector[3])
+    {
+        float Length = std::sqrt(Vector[0] * Vector[0] + Vector[1] * Vector[1] + Vector[2] * Vector[2]);
+        if (Length > 0.0f)
+        {
+            for (int i = 0; i < 3; ++i)
+                Vector[i] /= Length;
+        }
+        return Length;
+    }
+
+    // angle between a source direction and its decoded copy, 0 when the source has no direction
+    float AngleDegrees(const float* Source, const float Decoded[3])
+    {
+        float Unit[3] = { Source[0], Source[1], Source[2] };
+        if (Normalize(Unit) == 0.0f)
+            return 0.0f;
+
+        // acos of a dot product this close to 1 would mostly measure float rounding
+        float Cross[3] =
+        {
+            Unit[1] * Decoded[2] - Unit[2] * Decoded[1],
+            Unit[2] * Decoded[0] - Unit[0] * Decoded[2],
+            Unit[0] * Decoded[1] - Unit[1] * Decoded[0]
+        };
+        float Sin = std::sqrt(Cross[0] * Cross[0] + Cross[1] * Cross[1] + Cross[2] * Cross[2]);
+        float Cos = Unit[0] * Decoded[0] + Unit[1] * Decoded[1] + Unit[2] * Decoded[2];
+        return std::atan2(Sin, Cos) * (180.0f / 3.14159265f);
+    }
+}
+
+Utility::PositionQuantization Utility::ComputePositionQuantization(const float* Positions, size_t PositionStride, size_t VertexCount)
+{
+    float Min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float Max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (size_t v = 0; v < VertexCount; ++v)
+    {
+        const float* P = Element(Positions, PositionStride, v);
+        for (int i = 0; i < 3; ++i)
+        {
+            Min[i] = std::min(Min[i], P[i]);
+            Max[i] = std::max(Max[i], P[i]);
+        }
+    }
+
+    PositionQuantization Quantization;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (VertexCount == 0)
+            Min[i] = Max[i] = 0.0f;
+        Quantization.Bias[i] = Min[i];
+        Quantization.Scale[i] = Max[i] > Min[i] ? Max[i] - Min[i] : 1.0f;
+    }
+    return Quantization;
+}
+
+void Utility::EncodeOctahedral(const float Vector[3], int16_t Encoded[2])
+{
+    // project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the upper
+    float L1 = std::fabs(Vector[0]) + std::fabs(Vector[1]) + std::fabs(Vector[2]);
+    if (L1 == 0.0f)
+    {
+        Encoded[0] = Encoded[1] = 0;
+        return;
+    }
+
+    float U = Vector[0] / L1;
+    float V = Vector[1] / L1;
+    if (Vector[2] < 0.0f)
+    {
+        float FoldedU = (1.0f - std::fabs(V)) * (U >= 0.0f ? 1.0f : -1.0f);
+        float FoldedV = (1.0f - std::fabs(U)) * (V >= 0.0f ? 1.0f : -1.0f);
+        U = FoldedU;
+        V = FoldedV;
+    }
+
+    float Unit[3] = { Vector[0], Vector[1], Vector[2] };
+    Normalize(Unit);
+
+    // rounding each coordinate on its own is up to twice as far off as the best neighbour
+    float BaseU = std::floor(U * 32767.0f);
+    float BaseV = std::floor(V * 32767.0f);
+    float BestDot = -2.0f;
+    for (int Corner = 0; Corner < 4; ++Corner)
+    {
+        int16_t Candidate[2] =
+        {
+            (int16_t)std::min(std::max(BaseU + (Corner & 1), -32767.0f), 32767.0f),
+            (int16_t)std::min(std::max(BaseV + (Corner >> 1), -32767.0f), 32767.0f)
+        };
+
+        float Decoded[3];
+        DecodeOctahedral(Candidate, Decoded);
+        float Dot = Decoded[0] * Unit[0] + Decoded[1] * Unit[1] + Decoded[2] * Unit[2];
+        if (Dot > BestDot)
+        {
+            BestDot = Dot;
+            Encoded[0] = Candidate[0];
+            Encoded[1] = Candidate[1];
+        }
+    }
+}
+
+void Utility::DecodeOctahedral(const int16_t Encoded[2], float Vector[3])
+{
+    Vector[0] = SnormToFloat(Encoded[0]);
+    Vector[1] = SnormToFloat(Encoded[1]);
+    Vector[2] = 1.0f - std::fabs(Vector[0]) - std::fabs(Vector[1]);
+
+    // unfold the lower half, see DecodeOctahedral in common.hlsli
+    float Fold = std::max(-Vector[2], 0.0f);
+    Vector[0] += Vector[0] >= 0.0f ? -Fold : Fold;
+    Vector[1] += Vector[1] >= 0.0f ? -Fold : Fold;
+
+    Normalize(Vector);
+}
+
+uint16_t Utility::FloatToHalf(float Value)
+{
+    uint32_t Bits = FloatBits(Value);
+    uint32_t Sign = (Bits >> 16) & 0x8000;
+    Bits &= 0x7FFFFFFF;
+
+    uint32_t Half;
+    if (Bits >= 0x47800000)
+    {
+        // 65536 and up, infinity or NaN; a NaN stays one
+        Half = Bits > 0x7F800000 ? 0x7E00 : 0x7C00;
+    }
+    else if (Bits < 0x38800000)
+    {
+        // below 2^-14 the result is subnormal: adding 0.5 lines the half mantissa up with the
+        // bottom of the float one, and the float add rounds to nearest even for us
+        Half = FloatBits(BitsFloat(Bits) + 0.5f) - 0x3F000000;
+    }
+    else
+    {
+        // rebias the exponent and round the 13 dropped mantissa bits to nearest even; a carry
+        // out of the mantissa bumps the exponent, up to infinity past 65504
+        uint32_t Odd = (Bits >> 13) & 1;
+        Bits += 0xC8000000 + 0xFFF + Odd;
+        Half = Bits >> 13;
+    }
+    return (uint16_t)(Half | Sign);
+}
+
+float Utility::HalfToFloat(uint16_t Value)
+{
+    uint32_t Sign = (uint32_t)(Value & 0x8000) << 16;
+    uint32_t Exponent = (Value >> 10) & 0x1F;
+    uint32_t Mantissa = Value & 0x3FF;
+
+    if (Exponent == 0)
+    {
+        float Magnitude = Mantissa * (1.0f / 16777216.0f);  // 2^-24
+        return Sign ? -Magnitude : Magnitude;
+    }
+    if (Exponent == 31)
+        return BitsFloat(Sign | 0x7F800000 | (Mantissa << 13));
+    return BitsFloat(Sign | ((Exponent + 112) << 23) | (Mantissa << 13));
+}
+
+void Utility::QuantizeVertices(CompactVertex* Destination, size_t VertexCount, size_t Stride,
+    const float* Positions, const float* Normals, const float* TexCoords, const float* Tangents,
+    const PositionQuantization& Quantization)
+{
+    for (size_t v = 0; v < VertexCount; ++v)
+    {
+        CompactVertex& Out = Destination[v];
+
+        const float* P = Element(Positions, Stride, v);
+        for (int i = 0; i < 3; ++i)
+        {
+            float Unorm = (P[i] - Quantization.Bias[i]) / Quantization.Scale[i];
+            Out.Position[i] = (uint16_t)std::min(std::max(Unorm * 65535.0f + 0.5f, 0.0f), 65535.0f);
+        }
+        Out.Position[3] = 0;
+
+        EncodeOctahedral(Element(Normals, Stride, v), Out.Normal);
+        EncodeOctahedral(Element(Tangents, Stride, v), Out.Tangent);
+
+        const float* T = Element(TexCoords, Stride, v);
+        Out.TexC[0] = FloatToHalf(T[0]);
+        Out.TexC[1] = FloatToHalf(T[1]);
+    }
+}
+
+void Utility::DequantizeVertex(const CompactVertex& Vertex, const PositionQuantization& Quantization,
+    float Position[3], float Normal[3], float TexC[2], float Tangent[3])
+{
+    for (int i = 0; i < 3; ++i)
+        Position[i] = Vertex.Position[i] / 65535.0f * Quantization.Scale[i] + Quantization.Bias[i];
+
+    DecodeOctahedral(Vertex.Normal, Normal);
+    DecodeOctahedral(Vertex.Tangent, Tangent);
+
+    TexC[0] = HalfToFloat(Vertex.TexC[0]);
+    TexC[1] = HalfToFloat(Vertex.TexC[1]);
+}
+
+Utility::QuantizationError Utility::MeasureQuantizationError(const CompactVertex* Quantized, size_t VertexCount, size_t Stride,
+    const float* Positions, const float* Normals, const float* TexCoords, const float* Tangents,
+    const PositionQuantization& Quantization)
+{
+    QuantizationError Error = {};
+    for (size_t v = 0; v < VertexCount; ++v)
+    {
+        float Position[3], Normal[3], TexC[2], Tangent[3];
+        DequantizeVertex(Quantized[v], Quantization, Position, Normal, TexC, Tangent);
+
+        const float* P = Element(Positions, Stride, v);
+        const float* T = Element(TexCoords, Stride, v);
+        for (int i = 0; i < 3; ++i)
+            Error.Position = std::max(Error.Position, std::fabs(Position[i] - P[i]));
+        for (int i = 0; i < 2; ++i)
+            Error.TexC = std::max(Error.TexC, std::fabs(TexC[i] - T[i]));
+
+        Error.Normal = std::max(Error.Normal, AngleDegrees(Element(Normals, Stride, v), Normal));
+        Error.Tangent = std::max(Error.Tangent, AngleDegrees(Element(Tangents, Stride, v), Tangent));
+    }
+    return Error;
+}
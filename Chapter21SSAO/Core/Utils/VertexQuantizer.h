@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Utility
+{
+    // 20 byte vertex: positions as 16 bit unorm within the mesh bounds, normal and tangent
+    // octahedral encoded in two 16 bit snorms each, texture coordinates as half floats.
+    // Input layout formats R16G16B16A16_UNORM, R16G16_SNORM, R16G16_FLOAT, R16G16_SNORM.
+    struct CompactVertex
+    {
+        uint16_t Position[4];   // w is padding, always 0
+        int16_t Normal[2];
+        uint16_t TexC[2];
+        int16_t Tangent[2];
+    };
+
+    // A decoded position is the unorm value times Scale plus Bias
+    struct PositionQuantization
+    {
+        float Scale[3];
+        float Bias[3];
+    };
+
+    // Bounds of three float positions PositionStride bytes apart. Flat axes get a scale of 1
+    // so every component still decodes exactly to the bias.
+    PositionQuantization ComputePositionQuantization(const float* Positions, size_t PositionStride, size_t VertexCount);
+
+    // Encodes a unit vector, picking of the four nearest 16 bit values the one that decodes
+    // closest to it. Decoding renormalizes, as the shader does.
+    void EncodeOctahedral(const float Vector[3], int16_t Encoded[2]);
+    void DecodeOctahedral(const int16_t Encoded[2], float Vector[3]);
+
+    // IEEE half precision, rounding to nearest even and saturating to infinity
+    uint16_t FloatToHalf(float Value);
+    float HalfToFloat(uint16_t Value);
+
+    // Positions, normals and tangents are three floats and texture coordinates two, each
+    // Stride bytes from one vertex to the next, as when they all point into one array of structs
+    void QuantizeVertices(CompactVertex* Destination, size_t VertexCount, size_t Stride,
+        const float* Positions, const float* Normals, const float* TexCoords, const float* Tangents,
+        const PositionQuantization& Quantization);
+
+    // The CPU side of the shader decode, for checking what a mesh loses
+    void DequantizeVertex(const CompactVertex& Vertex, const PositionQuantization& Quantization,
+        float Position[3], float Normal[3], float TexC[2], float Tangent[3]);
+
+    // Largest difference between the source vertices and their quantized copies. Position and
+    // texture coordinate errors are the largest per component, normal and tangent errors the
+    // largest angle in degrees.
+    struct QuantizationError
+    {
+        float Position;
+        float Normal;
+        float TexC;
+        float Tangent;
+    };
+
+    QuantizationError MeasureQuantizationError(const CompactVertex* Quantized, size_t VertexCount, size_t Stride,
+        const float* Positions, const float* Normals, const float* TexCoords, const float* Tangents,
+        const PositionQuantization& Quantization);
+}
@@ -1,11 +1,259 @@
 #include "Waves.h"
-#include <ppl.h>
+#include "ThreadPool.h"
 #include <algorithm>
 #include <vector>
 #include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WAVES_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define WAVES_X86 0
+#endif
+
+// As in Hash.cpp: GCC and Clang only emit AVX inside functions that ask for it, MSVC always
+// does, so the rest of the build stays at its baseline instruction set
+#if defined(_MSC_VER) && !defined(__clang__)
+#define WAVES_TARGET(Features)
+#else
+#define WAVES_TARGET(Features) __attribute__((target(Features)))
+#endif
 
 using namespace DirectX;
 
+namespace
+{
+	// Rows handed to one worker at a time, roughly 4K cells so small grids stay on one thread.
+	int RowGrain(int numCols)
+	{
+		return std::max(1, 4096 / std::max(1, numCols));
+	}
+
+	// One interior row of the height update, prev is overwritten with the next solution
+	typedef void (*SolveRowFunc)(float* prev, const float* curr, int n, float k1, float k2, float k3);
+	// One interior row of normals and x tangents from the current solution
+	typedef void (*NormalRowFunc)(const float* curr, int n, float twoDx,
+		float* nx, float* ny, float* nz, float* tx, float* ty);
+
+	// Scalar columns from j on: the whole row without SIMD, the remainder with it. The
+	// vector loops below do the same operations in the same order, so every path gives the
+	// same bits.
+	inline void SolveRowTail(int j, float* prev, const float* curr, int n, float k1, float k2, float k3)
+	{
+		const float* up = curr - n;
+		const float* down = curr + n;
+		for (; j < n - 1; ++j)
+		{
+			prev[j] = k1 * prev[j] + k2 * curr[j] +
+				k3 * ((down[j] + up[j]) + (curr[j + 1] + curr[j - 1]));
+		}
+	}
+
+	inline void NormalRowTail(int j, const float* curr, int n, float twoDx,
+		float* nx, float* ny, float* nz, float* tx, float* ty)
+	{
+		const float* up = curr - n;
+		const float* down = curr + n;
+		for (; j < n - 1; ++j)
+		{
+			float l = curr[j - 1];
+			float r = curr[j + 1];
+			float t = up[j];
+			float b = down[j];
+
+			float dLR = l - r;
+			float dBT = b - t;
+			float lenSqT = twoDx * twoDx + dLR * dLR;
+			float invN = 1.0f / sqrtf(lenSqT + dBT * dBT);
+			float invT = 1.0f / sqrtf(lenSqT);
+
+			nx[j] = dLR * invN;
+			ny[j] = twoDx * invN;
+			nz[j] = dBT * invN;
+			tx[j] = twoDx * invT;
+			ty[j] = (r - l) * invT;
+		}
+	}
+
+	void SolveRowScalar(float* prev, const float* curr, int n, float k1, float k2, float k3)
+	{
+		SolveRowTail(1, prev, curr, n, k1, k2, k3);
+	}
+
+	void NormalRowScalar(const float* curr, int n, float twoDx,
+		float* nx, float* ny, float* nz, float* tx, float* ty)
+	{
+		NormalRowTail(1, curr, n, twoDx, nx, ny, nz, tx, ty);
+	}
+
+#if WAVES_X86
+
+	WAVES_TARGET("sse2") void SolveRowSSE2(float* prev, const float* curr, int n, float k1, float k2, float k3)
+	{
+		const float* up = curr - n;
+		const float* down = curr + n;
+		const __m128 vk1 = _mm_set1_ps(k1);
+		const __m128 vk2 = _mm_set1_ps(k2);
+		const __m128 vk3 = _mm_set1_ps(k3);
+
+		int j = 1;
+		for (; j + 4 <= n - 1; j += 4)
+		{
+			__m128 sum = _mm_add_ps(
+				_mm_add_ps(_mm_loadu_ps(down + j), _mm_loadu_ps(up + j)),
+				_mm_add_ps(_mm_loadu_ps(curr + j + 1), _mm_loadu_ps(curr + j - 1)));
+			__m128 h = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(vk1, _mm_loadu_ps(prev + j)), _mm_mul_ps(vk2, _mm_loadu_ps(curr + j))),
+				_mm_mul_ps(vk3, sum));
+			_mm_storeu_ps(prev + j, h);
+		}
+		SolveRowTail(j, prev, curr, n, k1, k2, k3);
+	}
+
+	WAVES_TARGET("sse2") void NormalRowSSE2(const float* curr, int n, float twoDx,
+		float* nx, float* ny, float* nz, float* tx, float* ty)
+	{
+		const float* up = curr - n;
+		const float* down = curr + n;
+		const __m128 vTwoDx = _mm_set1_ps(twoDx);
+		const __m128 vTwoDxSq = _mm_set1_ps(twoDx * twoDx);
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		int j = 1;
+		for (; j + 4 <= n - 1; j += 4)
+		{
+			__m128 l = _mm_loadu_ps(curr + j - 1);
+			__m128 r = _mm_loadu_ps(curr + j + 1);
+			__m128 t = _mm_loadu_ps(up + j);
+			__m128 b = _mm_loadu_ps(down + j);
+
+			// n = (l - r, 2dx, b - t), T = (2dx, r - l, 0)
+			__m128 dLR = _mm_sub_ps(l, r);
+			__m128 dBT = _mm_sub_ps(b, t);
+			__m128 lenSqT = _mm_add_ps(vTwoDxSq, _mm_mul_ps(dLR, dLR));
+			__m128 lenSqN = _mm_add_ps(lenSqT, _mm_mul_ps(dBT, dBT));
+			__m128 invN = _mm_div_ps(one, _mm_sqrt_ps(lenSqN));
+			__m128 invT = _mm_div_ps(one, _mm_sqrt_ps(lenSqT));
+
+			_mm_storeu_ps(nx + j, _mm_mul_ps(dLR, invN));
+			_mm_storeu_ps(ny + j, _mm_mul_ps(vTwoDx, invN));
+			_mm_storeu_ps(nz + j, _mm_mul_ps(dBT, invN));
+			_mm_storeu_ps(tx + j, _mm_mul_ps(vTwoDx, invT));
+			_mm_storeu_ps(ty + j, _mm_mul_ps(_mm_sub_ps(r, l), invT));
+		}
+		NormalRowTail(j, curr, n, twoDx, nx, ny, nz, tx, ty);
+	}
+
+	WAVES_TARGET("avx") void SolveRowAVX(float* prev, const float* curr, int n, float k1, float k2, float k3)
+	{
+		const float* up = curr - n;
+		const float* down = curr + n;
+		const __m256 vk1 = _mm256_set1_ps(k1);
+		const __m256 vk2 = _mm256_set1_ps(k2);
+		const __m256 vk3 = _mm256_set1_ps(k3);
+
+		int j = 1;
+		for (; j + 8 <= n - 1; j += 8)
+		{
+			__m256 sum = _mm256_add_ps(
+				_mm256_add_ps(_mm256_loadu_ps(down + j), _mm256_loadu_ps(up + j)),
+				_mm256_add_ps(_mm256_loadu_ps(curr + j + 1), _mm256_loadu_ps(curr + j - 1)));
+			__m256 h = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(vk1, _mm256_loadu_ps(prev + j)), _mm256_mul_ps(vk2, _mm256_loadu_ps(curr + j))),
+				_mm256_mul_ps(vk3, sum));
+			_mm256_storeu_ps(prev + j, h);
+		}
+		SolveRowTail(j, prev, curr, n, k1, k2, k3);
+	}
+
+	WAVES_TARGET("avx") void NormalRowAVX(const float* curr, int n, float twoDx,
+		float* nx, float* ny, float* nz, float* tx, float* ty)
+	{
+		const float* up = curr - n;
+		const float* down = curr + n;
+		const __m256 vTwoDx = _mm256_set1_ps(twoDx);
+		const __m256 vTwoDxSq = _mm256_set1_ps(twoDx * twoDx);
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		int j = 1;
+		for (; j + 8 <= n - 1; j += 8)
+		{
+			__m256 l = _mm256_loadu_ps(curr + j - 1);
+			__m256 r = _mm256_loadu_ps(curr + j + 1);
+			__m256 t = _mm256_loadu_ps(up + j);
+			__m256 b = _mm256_loadu_ps(down + j);
+
+			__m256 dLR = _mm256_sub_ps(l, r);
+			__m256 dBT = _mm256_sub_ps(b, t);
+			__m256 lenSqT = _mm256_add_ps(vTwoDxSq, _mm256_mul_ps(dLR, dLR));
+			__m256 lenSqN = _mm256_add_ps(lenSqT, _mm256_mul_ps(dBT, dBT));
+			__m256 invN = _mm256_div_ps(one, _mm256_sqrt_ps(lenSqN));
+			__m256 invT = _mm256_div_ps(one, _mm256_sqrt_ps(lenSqT));
+
+			_mm256_storeu_ps(nx + j, _mm256_mul_ps(dLR, invN));
+			_mm256_storeu_ps(ny + j, _mm256_mul_ps(vTwoDx, invN));
+			_mm256_storeu_ps(nz + j, _mm256_mul_ps(dBT, invN));
+			_mm256_storeu_ps(tx + j, _mm256_mul_ps(vTwoDx, invT));
+			_mm256_storeu_ps(ty + j, _mm256_mul_ps(_mm256_sub_ps(r, l), invT));
+		}
+		NormalRowTail(j, curr, n, twoDx, nx, ny, nz, tx, ty);
+	}
+
+	bool CpuSupportsSSE2(void)
+	{
+#ifdef _MSC_VER
+		int Info[4];
+		__cpuid(Info, 1);
+		return (Info[3] & (1 << 26)) != 0;
+#else
+		return __builtin_cpu_supports("sse2");
+#endif
+	}
+
+	// The CPU has AVX and the OS saves the YMM registers across context switches
+	bool CpuSupportsAVX(void)
+	{
+#ifdef _MSC_VER
+		int Info[4];
+		__cpuid(Info, 1);
+		const int OSXSaveAndAVX = (1 << 27) | (1 << 28);
+		return (Info[2] & OSXSaveAndAVX) == OSXSaveAndAVX && (_xgetbv(0) & 6) == 6;
+#else
+		return __builtin_cpu_supports("avx");
+#endif
+	}
+
+#endif
+
+	struct Kernels
+	{
+		SolveRowFunc SolveRow;
+		NormalRowFunc NormalRow;
+		const char* Name;
+	};
+
+	Kernels SelectKernels(void)
+	{
+#if WAVES_X86
+		if (CpuSupportsAVX())
+			return { SolveRowAVX, NormalRowAVX, "AVX" };
+		if (CpuSupportsSSE2())
+			return { SolveRowSSE2, NormalRowSSE2, "SSE2" };
+#endif
+		return { SolveRowScalar, NormalRowScalar, "Scalar" };
+	}
+
+	const Kernels& GetKernels(void)
+	{
+		static const Kernels s_Kernels = SelectKernels();
+		return s_Kernels;
+	}
+}
+
 Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
 {
 	mNumRows = m;
@@ -23,32 +271,36 @@ Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
 	mK2 = (4.0f - 8.0f * e) / d;
 	mK3 = (2.0f * e) / d;
 
-	mPrevSolution.resize(m * n);
-	mCurrSolution.resize(m * n);
-	mNormals.resize(m * n);
-	mTangentX.resize(m * n);
+	mPrevHeight.assign(m * n, 0.0f);
+	mCurrHeight.assign(m * n, 0.0f);
 
-	// Generate grid vertices in system memory.
+	// boundary normals/tangents are never recomputed, so both snapshots start flat
+	for (Snapshot& snapshot : mSnapshots)
+	{
+		snapshot.Height.assign(m * n, 0.0f);
+		snapshot.NormalX.assign(m * n, 0.0f);
+		snapshot.NormalY.assign(m * n, 1.0f);
+		snapshot.NormalZ.assign(m * n, 0.0f);
+		snapshot.TangentX.assign(m * n, 1.0f);
+		snapshot.TangentY.assign(m * n, 0.0f);
+	}
+
+	// Generate grid coordinates in system memory.
 
 	float halfWidth = (n - 1) * dx * 0.5f;
 	float halfDepth = (m - 1) * dx * 0.5f;
-	for (int i = 0; i < m; ++i)
-	{
-		float z = halfDepth - i * dx;
-		for (int j = 0; j < n; ++j)
-		{
-			float x = -halfWidth + j * dx;
 
-			mPrevSolution[i * n + j] = XMFLOAT3(x, 0.0f, z);
-			mCurrSolution[i * n + j] = XMFLOAT3(x, 0.0f, z);
-			mNormals[i * n + j] = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			mTangentX[i * n + j] = XMFLOAT3(1.0f, 0.0f, 0.0f);
-		}
-	}
+	mX.resize(n);
+	mZ.resize(m);
+	for (int j = 0; j < n; ++j)
+		mX[j] = -halfWidth + j * dx;
+	for (int i = 0; i < m; ++i)
+		mZ[i] = halfDepth - i * dx;
 }
 
 Waves::~Waves()
 {
+	WaitForUpdate();
 }
 
 int Waves::RowCount()const
@@ -81,73 +333,167 @@ float Waves::Depth()const
 	return mNumRows * mSpatialStep;
 }
 
-void Waves::Update(float dt)
+int Waves::Update(float dt)
 {
-	static float t = 0;
+	WaitForUpdate();
+	TakeDisturbances();
+	return RunSteps(dt);
+}
 
-	// Accumulate time.
-	t += dt;
+void Waves::UpdateAsync(float dt)
+{
+	WaitForUpdate();
+	TakeDisturbances();
 
-	// Only update the simulation at the specified time step.
-	if (t >= mTimeStep)
 	{
-		// Only update interior points; we use zero boundary conditions.
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
-			//for(int i = 1; i < mNumRows-1; ++i)
-			{
-				for (int j = 1; j < mNumCols - 1; ++j)
-				{
-					// After this update we will be discarding the old previous
-					// buffer, so overwrite that buffer with the new update.
-					// Note how we can do this inplace (read/write to same element) 
-					// because we won't need prev_ij again and the assignment happens last.
-
-					// Note j indexes x and i indexes z: h(x_j, z_i, t_k)
-					// Moreover, our +z axis goes "down"; this is just to 
-					// keep consistent with our row indices going down.
-
-					mPrevSolution[i * mNumCols + j].y =
-						mK1 * mPrevSolution[i * mNumCols + j].y +
-						mK2 * mCurrSolution[i * mNumCols + j].y +
-						mK3 * (mCurrSolution[(i + 1) * mNumCols + j].y +
-							mCurrSolution[(i - 1) * mNumCols + j].y +
-							mCurrSolution[i * mNumCols + j + 1].y +
-							mCurrSolution[i * mNumCols + j - 1].y);
-				}
-			});
-
-		// We just overwrote the previous buffer with the new data, so
-		// this data needs to become the current solution and the old
-		// current solution becomes the new previous solution.
-		std::swap(mPrevSolution, mCurrSolution);
-
-		t = 0.0f; // reset time
-
-		//
-		// Compute normals using finite difference scheme.
-		//
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
-			//for(int i = 1; i < mNumRows - 1; ++i)
+		std::lock_guard<std::mutex> LockGuard(mUpdateMutex);
+		mUpdating = true;
+	}
+
+	ThreadPool::Submit([this, dt]
+		{
+			RunSteps(dt);
+
 			{
-				for (int j = 1; j < mNumCols - 1; ++j)
-				{
-					float l = mCurrSolution[i * mNumCols + j - 1].y;
-					float r = mCurrSolution[i * mNumCols + j + 1].y;
-					float t = mCurrSolution[(i - 1) * mNumCols + j].y;
-					float b = mCurrSolution[(i + 1) * mNumCols + j].y;
-					mNormals[i * mNumCols + j].x = -r + l;
-					mNormals[i * mNumCols + j].y = 2.0f * mSpatialStep;
-					mNormals[i * mNumCols + j].z = b - t;
+				std::lock_guard<std::mutex> LockGuard(mUpdateMutex);
+				mUpdating = false;
+			}
+			mUpdateDone.notify_all();
+		});
+}
 
-					XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&mNormals[i * mNumCols + j]));
-					XMStoreFloat3(&mNormals[i * mNumCols + j], n);
+void Waves::WaitForUpdate()
+{
+	std::unique_lock<std::mutex> Lock(mUpdateMutex);
+	mUpdateDone.wait(Lock, [this] { return !mUpdating; });
+}
+
+int Waves::RunSteps(float dt)
+{
+	bool disturbed = ApplyDisturbances();
+
+	// Accumulate time and only update the simulation at the specified time step,
+	// carrying the remainder over to the next call.
+	mAccumulator += dt;
 
-					mTangentX[i * mNumCols + j] = XMFLOAT3(2.0f * mSpatialStep, r - l, 0.0f);
-					XMVECTOR T = XMVector3Normalize(XMLoadFloat3(&mTangentX[i * mNumCols + j]));
-					XMStoreFloat3(&mTangentX[i * mNumCols + j], T);
-				}
-			});
+	int steps = 0;
+	while (mAccumulator >= mTimeStep && steps < mMaxSubsteps)
+	{
+		Step();
+		mAccumulator -= mTimeStep;
+		++steps;
 	}
+
+	// Too far behind to catch up: drop whole steps rather than spiral.
+	if (mAccumulator >= mTimeStep)
+		mAccumulator = fmodf(mAccumulator, mTimeStep);
+
+	mStepCount += steps;
+
+	if (steps > 0 || disturbed)
+		Publish();
+
+	return steps;
+}
+
+void Waves::TakeDisturbances()
+{
+	std::lock_guard<std::mutex> LockGuard(mDisturbMutex);
+
+	// the two vectors trade places, so neither reallocates once both have grown
+	mUpdateDisturbances.clear();
+	mUpdateDisturbances.swap(mPendingDisturbances);
+}
+
+bool Waves::ApplyDisturbances()
+{
+	if (mUpdateDisturbances.empty())
+		return false;
+
+	for (const Disturbance& d : mUpdateDisturbances)
+	{
+		float halfMag = 0.5f * d.magnitude;
+
+		// Disturb the ijth vertex height and its neighbors.
+		mCurrHeight[d.i * mNumCols + d.j] += d.magnitude;
+		mCurrHeight[d.i * mNumCols + d.j + 1] += halfMag;
+		mCurrHeight[d.i * mNumCols + d.j - 1] += halfMag;
+		mCurrHeight[(d.i + 1) * mNumCols + d.j] += halfMag;
+		mCurrHeight[(d.i - 1) * mNumCols + d.j] += halfMag;
+	}
+	mUpdateDisturbances.clear();
+	return true;
+}
+
+void Waves::Step()
+{
+	// Only update interior points; we use zero boundary conditions.
+	ThreadPool::ParallelForRange(1, mNumRows - 1, [this](int rowBegin, int rowEnd)
+		{
+			SolveRows(rowBegin, rowEnd);
+		}, RowGrain(mNumCols));
+
+	// We just overwrote the previous buffer with the new data, so
+	// this data needs to become the current solution and the old
+	// current solution becomes the new previous solution.
+	std::swap(mPrevHeight, mCurrHeight);
+}
+
+void Waves::Publish()
+{
+	// the front snapshot may be read concurrently, only the back one is written
+	Snapshot& back = mSnapshots[1 - mFront.load(std::memory_order_relaxed)];
+
+	back.Height = mCurrHeight;
+	back.StepCount = mStepCount;
+
+	//
+	// Compute normals using finite difference scheme.
+	// Only needed for the published solution, not for every substep.
+	//
+	ThreadPool::ParallelForRange(1, mNumRows - 1, [this, &back](int rowBegin, int rowEnd)
+		{
+			ComputeNormalRows(back, rowBegin, rowEnd);
+		}, RowGrain(mNumCols));
+
+	mFront.store(1 - mFront.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void Waves::SolveRows(int rowBegin, int rowEnd)
+{
+	const int n = mNumCols;
+	const SolveRowFunc SolveRow = GetKernels().SolveRow;
+
+	for (int i = rowBegin; i < rowEnd; ++i)
+	{
+		// After this update we will be discarding the old previous
+		// buffer, so overwrite that buffer with the new update.
+		// Note how we can do this inplace (read/write to same element)
+		// because we won't need prev_ij again and the assignment happens last.
+
+		// Note j indexes x and i indexes z: h(x_j, z_i, t_k)
+		// Moreover, our +z axis goes "down"; this is just to
+		// keep consistent with our row indices going down.
+		SolveRow(&mPrevHeight[i * n], &mCurrHeight[i * n], n, mK1, mK2, mK3);
+	}
+}
+
+void Waves::ComputeNormalRows(Snapshot& target, int rowBegin, int rowEnd)
+{
+	const int n = mNumCols;
+	const float twoDx = 2.0f * mSpatialStep;
+	const NormalRowFunc NormalRow = GetKernels().NormalRow;
+
+	for (int i = rowBegin; i < rowEnd; ++i)
+	{
+		NormalRow(&mCurrHeight[i * n], n, twoDx, &target.NormalX[i * n], &target.NormalY[i * n],
+			&target.NormalZ[i * n], &target.TangentX[i * n], &target.TangentY[i * n]);
+	}
+}
+
+const char* Waves::GetKernelName(void)
+{
+	return GetKernels().Name;
 }
 
 void Waves::Disturb(int i, int j, float magnitude)
@@ -156,12 +502,6 @@ void Waves::Disturb(int i, int j, float magnitude)
 	assert(i > 1 && i < mNumRows - 2);
 	assert(j > 1 && j < mNumCols - 2);
 
-	float halfMag = 0.5f * magnitude;
-
-	// Disturb the ijth vertex height and its neighbors.
-	mCurrSolution[i * mNumCols + j].y += magnitude;
-	mCurrSolution[i * mNumCols + j + 1].y += halfMag;
-	mCurrSolution[i * mNumCols + j - 1].y += halfMag;
-	mCurrSolution[(i + 1) * mNumCols + j].y += halfMag;
-	mCurrSolution[(i - 1) * mNumCols + j].y += halfMag;
-}
\ No newline at end of file
+	std::lock_guard<std::mutex> LockGuard(mDisturbMutex);
+	mPendingDisturbances.push_back({ i, j, magnitude });
+}
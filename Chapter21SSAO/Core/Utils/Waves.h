@@ -4,12 +4,25 @@
 // Performs the calculations for the wave simulation.  After the simulation has been
 // updated, the client must copy the current solution into vertex buffers for rendering.
 // This class only does the calculations, it does not do any drawing.
+//
+// The solution is stored as a structure of arrays: x/z never change, so only the heights
+// are simulated, and normals/tangents live in separate component arrays so the stencil
+// kernels stream through contiguous floats. The row kernels are picked once per process
+// from what the CPU supports: AVX, SSE2 or scalar, all giving the same results.
+//
+// The simulation runs at a fixed time step decoupled from the frame rate. Results are
+// published into one of two snapshots, so the accessors always see the last completed
+// step while UpdateAsync computes the next one on a worker thread.
 //***************************************************************************************
 
 #ifndef WAVES_H
 #define WAVES_H
 
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <DirectXMath.h>
 
 class Waves
@@ -28,18 +41,76 @@ public:
     float Depth()const;
 
     // Returns the solution at the ith grid point.
-    const DirectX::XMFLOAT3& Position(int i)const { return mCurrSolution[i]; }
+    DirectX::XMFLOAT3 Position(int i)const
+    {
+        return DirectX::XMFLOAT3(mX[i % mNumCols], Front().Height[i], mZ[i / mNumCols]);
+    }
 
     // Returns the solution normal at the ith grid point.
-    const DirectX::XMFLOAT3& Normal(int i)const { return mNormals[i]; }
+    DirectX::XMFLOAT3 Normal(int i)const
+    {
+        const Snapshot& s = Front();
+        return DirectX::XMFLOAT3(s.NormalX[i], s.NormalY[i], s.NormalZ[i]);
+    }
 
     // Returns the unit tangent vector at the ith grid point in the local x-axis direction.
-    const DirectX::XMFLOAT3& TangentX(int i)const { return mTangentX[i]; }
+    DirectX::XMFLOAT3 TangentX(int i)const
+    {
+        const Snapshot& s = Front();
+        return DirectX::XMFLOAT3(s.TangentX[i], s.TangentY[i], 0.0f);
+    }
+
+    // Raw height field of the last published solution, row-major m x n.
+    const float* Heights()const { return Front().Height.data(); }
+
+    // Advances the simulation by dt on the calling thread. Runs as many fixed steps as
+    // fit in the accumulated time, at most MaxSubsteps, and returns how many ran.
+    int Update(float dt);
 
-    void Update(float dt);
+    // Same as Update but on a worker thread; the accessors keep returning the previous
+    // snapshot until it completes. Waits for any update still in flight first.
+    void UpdateAsync(float dt);
+    void WaitForUpdate();
+
+    // Queued for the next Update or UpdateAsync call, so it is safe while an update is
+    // running: that update took the queue when it started.
     void Disturb(int i, int j, float magnitude);
 
+    // Upper bound on steps per Update; time beyond that is dropped instead of
+    // letting the simulation fall further behind every frame.
+    void SetMaxSubsteps(int maxSubsteps) { mMaxSubsteps = maxSubsteps; }
+
+    // Total number of fixed steps taken since construction.
+    uint64_t StepCount()const { return Front().StepCount; }
+
+    // Name of the row kernels the solver dispatches to, for logs and benchmarks
+    static const char* GetKernelName(void);
+
 private:
+    struct Snapshot
+    {
+        std::vector<float> Height;
+        std::vector<float> NormalX;
+        std::vector<float> NormalY;
+        std::vector<float> NormalZ;
+        std::vector<float> TangentX;
+        std::vector<float> TangentY;
+        uint64_t StepCount = 0;
+    };
+
+    const Snapshot& Front()const { return mSnapshots[mFront.load(std::memory_order_acquire)]; }
+
+    // Moves the queued disturbances to the update about to run, on the calling thread.
+    void TakeDisturbances();
+    int RunSteps(float dt);
+    bool ApplyDisturbances();
+    // One simulation step: Laplacian update of the interior heights.
+    void Step();
+    void SolveRows(int rowBegin, int rowEnd);
+    // Writes heights, normals and tangents of the current solution into the back snapshot and flips it.
+    void Publish();
+    void ComputeNormalRows(Snapshot& target, int rowBegin, int rowEnd);
+
     int mNumRows = 0;
     int mNumCols = 0;
 
@@ -54,10 +125,32 @@ private:
     float mTimeStep = 0.0f;
     float mSpatialStep = 0.0f;
 
-    std::vector<DirectX::XMFLOAT3> mPrevSolution;
-    std::vector<DirectX::XMFLOAT3> mCurrSolution;
-    std::vector<DirectX::XMFLOAT3> mNormals;
-    std::vector<DirectX::XMFLOAT3> mTangentX;
+    // Time not yet consumed by a fixed step.
+    float mAccumulator = 0.0f;
+    int mMaxSubsteps = 4;
+    uint64_t mStepCount = 0;
+
+    // Grid coordinates per column (x) and per row (z).
+    std::vector<float> mX;
+    std::vector<float> mZ;
+
+    // Simulation state, only touched by the thread running the update.
+    std::vector<float> mPrevHeight;
+    std::vector<float> mCurrHeight;
+
+    Snapshot mSnapshots[2];
+    std::atomic<int> mFront{ 0 };
+
+    struct Disturbance { int i; int j; float magnitude; };
+    std::vector<Disturbance> mPendingDisturbances;
+    std::mutex mDisturbMutex;
+    // taken by the update in flight, only touched by the thread running it
+    std::vector<Disturbance> mUpdateDisturbances;
+
+    // set while an UpdateAsync job is in flight
+    bool mUpdating = false;
+    std::mutex mUpdateMutex;
+    std::condition_variable mUpdateDone;
 };
 
-#endif // WAVES_H
\ No newline at end of file
+#endif // WAVES_H
@@ -22,10 +22,14 @@
 #endif
 
 // VS 2010's stdint.h conflicts with intsafe.h
+#ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4005)
+#endif
 #include <stdint.h>
+#ifdef _MSC_VER
 #pragma warning(pop)
+#endif
 
 namespace DirectX
 {
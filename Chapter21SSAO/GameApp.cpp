@@ -11,7 +11,12 @@
 #include "GeometryGenerator.h"
 #include "TextureManager.h"
 #include "DescriptorHeap.h"
+#include "ThreadPool.h"
+#include "MeshOptimizer.h"
+#include "MeshFile.h"
+#include "ObjectConstants.h"
 #include <fstream>
+#include <cfloat>
 #include <d3dcompiler.h>
 
 
@@ -59,6 +64,21 @@ void GameApp::Startup(void)
 	BuildShapeRenderItems();
 	BuildSkyboxRenderItems();
 
+	// geometry and material ids used by the render item sort keys
+	AssignSortIds();
+
+	AttachMeshlets();
+
+	// every render item owns one slot of the per-frame object constants
+	for (size_t i = 0; i < m_AllRenders.size(); ++i)
+		m_AllRenders[i]->ObjectIndex = (UINT)i;
+
+	// one command per opaque item and, at worst, one batch each
+	UINT indirectItems = (std::max)((UINT)(m_ShapeRenders[(int)RenderLayer::Opaque].size() +
+		m_ShapeRenders[(int)RenderLayer::OpaqueDynamicReflectors].size()), 1u);
+	m_DrawCommands.Create(L"Indirect Draw Commands", indirectItems, sizeof(Utility::IndirectDrawCommand));
+	m_DrawCounts.Create(L"Indirect Draw Counts", indirectItems, sizeof(uint32_t));
+
 	// build cubemap camera
 	BuildCubeFaceCamera(0.0, 2.0, 0.0);
 
@@ -76,12 +96,20 @@ void GameApp::Startup(void)
 
 void GameApp::Cleanup(void)
 {
+	// patch jobs still running read the hills through this
+	m_Terrain.reset();
+
+	m_DrawCommands.Destroy();
+	m_DrawCounts.Destroy();
+	m_DrawSignature.Destroy();
+
 	for (auto& iter : m_AllRenders)
 	{
 		iter->Geo->m_VertexBuffer.Destroy();
 		iter->Geo->m_IndexBuffer.Destroy();
 	}
 
+	m_MaterialOrder.clear();
 	m_Materials.clear();
 	m_Textures.clear();
 	m_Geometry.clear();
@@ -117,36 +145,227 @@ void GameApp::Update(float deltaT)
 	if (GameInput::IsFirstPressed(GameInput::kKey_f1))
 		m_bRenderShapes = !m_bRenderShapes;
 
+	if (GameInput::IsFirstPressed(GameInput::kKey_f2))
+		m_bParallelRecording = !m_bParallelRecording;
+
+	// the patch pool is only allocated and filled the first time the terrain is shown
+	if (GameInput::IsFirstPressed(GameInput::kKey_f4))
+	{
+		m_bRenderTerrain = !m_bRenderTerrain;
+		if (m_bRenderTerrain && !m_bTerrainPrimed)
+			PrimeTerrain();
+	}
+
+	if (GameInput::IsFirstPressed(GameInput::kKey_f5))
+		m_bGpuDriven = !m_bGpuDriven;
+
+	// state changes issued/skipped by the contexts finished since the last press
+	if (GameInput::IsFirstPressed(GameInput::kKey_f3))
+	{
+		StateChangeStats stats = CommandContext::GetStateChangeStats();
+		Utility::Printf("PSO %u/%u, topology %u/%u, VB %u/%u, IB %u/%u (issued/skipped)\n",
+			stats.Issued[StateChangeStats::kPipelineState], stats.Skipped[StateChangeStats::kPipelineState],
+			stats.Issued[StateChangeStats::kPrimitiveTopology], stats.Skipped[StateChangeStats::kPrimitiveTopology],
+			stats.Issued[StateChangeStats::kVertexBuffer], stats.Skipped[StateChangeStats::kVertexBuffer],
+			stats.Issued[StateChangeStats::kIndexBuffer], stats.Skipped[StateChangeStats::kIndexBuffer]);
+
+		// barriers of every context, per frame, and what the frame graph's own came to last frame
+		float frames = (float)(std::max)(m_FramesSinceStats, 1u);
+		BarrierSolver::Stats graph = m_FrameGraph.GetLastBarrierStats();
+		Utility::Printf("Barriers per frame: %.1f transitions, %.1f split, %.1f ResourceBarrier calls; frame graph %u + %u split, %u UAV in %u calls, %u elided\n",
+			stats.Barriers / frames, stats.SplitBarriers / frames, stats.BarrierCalls / frames,
+			graph.Transitions, graph.SplitTransitions, graph.UAVBarriers, graph.BarrierCalls, graph.Elided);
+		m_FramesSinceStats = 0;
+
+		// CPU descriptor recycling, live should stay flat while resources are recreated
+		static const char* heapNames[] = { "CBV/SRV/UAV", "sampler", "RTV", "DSV" };
+		for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+		{
+			DescriptorBlockAllocator::Stats heap = Graphics::g_DescriptorAllocator[i].GetStats();
+			Utility::Printf("%s descriptors: %u live, %u free, %u pending in %u heaps\n", heapNames[i],
+				heap.LiveDescriptors, heap.FreeDescriptors, heap.PendingDescriptors, heap.NumHeaps);
+		}
+
+		// upload pages shared by every context, current (peak)
+		PagePool::Stats pages = LinearAllocator::GetStats(kCpuWritable);
+		Utility::Printf("Upload pages: %u (%u), %llu KB (%llu KB), in use %u (%u), large pages created %u, reused %u\n",
+			pages.NumPages, pages.PeakPages, pages.NumBytes >> 10, pages.PeakBytes >> 10,
+			pages.PagesInUse, pages.PeakPagesInUse, pages.LargePagesCreated, pages.LargePagesReused);
+
+		// triangles of one draw of every item at the levels picked for this frame
+		UINT lodTriangles = 0, fullTriangles = 0, itemsReduced = 0;
+		for (auto& item : m_AllRenders)
+		{
+			lodTriangles += item->IndexCount / 3;
+			fullTriangles += (item->Lods.empty() ? item->IndexCount : item->Lods[0]->IndexCount) / 3;
+			itemsReduced += item->Lod > 0 ? 1 : 0;
+		}
+		Utility::Printf("LOD: %u of %u triangles, %u items below full detail\n", lodTriangles, fullTriangles, itemsReduced);
+
+		// clusters of the camera passes, last frame
+		Utility::Printf("Clusters: %u, %u back-facing, %u off-screen, %u of %u triangles rejected\n",
+			m_ClusterStats.Meshlets, m_ClusterStats.BackFacing, m_ClusterStats.OutsideFrustum,
+			m_ClusterStats.TrianglesRejected, m_ClusterStats.Triangles);
+
+		// terrain patches of the last frame and what the streamer has done since the start
+		Utility::TerrainStreamer::Stats terrain = m_Terrain->GetStats();
+		Utility::Printf("Terrain: %u of %u patches drawn, %u selected, %u resident, %u pending, %u generated, %u evicted\n",
+			(UINT)m_VisibleTerrain.size(), terrain.Drawn, terrain.Selected, terrain.Resident, terrain.Pending,
+			terrain.Generated, terrain.Evicted);
+
+		// what the GPU cull of the last frame kept, worked out again by its CPU reference
+		if (m_bGpuDriven)
+		{
+			std::vector<XMFLOAT4X4> worlds(m_AllRenders.size());
+			for (auto& item : m_AllRenders)
+				XMStoreFloat4x4(&worlds[item->ObjectIndex], XMMatrixTranspose(item->World));
+
+			std::vector<Utility::IndirectDrawCommand> commands(m_IndirectInstances.size());
+			std::vector<uint32_t> counts(m_IndirectBatches.size());
+			Utility::CullInstances(m_IndirectInstances.data(), m_IndirectBatches.data(), m_IndirectBatches.size(),
+				&worlds[0].m[0][0], sizeof(XMFLOAT4X4), m_CullPlanes, commands.data(), counts.data());
+
+			UINT drawn = 0;
+			for (uint32_t count : counts)
+				drawn += count;
+			Utility::Printf("Indirect: %u of %u items drawn in %u batches\n", drawn, (UINT)m_IndirectInstances.size(),
+				(UINT)m_IndirectBatches.size());
+		}
+	}
+
+	SelectLods();
+
+	// start generating the patches the eye needs, the ones drawn change once all are there
+	if (m_bRenderTerrain)
+		UpdateTerrain();
+
+	// group items sharing pipeline, geometry and material so the contexts can drop the redundant state
+	XMMATRIX view = camera.GetViewMatrix();
+	for (int i = 0; i < (int)RenderLayer::Count; ++i)
+	{
+		SortRenderItems(m_ShapeRenders[i], (RenderLayer)i, view);
+		SortRenderItems(m_LandRenders[i], (RenderLayer)i, view);
+	}
+
 	
 
 }
 
 void GameApp::RenderScene(void)
 {
-	GraphicsContext& gfxContext = GraphicsContext::Begin(L"Scene Render");
+	// ESM完成之前的绘制
+	m_BlurMap->Execute(m_shadowMap->GetShadowBuffer(), 1);
+	m_BlurMap->GenerateMipMaps();
+
+	// constants of all render items go up in one block before any pass records
+	UploadObjectConstants();
+	UploadMaterialConstants();
+
+	// before any pass records, the camera passes draw the index lists it leaves, or the
+	// commands the GPU cull writes from the instances
+	if (m_bGpuDriven)
+		BuildIndirectInstances();
+	else
+		CullClusters();
+
+	// patches generated since the last frame are copied into their slots before anything draws
+	GpuBuffer& terrainPool = m_TerrainRitem->Geo->m_VertexBuffer;
+	m_VisibleTerrain.clear();
+	if (m_bRenderTerrain)
+	{
+		m_Terrain->TakeUploads(m_TerrainUploads);
+		CullTerrain();
+	}
 
-	// draw cubemap
-	DrawSceneToCubeMap(gfxContext);
+	// every pass records into its own context on the thread pool, so the passes only declare
+	// what they read and write and the frame graph works out the barriers between them. The
+	// terrain pool is only declared while it is drawn, before the first F4 it does not exist
+	m_FrameGraph.Reset();
 
-	DrawSceneToShadowMap(gfxContext);
+	if (!m_TerrainUploads.empty())
+	{
+		const size_t patchBytes = Utility::TerrainVerticesPerPatch(m_Terrain->GetDesc().PatchQuads) * sizeof(Vertex);
+		DynAlloc alloc = m_ObjectAllocator.Allocate(m_TerrainUploads.size() * patchBytes);
+		std::vector<uint32_t> slots;
+		for (size_t i = 0; i < m_TerrainUploads.size(); ++i)
+		{
+			memcpy((char*)alloc.DataPtr + i * patchBytes, m_TerrainUploads[i].Vertices.data(), patchBytes);
+			slots.push_back(m_TerrainUploads[i].Slot);
+		}
+		m_TerrainUploads.clear();
 
-	//DrawSceneToDepth2Map(gfxContext);
+		m_FrameGraph.AddPass(L"Terrain Upload", [alloc, slots, patchBytes, &terrainPool](GraphicsContext& gfxContext)
+		{
+			for (size_t i = 0; i < slots.size(); ++i)
+				gfxContext.CopyBufferRegion(terrainPool, slots[i] * patchBytes, alloc.Buffer, alloc.Offset + i * patchBytes, patchBytes);
+		})
+			.Write(terrainPool, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
 
-	DrawSceneToNormal(gfxContext);
+	// one pass per face so the most expensive part of the frame spreads across workers too
+	for (int i = 0; i < 6; ++i)
+	{
+		m_FrameGraph.AddPass(L"Cube Map Face", [this, i](GraphicsContext& gfxContext) { DrawSceneToCubeMap(gfxContext, i); })
+			.Write(g_SceneCubeMapBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET)
+			.Write(g_CubeMapDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	}
 
-	ComputeSSAO(gfxContext);
+	m_FrameGraph.AddPass(L"Shadow Map", [this](GraphicsContext& gfxContext) { DrawSceneToShadowMap(gfxContext); })
+		.Write(m_shadowMap->GetShadowBuffer(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
-	// ESM完成之前的绘制
-	m_BlurMap->Execute(m_shadowMap->GetShadowBuffer(), 1);
-	m_BlurMap->GenerateMipMaps();
+	if (m_bGpuDriven && !m_IndirectBatches.empty())
+	{
+		m_FrameGraph.AddPass(L"GPU Cull", [this](GraphicsContext& gfxContext) { CullInstancesOnGpu(gfxContext); })
+			.Write(m_DrawCommands, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+			.Write(m_DrawCounts, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
 
+	FrameGraph::Pass& normalPass = m_FrameGraph.AddPass(L"Normal", [this](GraphicsContext& gfxContext) { DrawSceneToNormal(gfxContext); })
+		.Write(m_SSAO->GetNormalMap(), D3D12_RESOURCE_STATE_RENDER_TARGET)
+		.Write(m_SSAO->GetPosMAP(), D3D12_RESOURCE_STATE_RENDER_TARGET)
+		.Write(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE)
+		.Read(g_SceneCubeMapBuffer, D3D12_RESOURCE_STATE_GENERIC_READ)
+		.Read(m_DrawCommands, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT)
+		.Read(m_DrawCounts, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+	if (m_bRenderTerrain)
+		normalPass.Read(terrainPool, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	m_FrameGraph.AddPass(L"SSAO", [this](GraphicsContext& gfxContext) { ComputeSSAO(gfxContext); })
+		.Write(m_SSAO->GetSSAOMAP(), D3D12_RESOURCE_STATE_RENDER_TARGET)
+		.Read(m_SSAO->GetNormalMap(), D3D12_RESOURCE_STATE_GENERIC_READ)
+		.Read(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	// the blur reads the shadow map again at the start of the next frame
+	FrameGraph::Pass& scenePass = m_FrameGraph.AddPass(L"Scene Render", [this](GraphicsContext& gfxContext) { DrawSceneToBackBuffer(gfxContext); })
+		.Write(g_DisplayPlane[g_CurrentBuffer], D3D12_RESOURCE_STATE_RENDER_TARGET)
+		.Write(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE)
+		.Read(g_SceneCubeMapBuffer, D3D12_RESOURCE_STATE_GENERIC_READ)
+		.Read(m_shadowMap->GetShadowBuffer(), D3D12_RESOURCE_STATE_GENERIC_READ)
+		.Read(m_SSAO->GetSSAOMAP(), D3D12_RESOURCE_STATE_GENERIC_READ)
+		.Read(m_DrawCommands, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT)
+		.Read(m_DrawCounts, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT)
+		.Leave(g_DisplayPlane[g_CurrentBuffer], D3D12_RESOURCE_STATE_PRESENT);
+	if (m_bRenderTerrain)
+		scenePass.Read(terrainPool, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	uint64_t FenceValue = m_FrameGraph.Execute(m_bParallelRecording);
+	++m_FramesSinceStats;
+
+	m_ObjectAllocator.CleanupUsedPages(FenceValue);
+
+	// slots of the patches drawn are not reused before this frame completes
+	if (m_bRenderTerrain)
+		m_Terrain->RetireFrame(FenceValue);
+
+	// the waves region written this frame can be reused once this frame completes
+	m_Geometry["waveGeo"]->m_DynamicVertexBuffer->EndFrame(FenceValue);
+}
 
+void GameApp::DrawSceneToBackBuffer(GraphicsContext& gfxContext)
+{
 	// reset viewport and scissor
 	gfxContext.SetViewportAndScissor(m_Viewport, m_Scissor);
 
-	gfxContext.TransitionResource(g_DisplayPlane[g_CurrentBuffer], D3D12_RESOURCE_STATE_RENDER_TARGET, true);
-	gfxContext.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
-
 	// clear dsv
 	gfxContext.ClearDepthAndStencil(g_SceneDepthBuffer);
 	// clear rtv
@@ -158,68 +377,70 @@ void GameApp::RenderScene(void)
 	gfxContext.SetRenderTarget(g_DisplayPlane[g_CurrentBuffer].GetRTV(), g_SceneDepthBuffer.GetDSV());
 
 	gfxContext.SetRootSignature(m_RootSignature);
+	gfxContext.SetShaderResourceView(6, m_ObjectConstants);
 
-	XMStoreFloat4x4(&passConstant.View, XMMatrixTranspose(camera.GetViewMatrix()));
-	XMStoreFloat4x4(&passConstant.Proj, XMMatrixTranspose(camera.GetProjMatrix()));
-	XMStoreFloat4x4(&passConstant.ShadowTransform, XMMatrixTranspose(m_shadowMap->GetShadowTransform()));
+	// passes record concurrently, each one works on its own copy of the pass constants
+	PassConstants passCB = passConstant;
+	XMStoreFloat4x4(&passCB.View, XMMatrixTranspose(camera.GetViewMatrix()));
+	XMStoreFloat4x4(&passCB.Proj, XMMatrixTranspose(camera.GetProjMatrix()));
 
 
-	XMStoreFloat3(&passConstant.eyePosW, camera.GetPosition());
-	gfxContext.SetDynamicConstantBufferView(1, sizeof(passConstant), &passConstant);
+	XMStoreFloat3(&passCB.eyePosW, camera.GetPosition());
+	gfxContext.SetDynamicConstantBufferView(1, sizeof(passCB), &passCB);
 
 	// structured buffer
-	gfxContext.SetBufferSRV(2, matBuffer);
+	gfxContext.SetShaderResourceView(2, m_MaterialConstants);
 
-	// srv tables
+	// srv tables, material textures are read straight from the bindless heap
 	gfxContext.SetDynamicDescriptor(3, 0, g_SceneCubeMapBuffer.GetSRV());
-	gfxContext.SetDynamicDescriptors(4, 0, m_srvs.size(), &m_srvs[0]);
-	gfxContext.SetDynamicDescriptors(5, 0, m_Normalsrvs.size(), &m_Normalsrvs[0]);
+	gfxContext.SetBindlessTable(4);
 
 	// debug Quad
-	gfxContext.SetDynamicDescriptors(6, 0, 1, &m_shadowMap->GetSRV());
-	//gfxContext.SetDynamicDescriptors(6, 0, 1, &m_BlurMap->GetOutput().GetSRV());
+	gfxContext.SetDynamicDescriptors(5, 0, 1, &m_shadowMap->GetSRV());
+	//gfxContext.SetDynamicDescriptors(5, 0, 1, &m_BlurMap->GetOutput().GetSRV());
 
 
 	// draw call
 	//if (m_bRenderShapes)
 	{
-		gfxContext.SetPipelineState(m_PSOs["opaque"]);
-		DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::Opaque]);
+		if (m_bGpuDriven)
+			DrawRenderItemsIndirect(gfxContext, "opaque", 0, m_ReflectorBatch);
+		else
+			DrawRenderItems(gfxContext, "opaque", m_ShapeRenders[(int)RenderLayer::Opaque], true);
 	}
 
+	DrawTerrain(gfxContext, "opaque");
+
 
 	
 	// dynamic cube mapping
-	gfxContext.SetPipelineState(m_PSOs["opaque"]);
 	gfxContext.SetDynamicDescriptor(3, 0, g_SceneCubeMapBuffer.GetSRV());
-	DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::OpaqueDynamicReflectors]);
+	if (m_bGpuDriven)
+		DrawRenderItemsIndirect(gfxContext, "opaque", m_ReflectorBatch, (UINT)m_IndirectBatches.size());
+	else
+		DrawRenderItems(gfxContext, "opaque", m_ShapeRenders[(int)RenderLayer::OpaqueDynamicReflectors], true);
 
 	// debug shadow map
-	gfxContext.SetPipelineState(m_PSOs["debug"]);
-	gfxContext.SetDynamicDescriptors(6, 0, 1, &m_SSAO->GetSSAOSRV());
-	DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::Quad]);
+	gfxContext.SetDynamicDescriptors(5, 0, 1, &m_SSAO->GetSSAOSRV());
+	DrawRenderItems(gfxContext, "debug", m_ShapeRenders[(int)RenderLayer::Quad]);
 
 	// draw sky box at last
-	gfxContext.SetPipelineState(m_PSOs["sky"]);
 	gfxContext.SetDynamicDescriptor(3, 0, m_cubeMap[0].GetSRV());
-	DrawRenderItems(gfxContext, m_SkyboxRenders[(int)RenderLayer::Skybox]);
-
-	gfxContext.TransitionResource(g_DisplayPlane[g_CurrentBuffer], D3D12_RESOURCE_STATE_PRESENT);
-
-	gfxContext.Finish();
+	DrawRenderItems(gfxContext, "sky", m_SkyboxRenders[(int)RenderLayer::Skybox]);
 }
 
 void GameApp::SetPsoAndRootSig()
 {
 	// initialize root signature
 	m_RootSignature.Reset(7, 1);
-	m_RootSignature[0].InitAsConstantBuffer(0, D3D12_SHADER_VISIBILITY_ALL);
+	m_RootSignature[0].InitAsConstants(0, 1, D3D12_SHADER_VISIBILITY_ALL);
 	m_RootSignature[1].InitAsConstantBuffer(1, D3D12_SHADER_VISIBILITY_ALL);
 	m_RootSignature[2].InitAsBufferSRV(0, D3D12_SHADER_VISIBILITY_ALL, 1);
 	m_RootSignature[3].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1);
-	m_RootSignature[4].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, m_srvs.size());
-	m_RootSignature[5].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, m_Normalsrvs.size(), D3D12_SHADER_VISIBILITY_ALL, 1);
-	m_RootSignature[6].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1, D3D12_SHADER_VISIBILITY_ALL, 2);
+	// unbounded: the whole bindless heap, indexed by the slots in MaterialConstants
+	m_RootSignature[4].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, UINT_MAX, D3D12_SHADER_VISIBILITY_ALL, 3);
+	m_RootSignature[5].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1, D3D12_SHADER_VISIBILITY_ALL, 2);
+	m_RootSignature[6].InitAsBufferSRV(0, D3D12_SHADER_VISIBILITY_ALL, 2);
 	// sampler
 	m_RootSignature.InitStaticSampler(0, Graphics::SamplerLinearWrapDesc, D3D12_SHADER_VISIBILITY_PIXEL);
 
@@ -234,6 +455,15 @@ void GameApp::SetPsoAndRootSig()
 		{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
 	};
 
+	// Utility::CompactVertex, the "_compact" pipelines decode it with DecodeVertex in common.hlsli
+	D3D12_INPUT_ELEMENT_DESC mCompactInputLayout[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+	};
+
 	DXGI_FORMAT ColorFormat = g_DisplayPlane[g_CurrentBuffer].GetFormat();
 	DXGI_FORMAT DepthFormat = g_SceneDepthBuffer.GetFormat();
 
@@ -347,153 +577,484 @@ void GameApp::SetPsoAndRootSig()
 	normalPSO.Finalize();
 	m_PSOs["normal"] = normalPSO;
 
+	// the same pipelines for geometry built with m_bCompactVertices
+	ComPtr<ID3DBlob> vertexCompactVS;
+	ComPtr<ID3DBlob> shadowMapCompactVS;
+	ComPtr<ID3DBlob> shadowDebugCompactVS;
+	D3DReadFileToBlob(L"shader/VertexShaderCompact.cso", &vertexCompactVS);
+	D3DReadFileToBlob(L"shader/shadowMapVSCompact.cso", &shadowMapCompactVS);
+	D3DReadFileToBlob(L"shader/shadowDebugVSCompact.cso", &shadowDebugCompactVS);
+
+	auto addCompact = [&](const char* name, ComPtr<ID3DBlob>& vs)
+	{
+		GraphicsPSO compactPSO = m_PSOs.at(name);
+		compactPSO.SetInputLayout(_countof(mCompactInputLayout), mCompactInputLayout);
+		compactPSO.SetVertexShader(vs);
+		compactPSO.Finalize();
+		m_PSOs[std::string(name) + "_compact"] = compactPSO;
+	};
+	addCompact("opaque", vertexCompactVS);
+	addCompact("normal", vertexCompactVS);
+	addCompact("shadow", shadowMapCompactVS);
+	addCompact("debug", shadowDebugCompactVS);
+
+	// GPU cull: planes, instances and batches in space4, the object constants where the
+	// graphics root signature has them, the commands and counts it writes
+	m_CullRootSignature.Reset(6, 0);
+	m_CullRootSignature[0].InitAsConstantBuffer(0, D3D12_SHADER_VISIBILITY_ALL, 4);
+	m_CullRootSignature[1].InitAsBufferSRV(0, D3D12_SHADER_VISIBILITY_ALL, 4);
+	m_CullRootSignature[2].InitAsBufferSRV(1, D3D12_SHADER_VISIBILITY_ALL, 4);
+	m_CullRootSignature[3].InitAsBufferSRV(0, D3D12_SHADER_VISIBILITY_ALL, 2);
+	m_CullRootSignature[4].InitAsBufferUAV(0, D3D12_SHADER_VISIBILITY_ALL, 4);
+	m_CullRootSignature[5].InitAsBufferUAV(1, D3D12_SHADER_VISIBILITY_ALL, 4);
+	m_CullRootSignature.Finalize(L"cull root signature");
+
+	ComPtr<ID3DBlob> cullCS;
+	D3DReadFileToBlob(L"shader/CSCullInstances.cso", &cullCS);
+	m_CullPSO.SetRootSignature(m_CullRootSignature);
+	m_CullPSO.SetComputeShader(cullCS);
+	m_CullPSO.Finalize();
+
+	// Utility::IndirectDrawCommand: the object index into root constant 0, then the draw
+	m_DrawSignature.Reset(2);
+	m_DrawSignature[0].Constant(0, 0, 1);
+	m_DrawSignature[1].DrawIndexed();
+	m_DrawSignature.Finalize(&m_RootSignature);
+
 
 
 }
 
-void GameApp::DrawRenderItems(GraphicsContext& gfxContext, std::vector<RenderItem*>& items)
+void GameApp::DrawRenderItems(GraphicsContext& gfxContext, const std::string& pso, std::vector<RenderItem*>& items, bool clusterCulled)
 {
-	ObjConstants objConstants;
+	// items of compact geometry draw with the twin decoding it; items are grouped by geometry
+	// and the context drops repeated pipeline changes
+	const GraphicsPSO& fullPSO = m_PSOs.at(pso);
+	auto compact = m_PSOs.find(pso + "_compact");
+	const GraphicsPSO& compactPSO = compact != m_PSOs.end() ? compact->second : fullPSO;
+
+	// object constants were uploaded by UploadObjectConstants, only the index changes per draw
 	for (auto& iter : items)
 	{
+		// only what the main camera sees was kept, passes from other views draw everything
+		bool culled = clusterCulled && iter->ClusterCulled;
+		if (culled && iter->CulledIndexCount == 0)
+			continue;
+
+		gfxContext.SetPipelineState(iter->Geo->CompactVertices ? compactPSO : fullPSO);
 		gfxContext.SetPrimitiveTopology(iter->PrimitiveType);
-		gfxContext.SetVertexBuffer(0, iter->Geo->m_VertexBuffer.VertexBufferView());
-		gfxContext.SetIndexBuffer(iter->Geo->m_IndexBuffer.IndexBufferView());
+		gfxContext.SetVertexBuffer(0, iter->Geo->VertexBufferView());
+		gfxContext.SetIndexBuffer(culled ? iter->CulledIndexBuffer : iter->Geo->m_IndexBuffer.IndexBufferView());
+
+		gfxContext.SetConstants(0, iter->ObjectIndex);
 
-		XMStoreFloat4x4(&objConstants.World, XMMatrixTranspose(iter->World)); // hlsl 列主序矩阵
-		XMStoreFloat4x4(&objConstants.TexTransform, XMMatrixTranspose(iter->TexTransform)); // hlsl 列主序矩阵
-		XMStoreFloat4x4(&objConstants.MatTransform, XMMatrixTranspose(iter->MatTransform)); // hlsl 列主序矩阵
-		objConstants.MaterialIndex = iter->ObjCBIndex;
+		if (culled)
+			gfxContext.DrawIndexedInstanced(iter->CulledIndexCount, 1, 0, iter->BaseVertexLocation, 0);
+		else
+			gfxContext.DrawIndexedInstanced(iter->IndexCount, 1, iter->StartIndexLocation, iter->BaseVertexLocation, 0);
+	}
+}
 
-		gfxContext.SetDynamicConstantBufferView(0, sizeof(objConstants), &objConstants);
+void GameApp::DrawFullQuad(GraphicsContext& gfxContext, std::vector<RenderItem*>& items)
+{
+	// screen space passes have their own root signature and take no object constants
+	for (auto& iter : items)
+	{
+		gfxContext.SetPrimitiveTopology(iter->PrimitiveType);
+		gfxContext.SetVertexBuffer(0, iter->Geo->VertexBufferView());
+		gfxContext.SetIndexBuffer(iter->Geo->m_IndexBuffer.IndexBufferView());
 
 		gfxContext.DrawIndexedInstanced(iter->IndexCount, 1, iter->StartIndexLocation, iter->BaseVertexLocation, 0);
 	}
 }
 
-void GameApp::DrawSceneToCubeMap(GraphicsContext& gfxContext)
+void GameApp::UploadObjectConstants()
 {
-	auto width = Graphics::g_SceneCubeMapBuffer.GetWidth();
-	auto height = Graphics::g_SceneCubeMapBuffer.GetHeight();
-	D3D12_VIEWPORT mViewport = { 0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f };
-	D3D12_RECT mScissorRect = { 0, 0, (LONG)width, (LONG)height };
-	gfxContext.SetViewportAndScissor(mViewport, mScissorRect);
+	static_assert(sizeof(ObjConstants) == sizeof(Utility::PackedObjectConstants), "ObjConstants and the packed layout differ");
 
-	gfxContext.TransitionResource(g_SceneCubeMapBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
-	gfxContext.TransitionResource(g_CubeMapDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
+	const int count = (int)m_AllRenders.size();
+	if (count == 0)
+		return;
 
-	//clear rtv
-	g_SceneCubeMapBuffer.SetClearColor(Color(0.0f, 0.0f, 0.0f, 0.0f));
-	gfxContext.ClearColor(g_SceneCubeMapBuffer);
+	DynAlloc alloc = m_ObjectAllocator.Allocate(count * sizeof(ObjConstants));
+	Utility::PackedObjectConstants* objects = (Utility::PackedObjectConstants*)alloc.DataPtr;
 
-	gfxContext.SetRootSignature(m_RootSignature);
+	// upload heap is write-combined: PackObjectConstants writes every field of each element in order
+	ThreadPool::ParallelForRange(0, count, [this, objects](int begin, int end)
+	{
+		const int chunk = 64;
+		Utility::ObjectConstantsSource sources[chunk];
+		for (int first = begin; first < end; first += chunk)
+		{
+			const int last = (std::min)(first + chunk, end);
+			for (int i = first; i < last; ++i)
+			{
+				const RenderItem* item = m_AllRenders[i].get();
+				Utility::ObjectConstantsSource& source = sources[i - first];
+				source.World = (const float*)&item->World;
+				source.TexTransform = (const float*)&item->TexTransform;
+				source.MatTransform = (const float*)&item->MatTransform;
+				source.PositionScale = &item->Geo->PositionScale.x;
+				source.PositionBias = &item->Geo->PositionBias.x;
+				source.MaterialIndex = item->ObjCBIndex;
+				source.Slot = item->ObjectIndex;
+			}
+			Utility::PackObjectConstants(objects, sources, last - first);
+		}
+	}, 1024);
 
-	// structured buffer
-	gfxContext.SetBufferSRV(2, matBuffer);
+	m_ObjectConstants = alloc.GpuAddress;
+}
 
-	// srv tables
-	gfxContext.SetDynamicDescriptor(3, 0, m_cubeMap[0].GetSRV());
-	gfxContext.SetDynamicDescriptors(4, 0, m_srvs.size(), &m_srvs[0]);
-	gfxContext.SetDynamicDescriptors(5, 0, m_Normalsrvs.size(), &m_Normalsrvs[0]);
+void GameApp::AssignSortIds()
+{
+	UINT id = 0;
+	for (auto& iter : m_Geometry)
+		iter.second->SortId = id++;
 
-	for (int i = 0; i < 6; ++i)
+	id = 0;
+	for (auto& iter : m_Materials)
+		iter.second->SortId = id++;
+}
+
+void GameApp::SelectLods()
+{
+	// a level is good enough while its error covers less than a pixel on screen. Going coarser
+	// takes a clear margin under that, so an item sitting at a switch distance keeps its level
+	const float maxPixelError = 1.0f;
+	const float coarserPixelError = 0.75f;
+
+	// pixels covered by one unit of length one unit in front of the camera
+	const float pixelsPerUnit = g_DisplayHeight / (2.0f * tanf(camera.GetFOV() * 0.5f));
+	XMVECTOR eye = camera.GetPosition();
+
+	for (auto& item : m_AllRenders)
 	{
-		// clear dsv
-		gfxContext.ClearDepthAndStencil(g_CubeMapDepthBuffer);
-		// set render target
-		gfxContext.SetRenderTarget(g_SceneCubeMapBuffer.GetRTV(i), g_CubeMapDepthBuffer.GetDSV());
-
-		// update passCB
-		XMStoreFloat4x4(&passConstant.View, XMMatrixTranspose(cubeCamera[i].GetViewMatrix()));
-		XMStoreFloat4x4(&passConstant.Proj, XMMatrixTranspose(cubeCamera[i].GetProjMatrix()));
-		XMStoreFloat3(&passConstant.eyePosW, cubeCamera[i].GetPosition());
-		gfxContext.SetDynamicConstantBufferView(1, sizeof(passConstant), &passConstant);
-
-		// draw call
-		gfxContext.SetPipelineState(m_PSOs["opaque"]);
-		DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::Opaque]);
-		// draw sky box at last
-		gfxContext.SetPipelineState(m_PSOs["sky"]);
-		DrawRenderItems(gfxContext, m_SkyboxRenders[(int)RenderLayer::Skybox]);
+		if (item->Lods.size() < 2)
+			continue;
+
+		// errors are in object space, the largest axis scale takes them to world space
+		float scale = (std::max)({ XMVectorGetX(XMVector3Length(item->World.r[0])),
+			XMVectorGetX(XMVector3Length(item->World.r[1])),
+			XMVectorGetX(XMVector3Length(item->World.r[2])) });
+		float distance = (std::max)(XMVectorGetX(XMVector3Length(item->World.r[3] - eye)), camera.GetNearClip());
+		float pixelsPerError = scale * pixelsPerUnit / distance;
+
+		UINT lod = (std::min)(item->Lod, (UINT)item->Lods.size() - 1);
+		while (lod > 0 && item->Lods[lod]->LodError * pixelsPerError > maxPixelError)
+			--lod;
+		while (lod + 1 < item->Lods.size() && item->Lods[lod + 1]->LodError * pixelsPerError <= coarserPixelError)
+			++lod;
+
+		const SubmeshGeometry* submesh = item->Lods[lod];
+		item->Lod = lod;
+		item->Meshlets = submesh->Meshlets.get();
+		item->IndexCount = submesh->IndexCount;
+		item->StartIndexLocation = submesh->StartIndexLocation;
+		item->BaseVertexLocation = submesh->BaseVertexLocation;
+	}
+}
+
+void GameApp::AttachMeshlets()
+{
+	// items copy their draw arguments out of DrawArgs, find the submesh they came from
+	for (auto& item : m_AllRenders)
+	{
+		for (auto& iter : item->Geo->DrawArgs)
+		{
+			const SubmeshGeometry& submesh = iter.second;
+			if (submesh.IndexCount == item->IndexCount && submesh.StartIndexLocation == item->StartIndexLocation &&
+				submesh.BaseVertexLocation == (INT)item->BaseVertexLocation)
+			{
+				item->Meshlets = submesh.Meshlets.get();
+				break;
+			}
+		}
+
+		// the GPU cull tests one sphere whatever level SelectLods picks, so it takes in the
+		// cluster spheres of all of them: centered on their box, reaching the farthest one
+		std::vector<const Utility::MeshletMesh*> meshes;
+		if (item->Meshlets != nullptr)
+			meshes.push_back(item->Meshlets);
+		for (const SubmeshGeometry* lod : item->Lods)
+		{
+			if (lod->Meshlets != nullptr)
+				meshes.push_back(lod->Meshlets.get());
+		}
+		if (meshes.empty() || meshes[0]->Bounds.empty())
+			continue;
+
+		XMVECTOR boxMin = XMVectorReplicate(FLT_MAX);
+		XMVECTOR boxMax = XMVectorReplicate(-FLT_MAX);
+		for (const Utility::MeshletMesh* mesh : meshes)
+		{
+			for (const Utility::MeshletBounds& bounds : mesh->Bounds)
+			{
+				XMVECTOR center = XMLoadFloat3((const XMFLOAT3*)bounds.Center);
+				XMVECTOR radius = XMVectorReplicate(bounds.Radius);
+				boxMin = XMVectorMin(boxMin, center - radius);
+				boxMax = XMVectorMax(boxMax, center + radius);
+			}
+		}
 
+		XMVECTOR sphereCenter = (boxMin + boxMax) * 0.5f;
+		float sphereRadius = 0.0f;
+		for (const Utility::MeshletMesh* mesh : meshes)
+		{
+			for (const Utility::MeshletBounds& bounds : mesh->Bounds)
+			{
+				float reach = XMVectorGetX(XMVector3Length(XMLoadFloat3((const XMFLOAT3*)bounds.Center) - sphereCenter)) + bounds.Radius;
+				sphereRadius = (std::max)(sphereRadius, reach);
+			}
+		}
+
+		XMStoreFloat4(&item->BoundingSphere, XMVectorSetW(sphereCenter, sphereRadius));
 	}
+}
 
-	gfxContext.TransitionResource(g_SceneCubeMapBuffer, D3D12_RESOURCE_STATE_GENERIC_READ, true);
+void GameApp::CullClusters()
+{
+	m_ClusterStats = {};
+
+	XMMATRIX viewProj = XMMatrixMultiply(camera.GetViewMatrix(), camera.GetProjMatrix());
+	XMVECTOR eye = camera.GetPosition();
+
+	for (RenderLayer layer : { RenderLayer::Opaque, RenderLayer::OpaqueDynamicReflectors })
+	{
+		for (RenderItem* item : m_ShapeRenders[(int)layer])
+		{
+			item->ClusterCulled = false;
+			if (item->Meshlets == nullptr)
+				continue;
+
+			// frustum planes and eye in object space, where the cluster bounds are
+			XMFLOAT4X4 objectViewProj;
+			XMStoreFloat4x4(&objectViewProj, XMMatrixMultiply(item->World, viewProj));
+			float planes[6][4];
+			Utility::ExtractFrustumPlanes(&objectViewProj.m[0][0], planes);
+
+			XMFLOAT3 eyeObject;
+			XMStoreFloat3(&eyeObject, XMVector3Transform(eye, XMMatrixInverse(nullptr, item->World)));
+
+			// uneven scale bends the normal cones, those items only get the frustum test
+			float scaleX = XMVectorGetX(XMVector3Length(item->World.r[0]));
+			float scaleY = XMVectorGetX(XMVector3Length(item->World.r[1]));
+			float scaleZ = XMVectorGetX(XMVector3Length(item->World.r[2]));
+			bool uniformScale = (std::max)({ scaleX, scaleY, scaleZ }) <= 1.001f * (std::min)({ scaleX, scaleY, scaleZ });
+
+			m_CulledIndices.resize(item->Meshlets->Triangles.size());
+			size_t count = Utility::CullMeshlets(*item->Meshlets, planes, uniformScale ? &eyeObject.x : nullptr,
+				m_CulledIndices.data(), m_ClusterStats);
+
+			item->ClusterCulled = true;
+			item->CulledIndexCount = (UINT)count;
+			if (count == 0)
+				continue;
+
+			DynAlloc alloc = m_ObjectAllocator.Allocate(count * sizeof(uint32_t));
+			memcpy(alloc.DataPtr, m_CulledIndices.data(), count * sizeof(uint32_t));
+			item->CulledIndexBuffer.BufferLocation = alloc.GpuAddress;
+			item->CulledIndexBuffer.SizeInBytes = (UINT)(count * sizeof(uint32_t));
+			item->CulledIndexBuffer.Format = DXGI_FORMAT_R32_UINT;
+		}
+	}
 }
 
-void GameApp::DrawSceneToShadowMap(GraphicsContext& gfxContext)
+void GameApp::BuildIndirectInstances()
 {
-	// 
-	gfxContext.SetViewportAndScissor(m_shadowMap->Viewport(), m_shadowMap->ScissorRect());
+	m_IndirectInstances.clear();
+	m_IndirectBatches.clear();
+	m_IndirectBatchItems.clear();
 
-	// transition buffer to depth write
-	gfxContext.TransitionResource(m_shadowMap->GetShadowBuffer(), D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
+	// the GPU tests world space spheres, the planes stay world space
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(camera.GetViewMatrix(), camera.GetProjMatrix()));
+	Utility::ExtractFrustumPlanes(&viewProj.m[0][0], m_CullPlanes);
 
-	gfxContext.ClearDepth(m_shadowMap->GetShadowBuffer());
+	// the items are sorted by geometry, so every run sharing it becomes one batch
+	for (RenderLayer layer : { RenderLayer::Opaque, RenderLayer::OpaqueDynamicReflectors })
+	{
+		if (layer == RenderLayer::OpaqueDynamicReflectors)
+			m_ReflectorBatch = (UINT)m_IndirectBatches.size();
+		const RenderItem* batchItem = nullptr;
 
-	gfxContext.SetRenderTargets(0, nullptr, m_shadowMap->GetDSV());
+		for (RenderItem* item : m_ShapeRenders[(int)layer])
+		{
+			if (item->IndexCount == 0)
+				continue;
+
+			if (batchItem == nullptr || item->Geo != batchItem->Geo || item->PrimitiveType != batchItem->PrimitiveType)
+			{
+				Utility::IndirectBatch batch = {};
+				batch.FirstInstance = (uint32_t)m_IndirectInstances.size();
+				m_IndirectBatches.push_back(batch);
+				m_IndirectBatchItems.push_back(item);
+				batchItem = item;
+			}
+
+			Utility::IndirectInstance instance;
+			memcpy(instance.Center, &item->BoundingSphere.x, sizeof(instance.Center));
+			instance.Radius = item->BoundingSphere.w;
+			instance.ObjectIndex = item->ObjectIndex;
+			instance.IndexCount = item->IndexCount;
+			instance.StartIndexLocation = item->StartIndexLocation;
+			instance.BaseVertexLocation = (int32_t)item->BaseVertexLocation;
+			m_IndirectInstances.push_back(instance);
+			++m_IndirectBatches.back().InstanceCount;
+		}
+	}
+}
 
-	gfxContext.SetRootSignature(m_RootSignature);
+void GameApp::CullInstancesOnGpu(GraphicsContext& gfxContext)
+{
+	ComputeContext& context = gfxContext.GetComputeContext();
 
-	XMStoreFloat4x4(&passConstant.View, XMMatrixTranspose(m_shadowMap->GetLightView()));
-	XMStoreFloat4x4(&passConstant.Proj, XMMatrixTranspose(m_shadowMap->GetLightProj()));
-	gfxContext.SetDynamicConstantBufferView(1, sizeof(passConstant), &passConstant);
+	context.SetRootSignature(m_CullRootSignature);
+	context.SetPipelineState(m_CullPSO);
 
-	// structured buffer
-	gfxContext.SetBufferSRV(2, matBuffer);
+	context.SetDynamicConstantBufferView(0, sizeof(m_CullPlanes), m_CullPlanes);
+	context.SetDynamicSRV(1, m_IndirectInstances.size() * sizeof(Utility::IndirectInstance), m_IndirectInstances.data());
+	context.SetDynamicSRV(2, m_IndirectBatches.size() * sizeof(Utility::IndirectBatch), m_IndirectBatches.data());
+	context.SetShaderResourceView(3, m_ObjectConstants);
+	context.SetBufferUAV(4, m_DrawCommands);
+	context.SetBufferUAV(5, m_DrawCounts);
 
-	// srv tables
-	gfxContext.SetDynamicDescriptors(4, 0, m_srvs.size(), &m_srvs[0]);
+	// one group per batch
+	context.Dispatch(m_IndirectBatches.size());
+}
 
-	gfxContext.SetPipelineState(m_PSOs["shadow"]);
+void GameApp::DrawRenderItemsIndirect(GraphicsContext& gfxContext, const std::string& pso, UINT firstBatch, UINT endBatch)
+{
+	const GraphicsPSO& fullPSO = m_PSOs.at(pso);
+	auto compact = m_PSOs.find(pso + "_compact");
+	const GraphicsPSO& compactPSO = compact != m_PSOs.end() ? compact->second : fullPSO;
 
-	// draw call
+	// the state is set once per batch, the count buffer says how many of its commands survived
+	for (UINT b = firstBatch; b < endBatch; ++b)
 	{
-		DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::Shadow]);
+		const RenderItem* item = m_IndirectBatchItems[b];
+		const Utility::IndirectBatch& batch = m_IndirectBatches[b];
+
+		gfxContext.SetPipelineState(item->Geo->CompactVertices ? compactPSO : fullPSO);
+		gfxContext.SetPrimitiveTopology(item->PrimitiveType);
+		gfxContext.SetVertexBuffer(0, item->Geo->VertexBufferView());
+		gfxContext.SetIndexBuffer(item->Geo->m_IndexBuffer.IndexBufferView());
+
+		gfxContext.ExecuteIndirect(m_DrawSignature, m_DrawCommands, batch.FirstInstance * sizeof(Utility::IndirectDrawCommand),
+			batch.InstanceCount, &m_DrawCounts, b * sizeof(uint32_t));
 	}
-	
-	gfxContext.TransitionResource(m_shadowMap->GetShadowBuffer(), D3D12_RESOURCE_STATE_GENERIC_READ, true);
 }
 
-void GameApp::DrawSceneToDepth2Map(GraphicsContext& gfxContext)
+void GameApp::SortRenderItems(std::vector<RenderItem*>& items, RenderLayer layer, FXMMATRIX view)
 {
-	// 
-	auto width = g_Depth2Buffer.GetWidth();
-	auto height = g_Depth2Buffer.GetHeight();
+	if (items.size() < 2)
+		return;
+
+	m_SortEntries.resize(items.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		RenderItem* item = items[i];
+
+		// view space depth of the item origin; for positive floats the bit pattern sorts like
+		// the value, the top 24 bits are plenty to order items
+		float depth = std::max(XMVectorGetZ(XMVector3Transform(item->World.r[3], view)), 0.0f);
+		uint32_t depthBits;
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+		uint64_t depthKey = depthBits >> 8;
+
+		uint64_t pipelineKey = (uint64_t)layer & 0xFF;
+		uint64_t geoKey = item->Geo->SortId & 0xFFFF;
+		uint64_t matKey = item->Mat->SortId & 0xFFFF;
+
+		// blending needs back to front, everything else is grouped by state and then drawn front to back
+		if (layer == RenderLayer::Transparent)
+			item->SortKey = pipelineKey << 56 | (~depthKey & 0xFFFFFF) << 32 | geoKey << 16 | matKey;
+		else
+			item->SortKey = pipelineKey << 56 | geoKey << 40 | matKey << 24 | depthKey;
+
+		m_SortEntries[i].Key = item->SortKey;
+		m_SortEntries[i].Index = (uint32_t)i;
+	}
+
+	Utility::RadixSort(m_SortEntries, m_SortScratch);
+
+	m_SortedItems.resize(items.size());
+	for (size_t i = 0; i < items.size(); ++i)
+		m_SortedItems[i] = items[m_SortEntries[i].Index];
+	items.swap(m_SortedItems);
+}
+
+void GameApp::DrawSceneToCubeMap(GraphicsContext& gfxContext, int face)
+{
+	auto width = Graphics::g_SceneCubeMapBuffer.GetWidth();
+	auto height = Graphics::g_SceneCubeMapBuffer.GetHeight();
 	D3D12_VIEWPORT mViewport = { 0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f };
 	D3D12_RECT mScissorRect = { 0, 0, (LONG)width, (LONG)height };
 	gfxContext.SetViewportAndScissor(mViewport, mScissorRect);
 
-	// transition buffer to depth write
-	gfxContext.TransitionResource(g_Depth2Buffer, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
-	gfxContext.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
+	// the faces are submitted in order, the first one clears all of them
+	if (face == 0)
+	{
+		//clear rtv
+		g_SceneCubeMapBuffer.SetClearColor(Color(0.0f, 0.0f, 0.0f, 0.0f));
+		gfxContext.ClearColor(g_SceneCubeMapBuffer);
+	}
 
-	g_Depth2Buffer.SetClearColor(Color{ 1.0f, 1.0f, 1.0f, 1.0f });
-	gfxContext.ClearColor(g_Depth2Buffer);
-	gfxContext.ClearDepth(g_SceneDepthBuffer);
+	gfxContext.SetRootSignature(m_RootSignature);
+	gfxContext.SetShaderResourceView(6, m_ObjectConstants);
+
+	// structured buffer
+	gfxContext.SetShaderResourceView(2, m_MaterialConstants);
+
+	// srv tables
+	gfxContext.SetDynamicDescriptor(3, 0, m_cubeMap[0].GetSRV());
+	gfxContext.SetBindlessTable(4);
+
+	// clear dsv
+	gfxContext.ClearDepthAndStencil(g_CubeMapDepthBuffer);
+	// set render target
+	gfxContext.SetRenderTarget(g_SceneCubeMapBuffer.GetRTV(face), g_CubeMapDepthBuffer.GetDSV());
+
+	// update passCB
+	PassConstants passCB = passConstant;
+	XMStoreFloat4x4(&passCB.View, XMMatrixTranspose(cubeCamera[face].GetViewMatrix()));
+	XMStoreFloat4x4(&passCB.Proj, XMMatrixTranspose(cubeCamera[face].GetProjMatrix()));
+	XMStoreFloat3(&passCB.eyePosW, cubeCamera[face].GetPosition());
+	gfxContext.SetDynamicConstantBufferView(1, sizeof(passCB), &passCB);
+
+	// draw call
+	DrawRenderItems(gfxContext, "opaque", m_ShapeRenders[(int)RenderLayer::Opaque]);
+	// draw sky box at last
+	DrawRenderItems(gfxContext, "sky", m_SkyboxRenders[(int)RenderLayer::Skybox]);
+}
+
+void GameApp::DrawSceneToShadowMap(GraphicsContext& gfxContext)
+{
+	// 
+	gfxContext.SetViewportAndScissor(m_shadowMap->Viewport(), m_shadowMap->ScissorRect());
+
+	gfxContext.ClearDepth(m_shadowMap->GetShadowBuffer());
 
-	gfxContext.SetRenderTarget(g_Depth2Buffer.GetRTV(), g_SceneDepthBuffer.GetDSV());
+	gfxContext.SetRenderTargets(0, nullptr, m_shadowMap->GetDSV());
 
 	gfxContext.SetRootSignature(m_RootSignature);
+	gfxContext.SetShaderResourceView(6, m_ObjectConstants);
 
-	XMStoreFloat4x4(&passConstant.View, XMMatrixTranspose(m_shadowMap->GetLightView()));
-	XMStoreFloat4x4(&passConstant.Proj, XMMatrixTranspose(m_shadowMap->GetLightProj()));
-	gfxContext.SetDynamicConstantBufferView(1, sizeof(passConstant), &passConstant);
+	PassConstants passCB = passConstant;
+	XMStoreFloat4x4(&passCB.View, XMMatrixTranspose(m_shadowMap->GetLightView()));
+	XMStoreFloat4x4(&passCB.Proj, XMMatrixTranspose(m_shadowMap->GetLightProj()));
+	gfxContext.SetDynamicConstantBufferView(1, sizeof(passCB), &passCB);
 
 	// structured buffer
-	gfxContext.SetBufferSRV(2, matBuffer);
-
-	// set shadowmap
-	gfxContext.SetDynamicDescriptors(6, 0, 1, &m_shadowMap->GetSRV());
+	gfxContext.SetShaderResourceView(2, m_MaterialConstants);
 
-	gfxContext.SetPipelineState(m_PSOs["shadow2"]);
+	// srv tables
+	gfxContext.SetBindlessTable(4);
 
 	// draw call
 	{
-		DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::FullQuad]);
+		DrawRenderItems(gfxContext, "shadow", m_ShapeRenders[(int)RenderLayer::Shadow]);
 	}
-
-	gfxContext.TransitionResource(g_Depth2Buffer, D3D12_RESOURCE_STATE_GENERIC_READ, true);
 }
 
 void GameApp::DrawSceneToNormal(GraphicsContext& gfxContext)
@@ -501,10 +1062,6 @@ void GameApp::DrawSceneToNormal(GraphicsContext& gfxContext)
 
 	gfxContext.SetViewportAndScissor(m_Viewport, m_Scissor);
 
-	gfxContext.TransitionResource(m_SSAO->GetNormalMap(), D3D12_RESOURCE_STATE_RENDER_TARGET, true);
-	gfxContext.TransitionResource(m_SSAO->GetPosMAP(), D3D12_RESOURCE_STATE_RENDER_TARGET, true);
-	gfxContext.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
-
 	// clear RTV color
 	gfxContext.ClearColor(m_SSAO->GetNormalMap());
 	gfxContext.ClearColor(m_SSAO->GetPosMAP());
@@ -517,44 +1074,42 @@ void GameApp::DrawSceneToNormal(GraphicsContext& gfxContext)
 	gfxContext.SetRenderTargets(2, rtvHandle, g_SceneDepthBuffer.GetDSV());
 
 	gfxContext.SetRootSignature(m_RootSignature);
+	gfxContext.SetShaderResourceView(6, m_ObjectConstants);
 
-	XMStoreFloat3(&passConstant.eyePosW, camera.GetPosition());
-	XMStoreFloat4x4(&passConstant.View, XMMatrixTranspose(camera.GetViewMatrix()));
-	XMStoreFloat4x4(&passConstant.Proj, XMMatrixTranspose(camera.GetProjMatrix()));
+	PassConstants passCB = passConstant;
+	XMStoreFloat3(&passCB.eyePosW, camera.GetPosition());
+	XMStoreFloat4x4(&passCB.View, XMMatrixTranspose(camera.GetViewMatrix()));
+	XMStoreFloat4x4(&passCB.Proj, XMMatrixTranspose(camera.GetProjMatrix()));
 
-	gfxContext.SetDynamicConstantBufferView(1, sizeof(passConstant), &passConstant);
+	gfxContext.SetDynamicConstantBufferView(1, sizeof(passCB), &passCB);
 
 	// structured buffer
-	gfxContext.SetBufferSRV(2, matBuffer);
+	gfxContext.SetShaderResourceView(2, m_MaterialConstants);
 
 	// srv tables
-	gfxContext.SetDynamicDescriptors(4, 0, m_srvs.size(), &m_srvs[0]);
-	gfxContext.SetDynamicDescriptors(5, 0, m_Normalsrvs.size(), &m_Normalsrvs[0]);
+	gfxContext.SetBindlessTable(4);
 
 	{
-		gfxContext.SetPipelineState(m_PSOs["normal"]);
-
-		DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::Opaque]);
+		if (m_bGpuDriven)
+			DrawRenderItemsIndirect(gfxContext, "normal", 0, m_ReflectorBatch);
+		else
+			DrawRenderItems(gfxContext, "normal", m_ShapeRenders[(int)RenderLayer::Opaque], true);
 	}
 
+	DrawTerrain(gfxContext, "normal");
+
 	// dynamic cube mapping
 	gfxContext.SetDynamicDescriptor(3, 0, g_SceneCubeMapBuffer.GetSRV());
-	DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::OpaqueDynamicReflectors]);
-
-	gfxContext.TransitionResource(m_SSAO->GetNormalMap(), D3D12_RESOURCE_STATE_PRESENT, true);
-	gfxContext.TransitionResource(m_SSAO->GetPosMAP(), D3D12_RESOURCE_STATE_PRESENT, true);
-
+	if (m_bGpuDriven)
+		DrawRenderItemsIndirect(gfxContext, "normal", m_ReflectorBatch, (UINT)m_IndirectBatches.size());
+	else
+		DrawRenderItems(gfxContext, "normal", m_ShapeRenders[(int)RenderLayer::OpaqueDynamicReflectors], true);
 }
 
 void GameApp::ComputeSSAO(GraphicsContext& gfxContext)
 {
 	gfxContext.SetViewportAndScissor(m_SSAO->Viewport(), m_SSAO->ScissorRect());
 
-	gfxContext.TransitionResource(m_SSAO->GetSSAOMAP(), D3D12_RESOURCE_STATE_RENDER_TARGET, true);
-
-	gfxContext.TransitionResource(m_SSAO->GetNormalMap(), D3D12_RESOURCE_STATE_GENERIC_READ, true);
-	gfxContext.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_GENERIC_READ, true);
-
 	// clear ssao map
 	gfxContext.ClearColor(m_SSAO->GetSSAOMAP());
 
@@ -600,10 +1155,8 @@ void GameApp::ComputeSSAO(GraphicsContext& gfxContext)
 
 	// draw call
 	{
-		DrawRenderItems(gfxContext, m_ShapeRenders[(int)RenderLayer::FullQuad]);
+		DrawFullQuad(gfxContext, m_ShapeRenders[(int)RenderLayer::FullQuad]);
 	}
-
-	gfxContext.TransitionResource(m_SSAO->GetSSAOMAP(), D3D12_RESOURCE_STATE_GENERIC_READ, true);
 }
 
 void GameApp::BuildCubeFaceCamera(float x, float y, float z)
@@ -681,6 +1234,9 @@ void GameApp::BuildShapeRenderItems()
 	skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
 	skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
 	skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
+	skullRitem->Lods.push_back(&skullRitem->Geo->DrawArgs["skull"]);
+	for (int i = 1; skullRitem->Geo->DrawArgs.count("skull_lod" + std::to_string(i)) != 0; ++i)
+		skullRitem->Lods.push_back(&skullRitem->Geo->DrawArgs["skull_lod" + std::to_string(i)]);
 	m_SkullRitem = skullRitem.get();
 	
 	auto globeRitem = std::make_unique<RenderItem>();
@@ -830,15 +1386,12 @@ void GameApp::BuildLandRenderItems()
 {
 	auto land = std::make_unique<RenderItem>();
 	land->World = XMMatrixIdentity() * XMMatrixScaling(0.5, 0.5, 0.5) * XMMatrixTranslation(0.0f, -15.0f, -30.f);
-	land->TexTransform = XMMatrixScaling(5.0f, 5.0f, 1.0f);
 	land->ObjCBIndex = 0;
 	land->Mat = m_Materials["grass"].get();
 	land->Geo = m_Geometry["landGeo"].get();
 	land->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	land->IndexCount = land->Geo->DrawArgs["land"].IndexCount;
-	land->BaseVertexLocation = land->Geo->DrawArgs["land"].BaseVertexLocation;
-	land->StartIndexLocation = land->Geo->DrawArgs["land"].StartIndexLocation;
-	m_LandRenders[(int)RenderLayer::Opaque].push_back(land.get());
+	// drawn patch by patch by DrawTerrain, the item only holds its constants
+	m_TerrainRitem = land.get();
 
 	auto wave = std::make_unique<RenderItem>();
 	wave->World = XMMatrixIdentity() * XMMatrixScaling(0.6, 0.6, 0.6) * XMMatrixTranslation(0.0f, -15.0f, -30.f);
@@ -871,47 +1424,179 @@ void GameApp::BuildLandRenderItems()
 	m_AllRenders.push_back(std::move(box));
 }
 
-void GameApp::BuildLandGeometry()
+static std::shared_ptr<Utility::MeshletMesh> BuildSubmeshMeshlets(const std::uint32_t* indices, size_t indexCount,
+	const XMFLOAT3* positions, size_t stride, size_t vertexCount)
 {
-	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, 50, 50);
+	auto meshlets = std::make_shared<Utility::MeshletMesh>();
+	Utility::BuildMeshlets(*meshlets, indices, indexCount, &positions->x, stride, vertexCount);
+	return meshlets;
+}
 
-	//
-	// Extract the vertex elements we are interested and apply the height function to
-	// each vertex.  In addition, color the vertices based on their height so we have
-	// sandy looking beaches, grassy low hills, and snow mountain peaks.
-	//
+static std::shared_ptr<Utility::MeshletMesh> BuildSubmeshMeshlets(const GeometryGenerator::MeshData& mesh)
+{
+	return BuildSubmeshMeshlets(mesh.Indices32.data(), mesh.Indices32.size(), &mesh.Vertices[0].Position,
+		sizeof(GeometryGenerator::Vertex), mesh.Vertices.size());
+}
 
-	std::vector<Vertex> vertices(grid.Vertices.size());
-	for (size_t i = 0; i < grid.Vertices.size(); ++i)
+static void ReportMeshOptimization(const char* name, const Utility::MeshOptimizeReport& report)
+{
+	Utility::Printf("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overfetch %.2f -> %.2f\n", name,
+		report.Before.ACMR, report.After.ACMR, report.Before.ATVR, report.After.ATVR,
+		report.Before.Overfetch, report.After.Overfetch);
+}
+
+// Reorders the generated triangles and vertices before they are copied into the vertex buffer.
+// Must run before GetIndices16, which keeps the indices it converted the first time.
+static void OptimizeMeshData(GeometryGenerator::MeshData& mesh, const char* name)
+{
+	ReportMeshOptimization(name, Utility::OptimizeMesh(mesh.Vertices, mesh.Indices32, &GeometryGenerator::Vertex::Position));
+}
+
+// Uploads the vertex buffer of geo, as Utility::CompactVertex quantized to the bounds of the
+// vertices when compact is set, and reports what it takes per vertex
+static void CreateVertexBuffer(MeshGeometry& geo, const std::vector<Vertex>& vertices, bool compact)
+{
+	const UINT count = (UINT)vertices.size();
+	if (!compact)
 	{
-		auto& p = grid.Vertices[i].Position;
-		vertices[i].position = p;
-		vertices[i].position.y = GetHillsHeight(p.x, p.z);
-		vertices[i].normal = GetHillsNormal(p.x, p.z);
-		vertices[i].tex = grid.Vertices[i].TexC;
-		vertices[i].tangent = grid.Vertices[i].TangentU;
+		geo.m_VertexBuffer.Create(L"vertex buff", count, sizeof(Vertex), vertices.data());
+		Utility::Printf("%s: %u vertices, %u bytes\n", geo.name.c_str(), count, count * (UINT)sizeof(Vertex));
+		return;
 	}
 
-	std::vector<std::uint16_t> indices = grid.GetIndices16();
+	const Vertex& first = vertices[0];
+	Utility::PositionQuantization quantization = Utility::ComputePositionQuantization(&first.position.x, sizeof(Vertex), count);
+
+	std::vector<Utility::CompactVertex> compactVertices(count);
+	Utility::QuantizeVertices(compactVertices.data(), count, sizeof(Vertex),
+		&first.position.x, &first.normal.x, &first.tex.x, &first.tangent.x, quantization);
+	geo.m_VertexBuffer.Create(L"vertex buff", count, sizeof(Utility::CompactVertex), compactVertices.data());
+
+	geo.CompactVertices = true;
+	geo.PositionScale = XMFLOAT3(quantization.Scale);
+	geo.PositionBias = XMFLOAT3(quantization.Bias);
+
+	Utility::QuantizationError error = Utility::MeasureQuantizationError(compactVertices.data(), count, sizeof(Vertex),
+		&first.position.x, &first.normal.x, &first.tex.x, &first.tangent.x, quantization);
+	Utility::Printf("%s: %u vertices, %u -> %u bytes; max error position %.5f, normal %.4f deg, tangent %.4f deg, uv %.5f\n",
+		geo.name.c_str(), count, count * (UINT)sizeof(Vertex), count * (UINT)sizeof(Utility::CompactVertex),
+		error.Position, error.Normal, error.Tangent, error.TexC);
+}
+
+void GameApp::BuildLandGeometry()
+{
+	// the hills over 2048 units in the local space of the land, in patches of 32 x 32 quads
+	// down to 1 unit apart, instead of one 160 unit grid of 50 x 50
+	Utility::TerrainDesc desc = {};
+	desc.Origin[0] = -1024.0f;
+	desc.Origin[1] = -1024.0f;
+	desc.Size = 2048.0f;
+	desc.MaxDepth = 6;
+	desc.PatchQuads = 32;
+	desc.SplitFactor = 1.5f;
+	desc.TextureTile = 32.0f; // as the grid with its texture scaled 5 times
+	desc.MaxResidentPatches = 512;
+	desc.MaxPendingPatches = 16;
+	desc.Height = [this](float x, float z) { return GetHillsHeight(x, z); };
+	desc.Normal = [this](float x, float z, float n[3])
+	{
+		XMFLOAT3 normal = GetHillsNormal(x, z);
+		n[0] = normal.x;
+		n[1] = normal.y;
+		n[2] = normal.z;
+	};
+	m_Terrain = std::make_unique<Utility::TerrainStreamer>(desc);
+
+	// patches are written straight into their slots
+	static_assert(sizeof(Vertex) == sizeof(Utility::TerrainVertex), "terrain patches are copied as Vertex");
 
-	const uint32_t vertexBufferSize = sizeof(Vertex);
-	const uint32_t indexBufferSize = sizeof(uint16_t);
+	// every patch indexes from its own slot, 16 bit indices are enough. The vertex pool waits
+	// for PrimeTerrain on the first F4
+	std::vector<uint32_t> stitched;
+	Utility::BuildTerrainIndices(desc.PatchQuads, stitched, m_TerrainRanges);
+	std::vector<std::uint16_t> indices(stitched.begin(), stitched.end());
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->name = "landGeo";
-	geo->m_VertexBuffer.Create(L"vertex buff", (UINT)vertices.size(), vertexBufferSize, vertices.data());
-	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), indexBufferSize, indices.data());
-
-	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
-	submesh.BaseVertexLocation = 0;
-	submesh.StartIndexLocation = 0;
-	geo->DrawArgs["land"] = std::move(submesh);
+	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), sizeof(std::uint16_t), indices.data());
+	Utility::Printf("%s: %u indices for the 16 stitch masks\n", geo->name.c_str(), (UINT)indices.size());
 
 	m_Geometry["landGeo"] = std::move(geo);
 }
 
+void GameApp::PrimeTerrain()
+{
+	// the vertex pool, and the patches around the eye generated and uploaded at once, which
+	// stalls the frame F4 first shows the terrain in
+	const Utility::TerrainDesc& desc = m_Terrain->GetDesc();
+	const UINT patchVertices = Utility::TerrainVerticesPerPatch(desc.PatchQuads);
+	GpuBuffer& pool = m_TerrainRitem->Geo->m_VertexBuffer;
+	pool.Create(L"terrain pool", desc.MaxResidentPatches * patchVertices, sizeof(Vertex));
+	Utility::Printf("%s: %u patch slots, %u KB\n", m_TerrainRitem->Geo->name.c_str(), desc.MaxResidentPatches,
+		(UINT)(pool.GetBufferSize() >> 10));
+
+	std::vector<Vertex> vertices;
+
+	for (bool complete = false; !complete; )
+	{
+		complete = UpdateTerrain();
+		m_Terrain->Flush();
+		m_Terrain->TakeUploads(m_TerrainUploads);
+
+		for (auto& upload : m_TerrainUploads)
+		{
+			size_t first = (size_t)upload.Slot * patchVertices;
+			vertices.resize((std::max)(vertices.size(), first + patchVertices));
+			memcpy(&vertices[first], upload.Vertices.data(), patchVertices * sizeof(Vertex));
+		}
+	}
+	m_TerrainUploads.clear();
+
+	CommandContext::InitializeBuffer(pool, vertices.data(), vertices.size() * sizeof(Vertex));
+	m_bTerrainPrimed = true;
+}
+
+bool GameApp::UpdateTerrain()
+{
+	// patches are selected around the eye in the local space of the land
+	XMFLOAT3 eye;
+	XMStoreFloat3(&eye, XMVector3Transform(camera.GetPosition(), XMMatrixInverse(nullptr, m_TerrainRitem->World)));
+
+	return m_Terrain->Update(&eye.x, [](uint64_t fence) { return g_CommandManager.IsFenceComplete(fence); });
+}
+
+void GameApp::CullTerrain()
+{
+	XMFLOAT4X4 terrainViewProj;
+	XMStoreFloat4x4(&terrainViewProj, m_TerrainRitem->World * camera.GetViewMatrix() * camera.GetProjMatrix());
+	float planes[6][4];
+	Utility::ExtractFrustumPlanes(&terrainViewProj.m[0][0], planes);
+
+	Utility::CullTerrainPatches(m_Terrain->GetPatches(), planes, m_VisibleTerrain);
+}
+
+void GameApp::DrawTerrain(GraphicsContext& gfxContext, const std::string& pso)
+{
+	if (!m_bRenderTerrain)
+		return;
+
+	const MeshGeometry* geo = m_TerrainRitem->Geo;
+	gfxContext.SetPipelineState(m_PSOs.at(pso));
+	gfxContext.SetPrimitiveTopology(m_TerrainRitem->PrimitiveType);
+	gfxContext.SetVertexBuffer(0, geo->VertexBufferView());
+	gfxContext.SetIndexBuffer(geo->m_IndexBuffer.IndexBufferView());
+	gfxContext.SetConstants(0, m_TerrainRitem->ObjectIndex);
+
+	// one draw per patch, its vertices at its slot and the index list of its stitch mask
+	const UINT patchVertices = Utility::TerrainVerticesPerPatch(m_Terrain->GetDesc().PatchQuads);
+	const std::vector<Utility::TerrainPatch>& patches = m_Terrain->GetPatches();
+	for (uint32_t i : m_VisibleTerrain)
+	{
+		const Utility::TerrainIndexRange& range = m_TerrainRanges[patches[i].StitchMask];
+		gfxContext.DrawIndexedInstanced(range.IndexCount, 1, range.StartIndex, patches[i].Slot * patchVertices, 0);
+	}
+}
+
 void GameApp::BuildWavesGeometry()
 {
 	std::vector<std::uint16_t> indices(3 * mWaves->TriangleCount()); // 3 indices per face
@@ -943,6 +1628,11 @@ void GameApp::BuildWavesGeometry()
 	geo->name = "waveGeo";
 	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), indexBufferSize, indices.data());
 
+	// vertices are rewritten every frame by UpdateWaves
+	geo->m_DynamicVertexBuffer = std::make_unique<DynamicVertexBuffer>();
+	geo->m_DynamicVertexBuffer->Create(L"Waves Vertex Buffer", mWaves->VertexCount(), sizeof(Vertex),
+		*g_CommandManager.GetGraphicsQueue().GetFence());
+
 	SubmeshGeometry submesh;
 	submesh.IndexCount = (UINT)indices.size();
 	submesh.BaseVertexLocation = 0;
@@ -962,6 +1652,11 @@ void GameApp::BuildShapeGeometry()
 	GeometryGenerator::MeshData cylinder = geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
 	GeometryGenerator::MeshData quad = geoGen.CreateQuad(0.0f, 0.0f, 1.0f, 1.0f, 0.0f); // n
 
+	OptimizeMeshData(box, "box");
+	OptimizeMeshData(grid, "grid");
+	OptimizeMeshData(sphere, "sphere");
+	OptimizeMeshData(cylinder, "cylinder");
+
 	UINT boxVertexOffset = 0;
 	UINT gridVertexOffset = (UINT)box.Vertices.size();
 	UINT sphereVertexOffset = gridVertexOffset + (UINT)grid.Vertices.size();
@@ -995,6 +1690,11 @@ void GameApp::BuildShapeGeometry()
 	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
 	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
 
+	boxSubmesh.Meshlets = BuildSubmeshMeshlets(box);
+	gridSubmesh.Meshlets = BuildSubmeshMeshlets(grid);
+	sphereSubmesh.Meshlets = BuildSubmeshMeshlets(sphere);
+	cylinderSubmesh.Meshlets = BuildSubmeshMeshlets(cylinder);
+
 	SubmeshGeometry quadSubmesh;
 	quadSubmesh.IndexCount = (UINT)quad.Indices32.size();
 	quadSubmesh.StartIndexLocation = quadIndexOffset;
@@ -1059,7 +1759,7 @@ void GameApp::BuildShapeGeometry()
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->name = "shapeGeo";
-	geo->m_VertexBuffer.Create(L"vertex buff", (UINT)vertices.size(), sizeof(Vertex), vertices.data());
+	CreateVertexBuffer(*geo, vertices, m_bCompactVertices);
 	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), sizeof(std::uint16_t), indices.data());
 
 	geo->DrawArgs["box"] = std::move(boxSubmesh);
@@ -1106,73 +1806,51 @@ void GameApp::BuildBoxGeometry()
 
 void GameApp::BuildSkullGeometry()
 {
-	std::ifstream fin("../Models/skull.txt");
-
-	if (!fin)
+	// skull.mesh is converted from skull.txt the first time (or whenever the text is newer) and
+	// memory mapped afterwards. The conversion reorders the skull for the vertex cache and
+	// simplifies it, its coarser levels follow the full detail indices and share its vertices
+	MeshFile::Mesh mesh;
+	if (!mesh.LoadOrConvert(L"../Models/skull.mesh", L"../Models/skull.txt"))
 	{
 		MessageBox(0, L"../Models/skull.txt not found.", 0, 0);
 		return;
 	}
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-
-	std::vector<Vertex> vertices(vcount);
-	for (UINT i = 0; i < vcount; ++i)
+	// the file keeps tangents apart from the vertices, this Vertex carries its own
+	std::vector<Vertex> vertices(mesh.GetVertexCount());
+	for (UINT i = 0; i < mesh.GetVertexCount(); ++i)
 	{
-		fin >> vertices[i].position.x >> vertices[i].position.y >> vertices[i].position.z;
-		fin >> vertices[i].normal.x >> vertices[i].normal.y >> vertices[i].normal.z;
-
-		// Model does not have texture coordinates, so just zero them out.
-		vertices[i].tex = { 0.0f, 0.0f };
-
-		XMVECTOR N = XMLoadFloat3(&vertices[i].normal);
-		// Generate a tangent vector so normal mapping works.  We aren't applying
-		// a texture map to the skull, so we just need any tangent vector so that
-		// the math works out to give us the original interpolated vertex normal.
-		XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-		if (fabsf(XMVectorGetX(XMVector3Dot(N, up))) < 1.0f - 0.001f)
-		{
-			XMVECTOR T = XMVector3Normalize(XMVector3Cross(up, N));
-			XMStoreFloat3(&vertices[i].tangent, T);
-		}
-		else
-		{
-			up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-			XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, up));
-			XMStoreFloat3(&vertices[i].tangent, T);
-		}
-
+		const MeshFile::Vertex& v = mesh.GetVertices()[i];
+		vertices[i].position = v.Position;
+		vertices[i].normal = v.Normal;
+		vertices[i].tex = v.Tex;
+		vertices[i].tangent = mesh.GetTangents()[i];
 	}
 
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-	std::vector<std::int32_t> indices(3 * tcount);
-	for (UINT i = 0; i < tcount; ++i)
-	{
-		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-	}
-
-	fin.close();
+	std::vector<std::uint32_t> indices(mesh.GetIndexCount());
+	for (UINT i = 0; i < mesh.GetIndexCount(); ++i)
+		indices[i] = mesh.GetIndex(i);
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->name = "skullGeo";
-	geo->m_VertexBuffer.Create(L"vertex buff", (UINT)vertices.size(), sizeof(Vertex), vertices.data());
-	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), sizeof(std::int32_t), indices.data());
-
-	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
+	CreateVertexBuffer(*geo, vertices, m_bCompactVertices);
+	geo->m_IndexBuffer.Create(L"Index Buffer", (UINT)indices.size(), sizeof(std::uint32_t), indices.data());
 
-	geo->DrawArgs["skull"] = std::move(submesh);
+	for (UINT i = 0; i < mesh.GetLodCount(); ++i)
+	{
+		const MeshFile::Lod& level = mesh.GetLod(i);
+
+		SubmeshGeometry lod;
+		lod.IndexCount = level.IndexCount;
+		lod.StartIndexLocation = level.StartIndex;
+		lod.BaseVertexLocation = 0;
+		lod.LodError = level.Error;
+		lod.Meshlets = BuildSubmeshMeshlets(indices.data() + level.StartIndex, level.IndexCount, &vertices[0].position, sizeof(Vertex), vertices.size());
+		geo->DrawArgs[i == 0 ? std::string("skull") : "skull_lod" + std::to_string(i)] = std::move(lod);
+
+		if (i > 0)
+			Utility::Printf("skull LOD %u: %u triangles, error %.3f\n", i, level.IndexCount / 3, level.Error);
+	}
 
 	m_Geometry["skullGeo"] = std::move(geo);
 
@@ -1316,87 +1994,91 @@ void GameApp::BuildMaterials()
 	m_Materials[mirror0->Name] = std::move(mirror0);
 	m_Materials[sky->Name] = std::move(sky);
 
-	std::vector<MaterialConstants> mat;
-	MaterialConstants temp;
+	// the material buffer is ordered by diffuse map, which is what the render items index it with
 	for (auto& m : m_Materials)
+		m_MaterialOrder.push_back(m.second.get());
+	std::sort(m_MaterialOrder.begin(), m_MaterialOrder.end(),
+		[](const Material* a, const Material* b)
+		{return a->DiffuseMapIndex < b->DiffuseMapIndex; }
+	);
+}
+
+void GameApp::UploadMaterialConstants()
+{
+	DynAlloc alloc = m_ObjectAllocator.Allocate(m_MaterialOrder.size() * sizeof(MaterialConstants));
+	MaterialConstants* materials = (MaterialConstants*)alloc.DataPtr;
+
+	// the texture indices of a material are positions in m_Textures and m_NormalTextures, the
+	// shaders get the bindless slots, which change once when a streamed texture is published.
+	// The sky samples the cube map and its diffuse index points past m_Textures.
+	auto slotOf = [](const std::vector<TextureRef>& textures, UINT index)
+	{
+		return index < textures.size() ? textures[index].GetBindlessIndex() : GetDefaultTextureIndex(kMagenta2D);
+	};
+
+	for (size_t i = 0; i < m_MaterialOrder.size(); ++i)
 	{
-		temp.DiffuseAlbedo = m.second->DiffuseAlbedo;
-		temp.FresnelR0 = m.second->FresnelR0;
-		temp.DiffuseMapIndex = m.second->DiffuseMapIndex;
-		XMStoreFloat4x4(&temp.MatTransform, XMMatrixTranspose(m.second->MatTransform));
-		temp.Roughness = m.second->Roughness;
-		mat.push_back(temp);
+		const Material* m = m_MaterialOrder[i];
+		MaterialConstants& dst = materials[i];
+
+		XMStoreFloat4x4(&dst.MatTransform, XMMatrixTranspose(m->MatTransform));
+		dst.DiffuseAlbedo = m->DiffuseAlbedo;
+		dst.FresnelR0 = m->FresnelR0;
+		dst.Roughness = m->Roughness;
+		dst.DiffuseMapIndex = slotOf(m_Textures, m->DiffuseMapIndex);
+		dst.NormalMapIndex = slotOf(m_NormalTextures, m->NormalMapIndex);
+		dst.MaterialPad[0] = dst.MaterialPad[1] = 0;
 	}
-	std::sort(mat.begin(), mat.end(), 
-		[](const MaterialConstants& a, const MaterialConstants& b) 
-		{return a.DiffuseMapIndex < b.DiffuseMapIndex; }
-	);
-	matBuffer.Create(L"material buffer", (UINT)m_Materials.size(), sizeof(MaterialConstants), mat.data());
+
+	m_MaterialConstants = alloc.GpuAddress;
 }
 
 void GameApp::LoadTextures()
 {
 	// 需要把TextureRef对象保存下来，出了有效域对象销毁，handle无效了
+	// 纹理在后台线程加载，加载完成前handle指向默认纹理；无论成功与否都保存，保证材质里的纹理下标不变
 	TextureManager::Initialize(L"../textures/");
 
-	TextureRef grassTex = TextureManager::LoadDDSFromFile(L"grass.dds");
-	if(grassTex.IsValid())
-		m_Textures.push_back(grassTex);
+	TextureRef grassTex = TextureManager::LoadDDSFromFileAsync(L"grass.dds");
+	m_Textures.push_back(grassTex);
 
-	TextureRef waterTex = TextureManager::LoadDDSFromFile(L"water1.dds");
-	if (waterTex.IsValid())
-		m_Textures.push_back(waterTex);
+	TextureRef waterTex = TextureManager::LoadDDSFromFileAsync(L"water1.dds");
+	m_Textures.push_back(waterTex);
 
-	TextureRef tileTex = TextureManager::LoadDDSFromFile(L"tile.dds");
-	if (tileTex.IsValid())
-		m_Textures.push_back(tileTex);
+	TextureRef tileTex = TextureManager::LoadDDSFromFileAsync(L"tile.dds");
+	m_Textures.push_back(tileTex);
 
-	TextureRef stoneTex = TextureManager::LoadDDSFromFile(L"stone.dds");
-	if (stoneTex.IsValid())
-		m_Textures.push_back(stoneTex);
+	TextureRef stoneTex = TextureManager::LoadDDSFromFileAsync(L"stone.dds");
+	m_Textures.push_back(stoneTex);
 
-	TextureRef bricks2Tex = TextureManager::LoadDDSFromFile(L"bricks2.dds");
-	if (bricks2Tex.IsValid())
-		m_Textures.push_back(bricks2Tex);
+	TextureRef bricks2Tex = TextureManager::LoadDDSFromFileAsync(L"bricks2.dds");
+	m_Textures.push_back(bricks2Tex);
 
-	TextureRef WireFenceTex = TextureManager::LoadDDSFromFile(L"WireFence.dds");
-	if (WireFenceTex.IsValid())
-		m_Textures.push_back(WireFenceTex);
+	TextureRef WireFenceTex = TextureManager::LoadDDSFromFileAsync(L"WireFence.dds");
+	m_Textures.push_back(WireFenceTex);
 
-	TextureRef white1x1Tex = TextureManager::LoadDDSFromFile(L"white1x1.dds");
-	if (white1x1Tex.IsValid())
-		m_Textures.push_back(white1x1Tex);
+	TextureRef white1x1Tex = TextureManager::LoadDDSFromFileAsync(L"white1x1.dds");
+	m_Textures.push_back(white1x1Tex);
 
-	TextureRef iceTex = TextureManager::LoadDDSFromFile(L"ice.dds");
-	if (iceTex.IsValid())
-		m_Textures.push_back(iceTex);
+	TextureRef iceTex = TextureManager::LoadDDSFromFileAsync(L"ice.dds");
+	m_Textures.push_back(iceTex);
 
-	TextureRef cubeMap = TextureManager::LoadDDSFromFile(L"snowcube1024.dds");
-	if (cubeMap.IsValid())
-		m_cubeMap.push_back(cubeMap);
+	TextureRef cubeMap = TextureManager::LoadDDSFromFileAsync(L"snowcube1024.dds");
+	m_cubeMap.push_back(cubeMap);
 
-	Utility::Printf("Found %u diffuse textures\n", m_Textures.size());
-
-	//m_srvs.resize(m_Textures.size());
-	for (auto& t : m_Textures)
-		m_srvs.push_back(t.GetSRV());
+	Utility::Printf("Requested %u diffuse textures\n", m_Textures.size());
 
 	// normal map
-	TextureRef default_nmap = TextureManager::LoadDDSFromFile(L"default_nmap.dds");
-	if (default_nmap.IsValid())
-		m_NormalTextures.push_back(default_nmap);
+	TextureRef default_nmap = TextureManager::LoadDDSFromFileAsync(L"default_nmap.dds");
+	m_NormalTextures.push_back(default_nmap);
 
-	TextureRef tile_nmap = TextureManager::LoadDDSFromFile(L"tile_nmap.dds");
-	if (tile_nmap.IsValid())
-		m_NormalTextures.push_back(tile_nmap);
+	TextureRef tile_nmap = TextureManager::LoadDDSFromFileAsync(L"tile_nmap.dds");
+	m_NormalTextures.push_back(tile_nmap);
 
-	TextureRef bricks2_nmap = TextureManager::LoadDDSFromFile(L"bricks2_nmap.dds");
-	if (bricks2_nmap.IsValid())
-		m_NormalTextures.push_back(bricks2_nmap);
+	TextureRef bricks2_nmap = TextureManager::LoadDDSFromFileAsync(L"bricks2_nmap.dds");
+	m_NormalTextures.push_back(bricks2_nmap);
 
-	Utility::Printf("Found %u Normal textures\n", m_NormalTextures.size());
-	for (auto& n : m_NormalTextures)
-		m_Normalsrvs.push_back(n.GetSRV());
+	Utility::Printf("Requested %u Normal textures\n", m_NormalTextures.size());
 }
 
 void GameApp::UpdatePassCB(float deltaT)
@@ -1490,26 +2172,31 @@ void GameApp::UpdateWaves(float deltaT)
 	}
 
 
-	// Update the wave simulation.
-	mWaves->Update(deltaT);
+	// The step kicked off last frame has to be done before we read its snapshot.
+	mWaves->WaitForUpdate();
 
-	// Update the wave vertex buffer with the new solution.
-	m_VerticesWaves.clear();
+	// Update the wave vertex buffer with the last completed solution.
+	// write straight into this frame's region of the mapped upload ring
+	Vertex* vertices = (Vertex*)m_Geometry["waveGeo"]->m_DynamicVertexBuffer->BeginFrame();
 	for (int i = 0; i < mWaves->VertexCount(); ++i)
 	{
 		Vertex v;
 
 		v.position = mWaves->Position(i);
 		v.normal = mWaves->Normal(i);
+		v.tangent = mWaves->TangentX(i);
 
 		v.tex.x = 0.5f + v.position.x / mWaves->Width();
 		v.tex.y = 0.5f - v.position.z / mWaves->Depth();
 
-		m_VerticesWaves.push_back(v);
+		// upload heap is write-combined, write whole vertices and never read back
+		vertices[i] = v;
 	}
-	AnimateMaterials(deltaT);
 
-	m_Geometry["waveGeo"]->m_VertexBuffer.Create(L"vertex buffer", m_VerticesWaves.size(), sizeof(Vertex), m_VerticesWaves.data());
+	// Update the wave simulation on a worker while this frame is recorded.
+	mWaves->UpdateAsync(deltaT);
+
+	AnimateMaterials(deltaT);
 }
 
 void GameApp::UpdateShadowTranform(float deltaT)
@@ -1519,6 +2206,9 @@ void GameApp::UpdateShadowTranform(float deltaT)
 	mSceneBounds.Radius = sqrtf(10.0 * 10.0 + 10.0 * 10.0);
 
 	m_shadowMap->SetToLightSpaceView(passConstant.Lights[0].Direction, mSceneBounds);
+
+	// the passes copy passConstant while recording, so every one of them sees this frame's transform
+	XMStoreFloat4x4(&passConstant.ShadowTransform, XMMatrixTranspose(m_shadowMap->GetShadowTransform()));
 }
 
 void GameApp::AnimateMaterials(float deltaT)
@@ -13,6 +13,11 @@
 #include "ShadowMap.h"
 #include "Blur.h"
 #include "SSAO.h"
+#include "FrameGraph.h"
+#include "RadixSort.h"
+#include "TerrainQuadtree.h"
+#include "IndirectCulling.h"
+#include "CommandSignature.h"
 
 enum class RenderLayer : int
 {
@@ -48,6 +53,25 @@ struct RenderItem
 	UINT StartIndexLocation = 0;
 	UINT BaseVertexLocation = 0;
 
+	// pipeline | geometry | material | depth, rebuilt every frame by SortRenderItems
+	uint64_t SortKey = 0;
+
+	// slot of this item in the per-frame object constants buffer
+	UINT ObjectIndex = 0;
+
+	// full detail first, SelectLods copies the chosen level into the draw arguments above
+	std::vector<const SubmeshGeometry*> Lods;
+	UINT Lod = 0;
+
+	// Meshlets of the submesh drawn. CullClusters writes the triangles of the clusters the
+	// camera can see to the index buffer below, camera passes draw that instead
+	const Utility::MeshletMesh* Meshlets = nullptr;
+	bool ClusterCulled = false;
+	D3D12_INDEX_BUFFER_VIEW CulledIndexBuffer = {};
+	UINT CulledIndexCount = 0;
+
+	// object space sphere around every level of detail, negative radius when the item has no meshlets
+	DirectX::XMFLOAT4 BoundingSphere = { 0.0f, 0.0f, 0.0f, -1.0f };
 };
 
 class GraphicsContext;
@@ -68,14 +92,28 @@ private:
 
 	void SetPsoAndRootSig();
 
-	void DrawRenderItems(GraphicsContext& gfxContext, std::vector<RenderItem*>& items);
-	void DrawSceneToCubeMap(GraphicsContext& gfxContext);
+	// sets pipeline pso, or its "_compact" twin for items of compact geometry, as it goes
+	void DrawRenderItems(GraphicsContext& gfxContext, const std::string& pso, std::vector<RenderItem*>& items, bool clusterCulled = false);
+	void DrawFullQuad(GraphicsContext& gfxContext, std::vector<RenderItem*>& items);
+	void UploadObjectConstants();
+	void UploadMaterialConstants();
+
+	void AssignSortIds();
+	void SortRenderItems(std::vector<RenderItem*>& items, RenderLayer layer, DirectX::FXMMATRIX view);
+	void SelectLods();
+	void AttachMeshlets();
+	void CullClusters();
+	void BuildIndirectInstances();
+	void CullInstancesOnGpu(GraphicsContext& gfxContext);
+	// draws the batches [firstBatch, endBatch) from the commands CullInstancesOnGpu left
+	void DrawRenderItemsIndirect(GraphicsContext& gfxContext, const std::string& pso, UINT firstBatch, UINT endBatch);
+	void DrawSceneToCubeMap(GraphicsContext& gfxContext, int face);
 
 	void DrawSceneToShadowMap(GraphicsContext& gfxContext);
-	void DrawSceneToDepth2Map(GraphicsContext& gfxContext);
 
 	void DrawSceneToNormal(GraphicsContext& gfxContext);
 	void ComputeSSAO(GraphicsContext& gfxContext);
+	void DrawSceneToBackBuffer(GraphicsContext& gfxContext);
 
 	void BuildCubeFaceCamera(float x=0.0, float y=0.0, float z=0.0);
 
@@ -84,6 +122,10 @@ private:
 	void BuildSkyboxRenderItems();
 
 	void BuildLandGeometry();
+	void PrimeTerrain();
+	bool UpdateTerrain();
+	void CullTerrain();
+	void DrawTerrain(GraphicsContext& gfxContext, const std::string& pso);
 	void BuildWavesGeometry();
 	void BuildShapeGeometry();
 	void BuildBoxGeometry();
@@ -109,10 +151,51 @@ private:
 	// switch render scene
 	bool m_bRenderShapes = true;
 
+	// records the passes of a frame on the thread pool, F2 toggles serial recording
+	FrameGraph m_FrameGraph;
+	bool m_bParallelRecording = true;
+	uint32_t m_FramesSinceStats = 0;
+
+	// upload the vertices of static meshes as Utility::CompactVertex, read when they are built
+	bool m_bCompactVertices = true;
+
+	// cluster culling of the camera passes, reported with F3
+	std::vector<uint32_t> m_CulledIndices;
+	Utility::MeshletCullStats m_ClusterStats = {};
+
+	// the hills as quadtree patches streamed into the vertex pool of "landGeo", F4 draws them.
+	// The pool is created and primed on the first F4
+	std::unique_ptr<Utility::TerrainStreamer> m_Terrain;
+	Utility::TerrainIndexRange m_TerrainRanges[16];
+	std::vector<Utility::TerrainStreamer::Upload> m_TerrainUploads;
+	std::vector<uint32_t> m_VisibleTerrain;
+	RenderItem* m_TerrainRitem = nullptr;
+	bool m_bRenderTerrain = false;
+	bool m_bTerrainPrimed = false;
+
+	// GPU-driven camera passes: a compute pass culls the opaque items and writes their draws
+	// for ExecuteIndirect, one batch per run of items sharing geometry. F5 goes back to CPU
+	// draws with cluster culling
+	bool m_bGpuDriven = true;
+	RootSignature m_CullRootSignature;
+	ComputePSO m_CullPSO;
+	CommandSignature m_DrawSignature;
+	IndirectArgsBuffer m_DrawCommands;
+	IndirectArgsBuffer m_DrawCounts;
+	std::vector<Utility::IndirectInstance> m_IndirectInstances;
+	std::vector<Utility::IndirectBatch> m_IndirectBatches;
+	std::vector<RenderItem*> m_IndirectBatchItems;     // first item of each batch, for its state
+	UINT m_ReflectorBatch = 0;                          // first batch of OpaqueDynamicReflectors
+	alignas(16) float m_CullPlanes[6][4];
+
+	// reused by SortRenderItems
+	std::vector<Utility::SortEntry> m_SortEntries;
+	std::vector<Utility::SortEntry> m_SortScratch;
+	std::vector<RenderItem*> m_SortedItems;
+
 	// waves
 	std::unique_ptr<Waves> mWaves;
 	RenderItem* m_WavesRitem;
-	std::vector<Vertex> m_VerticesWaves;
 
 	// skull
 	RenderItem* m_SkullRitem;
@@ -133,8 +216,6 @@ private:
 	std::vector<TextureRef> m_Textures; // work
 	std::vector<TextureRef> m_NormalTextures; // work
 	std::vector<TextureRef> m_cubeMap; // work
-	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_srvs;
-	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_Normalsrvs;
 
 	D3D12_VIEWPORT m_Viewport;
 	D3D12_RECT m_Scissor;
@@ -144,7 +225,16 @@ private:
 	DirectX::XMMATRIX m_Projection;
 
 	PassConstants passConstant;
-	StructuredBuffer matBuffer;
+
+	// ObjConstants of all render items, written in one block per frame and read
+	// through root SRV 6, each draw only sets its index as root constant 0
+	LinearAllocator m_ObjectAllocator{ kCpuWritable };
+	D3D12_GPU_VIRTUAL_ADDRESS m_ObjectConstants = 0;
+
+	// MaterialConstants in material buffer order, rewritten every frame with the current
+	// bindless slots of their textures and read through root SRV 2
+	std::vector<Material*> m_MaterialOrder;
+	D3D12_GPU_VIRTUAL_ADDRESS m_MaterialConstants = 0;
 
 	SsaoPassConstants ssaoCB;
 
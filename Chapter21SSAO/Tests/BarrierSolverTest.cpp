@@ -0,0 +1,357 @@
+#include "TestHarness.h"
+#include "BarrierSolver.h"
+#include <random>
+#include <string>
+
+// BarrierSolver on the cases it is meant to handle, each checked against the exact barriers
+// expected, then on random pass sequences replayed barrier by barrier: every access must find
+// its resource in a state that serves it, every UAV written twice must see a UAV barrier in
+// between, and every resource must end in its final state.
+//
+// Barriers print as one "|" per boundary, then T (transition), B/E (split begin/end) or U (UAV
+// barrier), the resource, and the states before and after in hex.
+
+namespace
+{
+    // D3D12_RESOURCE_STATES
+    const uint32_t kCommon = 0x0;
+    const uint32_t kRenderTarget = 0x4;
+    const uint32_t kUnorderedAccess = 0x8;
+    const uint32_t kDepthWrite = 0x10;
+    const uint32_t kDepthRead = 0x20;
+    const uint32_t kNonPixelShader = 0x40;
+    const uint32_t kPixelShader = 0x80;
+    const uint32_t kIndirectArgument = 0x200;
+    const uint32_t kCopyDest = 0x400;
+    const uint32_t kCopySource = 0x800;
+    const uint32_t kGenericRead = 0xAC3;
+    const uint32_t kPresent = 0x0;
+
+    std::string Dump(const BarrierSolver& Solver)
+    {
+        std::string Result;
+        for (uint32_t b = 0; b <= Solver.GetPassCount(); ++b)
+        {
+            uint32_t NumBarriers;
+            const BarrierSolver::Barrier* Barriers = Solver.GetBarriers(b, NumBarriers);
+            Result += "|";
+            for (uint32_t i = 0; i < NumBarriers; ++i)
+            {
+                static const char* kTypes = "TBEU";
+                char Text[64];
+                snprintf(Text, sizeof(Text), "%c%u:%x>%x ", kTypes[Barriers[i].Type], Barriers[i].Resource,
+                    Barriers[i].StateBefore, Barriers[i].StateAfter);
+                Result += Text;
+            }
+        }
+        return Result;
+    }
+}
+
+// Passes reading a resource in different read states share the one transition into the
+// first, widened to their combined state
+static void TestCombinedReads(void)
+{
+    BarrierSolver Solver;
+    const uint32_t R = Solver.AddResource(kUnorderedAccess);
+    Solver.AddPass(); Solver.Read(R, kPixelShader);
+    Solver.AddPass(); Solver.Read(R, kNonPixelShader);
+    Solver.AddPass(); Solver.Read(R, kPixelShader);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T0:8>c0 |||");
+    CHECK(Solver.GetStats().Transitions == 1 && Solver.GetStats().Elided == 2);
+    CHECK(Solver.GetFinalState(R) == (kPixelShader | kNonPixelShader));
+
+    // One pass declaring a resource more than once uses it in one state: the combined read
+    // state, or the written state when it also writes it
+    Solver.Reset();
+    const uint32_t A = Solver.AddResource(kRenderTarget);
+    const uint32_t B = Solver.AddResource(kGenericRead);
+    Solver.AddPass();
+    Solver.Read(A, kPixelShader);
+    Solver.Read(A, kNonPixelShader);
+    Solver.Read(B, kPixelShader);
+    Solver.Write(B, kUnorderedAccess);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T0:4>c0 T1:ac3>8 |");
+
+    // A write ends the run: the next read needs a transition of its own
+    Solver.Reset();
+    const uint32_t C = Solver.AddResource(kGenericRead);
+    Solver.AddPass(); Solver.Read(C, kPixelShader);
+    Solver.AddPass(); Solver.Write(C, kRenderTarget);
+    Solver.AddPass(); Solver.Read(C, kPixelShader);
+    Solver.AddPass(); Solver.Read(C, kCopySource);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "||T0:ac3>4 |T0:4>880 ||");
+}
+
+// A UAV written by consecutive passes gets a UAV barrier, other states written twice do not,
+// and neither does a UAV's first write in the frame
+static void TestUAVBarriers(void)
+{
+    BarrierSolver Solver;
+    const uint32_t U = Solver.AddResource(kUnorderedAccess);
+    const uint32_t T = Solver.AddResource(kRenderTarget);
+    Solver.AddPass(); Solver.Write(U, kUnorderedAccess); Solver.Write(T, kRenderTarget);
+    Solver.AddPass(); Solver.Write(U, kUnorderedAccess); Solver.Write(T, kRenderTarget);
+    Solver.AddPass(); Solver.Write(U, kUnorderedAccess);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "||U0:8>8 |U0:8>8 |");
+    CHECK(Solver.GetStats().UAVBarriers == 2 && Solver.GetStats().Elided == 3);
+    CHECK(Solver.GetStats().BarrierCalls == 2);
+
+    // A transition in between already orders the writes
+    Solver.Reset();
+    const uint32_t V = Solver.AddResource(kUnorderedAccess);
+    Solver.AddPass(); Solver.Write(V, kUnorderedAccess);
+    Solver.AddPass(); Solver.Read(V, kNonPixelShader);
+    Solver.AddPass(); Solver.Write(V, kUnorderedAccess);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "||T0:8>40 |T0:40>8 |");
+    CHECK(Solver.GetStats().UAVBarriers == 0);
+}
+
+// Slack between a resource's uses becomes a BEGIN/END pair only when both ends are in the
+// same command list
+static void TestSplitPlacement(void)
+{
+    BarrierSolver Solver;
+    uint32_t R = Solver.AddResource(kGenericRead);
+    Solver.AddPass(0); Solver.Write(R, kRenderTarget);
+    Solver.AddPass(0);
+    Solver.AddPass(0); Solver.Read(R, kGenericRead);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T0:ac3>4 |B0:4>ac3 |E0:4>ac3 |");
+    CHECK(Solver.GetStats().SplitTransitions == 1 && Solver.GetStats().Transitions == 1);
+
+    Solver.Reset();
+    R = Solver.AddResource(kGenericRead);
+    Solver.AddPass(0); Solver.Write(R, kRenderTarget);
+    Solver.AddPass(1);
+    Solver.AddPass(2); Solver.Read(R, kGenericRead);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T0:ac3>4 ||T0:4>ac3 |");
+    CHECK(Solver.GetStats().SplitTransitions == 0);
+
+    // The first use in the frame has nothing to wait on, so its transition can begin before
+    // the first pass, and a final state can begin right after the last use
+    Solver.Reset();
+    R = Solver.AddResource(kCommon);
+    const uint32_t Back = Solver.AddResource(kPresent);
+    Solver.AddPass(0); Solver.Write(Back, kRenderTarget);
+    Solver.AddPass(0); Solver.Read(R, kPixelShader);
+    Solver.AddPass(0);
+    Solver.SetFinalState(R, kCopyDest);
+    Solver.SetFinalState(Back, kPresent);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T1:0>4 B0:0>80 |E0:0>80 B1:4>0 |B0:80>400 |E0:80>400 E1:4>0 ");
+    CHECK(Solver.GetStats().SplitTransitions == 3);
+
+    // Blur::Execute with one blur: the second output is first used by the second pass, so its
+    // transition into UAV begins before the first
+    Solver.Reset();
+    const uint32_t In = Solver.AddResource(kGenericRead);
+    const uint32_t Out0 = Solver.AddResource(kGenericRead);
+    const uint32_t Out1 = Solver.AddResource(kGenericRead);
+    Solver.AddPass(); Solver.Read(In, kGenericRead); Solver.Write(Out0, kUnorderedAccess);
+    Solver.AddPass(); Solver.Read(Out0, kGenericRead); Solver.Write(Out1, kUnorderedAccess);
+    Solver.AddPass(); Solver.Read(Out1, kGenericRead); Solver.Write(Out0, kUnorderedAccess);
+    Solver.SetFinalState(Out0, kGenericRead);
+    Solver.SetFinalState(Out1, kGenericRead);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T1:ac3>8 B2:ac3>8 |T1:8>ac3 E2:ac3>8 |T2:8>ac3 T1:ac3>8 |T1:8>ac3 ");
+    CHECK(Solver.GetStats().BarrierCalls == 4);
+
+    // Solving again starts over from the initial states and gives the same barriers
+    const std::string First = Dump(Solver);
+    Solver.Solve();
+    CHECK(Dump(Solver) == First);
+}
+
+// A final read state that contains the current one is folded into the last read transition,
+// anything else gets a transition after the last pass
+static void TestFinalStateFolding(void)
+{
+    BarrierSolver Solver;
+    uint32_t R = Solver.AddResource(kRenderTarget);
+    Solver.AddPass(); Solver.Read(R, kPixelShader);
+    Solver.AddPass();
+    Solver.SetFinalState(R, kGenericRead);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T0:4>ac3 ||");
+    CHECK(Solver.GetFinalState(R) == kGenericRead);
+
+    // not after a write
+    Solver.Reset();
+    R = Solver.AddResource(kGenericRead);
+    Solver.AddPass(); Solver.Write(R, kRenderTarget);
+    Solver.SetFinalState(R, kGenericRead);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T0:ac3>4 |T0:4>ac3 ");
+
+    // not when the final state is no read state
+    Solver.Reset();
+    R = Solver.AddResource(kRenderTarget);
+    Solver.AddPass(); Solver.Read(R, kPixelShader);
+    Solver.SetFinalState(R, kPresent);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "|T0:4>80 |T0:80>0 ");
+
+    // a resource already in its final state, or without one, is left alone
+    Solver.Reset();
+    R = Solver.AddResource(kDepthWrite);
+    const uint32_t Untouched = Solver.AddResource(kCopySource);
+    Solver.AddPass(); Solver.Write(R, kDepthWrite);
+    Solver.SetFinalState(R, kDepthWrite);
+    Solver.SetFinalState(Untouched, kCopySource);
+    Solver.Solve();
+    CHECK(Dump(Solver) == "||");
+    CHECK(Solver.GetStats().Elided == 1);
+}
+
+// Random frames replayed barrier by barrier, the way the D3D debug layer would see them
+static void TestRandomFrames(void)
+{
+    static const uint32_t kReadStates[] = { kDepthRead, kNonPixelShader, kPixelShader, kIndirectArgument, kCopySource, kGenericRead };
+    static const uint32_t kWriteStates[] = { kRenderTarget, kUnorderedAccess, kDepthWrite, kCopyDest };
+    static const uint32_t kNumResources = 5;
+
+    std::mt19937 Rng(1);
+    BarrierSolver Solver;
+    uint32_t NumSplits = 0, NumUAVBarriers = 0;
+
+    for (int Frame = 0; Frame < 5000; ++Frame)
+    {
+        Solver.Reset();
+
+        const uint32_t NumPasses = 1 + Rng() % 8;
+        std::vector<uint32_t> Initial(kNumResources), Final(kNumResources, ~0u);
+        for (uint32_t r = 0; r < kNumResources; ++r)
+        {
+            Initial[r] = Rng() % 3 == 0 ? kCommon : Rng() % 2 ? kReadStates[Rng() % 6] : kWriteStates[Rng() % 4];
+            Solver.AddResource(Initial[r]);
+            if (Rng() % 2)
+            {
+                Final[r] = Rng() % 2 ? kReadStates[Rng() % 6] : kWriteStates[Rng() % 4];
+                Solver.SetFinalState(r, Final[r]);
+            }
+        }
+
+        // at most one access per resource per pass, states as declared
+        struct Access { uint32_t Pass, Resource, State; bool Write; };
+        std::vector<Access> Accesses;
+        std::vector<uint32_t> Lists(NumPasses);
+        uint32_t List = 0;
+        for (uint32_t p = 0; p < NumPasses; ++p)
+        {
+            List += Rng() % 3 == 0;
+            Lists[p] = List;
+            Solver.AddPass(List);
+            for (uint32_t r = 0; r < kNumResources; ++r)
+            {
+                const uint32_t Kind = Rng() % 4;
+                if (Kind == 0)
+                {
+                    Accesses.push_back({ p, r, kReadStates[Rng() % 6], false });
+                    Solver.Read(r, Accesses.back().State);
+                }
+                else if (Kind == 1)
+                {
+                    Accesses.push_back({ p, r, kWriteStates[Rng() % 4], true });
+                    Solver.Write(r, Accesses.back().State);
+                }
+            }
+        }
+        Solver.Solve();
+
+        std::vector<uint32_t> State = Initial;
+        std::vector<bool> Splitting(kNumResources, false);
+        std::vector<uint32_t> SplitAfter(kNumResources, 0), SplitList(kNumResources, 0);
+        std::vector<bool> UnorderedWrite(kNumResources, false);
+        size_t NextAccess = 0;
+
+        for (uint32_t b = 0; b <= NumPasses; ++b)
+        {
+            const uint32_t BoundaryList = Lists[b < NumPasses ? b : NumPasses - 1];
+            uint32_t NumBarriers;
+            const BarrierSolver::Barrier* Barriers = Solver.GetBarriers(b, NumBarriers);
+            for (uint32_t i = 0; i < NumBarriers; ++i)
+            {
+                const BarrierSolver::Barrier& Barrier = Barriers[i];
+                const uint32_t r = Barrier.Resource;
+                CHECK(r < kNumResources);
+                switch (Barrier.Type)
+                {
+                case BarrierSolver::kTransition:
+                case BarrierSolver::kBeginOnly:
+                    CHECK(!Splitting[r] && State[r] == Barrier.StateBefore && Barrier.StateBefore != Barrier.StateAfter);
+                    if (Barrier.Type == BarrierSolver::kTransition)
+                    {
+                        State[r] = Barrier.StateAfter;
+                    }
+                    else
+                    {
+                        Splitting[r] = true;
+                        SplitAfter[r] = Barrier.StateAfter;
+                        SplitList[r] = BoundaryList;
+                        ++NumSplits;
+                    }
+                    UnorderedWrite[r] = false;
+                    break;
+                case BarrierSolver::kEndOnly:
+                    CHECK(Splitting[r] && SplitAfter[r] == Barrier.StateAfter && SplitList[r] == BoundaryList);
+                    Splitting[r] = false;
+                    State[r] = Barrier.StateAfter;
+                    break;
+                case BarrierSolver::kUAV:
+                    CHECK(State[r] == kUnorderedAccess);
+                    UnorderedWrite[r] = false;
+                    ++NumUAVBarriers;
+                    break;
+                }
+            }
+
+            for (; NextAccess < Accesses.size() && Accesses[NextAccess].Pass == b; ++NextAccess)
+            {
+                const Access& A = Accesses[NextAccess];
+                CHECK(!Splitting[A.Resource]);
+                if (A.Write)
+                {
+                    CHECK(State[A.Resource] == A.State);
+                    if (A.State == kUnorderedAccess)
+                    {
+                        CHECK(!UnorderedWrite[A.Resource]);
+                        UnorderedWrite[A.Resource] = true;
+                    }
+                }
+                else
+                {
+                    CHECK((State[A.Resource] & A.State) == A.State);
+                    CHECK((State[A.Resource] & ~BarrierSolver::kReadOnlyStates) == 0);
+                }
+            }
+        }
+
+        for (uint32_t r = 0; r < kNumResources; ++r)
+        {
+            CHECK(!Splitting[r]);
+            if (Final[r] != ~0u)
+                CHECK(State[r] == Final[r]);
+            CHECK(Solver.GetFinalState(r) == State[r]);
+        }
+    }
+
+    // the random frames did reach the split and UAV paths
+    CHECK(NumSplits > 100 && NumUAVBarriers > 100);
+}
+
+int main(void)
+{
+    TestCombinedReads();
+    TestUAVBarriers();
+    TestSplitPlacement();
+    TestFinalStateFolding();
+    TestRandomFrames();
+    return Test::Finish("BarrierSolverTest");
+}
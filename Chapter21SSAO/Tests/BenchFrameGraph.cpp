@@ -0,0 +1,133 @@
+#include "TestHarness.h"
+#include "NullDevice.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "CommandListManager.h"
+#include "FrameGraph.h"
+#include "GpuBuffer.h"
+#include "RootSignature.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <thread>
+
+// Recording throughput of FrameGraph on the null device: a frame of synthetic passes, each
+// reading a shared buffer, writing one of its own and recording a run of draws with root
+// constants and a dynamic descriptor table, the way the scene passes of GameApp do. Recorded
+// on the calling thread alone, then on the ThreadPool with 1 to 7 workers besides it.
+//
+// Only the recording is timed, as GetLastRecordTimeMs reports it; the null queue executes a
+// batch as soon as it is submitted. Passes per millisecond only grow with the thread count
+// on a machine with that many cores, so the core count is printed too.
+
+namespace
+{
+    const int kPasses = 48;
+    const int kDrawsPerPass = 200;
+    const UINT kTableSize = 4;
+
+    NullDevice& GetNullDevice(void)
+    {
+        return *static_cast<NullDevice*>(Graphics::g_Device);
+    }
+
+    struct Scene
+    {
+        RootSignature RootSig;
+        ByteAddressBuffer Shared;
+        ByteAddressBuffer Targets[kPasses];
+        D3D12_CPU_DESCRIPTOR_HANDLE Table[kTableSize];
+
+        Scene(void)
+        {
+            RootSig.Reset(2, 0);
+            RootSig[0].InitAsConstants(0, 2);
+            RootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, kTableSize);
+            RootSig.Finalize(L"Frame Graph Bench");
+
+            Shared.Create(L"Shared", 256, 4);
+            for (ByteAddressBuffer& Target : Targets)
+                Target.Create(L"Pass Target", 256, 4);
+            for (UINT i = 0; i < kTableSize; ++i)
+                Table[i] = Targets[i].GetSRV();
+        }
+
+        ~Scene(void)
+        {
+            Shared.Destroy();
+            for (ByteAddressBuffer& Target : Targets)
+                Target.Destroy();
+        }
+    };
+
+    void AddPasses(FrameGraph& Graph, Scene& S)
+    {
+        Graph.Reset();
+        for (int i = 0; i < kPasses; ++i)
+        {
+            FrameGraph::Pass& Pass = Graph.AddPass(L"Synthetic", [&S, i](GraphicsContext& Context)
+            {
+                Context.SetRootSignature(S.RootSig);
+                for (int Draw = 0; Draw < kDrawsPerPass; ++Draw)
+                {
+                    Context.SetConstants(0, i, Draw);
+                    Context.SetDynamicDescriptors(1, 0, kTableSize, S.Table);
+                    Context.Draw(3);
+                }
+            });
+            Pass.Read(S.Shared, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+                .Write(S.Targets[i], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+    }
+
+    // Frames recorded with Threads threads in all, returns passes per millisecond
+    double Run(Scene& S, int Threads, int Frames)
+    {
+        if (Threads > 1)
+            ThreadPool::Initialize(Threads - 1);
+
+        FrameGraph Graph;
+        NullCommandStats Before = GetNullDevice().GetExecutedStats();
+        double RecordMs = 0.0;
+
+        for (int Frame = 0; Frame < Frames; ++Frame)
+        {
+            AddPasses(Graph, S);
+            Graph.Execute(Threads > 1);
+            RecordMs += Graph.GetLastRecordTimeMs();
+        }
+        Graphics::g_CommandManager.IdleGPU();
+
+        // every pass reached the queue whole, however it was recorded
+        NullCommandStats After = GetNullDevice().GetExecutedStats();
+        CHECK(After.ExecutedLists == Before.ExecutedLists + (uint64_t)Frames * kPasses);
+        CHECK(After.Draws == Before.Draws + (uint64_t)Frames * kPasses * kDrawsPerPass);
+
+        if (Threads > 1)
+            ThreadPool::Shutdown();
+
+        return Frames * kPasses / RecordMs;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int Frames = std::max(2, (int)(200 * Test::GetScale(argc, argv)));
+
+    Graphics::Initialize(false);
+    {
+        Scene S;
+
+        printf("%d frames of %d passes, %d draws each, %u cores\n", Frames, kPasses, kDrawsPerPass,
+            std::thread::hardware_concurrency());
+        const double Serial = Run(S, 1, Frames);
+        printf("  1 thread   %8.1f passes/ms\n", Serial);
+        for (int Threads : { 2, 4, 8 })
+        {
+            const double Parallel = Run(S, Threads, Frames);
+            printf("  %d threads  %8.1f passes/ms  %5.2fx\n", Threads, Parallel, Parallel / Serial);
+        }
+    }
+    Graphics::Shutdown();
+
+    return Test::Finish("BenchFrameGraph");
+}
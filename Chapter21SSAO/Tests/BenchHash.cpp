@@ -0,0 +1,53 @@
+#include "TestHarness.h"
+#include "Hash.h"
+#include <random>
+#include <vector>
+
+// HashRange on inputs the size of D3D12_GRAPHICS_PIPELINE_STATE_DESC on x64, against the
+// per-word FNV loop Hash.h used on every build but x64 MSVC. One word changes per call so
+// no call can be folded into the previous one.
+
+namespace
+{
+    const size_t kDescWords = 656 / 4;
+
+    size_t HashRangeFNV(const uint32_t* const Begin, const uint32_t* const End, size_t Hash)
+    {
+        for (const uint32_t* Iter = Begin; Iter < End; ++Iter)
+            Hash = 16777619U * Hash ^ *Iter;
+        return Hash;
+    }
+
+    template <typename HashFunc>
+    double NanosecondsPerDesc(HashFunc Func, std::vector<uint32_t>& Desc, int Count)
+    {
+        volatile size_t Sink = 0;
+        Test::Timer Timer;
+        for (int i = 0; i < Count; ++i)
+        {
+            Desc[0] = (uint32_t)i;
+            Sink = Sink + Func(Desc.data(), Desc.data() + Desc.size(), 2166136261U);
+        }
+        return Timer.Seconds() * 1e9 / Count;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int Count = (int)(2000000 * Test::GetScale(argc, argv)) + 1;
+
+    std::vector<uint32_t> Desc(kDescWords, 0);
+    std::mt19937 Rng(1);
+    for (uint32_t& Word : Desc)
+        Word = Rng() % 4 ? 0 : Rng() % 64;
+
+    const double FNV = NanosecondsPerDesc(HashRangeFNV, Desc, Count);
+    const double Current = NanosecondsPerDesc(Utility::HashRange, Desc, Count);
+
+    printf("%d hashes of %zu bytes\n", Count, kDescWords * 4);
+    printf("  FNV loop        %7.1f ns/desc  %6.2f GB/s\n", FNV, kDescWords * 4 / FNV);
+    printf("  HashRange       %7.1f ns/desc  %6.2f GB/s  (%s)\n", Current, kDescWords * 4 / Current,
+        Utility::GetHashRangeImplementation());
+
+    return Test::Finish("BenchHash");
+}
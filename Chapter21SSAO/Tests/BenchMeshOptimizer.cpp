@@ -0,0 +1,225 @@
+#include "TestHarness.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// OptimizeMesh on the skull BuildSkullGeometry loads and on a 100x100 grid like the land, in
+// the app's vertex layout. Prints ACMR, ATVR and overfetch before and after, and overdraw as
+// pixels shaded per pixel covered by a depth-tested, back-face culled 256x256 raster from the
+// six axis views. Checks that no measure of the vertex cache gets worse and that the same
+// triangles come out.
+
+namespace
+{
+    struct Float3 { float x, y, z; };
+
+    // Vertex of GameApp.h
+    struct Vertex
+    {
+        Float3 position;
+        Float3 normal;
+        float tex[2];
+        Float3 tangent;
+    };
+
+    float MeasureOverdraw(const std::vector<Vertex>& Vertices, const std::vector<uint32_t>& Indices)
+    {
+        const int kResolution = 256;
+
+        float Min[3] = { 1e30f, 1e30f, 1e30f };
+        float Max[3] = { -1e30f, -1e30f, -1e30f };
+        for (const Vertex& V : Vertices)
+        {
+            const float* P = &V.position.x;
+            for (int i = 0; i < 3; ++i)
+            {
+                Min[i] = std::min(Min[i], P[i]);
+                Max[i] = std::max(Max[i], P[i]);
+            }
+        }
+        const float Extent = std::max({ Max[0] - Min[0], Max[1] - Min[1], Max[2] - Min[2] });
+
+        size_t Shaded = 0, Covered = 0;
+        std::vector<float> Depth(kResolution * kResolution);
+        for (int Axis = 0; Axis < 3; ++Axis)
+        {
+            for (int Direction = -1; Direction <= 1; Direction += 2)
+            {
+                std::fill(Depth.begin(), Depth.end(), 1e30f);
+                const int U = (Axis + 1) % 3, V = (Axis + 2) % 3;
+
+                for (size_t t = 0; t < Indices.size(); t += 3)
+                {
+                    float X[3], Y[3], Z[3];
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        const float* P = &Vertices[Indices[t + k]].position.x;
+                        X[k] = (P[U] - Min[U]) / Extent * (kResolution - 1);
+                        Y[k] = (P[V] - Min[V]) / Extent * (kResolution - 1);
+                        Z[k] = Direction * (P[Axis] - Min[Axis]);
+                    }
+
+                    const float Area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+                    if (Area * Direction >= 0.0f)
+                        continue;
+
+                    const int X0 = std::max(0, (int)std::floor(std::min({ X[0], X[1], X[2] })));
+                    const int X1 = std::min(kResolution - 1, (int)std::ceil(std::max({ X[0], X[1], X[2] })));
+                    const int Y0 = std::max(0, (int)std::floor(std::min({ Y[0], Y[1], Y[2] })));
+                    const int Y1 = std::min(kResolution - 1, (int)std::ceil(std::max({ Y[0], Y[1], Y[2] })));
+                    for (int py = Y0; py <= Y1; ++py)
+                    {
+                        for (int px = X0; px <= X1; ++px)
+                        {
+                            const float fx = px + 0.5f, fy = py + 0.5f;
+                            const float W0 = ((X[1] - fx) * (Y[2] - fy) - (X[2] - fx) * (Y[1] - fy)) / Area;
+                            const float W1 = ((X[2] - fx) * (Y[0] - fy) - (X[0] - fx) * (Y[2] - fy)) / Area;
+                            const float W2 = 1.0f - W0 - W1;
+                            if (W0 < 0.0f || W1 < 0.0f || W2 < 0.0f)
+                                continue;
+
+                            const float D = W0 * Z[0] + W1 * Z[1] + W2 * Z[2];
+                            float& Nearest = Depth[py * kResolution + px];
+                            if (D < Nearest)
+                            {
+                                if (Nearest == 1e30f)
+                                    ++Covered;
+                                Nearest = D;
+                                ++Shaded;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return Covered != 0 ? (float)Shaded / Covered : 0.0f;
+    }
+
+    // Triangles by their positions, rotated to start at the smallest, so the same triangles
+    // compare equal however vertices and triangles were renumbered
+    std::vector<std::vector<float>> SortedTriangles(const std::vector<Vertex>& Vertices, const std::vector<uint32_t>& Indices)
+    {
+        std::vector<std::vector<float>> Triangles;
+        for (size_t t = 0; t < Indices.size(); t += 3)
+        {
+            std::vector<float> Corners[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                const Vertex& V = Vertices[Indices[t + k]];
+                Corners[k] = { V.position.x, V.position.y, V.position.z, V.normal.x, V.normal.y, V.normal.z };
+            }
+            const int First = (int)(std::min_element(Corners, Corners + 3) - Corners);
+            std::vector<float> Triangle;
+            for (int k = 0; k < 3; ++k)
+                Triangle.insert(Triangle.end(), Corners[(First + k) % 3].begin(), Corners[(First + k) % 3].end());
+            Triangles.push_back(Triangle);
+        }
+        std::sort(Triangles.begin(), Triangles.end());
+        return Triangles;
+    }
+
+    void Run(const char* Name, std::vector<Vertex> Vertices, std::vector<uint32_t> Indices, int Repeat)
+    {
+        const float OverdrawBefore = MeasureOverdraw(Vertices, Indices);
+        const std::vector<std::vector<float>> TrianglesBefore = SortedTriangles(Vertices, Indices);
+
+        // the first run does the work, the rest are for timing
+        std::vector<Vertex> OptimizedVertices = Vertices;
+        std::vector<uint32_t> OptimizedIndices = Indices;
+        const Utility::MeshOptimizeReport Report = Utility::OptimizeMesh(OptimizedVertices, OptimizedIndices, &Vertex::position);
+
+        Test::Timer Timer;
+        for (int i = 0; i < Repeat; ++i)
+        {
+            std::vector<Vertex> V = Vertices;
+            std::vector<uint32_t> I = Indices;
+            Utility::OptimizeMesh(V, I, &Vertex::position);
+        }
+        const double Milliseconds = Repeat > 0 ? Timer.Seconds() * 1000.0 / Repeat : 0.0;
+
+        const float OverdrawAfter = MeasureOverdraw(OptimizedVertices, OptimizedIndices);
+
+        printf("%-8s %6zu tris  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  overfetch %.2f -> %.2f  overdraw %.3f -> %.3f  %.1f ms\n",
+            Name, Indices.size() / 3, Report.Before.ACMR, Report.After.ACMR, Report.Before.ATVR, Report.After.ATVR,
+            Report.Before.Overfetch, Report.After.Overfetch, OverdrawBefore, OverdrawAfter, Milliseconds);
+
+        CHECK(Report.After.ACMR <= Report.Before.ACMR);
+        CHECK(Report.After.ATVR <= Report.Before.ATVR);
+        CHECK(Report.After.Overfetch <= Report.Before.Overfetch);
+        CHECK(OptimizedIndices.size() == Indices.size());
+        CHECK(OptimizedVertices.size() <= Vertices.size());
+        for (uint32_t Index : OptimizedIndices)
+            CHECK(Index < OptimizedVertices.size());
+        CHECK(SortedTriangles(OptimizedVertices, OptimizedIndices) == TrianglesBefore);
+    }
+
+    bool LoadSkull(const char* Path, std::vector<Vertex>& Vertices, std::vector<uint32_t>& Indices)
+    {
+        std::ifstream File(Path);
+        if (!File)
+            return false;
+
+        uint32_t VertexCount = 0, TriangleCount = 0;
+        std::string Ignore;
+        File >> Ignore >> VertexCount >> Ignore >> TriangleCount >> Ignore >> Ignore >> Ignore >> Ignore;
+
+        Vertices.assign(VertexCount, Vertex());
+        for (Vertex& V : Vertices)
+        {
+            File >> V.position.x >> V.position.y >> V.position.z;
+            File >> V.normal.x >> V.normal.y >> V.normal.z;
+        }
+
+        File >> Ignore >> Ignore >> Ignore;
+        Indices.resize(3 * TriangleCount);
+        for (uint32_t& Index : Indices)
+            File >> Index;
+        return (bool)File;
+    }
+
+    // GeometryGenerator::CreateGrid's vertex and index order
+    void BuildGrid(uint32_t Rows, uint32_t Columns, std::vector<Vertex>& Vertices, std::vector<uint32_t>& Indices)
+    {
+        Vertices.assign(Rows * Columns, Vertex());
+        for (uint32_t i = 0; i < Rows; ++i)
+        {
+            for (uint32_t j = 0; j < Columns; ++j)
+            {
+                Vertex& V = Vertices[i * Columns + j];
+                V.position = { -50.0f + j * 100.0f / (Columns - 1), 0.0f, 50.0f - i * 100.0f / (Rows - 1) };
+                V.normal = { 0.0f, 1.0f, 0.0f };
+            }
+        }
+
+        Indices.clear();
+        for (uint32_t i = 0; i + 1 < Rows; ++i)
+        {
+            for (uint32_t j = 0; j + 1 < Columns; ++j)
+            {
+                const uint32_t Quad[6] = { i * Columns + j, i * Columns + j + 1, (i + 1) * Columns + j,
+                    (i + 1) * Columns + j, i * Columns + j + 1, (i + 1) * Columns + j + 1 };
+                Indices.insert(Indices.end(), Quad, Quad + 6);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int Repeat = (int)(10 * Test::GetScale(argc, argv));
+
+    std::vector<Vertex> Vertices;
+    std::vector<uint32_t> Indices;
+
+    CHECK(LoadSkull("../../Models/skull.txt", Vertices, Indices));
+    if (!Vertices.empty())
+        Run("skull", Vertices, Indices, Repeat);
+
+    BuildGrid(100, 100, Vertices, Indices);
+    Run("grid100", Vertices, Indices, Repeat);
+
+    return Test::Finish("BenchMeshOptimizer");
+}
@@ -0,0 +1,91 @@
+#include "TestHarness.h"
+#include "TestMeshes.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// What cluster culling saves: the share of triangles CullMeshlets rejects before the draw, on
+// average over random views orbiting each mesh, close up to it and inside its bounds, and how
+// many of the rejected meshlets went for facing away rather than for leaving the frustum.
+// Also times BuildMeshlets and CullMeshlets. Meshes are reordered for the vertex cache first,
+// as BuildSubmeshMeshlets gets them.
+
+using Test::Float3;
+
+namespace
+{
+    void Run(const char* Name, const std::vector<Float3>& Positions, std::vector<uint32_t> Indices, int ViewsPerKind)
+    {
+        std::vector<uint32_t> Reordered(Indices.size());
+        Utility::OptimizeVertexCache(Reordered.data(), Indices.data(), Indices.size(), Positions.size());
+        Indices.swap(Reordered);
+
+        Test::Timer BuildTimer;
+        Utility::MeshletMesh Mesh;
+        Utility::BuildMeshlets(Mesh, Indices.data(), Indices.size(), &Positions[0].x, sizeof(Float3), Positions.size());
+        const double BuildMilliseconds = BuildTimer.Seconds() * 1000.0;
+
+        printf("%-8s %6zu tris -> %5zu meshlets, %.1f tris each, built in %.1f ms\n", Name, Indices.size() / 3,
+            Mesh.Meshlets.size(), (double)Indices.size() / 3 / Mesh.Meshlets.size(), BuildMilliseconds);
+        CHECK(!Mesh.Meshlets.empty());
+
+        Float3 Center;
+        float Radius;
+        Test::BoundingSphere(Positions, Center, Radius);
+
+        std::mt19937 Random(7);
+        std::vector<uint32_t> Culled(Indices.size());
+        const char* KindNames[] = { "orbit", "close-up", "inside" };
+
+        for (Test::ViewKind Kind : { Test::ViewKind::Orbit, Test::ViewKind::CloseUp, Test::ViewKind::Inside })
+        {
+            double Rejected = 0.0, Seconds = 0.0;
+            Utility::MeshletCullStats Total = {};
+            for (int View = 0; View < ViewsPerKind; ++View)
+            {
+                Float3 Eye;
+                float Matrix[16], Planes[6][4];
+                Test::RandomView(Kind, Random, Center, Radius, Eye, Matrix);
+                Utility::ExtractFrustumPlanes(Matrix, Planes);
+
+                Test::Timer CullTimer;
+                Utility::MeshletCullStats Stats = {};
+                const size_t Count = Utility::CullMeshlets(Mesh, Planes, &Eye.x, Culled.data(), Stats);
+                Seconds += CullTimer.Seconds();
+
+                CHECK(Count == (Stats.Triangles - Stats.TrianglesRejected) * 3);
+                Rejected += (double)Stats.TrianglesRejected / Stats.Triangles;
+                Total.Meshlets += Stats.Meshlets;
+                Total.BackFacing += Stats.BackFacing;
+                Total.OutsideFrustum += Stats.OutsideFrustum;
+            }
+
+            const uint32_t Culls = Total.BackFacing + Total.OutsideFrustum;
+            printf("  %-8s %5.1f%% of triangles rejected, %5.1f%% of those meshlets back-facing, %.3f ms per cull\n",
+                KindNames[(int)Kind], 100.0 * Rejected / ViewsPerKind, Culls != 0 ? 100.0 * Total.BackFacing / Culls : 0.0,
+                Seconds * 1000.0 / ViewsPerKind);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int ViewsPerKind = std::max(1, (int)(256 * Test::GetScale(argc, argv)));
+
+    std::vector<Float3> Positions;
+    std::vector<uint32_t> Indices;
+
+    CHECK(Test::LoadTextModel("../../Models/skull.txt", Positions, Indices));
+    if (!Positions.empty())
+        Run("skull", Positions, Indices, ViewsPerKind);
+
+    Test::BuildSphere(0.5f, 40, 40, Positions, Indices);
+    Run("sphere", Positions, Indices, ViewsPerKind);
+
+    Test::BuildHills(100, 100, Positions, Indices);
+    Run("hills", Positions, Indices, ViewsPerKind);
+
+    return Test::Finish("BenchMeshletCulling");
+}
@@ -0,0 +1,154 @@
+#include "TestHarness.h"
+#include "NullDevice.h"
+#include "GraphicsCore.h"
+#include "CommandListManager.h"
+#include "LinearAllocator.h"
+#include "ObjectConstants.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+// Object constants for 10k render items through the LinearAllocator GameApp uses, on the null
+// device: one 256-byte aligned block per draw, the way DrawRenderItems used to, against one
+// block for every item, the way UploadObjectConstants does. Both pack with
+// PackObjectConstants and write the same bytes. Pages retire against the graphics queue fence
+// once a frame.
+
+namespace
+{
+    // The matrices of a RenderItem, row-major and 16-byte aligned like XMMATRIX
+    struct Item
+    {
+        alignas(16) float World[16];
+        alignas(16) float TexTransform[16];
+        alignas(16) float MatTransform[16];
+        uint32_t MaterialIndex;
+        float PositionScale[3];
+        float PositionBias[3];
+    };
+
+    Utility::ObjectConstantsSource SourceOf(const Item& I, uint32_t Slot)
+    {
+        return { I.World, I.TexTransform, I.MatTransform, I.PositionScale, I.PositionBias, I.MaterialIndex, Slot };
+    }
+
+    // One allocation per item
+    void PerDraw(const std::vector<Item>& Items, LinearAllocator& Allocator, Utility::PackedObjectConstants** Blocks)
+    {
+        for (size_t i = 0; i < Items.size(); ++i)
+        {
+            Blocks[i] = (Utility::PackedObjectConstants*)Allocator.Allocate(sizeof(Utility::PackedObjectConstants)).DataPtr;
+            Utility::ObjectConstantsSource Source = SourceOf(Items[i], 0);
+            Utility::PackObjectConstants(Blocks[i], &Source, 1);
+        }
+    }
+
+    // One allocation for all items, sources gathered a chunk at a time as UploadObjectConstants does
+    Utility::PackedObjectConstants* OneBlock(const std::vector<Item>& Items, LinearAllocator& Allocator)
+    {
+        Utility::PackedObjectConstants* Objects =
+            (Utility::PackedObjectConstants*)Allocator.Allocate(Items.size() * sizeof(Utility::PackedObjectConstants)).DataPtr;
+
+        const size_t Chunk = 64;
+        Utility::ObjectConstantsSource Sources[Chunk];
+        for (size_t First = 0; First < Items.size(); First += Chunk)
+        {
+            const size_t Last = std::min(First + Chunk, Items.size());
+            for (size_t i = First; i < Last; ++i)
+                Sources[i - First] = SourceOf(Items[i], (uint32_t)i);
+            Utility::PackObjectConstants(Objects, Sources, Last - First);
+        }
+        return Objects;
+    }
+
+    bool IsTransposed(const float* Row, const float* Column)
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                if (Column[c * 4 + r] != Row[r * 4 + c])
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    void EndFrame(LinearAllocator& Allocator)
+    {
+        Allocator.CleanupUsedPages(Graphics::g_CommandManager.GetGraphicsQueue().IncrementFence());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const double Scale = Test::GetScale(argc, argv);
+    const size_t NumItems = 10000;
+    const int NumFrames = std::max(1, (int)(200 * Scale));
+
+    std::mt19937 Rng(7);
+    std::uniform_real_distribution<float> Dist(-10.0f, 10.0f);
+    std::vector<Item> Items(NumItems);
+    for (Item& I : Items)
+    {
+        for (int k = 0; k < 16; ++k)
+        {
+            I.World[k] = Dist(Rng);
+            I.TexTransform[k] = Dist(Rng);
+            I.MatTransform[k] = Dist(Rng);
+        }
+        I.MaterialIndex = Rng() % 32;
+        for (int k = 0; k < 3; ++k)
+        {
+            I.PositionScale[k] = Dist(Rng);
+            I.PositionBias[k] = Dist(Rng);
+        }
+    }
+
+    Graphics::Initialize(false);
+    {
+        LinearAllocator Allocator(kCpuWritable);
+        std::vector<Utility::PackedObjectConstants*> Blocks(NumItems);
+
+        // both write the same constants, the ones the shaders expect
+        PerDraw(Items, Allocator, Blocks.data());
+        const Utility::PackedObjectConstants* Objects = OneBlock(Items, Allocator);
+        for (size_t i = 0; i < NumItems; ++i)
+        {
+            CHECK(memcmp(Blocks[i], &Objects[i], sizeof(Utility::PackedObjectConstants)) == 0);
+            CHECK(IsTransposed(Items[i].World, Objects[i].World));
+            CHECK(IsTransposed(Items[i].TexTransform, Objects[i].TexTransform));
+            CHECK(IsTransposed(Items[i].MatTransform, Objects[i].MatTransform));
+            CHECK(Objects[i].MaterialIndex == Items[i].MaterialIndex);
+            CHECK(Objects[i].PositionScale[2] == Items[i].PositionScale[2] && Objects[i].PositionScale[3] == 0.0f);
+            CHECK(Objects[i].PositionBias[2] == Items[i].PositionBias[2] && Objects[i].PositionBias[3] == 0.0f);
+        }
+        EndFrame(Allocator);
+
+        auto Measure = [&](auto&& Frame)
+        {
+            Test::Timer Timer;
+            for (int i = 0; i < NumFrames; ++i)
+            {
+                Frame();
+                EndFrame(Allocator);
+            }
+            return Timer.Seconds() * 1e9 / ((double)NumItems * NumFrames);
+        };
+
+        const double PerDrawNs = Measure([&] { PerDraw(Items, Allocator, Blocks.data()); });
+        const double OneBlockNs = Measure([&] { OneBlock(Items, Allocator); });
+
+        PagePool::Stats Stats = LinearAllocator::GetStats(kCpuWritable);
+        printf("%zu items, %d frames\n", NumItems, NumFrames);
+        printf("  per draw:   %6.1f ns/item, %zu allocations/frame, %zu bytes/frame\n", PerDrawNs, NumItems,
+            NumItems * 256);
+        printf("  one block:  %6.1f ns/item, 1 allocation/frame, %zu bytes/frame\n", OneBlockNs,
+            NumItems * sizeof(Utility::PackedObjectConstants));
+        printf("  pages alive: %u, peak %u, large pages created: %u\n", Stats.NumPages, Stats.PeakPages,
+            Stats.LargePagesCreated);
+    }
+    Graphics::Shutdown();
+
+    return Test::Finish("BenchObjectConstants");
+}
@@ -0,0 +1,320 @@
+#include "TestHarness.h"
+#include "PagePool.h"
+#include "NullFence.h"
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+// The page traffic behind SetDynamicConstantBufferView: recording threads bump-allocate
+// 256-byte constant buffers out of LinearAllocator pages, ask for a large page every 2000
+// allocations, and retire everything at the end of a 1000-allocation context. Run against
+// the mutex-guarded LinearAllocatorPageManager this tree used to have and against PagePool,
+// from 1 to 16 threads.
+//
+// Wall time only shows serialization on a machine with as many cores as threads, so the
+// benchmark also counts how often each pool takes its mutex, and how often a thread found it
+// already held. The first is what serializes recording threads regardless of core count.
+// Pages are checked out and in as they go, so a page handed to two contexts at once or
+// reused before its fence fails a check.
+
+namespace
+{
+    const uint32_t kFrameLag = 2;
+
+    NullFence s_Fence(0, false);
+    std::atomic<uint64_t> s_NextFence{ 1 };
+
+    bool IsComplete(uint64_t FenceValue)
+    {
+        return FenceValue <= s_Fence.GetCompletedValue();
+    }
+
+    uint64_t EndContext(void)
+    {
+        const uint64_t Value = s_NextFence.fetch_add(1);
+        s_Fence.Signal(Value);
+        if (Value > kFrameLag)
+            s_Fence.Complete(Value - kFrameLag);
+        return Value;
+    }
+
+    struct MockPage : public PoolPage
+    {
+        std::atomic<int> Owned{ 0 };
+        uint64_t FreedAt = 0;
+        char Bytes[64];
+    };
+
+    void CheckOut(MockPage* Page)
+    {
+        CHECK(Page->Owned.exchange(1) == 0);
+        CHECK(IsComplete(Page->FreedAt));
+    }
+
+    void CheckIn(MockPage* Page, uint64_t FenceValue)
+    {
+        Page->FreedAt = FenceValue;
+        CHECK(Page->Owned.exchange(0) == 1);
+    }
+
+    struct LockCounts
+    {
+        std::atomic<uint64_t> Acquired{ 0 };
+        std::atomic<uint64_t> Contended{ 0 };
+        std::atomic<uint32_t> PagesCreated{ 0 };
+    };
+
+    // LinearAllocatorPageManager before PagePool: one mutex around every request and discard,
+    // large pages created for each request and deleted after their fence
+    class LockedPageManager
+    {
+    public:
+        explicit LockedPageManager(size_t PageSize) : m_PageSize(PageSize) {}
+
+        ~LockedPageManager()
+        {
+            while (!m_DeletionQueue.empty())
+            {
+                delete m_DeletionQueue.front().second;
+                m_DeletionQueue.pop();
+            }
+        }
+
+        MockPage* RequestPage(void)
+        {
+            std::unique_lock<std::mutex> Lock = Acquire();
+
+            while (!m_RetiredPages.empty() && IsComplete(m_RetiredPages.front().first))
+            {
+                m_AvailablePages.push(m_RetiredPages.front().second);
+                m_RetiredPages.pop();
+            }
+
+            if (!m_AvailablePages.empty())
+            {
+                MockPage* Page = m_AvailablePages.front();
+                m_AvailablePages.pop();
+                return Page;
+            }
+
+            m_PagePool.emplace_back(CreatePage(m_PageSize));
+            return m_PagePool.back().get();
+        }
+
+        MockPage* RequestLargePage(size_t Size)
+        {
+            return CreatePage(Size);
+        }
+
+        void DiscardPages(uint64_t FenceValue, const std::vector<MockPage*>& Pages, const std::vector<MockPage*>& LargePages)
+        {
+            {
+                std::unique_lock<std::mutex> Lock = Acquire();
+                for (MockPage* Page : Pages)
+                    m_RetiredPages.push(std::make_pair(FenceValue, Page));
+            }
+
+            std::unique_lock<std::mutex> Lock = Acquire();
+            while (!m_DeletionQueue.empty() && IsComplete(m_DeletionQueue.front().first))
+            {
+                delete m_DeletionQueue.front().second;
+                m_DeletionQueue.pop();
+            }
+            for (MockPage* Page : LargePages)
+                m_DeletionQueue.push(std::make_pair(FenceValue, Page));
+        }
+
+        LockCounts Counts;
+
+    private:
+        std::unique_lock<std::mutex> Acquire(void)
+        {
+            ++Counts.Acquired;
+            std::unique_lock<std::mutex> Lock(m_Mutex, std::try_to_lock);
+            if (!Lock.owns_lock())
+            {
+                ++Counts.Contended;
+                Lock.lock();
+            }
+            return Lock;
+        }
+
+        MockPage* CreatePage(size_t Size)
+        {
+            ++Counts.PagesCreated;
+            MockPage* Page = new MockPage;
+            Page->m_PageSize = Size;
+            return Page;
+        }
+
+        const size_t m_PageSize;
+        std::mutex m_Mutex;
+        std::vector<std::unique_ptr<MockPage>> m_PagePool;
+        std::queue<std::pair<uint64_t, MockPage*>> m_RetiredPages;
+        std::queue<std::pair<uint64_t, MockPage*>> m_DeletionQueue;
+        std::queue<MockPage*> m_AvailablePages;
+    };
+
+    // PagePool takes its mutex to create or destroy a page, and once per thread to set up its
+    // cache. The hooks count the first two; whether the mutex was held cannot be seen here.
+    class MockPagePool : public PagePool
+    {
+    public:
+        explicit MockPagePool(size_t PageSize) : PagePool(PageSize) {}
+        ~MockPagePool() { Destroy(); }
+
+        MockPage* RequestPage(void) { return static_cast<MockPage*>(PagePool::RequestPage()); }
+        MockPage* RequestLargePage(size_t Size) { return static_cast<MockPage*>(PagePool::RequestLargePage(Size)); }
+
+        void DiscardPages(uint64_t FenceValue, const std::vector<MockPage*>& Pages, const std::vector<MockPage*>& LargePages)
+        {
+            PoolPage* Head = nullptr;
+            for (MockPage* Page : Pages)
+            {
+                Page->m_NextPooled = Head;
+                Head = Page;
+            }
+            for (MockPage* Page : LargePages)
+            {
+                Page->m_NextPooled = Head;
+                Head = Page;
+            }
+            if (Head != nullptr)
+                PagePool::DiscardPages(FenceValue, Head);
+        }
+
+        LockCounts Counts;
+
+    protected:
+        virtual PoolPage* CreatePage(size_t) override
+        {
+            ++Counts.Acquired;
+            ++Counts.PagesCreated;
+            return new MockPage;
+        }
+
+        virtual void DestroyPage(PoolPage* Page) override
+        {
+            ++Counts.Acquired;
+            delete static_cast<MockPage*>(Page);
+        }
+
+        virtual bool IsFenceComplete(uint64_t FenceValue) override { return IsComplete(FenceValue); }
+    };
+
+    // One recording thread: LinearAllocator::Allocate, one context after another
+    template <typename PageManager>
+    void Record(PageManager& Manager, size_t PageSize, int NumAllocations, uint32_t Seed)
+    {
+        std::mt19937 Rng(Seed);
+        MockPage* CurPage = nullptr;
+        size_t CurOffset = PageSize;
+        std::vector<MockPage*> RetiredPages;
+        std::vector<MockPage*> LargePages;
+        size_t Sink = 0;
+
+        for (int i = 1; i <= NumAllocations; ++i)
+        {
+            if (i % 2000 == 0)
+            {
+                const size_t Size = PageSize + 1 + Rng() % (4 * PageSize);
+                MockPage* Page = Manager.RequestLargePage(Size);
+                CheckOut(Page);
+                LargePages.push_back(Page);
+            }
+
+            if (CurOffset + 256 > PageSize)
+            {
+                if (CurPage != nullptr)
+                    RetiredPages.push_back(CurPage);
+                CurPage = Manager.RequestPage();
+                CheckOut(CurPage);
+                CurOffset = 0;
+            }
+            Sink += (size_t)CurPage->Bytes + CurOffset;
+            CurOffset += 256;
+
+            if (i % 1000 == 0)
+            {
+                RetiredPages.push_back(CurPage);
+                CurPage = nullptr;
+                CurOffset = PageSize;
+
+                const uint64_t FenceValue = EndContext();
+                for (MockPage* Page : RetiredPages)
+                    CheckIn(Page, FenceValue);
+                for (MockPage* Page : LargePages)
+                    CheckIn(Page, FenceValue);
+                Manager.DiscardPages(FenceValue, RetiredPages, LargePages);
+                RetiredPages.clear();
+                LargePages.clear();
+            }
+        }
+
+        if (Sink == 1)
+            printf(" ");
+    }
+
+    struct Result
+    {
+        double NsPerAllocation;
+        double LocksPer1000;
+        uint64_t LocksAcquired;
+        uint64_t LocksContended;
+        uint32_t PagesCreated;
+    };
+
+    template <typename PageManager>
+    Result Run(int NumThreads, int NumAllocations, size_t PageSize)
+    {
+        PageManager Manager(PageSize);
+
+        Test::Timer Timer;
+        std::vector<std::thread> Threads;
+        const int PerThread = NumAllocations / NumThreads / 1000 * 1000;
+        for (int t = 0; t < NumThreads; ++t)
+            Threads.emplace_back([&, t] { Record(Manager, PageSize, PerThread, t + 1); });
+        for (std::thread& Thread : Threads)
+            Thread.join();
+
+        Result Res;
+        Res.NsPerAllocation = Timer.Seconds() * 1e9 / ((double)PerThread * NumThreads);
+        Res.LocksPer1000 = Manager.Counts.Acquired * 1000.0 / ((double)PerThread * NumThreads);
+        Res.LocksAcquired = Manager.Counts.Acquired;
+        Res.LocksContended = Manager.Counts.Contended;
+        Res.PagesCreated = Manager.Counts.PagesCreated;
+        return Res;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int NumAllocations = (int)(4000000 * Test::GetScale(argc, argv));
+
+    printf("%d 256-byte allocations per run, %u hardware threads\n", NumAllocations, std::thread::hardware_concurrency());
+    printf("                         ------------ mutex ------------   ------------ PagePool ------------\n");
+    printf("page    threads         ns/alloc  locks/1k  contended  pages   ns/alloc  locks/1k  pages\n");
+
+    for (size_t PageSize : { (size_t)0x10000, (size_t)0x200000 })
+    {
+        for (int NumThreads : { 1, 2, 4, 8, 16 })
+        {
+            const Result Locked = Run<LockedPageManager>(NumThreads, NumAllocations, PageSize);
+            const Result Pooled = Run<MockPagePool>(NumThreads, NumAllocations, PageSize);
+            printf("%4zu KB  %2d        %8.2f  %8.3f  %9llu  %5u   %8.2f  %8.3f  %5u\n",
+                PageSize >> 10, NumThreads,
+                Locked.NsPerAllocation, Locked.LocksPer1000, (unsigned long long)Locked.LocksContended, Locked.PagesCreated,
+                Pooled.NsPerAllocation, Pooled.LocksPer1000, Pooled.PagesCreated);
+
+            // PagePool creates pages only as the working set needs them, so it takes its
+            // mutex far less often than once per page request
+            CHECK(Pooled.LocksAcquired < Locked.LocksAcquired);
+            CHECK(Pooled.PagesCreated <= Locked.PagesCreated);
+        }
+    }
+
+    return Test::Finish("BenchPagePool");
+}
@@ -0,0 +1,162 @@
+#include "TestHarness.h"
+#include "Waves.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// One simulation step and its normals, per grid cell, against the solver Waves replaced: whole
+// XMFLOAT3 vertices for both solutions, scalar loops, normals and tangents normalised one at a
+// time. The baseline is split over rows on the same ThreadPool, so the difference is the
+// layout and the kernels. The grids start from the same disturbances and must stay together.
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+    const float kSpatialStep = 0.25f;
+    const float kTimeStep = 0.03f;
+    const float kSpeed = 3.25f;
+    const float kDamping = 0.4f;
+
+    class ScalarWaves
+    {
+    public:
+        ScalarWaves(int m, int n) : m_NumRows(m), m_NumCols(n), m_Prev(m * n), m_Curr(m * n),
+            m_Normals(m * n, XMFLOAT3(0.0f, 1.0f, 0.0f)), m_TangentX(m * n, XMFLOAT3(1.0f, 0.0f, 0.0f))
+        {
+            float d = kDamping * kTimeStep + 2.0f;
+            float e = (kSpeed * kSpeed) * (kTimeStep * kTimeStep) / (kSpatialStep * kSpatialStep);
+            m_K1 = (kDamping * kTimeStep - 2.0f) / d;
+            m_K2 = (4.0f - 8.0f * e) / d;
+            m_K3 = (2.0f * e) / d;
+
+            for (XMFLOAT3& Vertex : m_Prev)
+                Vertex = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            m_Curr = m_Prev;
+        }
+
+        void Disturb(int i, int j, float Magnitude)
+        {
+            float HalfMag = 0.5f * Magnitude;
+            m_Curr[i * m_NumCols + j].y += Magnitude;
+            m_Curr[i * m_NumCols + j + 1].y += HalfMag;
+            m_Curr[i * m_NumCols + j - 1].y += HalfMag;
+            m_Curr[(i + 1) * m_NumCols + j].y += HalfMag;
+            m_Curr[(i - 1) * m_NumCols + j].y += HalfMag;
+        }
+
+        void Step(void)
+        {
+            const int n = m_NumCols;
+            ThreadPool::ParallelForRange(1, m_NumRows - 1, [this, n](int RowBegin, int RowEnd)
+            {
+                for (int i = RowBegin; i < RowEnd; ++i)
+                {
+                    for (int j = 1; j < n - 1; ++j)
+                    {
+                        m_Prev[i * n + j].y =
+                            m_K1 * m_Prev[i * n + j].y +
+                            m_K2 * m_Curr[i * n + j].y +
+                            m_K3 * (m_Curr[(i + 1) * n + j].y +
+                                m_Curr[(i - 1) * n + j].y +
+                                m_Curr[i * n + j + 1].y +
+                                m_Curr[i * n + j - 1].y);
+                    }
+                }
+            }, Grain());
+
+            std::swap(m_Prev, m_Curr);
+
+            ThreadPool::ParallelForRange(1, m_NumRows - 1, [this, n](int RowBegin, int RowEnd)
+            {
+                for (int i = RowBegin; i < RowEnd; ++i)
+                {
+                    for (int j = 1; j < n - 1; ++j)
+                    {
+                        float l = m_Curr[i * n + j - 1].y;
+                        float r = m_Curr[i * n + j + 1].y;
+                        float t = m_Curr[(i - 1) * n + j].y;
+                        float b = m_Curr[(i + 1) * n + j].y;
+                        m_Normals[i * n + j] = Normalize(XMFLOAT3(-r + l, 2.0f * kSpatialStep, b - t));
+                        m_TangentX[i * n + j] = Normalize(XMFLOAT3(2.0f * kSpatialStep, r - l, 0.0f));
+                    }
+                }
+            }, Grain());
+        }
+
+        float Height(int i) const { return m_Curr[i].y; }
+
+    private:
+        static XMFLOAT3 Normalize(XMFLOAT3 v)
+        {
+            float Inv = 1.0f / sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+            return XMFLOAT3(v.x * Inv, v.y * Inv, v.z * Inv);
+        }
+
+        int Grain(void) const { return std::max(1, 4096 / m_NumCols); }
+
+        int m_NumRows;
+        int m_NumCols;
+        float m_K1, m_K2, m_K3;
+        std::vector<XMFLOAT3> m_Prev;
+        std::vector<XMFLOAT3> m_Curr;
+        std::vector<XMFLOAT3> m_Normals;
+        std::vector<XMFLOAT3> m_TangentX;
+    };
+
+    // A few drops away from the boundary, the same on both solvers
+    template <typename Solver>
+    void DisturbGrid(Solver& Grid, int Size)
+    {
+        for (int k = 1; k <= 4; ++k)
+            Grid.Disturb(Size * k / 5, Size * (5 - k) / 5, 0.5f);
+    }
+
+    void Run(int Size, double Scale)
+    {
+        const double Cells = (double)Size * Size;
+        const int Steps = std::max(2, (int)(Scale * 2e8 / Cells));
+
+        ScalarWaves Baseline(Size, Size);
+        DisturbGrid(Baseline, Size);
+        Test::Timer BaselineTimer;
+        for (int s = 0; s < Steps; ++s)
+            Baseline.Step();
+        const double BaselineNs = BaselineTimer.Seconds() * 1e9 / (Steps * Cells);
+
+        // every Update covers exactly one step, and publishes its normals
+        Waves Grid(Size, Size, kSpatialStep, kTimeStep, kSpeed, kDamping);
+        DisturbGrid(Grid, Size);
+        Test::Timer WavesTimer;
+        int Taken = 0;
+        for (int s = 0; s < Steps; ++s)
+            Taken += Grid.Update(kTimeStep);
+        const double WavesNs = WavesTimer.Seconds() * 1e9 / (Steps * Cells);
+        CHECK(Taken == Steps);
+
+        // the sums are grouped differently, so allow for rounding
+        float MaxDiff = 0.0f, MaxHeight = 0.0f;
+        for (int i = 0; i < Size * Size; ++i)
+        {
+            MaxDiff = std::max(MaxDiff, fabsf(Grid.Heights()[i] - Baseline.Height(i)));
+            MaxHeight = std::max(MaxHeight, fabsf(Baseline.Height(i)));
+        }
+        CHECK(MaxDiff <= 1e-4f * std::max(1.0f, MaxHeight));
+
+        printf("%4d x %-4d %5d steps  scalar AoS %6.2f ns/cell  Waves %6.2f ns/cell  %5.2fx\n", Size, Size, Steps,
+            BaselineNs, WavesNs, BaselineNs / WavesNs);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const double Scale = Test::GetScale(argc, argv);
+
+    printf("Waves kernels: %s, %u workers\n", Waves::GetKernelName(), ThreadPool::GetWorkerCount());
+    Run(128, Scale);
+    Run(512, Scale);
+    Run(2048, Scale);
+
+    return Test::Finish("BenchWaves");
+}
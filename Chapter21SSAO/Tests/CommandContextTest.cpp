@@ -0,0 +1,215 @@
+#include "TestHarness.h"
+#include "NullDevice.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "CommandListManager.h"
+#include "GpuBuffer.h"
+#include "LinearAllocator.h"
+#include "RootSignature.h"
+#include <set>
+#include <vector>
+
+// CommandContext on the null device, from Graphics::Initialize to Shutdown: what reaches the
+// queue, when the upload pages it used come back, and what the dynamic descriptor heap copies
+// into the shader-visible heap. Queues execute as soon as a list is submitted, and pausing the
+// device holds back their fence signals, the way a GPU running behind would.
+
+namespace
+{
+    NullDevice& GetNullDevice(void)
+    {
+        return *static_cast<NullDevice*>(Graphics::g_Device);
+    }
+
+    NullResource* AsNullResource(ID3D12Resource* pResource)
+    {
+        return static_cast<NullResource*>(pResource);
+    }
+}
+
+static void TestInitializeBuffer(void)
+{
+    const uint32_t kNumElements = 256;
+    std::vector<uint32_t> Data(kNumElements);
+    for (uint32_t i = 0; i < kNumElements; ++i)
+        Data[i] = i * 2654435761u;
+
+    NullCommandStats Before = GetNullDevice().GetExecutedStats();
+
+    ByteAddressBuffer Buffer;
+    Buffer.Create(L"Initialized Buffer", kNumElements, sizeof(uint32_t), Data.data());
+
+    // the bytes arrive through one copy from an upload page, between two barriers
+    NullResource* Resource = AsNullResource(Buffer.GetResource());
+    CHECK(Resource->GetHeapType() == D3D12_HEAP_TYPE_DEFAULT);
+    CHECK(memcmp(Resource->GetMemory(), Data.data(), kNumElements * sizeof(uint32_t)) == 0);
+
+    NullCommandStats After = GetNullDevice().GetExecutedStats();
+    CHECK(After.ExecutedLists == Before.ExecutedLists + 1);
+    CHECK(After.BufferCopies == Before.BufferCopies + 1);
+    CHECK(After.BytesCopied == Before.BytesCopied + kNumElements * sizeof(uint32_t));
+    CHECK(After.Barriers == Before.Barriers + 2);
+
+    // the views the buffer made describe it
+    NullDescriptor& SRV = NullDevice::GetDescriptor(Buffer.GetSRV());
+    CHECK(SRV.Kind == NullDescriptor::kSRV);
+    CHECK(SRV.Resource == Resource);
+    CHECK(NullDevice::GetDescriptor(Buffer.GetUAV()).Kind == NullDescriptor::kUAV);
+
+    int Live = GetNullDevice().GetLiveResources();
+    Buffer.Destroy();
+    CHECK(GetNullDevice().GetLiveResources() == Live - 1);
+}
+
+static void TestBarrierBatching(void)
+{
+    ByteAddressBuffer Buffer;
+    Buffer.Create(L"Barrier Buffer", 64, 4);
+
+    NullCommandStats Before = GetNullDevice().GetExecutedStats();
+    CommandContext::GetStateChangeStats(true);
+
+    // transitions queue up until something needs them, then go out in one call, and one to the
+    // state a resource is already in costs nothing
+    CommandContext& Context = CommandContext::Begin(L"Barriers");
+    Context.TransitionResource(Buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+    Context.TransitionResource(Buffer, D3D12_RESOURCE_STATE_COPY_DEST);
+    Context.TransitionResource(Buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(Buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.Finish(true);
+
+    NullCommandStats After = GetNullDevice().GetExecutedStats();
+    CHECK(After.ExecutedLists == Before.ExecutedLists + 1);
+    CHECK(After.Barriers == Before.Barriers + 2);
+    CHECK(After.BarrierCalls == Before.BarrierCalls + 1);
+
+    // the context counts what the list received
+    StateChangeStats Counted = CommandContext::GetStateChangeStats(true);
+    CHECK(Counted.Barriers == 2);
+    CHECK(Counted.BarrierCalls == 1);
+}
+
+// Pages a context retired come back once the fence it was submitted with completes, not before
+static void TestUploadPageRecycling(void)
+{
+    const int kFrames = 3;
+
+    GetNullDevice().SetGpuPaused(true);
+
+    std::set<ID3D12Resource*> PagesInFlight;
+    for (int Frame = 0; Frame < kFrames; ++Frame)
+    {
+        CommandContext& Context = CommandContext::Begin(L"Upload");
+        DynAlloc Upload = Context.ReserveUploadMemory(kCpuAllocatorPageSize);
+        memset(Upload.DataPtr, Frame, Upload.Size);
+        PagesInFlight.insert(Upload.Buffer.GetResource());
+        Context.Finish(false);
+    }
+    CHECK(PagesInFlight.size() == kFrames);
+
+    PagePool::Stats Stats = LinearAllocator::GetStats(kCpuWritable);
+    CHECK(Stats.NumPages >= (uint32_t)kFrames);
+    CHECK(Stats.PagesInUse == 0);
+
+    GetNullDevice().SetGpuPaused(false);
+    Graphics::g_CommandManager.IdleGPU();
+
+    // the next frames find every page they need in the pool
+    for (int Frame = 0; Frame < kFrames; ++Frame)
+    {
+        CommandContext& Context = CommandContext::Begin(L"Upload");
+        Context.ReserveUploadMemory(kCpuAllocatorPageSize);
+        Context.Finish(true);
+    }
+    CHECK(LinearAllocator::GetStats(kCpuWritable).NumPages == Stats.NumPages);
+
+    // larger than a page goes to its own page, which is recycled by size
+    {
+        CommandContext& Context = CommandContext::Begin(L"Large Upload");
+        Context.ReserveUploadMemory(kCpuAllocatorPageSize + 1);
+        Context.Finish(true);
+    }
+    uint32_t LargeCreated = LinearAllocator::GetStats(kCpuWritable).LargePagesCreated;
+    {
+        CommandContext& Context = CommandContext::Begin(L"Large Upload");
+        Context.ReserveUploadMemory(kCpuAllocatorPageSize + 1);
+        Context.Finish(true);
+    }
+    CHECK(LinearAllocator::GetStats(kCpuWritable).LargePagesCreated == LargeCreated);
+}
+
+// Staged CPU descriptors are copied into the shader-visible heap when the dispatch needs them,
+// and the table handed to the command list points at the copies
+static void TestDynamicDescriptors(void)
+{
+    const UINT kTableSize = 4;
+
+    RootSignature RootSig;
+    RootSig.Reset(2, 0);
+    RootSig[0].InitAsConstants(0, 4);
+    RootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, kTableSize);
+    RootSig.Finalize(L"Dynamic Descriptor Test");
+
+    ByteAddressBuffer Buffers[kTableSize + 1];
+    D3D12_CPU_DESCRIPTOR_HANDLE Handles[kTableSize];
+    for (UINT i = 0; i <= kTableSize; ++i)
+        Buffers[i].Create(L"Table Buffer", 64, 4);
+    for (UINT i = 0; i < kTableSize; ++i)
+        Handles[i] = Buffers[i].GetSRV();
+
+    ComputeContext& Context = ComputeContext::Begin(L"Descriptors");
+    NullCommandList* CommandList = static_cast<NullCommandList*>(Context.GetCommandList());
+
+    Context.SetRootSignature(RootSig);
+    Context.SetDynamicDescriptors(1, 0, kTableSize, Handles);
+    CHECK(CommandList->GetComputeTable(1).ptr == 0);
+    Context.Dispatch(1, 1, 1);
+
+    D3D12_GPU_DESCRIPTOR_HANDLE Table = CommandList->GetComputeTable(1);
+    CHECK(Table.ptr != 0);
+    for (UINT i = 0; i < kTableSize; ++i)
+    {
+        D3D12_GPU_DESCRIPTOR_HANDLE Entry = { Table.ptr + i * NullDevice::kDescriptorSize };
+        NullDescriptor& Copy = NullDevice::GetDescriptor(Entry);
+        CHECK(Copy.Kind == NullDescriptor::kSRV);
+        CHECK(Copy.Resource == Buffers[i].GetResource());
+        CHECK(&Copy != &NullDevice::GetDescriptor(Handles[i]));
+    }
+
+    // replacing one entry copies the table again, the old copy stays as it was for the GPU
+    Context.SetDynamicDescriptor(1, 2, Buffers[kTableSize].GetSRV());
+    Context.Dispatch(1, 1, 1);
+
+    D3D12_GPU_DESCRIPTOR_HANDLE NewTable = CommandList->GetComputeTable(1);
+    CHECK(NewTable.ptr != Table.ptr);
+    CHECK(NullDevice::GetDescriptor(D3D12_GPU_DESCRIPTOR_HANDLE{ NewTable.ptr + 2 * NullDevice::kDescriptorSize }).Resource ==
+        Buffers[kTableSize].GetResource());
+    CHECK(NullDevice::GetDescriptor(D3D12_GPU_DESCRIPTOR_HANDLE{ NewTable.ptr + 1 * NullDevice::kDescriptorSize }).Resource ==
+        Buffers[1].GetResource());
+    CHECK(NullDevice::GetDescriptor(D3D12_GPU_DESCRIPTOR_HANDLE{ Table.ptr + 2 * NullDevice::kDescriptorSize }).Resource ==
+        Buffers[2].GetResource());
+
+    NullCommandStats Before = GetNullDevice().GetExecutedStats();
+    Context.Finish(true);
+    CHECK(GetNullDevice().GetExecutedStats().Dispatches == Before.Dispatches + 2);
+}
+
+int main(void)
+{
+    Graphics::Initialize(false);
+
+    // kept past Shutdown to see that everything made on it was released
+    NullDevice* Device = &GetNullDevice();
+    Device->AddRef();
+
+    TestInitializeBuffer();
+    TestBarrierBatching();
+    TestUploadPageRecycling();
+    TestDynamicDescriptors();
+
+    Graphics::Shutdown();
+    CHECK(Device->GetLiveResources() == 0);
+    Device->Release();
+
+    return Test::Finish("CommandContextTest");
+}
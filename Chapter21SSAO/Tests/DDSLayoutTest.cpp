@@ -0,0 +1,161 @@
+#include "TestHarness.h"
+#include "DDSLayout.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// GetDDSTextureLayout over every texture the samples ship, in textures/ at the top of the
+// repository or the directory given on the command line. The layout must cover each file
+// exactly, mip by mip, and agree with GetSurfaceInfo; damaged copies must be rejected.
+
+static std::vector<uint8_t> ReadFile(const std::filesystem::path& Path)
+{
+    std::ifstream File(Path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(File), std::istreambuf_iterator<char>());
+}
+
+static size_t EndOf(const DDSTextureLayout& Layout)
+{
+    const DDSSubresourceLayout& Last = Layout.Subresources.back();
+    return Last.Offset + Last.SlicePitch * Last.Depth;
+}
+
+static void CheckLayout(const std::string& Name, const std::vector<uint8_t>& Data)
+{
+    DDSTextureLayout Layout;
+    const HRESULT hr = GetDDSTextureLayout(Data.data(), Data.size(), 0, Layout);
+    CHECK(SUCCEEDED(hr));
+    if (FAILED(hr))
+    {
+        fprintf(stderr, "%s: 0x%08x\n", Name.c_str(), (unsigned)hr);
+        return;
+    }
+
+    CHECK(Layout.Format != DXGI_FORMAT_UNKNOWN);
+    CHECK(Layout.MipCount >= 1 && Layout.ArraySize >= 1);
+    CHECK(Layout.SkippedMips == 0);
+    CHECK(Layout.Subresources.size() == (size_t)Layout.ArraySize * Layout.MipCount);
+    CHECK(!Layout.IsCubeMap || Layout.ArraySize % 6 == 0);
+
+    // subresources follow each other from the end of the header to the end of the file
+    size_t Offset = Layout.Subresources[0].Offset;
+    CHECK(Offset == 4 + 124 || Offset == 4 + 124 + 20);
+    for (uint32_t Item = 0; Item < Layout.ArraySize; ++Item)
+    {
+        for (uint32_t Mip = 0; Mip < Layout.MipCount; ++Mip)
+        {
+            const DDSSubresourceLayout& Sub = Layout.Subresources[Item * Layout.MipCount + Mip];
+            CHECK(Sub.Offset == Offset);
+            CHECK(Sub.Width == std::max(1u, Layout.Width >> Mip));
+            CHECK(Sub.Height == std::max(1u, Layout.Height >> Mip));
+            CHECK(Sub.Depth == std::max(1u, Layout.Depth >> Mip));
+
+            size_t NumBytes, RowBytes, NumRows;
+            GetSurfaceInfo(Sub.Width, Sub.Height, Layout.Format, &NumBytes, &RowBytes, &NumRows);
+            CHECK(Sub.RowPitch == RowBytes);
+            CHECK(Sub.SlicePitch == NumBytes);
+            CHECK(Sub.NumRows == NumRows);
+            CHECK(Sub.RowPitch * Sub.NumRows == Sub.SlicePitch);
+
+            Offset += Sub.SlicePitch * Sub.Depth;
+        }
+    }
+    CHECK(Offset == Data.size());
+    CHECK(EndOf(Layout) == Data.size());
+
+    // one byte short of the last texel, or of the header, is an error
+    DDSTextureLayout Rejected;
+    CHECK(FAILED(GetDDSTextureLayout(Data.data(), Data.size() - 1, 0, Rejected)));
+    CHECK(FAILED(GetDDSTextureLayout(Data.data(), Layout.Subresources[0].Offset - 1, 0, Rejected)));
+    CHECK(FAILED(GetDDSTextureLayout(Data.data(), 3, 0, Rejected)));
+
+    std::vector<uint8_t> Damaged = Data;
+    Damaged[0] = 'X';
+    CHECK(FAILED(GetDDSTextureLayout(Damaged.data(), Damaged.size(), 0, Rejected)));
+
+    // header size field
+    Damaged = Data;
+    Damaged[4] = 0;
+    CHECK(FAILED(GetDDSTextureLayout(Damaged.data(), Damaged.size(), 0, Rejected)));
+
+    // a size limit drops the leading mips above it and keeps the offsets of the rest. A
+    // texture without mips keeps its only level whatever its size.
+    const uint32_t MaxSize = 64;
+    DDSTextureLayout Limited;
+    CHECK(SUCCEEDED(GetDDSTextureLayout(Data.data(), Data.size(), MaxSize, Limited)));
+    if (Layout.MipCount > 1 && std::max(Layout.Width, Layout.Height) > MaxSize)
+    {
+        CHECK(std::max(Limited.Width, Limited.Height) <= MaxSize);
+        CHECK(Limited.SkippedMips > 0);
+        CHECK(Limited.SkippedMips + Limited.MipCount == Layout.MipCount);
+        CHECK(Limited.Width == std::max(1u, Layout.Width >> Limited.SkippedMips));
+        for (uint32_t Item = 0; Item < Limited.ArraySize; ++Item)
+        {
+            for (uint32_t Mip = 0; Mip < Limited.MipCount; ++Mip)
+            {
+                const DDSSubresourceLayout& Kept = Limited.Subresources[Item * Limited.MipCount + Mip];
+                const DDSSubresourceLayout& Full = Layout.Subresources[Item * Layout.MipCount + Mip + Limited.SkippedMips];
+                CHECK(Kept.Offset == Full.Offset && Kept.Width == Full.Width && Kept.SlicePitch == Full.SlicePitch);
+            }
+        }
+    }
+    else
+    {
+        CHECK(Limited.SkippedMips == 0 && Limited.MipCount == Layout.MipCount);
+    }
+}
+
+struct Expected
+{
+    const char* Name;
+    DXGI_FORMAT Format;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t MipCount;
+    uint32_t ArraySize;
+    bool IsCubeMap;
+};
+
+int main(int argc, char** argv)
+{
+    const std::filesystem::path Root = argc > 1 ? argv[1] : "../../textures";
+
+    int NumFiles = 0;
+    for (const auto& Entry : std::filesystem::directory_iterator(Root))
+    {
+        if (Entry.path().extension() != ".dds")
+            continue;
+        CheckLayout(Entry.path().filename().string(), ReadFile(Entry.path()));
+        ++NumFiles;
+    }
+    CHECK(NumFiles >= 20);
+
+    // one of each kind: BC1, BC2, BC3 with mips, uncompressed, an array, a cube map, 1x1
+    const Expected Known[] =
+    {
+        { "ice.dds",          DXGI_FORMAT_BC1_UNORM,      512, 512,  1, 1, false },
+        { "water1.dds",       DXGI_FORMAT_BC1_UNORM,      256, 256,  9, 1, false },
+        { "tree01S.dds",      DXGI_FORMAT_BC2_UNORM,      208, 256,  1, 1, false },
+        { "WoodCrate01.dds",  DXGI_FORMAT_BC3_UNORM,      512, 512, 10, 1, false },
+        { "bricks_nmap.dds",  DXGI_FORMAT_B8G8R8A8_UNORM, 512, 512, 10, 1, false },
+        { "treeArray2.dds",   DXGI_FORMAT_R8G8B8A8_UNORM, 208, 256,  1, 3, false },
+        { "cubeMap.dds",      DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256,  1, 6, true },
+        { "white1x1.dds",     DXGI_FORMAT_B8G8R8A8_UNORM,   1,   1,  1, 1, false },
+    };
+    for (const Expected& Texture : Known)
+    {
+        const std::vector<uint8_t> Data = ReadFile(Root / Texture.Name);
+        DDSTextureLayout Layout;
+        CHECK(SUCCEEDED(GetDDSTextureLayout(Data.data(), Data.size(), 0, Layout)));
+        CHECK(Layout.ResourceDimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D);
+        CHECK(Layout.Format == Texture.Format);
+        CHECK(Layout.Width == Texture.Width && Layout.Height == Texture.Height && Layout.Depth == 1);
+        CHECK(Layout.MipCount == Texture.MipCount);
+        CHECK(Layout.ArraySize == Texture.ArraySize);
+        CHECK(Layout.IsCubeMap == Texture.IsCubeMap);
+    }
+
+    return Test::Finish("DDSLayoutTest");
+}
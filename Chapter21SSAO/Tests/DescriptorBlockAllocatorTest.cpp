@@ -0,0 +1,276 @@
+#include "TestHarness.h"
+#include "DescriptorBlockAllocator.h"
+#include "NullFence.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+// DescriptorBlockAllocator over fake heaps: a heap is a range of addresses, and a NullFence
+// stands in for the graphics queue, completing frames a fixed number behind the one being
+// recorded, the way DescriptorAllocator sees the real one. Every descriptor handed out is
+// marked as owned, so a block given to two owners, or given out again before the frame it
+// was freed in completed, shows up as a failed check.
+
+namespace
+{
+    const uint32_t kHeapSize = 256;
+    const uint32_t kDescriptorSize = 32;
+    const size_t kBaseAddress = 0x10000000;
+    const uint32_t kMaxHeaps = 4096;
+    const uint32_t kFrameLag = 2;
+
+    class TestAllocator : public DescriptorBlockAllocator
+    {
+    public:
+        TestAllocator(void) : DescriptorBlockAllocator(kHeapSize), m_Fence(0, false) {}
+
+        // Closes the frame being recorded; the GPU finishes the one kFrameLag before it
+        void EndFrame(void)
+        {
+            const uint64_t Value = m_NextFence.fetch_add(1);
+            m_Fence.Signal(Value);
+            if (Value > kFrameLag)
+                m_Fence.Complete(Value - kFrameLag);
+        }
+
+        void CompleteAll(void)
+        {
+            EndFrame();
+            m_Fence.CompleteAll();
+        }
+
+        uint64_t GetCurrentFence(void) { return m_NextFence; }
+        bool IsComplete(uint64_t FenceValue) { return FenceValue <= m_Fence.GetCompletedValue(); }
+
+        void ResetHeaps(void)
+        {
+            Reset();
+            m_NumHeaps = 0;
+        }
+
+    protected:
+        virtual size_t CreateHeap(void) override
+        {
+            return kBaseAddress + (size_t)(m_NumHeaps++) * kHeapSize * kDescriptorSize;
+        }
+
+        virtual uint32_t GetDescriptorSize(void) override { return kDescriptorSize; }
+        virtual uint64_t GetRetireFence(void) override { return m_NextFence; }
+        virtual bool IsFenceComplete(uint64_t FenceValue) override { return IsComplete(FenceValue); }
+
+    private:
+        NullFence m_Fence;
+        std::atomic<uint64_t> m_NextFence{ 1 };
+        uint32_t m_NumHeaps = 0;
+    };
+
+    uint32_t IndexOf(size_t Handle)
+    {
+        return (uint32_t)((Handle - kBaseAddress) / kDescriptorSize);
+    }
+
+    // Which descriptors are handed out, and the fence each was last freed with
+    std::vector<std::atomic<uint8_t>> s_Owned(kMaxHeaps * kHeapSize);
+    std::vector<std::atomic<uint64_t>> s_FreedAt(kMaxHeaps * kHeapSize);
+
+    bool CheckBlock(size_t Handle, uint32_t Count)
+    {
+        if (Handle < kBaseAddress || (Handle - kBaseAddress) % kDescriptorSize != 0 ||
+            IndexOf(Handle) + Count > kMaxHeaps * kHeapSize)
+            return false;
+        // a block never straddles two heaps
+        return IndexOf(Handle) / kHeapSize == (IndexOf(Handle) + Count - 1) / kHeapSize;
+    }
+
+    void Take(TestAllocator& Allocator, size_t Handle, uint32_t Count)
+    {
+        for (uint32_t i = IndexOf(Handle); i < IndexOf(Handle) + Count; ++i)
+        {
+            CHECK(s_Owned[i].exchange(1) == 0);
+            CHECK(Allocator.IsComplete(s_FreedAt[i]));
+        }
+    }
+
+    void Give(TestAllocator& Allocator, size_t Handle, uint32_t Count)
+    {
+        const uint64_t Fence = Allocator.GetCurrentFence();
+        for (uint32_t i = IndexOf(Handle); i < IndexOf(Handle) + Count; ++i)
+        {
+            s_FreedAt[i] = Fence;
+            CHECK(s_Owned[i].exchange(0) == 1);
+        }
+        Allocator.FreeBlock(Handle, Count);
+    }
+
+    // Resources created and destroyed at random, mostly single descriptors like views, a
+    // few small tables, rarely a whole heap. The working set stays between 64 and 1500
+    // descriptors, so a steady state needs a bounded number of heaps.
+    void Churn(TestAllocator& Allocator, uint32_t Seed, int Iterations)
+    {
+        std::mt19937 Rng(Seed);
+        std::vector<std::pair<size_t, uint32_t>> Held;
+        int Live = 0;
+
+        for (int Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            if (Live < 64 || (Live < 1500 && (Rng() & 1)))
+            {
+                const uint32_t Kind = Rng() % 100;
+                const uint32_t Count = Kind < 90 ? 1 : Kind < 99 ? 1 + Rng() % 8 : 1 + Rng() % kHeapSize;
+                const size_t Handle = Allocator.AllocateBlock(Count);
+                CHECK(CheckBlock(Handle, Count));
+                if (!CheckBlock(Handle, Count))
+                    continue;
+                Take(Allocator, Handle, Count);
+                Held.push_back(std::make_pair(Handle, Count));
+                Live += Count;
+            }
+            else
+            {
+                const size_t Pick = Rng() % Held.size();
+                Give(Allocator, Held[Pick].first, Held[Pick].second);
+                Live -= Held[Pick].second;
+                Held[Pick] = Held.back();
+                Held.pop_back();
+            }
+
+            if (Iteration % 200 == 199)
+                Allocator.EndFrame();
+        }
+
+        for (const auto& Block : Held)
+            Give(Allocator, Block.first, Block.second);
+    }
+
+    bool StatsAddUp(const DescriptorBlockAllocator::Stats& Stats)
+    {
+        return Stats.LiveDescriptors + Stats.FreeDescriptors + Stats.PendingDescriptors == Stats.NumHeaps * kHeapSize;
+    }
+}
+
+// Requests round up to a power of two, are carved from the current heap, and the tail a
+// heap cannot serve is kept as smaller blocks
+static void TestCarving(void)
+{
+    TestAllocator Allocator;
+
+    // The first single fills this thread's cache with a batch
+    const size_t Single = Allocator.AllocateBlock(1);
+    CHECK(IndexOf(Single) < DescriptorBlockAllocator::kThreadCacheBatch);
+
+    const size_t Table = Allocator.AllocateBlock(100);
+    CHECK(IndexOf(Table) == DescriptorBlockAllocator::kThreadCacheBatch);
+
+    // 96 left in the first heap, not enough for 128: it is split into 64 + 32 and a second
+    // heap serves the request
+    const size_t Second = Allocator.AllocateBlock(128);
+    CHECK(IndexOf(Second) == kHeapSize);
+
+    DescriptorBlockAllocator::Stats Stats = Allocator.GetStats();
+    CHECK(Stats.NumHeaps == 2);
+    CHECK(Stats.LiveDescriptors == 1 + 128 + 128);
+    CHECK(Stats.PendingDescriptors == 0);
+    CHECK(StatsAddUp(Stats));
+
+    CHECK(IndexOf(Allocator.AllocateBlock(64)) == 160);
+    CHECK(IndexOf(Allocator.AllocateBlock(20)) == 224);
+    CHECK(Allocator.GetStats().NumHeaps == 2);
+
+    Allocator.Reset();
+    Stats = Allocator.GetStats();
+    CHECK(Stats.NumHeaps == 0 && Stats.LiveDescriptors == 0 && Stats.FreeDescriptors == 0);
+}
+
+// A freed block comes back only after the frame it was freed in has completed
+static void TestFenceDeferredReuse(void)
+{
+    TestAllocator Allocator;
+
+    const size_t Table = Allocator.AllocateBlock(16);
+    Allocator.FreeBlock(Table, 16);
+    CHECK(Allocator.GetStats().PendingDescriptors == 16);
+
+    std::vector<size_t> Tables;
+    for (uint32_t Frame = 0; Frame <= kFrameLag; ++Frame)
+    {
+        Tables.push_back(Allocator.AllocateBlock(16));
+        CHECK(Tables.back() != Table);
+        Allocator.EndFrame();
+    }
+    CHECK(Allocator.AllocateBlock(16) == Table);
+
+    // Singles go back in batches; each batch waits on the frame current when it was handed in
+    std::vector<size_t> Singles;
+    for (uint32_t i = 0; i < DescriptorBlockAllocator::kThreadCacheBatch * 3; ++i)
+        Singles.push_back(Allocator.AllocateBlock(1));
+    for (size_t Handle : Singles)
+        Allocator.FreeBlock(Handle, 1);
+    CHECK(Allocator.GetStats().PendingDescriptors == Singles.size());
+
+    for (uint32_t i = 0; i < DescriptorBlockAllocator::kThreadCacheBatch; ++i)
+    {
+        const size_t Handle = Allocator.AllocateBlock(1);
+        CHECK(std::find(Singles.begin(), Singles.end(), Handle) == Singles.end());
+    }
+
+    Allocator.CompleteAll();
+    const uint32_t HeapsBefore = Allocator.GetStats().NumHeaps;
+    for (uint32_t i = 0; i < (uint32_t)Singles.size(); ++i)
+        Allocator.AllocateBlock(1);
+    CHECK(Allocator.GetStats().NumHeaps == HeapsBefore);
+    CHECK(StatsAddUp(Allocator.GetStats()));
+}
+
+// A million creations and destructions over four threads, in two halves. Freed blocks are
+// recycled rather than new heaps created, so the heap count follows the working set, not
+// the number of creations: the second half adds little, and the total stays within what the
+// working set needs. Size classes are never merged, so each class settles at its own peak
+// and the count creeps up for a while before it stops.
+static void TestStress(void)
+{
+    TestAllocator Allocator;
+    const int NumThreads = 4;
+
+    auto RunPhase = [&](uint32_t Seed, int IterationsPerThread)
+    {
+        std::vector<std::thread> Threads;
+        for (int t = 0; t < NumThreads; ++t)
+            Threads.emplace_back([&, t] { Churn(Allocator, Seed + t, IterationsPerThread); });
+        for (std::thread& Thread : Threads)
+            Thread.join();
+    };
+
+    RunPhase(1, 125000);
+    const DescriptorBlockAllocator::Stats Half = Allocator.GetStats();
+    CHECK(Half.LiveDescriptors == 0);
+    CHECK(StatsAddUp(Half));
+
+    RunPhase(100, 125000);
+    const DescriptorBlockAllocator::Stats Final = Allocator.GetStats();
+    CHECK(Final.LiveDescriptors == 0);
+    CHECK(StatsAddUp(Final));
+
+    printf("1M creations and destructions: %u heaps after 500k, %u after 1M\n", Half.NumHeaps, Final.NumHeaps);
+
+    // Each thread holds at most 1500 + kHeapSize descriptors, 28 heaps for all four. What
+    // waits on a fence and what sits in the other size classes stays below as much again.
+    CHECK(Final.NumHeaps <= Half.NumHeaps + Half.NumHeaps / 2);
+    CHECK(Final.NumHeaps < 56);
+
+    // Once everything has completed, a Reset starts over from nothing
+    Allocator.ResetHeaps();
+    for (auto& FreedAt : s_FreedAt)
+        FreedAt = 0;
+    CHECK(Allocator.GetStats().NumHeaps == 0);
+    Churn(Allocator, 7, 10000);
+    CHECK(StatsAddUp(Allocator.GetStats()));
+}
+
+int main(void)
+{
+    TestCarving();
+    TestFenceDeferredReuse();
+    TestStress();
+    return Test::Finish("DescriptorBlockAllocatorTest");
+}
@@ -0,0 +1,197 @@
+#include "TestHarness.h"
+#include "DescriptorIndexAllocator.h"
+#include "NullFence.h"
+#include <map>
+#include <random>
+#include <set>
+
+// DescriptorIndexAllocator driven by a NullFence standing in for the graphics queue: a slot is
+// freed with the next fence value, the way BindlessDescriptorHeap::Free does, and only comes
+// back once the test completes that value.
+
+namespace
+{
+    const uint32_t kInvalid = DescriptorIndexAllocator::kInvalidIndex;
+
+    void ReleaseCompleted(DescriptorIndexAllocator& Allocator, NullFence& Fence)
+    {
+        Allocator.ReleaseCompleted([&](uint64_t Value) { return Value <= Fence.GetCompletedValue(); });
+    }
+
+    bool CountsAddUp(const DescriptorIndexAllocator& Allocator)
+    {
+        return Allocator.GetLiveCount() + Allocator.GetPendingCount() + Allocator.GetAvailableCount() ==
+            Allocator.GetCapacity();
+    }
+}
+
+static void TestAllocateAndExhaust(void)
+{
+    DescriptorIndexAllocator Allocator(8);
+    CHECK(Allocator.GetCapacity() == 8 && Allocator.GetAvailableCount() == 8);
+
+    std::set<uint32_t> Live;
+    for (int i = 0; i < 8; ++i)
+    {
+        const uint32_t Index = Allocator.Allocate();
+        CHECK(Index < 8);
+        CHECK(Live.insert(Index).second);
+    }
+    CHECK(Allocator.GetLiveCount() == 8 && Allocator.GetAvailableCount() == 0);
+    CHECK(Allocator.Allocate() == kInvalid);
+    CHECK(Allocator.GetLiveCount() == 8);
+
+    // A zero-capacity allocator hands out nothing
+    DescriptorIndexAllocator Empty;
+    CHECK(Empty.Allocate() == kInvalid);
+
+    // Reset forgets live and pending slots alike
+    Allocator.Free(2, 1);
+    Allocator.Reset(4);
+    CHECK(Allocator.GetCapacity() == 4 && Allocator.GetLiveCount() == 0 && Allocator.GetPendingCount() == 0);
+    for (uint32_t i = 0; i < 4; ++i)
+        CHECK(Allocator.Allocate() == i);
+    CHECK(Allocator.Allocate() == kInvalid);
+}
+
+static void TestFenceDeferredReuse(void)
+{
+    NullFence Fence(0, false);
+    DescriptorIndexAllocator Allocator(8);
+    for (int i = 0; i < 8; ++i)
+        Allocator.Allocate();
+
+    Fence.Signal(1);
+    Allocator.Free(3, 1);
+    Fence.Signal(2);
+    Allocator.Free(5, 2);
+    CHECK(Allocator.GetLiveCount() == 6 && Allocator.GetPendingCount() == 2 && Allocator.GetAvailableCount() == 0);
+    CHECK(CountsAddUp(Allocator));
+
+    // Nothing comes back while the GPU may still read the descriptors
+    ReleaseCompleted(Allocator, Fence);
+    CHECK(Allocator.Allocate() == kInvalid);
+
+    // Each slot comes back with its own fence value, not before
+    Fence.Complete(1);
+    ReleaseCompleted(Allocator, Fence);
+    CHECK(Allocator.GetPendingCount() == 1 && Allocator.GetAvailableCount() == 1);
+    CHECK(Allocator.Allocate() == 3);
+    CHECK(Allocator.Allocate() == kInvalid);
+
+    Fence.Complete(2);
+    ReleaseCompleted(Allocator, Fence);
+    CHECK(Allocator.Allocate() == 5);
+    CHECK(Allocator.GetPendingCount() == 0 && Allocator.GetLiveCount() == 8);
+}
+
+static void TestReleaseOrder(void)
+{
+    NullFence Fence(0, false);
+    DescriptorIndexAllocator Allocator(4);
+    for (int i = 0; i < 4; ++i)
+        Allocator.Allocate();
+
+    // Slots released together come back most recently freed first
+    Fence.Signal(1);
+    Allocator.Free(0, 1);
+    Allocator.Free(1, 1);
+    Allocator.Free(2, 1);
+    Fence.Complete(1);
+    ReleaseCompleted(Allocator, Fence);
+    CHECK(Allocator.Allocate() == 2);
+    CHECK(Allocator.Allocate() == 1);
+    CHECK(Allocator.Allocate() == 0);
+
+    // The scan stops at the first incomplete fence, even when a slot freed after it has a
+    // completed one: freeing on a second queue does not jump the line
+    Fence.Signal(3);
+    Allocator.Free(0, 3);
+    Allocator.Free(1, 2);
+    Fence.Complete(2);
+    ReleaseCompleted(Allocator, Fence);
+    CHECK(Allocator.GetPendingCount() == 2 && Allocator.Allocate() == kInvalid);
+    Fence.Complete(3);
+    ReleaseCompleted(Allocator, Fence);
+    CHECK(Allocator.GetPendingCount() == 0 && Allocator.GetAvailableCount() == 2);
+}
+
+// Random allocation, frees and fence progress against a model of which slots are live and
+// which wait on a fence: no slot is handed out twice or before its fence completes, and
+// every slot comes back eventually
+static void TestRandomChurn(void)
+{
+    const uint32_t Capacity = 1024;
+    NullFence Fence(0, false);
+    DescriptorIndexAllocator Allocator(Capacity);
+
+    std::mt19937 Rng(1);
+    std::set<uint32_t> Live;
+    std::map<uint32_t, uint64_t> Pending;
+    uint64_t NextFence = 1;
+    Fence.Signal(NextFence);
+
+    for (int Iteration = 0; Iteration < 200000; ++Iteration)
+    {
+        const uint32_t Op = Rng() % 100;
+        if (Op < 50)
+        {
+            const uint32_t Index = Allocator.Allocate();
+            if (Index == kInvalid)
+            {
+                CHECK(Live.size() + Pending.size() == Capacity);
+                continue;
+            }
+            CHECK(Index < Capacity);
+            CHECK(Live.count(Index) == 0);
+            CHECK(Pending.count(Index) == 0);
+            Live.insert(Index);
+        }
+        else if (Op < 95)
+        {
+            if (Live.empty())
+                continue;
+            auto Iter = Live.begin();
+            std::advance(Iter, Rng() % std::min<size_t>(Live.size(), 64));
+            Allocator.Free(*Iter, NextFence);
+            Pending[*Iter] = NextFence;
+            Live.erase(Iter);
+        }
+        else
+        {
+            // end of a "frame": the GPU lags up to two frames behind
+            Fence.Signal(++NextFence);
+            const uint64_t Lag = Rng() % 3;
+            if (NextFence > Lag + 1)
+                Fence.Complete(NextFence - 1 - Lag);
+            ReleaseCompleted(Allocator, Fence);
+            for (auto Iter = Pending.begin(); Iter != Pending.end(); )
+                Iter = Iter->second <= Fence.GetCompletedValue() ? Pending.erase(Iter) : std::next(Iter);
+        }
+
+        CHECK(Allocator.GetLiveCount() == Live.size());
+        CHECK(Allocator.GetPendingCount() == Pending.size());
+        CHECK(CountsAddUp(Allocator));
+    }
+
+    for (uint32_t Index : Live)
+        Allocator.Free(Index, NextFence);
+    Fence.CompleteAll();
+    ReleaseCompleted(Allocator, Fence);
+    CHECK(Allocator.GetLiveCount() == 0 && Allocator.GetPendingCount() == 0);
+    CHECK(Allocator.GetAvailableCount() == Capacity);
+
+    std::set<uint32_t> All;
+    for (uint32_t i = 0; i < Capacity; ++i)
+        All.insert(Allocator.Allocate());
+    CHECK(All.size() == Capacity && All.count(kInvalid) == 0);
+}
+
+int main(void)
+{
+    TestAllocateAndExhaust();
+    TestFenceDeferredReuse();
+    TestReleaseOrder();
+    TestRandomChurn();
+    return Test::Finish("DescriptorIndexAllocatorTest");
+}
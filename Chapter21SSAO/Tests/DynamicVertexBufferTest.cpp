@@ -0,0 +1,144 @@
+#include "TestHarness.h"
+#include "NullDevice.h"
+#include "NullFence.h"
+#include "DynamicVertexBuffer.h"
+#include <future>
+#include <thread>
+
+// The ring of DynamicVertexBuffer against a NullFence the test completes by hand: regions are
+// handed out in turn, the view follows the current one, and a region only comes back once the
+// fence value EndFrame stored for it has completed.
+
+namespace
+{
+    struct Vertex
+    {
+        float Position[3];
+        float Normal[3];
+        float TexC[2];
+    };
+
+    const uint32_t kNumVertices = 100;
+    const uint32_t kNumFrames = 3;
+    const size_t kRegionSize = 3328;    // 100 * 32 bytes, rounded up to 256
+
+    // True if Result is still pending after the other thread had time to finish
+    template <typename T>
+    bool IsBlocked(std::future<T>& Result)
+    {
+        return Result.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout;
+    }
+}
+
+static void TestRegionsAndViews(void)
+{
+    NullFence Fence(0);
+
+    DynamicVertexBuffer Buffer;
+    Buffer.Create(L"Ring", kNumVertices, sizeof(Vertex), Fence, kNumFrames);
+    CHECK(Buffer.GetBufferSize() == kRegionSize * kNumFrames);
+    CHECK(Buffer.GetVertexCount() == kNumVertices);
+
+    uint8_t* Regions[kNumFrames * 2];
+    for (uint32_t Frame = 0; Frame < kNumFrames * 2; ++Frame)
+    {
+        Regions[Frame] = (uint8_t*)Buffer.BeginFrame();
+        memset(Regions[Frame], (int)Frame, kNumVertices * sizeof(Vertex));
+
+        // the view is the region just written, on the GPU side
+        D3D12_VERTEX_BUFFER_VIEW View = Buffer.VertexBufferView();
+        CHECK(View.BufferLocation == Buffer.GetGpuVirtualAddress() + (Frame % kNumFrames) * kRegionSize);
+        CHECK(View.SizeInBytes == kNumVertices * sizeof(Vertex));
+        CHECK(View.StrideInBytes == sizeof(Vertex));
+
+        Fence.Signal(Frame + 1);
+        Buffer.EndFrame(Frame + 1);
+    }
+
+    // consecutive regions in order, then the ring starts over
+    for (uint32_t Frame = 1; Frame < kNumFrames; ++Frame)
+        CHECK(Regions[Frame] == Regions[Frame - 1] + kRegionSize);
+    for (uint32_t Frame = 0; Frame < kNumFrames; ++Frame)
+        CHECK(Regions[Frame + kNumFrames] == Regions[Frame]);
+}
+
+// Wrapping around to a region waits for the fence of the frame that last used it, and that
+// fence alone
+static void TestWrapWaitsForOldestRegion(void)
+{
+    NullFence Fence(0, false);
+
+    DynamicVertexBuffer Buffer;
+    Buffer.Create(L"Ring", kNumVertices, sizeof(Vertex), Fence, kNumFrames);
+
+    // regions that were never submitted don't wait
+    for (uint32_t Frame = 0; Frame < kNumFrames; ++Frame)
+    {
+        Buffer.BeginFrame();
+        Fence.Signal(10 + Frame);
+        Buffer.EndFrame(10 + Frame);
+    }
+
+    std::future<void*> Wrapped = std::async(std::launch::async, [&] { return Buffer.BeginFrame(); });
+    CHECK(IsBlocked(Wrapped));
+
+    // EndFrame stored 10 for region 0, completing less than that is not enough
+    Fence.Complete(9);
+    CHECK(IsBlocked(Wrapped));
+
+    // 11 and 12, for the other regions, are still pending
+    Fence.Complete(10);
+    uint8_t* Region = (uint8_t*)Wrapped.get();
+    CHECK(Region != nullptr);
+    CHECK(Buffer.VertexBufferView().BufferLocation == Buffer.GetGpuVirtualAddress());
+    CHECK(Fence.GetCompletedValue() == 10);
+
+    // a later EndFrame replaces the value the region waits for
+    Fence.Signal(20);
+    Buffer.EndFrame(20);
+    Fence.Complete(12);
+    Buffer.BeginFrame();
+    Buffer.EndFrame(21);
+    Buffer.BeginFrame();
+    Buffer.EndFrame(22);
+
+    std::future<void*> Again = std::async(std::launch::async, [&] { return Buffer.BeginFrame(); });
+    CHECK(IsBlocked(Again));
+    Fence.Complete(20);
+    CHECK((uint8_t*)Again.get() == Region);
+
+    Fence.Signal(22);
+    Fence.CompleteAll();
+}
+
+// Destroy waits for every region still being read
+static void TestDestroyWaitsForAllRegions(void)
+{
+    NullFence Fence(0, false);
+
+    DynamicVertexBuffer Buffer;
+    Buffer.Create(L"Ring", kNumVertices, sizeof(Vertex), Fence, kNumFrames);
+    for (uint32_t Frame = 0; Frame < kNumFrames; ++Frame)
+    {
+        Buffer.BeginFrame();
+        Fence.Signal(Frame + 1);
+        Buffer.EndFrame(Frame + 1);
+    }
+
+    std::future<void> Destroyed = std::async(std::launch::async, [&] { Buffer.Destroy(); });
+    Fence.Complete(2);
+    CHECK(IsBlocked(Destroyed));
+    Fence.Complete(3);
+    Destroyed.get();
+    CHECK(Buffer.GetResource() == nullptr);
+}
+
+int main(void)
+{
+    Graphics::Initialize(false);
+    TestRegionsAndViews();
+    TestWrapWaitsForOldestRegion();
+    TestDestroyWaitsForAllRegions();
+    Graphics::Shutdown();
+    return Test::Finish("DynamicVertexBufferTest");
+}
@@ -0,0 +1,100 @@
+#include "TestHarness.h"
+#include "NullFence.h"
+#include <thread>
+
+static void TestAutoComplete(void)
+{
+    NullFence Fence(100);
+    CHECK(Fence.GetCompletedValue() == 100);
+
+    // signaled values complete right away, and waiting on them returns
+    Fence.Signal(101);
+    CHECK(Fence.GetCompletedValue() == 101);
+    Fence.WaitForValue(101);
+    Fence.WaitForValue(50);
+
+    // an older signal never moves the fence back
+    Fence.Signal(99);
+    CHECK(Fence.GetCompletedValue() == 101);
+}
+
+static void TestManualComplete(void)
+{
+    NullFence Fence(0, false);
+
+    Fence.Signal(1);
+    Fence.Signal(2);
+    Fence.Signal(3);
+    CHECK(Fence.GetCompletedValue() == 0);
+
+    Fence.Complete(2);
+    CHECK(Fence.GetCompletedValue() == 2);
+
+    // completing never runs ahead of the last signal
+    Fence.Complete(10);
+    CHECK(Fence.GetCompletedValue() == 3);
+
+    Fence.Signal(5);
+    Fence.CompleteAll();
+    CHECK(Fence.GetCompletedValue() == 5);
+
+    // switching to AutoComplete affects later signals only
+    Fence.Signal(6);
+    Fence.SetAutoComplete(true);
+    CHECK(Fence.GetCompletedValue() == 5);
+    Fence.Signal(7);
+    CHECK(Fence.GetCompletedValue() == 7);
+}
+
+static void TestWaitAcrossThreads(void)
+{
+    NullFence Fence(0, false);
+    Fence.Signal(1);
+    Fence.Signal(2);
+
+    std::atomic<uint64_t> SeenAfterWait{ 0 };
+    std::thread Waiter([&]
+    {
+        Fence.WaitForValue(2);
+        SeenAfterWait = Fence.GetCompletedValue();
+    });
+
+    // the waiter must not return on a partial completion
+    Fence.Complete(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(SeenAfterWait.load() == 0);
+
+    Fence.Complete(2);
+    Waiter.join();
+    CHECK(SeenAfterWait.load() == 2);
+}
+
+// The recycling pattern every fence-keyed pool follows: retire with the next fence value,
+// reuse once the fence reports it complete
+static void TestRetireAndReuse(void)
+{
+    NullFence Fence(0, false);
+    uint64_t NextValue = 1;
+
+    std::vector<std::pair<uint64_t, int>> Retired;
+    for (int Frame = 0; Frame < 4; ++Frame)
+    {
+        Retired.push_back(std::make_pair(NextValue, Frame));
+        Fence.Signal(NextValue++);
+    }
+
+    int Reusable = 0;
+    Fence.Complete(2);
+    for (auto& Entry : Retired)
+        Reusable += Entry.first <= Fence.GetCompletedValue() ? 1 : 0;
+    CHECK(Reusable == 2);
+}
+
+int main(void)
+{
+    TestAutoComplete();
+    TestManualComplete();
+    TestWaitAcrossThreads();
+    TestRetireAndReuse();
+    return Test::Finish("FenceTest");
+}
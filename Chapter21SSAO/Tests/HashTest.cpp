@@ -0,0 +1,148 @@
+#include "TestHarness.h"
+#include "Hash.h"
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+// HashRange over inputs the size of D3D12_GRAPHICS_PIPELINE_STATE_DESC on x64, mostly zeros
+// and small enums like a real one. The pipeline and root signature caches treat equal hashes
+// as a likely match, so nearby descriptions must not collide, and the low bits the hash maps
+// index must be evenly spread.
+
+namespace
+{
+    const size_t kDescWords = 656 / 4;
+    const size_t kSeed = 2166136261U;
+
+    size_t Hash(const std::vector<uint32_t>& Words, size_t Seed = kSeed)
+    {
+        return Utility::HashRange(Words.data(), Words.data() + Words.size(), Seed);
+    }
+
+    struct alignas(8) BlendDesc
+    {
+        uint32_t Enable;
+        uint32_t Src;
+        uint32_t Dest;
+        uint32_t Op;
+    };
+}
+
+int main(void)
+{
+    printf("HashRange implementation: %s\n", Utility::GetHashRangeImplementation());
+
+    std::vector<uint32_t> Base(kDescWords, 0);
+    std::mt19937 Rng(1);
+    for (uint32_t& Word : Base)
+        Word = Rng() % 4 ? 0 : Rng() % 64;
+
+    // The same words give the same hash; the seed, the length and where the range starts in
+    // memory all matter
+    {
+        const size_t H = Hash(Base);
+        CHECK(Hash(Base) == H);
+        CHECK(Hash(Base, kSeed + 1) != H);
+        CHECK(Hash(Base, 0) != Hash(Base, (size_t)1 << 40));
+
+        std::vector<uint32_t> Longer = Base;
+        Longer.push_back(0);
+        CHECK(Hash(Longer) != H);
+
+        std::vector<uint32_t> Shifted(kDescWords + 1);
+        std::copy(Base.begin(), Base.end(), Shifted.begin() + 1);
+        CHECK(Utility::HashRange(Shifted.data() + 1, Shifted.data() + Shifted.size(), kSeed) == H);
+
+        BlendDesc Blend[2] = { { 1, 2, 3, 4 }, { 0, 5, 6, 1 } };
+        CHECK(Utility::HashState(Blend, 2) == Utility::HashRange((uint32_t*)Blend, (uint32_t*)(Blend + 2), kSeed));
+        CHECK(Utility::HashState(Blend) != Utility::HashState(Blend, 2));
+        CHECK(Utility::HashState(Blend + 1, 1, Utility::HashState(Blend)) != Utility::HashState(Blend + 1));
+    }
+
+    // Short ranges of every length, including the remainders the wide paths handle one word
+    // at a time: flipping any bit of any word changes the hash
+    for (size_t Length = 0; Length <= 24; ++Length)
+    {
+        std::vector<uint32_t> Words(Base.begin(), Base.begin() + Length);
+        const size_t H = Hash(Words);
+        for (size_t i = 0; i < Length; ++i)
+        {
+            for (uint32_t Bit = 0; Bit < 32; ++Bit)
+            {
+                Words[i] ^= 1u << Bit;
+                CHECK(Hash(Words) != H);
+                Words[i] ^= 1u << Bit;
+            }
+        }
+    }
+
+    // Every single field set to 0..255, pairs of fields changed together, and blocks of
+    // render target blend state swapped: no collisions, and the low bits evenly spread
+    {
+        const size_t kNumBuckets = 1024;
+        std::unordered_set<size_t> Seen;
+        std::vector<size_t> Buckets(kNumBuckets, 0);
+        size_t NumInputs = 0;
+        size_t NumCollisions = 0;
+
+        auto Add = [&](const std::vector<uint32_t>& Desc)
+        {
+            const size_t H = Hash(Desc);
+            ++NumInputs;
+            if (!Seen.insert(H).second)
+                ++NumCollisions;
+            ++Buckets[H % kNumBuckets];
+        };
+
+        std::vector<uint32_t> Desc;
+        for (size_t i = 0; i < kDescWords; ++i)
+        {
+            for (uint32_t Value = 0; Value < 256; ++Value)
+            {
+                if (Value == Base[i])
+                    continue;
+                Desc = Base;
+                Desc[i] = Value;
+                Add(Desc);
+            }
+        }
+        for (size_t i = 0; i < kDescWords; ++i)
+        {
+            for (size_t j = i + 1; j < kDescWords; ++j)
+            {
+                for (uint32_t Delta = 1; Delta < 4; ++Delta)
+                {
+                    Desc = Base;
+                    Desc[i] ^= Delta;
+                    Desc[j] ^= Delta;
+                    Add(Desc);
+                }
+            }
+        }
+        for (size_t Block = 0; Block + 16 <= kDescWords; Block += 8)
+        {
+            Desc = Base;
+            for (size_t k = 0; k < 8; ++k)
+            {
+                std::swap(Desc[Block + k], Desc[Block + 8 + k]);
+                Desc[Block + k] ^= 1;
+            }
+            Add(Desc);
+        }
+
+        const double Mean = (double)NumInputs / kNumBuckets;
+        double ChiSquared = 0.0;
+        for (size_t Count : Buckets)
+            ChiSquared += (Count - Mean) * (Count - Mean) / Mean;
+
+        printf("%zu inputs, %zu collisions, chi2 %.0f over %zu buckets\n",
+            NumInputs, NumCollisions, ChiSquared, kNumBuckets);
+
+        CHECK(NumInputs > 80000);
+        CHECK(NumCollisions == 0);
+        // 1023 degrees of freedom: mean 1023, standard deviation about 45
+        CHECK(ChiSquared < 1250.0);
+    }
+
+    return Test::Finish("HashTest");
+}
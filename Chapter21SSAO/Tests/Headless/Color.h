@@ -0,0 +1,36 @@
+#pragma once
+
+// Stands in for Core/Utils/Color.h, which is built on DirectXMath: four floats with the
+// accessors the buffers and contexts use.
+
+#include <cstdint>
+
+class Color
+{
+public:
+    Color(void) : m_value{ 1.0f, 1.0f, 1.0f, 1.0f } {}
+    Color(float r, float g, float b, float a = 1.0f) : m_value{ r, g, b, a } {}
+
+    float R() const { return m_value[0]; }
+    float G() const { return m_value[1]; }
+    float B() const { return m_value[2]; }
+    float A() const { return m_value[3]; }
+
+    bool operator==(const Color& rhs) const
+    {
+        return m_value[0] == rhs.m_value[0] && m_value[1] == rhs.m_value[1] && m_value[2] == rhs.m_value[2] &&
+            m_value[3] == rhs.m_value[3];
+    }
+    bool operator!=(const Color& rhs) const { return !(*this == rhs); }
+
+    void SetR(float r) { m_value[0] = r; }
+    void SetG(float g) { m_value[1] = g; }
+    void SetB(float b) { m_value[2] = b; }
+    void SetA(float a) { m_value[3] = a; }
+
+    float* GetPtr(void) { return m_value; }
+    float& operator[](int idx) { return GetPtr()[idx]; }
+
+private:
+    float m_value[4];
+};
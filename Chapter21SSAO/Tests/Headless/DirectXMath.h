@@ -0,0 +1,17 @@
+#pragma once
+
+// Stands in for <DirectXMath.h> where Core only stores and returns vectors: the plain float
+// structures, without the SIMD types and functions that work on them.
+
+namespace DirectX
+{
+    struct XMFLOAT3
+    {
+        float x;
+        float y;
+        float z;
+
+        XMFLOAT3() = default;
+        constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+    };
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Stands in for Core/Command/CommandContext.h in tests that record nothing, see
+// Mock/GraphicsCore.h.
+
+#include "pch.h"
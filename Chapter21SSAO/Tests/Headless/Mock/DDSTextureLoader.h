@@ -0,0 +1,19 @@
+#pragma once
+
+// Stands in for Core/Utils/DDSTextureLoader.h: the declaration only, the test decides what
+// creating a texture from memory does.
+
+#include "pch.h"
+
+enum DDS_ALPHA_MODE
+{
+    DDS_ALPHA_MODE_UNKNOWN = 0,
+    DDS_ALPHA_MODE_STRAIGHT = 1,
+    DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+    DDS_ALPHA_MODE_OPAQUE = 3,
+    DDS_ALPHA_MODE_CUSTOM = 4,
+};
+
+HRESULT CreateDDSTextureFromMemory(ID3D12Device* d3dDevice, const uint8_t* ddsData, size_t ddsDataSize,
+    size_t maxsize, bool forceSRGB, ID3D12Resource** texture, D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+    DDS_ALPHA_MODE* alphaMode = nullptr);
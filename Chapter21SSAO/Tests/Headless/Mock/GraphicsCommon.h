@@ -0,0 +1,24 @@
+#pragma once
+
+// Stands in for Core/GraphicsCommon.h: only the default textures, defined by the test.
+
+#include "pch.h"
+
+namespace Graphics
+{
+    enum eDefaultTexture
+    {
+        kMagenta2D,  // Useful for indicating missing textures
+        kBlackOpaque2D,
+        kBlackTransparent2D,
+        kWhiteOpaque2D,
+        kWhiteTransparent2D,
+        kDefaultNormalMap,
+        kBlackCubeMap,
+
+        kNumDefaultTextures
+    };
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDefaultTexture(eDefaultTexture texID);
+    // Slot of the default texture in the bindless heap
+    uint32_t GetDefaultTextureIndex(eDefaultTexture texID);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Stands in for Core/GraphicsCore.h in tests that define the globals of the graphics core
+// themselves instead of bringing up NullGraphicsCore.cpp. Mock/ comes before Headless/ on
+// their include path.
+
+#include "pch.h"
+#include "DescriptorIndexAllocator.h"
+
+namespace Graphics
+{
+    extern ID3D12Device* g_Device;
+
+    // Same interface as the real heap in DescriptorHeap.h
+    class BindlessDescriptorHeap
+    {
+    public:
+        uint32_t Allocate(D3D12_CPU_DESCRIPTOR_HANDLE Source);
+        void Free(uint32_t Index);
+    };
+    extern BindlessDescriptorHeap g_BindlessHeap;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE Type, UINT Count = 1);
+    void FreeDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE Handle, D3D12_DESCRIPTOR_HEAP_TYPE Type, UINT Count = 1);
+}
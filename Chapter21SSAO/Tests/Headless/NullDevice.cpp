@@ -0,0 +1,608 @@
+#include "NullDevice.h"
+#include "DDSLayout.h"
+
+namespace
+{
+    // The Windows event D3D12Fence waits on: auto-reset, which is all the engine creates
+    struct NullEvent
+    {
+        std::mutex Mutex;
+        std::condition_variable Signaled;
+        bool IsSet = false;
+
+        void Set(void)
+        {
+            {
+                std::lock_guard<std::mutex> LockGuard(Mutex);
+                IsSet = true;
+            }
+            Signaled.notify_all();
+        }
+    };
+
+    class NullCommandAllocator : public NullDeviceChild<ID3D12CommandAllocator>
+    {
+    public:
+        using NullDeviceChild::NullDeviceChild;
+        virtual HRESULT Reset(void) override { return S_OK; }
+    };
+
+    class NullRootSignature : public NullDeviceChild<ID3D12RootSignature>
+    {
+    public:
+        using NullDeviceChild::NullDeviceChild;
+    };
+
+    class NullPipelineState : public NullDeviceChild<ID3D12PipelineState>
+    {
+    public:
+        using NullDeviceChild::NullDeviceChild;
+    };
+
+    class NullCommandSignature : public NullDeviceChild<ID3D12CommandSignature>
+    {
+    public:
+        using NullDeviceChild::NullDeviceChild;
+    };
+
+    template <typename T>
+    void AppendBytes(std::vector<uint8_t>& Bytes, const T* Data, size_t Count)
+    {
+        const uint8_t* First = reinterpret_cast<const uint8_t*>(Data);
+        Bytes.insert(Bytes.end(), First, First + sizeof(T) * Count);
+    }
+
+    NullResource* AsNullResource(ID3D12Resource* pResource)
+    {
+        return static_cast<NullResource*>(pResource);
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS AddressOf(ID3D12Resource* pResource)
+    {
+        return pResource != nullptr ? pResource->GetGPUVirtualAddress() : 0;
+    }
+}
+
+HANDLE CreateEvent(void*, BOOL, BOOL, LPCWSTR)
+{
+    return new NullEvent;
+}
+
+BOOL CloseHandle(HANDLE Object)
+{
+    delete static_cast<NullEvent*>(Object);
+    return TRUE;
+}
+
+DWORD WaitForSingleObject(HANDLE Handle, DWORD)
+{
+    NullEvent& Event = *static_cast<NullEvent*>(Handle);
+    std::unique_lock<std::mutex> Lock(Event.Mutex);
+    Event.Signaled.wait(Lock, [&Event] { return Event.IsSet; });
+    Event.IsSet = false;
+    return WAIT_OBJECT_0;
+}
+
+// The blob only has to tell root signatures apart, RootSignature caches them by its own hash
+HRESULT D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* pRootSignature, D3D_ROOT_SIGNATURE_VERSION,
+    ID3DBlob** ppBlob, ID3DBlob** ppErrorBlob)
+{
+    if (ppErrorBlob != nullptr)
+        *ppErrorBlob = nullptr;
+
+    std::vector<uint8_t> Bytes;
+    AppendBytes(Bytes, &pRootSignature->Flags, 1);
+    for (UINT i = 0; i < pRootSignature->NumParameters; ++i)
+    {
+        const D3D12_ROOT_PARAMETER& Param = pRootSignature->pParameters[i];
+        AppendBytes(Bytes, &Param.ParameterType, 1);
+        AppendBytes(Bytes, &Param.ShaderVisibility, 1);
+        if (Param.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+            AppendBytes(Bytes, Param.DescriptorTable.pDescriptorRanges, Param.DescriptorTable.NumDescriptorRanges);
+        else if (Param.ParameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+            AppendBytes(Bytes, &Param.Constants, 1);
+        else
+            AppendBytes(Bytes, &Param.Descriptor, 1);
+    }
+    AppendBytes(Bytes, pRootSignature->pStaticSamplers, pRootSignature->NumStaticSamplers);
+
+    *ppBlob = new NullBlob(std::move(Bytes));
+    return S_OK;
+}
+
+//
+// NullResource
+//
+
+NullResource::NullResource(NullDevice* pDevice, const D3D12_RESOURCE_DESC& Desc, D3D12_HEAP_TYPE HeapType) :
+    NullDeviceChild(pDevice),
+    m_Desc(Desc),
+    m_HeapType(HeapType),
+    m_Memory(nullptr),
+    m_MapCount(0)
+{
+    if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        m_Memory = static_cast<uint8_t*>(calloc((size_t)Desc.Width, 1));
+    pDevice->TrackResource(1);
+}
+
+NullResource::~NullResource()
+{
+    free(m_Memory);
+    GetNullDevice()->TrackResource(-1);
+}
+
+HRESULT NullResource::Map(UINT, const D3D12_RANGE*, void** ppData)
+{
+    if (m_Memory == nullptr)
+        return E_INVALIDARG;
+
+    ++m_MapCount;
+    if (ppData != nullptr)
+        *ppData = m_Memory;
+    return S_OK;
+}
+
+void NullResource::Unmap(UINT, const D3D12_RANGE*)
+{
+    ASSERT(m_MapCount > 0, "Unmapping a resource that is not mapped");
+    --m_MapCount;
+}
+
+//
+// NullDescriptorHeap
+//
+
+NullDescriptorHeap::NullDescriptorHeap(NullDevice* pDevice, const D3D12_DESCRIPTOR_HEAP_DESC& Desc) :
+    NullDeviceChild(pDevice),
+    m_Desc(Desc),
+    m_Descriptors(Desc.NumDescriptors)
+{
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE NullDescriptorHeap::GetCPUDescriptorHandleForHeapStart(void) const
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE Handle;
+    Handle.ptr = (size_t)m_Descriptors.data();
+    return Handle;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE NullDescriptorHeap::GetGPUDescriptorHandleForHeapStart(void) const
+{
+    // like the real API, only shader-visible heaps have GPU handles
+    D3D12_GPU_DESCRIPTOR_HANDLE Handle;
+    Handle.ptr = (m_Desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) != 0 ?
+        (uint64_t)(uintptr_t)m_Descriptors.data() + kGpuHandleBias : 0;
+    return Handle;
+}
+
+//
+// NullCommandList
+//
+
+NullCommandList::NullCommandList(NullDevice* pDevice, D3D12_COMMAND_LIST_TYPE Type) :
+    NullDeviceChild(pDevice),
+    m_Type(Type),
+    m_Closed(false)
+{
+}
+
+HRESULT NullCommandList::Close(void)
+{
+    if (m_Closed)
+        return E_FAIL;
+    m_Closed = true;
+    return S_OK;
+}
+
+HRESULT NullCommandList::Reset(ID3D12CommandAllocator*, ID3D12PipelineState*)
+{
+    if (!m_Closed)
+        return E_FAIL;
+    m_Closed = false;
+    m_Stats = NullCommandStats();
+    m_BufferCopies.clear();
+    m_ComputeTables.clear();
+    m_GraphicsTables.clear();
+    return S_OK;
+}
+
+void NullCommandList::CopyBufferRegion(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer,
+    UINT64 SrcOffset, UINT64 NumBytes)
+{
+    NullResource* Dest = AsNullResource(pDstBuffer);
+    NullResource* Source = AsNullResource(pSrcBuffer);
+    ASSERT(DstOffset + NumBytes <= Dest->GetDesc().Width && SrcOffset + NumBytes <= Source->GetDesc().Width,
+        "Buffer copy out of range");
+
+    m_BufferCopies.push_back({ Dest, DstOffset, Source, SrcOffset, NumBytes });
+    ++m_Stats.BufferCopies;
+    m_Stats.BytesCopied += NumBytes;
+}
+
+void NullCommandList::CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource)
+{
+    if (pDstResource->GetDesc().Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        CopyBufferRegion(pDstResource, 0, pSrcResource, 0, pSrcResource->GetDesc().Width);
+    else
+        ++m_Stats.TextureCopies;
+}
+
+//
+// NullDeviceFence
+//
+
+NullDeviceFence::NullDeviceFence(NullDevice* pDevice, UINT64 InitialValue) :
+    NullDeviceChild(pDevice),
+    m_Value(InitialValue)
+{
+}
+
+HRESULT NullDeviceFence::SetEventOnCompletion(UINT64 Value, HANDLE hEvent)
+{
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        if (GetCompletedValue() < Value)
+        {
+            m_Waiting.emplace_back(Value, hEvent);
+            return S_OK;
+        }
+    }
+    static_cast<NullEvent*>(hEvent)->Set();
+    return S_OK;
+}
+
+HRESULT NullDeviceFence::Signal(UINT64 Value)
+{
+    std::vector<HANDLE> Reached;
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        m_Value.store(Value, std::memory_order_release);
+
+        for (size_t i = 0; i < m_Waiting.size();)
+        {
+            if (m_Waiting[i].first <= Value)
+            {
+                Reached.push_back(m_Waiting[i].second);
+                m_Waiting[i] = m_Waiting.back();
+                m_Waiting.pop_back();
+            }
+            else
+                ++i;
+        }
+    }
+
+    for (HANDLE Event : Reached)
+        static_cast<NullEvent*>(Event)->Set();
+    return S_OK;
+}
+
+//
+// NullCommandQueue
+//
+
+void NullCommandQueue::ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists)
+{
+    for (UINT i = 0; i < NumCommandLists; ++i)
+    {
+        NullCommandList* List = static_cast<NullCommandList*>(ppCommandLists[i]);
+        ASSERT(List->IsClosed(), "Executing a command list that is still recording");
+        ASSERT(List->GetType() == m_Desc.Type, "Command list type does not match the queue");
+
+        for (const NullCommandList::BufferCopy& Copy : List->GetBufferCopies())
+        {
+            memmove(Copy.Dest->GetMemory() + Copy.DestOffset, Copy.Source->GetMemory() + Copy.SourceOffset,
+                (size_t)Copy.NumBytes);
+        }
+
+        NullCommandStats Stats = List->GetStats();
+        Stats.ExecutedLists = 1;
+        GetNullDevice()->AddExecuted(Stats);
+    }
+}
+
+HRESULT NullCommandQueue::Signal(ID3D12Fence* pFence, UINT64 Value)
+{
+    GetNullDevice()->SignalFence(static_cast<NullDeviceFence*>(pFence), Value);
+    return S_OK;
+}
+
+//
+// NullDevice
+//
+
+NullDevice::~NullDevice()
+{
+    SetGpuPaused(false);
+}
+
+HRESULT NullDevice::CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID, void** ppCommandQueue)
+{
+    *ppCommandQueue = static_cast<ID3D12CommandQueue*>(new NullCommandQueue(this, *pDesc));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE, REFIID, void** ppCommandAllocator)
+{
+    *ppCommandAllocator = static_cast<ID3D12CommandAllocator*>(new NullCommandAllocator(this));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreateCommandList(UINT, D3D12_COMMAND_LIST_TYPE Type, ID3D12CommandAllocator*,
+    ID3D12PipelineState*, REFIID, void** ppCommandList)
+{
+    // the interface is picked by the caller's pointer type, which is always the graphics list
+    *ppCommandList = static_cast<ID3D12GraphicsCommandList*>(new NullCommandList(this, Type));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS, REFIID, void** ppFence)
+{
+    *ppFence = static_cast<ID3D12Fence*>(new NullDeviceFence(this, InitialValue));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, REFIID,
+    void** ppPipelineState)
+{
+    if (pDesc->pRootSignature == nullptr)
+        return E_INVALIDARG;
+
+    ++m_PipelineStatesCreated;
+    *ppPipelineState = static_cast<ID3D12PipelineState*>(new NullPipelineState(this));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID,
+    void** ppPipelineState)
+{
+    if (pDesc->pRootSignature == nullptr)
+        return E_INVALIDARG;
+
+    ++m_PipelineStatesCreated;
+    *ppPipelineState = static_cast<ID3D12PipelineState*>(new NullPipelineState(this));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreateRootSignature(UINT, const void* pBlobWithRootSignature, SIZE_T BlobLengthInBytes, REFIID,
+    void** ppvRootSignature)
+{
+    if (pBlobWithRootSignature == nullptr || BlobLengthInBytes == 0)
+        return E_INVALIDARG;
+
+    ++m_RootSignaturesCreated;
+    *ppvRootSignature = static_cast<ID3D12RootSignature*>(new NullRootSignature(this));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC* pDesc, ID3D12RootSignature*, REFIID,
+    void** ppvCommandSignature)
+{
+    if (pDesc->NumArgumentDescs == 0)
+        return E_INVALIDARG;
+
+    *ppvCommandSignature = static_cast<ID3D12CommandSignature*>(new NullCommandSignature(this));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreateCommittedResource(const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS,
+    const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void** ppvResource)
+{
+    if (pDesc->Dimension == D3D12_RESOURCE_DIMENSION_BUFFER && pDesc->Width == 0)
+        return E_INVALIDARG;
+
+    *ppvResource = static_cast<ID3D12Resource*>(new NullResource(this, *pDesc, pHeapProperties->Type));
+    return S_OK;
+}
+
+HRESULT NullDevice::CreatePlacedResource(ID3D12Heap*, UINT64, const D3D12_RESOURCE_DESC* pDesc,
+    D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void** ppvResource)
+{
+    // no heaps here, a placed resource gets memory of its own
+    *ppvResource = static_cast<ID3D12Resource*>(new NullResource(this, *pDesc, D3D12_HEAP_TYPE_DEFAULT));
+    return S_OK;
+}
+
+// Rows are padded to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and subresources start on
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, like the real layout of an upload buffer
+void NullDevice::GetCopyableFootprints(const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource,
+    UINT NumSubresources, UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows,
+    UINT64* pRowSizeInBytes, UINT64* pTotalBytes)
+{
+    const D3D12_RESOURCE_DESC& Desc = *pResourceDesc;
+    const bool IsBuffer = Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER;
+    const UINT MipLevels = IsBuffer ? 1 : std::max<UINT>(Desc.MipLevels, 1);
+    const bool Is3D = Desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+
+    UINT64 Offset = BaseOffset;
+    UINT64 Total = 0;
+    for (UINT i = 0; i < NumSubresources; ++i)
+    {
+        const UINT Subresource = FirstSubresource + i;
+        const UINT Mip = Subresource % MipLevels;
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT Layout = {};
+        UINT NumRows;
+        UINT64 RowSize;
+        if (IsBuffer)
+        {
+            Layout.Footprint.Format = DXGI_FORMAT_UNKNOWN;
+            Layout.Footprint.Width = (UINT)Desc.Width;
+            Layout.Footprint.Height = 1;
+            Layout.Footprint.Depth = 1;
+            Layout.Footprint.RowPitch = (UINT)Math::AlignUp(Desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+            NumRows = 1;
+            RowSize = Desc.Width;
+        }
+        else
+        {
+            Layout.Footprint.Format = Desc.Format;
+            Layout.Footprint.Width = std::max<UINT>((UINT)(Desc.Width >> Mip), 1);
+            Layout.Footprint.Height = std::max<UINT>(Desc.Height >> Mip, 1);
+            Layout.Footprint.Depth = Is3D ? std::max<UINT>(Desc.DepthOrArraySize >> Mip, 1) : 1;
+
+            size_t RowBytes, Rows;
+            GetSurfaceInfo(Layout.Footprint.Width, Layout.Footprint.Height, Desc.Format, nullptr, &RowBytes, &Rows);
+            Layout.Footprint.RowPitch = (UINT)Math::AlignUp(RowBytes, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+            NumRows = (UINT)Rows;
+            RowSize = RowBytes;
+        }
+
+        Offset = Math::AlignUp(Offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        Layout.Offset = Offset;
+        const UINT64 Size = IsBuffer ? Desc.Width :
+            (UINT64)Layout.Footprint.RowPitch * NumRows * Layout.Footprint.Depth;
+
+        if (pLayouts != nullptr)
+            pLayouts[i] = Layout;
+        if (pNumRows != nullptr)
+            pNumRows[i] = NumRows;
+        if (pRowSizeInBytes != nullptr)
+            pRowSizeInBytes[i] = RowSize;
+
+        Total = Offset + Size - BaseOffset;
+        Offset += Size;
+    }
+
+    if (pTotalBytes != nullptr)
+        *pTotalBytes = Total;
+}
+
+HRESULT NullDevice::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID, void** ppvHeap)
+{
+    if (pDescriptorHeapDesc->NumDescriptors == 0)
+        return E_INVALIDARG;
+
+    ++m_DescriptorHeapsCreated;
+    *ppvHeap = static_cast<ID3D12DescriptorHeap*>(new NullDescriptorHeap(this, *pDescriptorHeapDesc));
+    return S_OK;
+}
+
+void NullDevice::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc,
+    D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+{
+    ASSERT(Math::IsAligned(pDesc->SizeInBytes, 256), "Constant buffer views are multiples of 256 bytes");
+    GetDescriptor(DestDescriptor) = { NullDescriptor::kCBV, DXGI_FORMAT_UNKNOWN, nullptr, pDesc->BufferLocation,
+        pDesc->SizeInBytes };
+}
+
+void NullDevice::CreateShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+    D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+{
+    const DXGI_FORMAT Format = pDesc != nullptr ? pDesc->Format :
+        pResource != nullptr ? pResource->GetDesc().Format : DXGI_FORMAT_UNKNOWN;
+    const UINT64 Size = pResource != nullptr ? pResource->GetDesc().Width : 0;
+    GetDescriptor(DestDescriptor) = { NullDescriptor::kSRV, Format, pResource, AddressOf(pResource), Size };
+}
+
+void NullDevice::CreateUnorderedAccessView(ID3D12Resource* pResource, ID3D12Resource*,
+    const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+{
+    const DXGI_FORMAT Format = pDesc != nullptr ? pDesc->Format :
+        pResource != nullptr ? pResource->GetDesc().Format : DXGI_FORMAT_UNKNOWN;
+    const UINT64 Size = pResource != nullptr ? pResource->GetDesc().Width : 0;
+    GetDescriptor(DestDescriptor) = { NullDescriptor::kUAV, Format, pResource, AddressOf(pResource), Size };
+}
+
+void NullDevice::CreateSampler(const D3D12_SAMPLER_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor)
+{
+    GetDescriptor(DestDescriptor) = { NullDescriptor::kSampler, DXGI_FORMAT_UNKNOWN, nullptr, 0, 0 };
+}
+
+void NullDevice::CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+    const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges,
+    const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts, const UINT* pSrcDescriptorRangeSizes,
+    D3D12_DESCRIPTOR_HEAP_TYPE)
+{
+    // both sides cover the same number of descriptors, split into ranges differently
+    UINT DestRange = 0, DestIndex = 0;
+    for (UINT SrcRange = 0; SrcRange < NumSrcDescriptorRanges; ++SrcRange)
+    {
+        const UINT SrcSize = pSrcDescriptorRangeSizes != nullptr ? pSrcDescriptorRangeSizes[SrcRange] : 1;
+        for (UINT SrcIndex = 0; SrcIndex < SrcSize; ++SrcIndex)
+        {
+            while (DestRange < NumDestDescriptorRanges &&
+                DestIndex == (pDestDescriptorRangeSizes != nullptr ? pDestDescriptorRangeSizes[DestRange] : 1))
+            {
+                ++DestRange;
+                DestIndex = 0;
+            }
+            ASSERT(DestRange < NumDestDescriptorRanges, "More source descriptors than destinations");
+
+            const NullDescriptor* Source = reinterpret_cast<const NullDescriptor*>(pSrcDescriptorRangeStarts[SrcRange].ptr) + SrcIndex;
+            NullDescriptor* Dest = reinterpret_cast<NullDescriptor*>(pDestDescriptorRangeStarts[DestRange].ptr) + DestIndex;
+            *Dest = *Source;
+            ++DestIndex;
+        }
+    }
+}
+
+void NullDevice::CopyDescriptorsSimple(UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart,
+    D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE)
+{
+    memmove(reinterpret_cast<void*>(DestDescriptorRangeStart.ptr), reinterpret_cast<const void*>(SrcDescriptorRangeStart.ptr),
+        NumDescriptors * sizeof(NullDescriptor));
+}
+
+HRESULT NullDevice::CheckFeatureSupport(D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize)
+{
+    if (Feature != D3D12_FEATURE_D3D12_OPTIONS || FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))
+        return E_INVALIDARG;
+
+    D3D12_FEATURE_DATA_D3D12_OPTIONS& Options = *static_cast<D3D12_FEATURE_DATA_D3D12_OPTIONS*>(pFeatureSupportData);
+    Options = {};
+    Options.ResourceBindingTier = D3D12_RESOURCE_BINDING_TIER_3;
+    return S_OK;
+}
+
+void NullDevice::SetGpuPaused(bool Paused)
+{
+    std::deque<std::pair<NullDeviceFence*, UINT64>> Held;
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        m_Paused = Paused;
+        if (!Paused)
+            Held.swap(m_HeldSignals);
+    }
+
+    for (auto& Signal : Held)
+    {
+        Signal.first->Signal(Signal.second);
+        Signal.first->Release();
+    }
+}
+
+void NullDevice::SignalFence(NullDeviceFence* pFence, UINT64 Value)
+{
+    {
+        std::lock_guard<std::mutex> LockGuard(m_Mutex);
+        if (m_Paused)
+        {
+            // kept alive until it is signaled
+            pFence->AddRef();
+            m_HeldSignals.emplace_back(pFence, Value);
+            return;
+        }
+    }
+    pFence->Signal(Value);
+}
+
+void NullDevice::AddExecuted(const NullCommandStats& Stats)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+    m_Executed.Draws += Stats.Draws;
+    m_Executed.Dispatches += Stats.Dispatches;
+    m_Executed.Barriers += Stats.Barriers;
+    m_Executed.BarrierCalls += Stats.BarrierCalls;
+    m_Executed.BufferCopies += Stats.BufferCopies;
+    m_Executed.BytesCopied += Stats.BytesCopied;
+    m_Executed.TextureCopies += Stats.TextureCopies;
+    m_Executed.Clears += Stats.Clears;
+    m_Executed.ExecutedLists += Stats.ExecutedLists;
+}
+
+NullCommandStats NullDevice::GetExecutedStats(void)
+{
+    std::lock_guard<std::mutex> LockGuard(m_Mutex);
+    return m_Executed;
+}
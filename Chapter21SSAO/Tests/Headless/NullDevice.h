@@ -0,0 +1,380 @@
+#pragma once
+
+#include "pch.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+
+// A D3D12 device without a GPU, enough to run the engine's recording and recycling code on
+// the CPU. Buffers are malloc'd and their GPU address is their host address, so Map hands out
+// the same memory a copy reads and writes. Textures get a description but no memory. Descriptor
+// heaps are arrays of NullDescriptor, a handle is the address of one, so copying descriptors
+// copies what the views were created from. Command lists count what is recorded and keep the
+// buffer copies, which the queue performs when the list is executed. Fences complete as soon as
+// the queue signals them, unless the GPU is paused, which lets a test hold work in flight.
+//
+// Like the real API, objects are reference counted and created with a reference held by the
+// caller. Children point at the device without holding it.
+
+class NullDevice;
+
+struct NullDescriptor
+{
+    enum eKind : uint32_t { kNone, kCBV, kSRV, kUAV, kRTV, kDSV, kSampler };
+
+    eKind Kind;
+    DXGI_FORMAT Format;
+    ID3D12Resource* Resource;
+    D3D12_GPU_VIRTUAL_ADDRESS Address;
+    UINT64 Size;
+};
+
+// What the command lists recorded, summed over everything a queue executed
+struct NullCommandStats
+{
+    uint64_t Draws = 0;
+    uint64_t Dispatches = 0;
+    uint64_t Barriers = 0;
+    uint64_t BarrierCalls = 0;
+    uint64_t BufferCopies = 0;
+    uint64_t BytesCopied = 0;
+    uint64_t TextureCopies = 0;
+    uint64_t Clears = 0;
+    uint64_t ExecutedLists = 0;
+};
+
+template <typename Interface>
+class NullObject : public Interface
+{
+public:
+    virtual HRESULT SetName(LPCWSTR Name) override
+    {
+        m_Name = Name != nullptr ? Name : L"";
+        return S_OK;
+    }
+
+    const std::wstring& GetName(void) const { return m_Name; }
+
+private:
+    std::wstring m_Name;
+};
+
+template <typename Interface>
+class NullDeviceChild : public NullObject<Interface>
+{
+public:
+    explicit NullDeviceChild(NullDevice* pDevice) : m_Device(pDevice) {}
+
+    virtual HRESULT GetDevice(REFIID riid, void** ppvDevice) override;
+
+    NullDevice* GetNullDevice(void) const { return m_Device; }
+
+private:
+    NullDevice* m_Device;
+};
+
+// Serialized root signatures, and shader binaries a test hands to a PSO
+class NullBlob : public ID3DBlob
+{
+public:
+    explicit NullBlob(std::vector<uint8_t>&& Bytes) : m_Bytes(std::move(Bytes)) {}
+
+    virtual void* GetBufferPointer(void) override { return m_Bytes.data(); }
+    virtual SIZE_T GetBufferSize(void) override { return m_Bytes.size(); }
+
+private:
+    std::vector<uint8_t> m_Bytes;
+};
+
+class NullResource : public NullDeviceChild<ID3D12Resource>
+{
+public:
+    NullResource(NullDevice* pDevice, const D3D12_RESOURCE_DESC& Desc, D3D12_HEAP_TYPE HeapType);
+    ~NullResource();
+
+    virtual HRESULT Map(UINT Subresource, const D3D12_RANGE* pReadRange, void** ppData) override;
+    virtual void Unmap(UINT Subresource, const D3D12_RANGE* pWrittenRange) override;
+    virtual D3D12_RESOURCE_DESC GetDesc(void) const override { return m_Desc; }
+    virtual D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress(void) const override
+    {
+        return (D3D12_GPU_VIRTUAL_ADDRESS)(uintptr_t)m_Memory;
+    }
+
+    D3D12_HEAP_TYPE GetHeapType(void) const { return m_HeapType; }
+    uint8_t* GetMemory(void) const { return m_Memory; }
+    int GetMapCount(void) const { return m_MapCount.load(); }
+
+private:
+    D3D12_RESOURCE_DESC m_Desc;
+    D3D12_HEAP_TYPE m_HeapType;
+    uint8_t* m_Memory;
+    std::atomic<int> m_MapCount;
+};
+
+class NullDescriptorHeap : public NullDeviceChild<ID3D12DescriptorHeap>
+{
+public:
+    // Shader-visible heaps report GPU handles this far above their CPU ones
+    static const uint64_t kGpuHandleBias = 1ull << 48;
+
+    NullDescriptorHeap(NullDevice* pDevice, const D3D12_DESCRIPTOR_HEAP_DESC& Desc);
+
+    virtual D3D12_DESCRIPTOR_HEAP_DESC GetDesc(void) const override { return m_Desc; }
+    virtual D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart(void) const override;
+    virtual D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart(void) const override;
+
+private:
+    D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+    std::vector<NullDescriptor> m_Descriptors;
+};
+
+class NullCommandList : public NullDeviceChild<ID3D12GraphicsCommandList>
+{
+public:
+    struct BufferCopy
+    {
+        NullResource* Dest;
+        UINT64 DestOffset;
+        NullResource* Source;
+        UINT64 SourceOffset;
+        UINT64 NumBytes;
+    };
+
+    NullCommandList(NullDevice* pDevice, D3D12_COMMAND_LIST_TYPE Type);
+
+    virtual D3D12_COMMAND_LIST_TYPE GetType(void) const override { return m_Type; }
+    virtual HRESULT Close(void) override;
+    virtual HRESULT Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState) override;
+
+    virtual void DrawInstanced(UINT, UINT, UINT, UINT) override { ++m_Stats.Draws; }
+    virtual void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) override { ++m_Stats.Draws; }
+    virtual void Dispatch(UINT, UINT, UINT) override { ++m_Stats.Dispatches; }
+    virtual void ExecuteIndirect(ID3D12CommandSignature*, UINT, ID3D12Resource*, UINT64, ID3D12Resource*, UINT64) override
+    {
+        ++m_Stats.Draws;
+    }
+
+    virtual void CopyBufferRegion(ID3D12Resource* pDstBuffer, UINT64 DstOffset, ID3D12Resource* pSrcBuffer,
+        UINT64 SrcOffset, UINT64 NumBytes) override;
+    virtual void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION*, UINT, UINT, UINT,
+        const D3D12_TEXTURE_COPY_LOCATION*, const D3D12_BOX*) override { ++m_Stats.TextureCopies; }
+    virtual void CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource) override;
+
+    virtual void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) override {}
+    virtual void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) override {}
+    virtual void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) override {}
+    virtual void RSSetViewports(UINT, const D3D12_VIEWPORT*) override {}
+    virtual void RSSetScissorRects(UINT, const D3D12_RECT*) override {}
+    virtual void OMSetBlendFactor(const FLOAT[4]) override {}
+    virtual void OMSetStencilRef(UINT) override {}
+    virtual void OMSetRenderTargets(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, BOOL,
+        const D3D12_CPU_DESCRIPTOR_HANDLE*) override {}
+    virtual void SetPipelineState(ID3D12PipelineState*) override {}
+    virtual void ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER*) override
+    {
+        m_Stats.Barriers += NumBarriers;
+        ++m_Stats.BarrierCalls;
+    }
+    virtual void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) override {}
+
+    virtual void SetComputeRootSignature(ID3D12RootSignature*) override {}
+    virtual void SetGraphicsRootSignature(ID3D12RootSignature*) override {}
+    virtual void SetComputeRootDescriptorTable(UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE Table) override
+    {
+        SetTable(m_ComputeTables, RootIndex, Table);
+    }
+    virtual void SetGraphicsRootDescriptorTable(UINT RootIndex, D3D12_GPU_DESCRIPTOR_HANDLE Table) override
+    {
+        SetTable(m_GraphicsTables, RootIndex, Table);
+    }
+    virtual void SetComputeRoot32BitConstant(UINT, UINT, UINT) override {}
+    virtual void SetGraphicsRoot32BitConstant(UINT, UINT, UINT) override {}
+    virtual void SetComputeRoot32BitConstants(UINT, UINT, const void*, UINT) override {}
+    virtual void SetGraphicsRoot32BitConstants(UINT, UINT, const void*, UINT) override {}
+    virtual void SetComputeRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override {}
+    virtual void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override {}
+    virtual void SetComputeRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override {}
+    virtual void SetGraphicsRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override {}
+    virtual void SetComputeRootUnorderedAccessView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override {}
+    virtual void SetGraphicsRootUnorderedAccessView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) override {}
+
+    virtual void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CLEAR_FLAGS, FLOAT, UINT8, UINT,
+        const D3D12_RECT*) override { ++m_Stats.Clears; }
+    virtual void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE, const FLOAT[4], UINT, const D3D12_RECT*) override
+    {
+        ++m_Stats.Clears;
+    }
+    virtual void ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE,
+        ID3D12Resource*, const UINT[4], UINT, const D3D12_RECT*) override { ++m_Stats.Clears; }
+    virtual void ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE,
+        ID3D12Resource*, const FLOAT[4], UINT, const D3D12_RECT*) override { ++m_Stats.Clears; }
+
+    virtual void BeginQuery(ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT) override {}
+    virtual void EndQuery(ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT) override {}
+    virtual void ResolveQueryData(ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT, UINT, ID3D12Resource*, UINT64) override {}
+    virtual void SetPredication(ID3D12Resource*, UINT64, D3D12_PREDICATION_OP) override {}
+
+    bool IsClosed(void) const { return m_Closed; }
+    const NullCommandStats& GetStats(void) const { return m_Stats; }
+    const std::vector<BufferCopy>& GetBufferCopies(void) const { return m_BufferCopies; }
+
+    // The last table bound at a root index since the list was reset, zero if none was
+    D3D12_GPU_DESCRIPTOR_HANDLE GetComputeTable(UINT RootIndex) const { return GetTable(m_ComputeTables, RootIndex); }
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGraphicsTable(UINT RootIndex) const { return GetTable(m_GraphicsTables, RootIndex); }
+
+private:
+    static void SetTable(std::vector<D3D12_GPU_DESCRIPTOR_HANDLE>& Tables, UINT RootIndex,
+        D3D12_GPU_DESCRIPTOR_HANDLE Table)
+    {
+        if (Tables.size() <= RootIndex)
+            Tables.resize(RootIndex + 1, D3D12_GPU_DESCRIPTOR_HANDLE{ 0 });
+        Tables[RootIndex] = Table;
+    }
+
+    static D3D12_GPU_DESCRIPTOR_HANDLE GetTable(const std::vector<D3D12_GPU_DESCRIPTOR_HANDLE>& Tables, UINT RootIndex)
+    {
+        return RootIndex < Tables.size() ? Tables[RootIndex] : D3D12_GPU_DESCRIPTOR_HANDLE{ 0 };
+    }
+
+    D3D12_COMMAND_LIST_TYPE m_Type;
+    bool m_Closed;
+    NullCommandStats m_Stats;
+    std::vector<BufferCopy> m_BufferCopies;
+    std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> m_ComputeTables;
+    std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> m_GraphicsTables;
+};
+
+// Its value moves when a queue signals it, SetEventOnCompletion sets the event once it gets there
+class NullDeviceFence : public NullDeviceChild<ID3D12Fence>
+{
+public:
+    NullDeviceFence(NullDevice* pDevice, UINT64 InitialValue);
+
+    virtual UINT64 GetCompletedValue(void) override { return m_Value.load(std::memory_order_acquire); }
+    virtual HRESULT SetEventOnCompletion(UINT64 Value, HANDLE hEvent) override;
+    virtual HRESULT Signal(UINT64 Value) override;
+
+private:
+    std::atomic<UINT64> m_Value;
+
+    std::mutex m_Mutex;
+    std::vector<std::pair<UINT64, HANDLE>> m_Waiting;
+};
+
+class NullCommandQueue : public NullDeviceChild<ID3D12CommandQueue>
+{
+public:
+    NullCommandQueue(NullDevice* pDevice, const D3D12_COMMAND_QUEUE_DESC& Desc) :
+        NullDeviceChild(pDevice), m_Desc(Desc) {}
+
+    virtual void ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists) override;
+    virtual HRESULT Signal(ID3D12Fence* pFence, UINT64 Value) override;
+    virtual HRESULT Wait(ID3D12Fence*, UINT64) override { return S_OK; }
+
+private:
+    D3D12_COMMAND_QUEUE_DESC m_Desc;
+};
+
+class NullDevice : public NullObject<ID3D12Device>
+{
+public:
+    // Descriptor handles step over one NullDescriptor
+    static const UINT kDescriptorSize = sizeof(NullDescriptor);
+
+    NullDevice(void) = default;
+    ~NullDevice();
+
+    virtual HRESULT CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue) override;
+    virtual HRESULT CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE Type, REFIID riid, void** ppCommandAllocator) override;
+    virtual HRESULT CreateCommandList(UINT NodeMask, D3D12_COMMAND_LIST_TYPE Type,
+        ID3D12CommandAllocator* pCommandAllocator, ID3D12PipelineState* pInitialState, REFIID riid,
+        void** ppCommandList) override;
+    virtual HRESULT CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid, void** ppFence) override;
+
+    virtual HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, REFIID riid,
+        void** ppPipelineState) override;
+    virtual HRESULT CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID riid,
+        void** ppPipelineState) override;
+    virtual HRESULT CreateRootSignature(UINT NodeMask, const void* pBlobWithRootSignature,
+        SIZE_T BlobLengthInBytes, REFIID riid, void** ppvRootSignature) override;
+    virtual HRESULT CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC* pDesc,
+        ID3D12RootSignature* pRootSignature, REFIID riid, void** ppvCommandSignature) override;
+
+    virtual HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS HeapFlags,
+        const D3D12_RESOURCE_DESC* pDesc, D3D12_RESOURCE_STATES InitialResourceState,
+        const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riidResource, void** ppvResource) override;
+    virtual HRESULT CreatePlacedResource(ID3D12Heap* pHeap, UINT64 HeapOffset, const D3D12_RESOURCE_DESC* pDesc,
+        D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* pOptimizedClearValue, REFIID riid,
+        void** ppvResource) override;
+    virtual void GetCopyableFootprints(const D3D12_RESOURCE_DESC* pResourceDesc, UINT FirstSubresource,
+        UINT NumSubresources, UINT64 BaseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts, UINT* pNumRows,
+        UINT64* pRowSizeInBytes, UINT64* pTotalBytes) override;
+
+    virtual HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid,
+        void** ppvHeap) override;
+    virtual UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) override { return kDescriptorSize; }
+    virtual void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc,
+        D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+    virtual void CreateShaderResourceView(ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+        D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+    virtual void CreateUnorderedAccessView(ID3D12Resource* pResource, ID3D12Resource* pCounterResource,
+        const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+    virtual void CreateSampler(const D3D12_SAMPLER_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override;
+    virtual void CopyDescriptors(UINT NumDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+        const UINT* pDestDescriptorRangeSizes, UINT NumSrcDescriptorRanges,
+        const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts, const UINT* pSrcDescriptorRangeSizes,
+        D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override;
+    virtual void CopyDescriptorsSimple(UINT NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart,
+        D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override;
+
+    virtual HRESULT CheckFeatureSupport(D3D12_FEATURE Feature, void* pFeatureSupportData,
+        UINT FeatureSupportDataSize) override;
+
+    // While paused, signals are held back and fences stop advancing. Resuming completes them in
+    // the order they were issued.
+    void SetGpuPaused(bool Paused);
+    // Called by the queues
+    void SignalFence(NullDeviceFence* pFence, UINT64 Value);
+    void AddExecuted(const NullCommandStats& Stats);
+
+    // What every queue has executed so far
+    NullCommandStats GetExecutedStats(void);
+
+    int GetLiveResources(void) const { return m_LiveResources.load(); }
+    int GetPipelineStatesCreated(void) const { return m_PipelineStatesCreated.load(); }
+    int GetRootSignaturesCreated(void) const { return m_RootSignaturesCreated.load(); }
+    int GetDescriptorHeapsCreated(void) const { return m_DescriptorHeapsCreated.load(); }
+
+    // NullResource keeps the count of live resources
+    void TrackResource(int Delta) { m_LiveResources += Delta; }
+
+    // The descriptor a handle from one of this device's heaps points at
+    static NullDescriptor& GetDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE Handle)
+    {
+        return *reinterpret_cast<NullDescriptor*>(Handle.ptr);
+    }
+
+    static NullDescriptor& GetDescriptor(D3D12_GPU_DESCRIPTOR_HANDLE Handle)
+    {
+        return *reinterpret_cast<NullDescriptor*>(Handle.ptr - NullDescriptorHeap::kGpuHandleBias);
+    }
+
+private:
+    std::atomic<int> m_LiveResources{ 0 };
+    std::atomic<int> m_PipelineStatesCreated{ 0 };
+    std::atomic<int> m_RootSignaturesCreated{ 0 };
+    std::atomic<int> m_DescriptorHeapsCreated{ 0 };
+
+    std::mutex m_Mutex;
+    NullCommandStats m_Executed;
+    bool m_Paused = false;
+    std::deque<std::pair<NullDeviceFence*, UINT64>> m_HeldSignals;
+};
+
+template <typename Interface>
+HRESULT NullDeviceChild<Interface>::GetDevice(REFIID, void** ppvDevice)
+{
+    m_Device->AddRef();
+    *ppvDevice = static_cast<ID3D12Device*>(m_Device);
+    return S_OK;
+}
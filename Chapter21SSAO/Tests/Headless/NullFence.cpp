@@ -0,0 +1,42 @@
+#include "NullFence.h"
+#include <algorithm>
+
+NullFence::NullFence(uint64_t InitialValue, bool AutoComplete) :
+	m_CompletedValue(InitialValue),
+	m_SignaledValue(InitialValue),
+	m_AutoComplete(AutoComplete)
+{
+}
+
+void NullFence::Signal(uint64_t Value)
+{
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+		if (Value > m_SignaledValue.load())
+			m_SignaledValue.store(Value, std::memory_order_release);
+	}
+
+	if (m_AutoComplete)
+		Complete(Value);
+}
+
+void NullFence::WaitForValue(uint64_t Value)
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+
+	// in either mode only a value that was signaled can ever complete
+	ASSERT(Value <= m_SignaledValue.load(), "Waiting on a value that was never signaled");
+
+	m_Completed.wait(Lock, [this, Value] { return GetCompletedValue() >= Value; });
+}
+
+void NullFence::Complete(uint64_t Value)
+{
+	{
+		std::lock_guard<std::mutex> LockGuard(m_Mutex);
+		Value = std::min(Value, m_SignaledValue.load());
+		if (Value > m_CompletedValue.load())
+			m_CompletedValue.store(Value, std::memory_order_release);
+	}
+	m_Completed.notify_all();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Fence.h"
+#include <atomic>
+#include <condition_variable>
+
+// Fence without a GPU. Signaled values complete immediately in AutoComplete mode, otherwise
+// only when Complete() is called, which lets a test decide exactly when the "GPU" catches up
+// and exercise the retire/recycle paths deterministically. Like a real fence, nothing
+// completes a value before it is signaled.
+class NullFence : public Fence
+{
+public:
+	NullFence(uint64_t InitialValue, bool AutoComplete = true);
+
+	virtual uint64_t GetCompletedValue(void) override { return m_CompletedValue.load(std::memory_order_acquire); }
+	virtual void Signal(uint64_t Value) override;
+	virtual void WaitForValue(uint64_t Value) override;
+
+	// Completes every signaled value up to and including Value, never past the last signal
+	void Complete(uint64_t Value);
+	// Completes everything signaled so far
+	void CompleteAll(void) { Complete(m_SignaledValue.load(std::memory_order_acquire)); }
+
+	void SetAutoComplete(bool AutoComplete) { m_AutoComplete = AutoComplete; }
+
+private:
+	std::atomic<uint64_t> m_CompletedValue;
+	std::atomic<uint64_t> m_SignaledValue;
+	std::atomic<bool> m_AutoComplete;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Completed;
+};
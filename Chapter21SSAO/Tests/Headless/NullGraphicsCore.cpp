@@ -0,0 +1,58 @@
+#include "pch.h"
+#include "GraphicsCore.h"
+#include "CommandListManager.h"
+#include "CommandContext.h"
+#include "PipelineState.h"
+#include "RootSignature.h"
+#include "DynamicDescriptorHeap.h"
+#include "NullDevice.h"
+
+// Stands in for Core/GraphicsCore.cpp: the same globals, brought up on a NullDevice instead
+// of an adapter. There is no swap chain and no common state, whose shaders are compiled by
+// Visual Studio.
+
+namespace Graphics
+{
+    ID3D12Device* g_Device = nullptr;
+    CommandListManager g_CommandManager;
+    ContextManager g_ContextManager;
+
+    DescriptorAllocator g_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] =
+    {
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+        D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER,
+        D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
+        D3D12_DESCRIPTOR_HEAP_TYPE_DSV
+    };
+
+    BindlessDescriptorHeap g_BindlessHeap;
+}
+
+void Graphics::Initialize(bool)
+{
+    g_Device = new NullDevice;
+
+    g_CommandManager.Create(g_Device);
+
+    g_BindlessHeap.Create(L"Bindless Heap");
+}
+
+// In the order of the real Shutdown, plus the pages and contexts it leaves to the process exit,
+// so leak checkers see a clean heap
+void Graphics::Shutdown(void)
+{
+    g_CommandManager.IdleGPU();
+    g_CommandManager.ShutDown();
+
+    PSO::DesytroyAll();
+    RootSignature::DestroyAll();
+    DescriptorAllocator::DestroyAll();
+    CommandContext::DestroyAllContexts();
+    g_BindlessHeap.Destroy();
+
+    if (g_Device != nullptr)
+    {
+        g_Device->Release();
+        g_Device = nullptr;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Stands in for Core/Utils/Utility.h, whose printing goes through the Windows debugger.
+
+#include "pch.h"
+
+namespace Utility
+{
+    inline void Print(const char* msg) { printf("%s", msg); }
+    inline void Print(const wchar_t* msg) { printf("%ls", msg); }
+
+    inline void Printf(const char* format, ...)
+    {
+        va_list ap;
+        va_start(ap, format);
+        vprintf(format, ap);
+        va_end(ap);
+    }
+
+    inline void Printf(const wchar_t* format, ...)
+    {
+        wchar_t buffer[256];
+        va_list ap;
+        va_start(ap, format);
+        vswprintf(buffer, 256, format, ap);
+        va_end(ap);
+        Print(buffer);
+    }
+
+    // The tests only use ASCII paths
+    inline std::wstring UTF8ToWideString(const std::string& str)
+    {
+        return std::wstring(str.begin(), str.end());
+    }
+}
+
+// Utility.cpp copies with SSE stores, a plain copy of the same 16-byte units does here
+inline void SIMDMemCopy(void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords)
+{
+    memcpy(Dest, Source, NumQuadwords * 16);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// Stands in for Core/Utils/VectorMath.h. DirectXMath is not available headless; Core's
+// device code only uses the integer helpers of Math/Common.h, copied here.
+
+#include <cstddef>
+
+namespace Math
+{
+    template <typename T> inline T AlignUpWithMask(T value, size_t mask)
+    {
+        return (T)(((size_t)value + mask) & ~mask);
+    }
+
+    template <typename T> inline T AlignDownWithMask(T value, size_t mask)
+    {
+        return (T)((size_t)value & ~mask);
+    }
+
+    template <typename T> inline T AlignUp(T value, size_t alignment)
+    {
+        return AlignUpWithMask(value, alignment - 1);
+    }
+
+    template <typename T> inline T AlignDown(T value, size_t alignment)
+    {
+        return AlignDownWithMask(value, alignment - 1);
+    }
+
+    template <typename T> inline bool IsAligned(T value, size_t alignment)
+    {
+        return 0 == ((size_t)value & (alignment - 1));
+    }
+
+    template <typename T> inline T DivideByMultiple(T value, size_t alignment)
+    {
+        return (T)((value + alignment - 1) / alignment);
+    }
+
+    template <typename T> inline bool IsPowerOfTwo(T value)
+    {
+        return 0 == (value & (value - 1));
+    }
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Stands in for <d3dcompiler.h>. Nothing is compiled headless, PipelineState.h only needs
+// ID3DBlob, which the mock declares in d3d12.h.
+
+#include <d3d12.h>
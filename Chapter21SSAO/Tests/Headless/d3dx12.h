@@ -0,0 +1,117 @@
+#pragma once
+
+// Stands in for Core/Utils/d3dx12.h: the helpers Core uses, written against the mock API of
+// d3d12.h. UpdateSubresources lays the data out the way the real helper does, so the copies a
+// test sees are the ones a GPU would get.
+
+#include <d3d12.h>
+#include <cstring>
+#include <vector>
+
+struct CD3DX12_RANGE : public D3D12_RANGE
+{
+    CD3DX12_RANGE(void) = default;
+    CD3DX12_RANGE(SIZE_T begin, SIZE_T end)
+    {
+        Begin = begin;
+        End = end;
+    }
+};
+
+struct CD3DX12_RECT : public D3D12_RECT
+{
+    CD3DX12_RECT(void) = default;
+    CD3DX12_RECT(LONG Left, LONG Top, LONG Right, LONG Bottom)
+    {
+        left = Left;
+        top = Top;
+        right = Right;
+        bottom = Bottom;
+    }
+};
+
+struct CD3DX12_SHADER_BYTECODE : public D3D12_SHADER_BYTECODE
+{
+    CD3DX12_SHADER_BYTECODE(void) = default;
+    CD3DX12_SHADER_BYTECODE(const void* _pShaderBytecode, SIZE_T bytecodeLength)
+    {
+        pShaderBytecode = _pShaderBytecode;
+        BytecodeLength = bytecodeLength;
+    }
+};
+
+inline ID3D12Device* D3DX12GetResourceDevice(ID3D12Resource* pResource)
+{
+    ID3D12Device* pDevice = nullptr;
+    pResource->GetDevice(IID_PPV_ARGS(&pDevice));
+    pDevice->Release();
+    return pDevice;
+}
+
+// Size of the upload buffer that holds the given subresources
+inline UINT64 GetRequiredIntermediateSize(ID3D12Resource* pDestinationResource, UINT FirstSubresource,
+    UINT NumSubresources)
+{
+    D3D12_RESOURCE_DESC Desc = pDestinationResource->GetDesc();
+    UINT64 RequiredSize = 0;
+    D3DX12GetResourceDevice(pDestinationResource)->GetCopyableFootprints(&Desc, FirstSubresource, NumSubresources, 0,
+        nullptr, nullptr, nullptr, &RequiredSize);
+    return RequiredSize;
+}
+
+// Copies the subresources into the upload buffer at their footprints, then records the copies
+// from there into the destination
+inline UINT64 UpdateSubresources(ID3D12GraphicsCommandList* pCmdList, ID3D12Resource* pDestinationResource,
+    ID3D12Resource* pIntermediate, UINT64 IntermediateOffset, UINT FirstSubresource, UINT NumSubresources,
+    const D3D12_SUBRESOURCE_DATA* pSrcData)
+{
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts(NumSubresources);
+    std::vector<UINT> NumRows(NumSubresources);
+    std::vector<UINT64> RowSizesInBytes(NumSubresources);
+    UINT64 RequiredSize = 0;
+
+    D3D12_RESOURCE_DESC Desc = pDestinationResource->GetDesc();
+    D3DX12GetResourceDevice(pDestinationResource)->GetCopyableFootprints(&Desc, FirstSubresource, NumSubresources,
+        IntermediateOffset, Layouts.data(), NumRows.data(), RowSizesInBytes.data(), &RequiredSize);
+
+    D3D12_RESOURCE_DESC IntermediateDesc = pIntermediate->GetDesc();
+    if (IntermediateDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER ||
+        IntermediateDesc.Width < RequiredSize + Layouts[0].Offset)
+        return 0;
+
+    BYTE* pData;
+    if (FAILED(pIntermediate->Map(0, nullptr, reinterpret_cast<void**>(&pData))))
+        return 0;
+
+    for (UINT i = 0; i < NumSubresources; ++i)
+    {
+        const D3D12_SUBRESOURCE_FOOTPRINT& Footprint = Layouts[i].Footprint;
+        for (UINT z = 0; z < Footprint.Depth; ++z)
+        {
+            BYTE* pDestSlice = pData + Layouts[i].Offset + (SIZE_T)Footprint.RowPitch * NumRows[i] * z;
+            const BYTE* pSrcSlice = static_cast<const BYTE*>(pSrcData[i].pData) + pSrcData[i].SlicePitch * z;
+            for (UINT y = 0; y < NumRows[i]; ++y)
+                memcpy(pDestSlice + (SIZE_T)Footprint.RowPitch * y, pSrcSlice + pSrcData[i].RowPitch * y,
+                    (SIZE_T)RowSizesInBytes[i]);
+        }
+    }
+    pIntermediate->Unmap(0, nullptr);
+
+    if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        pCmdList->CopyBufferRegion(pDestinationResource, 0, pIntermediate, Layouts[0].Offset,
+            Layouts[0].Footprint.Width);
+    }
+    else
+    {
+        for (UINT i = 0; i < NumSubresources; ++i)
+        {
+            D3D12_TEXTURE_COPY_LOCATION Dst = { pDestinationResource, D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, {} };
+            Dst.SubresourceIndex = i + FirstSubresource;
+            D3D12_TEXTURE_COPY_LOCATION Src = { pIntermediate, D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT, {} };
+            Src.PlacedFootprint = Layouts[i];
+            pCmdList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+        }
+    }
+    return RequiredSize;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+// Stands in for Core/Utils/pch.h when Core is built for the headless tests. It comes first
+// on the include path, so "pch.h" resolves here; the Windows SDK is not available, only the
+// handful of names Core uses is declared, and <d3d12.h> is the mock next to this file, which
+// NullDevice.h implements.
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cwctype>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+#include <wrl/client.h>
+#include <d3d12.h>
+
+// The real pch.h opens DirectX through Color.h, and units like DDSLayout.cpp rely on it
+namespace DirectX {}
+using namespace DirectX;
+
+template <typename T, size_t N> char (&_countof_helper(T (&)[N]))[N];
+#define _countof(a) (sizeof(_countof_helper(a)))
+
+#define D3D12_GPU_VIRTUAL_ADDRESS_NULL      ((D3D12_GPU_VIRTUAL_ADDRESS)0)
+#define D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN   ((D3D12_GPU_VIRTUAL_ADDRESS)-1)
+#define MY_IID_PPV_ARGS                     IID_PPV_ARGS
+
+#define ZeroMemory(Destination, Length) memset((Destination), 0, (Length))
+
+// The bit scans of <intrin.h>: the index of the lowest or highest set bit, false for zero
+inline unsigned char _BitScanForward(unsigned long* Index, unsigned long Mask)
+{
+    if (Mask == 0)
+        return 0;
+    *Index = (unsigned long)__builtin_ctzl(Mask);
+    return 1;
+}
+
+inline unsigned char _BitScanReverse(unsigned long* Index, unsigned long Mask)
+{
+    if (Mask == 0)
+        return 0;
+    *Index = (unsigned long)(sizeof(unsigned long) * 8 - 1 - __builtin_clzl(Mask));
+    return 1;
+}
+
+inline unsigned char _BitScanForward64(unsigned long* Index, uint64_t Mask)
+{
+    if (Mask == 0)
+        return 0;
+    *Index = (unsigned long)__builtin_ctzll(Mask);
+    return 1;
+}
+
+inline unsigned char _BitScanReverse64(unsigned long* Index, uint64_t Mask)
+{
+    if (Mask == 0)
+        return 0;
+    *Index = (unsigned long)(63 - __builtin_clzll(Mask));
+    return 1;
+}
+
+// Failed assertions end the test run, the message says where
+#define ASSERT( isFalse, ... ) \
+    if (!(bool)(isFalse)) { \
+        fprintf(stderr, "\nAssertion failed in %s @ %d\n--> '%s' is false\n", __FILE__, __LINE__, #isFalse); \
+        abort(); \
+    }
+
+#define ASSERT_SUCCEEDED( hr, ... ) ASSERT(SUCCEEDED(hr))
+#define WARN_ONCE_IF( isTrue, ... ) (void)(isTrue)
+#define WARN_ONCE_IF_NOT( isTrue, ... ) (void)(isTrue)
+#define DEBUGPRINT( msg, ... ) do {} while(0)
+
+#include "d3dx12.h"
+#include "Utility.h"
+#include "VectorMath.h"
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+
+// Microsoft::WRL::ComPtr for the mock interfaces of d3d12.h: holds one reference, no QueryInterface.
+namespace Microsoft
+{
+    namespace WRL
+    {
+        template <typename T>
+        class ComPtr
+        {
+        public:
+            ComPtr(void) = default;
+            ComPtr(T* Ptr) : m_Ptr(Ptr) { if (m_Ptr) m_Ptr->AddRef(); }
+            ComPtr(const ComPtr& Other) : ComPtr(Other.m_Ptr) {}
+            ComPtr(ComPtr&& Other) : m_Ptr(Other.m_Ptr) { Other.m_Ptr = nullptr; }
+            ~ComPtr(void) { Reset(); }
+
+            ComPtr& operator=(const ComPtr& Other)
+            {
+                ComPtr Copy(Other);
+                Swap(Copy);
+                return *this;
+            }
+
+            ComPtr& operator=(ComPtr&& Other)
+            {
+                ComPtr Moved(static_cast<ComPtr&&>(Other));
+                Swap(Moved);
+                return *this;
+            }
+
+            ComPtr& operator=(T* Ptr)
+            {
+                ComPtr Copy(Ptr);
+                Swap(Copy);
+                return *this;
+            }
+
+            explicit operator bool(void) const { return m_Ptr != nullptr; }
+            bool operator==(std::nullptr_t) const { return m_Ptr == nullptr; }
+            bool operator!=(std::nullptr_t) const { return m_Ptr != nullptr; }
+
+            T* Get(void) const { return m_Ptr; }
+            T* operator->(void) const { return m_Ptr; }
+            T** GetAddressOf(void) { return &m_Ptr; }
+            T** ReleaseAndGetAddressOf(void) { Reset(); return &m_Ptr; }
+            T** operator&(void) { return ReleaseAndGetAddressOf(); }
+
+            // Takes over a reference without adding one, and hands it back
+            void Attach(T* Ptr)
+            {
+                Reset();
+                m_Ptr = Ptr;
+            }
+            T* Detach(void)
+            {
+                T* Ptr = m_Ptr;
+                m_Ptr = nullptr;
+                return Ptr;
+            }
+
+            void Reset(void)
+            {
+                if (m_Ptr)
+                    m_Ptr->Release();
+                m_Ptr = nullptr;
+            }
+
+        private:
+            void Swap(ComPtr& Other)
+            {
+                T* Ptr = m_Ptr;
+                m_Ptr = Other.m_Ptr;
+                Other.m_Ptr = Ptr;
+            }
+
+            T* m_Ptr = nullptr;
+        };
+    }
+}
@@ -0,0 +1,313 @@
+#include "TestHarness.h"
+#include "IndirectCulling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <pmmintrin.h>
+#define HAS_FLUSH_TO_ZERO 1
+#endif
+
+// CullInstances against two references over random scenes, with worlds scaled down into
+// denormals and denormal inputs among them. The first does what CSCullInstances.hlsl does in
+// plain float arithmetic, one rounding per step, with the CPU flushing denormals the way the
+// GPU does, in groups of kIndirectCullGroupSize compacted by a prefix sum; commands and counts
+// must match it bit for bit. The second is a double precision sphere test, which the cull must
+// agree with wherever a sphere is not within a hair of a plane. Commands past a batch's count
+// are left alone.
+
+namespace
+{
+    const uint32_t kUntouched = 0xDEAD;
+
+    struct Scene
+    {
+        float Planes[6][4];
+        std::vector<float> Worlds;      // transposed, 16 floats each
+        std::vector<Utility::IndirectInstance> Instances;
+        std::vector<Utility::IndirectBatch> Batches;
+    };
+
+    Scene RandomScene(std::mt19937& Random)
+    {
+        std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+        const uint32_t kObjects = 300;
+
+        Scene S;
+        for (float* Plane : S.Planes)
+        {
+            float Normal[3] = { Unit(Random), Unit(Random), Unit(Random) };
+            const float Length = std::sqrt(Normal[0] * Normal[0] + Normal[1] * Normal[1] + Normal[2] * Normal[2]);
+            for (int i = 0; i < 3; ++i)
+                Plane[i] = Normal[i] / Length;
+            // through the origin, so the worlds scaled by 1e-20 square to denormal distances
+            Plane[3] = Random() % 3 == 0 ? 0.0f : 5.0f * Unit(Random) + 3.0f;
+        }
+
+        S.Worlds.resize(kObjects * 16);
+        for (uint32_t o = 0; o < kObjects; ++o)
+        {
+            float* World = &S.Worlds[o * 16];
+            for (int k = 0; k < 16; ++k)
+                World[k] = Unit(Random) * (k % 5 == 0 ? 3.0f : 1.0f);
+            if (o % 17 == 0)
+            {
+                for (int k = 0; k < 16; ++k)
+                    World[k] *= 1e-20f;     // products underflow into denormals
+            }
+            if (o % 23 == 0)
+                World[3] = 1e-39f;          // a denormal input
+        }
+
+        S.Instances.resize(kObjects);
+        for (uint32_t i = 0; i < kObjects; ++i)
+        {
+            S.Instances[i] = { { 8.0f * Unit(Random), 8.0f * Unit(Random), 8.0f * Unit(Random) }, 2.0f * std::fabs(Unit(Random)),
+                (i * 7) % kObjects, i * 3, i, -(int32_t)i };
+            if (i % 31 == 0)
+                S.Instances[i].Radius = -1.0f;
+            if (i % 37 == 0)
+                S.Instances[i].Radius = 1e-22f;
+        }
+
+        for (uint32_t First = 0; First < kObjects; )
+        {
+            const uint32_t Count = std::min<uint32_t>(Random() % 150 + 1, kObjects - First);
+            S.Batches.push_back({ First, Count, { 0, 0 } });
+            First += Count;
+        }
+        return S;
+    }
+
+    void Cull(const Scene& S, std::vector<Utility::IndirectDrawCommand>& Commands, std::vector<uint32_t>& Counts)
+    {
+        Commands.assign(S.Instances.size(), Utility::IndirectDrawCommand{ kUntouched, 0, 0, 0, 0, 0 });
+        Counts.assign(S.Batches.size(), 0);
+        Utility::CullInstances(S.Instances.data(), S.Batches.data(), S.Batches.size(), S.Worlds.data(), 16 * sizeof(float),
+            S.Planes, Commands.data(), Counts.data());
+    }
+
+#ifdef HAS_FLUSH_TO_ZERO
+    // The shader's arithmetic in plain floats; volatile keeps every step rounded on its own
+    bool PlainFloatVisible(const Utility::IndirectInstance& I, const float* World, const float Planes[6][4])
+    {
+        if (!(I.Radius >= 0.0f))
+            return true;
+
+        auto W = [World](int i, int j) { return World[j * 4 + i]; };
+        volatile float Center[3];
+        for (int j = 0; j < 3; ++j)
+            Center[j] = ((I.Center[0] * W(0, j) + I.Center[1] * W(1, j)) + I.Center[2] * W(2, j)) + W(3, j);
+
+        volatile float Scale2 = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            volatile float Length2 = (W(i, 0) * W(i, 0) + W(i, 1) * W(i, 1)) + W(i, 2) * W(i, 2);
+            Scale2 = Length2 > Scale2 ? (float)Length2 : (float)Scale2;
+        }
+        volatile float Radius2 = (I.Radius * I.Radius) * Scale2;
+
+        for (int p = 0; p < 6; ++p)
+        {
+            volatile float Distance = ((Planes[p][0] * Center[0] + Planes[p][1] * Center[1]) + Planes[p][2] * Center[2]) + Planes[p][3];
+            volatile float Distance2 = Distance * Distance;
+            if (Distance < 0.0f && Distance2 > Radius2)
+                return false;
+        }
+        return true;
+    }
+
+    // One group per kIndirectCullGroupSize instances of a batch, each thread placing its command
+    // by an inclusive prefix sum over the group, as the shader does
+    void CullLikeTheGpu(const Scene& S, std::vector<Utility::IndirectDrawCommand>& Commands, std::vector<uint32_t>& Counts)
+    {
+        const uint32_t kGroup = Utility::kIndirectCullGroupSize;
+        Commands.assign(S.Instances.size(), Utility::IndirectDrawCommand{ kUntouched, 0, 0, 0, 0, 0 });
+        Counts.assign(S.Batches.size(), 0);
+
+        const unsigned int FlushZero = _MM_GET_FLUSH_ZERO_MODE(), DenormalsZero = _MM_GET_DENORMALS_ZERO_MODE();
+        _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+        _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+
+        for (size_t b = 0; b < S.Batches.size(); ++b)
+        {
+            const Utility::IndirectBatch& Batch = S.Batches[b];
+            uint32_t Written = 0;
+            for (uint32_t First = 0; First < Batch.InstanceCount; First += kGroup)
+            {
+                std::vector<uint32_t> Visible(kGroup, 0), Prefix(kGroup), Add(kGroup);
+                for (uint32_t t = 0; t < kGroup && First + t < Batch.InstanceCount; ++t)
+                {
+                    const Utility::IndirectInstance& I = S.Instances[Batch.FirstInstance + First + t];
+                    Visible[t] = PlainFloatVisible(I, &S.Worlds[I.ObjectIndex * 16], S.Planes) ? 1 : 0;
+                }
+
+                Prefix = Visible;
+                for (uint32_t Offset = 1; Offset < kGroup; Offset <<= 1)
+                {
+                    for (uint32_t t = 0; t < kGroup; ++t)
+                        Add[t] = t >= Offset ? Prefix[t - Offset] : 0;
+                    for (uint32_t t = 0; t < kGroup; ++t)
+                        Prefix[t] += Add[t];
+                }
+
+                for (uint32_t t = 0; t < kGroup; ++t)
+                {
+                    if (!Visible[t])
+                        continue;
+                    const Utility::IndirectInstance& I = S.Instances[Batch.FirstInstance + First + t];
+                    Commands[Batch.FirstInstance + Written + Prefix[t] - 1] =
+                        { I.ObjectIndex, I.IndexCount, 1, I.StartIndexLocation, I.BaseVertexLocation, 0 };
+                }
+                Written += Prefix[kGroup - 1];
+            }
+            Counts[b] = Written;
+        }
+
+        _MM_SET_FLUSH_ZERO_MODE(FlushZero);
+        _MM_SET_DENORMALS_ZERO_MODE(DenormalsZero);
+    }
+#endif
+}
+
+static void TestLayout(void)
+{
+    // IndirectInstance and IndirectBatch in CSCullInstances.hlsl, the command signature's stride
+    CHECK(sizeof(Utility::IndirectInstance) == 32);
+    CHECK(sizeof(Utility::IndirectBatch) == 16);
+    CHECK(sizeof(Utility::IndirectDrawCommand) == 24);
+}
+
+static void TestAgainstPlainFloat(void)
+{
+#ifdef HAS_FLUSH_TO_ZERO
+    std::mt19937 Random(7);
+    std::vector<Utility::IndirectDrawCommand> Commands, Expected;
+    std::vector<uint32_t> Counts, ExpectedCounts;
+
+    int Mismatches = 0;
+    for (int Iteration = 0; Iteration < 200; ++Iteration)
+    {
+        const Scene S = RandomScene(Random);
+        Cull(S, Commands, Counts);
+        CullLikeTheGpu(S, Expected, ExpectedCounts);
+        if (Counts != ExpectedCounts || memcmp(Commands.data(), Expected.data(), Commands.size() * sizeof(Commands[0])) != 0)
+            ++Mismatches;
+    }
+    CHECK(Mismatches == 0);
+#else
+    printf("no flush to zero control on this CPU, skipping the plain float reference\n");
+#endif
+}
+
+static void TestAgainstDouble(void)
+{
+    std::mt19937 Random(11);
+    std::vector<Utility::IndirectDrawCommand> Commands;
+    std::vector<uint32_t> Counts;
+
+    uint32_t Tested = 0, Culled = 0;
+    for (int Iteration = 0; Iteration < 200; ++Iteration)
+    {
+        const Scene S = RandomScene(Random);
+        Cull(S, Commands, Counts);
+
+        for (size_t b = 0; b < S.Batches.size(); ++b)
+        {
+            const Utility::IndirectBatch& Batch = S.Batches[b];
+            uint32_t Kept = 0;
+            for (uint32_t i = 0; i < Batch.InstanceCount; ++i)
+            {
+                const Utility::IndirectInstance& I = S.Instances[Batch.FirstInstance + i];
+                const float* World = &S.Worlds[I.ObjectIndex * 16];
+
+                bool Visible = true, Borderline = false;
+                if (I.Radius >= 0.0f)
+                {
+                    double Center[3], Scale = 0.0;
+                    for (int j = 0; j < 3; ++j)
+                        Center[j] = (double)I.Center[0] * World[j * 4] + (double)I.Center[1] * World[j * 4 + 1] + (double)I.Center[2] * World[j * 4 + 2] + World[j * 4 + 3];
+                    for (int r = 0; r < 3; ++r)
+                        Scale = std::max(Scale, std::sqrt((double)World[r] * World[r] + (double)World[4 + r] * World[4 + r] + (double)World[8 + r] * World[8 + r]));
+
+                    const double Radius = I.Radius * Scale;
+                    for (const float* Plane : S.Planes)
+                    {
+                        const double Distance = Plane[0] * Center[0] + Plane[1] * Center[1] + Plane[2] * Center[2] + Plane[3];
+                        Borderline |= std::fabs(Distance + Radius) < 1e-3;
+                        Visible &= Distance >= -Radius;
+                    }
+                }
+
+                const bool Got = Utility::IsInstanceVisible(I, World, S.Planes);
+                if (!Borderline)
+                {
+                    CHECK(Got == Visible);
+                    ++Tested;
+                    Culled += Got ? 0 : 1;
+                }
+
+                // the visible ones in order at the start of the batch
+                if (Got)
+                {
+                    const Utility::IndirectDrawCommand& C = Commands[Batch.FirstInstance + Kept++];
+                    CHECK(C.ObjectIndex == I.ObjectIndex && C.IndexCountPerInstance == I.IndexCount && C.InstanceCount == 1 &&
+                        C.StartIndexLocation == I.StartIndexLocation && C.BaseVertexLocation == I.BaseVertexLocation);
+                }
+            }
+
+            CHECK(Kept == Counts[b]);
+            for (uint32_t i = Kept; i < Batch.InstanceCount; ++i)
+                CHECK(Commands[Batch.FirstInstance + i].ObjectIndex == kUntouched);
+        }
+    }
+    printf("double reference: %u instances away from a plane, %u culled\n", Tested, Culled);
+    CHECK(Culled > Tested / 10 && Culled < Tested);
+}
+
+// A point 1e-20 behind a plane: its squared distance is a denormal the GPU flushes to zero,
+// which is then not beyond the zero radius, so it stays
+static void TestDenormalDistance(void)
+{
+    const float Identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    float Planes[6][4] = {};
+    for (float* Plane : Planes)
+        Plane[0] = 1.0f;        // x >= 0
+
+    Utility::IndirectInstance Instance = { { -1e-20f, 0.0f, 0.0f }, 0.0f, 0, 3, 0, 0 };
+    CHECK(Utility::IsInstanceVisible(Instance, Identity, Planes));
+    Instance.Center[0] = -1e-15f;
+    CHECK(!Utility::IsInstanceVisible(Instance, Identity, Planes));
+}
+
+// A negative or NaN radius is drawn whatever the planes say
+static void TestNeverCulled(void)
+{
+    const float Identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    float Planes[6][4] = {};
+    for (float* Plane : Planes)
+    {
+        Plane[0] = 1.0f;
+        Plane[3] = -100.0f;     // x >= 100
+    }
+
+    Utility::IndirectInstance Instance = { { 0.0f, 0.0f, 0.0f }, 1.0f, 0, 3, 0, 0 };
+    CHECK(!Utility::IsInstanceVisible(Instance, Identity, Planes));
+    Instance.Radius = -1.0f;
+    CHECK(Utility::IsInstanceVisible(Instance, Identity, Planes));
+    Instance.Radius = std::nanf("");
+    CHECK(Utility::IsInstanceVisible(Instance, Identity, Planes));
+}
+
+int main(void)
+{
+    TestLayout();
+    TestAgainstPlainFloat();
+    TestAgainstDouble();
+    TestDenormalDistance();
+    TestNeverCulled();
+    return Test::Finish("IndirectCullingTest");
+}
@@ -0,0 +1,244 @@
+#include "TestHarness.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// The error GenerateLods reports for each level against the one measured: the distance from
+// sampled vertices of the full detail mesh to the nearest triangle of the level. A single
+// simplification reports the root mean square distance to the planes it was built from, which
+// a vertex can exceed, but the chain adds up the errors of every step, and on these meshes the
+// sum stays above the largest distance measured. Run on the skull, on a flat 100x100 grid whose
+// border must not move, and on the same grid with hills.
+
+namespace
+{
+    struct Float3 { float x, y, z; };
+
+    Float3 operator-(const Float3& A, const Float3& B) { return { A.x - B.x, A.y - B.y, A.z - B.z }; }
+    Float3 operator+(const Float3& A, const Float3& B) { return { A.x + B.x, A.y + B.y, A.z + B.z }; }
+    Float3 operator*(const Float3& A, float S) { return { A.x * S, A.y * S, A.z * S }; }
+    float Dot(const Float3& A, const Float3& B) { return A.x * B.x + A.y * B.y + A.z * B.z; }
+    float Length(const Float3& A) { return std::sqrt(Dot(A, A)); }
+
+    // Closest point on triangle ABC to P (Ericson, Real-Time Collision Detection, 5.1.5)
+    float DistanceToTriangle(const Float3& P, const Float3& A, const Float3& B, const Float3& C)
+    {
+        const Float3 AB = B - A, AC = C - A, AP = P - A;
+        const float D1 = Dot(AB, AP), D2 = Dot(AC, AP);
+        if (D1 <= 0.0f && D2 <= 0.0f)
+            return Length(P - A);
+
+        const Float3 BP = P - B;
+        const float D3 = Dot(AB, BP), D4 = Dot(AC, BP);
+        if (D3 >= 0.0f && D4 <= D3)
+            return Length(P - B);
+
+        const float VC = D1 * D4 - D3 * D2;
+        if (VC <= 0.0f && D1 >= 0.0f && D3 <= 0.0f)
+            return Length(P - (A + AB * (D1 / (D1 - D3))));
+
+        const Float3 CP = P - C;
+        const float D5 = Dot(AB, CP), D6 = Dot(AC, CP);
+        if (D6 >= 0.0f && D5 <= D6)
+            return Length(P - C);
+
+        const float VB = D5 * D2 - D1 * D6;
+        if (VB <= 0.0f && D2 >= 0.0f && D6 <= 0.0f)
+            return Length(P - (A + AC * (D2 / (D2 - D6))));
+
+        const float VA = D3 * D6 - D5 * D4;
+        if (VA <= 0.0f && D4 - D3 >= 0.0f && D5 - D6 >= 0.0f)
+            return Length(P - (B + (C - B) * ((D4 - D3) / ((D4 - D3) + (D5 - D6)))));
+
+        const float Denom = 1.0f / (VA + VB + VC);
+        return Length(P - (A + AB * (VB * Denom) + AC * (VC * Denom)));
+    }
+
+    // Largest distance from every SampleStep-th vertex to the triangles of a level
+    float MeasureError(const std::vector<Float3>& Positions, const uint32_t* Indices, size_t IndexCount, size_t SampleStep)
+    {
+        float Max = 0.0f;
+        for (size_t v = 0; v < Positions.size(); v += SampleStep)
+        {
+            float Nearest = 1e30f;
+            for (size_t t = 0; t < IndexCount; t += 3)
+            {
+                Nearest = std::min(Nearest, DistanceToTriangle(Positions[v],
+                    Positions[Indices[t]], Positions[Indices[t + 1]], Positions[Indices[t + 2]]));
+            }
+            Max = std::max(Max, Nearest);
+        }
+        return Max;
+    }
+
+    // Every index in range and no triangle collapsed onto an edge or a point
+    bool LevelIsValid(const std::vector<uint32_t>& Indices, const Utility::MeshLod& Lod, size_t VertexCount)
+    {
+        if (Lod.IndexCount % 3 != 0 || Lod.StartIndex + Lod.IndexCount > Indices.size())
+            return false;
+
+        for (uint32_t t = Lod.StartIndex; t < Lod.StartIndex + Lod.IndexCount; t += 3)
+        {
+            const uint32_t* T = &Indices[t];
+            if (T[0] >= VertexCount || T[1] >= VertexCount || T[2] >= VertexCount)
+                return false;
+            if (T[0] == T[1] || T[1] == T[2] || T[0] == T[2])
+                return false;
+        }
+        return true;
+    }
+
+    // Five levels from Indices, each checked for validity and for a measured error no larger
+    // than the reported one. Indices receives the chain.
+    std::vector<Utility::MeshLod> CheckChain(const char* Name, const std::vector<Float3>& Positions,
+        std::vector<uint32_t>& Indices, size_t SampleStep)
+    {
+        Test::Timer Timer;
+        std::vector<Utility::MeshLod> Lods = Utility::GenerateLods(Indices, &Positions[0].x, sizeof(Float3), Positions.size(), 5);
+        printf("%s: %zu levels in %.1f ms\n", Name, Lods.size(), Timer.Seconds() * 1000.0);
+
+        CHECK(!Lods.empty() && Lods[0].StartIndex == 0 && Lods[0].Error == 0.0f);
+        for (size_t i = 0; i < Lods.size(); ++i)
+        {
+            CHECK(LevelIsValid(Indices, Lods[i], Positions.size()));
+
+            const float Measured = MeasureError(Positions, &Indices[Lods[i].StartIndex], Lods[i].IndexCount, SampleStep);
+            printf("  LOD%zu %6u tris  reported %.4f  measured %.4f\n", i, Lods[i].IndexCount / 3, Lods[i].Error, Measured);
+
+            CHECK(Measured <= Lods[i].Error + 1e-4f);
+            if (i > 0)
+            {
+                CHECK(Lods[i].IndexCount < Lods[i - 1].IndexCount);
+                CHECK(Lods[i].Error >= Lods[i - 1].Error);
+            }
+        }
+        return Lods;
+    }
+
+    void BuildGrid(uint32_t Rows, uint32_t Columns, std::vector<Float3>& Positions, std::vector<uint32_t>& Indices)
+    {
+        Positions.resize(Rows * Columns);
+        for (uint32_t i = 0; i < Rows; ++i)
+        {
+            for (uint32_t j = 0; j < Columns; ++j)
+                Positions[i * Columns + j] = { -50.0f + j * 100.0f / (Columns - 1), 0.0f, 50.0f - i * 100.0f / (Rows - 1) };
+        }
+
+        Indices.clear();
+        for (uint32_t i = 0; i + 1 < Rows; ++i)
+        {
+            for (uint32_t j = 0; j + 1 < Columns; ++j)
+            {
+                const uint32_t Quad[6] = { i * Columns + j, i * Columns + j + 1, (i + 1) * Columns + j,
+                    (i + 1) * Columns + j, i * Columns + j + 1, (i + 1) * Columns + j + 1 };
+                Indices.insert(Indices.end(), Quad, Quad + 6);
+            }
+        }
+    }
+
+    double AreaXZ(const std::vector<Float3>& Positions, const uint32_t* Indices, size_t IndexCount)
+    {
+        double Area = 0.0;
+        for (size_t t = 0; t < IndexCount; t += 3)
+        {
+            const Float3 A = Positions[Indices[t + 1]] - Positions[Indices[t]];
+            const Float3 B = Positions[Indices[t + 2]] - Positions[Indices[t]];
+            Area += 0.5 * std::fabs(A.x * B.z - A.z * B.x);
+        }
+        return Area;
+    }
+}
+
+// A plane simplifies without error, and its open border only slides along itself, so every
+// level still covers the whole 100x100 square
+static void TestFlatGrid(void)
+{
+    std::vector<Float3> Positions;
+    std::vector<uint32_t> Indices;
+    BuildGrid(100, 100, Positions, Indices);
+
+    const std::vector<Utility::MeshLod> Lods = CheckChain("flat grid", Positions, Indices, 7);
+    CHECK(Lods.size() == 5);
+    for (const Utility::MeshLod& Lod : Lods)
+    {
+        CHECK(Lod.Error == 0.0f);
+        CHECK(std::fabs(AreaXZ(Positions, &Indices[Lod.StartIndex], Lod.IndexCount) - 10000.0) < 1e-2);
+    }
+}
+
+static void TestHills(void)
+{
+    std::vector<Float3> Positions;
+    std::vector<uint32_t> Indices;
+    BuildGrid(100, 100, Positions, Indices);
+    for (Float3& P : Positions)
+        P.y = std::sin(P.x * 0.2f) * std::cos(P.z * 0.15f) * 3.0f;
+
+    const std::vector<uint32_t> Original = Indices;
+    const std::vector<Utility::MeshLod> Lods = CheckChain("hills", Positions, Indices, 3);
+    CHECK(Lods.size() == 5 && Lods.back().Error > 0.0f);
+
+    // SimplifyMesh stops before the first collapse over TargetError, however far the target
+    // count is, and a tighter error keeps more triangles
+    std::vector<uint32_t> Simplified(Original.size());
+    size_t Counts[2];
+    const float TargetErrors[2] = { 0.5f * Lods[2].Error, 0.125f * Lods[2].Error };
+    for (int i = 0; i < 2; ++i)
+    {
+        float ResultError = -1.0f;
+        Counts[i] = Utility::SimplifyMesh(Simplified.data(), Original.data(), Original.size(),
+            &Positions[0].x, sizeof(Float3), Positions.size(), 0, TargetErrors[i], &ResultError);
+        CHECK(Counts[i] % 3 == 0 && Counts[i] < Original.size() && Counts[i] > Lods.back().IndexCount);
+        CHECK(ResultError >= 0.0f && ResultError <= TargetErrors[i]);
+    }
+    CHECK(Counts[1] > Counts[0]);
+
+    // and at TargetIndexCount, however large the error allowed
+    const size_t Target = Original.size() / 4;
+    const size_t Reduced = Utility::SimplifyMesh(Simplified.data(), Original.data(), Original.size(),
+        &Positions[0].x, sizeof(Float3), Positions.size(), Target, 1e30f);
+    CHECK(Reduced <= Target && Reduced > Target * 9 / 10);
+}
+
+static void TestSkull(void)
+{
+    std::ifstream File("../../Models/skull.txt");
+    CHECK(File.good());
+    if (!File)
+        return;
+
+    uint32_t VertexCount = 0, TriangleCount = 0;
+    std::string Ignore;
+    File >> Ignore >> VertexCount >> Ignore >> TriangleCount >> Ignore >> Ignore >> Ignore >> Ignore;
+
+    std::vector<Float3> Positions(VertexCount);
+    for (Float3& P : Positions)
+    {
+        Float3 Normal;
+        File >> P.x >> P.y >> P.z >> Normal.x >> Normal.y >> Normal.z;
+    }
+
+    File >> Ignore >> Ignore >> Ignore;
+    std::vector<uint32_t> Indices(3 * TriangleCount);
+    for (uint32_t& Index : Indices)
+        File >> Index;
+    CHECK(File.good());
+
+    // each level about half the one before, the coarsest still within 5% of the skull's size
+    const std::vector<Utility::MeshLod> Lods = CheckChain("skull", Positions, Indices, 97);
+    CHECK(Lods.size() == 5);
+    for (size_t i = 1; i < Lods.size(); ++i)
+        CHECK(Lods[i].IndexCount * 10 >= Lods[i - 1].IndexCount * 4 && Lods[i].IndexCount * 10 <= Lods[i - 1].IndexCount * 6);
+    CHECK(Lods.back().Error < 0.05f * 12.9f);
+}
+
+int main(void)
+{
+    TestFlatGrid();
+    TestHills();
+    TestSkull();
+    return Test::Finish("MeshSimplifierTest");
+}
@@ -0,0 +1,240 @@
+#include "TestHarness.h"
+#include "TestMeshes.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// BuildMeshlets keeps every triangle in order within the limits, with bounds that hold every
+// vertex and cones that hold every normal. CullMeshlets is checked by brute force from random
+// views: each triangle of a rejected meshlet must face away from the eye or lie wholly outside
+// one plane, and the kept meshlets come out whole and in order. Run on the skull, a sphere and
+// the hills, reordered for the vertex cache as BuildSubmeshMeshlets gets them.
+
+using Test::Float3;
+
+namespace
+{
+    const Float3& Corner(const std::vector<Float3>& Positions, const Utility::MeshletMesh& Mesh, const Utility::Meshlet& M, uint32_t t, int k)
+    {
+        return Positions[Mesh.Vertices[M.VertexOffset + Mesh.Triangles[M.TriangleOffset + t * 3 + k]]];
+    }
+
+    Utility::MeshletMesh Build(const std::vector<Float3>& Positions, const std::vector<uint32_t>& Indices)
+    {
+        Utility::MeshletMesh Mesh;
+        Utility::BuildMeshlets(Mesh, Indices.data(), Indices.size(), &Positions[0].x, sizeof(Float3), Positions.size());
+        return Mesh;
+    }
+
+    std::vector<uint32_t> CacheOrder(const std::vector<Float3>& Positions, const std::vector<uint32_t>& Indices)
+    {
+        std::vector<uint32_t> Reordered(Indices.size());
+        Utility::OptimizeVertexCache(Reordered.data(), Indices.data(), Indices.size(), Positions.size());
+        return Reordered;
+    }
+}
+
+static void TestBuild(const std::vector<Float3>& Positions, const std::vector<uint32_t>& Indices)
+{
+    const Utility::MeshletMesh Mesh = Build(Positions, Indices);
+    CHECK(!Mesh.Meshlets.empty() && Mesh.Bounds.size() == Mesh.Meshlets.size());
+
+    std::vector<uint32_t> Expanded;
+    for (size_t i = 0; i < Mesh.Meshlets.size(); ++i)
+    {
+        const Utility::Meshlet& M = Mesh.Meshlets[i];
+        const Utility::MeshletBounds& B = Mesh.Bounds[i];
+        CHECK(M.VertexCount > 0 && M.VertexCount <= Utility::kMaxMeshletVertices);
+        CHECK(M.TriangleCount > 0 && M.TriangleCount <= Utility::kMaxMeshletTriangles);
+        CHECK(M.VertexOffset + M.VertexCount <= Mesh.Vertices.size());
+        CHECK(M.TriangleOffset + M.TriangleCount * 3 <= Mesh.Triangles.size());
+
+        for (uint32_t t = 0; t < M.TriangleCount * 3; ++t)
+        {
+            const uint8_t Local = Mesh.Triangles[M.TriangleOffset + t];
+            CHECK(Local < M.VertexCount);
+            Expanded.push_back(Mesh.Vertices[M.VertexOffset + Local]);
+        }
+
+        const Float3 Center = { B.Center[0], B.Center[1], B.Center[2] };
+        for (uint32_t v = 0; v < M.VertexCount; ++v)
+            CHECK(Test::Length(Positions[Mesh.Vertices[M.VertexOffset + v]] - Center) <= B.Radius * 1.0001f + 1e-6f);
+
+        // a cone that can cull must hold every normal: cos of the widest angle is sqrt(1 - cutoff^2)
+        if (B.ConeCutoff < 1.0f)
+        {
+            const Float3 Axis = { B.ConeAxis[0], B.ConeAxis[1], B.ConeAxis[2] };
+            const float MinDot = std::sqrt(1.0f - B.ConeCutoff * B.ConeCutoff);
+            for (uint32_t t = 0; t < M.TriangleCount; ++t)
+            {
+                const Float3 P0 = Corner(Positions, Mesh, M, t, 0);
+                const Float3 Normal = Test::Cross(Corner(Positions, Mesh, M, t, 1) - P0, Corner(Positions, Mesh, M, t, 2) - P0);
+                if (Test::Length(Normal) > 0.0f)
+                    CHECK(Test::Dot(Test::Normalize(Normal), Axis) >= MinDot - 1e-4f);
+            }
+        }
+    }
+    CHECK(Expanded == Indices);
+}
+
+static void TestCulling(const std::vector<Float3>& Positions, const std::vector<uint32_t>& Indices, int ViewsPerKind)
+{
+    const Utility::MeshletMesh Mesh = Build(Positions, Indices);
+
+    // culls one meshlet at a time, sharing the vertex and triangle lists
+    Utility::MeshletMesh One;
+    One.Vertices = Mesh.Vertices;
+    One.Triangles = Mesh.Triangles;
+    One.Meshlets.resize(1);
+    One.Bounds.resize(1);
+
+    Float3 Center;
+    float Radius;
+    Test::BoundingSphere(Positions, Center, Radius);
+
+    std::mt19937 Random(7);
+    std::vector<uint32_t> Culled(Indices.size()), Expected;
+    uint32_t Single[Utility::kMaxMeshletTriangles * 3];
+
+    for (Test::ViewKind Kind : { Test::ViewKind::Orbit, Test::ViewKind::CloseUp, Test::ViewKind::Inside })
+    {
+        for (int View = 0; View < ViewsPerKind; ++View)
+        {
+            Float3 Eye;
+            float Matrix[16], Planes[6][4];
+            Test::RandomView(Kind, Random, Center, Radius, Eye, Matrix);
+            Utility::ExtractFrustumPlanes(Matrix, Planes);
+
+            Utility::MeshletCullStats Stats = {};
+            const size_t Count = Utility::CullMeshlets(Mesh, Planes, &Eye.x, Culled.data(), Stats);
+            CHECK(Stats.Meshlets == Mesh.Meshlets.size() && Stats.Triangles == Indices.size() / 3);
+            CHECK(Count == (Stats.Triangles - Stats.TrianglesRejected) * 3);
+
+            Expected.clear();
+            for (size_t i = 0; i < Mesh.Meshlets.size(); ++i)
+            {
+                const Utility::Meshlet& M = Mesh.Meshlets[i];
+                One.Meshlets[0] = M;
+                One.Bounds[0] = Mesh.Bounds[i];
+                Utility::MeshletCullStats OneStats = {};
+                if (Utility::CullMeshlets(One, Planes, &Eye.x, Single, OneStats) != 0)
+                {
+                    Expected.insert(Expected.end(), Single, Single + M.TriangleCount * 3);
+                    continue;
+                }
+
+                for (uint32_t t = 0; t < M.TriangleCount; ++t)
+                {
+                    const Float3 P[3] = { Corner(Positions, Mesh, M, t, 0), Corner(Positions, Mesh, M, t, 1), Corner(Positions, Mesh, M, t, 2) };
+
+                    // front faces are clockwise as seen, so cross(e1, e2) points at the eye
+                    const Float3 Normal = Test::Cross(P[1] - P[0], P[2] - P[0]);
+                    const bool BackFacing = Test::Dot(Eye - P[0], Normal) <= 1e-7f * Test::Length(Normal);
+
+                    bool Outside = false;
+                    for (int p = 0; p < 6; ++p)
+                    {
+                        bool AllOutside = true;
+                        for (int k = 0; k < 3; ++k)
+                            AllOutside &= Planes[p][0] * P[k].x + Planes[p][1] * P[k].y + Planes[p][2] * P[k].z + Planes[p][3] < 0.0f;
+                        Outside |= AllOutside;
+                    }
+                    CHECK(BackFacing || Outside);
+                }
+            }
+            CHECK(Expected.size() == Count && std::equal(Expected.begin(), Expected.end(), Culled.begin()));
+        }
+    }
+}
+
+// The identity's clip volume is -1 <= x, y <= 1 and 0 <= z <= 1
+static void TestFrustumPlanes(void)
+{
+    const float Identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    float Planes[6][4];
+    Utility::ExtractFrustumPlanes(Identity, Planes);
+
+    auto Inside = [&](float x, float y, float z)
+    {
+        for (int p = 0; p < 6; ++p)
+        {
+            if (Planes[p][0] * x + Planes[p][1] * y + Planes[p][2] * z + Planes[p][3] < 0.0f)
+                return false;
+        }
+        return true;
+    };
+
+    for (int p = 0; p < 6; ++p)
+        CHECK(std::fabs(Planes[p][0] * Planes[p][0] + Planes[p][1] * Planes[p][1] + Planes[p][2] * Planes[p][2] - 1.0f) < 1e-5f);
+
+    CHECK(Inside(0.0f, 0.0f, 0.5f));
+    CHECK(Inside(0.99f, -0.99f, 0.01f));
+    CHECK(!Inside(1.01f, 0.0f, 0.5f));
+    CHECK(!Inside(0.0f, -1.01f, 0.5f));
+    CHECK(!Inside(0.0f, 0.0f, -0.01f));
+    CHECK(!Inside(0.0f, 0.0f, 1.01f));
+}
+
+// Without an eye nothing is rejected for facing away, with one the far side of a sphere is
+static void TestNoEye(void)
+{
+    std::vector<Float3> Positions;
+    std::vector<uint32_t> Indices;
+    Test::BuildSphere(0.5f, 40, 40, Positions, Indices);
+    const Utility::MeshletMesh Mesh = Build(Positions, CacheOrder(Positions, Indices));
+
+    const Float3 Eye = { 0.0f, 0.0f, -5.0f };
+    float Matrix[16], Planes[6][4];
+    Test::LookAtPerspective(Eye, { 0.0f, 0.0f, 0.0f }, 0.785f, 1.0f, 0.1f, 100.0f, Matrix);
+    Utility::ExtractFrustumPlanes(Matrix, Planes);
+
+    std::vector<uint32_t> Culled(Indices.size());
+    Utility::MeshletCullStats Stats = {};
+    CHECK(Utility::CullMeshlets(Mesh, Planes, nullptr, Culled.data(), Stats) == Indices.size());
+    CHECK(Stats.BackFacing == 0 && Stats.OutsideFrustum == 0 && Stats.TrianglesRejected == 0);
+
+    Stats = {};
+    CHECK(Utility::CullMeshlets(Mesh, Planes, &Eye.x, Culled.data(), Stats) < Indices.size());
+    CHECK(Stats.BackFacing > 0 && Stats.OutsideFrustum == 0);
+}
+
+static void TestEmpty(void)
+{
+    Utility::MeshletMesh Mesh;
+    const float Position[3] = { 0.0f, 0.0f, 0.0f };
+    Utility::BuildMeshlets(Mesh, nullptr, 0, Position, sizeof(Position), 1);
+    CHECK(Mesh.Meshlets.empty() && Mesh.Bounds.empty() && Mesh.Vertices.empty() && Mesh.Triangles.empty());
+}
+
+int main(void)
+{
+    TestFrustumPlanes();
+    TestNoEye();
+    TestEmpty();
+
+    std::vector<Float3> Positions;
+    std::vector<uint32_t> Indices;
+
+    CHECK(Test::LoadTextModel("../../Models/skull.txt", Positions, Indices));
+    if (!Positions.empty())
+    {
+        Indices = CacheOrder(Positions, Indices);
+        TestBuild(Positions, Indices);
+        TestCulling(Positions, Indices, 8);
+    }
+
+    Test::BuildSphere(0.5f, 40, 40, Positions, Indices);
+    Indices = CacheOrder(Positions, Indices);
+    TestBuild(Positions, Indices);
+    TestCulling(Positions, Indices, 8);
+
+    Test::BuildHills(100, 100, Positions, Indices);
+    Indices = CacheOrder(Positions, Indices);
+    TestBuild(Positions, Indices);
+    TestCulling(Positions, Indices, 8);
+
+    return Test::Finish("MeshletBuilderTest");
+}
@@ -0,0 +1,163 @@
+#include "TestHarness.h"
+#include "NullDevice.h"
+#include "GraphicsCore.h"
+#include "PipelineState.h"
+#include "RootSignature.h"
+
+// GraphicsPSO and ComputePSO on the null device: descriptions that hash the same share one
+// ID3D12PipelineState and cost the device nothing, anything that differs compiles a new one.
+// The shader bytes are compared by content, so two copies of a shader count as the same.
+
+namespace
+{
+    const uint8_t kVertexShader[] = { 0x44, 0x58, 0x42, 0x43, 1, 2, 3, 4, 5, 6, 7, 8 };
+    const uint8_t kPixelShader[] = { 0x44, 0x58, 0x42, 0x43, 8, 7, 6, 5, 4, 3, 2, 1 };
+
+    Microsoft::WRL::ComPtr<ID3DBlob> MakeShader(const uint8_t* Bytes, size_t Size)
+    {
+        Microsoft::WRL::ComPtr<ID3DBlob> Blob;
+        Blob.Attach(new NullBlob(std::vector<uint8_t>(Bytes, Bytes + Size)));
+        return Blob;
+    }
+
+    NullDevice& GetNullDevice(void)
+    {
+        return *static_cast<NullDevice*>(Graphics::g_Device);
+    }
+
+    void InitOpaque(GraphicsPSO& PSO, const RootSignature& RootSig, const void* VS, const void* PS)
+    {
+        D3D12_INPUT_ELEMENT_DESC Layout[] =
+        {
+            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        };
+
+        PSO.SetRootSignature(RootSig);
+        PSO.SetInputLayout(_countof(Layout), Layout);
+        PSO.SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
+        PSO.SetRenderTargetFormat(DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_D24_UNORM_S8_UINT);
+        PSO.SetVertexShader(VS, sizeof(kVertexShader));
+        PSO.SetPixelShader(PS, sizeof(kPixelShader));
+    }
+}
+
+static void TestRootSignatureReuse(RootSignature& RootSig)
+{
+    int Before = GetNullDevice().GetRootSignaturesCreated();
+
+    RootSig.Reset(2, 0);
+    RootSig[0].InitAsConstantBuffer(0);
+    RootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 4, D3D12_SHADER_VISIBILITY_PIXEL);
+    RootSig.Finalize(L"Test Root Signature", D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+    CHECK(RootSig.GetSignature() != nullptr);
+
+    // the same layout built again is looked up, not created
+    RootSignature Copy;
+    Copy.Reset(2, 0);
+    Copy[0].InitAsConstantBuffer(0);
+    Copy[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 4, D3D12_SHADER_VISIBILITY_PIXEL);
+    Copy.Finalize(L"Test Root Signature Copy", D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+    CHECK(Copy.GetSignature() == RootSig.GetSignature());
+    CHECK(GetNullDevice().GetRootSignaturesCreated() == Before + 1);
+}
+
+static void TestGraphicsPSOSharing(const RootSignature& RootSig)
+{
+    PSOCacheStats Before = PSO::GetGraphicsCacheStats();
+    int Created = GetNullDevice().GetPipelineStatesCreated();
+
+    GraphicsPSO First(L"First");
+    InitOpaque(First, RootSig, kVertexShader, kPixelShader);
+    First.Finalize();
+    CHECK(First.GetPipelineStateObject() != nullptr);
+    CHECK(GetNullDevice().GetPipelineStatesCreated() == Created + 1);
+
+    // a copy of the shaders at another address still hashes the same
+    uint8_t VSCopy[sizeof(kVertexShader)];
+    uint8_t PSCopy[sizeof(kPixelShader)];
+    memcpy(VSCopy, kVertexShader, sizeof(VSCopy));
+    memcpy(PSCopy, kPixelShader, sizeof(PSCopy));
+
+    GraphicsPSO Second(L"Second");
+    InitOpaque(Second, RootSig, VSCopy, PSCopy);
+    Second.Finalize();
+    CHECK(Second.GetPipelineStateObject() == First.GetPipelineStateObject());
+    CHECK(GetNullDevice().GetPipelineStatesCreated() == Created + 1);
+
+    PSOCacheStats After = PSO::GetGraphicsCacheStats();
+    CHECK(After.Misses == Before.Misses + 1);
+    CHECK(After.Hits == Before.Hits + 1);
+    CHECK(After.Collisions == Before.Collisions);
+
+    // any state that reaches the device makes a new pipeline
+    GraphicsPSO Wireframe(L"Wireframe");
+    InitOpaque(Wireframe, RootSig, kVertexShader, kPixelShader);
+    D3D12_RASTERIZER_DESC Rasterizer = {};
+    Rasterizer.FillMode = D3D12_FILL_MODE_WIREFRAME;
+    Rasterizer.CullMode = D3D12_CULL_MODE_NONE;
+    Wireframe.SetRasterizerState(Rasterizer);
+    Wireframe.Finalize();
+    CHECK(Wireframe.GetPipelineStateObject() != First.GetPipelineStateObject());
+
+    GraphicsPSO OtherPixelShader(L"Other Pixel Shader");
+    InitOpaque(OtherPixelShader, RootSig, kVertexShader, kVertexShader);
+    OtherPixelShader.Finalize();
+    CHECK(OtherPixelShader.GetPipelineStateObject() != First.GetPipelineStateObject());
+
+    GraphicsPSO OtherFormat(L"Other Format");
+    InitOpaque(OtherFormat, RootSig, kVertexShader, kPixelShader);
+    OtherFormat.SetRenderTargetFormat(DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_D24_UNORM_S8_UINT);
+    OtherFormat.Finalize();
+    CHECK(OtherFormat.GetPipelineStateObject() != First.GetPipelineStateObject());
+
+    CHECK(GetNullDevice().GetPipelineStatesCreated() == Created + 4);
+    CHECK(PSO::GetGraphicsCacheStats().Misses == Before.Misses + 4);
+}
+
+static void TestComputePSOSharing(const RootSignature& RootSig)
+{
+    PSOCacheStats Before = PSO::GetComputeCacheStats();
+    int Created = GetNullDevice().GetPipelineStatesCreated();
+
+    // separate blobs with the same bytes, as two loads of one shader file would give. The PSO
+    // only points at them, so they outlive Finalize.
+    Microsoft::WRL::ComPtr<ID3DBlob> Shader = MakeShader(kVertexShader, sizeof(kVertexShader));
+    Microsoft::WRL::ComPtr<ID3DBlob> ShaderCopy = MakeShader(kVertexShader, sizeof(kVertexShader));
+    Microsoft::WRL::ComPtr<ID3DBlob> OtherShader = MakeShader(kPixelShader, sizeof(kPixelShader));
+
+    ComputePSO First(L"Compute First");
+    First.SetRootSignature(RootSig);
+    First.SetComputeShader(Shader);
+    First.Finalize();
+
+    ComputePSO Second(L"Compute Second");
+    Second.SetRootSignature(RootSig);
+    Second.SetComputeShader(ShaderCopy);
+    Second.Finalize();
+    CHECK(Second.GetPipelineStateObject() == First.GetPipelineStateObject());
+
+    ComputePSO Other(L"Compute Other");
+    Other.SetRootSignature(RootSig);
+    Other.SetComputeShader(OtherShader);
+    Other.Finalize();
+    CHECK(Other.GetPipelineStateObject() != First.GetPipelineStateObject());
+
+    CHECK(GetNullDevice().GetPipelineStatesCreated() == Created + 2);
+    PSOCacheStats After = PSO::GetComputeCacheStats();
+    CHECK(After.Misses == Before.Misses + 2);
+    CHECK(After.Hits == Before.Hits + 1);
+}
+
+int main(void)
+{
+    Graphics::Initialize(false);
+    {
+        RootSignature RootSig;
+        TestRootSignatureReuse(RootSig);
+        TestGraphicsPSOSharing(RootSig);
+        TestComputePSOSharing(RootSig);
+    }
+    Graphics::Shutdown();
+    return Test::Finish("PipelineStateTest");
+}
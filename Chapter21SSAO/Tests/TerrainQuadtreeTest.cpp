@@ -0,0 +1,339 @@
+#include "TestHarness.h"
+#include "TerrainQuadtree.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+
+// The terrain of GameApp::BuildLandGeometry without the device. Every stitch mask covers its
+// patch exactly once, front faces up, with only the edges of the coarser neighbour left on a
+// stitched side. Patches of neighbouring levels generate bit identical vertices where they
+// meet. Selection tiles the square with leaves at most a level apart and correct stitch
+// masks, and no leaf is coarser than the eye allows. The streamer, driven by a fake GPU two
+// frames behind, only ever draws patches whose slots hold their own vertices.
+
+namespace
+{
+    float Hills(float x, float z)
+    {
+        return 0.3f * (z * std::sin(0.1f * x) + x * std::cos(0.1f * z));
+    }
+
+    // the desc of GameApp::BuildLandGeometry over the hills of GetHillsHeight
+    Utility::TerrainDesc MakeDesc(void)
+    {
+        Utility::TerrainDesc Desc = {};
+        Desc.Origin[0] = -1024.0f;
+        Desc.Origin[1] = -1024.0f;
+        Desc.Size = 2048.0f;
+        Desc.MaxDepth = 6;
+        Desc.PatchQuads = 32;
+        Desc.SplitFactor = 1.5f;
+        Desc.TextureTile = 32.0f;
+        Desc.MaxResidentPatches = 512;
+        Desc.MaxPendingPatches = 16;
+        Desc.Height = Hills;
+        return Desc;
+    }
+
+    // Distance from Eye to the square of a patch in x and z, and to Range in y when given
+    float DistanceToPatch(const Utility::TerrainDesc& Desc, const float Eye[3], const Utility::TerrainPatch& P, const float* Range)
+    {
+        const float Size = Desc.Size / (float)(1u << P.Level);
+        const float MinX = Desc.Origin[0] + P.X * Size, MinZ = Desc.Origin[1] + P.Z * Size;
+        const float Dx = std::max({ MinX - Eye[0], Eye[0] - MinX - Size, 0.0f });
+        const float Dz = std::max({ MinZ - Eye[2], Eye[2] - MinZ - Size, 0.0f });
+        const float Dy = Range != nullptr ? std::max({ Range[0] - Eye[1], Eye[1] - Range[1], 0.0f }) : 0.0f;
+        return std::sqrt(Dx * Dx + Dy * Dy + Dz * Dz);
+    }
+
+    // Checks the leaves tile the square, neighbours are at most a level apart and stitch masks
+    // are set exactly towards coarser neighbours. Returns the leaf under each finest cell.
+    std::vector<int> CheckTiling(const Utility::TerrainDesc& Desc, const std::vector<Utility::TerrainPatch>& Leaves)
+    {
+        const uint32_t Fine = 1u << Desc.MaxDepth;
+        std::vector<int> Owner(Fine * Fine, -1);
+        for (size_t i = 0; i < Leaves.size(); ++i)
+        {
+            const Utility::TerrainPatch& L = Leaves[i];
+            CHECK(L.Level <= Desc.MaxDepth && L.X < (1u << L.Level) && L.Z < (1u << L.Level));
+            const uint32_t Cells = Fine >> L.Level;
+            for (uint32_t z = 0; z < Cells; ++z)
+            {
+                for (uint32_t x = 0; x < Cells; ++x)
+                {
+                    int& Cell = Owner[(L.Z * Cells + z) * Fine + L.X * Cells + x];
+                    CHECK(Cell == -1);
+                    Cell = (int)i;
+                }
+            }
+        }
+        CHECK(std::find(Owner.begin(), Owner.end(), -1) == Owner.end());
+
+        // west, east, south, north as the bits of TerrainEdge
+        const int Dx[4] = { -1, 1, 0, 0 }, Dz[4] = { 0, 0, -1, 1 };
+        for (const Utility::TerrainPatch& L : Leaves)
+        {
+            const int Cells = (int)(Fine >> L.Level);
+            for (int Edge = 0; Edge < 4; ++Edge)
+            {
+                int MinLevel = 99, MaxLevel = -1;
+                for (int k = 0; k < Cells; ++k)
+                {
+                    const int x = Dx[Edge] < 0 ? (int)L.X * Cells - 1 : Dx[Edge] > 0 ? ((int)L.X + 1) * Cells : (int)L.X * Cells + k;
+                    const int z = Dz[Edge] < 0 ? (int)L.Z * Cells - 1 : Dz[Edge] > 0 ? ((int)L.Z + 1) * Cells : (int)L.Z * Cells + k;
+                    if (x < 0 || z < 0 || x >= (int)Fine || z >= (int)Fine)
+                        continue;
+                    const int Level = (int)Leaves[Owner[z * Fine + x]].Level;
+                    MinLevel = std::min(MinLevel, Level);
+                    MaxLevel = std::max(MaxLevel, Level);
+                }
+
+                const bool Stitched = (L.StitchMask & (1u << Edge)) != 0;
+                if (MaxLevel < 0)
+                {
+                    CHECK(!Stitched);   // the rim of the terrain
+                    continue;
+                }
+                CHECK(std::abs(MinLevel - (int)L.Level) <= 1 && std::abs(MaxLevel - (int)L.Level) <= 1);
+                CHECK(Stitched == (MinLevel < (int)L.Level));
+            }
+        }
+        return Owner;
+    }
+}
+
+// Every mask covers the N x N square once, all facing +y, and each edge is used once in each
+// direction inside and once on the rim; on a stitched side the rim edges span two quads
+static void TestStitching(void)
+{
+    for (uint32_t N : { 2u, 4u, 32u })
+    {
+        std::vector<uint32_t> Indices;
+        Utility::TerrainIndexRange Ranges[16];
+        Utility::BuildTerrainIndices(N, Indices, Ranges);
+
+        for (uint32_t Mask = 0; Mask < 16; ++Mask)
+        {
+            const Utility::TerrainIndexRange& R = Ranges[Mask];
+            CHECK(R.IndexCount % 3 == 0 && R.StartIndex + R.IndexCount <= Indices.size());
+
+            double Area = 0.0;
+            std::map<std::pair<uint32_t, uint32_t>, int> Edges;
+            for (uint32_t t = R.StartIndex; t < R.StartIndex + R.IndexCount; t += 3)
+            {
+                double x[3], z[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    CHECK(Indices[t + k] < Utility::TerrainVerticesPerPatch(N));
+                    x[k] = Indices[t + k] % (N + 1);
+                    z[k] = Indices[t + k] / (N + 1);
+                    ++Edges[{ Indices[t + k], Indices[t + (k + 1) % 3] }];
+                }
+
+                // y of cross(e1, e2), positive facing up
+                const double Up = (z[1] - z[0]) * (x[2] - x[0]) - (x[1] - x[0]) * (z[2] - z[0]);
+                CHECK(Up > 0.0);
+                Area += 0.5 * Up;
+            }
+            CHECK(std::fabs(Area - (double)N * N) < 1e-9);
+
+            for (const auto& Edge : Edges)
+            {
+                CHECK(Edge.second == 1);
+                if (Edges.count({ Edge.first.second, Edge.first.first }) != 0)
+                    continue;
+
+                const int Ax = Edge.first.first % (N + 1), Az = Edge.first.first / (N + 1);
+                const int Bx = Edge.first.second % (N + 1), Bz = Edge.first.second / (N + 1);
+                const bool West = Ax == 0 && Bx == 0, East = Ax == (int)N && Bx == (int)N;
+                const bool South = Az == 0 && Bz == 0, North = Az == (int)N && Bz == (int)N;
+                CHECK(West || East || South || North);
+
+                const bool Stitched = (West && (Mask & Utility::kTerrainWest)) || (East && (Mask & Utility::kTerrainEast)) ||
+                    (South && (Mask & Utility::kTerrainSouth)) || (North && (Mask & Utility::kTerrainNorth));
+                const int Length = std::abs(Ax - Bx) + std::abs(Az - Bz);
+                if (Stitched)
+                    CHECK(Length == 2 && Ax % 2 == 0 && Az % 2 == 0);
+                else
+                    CHECK(Length == 1);
+            }
+        }
+    }
+}
+
+// The east side of patch (3, 2, 4) against the west sides of its two level 4 neighbours:
+// every other fine vertex is a coarse one, bit for bit
+static void TestSharedEdges(void)
+{
+    const Utility::TerrainDesc Desc = MakeDesc();
+    const uint32_t N = Desc.PatchQuads;
+    std::vector<Utility::TerrainVertex> Coarse(Utility::TerrainVerticesPerPatch(N)), Fine(Coarse.size());
+    float BoundsMin[3], BoundsMax[3];
+    Utility::GenerateTerrainPatch(Desc, 3, 2, 4, Coarse.data(), BoundsMin, BoundsMax);
+
+    // bounds hold every vertex and the patch spans its square
+    for (const Utility::TerrainVertex& V : Coarse)
+    {
+        for (int i = 0; i < 3; ++i)
+            CHECK(V.Position[i] >= BoundsMin[i] && V.Position[i] <= BoundsMax[i]);
+        CHECK(V.Position[1] == Hills(V.Position[0], V.Position[2]));
+        CHECK(V.Normal[1] > 0.0f && std::fabs(V.Normal[0] * V.Normal[0] + V.Normal[1] * V.Normal[1] + V.Normal[2] * V.Normal[2] - 1.0f) < 1e-4f);
+    }
+    const float Size = Desc.Size / 8.0f;
+    CHECK(BoundsMin[0] == Desc.Origin[0] + 2 * Size && BoundsMax[0] == Desc.Origin[0] + 3 * Size);
+    CHECK(BoundsMin[2] == Desc.Origin[1] + 4 * Size && BoundsMax[2] == Desc.Origin[1] + 5 * Size);
+
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        Utility::GenerateTerrainPatch(Desc, 4, 6, 8 + c, Fine.data(), BoundsMin, BoundsMax);
+        for (uint32_t Row = 0; Row <= N; Row += 2)
+        {
+            const Utility::TerrainVertex& A = Coarse[(c * N / 2 + Row / 2) * (N + 1) + N];
+            const Utility::TerrainVertex& B = Fine[Row * (N + 1)];
+            CHECK(memcmp(&A, &B, sizeof(A)) == 0);
+        }
+    }
+}
+
+// Selection for eyes near the ground, at the rim, high above and outside the square. No leaf is
+// coarser than the split rule allows, and the leaf under a low eye is as fine as it gets.
+static void TestSelection(void)
+{
+    const Utility::TerrainDesc Desc = MakeDesc();
+    const float Eyes[][3] = { { 0, 40, 0 }, { -1000, 10, 900 }, { 500, 300, -200 }, { 0, 5000, 0 }, { 3000, 10, 0 } };
+
+    for (const float* Eye : Eyes)
+    {
+        std::vector<Utility::TerrainPatch> Leaves;
+        Utility::SelectTerrainPatches(Desc, Eye, Leaves);
+        const std::vector<int> Owner = CheckTiling(Desc, Leaves);
+
+        for (const Utility::TerrainPatch& L : Leaves)
+        {
+            if (L.Level < Desc.MaxDepth)
+                CHECK(DistanceToPatch(Desc, Eye, L, nullptr) >= Desc.SplitFactor * Desc.Size / (float)(1u << L.Level));
+        }
+
+        const uint32_t Fine = 1u << Desc.MaxDepth;
+        const float Cell = Desc.Size / Fine;
+        const int x = (int)std::floor((Eye[0] - Desc.Origin[0]) / Cell), z = (int)std::floor((Eye[2] - Desc.Origin[1]) / Cell);
+        if (x >= 0 && z >= 0 && x < (int)Fine && z < (int)Fine)
+            CHECK(Leaves[Owner[z * Fine + x]].Level == Desc.MaxDepth);
+    }
+
+    // heights known to be far below the eye select coarser patches
+    const float High[3] = { 0.0f, 400.0f, 0.0f };
+    std::vector<Utility::TerrainPatch> Flat, Ranged;
+    Utility::SelectTerrainPatches(Desc, High, Flat);
+    const float Range[2] = { -20.0f, 20.0f };
+    Utility::SelectTerrainPatches(Desc, High, Ranged, [&Range](uint32_t, uint32_t, uint32_t, float Out[2])
+    {
+        Out[0] = Range[0];
+        Out[1] = Range[1];
+        return true;
+    });
+    CheckTiling(Desc, Ranged);
+    CHECK(Ranged.size() < Flat.size());
+    for (const Utility::TerrainPatch& L : Ranged)
+    {
+        if (L.Level < Desc.MaxDepth)
+            CHECK(DistanceToPatch(Desc, High, L, Range) >= Desc.SplitFactor * Desc.Size / (float)(1u << L.Level));
+    }
+}
+
+static void TestCulling(void)
+{
+    std::vector<Utility::TerrainPatch> Patches(2);
+    Patches[0].BoundsMin[0] = Patches[0].BoundsMin[1] = Patches[0].BoundsMin[2] = 0.0f;
+    Patches[0].BoundsMax[0] = Patches[0].BoundsMax[1] = Patches[0].BoundsMax[2] = 1.0f;
+    Patches[1] = Patches[0];
+    Patches[1].BoundsMin[0] = -5.0f;
+    Patches[1].BoundsMax[0] = -4.0f;
+
+    // x >= -0.5 cuts the second box off, the first is inside every plane
+    const float Planes[6][4] = { { 1, 0, 0, 0.5f }, { -1, 0, 0, 10 }, { 0, 1, 0, 10 }, { 0, -1, 0, 10 }, { 0, 0, 1, 10 }, { 0, 0, -1, 10 } };
+    std::vector<uint32_t> Visible = { 7 };
+    Utility::CullTerrainPatches(Patches, Planes, Visible);
+    CHECK(Visible.size() == 1 && Visible[0] == 0);
+}
+
+// A diagonal flight across the terrain with fences completing two frames late, in a pool just
+// over two selections so slots have to be reused. Whatever is drawn sits in distinct slots
+// holding its own vertices, and once the eye stops the selection is drawn.
+static void TestStreaming(void)
+{
+    Utility::TerrainDesc Desc = MakeDesc();
+    Desc.MaxResidentPatches = 320;
+    const uint32_t PatchVertices = Utility::TerrainVerticesPerPatch(Desc.PatchQuads);
+    Utility::TerrainStreamer Streamer(Desc);
+
+    uint64_t Fence = 0;
+    auto IsFenceComplete = [&Fence](uint64_t Value) { return Value + 2 <= Fence; };
+
+    std::vector<std::vector<Utility::TerrainVertex>> Pool(Desc.MaxResidentPatches);
+    std::vector<Utility::TerrainStreamer::Upload> Uploads;
+    std::vector<Utility::TerrainVertex> Reference(PatchVertices);
+    float Eye[3] = { -900.0f, 20.0f, -900.0f };
+
+    for (int Frame = 0; Frame < 600; ++Frame)
+    {
+        Eye[0] += 3.0f;
+        Eye[2] += 2.5f;
+        Streamer.Update(Eye, IsFenceComplete);
+
+        Streamer.TakeUploads(Uploads);
+        for (Utility::TerrainStreamer::Upload& Upload : Uploads)
+        {
+            CHECK(Upload.Slot < Desc.MaxResidentPatches && Upload.Vertices.size() == PatchVertices);
+            if (Upload.Slot < Desc.MaxResidentPatches)
+                Pool[Upload.Slot] = std::move(Upload.Vertices);
+        }
+
+        std::set<uint32_t> Slots;
+        for (const Utility::TerrainPatch& P : Streamer.GetPatches())
+        {
+            CHECK(Slots.insert(P.Slot).second);
+            if (Frame % 50 == 0)
+            {
+                float BoundsMin[3], BoundsMax[3];
+                Utility::GenerateTerrainPatch(Desc, P.Level, P.X, P.Z, Reference.data(), BoundsMin, BoundsMax);
+                CHECK(Pool[P.Slot].size() == PatchVertices &&
+                    memcmp(Reference.data(), Pool[P.Slot].data(), PatchVertices * sizeof(Utility::TerrainVertex)) == 0);
+                CHECK(BoundsMin[1] == P.BoundsMin[1] && BoundsMax[1] == P.BoundsMax[1]);
+            }
+        }
+        CHECK(Streamer.GetStats().Resident <= Desc.MaxResidentPatches);
+        Streamer.RetireFrame(++Fence);
+    }
+
+    int Updates = 0;
+    while (!Streamer.Update(Eye, IsFenceComplete) && Updates < 100)
+    {
+        Streamer.Flush();
+        Streamer.TakeUploads(Uploads);
+        Streamer.RetireFrame(++Fence);
+        ++Updates;
+    }
+
+    const Utility::TerrainStreamer::Stats Stats = Streamer.GetStats();
+    printf("streaming: %u generated, %u evicted, settled %d updates after stopping on %u patches\n",
+        Stats.Generated, Stats.Evicted, Updates, Stats.Drawn);
+    CHECK(Updates < 100);
+    CHECK(Streamer.GetPatches().size() == Stats.Selected && Stats.Drawn == Stats.Selected);
+    CHECK(Stats.Evicted > 0);
+    CheckTiling(Desc, Streamer.GetPatches());
+}
+
+int main(void)
+{
+    TestStitching();
+    TestSharedEdges();
+    TestSelection();
+    TestCulling();
+    TestStreaming();
+    return Test::Finish("TerrainQuadtreeTest");
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Position-only meshes and cameras shared by the mesh tests and benchmarks: the skull from the
+// book's text format, a 100x100 grid with hills like the land, a UV sphere like
+// GeometryGenerator::CreateSphere, and random cameras around them.
+namespace Test
+{
+    struct Float3 { float x, y, z; };
+
+    inline Float3 operator-(const Float3& A, const Float3& B) { return { A.x - B.x, A.y - B.y, A.z - B.z }; }
+    inline Float3 operator+(const Float3& A, const Float3& B) { return { A.x + B.x, A.y + B.y, A.z + B.z }; }
+    inline Float3 operator*(const Float3& A, float S) { return { A.x * S, A.y * S, A.z * S }; }
+    inline float Dot(const Float3& A, const Float3& B) { return A.x * B.x + A.y * B.y + A.z * B.z; }
+    inline float Length(const Float3& A) { return std::sqrt(Dot(A, A)); }
+    inline Float3 Normalize(const Float3& A) { return A * (1.0f / Length(A)); }
+    inline Float3 Cross(const Float3& A, const Float3& B)
+    {
+        return { A.y * B.z - A.z * B.y, A.z * B.x - A.x * B.z, A.x * B.y - A.y * B.x };
+    }
+
+    // "VertexCount:", "TriangleCount:", one "px py pz nx ny nz" line per vertex, then three
+    // indices per triangle; the normals are skipped
+    inline bool LoadTextModel(const char* Path, std::vector<Float3>& Positions, std::vector<uint32_t>& Indices)
+    {
+        std::ifstream File(Path);
+        if (!File)
+            return false;
+
+        uint32_t VertexCount = 0, TriangleCount = 0;
+        std::string Ignore;
+        File >> Ignore >> VertexCount >> Ignore >> TriangleCount >> Ignore >> Ignore >> Ignore >> Ignore;
+
+        Positions.resize(VertexCount);
+        for (Float3& P : Positions)
+        {
+            Float3 Normal;
+            File >> P.x >> P.y >> P.z >> Normal.x >> Normal.y >> Normal.z;
+        }
+
+        File >> Ignore >> Ignore >> Ignore;
+        Indices.resize(3 * TriangleCount);
+        for (uint32_t& Index : Indices)
+            File >> Index;
+        return (bool)File;
+    }
+
+    // GeometryGenerator::CreateGrid's vertex and index order over 100x100 units, raised into
+    // hills so no two neighbouring triangles share a plane
+    inline void BuildHills(uint32_t Rows, uint32_t Columns, std::vector<Float3>& Positions, std::vector<uint32_t>& Indices)
+    {
+        Positions.resize(Rows * Columns);
+        for (uint32_t i = 0; i < Rows; ++i)
+        {
+            for (uint32_t j = 0; j < Columns; ++j)
+            {
+                const float x = -50.0f + j * 100.0f / (Columns - 1), z = 50.0f - i * 100.0f / (Rows - 1);
+                Positions[i * Columns + j] = { x, std::sin(x * 0.2f) * std::cos(z * 0.15f) * 3.0f, z };
+            }
+        }
+
+        Indices.clear();
+        for (uint32_t i = 0; i + 1 < Rows; ++i)
+        {
+            for (uint32_t j = 0; j + 1 < Columns; ++j)
+            {
+                const uint32_t Quad[6] = { i * Columns + j, i * Columns + j + 1, (i + 1) * Columns + j,
+                    (i + 1) * Columns + j, i * Columns + j + 1, (i + 1) * Columns + j + 1 };
+                Indices.insert(Indices.end(), Quad, Quad + 6);
+            }
+        }
+    }
+
+    // GeometryGenerator::CreateSphere's vertex and index order
+    inline void BuildSphere(float Radius, uint32_t Slices, uint32_t Stacks, std::vector<Float3>& Positions, std::vector<uint32_t>& Indices)
+    {
+        const float Pi = 3.1415926535f;
+
+        Positions.assign(1, Float3{ 0.0f, Radius, 0.0f });
+        for (uint32_t i = 1; i < Stacks; ++i)
+        {
+            const float Phi = i * Pi / Stacks;
+            for (uint32_t j = 0; j <= Slices; ++j)
+            {
+                const float Theta = j * 2.0f * Pi / Slices;
+                Positions.push_back({ Radius * std::sin(Phi) * std::cos(Theta), Radius * std::cos(Phi), Radius * std::sin(Phi) * std::sin(Theta) });
+            }
+        }
+        Positions.push_back({ 0.0f, -Radius, 0.0f });
+
+        Indices.clear();
+        for (uint32_t i = 1; i <= Slices; ++i)
+            Indices.insert(Indices.end(), { 0, i + 1, i });
+
+        const uint32_t Ring = Slices + 1;
+        for (uint32_t i = 0; i + 2 < Stacks; ++i)
+        {
+            for (uint32_t j = 0; j < Slices; ++j)
+            {
+                const uint32_t Base = 1 + i * Ring + j;
+                Indices.insert(Indices.end(), { Base, Base + 1, Base + Ring, Base + Ring, Base + 1, Base + Ring + 1 });
+            }
+        }
+
+        const uint32_t SouthPole = (uint32_t)Positions.size() - 1;
+        const uint32_t Base = SouthPole - Ring;
+        for (uint32_t i = 0; i < Slices; ++i)
+            Indices.insert(Indices.end(), { SouthPole, Base + i, Base + i + 1 });
+    }
+
+    // XMMatrixLookAtLH(Eye, At, up) * XMMatrixPerspectiveFovLH(FovY, Aspect, Near, Far), row vectors
+    inline void LookAtPerspective(const Float3& Eye, const Float3& At, float FovY, float Aspect, float Near, float Far, float Matrix[16])
+    {
+        const Float3 Z = Normalize(At - Eye);
+        const Float3 Up = std::fabs(Z.y) > 0.99f ? Float3{ 0.0f, 0.0f, 1.0f } : Float3{ 0.0f, 1.0f, 0.0f };
+        const Float3 X = Normalize(Cross(Up, Z));
+        const Float3 Y = Cross(Z, X);
+
+        const float View[16] = {
+            X.x, Y.x, Z.x, 0.0f,
+            X.y, Y.y, Z.y, 0.0f,
+            X.z, Y.z, Z.z, 0.0f,
+            -Dot(X, Eye), -Dot(Y, Eye), -Dot(Z, Eye), 1.0f };
+
+        const float H = 1.0f / std::tan(0.5f * FovY), W = H / Aspect, Q = Far / (Far - Near);
+        const float Projection[16] = {
+            W, 0.0f, 0.0f, 0.0f,
+            0.0f, H, 0.0f, 0.0f,
+            0.0f, 0.0f, Q, 1.0f,
+            0.0f, 0.0f, -Near * Q, 0.0f };
+
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                Matrix[r * 4 + c] = 0.0f;
+                for (int k = 0; k < 4; ++k)
+                    Matrix[r * 4 + c] += View[r * 4 + k] * Projection[k * 4 + c];
+            }
+        }
+    }
+
+    enum class ViewKind { Orbit, CloseUp, Inside };
+
+    // A random camera around the sphere at Center with Radius: orbiting at three radii and
+    // looking at the center, at 1.3 radii looking somewhere near it, or at 0.6 radii inside
+    // the bounds. 45 degree field of view, 16:9.
+    inline void RandomView(ViewKind Kind, std::mt19937& Random, const Float3& Center, float Radius, Float3& Eye, float Matrix[16])
+    {
+        std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+        Float3 Direction;
+        do
+            Direction = { Unit(Random), Unit(Random), Unit(Random) };
+        while (Dot(Direction, Direction) < 1e-4f);
+
+        const float Distance = Kind == ViewKind::Orbit ? 3.0f * Radius : Kind == ViewKind::CloseUp ? 1.3f * Radius : 0.6f * Radius;
+        Eye = Center + Normalize(Direction) * Distance;
+
+        Float3 At = Center;
+        if (Kind == ViewKind::CloseUp)
+            At = At + Float3{ Unit(Random), Unit(Random), Unit(Random) } * (0.5f * Radius);
+
+        LookAtPerspective(Eye, At, 0.785f, 16.0f / 9.0f, 0.01f * Radius, 100.0f * Radius, Matrix);
+    }
+
+    // Center and radius of the sphere around the box of Positions
+    inline void BoundingSphere(const std::vector<Float3>& Positions, Float3& Center, float& Radius)
+    {
+        Float3 Min = { 1e30f, 1e30f, 1e30f }, Max = { -1e30f, -1e30f, -1e30f };
+        for (const Float3& P : Positions)
+        {
+            Min = { std::fmin(Min.x, P.x), std::fmin(Min.y, P.y), std::fmin(Min.z, P.z) };
+            Max = { std::fmax(Max.x, P.x), std::fmax(Max.y, P.y), std::fmax(Max.z, P.z) };
+        }
+        Center = (Min + Max) * 0.5f;
+        Radius = 0.5f * Length(Max - Min);
+    }
+}
@@ -0,0 +1,317 @@
+#include "TestHarness.h"
+#include "TextureManager.h"
+#include "DDSTextureLoader.h"
+#include "GraphicsCore.h"
+#include "NullDevice.h"
+#include "ThreadPool.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+
+// TextureManager against the stand-ins in Headless/Mock, on a null device. A descriptor is a heap cell holding the id of the texture
+// its view shows: the default textures have ids 1000 + eDefaultTexture, a file written by
+// this test holds its own id after the DDS magic, and the mock loader copies that id into the
+// view it is given. Live descriptors, resources and bindless slots are counted, so leaks and
+// double frees show up as counts that do not return to zero.
+
+namespace
+{
+    std::atomic<int> s_LiveDescriptors{ 0 };
+    std::atomic<int> s_LiveBindless{ 0 };
+    std::atomic<int> s_LiveResources{ 0 };
+    std::atomic<uint32_t> s_NextBindless{ 100 };
+
+    // Uploads per texture id, and how long each takes
+    std::mutex s_LoadMutex;
+    std::map<uint32_t, int> s_LoadCount;
+    std::atomic<int> s_LoadMilliseconds{ 0 };
+
+    std::atomic<uint32_t> s_DefaultCells[Graphics::kNumDefaultTextures];
+
+    uint32_t Read(D3D12_CPU_DESCRIPTOR_HANDLE Handle)
+    {
+        return ((std::atomic<uint32_t>*)Handle.ptr)->load();
+    }
+
+    struct MockDevice : public NullDevice
+    {
+        virtual void CopyDescriptorsSimple(unsigned int NumDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE DestStart,
+            D3D12_CPU_DESCRIPTOR_HANDLE SrcStart, D3D12_DESCRIPTOR_HEAP_TYPE) override
+        {
+            CHECK(NumDescriptors == 1);
+            ((std::atomic<uint32_t>*)DestStart.ptr)->store(Read(SrcStart));
+        }
+    };
+    MockDevice s_Device;
+
+    // The resource a texture holds, counted so the test sees it go away with the texture
+    struct MockResource : public NullResource
+    {
+        explicit MockResource(const D3D12_RESOURCE_DESC& Desc) : NullResource(&s_Device, Desc, D3D12_HEAP_TYPE_DEFAULT)
+        {
+            ++s_LiveResources;
+        }
+        ~MockResource() { --s_LiveResources; }
+    };
+
+    void WriteTexture(const std::filesystem::path& Path, uint32_t Id)
+    {
+        std::ofstream File(Path, std::ios::binary);
+        File.write("DDS ", 4);
+        File.write((const char*)&Id, sizeof(Id));
+    }
+}
+
+ID3D12Device* Graphics::g_Device = &s_Device;
+Graphics::BindlessDescriptorHeap Graphics::g_BindlessHeap;
+
+uint32_t Graphics::BindlessDescriptorHeap::Allocate(D3D12_CPU_DESCRIPTOR_HANDLE)
+{
+    ++s_LiveBindless;
+    return s_NextBindless++;
+}
+
+void Graphics::BindlessDescriptorHeap::Free(uint32_t Index)
+{
+    if (Index != DescriptorIndexAllocator::kInvalidIndex)
+        --s_LiveBindless;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE, UINT)
+{
+    ++s_LiveDescriptors;
+    return { (size_t)new std::atomic<uint32_t>(~0u) };
+}
+
+void Graphics::FreeDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE Handle, D3D12_DESCRIPTOR_HEAP_TYPE, UINT)
+{
+    if (Handle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        return;
+    --s_LiveDescriptors;
+    delete (std::atomic<uint32_t>*)Handle.ptr;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Graphics::GetDefaultTexture(eDefaultTexture texID)
+{
+    return { (size_t)&s_DefaultCells[texID] };
+}
+
+uint32_t Graphics::GetDefaultTextureIndex(eDefaultTexture texID)
+{
+    return (uint32_t)texID;
+}
+
+// As in Texture.cpp
+Texture::~Texture()
+{
+    Graphics::FreeDescriptor(m_hCpuDescriptorHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+HRESULT CreateDDSTextureFromMemory(ID3D12Device* d3dDevice, const uint8_t* ddsData, size_t ddsDataSize,
+    size_t, bool, ID3D12Resource** texture, D3D12_CPU_DESCRIPTOR_HANDLE textureView, DDS_ALPHA_MODE*)
+{
+    CHECK(d3dDevice == &s_Device);
+    if (s_LoadMilliseconds > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(s_LoadMilliseconds));
+
+    if (ddsDataSize != 8 || memcmp(ddsData, "DDS ", 4) != 0)
+        return -1;
+
+    uint32_t Id;
+    memcpy(&Id, ddsData + 4, sizeof(Id));
+    {
+        std::lock_guard<std::mutex> Guard(s_LoadMutex);
+        ++s_LoadCount[Id];
+    }
+
+    D3D12_RESOURCE_DESC Desc = {};
+    Desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    Desc.Width = 256;
+    Desc.Height = 256;
+    Desc.DepthOrArraySize = 1;
+    Desc.MipLevels = 1;
+    *texture = new MockResource(Desc);
+    ((std::atomic<uint32_t>*)textureView.ptr)->store(Id);
+    return 0;
+}
+
+int main(void)
+{
+    using namespace TextureManager;
+    using Graphics::kMagenta2D;
+    using Graphics::kBlackOpaque2D;
+
+    for (uint32_t i = 0; i < Graphics::kNumDefaultTextures; ++i)
+        s_DefaultCells[i] = 1000 + i;
+
+    const std::filesystem::path Root = std::filesystem::current_path() / "TextureManagerTest.files";
+    std::filesystem::create_directories(Root);
+    const uint32_t NumFiles = 8;
+    std::vector<std::wstring> Names;
+    for (uint32_t i = 0; i < NumFiles; ++i)
+    {
+        Names.push_back(L"tex" + std::to_wstring(i) + L".dds");
+        WriteTexture(Root / Names.back(), i);
+    }
+    std::ofstream(Root / "bad.dds", std::ios::binary) << "xx";
+
+    Initialize(Root.wstring() + L"/");
+
+    // An asynchronous load shows the fallback through its final descriptor until Update
+    // publishes it, then the texture through the same descriptor
+    {
+        s_LoadMilliseconds = 20;
+        TextureRef Ref = LoadDDSFromFileAsync(Names[0], false, kBlackOpaque2D);
+        const D3D12_CPU_DESCRIPTOR_HANDLE Handle = Ref.GetSRV();
+        CHECK(!Ref.IsValid());
+        CHECK(Read(Handle) == 1000 + kBlackOpaque2D);
+        CHECK(Ref.GetBindlessIndex() == kBlackOpaque2D);
+
+        while (GetPendingLoadCount() != 0)
+            std::this_thread::yield();
+        CHECK(!Ref.IsValid());
+        CHECK(Read(Handle) == 1000 + kBlackOpaque2D);
+
+        Update();
+        CHECK(Ref.IsValid());
+        CHECK(Ref.GetSRV().ptr == Handle.ptr);
+        CHECK(Read(Handle) == 0);
+        CHECK(Ref.GetBindlessIndex() >= 100);
+    }
+    CHECK(s_LiveDescriptors == 0 && s_LiveResources == 0 && s_LiveBindless == 0);
+
+    // Files that do not load keep their fallback and never turn valid
+    {
+        TextureRef Bad = LoadDDSFromFileAsync(L"bad.dds");
+        TextureRef Missing = LoadDDSFromFile(std::wstring(L"missing.dds"), false, kBlackOpaque2D);
+        WaitForAllLoads();
+        CHECK(!Bad.IsValid() && Read(Bad.GetSRV()) == 1000 + kMagenta2D);
+        CHECK(!Missing.IsValid() && Read(Missing.GetSRV()) == 1000 + kBlackOpaque2D);
+        CHECK(Bad.GetBindlessIndex() == kMagenta2D);
+    }
+    CHECK(s_LiveDescriptors == 0 && s_LiveResources == 0 && s_LiveBindless == 0);
+
+    // Many threads request the same files at once, synchronously and asynchronously. Every
+    // file is uploaded once, every request for it shares one texture, a synchronous request
+    // returns it published even when an asynchronous load of it is still running, and it
+    // gets one bindless slot.
+    {
+        s_LoadMilliseconds = 5;
+        s_LoadCount.clear();
+
+        const int NumThreads = 8;
+        std::vector<std::vector<TextureRef>> Refs(NumThreads);
+        std::atomic<int> Running{ NumThreads };
+        std::vector<std::thread> Threads;
+        for (int t = 0; t < NumThreads; ++t)
+        {
+            Threads.emplace_back([&, t]
+            {
+                std::mt19937 Rng(t);
+                std::vector<uint32_t> Order(NumFiles);
+                for (uint32_t i = 0; i < NumFiles; ++i)
+                    Order[i] = i;
+                std::shuffle(Order.begin(), Order.end(), Rng);
+
+                for (uint32_t i : Order)
+                {
+                    if (Rng() % 2)
+                    {
+                        TextureRef Ref = LoadDDSFromFile(Names[i]);
+                        CHECK(Ref.IsValid());
+                        CHECK(Read(Ref.GetSRV()) == i);
+                        Refs[t].push_back(Ref);
+                    }
+                    else
+                    {
+                        Refs[t].push_back(LoadDDSFromFileAsync(Names[i]));
+                    }
+                }
+                --Running;
+            });
+        }
+
+        // the render thread publishes while the requests come in
+        while (Running > 0)
+        {
+            Update();
+            std::this_thread::yield();
+        }
+        for (std::thread& Thread : Threads)
+            Thread.join();
+        WaitForAllLoads();
+
+        for (uint32_t i = 0; i < NumFiles; ++i)
+            CHECK(s_LoadCount[i] == 1);
+
+        std::vector<const Texture*> Textures(NumFiles, nullptr);
+        for (int t = 0; t < NumThreads; ++t)
+        {
+            CHECK(Refs[t].size() == NumFiles);
+            for (const TextureRef& Ref : Refs[t])
+            {
+                CHECK(Ref.IsValid());
+                const uint32_t Id = Read(Ref.GetSRV());
+                CHECK(Id < NumFiles);
+                if (Id >= NumFiles)
+                    continue;
+                if (Textures[Id] == nullptr)
+                    Textures[Id] = Ref.Get();
+                CHECK(Ref.Get() == Textures[Id]);
+            }
+        }
+        CHECK(s_LiveResources == (int)NumFiles);
+        CHECK(s_LiveBindless == (int)NumFiles);
+    }
+    CHECK(s_LiveDescriptors == 0 && s_LiveResources == 0 && s_LiveBindless == 0);
+
+    // References taken and dropped from many threads at once: the last reference of a texture
+    // races with new requests for the same file. Each texture must be destroyed exactly once,
+    // and only once nothing refers to it.
+    {
+        s_LoadMilliseconds = 0;
+
+        const int NumThreads = 8;
+        const int NumIterations = 5000;
+        std::atomic<int> Running{ NumThreads };
+        std::vector<std::thread> Threads;
+        for (int t = 0; t < NumThreads; ++t)
+        {
+            Threads.emplace_back([&, t]
+            {
+                std::mt19937 Rng(100 + t);
+                for (int i = 0; i < NumIterations; ++i)
+                {
+                    const uint32_t Index = Rng() % 2;
+                    TextureRef Ref = (Rng() % 4 == 0) ? LoadDDSFromFileAsync(Names[Index]) : LoadDDSFromFile(Names[Index]);
+                    TextureRef Copy = Ref;
+                    Ref = nullptr;
+                    CHECK(Copy.Get() != nullptr);
+                    if (Copy.IsValid())
+                        CHECK(Read(Copy.GetSRV()) == Index);
+                }
+                --Running;
+            });
+        }
+
+        while (Running > 0)
+        {
+            Update();
+            std::this_thread::yield();
+        }
+        for (std::thread& Thread : Threads)
+            Thread.join();
+        WaitForAllLoads();
+    }
+    CHECK(s_LiveDescriptors == 0 && s_LiveResources == 0 && s_LiveBindless == 0);
+
+    Shutdown();
+    ThreadPool::Shutdown();
+    std::filesystem::remove_all(Root);
+
+    return Test::Finish("TextureManagerTest");
+}
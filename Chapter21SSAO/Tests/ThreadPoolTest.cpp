@@ -0,0 +1,70 @@
+#include "TestHarness.h"
+#include "ThreadPool.h"
+#include <thread>
+#include <vector>
+
+int main(void)
+{
+    ThreadPool::Initialize(2);
+
+    // every index exactly once, for grains that divide the range and grains that do not
+    for (int Grain : { 1, 3, 64, 1000 })
+    {
+        std::vector<std::atomic<int>> Visits(1000);
+        ThreadPool::ParallelFor(0, 1000, [&Visits](int i) { ++Visits[i]; }, Grain);
+        for (std::atomic<int>& Count : Visits)
+            CHECK(Count == 1);
+    }
+
+    // nested loops on the workers finish
+    {
+        std::atomic<int> Total{ 0 };
+        ThreadPool::ParallelFor(0, 16, [&Total](int)
+        {
+            ThreadPool::ParallelFor(0, 16, [&Total](int) { ++Total; });
+        });
+        CHECK(Total == 256);
+    }
+
+    // While it waits for its helpers, the caller of ParallelFor must not run a job somebody
+    // else submitted: on the render thread that could be a whole texture load. Both workers
+    // are kept busy so the helpers and the job stay queued, the job ahead of them.
+    {
+        std::atomic<bool> Release{ false };
+        std::atomic<int> Blocked{ 0 };
+        for (int i = 0; i < 2; ++i)
+        {
+            ThreadPool::Submit([&]
+            {
+                ++Blocked;
+                while (!Release)
+                    std::this_thread::yield();
+                --Blocked;
+            });
+        }
+        while (Blocked < 2)
+            std::this_thread::yield();
+
+        std::atomic<bool> JobDone{ false };
+        std::thread::id JobThread;
+        ThreadPool::Submit([&]
+        {
+            JobThread = std::this_thread::get_id();
+            JobDone = true;
+        });
+
+        std::atomic<int> Sum{ 0 };
+        ThreadPool::ParallelFor(0, 100, [&Sum](int i) { Sum += i; });
+        CHECK(Sum == 4950);
+        CHECK(!JobDone);
+
+        Release = true;
+        while (!JobDone || Blocked > 0)
+            std::this_thread::yield();
+        CHECK(JobThread != std::this_thread::get_id());
+    }
+
+    ThreadPool::Shutdown();
+
+    return Test::Finish("ThreadPoolTest");
+}
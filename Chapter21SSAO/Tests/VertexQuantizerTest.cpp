@@ -0,0 +1,211 @@
+#include "TestHarness.h"
+#include "TestMeshes.h"
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Round trips of every encoding CompactVertex uses. Half floats are checked exhaustively: every
+// half decodes and encodes back to itself, and the floats either side of the midpoint between
+// two neighbouring halves round to the nearer one, ties to the even one. Octahedral normals
+// stay within a hundredth of a degree over random directions, the axes and the fold.
+// Positions stay within half a unorm step of the bounds on every axis, and a flat axis decodes
+// exactly. Then the whole vertex on the skull.
+
+namespace
+{
+    float AngleDegrees(const float A[3], const float B[3])
+    {
+        const Test::Float3 U = { A[0], A[1], A[2] }, V = { B[0], B[1], B[2] };
+        return std::atan2(Test::Length(Test::Cross(U, V)), Test::Dot(U, V)) * (180.0f / 3.14159265f);
+    }
+
+    float OctahedralRoundTrip(Test::Float3 Direction)
+    {
+        Direction = Test::Normalize(Direction);
+        int16_t Encoded[2];
+        float Decoded[3];
+        Utility::EncodeOctahedral(&Direction.x, Encoded);
+        Utility::DecodeOctahedral(Encoded, Decoded);
+        return AngleDegrees(&Direction.x, Decoded);
+    }
+
+    // One vertex of an array of structs, as GameApp's Vertex lays them out
+    struct SourceVertex
+    {
+        Test::Float3 Position;
+        Test::Float3 Normal;
+        float TexC[2];
+        Test::Float3 Tangent;
+    };
+
+    Utility::QuantizationError Quantize(const std::vector<SourceVertex>& Vertices, Utility::PositionQuantization& Quantization,
+        std::vector<Utility::CompactVertex>& Quantized)
+    {
+        const SourceVertex& First = Vertices[0];
+        Quantization = Utility::ComputePositionQuantization(&First.Position.x, sizeof(SourceVertex), Vertices.size());
+        Quantized.resize(Vertices.size());
+        Utility::QuantizeVertices(Quantized.data(), Vertices.size(), sizeof(SourceVertex),
+            &First.Position.x, &First.Normal.x, First.TexC, &First.Tangent.x, Quantization);
+        return Utility::MeasureQuantizationError(Quantized.data(), Vertices.size(), sizeof(SourceVertex),
+            &First.Position.x, &First.Normal.x, First.TexC, &First.Tangent.x, Quantization);
+    }
+}
+
+static void TestHalf(void)
+{
+    for (uint32_t h = 0; h < 0x10000; ++h)
+    {
+        const float Value = Utility::HalfToFloat((uint16_t)h);
+        if (std::isnan(Value))
+            CHECK(std::isnan(Utility::HalfToFloat(Utility::FloatToHalf(Value))));
+        else
+            CHECK(Utility::FloatToHalf(Value) == h);
+    }
+
+    // every midpoint is exact in a float, subnormal halves included
+    const float Infinity = std::numeric_limits<float>::infinity();
+    for (uint16_t h = 0; h < 0x7BFF; ++h)
+    {
+        const float Low = Utility::HalfToFloat(h), High = Utility::HalfToFloat(h + 1);
+        const float Middle = 0.5f * (Low + High);
+        const uint16_t Even = (h & 1) ? h + 1 : h;
+        CHECK(Utility::FloatToHalf(std::nextafter(Middle, 0.0f)) == h);
+        CHECK(Utility::FloatToHalf(std::nextafter(Middle, Infinity)) == h + 1);
+        CHECK(Utility::FloatToHalf(Middle) == Even);
+        CHECK(Utility::FloatToHalf(-Middle) == (Even | 0x8000));
+    }
+
+    // past the largest half, 65504, the next step would be 65536: halfway there rounds to
+    // infinity, just below it rounds down
+    CHECK(Utility::FloatToHalf(65520.0f) == 0x7C00);
+    CHECK(Utility::FloatToHalf(std::nextafter(65520.0f, 0.0f)) == 0x7BFF);
+    CHECK(Utility::FloatToHalf(1e10f) == 0x7C00 && Utility::FloatToHalf(-1e10f) == 0xFC00);
+    CHECK(Utility::FloatToHalf(Infinity) == 0x7C00 && Utility::FloatToHalf(-Infinity) == 0xFC00);
+    CHECK(Utility::FloatToHalf(1e-10f) == 0 && Utility::FloatToHalf(-1e-10f) == 0x8000);
+    CHECK(std::isnan(Utility::HalfToFloat(Utility::FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+static void TestOctahedral(void)
+{
+    // half the diagonal of a 1/32767 cell is 0.0012 degrees where the octahedron touches the
+    // sphere, and its faces stretch that to about 0.0073 where they are most slanted to it
+    const float kMaxDegrees = 0.01f;
+
+    float Worst = 0.0f;
+    const Test::Float3 Special[] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+        { 1, 0, -1 }, { 0, -1, -1 }, { -1, 1, -1 }, { 1, 1, 0 }, { -1, -1, 1e-6f }, { 1e-6f, 1, -1 } };
+    for (const Test::Float3& Direction : Special)
+        Worst = std::max(Worst, OctahedralRoundTrip(Direction));
+
+    std::mt19937 Random(1);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+    for (int i = 0; i < 200000; ++i)
+    {
+        const Test::Float3 Direction = { Unit(Random), Unit(Random), Unit(Random) };
+        if (Test::Length(Direction) > 1e-3f)
+            Worst = std::max(Worst, OctahedralRoundTrip(Direction));
+    }
+    printf("octahedral: %.5f degrees at worst\n", Worst);
+    CHECK(Worst < kMaxDegrees);
+
+    // a zero vector has no direction and encodes to (0, 0)
+    const float Zero[3] = { 0.0f, 0.0f, 0.0f };
+    int16_t Encoded[2] = { 1, 1 };
+    Utility::EncodeOctahedral(Zero, Encoded);
+    CHECK(Encoded[0] == 0 && Encoded[1] == 0);
+}
+
+static void TestPositions(void)
+{
+    std::mt19937 Random(3);
+    std::uniform_real_distribution<float> Unit(-1.0f, 1.0f);
+
+    // y is flat, x and z span very different ranges
+    std::vector<SourceVertex> Vertices(5000);
+    for (SourceVertex& V : Vertices)
+    {
+        V = {};
+        V.Position = { 1000.0f + 500.0f * Unit(Random), 7.25f, 0.01f * Unit(Random) };
+        V.Normal = { 0.0f, 1.0f, 0.0f };
+        V.Tangent = { 1.0f, 0.0f, 0.0f };
+    }
+
+    Utility::PositionQuantization Quantization;
+    std::vector<Utility::CompactVertex> Quantized;
+    Quantize(Vertices, Quantization, Quantized);
+    CHECK(Quantization.Scale[1] == 1.0f && Quantization.Bias[1] == 7.25f);
+
+    for (size_t v = 0; v < Vertices.size(); ++v)
+    {
+        float Position[3], Normal[3], TexC[2], Tangent[3];
+        Utility::DequantizeVertex(Quantized[v], Quantization, Position, Normal, TexC, Tangent);
+        CHECK(Quantized[v].Position[3] == 0);
+        CHECK(Position[1] == 7.25f);
+
+        const float* Source = &Vertices[v].Position.x;
+        for (int i = 0; i < 3; i += 2)
+        {
+            // half a step, and the rounding of a float the size of the bias
+            const float Tolerance = 0.5f * Quantization.Scale[i] / 65535.0f + 2.0f * std::fabs(Quantization.Bias[i]) * 1.2e-7f;
+            CHECK(std::fabs(Position[i] - Source[i]) <= Tolerance);
+        }
+    }
+}
+
+static void TestSkull(void)
+{
+    std::vector<Test::Float3> Positions;
+    std::vector<uint32_t> Indices;
+    CHECK(Test::LoadTextModel("../../Models/skull.txt", Positions, Indices));
+    if (Positions.empty())
+        return;
+
+    // normals from the faces, tangents across them, texture coordinates tiled four times
+    std::vector<SourceVertex> Vertices(Positions.size(), SourceVertex{});
+    for (size_t t = 0; t < Indices.size(); t += 3)
+    {
+        const Test::Float3 Normal = Test::Cross(Positions[Indices[t + 1]] - Positions[Indices[t]], Positions[Indices[t + 2]] - Positions[Indices[t]]);
+        for (int k = 0; k < 3; ++k)
+            Vertices[Indices[t + k]].Normal = Vertices[Indices[t + k]].Normal + Normal;
+    }
+
+    std::mt19937 Random(5);
+    std::uniform_real_distribution<float> Tile(-4.0f, 4.0f);
+    for (size_t v = 0; v < Vertices.size(); ++v)
+    {
+        SourceVertex& V = Vertices[v];
+        V.Position = Positions[v];
+        V.Normal = Test::Length(V.Normal) > 0.0f ? Test::Normalize(V.Normal) : Test::Float3{ 0.0f, 1.0f, 0.0f };
+        V.Tangent = std::fabs(V.Normal.y) < 0.99f ? Test::Normalize(Test::Cross({ 0.0f, 1.0f, 0.0f }, V.Normal)) : Test::Float3{ 1.0f, 0.0f, 0.0f };
+        V.TexC[0] = Tile(Random);
+        V.TexC[1] = Tile(Random);
+    }
+
+    Utility::PositionQuantization Quantization;
+    std::vector<Utility::CompactVertex> Quantized;
+    const Utility::QuantizationError Error = Quantize(Vertices, Quantization, Quantized);
+
+    const float Step = std::max({ Quantization.Scale[0], Quantization.Scale[1], Quantization.Scale[2] }) / 65535.0f;
+    const float Rounding = 2.0f * std::max({ std::fabs(Quantization.Bias[0]), std::fabs(Quantization.Bias[1]), std::fabs(Quantization.Bias[2]) }) * 1.2e-7f;
+    printf("skull: %zu -> %zu bytes, position %.6f (half step %.6f), normal %.5f deg, texc %.6f, tangent %.5f deg\n",
+        Vertices.size() * sizeof(SourceVertex), Quantized.size() * sizeof(Utility::CompactVertex),
+        Error.Position, 0.5f * Step, Error.Normal, Error.TexC, Error.Tangent);
+
+    CHECK(sizeof(Utility::CompactVertex) == 20);
+    CHECK(Error.Position <= 0.5f * Step + Rounding);
+    CHECK(Error.Normal < 0.01f && Error.Tangent < 0.01f);
+    CHECK(Error.TexC <= 4.0f / 2048.0f);     // half of an ulp of a half float in [2, 4)
+}
+
+int main(void)
+{
+    TestHalf();
+    TestOctahedral();
+    TestPositions();
+    TestSkull();
+    return Test::Finish("VertexQuantizerTest");
+}
@@ -0,0 +1,278 @@
+#include "TestHarness.h"
+#include "Waves.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+// Waves against a plain scalar solver written from the wave equation: the fixed step and its
+// accumulator, the cap on substeps, the energy the damping takes out every step, and what the
+// accessors show while UpdateAsync runs. The grid is 45 columns wide so every SIMD kernel also
+// takes its scalar remainder.
+
+namespace
+{
+    const int kRows = 37;
+    const int kCols = 45;
+    const float kSpatialStep = 0.25f;
+    const float kTimeStep = 0.03f;
+    const float kSpeed = 3.25f;
+    const float kDamping = 0.4f;
+
+    // The update Waves documents, one cell at a time, with the sums grouped as Waves groups them
+    class ReferenceWaves
+    {
+    public:
+        ReferenceWaves(void) : m_Prev(kRows * kCols, 0.0f), m_Curr(kRows * kCols, 0.0f)
+        {
+            float d = kDamping * kTimeStep + 2.0f;
+            float e = (kSpeed * kSpeed) * (kTimeStep * kTimeStep) / (kSpatialStep * kSpatialStep);
+            m_K1 = (kDamping * kTimeStep - 2.0f) / d;
+            m_K2 = (4.0f - 8.0f * e) / d;
+            m_K3 = (2.0f * e) / d;
+        }
+
+        void Disturb(int i, int j, float Magnitude)
+        {
+            m_Curr[i * kCols + j] += Magnitude;
+            m_Curr[i * kCols + j + 1] += 0.5f * Magnitude;
+            m_Curr[i * kCols + j - 1] += 0.5f * Magnitude;
+            m_Curr[(i + 1) * kCols + j] += 0.5f * Magnitude;
+            m_Curr[(i - 1) * kCols + j] += 0.5f * Magnitude;
+        }
+
+        void Step(void)
+        {
+            for (int i = 1; i < kRows - 1; ++i)
+            {
+                for (int j = 1; j < kCols - 1; ++j)
+                {
+                    float& h = m_Prev[i * kCols + j];
+                    h = m_K1 * h + m_K2 * m_Curr[i * kCols + j] +
+                        m_K3 * ((Curr(i + 1, j) + Curr(i - 1, j)) + (Curr(i, j + 1) + Curr(i, j - 1)));
+                }
+            }
+            m_Prev.swap(m_Curr);
+        }
+
+        float Curr(int i, int j) const { return m_Curr[i * kCols + j]; }
+        const std::vector<float>& Heights(void) const { return m_Curr; }
+
+    private:
+        float m_K1, m_K2, m_K3;
+        std::vector<float> m_Prev;
+        std::vector<float> m_Curr;
+    };
+
+    float MaxDifference(const float* Heights, const std::vector<float>& Expected)
+    {
+        float Diff = 0.0f;
+        for (size_t i = 0; i < Expected.size(); ++i)
+            Diff = std::max(Diff, fabsf(Heights[i] - Expected[i]));
+        return Diff;
+    }
+
+    // Energy between two consecutive solutions, the one this scheme keeps or loses to damping:
+    // |(u1 - u0) / dt|^2 plus c^2 times the gradient of u1 dotted with the gradient of u0. The
+    // boundary is held at zero, so every edge of the grid counts.
+    double Energy(const std::vector<float>& u0, const float* u1)
+    {
+        const double c2 = (double)kSpeed * kSpeed / ((double)kSpatialStep * kSpatialStep);
+        double Kinetic = 0.0, Potential = 0.0;
+        for (int i = 0; i < kRows; ++i)
+        {
+            for (int j = 0; j < kCols; ++j)
+            {
+                const int k = i * kCols + j;
+                double v = ((double)u1[k] - u0[k]) / kTimeStep;
+                Kinetic += v * v;
+                if (j + 1 < kCols)
+                    Potential += ((double)u1[k + 1] - u1[k]) * ((double)u0[k + 1] - u0[k]);
+                if (i + 1 < kRows)
+                    Potential += ((double)u1[k + kCols] - u1[k]) * ((double)u0[k + kCols] - u0[k]);
+            }
+        }
+        return Kinetic + c2 * Potential;
+    }
+
+    // Keeps every worker busy, so jobs submitted meanwhile stay queued until Release
+    class PoolBlocker
+    {
+    public:
+        PoolBlocker(void)
+        {
+            const int Workers = (int)ThreadPool::GetWorkerCount();
+            for (int i = 0; i < Workers; ++i)
+            {
+                ThreadPool::Submit([this]
+                {
+                    ++m_Blocked;
+                    while (!m_Release)
+                        std::this_thread::yield();
+                    --m_Blocked;
+                });
+            }
+            while (m_Blocked < Workers)
+                std::this_thread::yield();
+        }
+
+        ~PoolBlocker(void) { Release(); }
+
+        void Release(void)
+        {
+            m_Release = true;
+            while (m_Blocked > 0)
+                std::this_thread::yield();
+        }
+
+    private:
+        std::atomic<bool> m_Release{ false };
+        std::atomic<int> m_Blocked{ 0 };
+    };
+}
+
+// Time is spent in whole steps and the rest carried to the next call. dt = 0.25 and the frame
+// times are exact in binary, so the expected counts are too.
+static void TestAccumulator(void)
+{
+    Waves Grid(kRows, kCols, 1.0f, 0.25f, 1.0f, 0.0f);
+
+    CHECK(Grid.Update(0.15625f) == 0);
+    CHECK(Grid.Update(0.15625f) == 1);    // 0.3125, 0.0625 left
+    CHECK(Grid.Update(0.15625f) == 0);    // 0.21875
+    CHECK(Grid.Update(0.15625f) == 1);    // 0.375, 0.125 left
+    CHECK(Grid.Update(0.625f) == 3);      // 0.75
+    CHECK(Grid.Update(0.0f) == 0);
+    CHECK(Grid.StepCount() == 5);
+}
+
+// A long frame runs at most MaxSubsteps and drops the whole steps beyond them, keeping the
+// fraction
+static void TestSubstepCap(void)
+{
+    Waves Grid(kRows, kCols, 1.0f, 0.25f, 1.0f, 0.0f);
+    CHECK(Grid.Update(10.0f) == 4);
+    CHECK(Grid.StepCount() == 4);
+
+    Grid.SetMaxSubsteps(2);
+    CHECK(Grid.Update(1.125f) == 2);
+    CHECK(Grid.StepCount() == 6);
+
+    // 0.125 was kept, 0.125 more makes one step
+    CHECK(Grid.Update(0.125f) == 1);
+    CHECK(Grid.Update(0.0f) == 0);
+    CHECK(Grid.StepCount() == 7);
+}
+
+static void TestMatchesReferenceAndLosesEnergy(void)
+{
+    Waves Grid(kRows, kCols, kSpatialStep, kTimeStep, kSpeed, kDamping);
+    ReferenceWaves Reference;
+    Grid.Disturb(10, 12, 0.8f);
+    Grid.Disturb(25, 33, -0.5f);
+    Reference.Disturb(10, 12, 0.8f);
+    Reference.Disturb(25, 33, -0.5f);
+
+    std::vector<float> Previous(Grid.Heights(), Grid.Heights() + kRows * kCols);
+    double FirstEnergy = 0.0, LastEnergy = 0.0;
+    const double Tolerance = 1e-5;
+
+    for (int s = 0; s < 200; ++s)
+    {
+        CHECK(Grid.Update(kTimeStep) == 1);
+        Reference.Step();
+        CHECK(MaxDifference(Grid.Heights(), Reference.Heights()) <= 1e-6f);
+
+        // the disturbed solution the first step started from is never published, so the
+        // first pair to measure is the first two steps
+        const double E = Energy(Previous, Grid.Heights());
+        if (s > 0)
+            CHECK(E > 0.0);
+        if (s == 1)
+            FirstEnergy = E;
+        if (s > 1)
+            CHECK(E <= LastEnergy * (1.0 + Tolerance));
+        LastEnergy = E;
+        Previous.assign(Grid.Heights(), Grid.Heights() + kRows * kCols);
+    }
+
+    // 6 seconds at a damping of 0.4 leave about a tenth
+    CHECK(LastEnergy < FirstEnergy * 0.2);
+
+    // normals and tangents are the finite differences of the heights, normalised
+    const float TwoDx = 2.0f * kSpatialStep;
+    for (int i = 1; i < kRows - 1; ++i)
+    {
+        for (int j = 1; j < kCols - 1; ++j)
+        {
+            float l = Reference.Curr(i, j - 1), r = Reference.Curr(i, j + 1);
+            float t = Reference.Curr(i - 1, j), b = Reference.Curr(i + 1, j);
+            float InvN = 1.0f / sqrtf(TwoDx * TwoDx + (l - r) * (l - r) + (b - t) * (b - t));
+            float InvT = 1.0f / sqrtf(TwoDx * TwoDx + (r - l) * (r - l));
+
+            DirectX::XMFLOAT3 N = Grid.Normal(i * kCols + j);
+            DirectX::XMFLOAT3 T = Grid.TangentX(i * kCols + j);
+            CHECK(fabsf(N.x - (l - r) * InvN) <= 1e-5f);
+            CHECK(fabsf(N.y - TwoDx * InvN) <= 1e-5f);
+            CHECK(fabsf(N.z - (b - t) * InvN) <= 1e-5f);
+            CHECK(fabsf(T.x - TwoDx * InvT) <= 1e-5f);
+            CHECK(fabsf(T.y - (r - l) * InvT) <= 1e-5f);
+            CHECK(T.z == 0.0f);
+        }
+    }
+}
+
+// The accessors show the last published snapshot while an update is queued or running, and
+// the new one once WaitForUpdate returns. Disturbances queued meanwhile wait for the next
+// update.
+static void TestAsyncSnapshot(void)
+{
+    Waves Grid(kRows, kCols, kSpatialStep, kTimeStep, kSpeed, kDamping);
+    ReferenceWaves Reference;
+    Grid.Disturb(18, 20, 1.0f);
+    Reference.Disturb(18, 20, 1.0f);
+    CHECK(Grid.Update(kTimeStep) == 1);
+    Reference.Step();
+
+    const std::vector<float> Published(Grid.Heights(), Grid.Heights() + kRows * kCols);
+    const DirectX::XMFLOAT3 PublishedNormal = Grid.Normal(18 * kCols + 21);
+    {
+        PoolBlocker Blocker;
+        Grid.UpdateAsync(3.5f * kTimeStep);
+        Grid.Disturb(5, 5, 2.0f);
+
+        CHECK(Grid.StepCount() == 1);
+        CHECK(MaxDifference(Grid.Heights(), Published) == 0.0f);
+        CHECK(Grid.Normal(18 * kCols + 21).x == PublishedNormal.x);
+        CHECK(Grid.Position(18 * kCols + 20).y == Published[18 * kCols + 20]);
+    }
+    Grid.WaitForUpdate();
+    for (int s = 0; s < 3; ++s)
+        Reference.Step();
+
+    CHECK(Grid.StepCount() == 4);
+    CHECK(MaxDifference(Grid.Heights(), Reference.Heights()) <= 1e-6f);
+
+    // the disturbance made during the update was not in it, it is published by the next one
+    // even when that one has too little time to step
+    CHECK(Grid.Update(0.0f) == 0);
+    Reference.Disturb(5, 5, 2.0f);
+    CHECK(Grid.StepCount() == 4);
+    CHECK(MaxDifference(Grid.Heights(), Reference.Heights()) <= 1e-6f);
+    CHECK(Grid.Heights()[5 * kCols + 5] >= 2.0f - 1e-6f);
+}
+
+int main(void)
+{
+    ThreadPool::Initialize(2);
+
+    TestAccumulator();
+    TestSubstepCap();
+    TestMatchesReferenceAndLosesEnergy();
+    TestAsyncSnapshot();
+
+    ThreadPool::Shutdown();
+    return Test::Finish("WavesTest");
+}
@@ -2,6 +2,9 @@
 #include <DirectXMath.h>
 #include <string>
 #include "GpuBuffer.h"
+#include "DynamicVertexBuffer.h"
+#include "MeshletBuilder.h"
+#include "VertexQuantizer.h"
 
 
 
@@ -19,6 +22,8 @@ struct Material
 	UINT NormalMapIndex = 0;
 	UINT MaterialPad[2];
 
+	// dense id packed into render item sort keys
+	UINT SortId = 0;
 };
 
 struct Vertex {
@@ -33,7 +38,12 @@ struct SubmeshGeometry
 	UINT IndexCount = 0;
 	UINT StartIndexLocation = 0;
 	INT BaseVertexLocation = 0;
-	
+
+	// object space distance from the full detail submesh, for the coarser levels of a LOD chain
+	float LodError = 0.0f;
+
+	// clusters of the same triangles, their indices relative to BaseVertexLocation
+	std::shared_ptr<Utility::MeshletMesh> Meshlets;
 };
 
 struct MeshGeometry
@@ -44,7 +54,23 @@ struct MeshGeometry
 	StructuredBuffer m_VertexBuffer;
 	ByteAddressBuffer m_IndexBuffer;
 
+	// CPU-animated meshes (waves) stream their vertices through a ring of upload memory
+	std::unique_ptr<DynamicVertexBuffer> m_DynamicVertexBuffer;
+
+	D3D12_VERTEX_BUFFER_VIEW VertexBufferView() const
+	{
+		return m_DynamicVertexBuffer ? m_DynamicVertexBuffer->VertexBufferView() : m_VertexBuffer.VertexBufferView();
+	}
+
 	std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
+
+	// vertices stored as Utility::CompactVertex, drawn with the "_compact" twin of each pipeline
+	bool CompactVertices = false;
+	DirectX::XMFLOAT3 PositionScale = { 1.0f, 1.0f, 1.0f };
+	DirectX::XMFLOAT3 PositionBias = { 0.0f, 0.0f, 0.0f };
+
+	// dense id packed into render item sort keys
+	UINT SortId = 0;
 };
 
 // shader constants
@@ -77,6 +103,9 @@ __declspec(align(16)) struct ObjConstants
 	DirectX::XMFLOAT4X4 MatTransform;
 	UINT MaterialIndex = 0;
 	UINT ObjPad[3];
+	// dequantizes the positions of compact vertices, see MeshGeometry
+	DirectX::XMFLOAT4 PositionScale;
+	DirectX::XMFLOAT4 PositionBias;
 };
 
 #define MaxLights 16
@@ -0,0 +1,120 @@
+#include "common.hlsli"
+
+// Culls the instances of a batch against the frustum and writes the visible ones, in order,
+// as the commands ExecuteIndirect reads. Mirrors Utility::CullInstances step for step, the
+// precise variables keep the compiler from fusing or reordering the arithmetic.
+
+struct IndirectInstance
+{
+    float3 Center;
+    float Radius;   // negative is never culled
+    uint ObjectIndex;
+    uint IndexCount;
+    uint StartIndexLocation;
+    int BaseVertexLocation;
+};
+
+struct IndirectBatch
+{
+    uint FirstInstance;
+    uint InstanceCount;
+    uint2 Pad;
+};
+
+cbuffer cbCull : register(b0, space4)
+{
+    // world space, a * x + b * y + c * z + d >= 0 inside
+    float4 gPlanes[6];
+};
+
+StructuredBuffer<IndirectInstance> gInstances : register(t0, space4);
+StructuredBuffer<IndirectBatch> gBatches : register(t1, space4);
+// 24 bytes per command: object index, then D3D12_DRAW_INDEXED_ARGUMENTS
+RWByteAddressBuffer gCommands : register(u0, space4);
+// visible instances per batch
+RWByteAddressBuffer gCounts : register(u1, space4);
+
+#define GROUP_SIZE 64
+#define COMMAND_SIZE 24
+
+groupshared uint gsPrefix[GROUP_SIZE];
+
+bool IsVisible(IndirectInstance instance)
+{
+    if (!(instance.Radius >= 0.0f))
+        return true;
+
+    float4x4 world = gObjectData[instance.ObjectIndex].gWorld;
+
+    precise float3 center;
+    [unroll]
+    for (int j = 0; j < 3; ++j)
+        center[j] = ((instance.Center.x * world[0][j] + instance.Center.y * world[1][j]) + instance.Center.z * world[2][j]) + world[3][j];
+
+    // squared length of the longest axis, the sphere grows by that much at most
+    precise float scale2 = 0.0f;
+    [unroll]
+    for (int i = 0; i < 3; ++i)
+    {
+        precise float length2 = (world[i][0] * world[i][0] + world[i][1] * world[i][1]) + world[i][2] * world[i][2];
+        scale2 = length2 > scale2 ? length2 : scale2;
+    }
+    precise float radius2 = (instance.Radius * instance.Radius) * scale2;
+
+    // squares instead of the radius, sqrt is not exact on the GPU
+    [unroll]
+    for (int p = 0; p < 6; ++p)
+    {
+        precise float distance = ((gPlanes[p].x * center.x + gPlanes[p].y * center.y) + gPlanes[p].z * center.z) + gPlanes[p].w;
+        precise float distance2 = distance * distance;
+        if (distance < 0.0f && distance2 > radius2)
+            return false;
+    }
+    return true;
+}
+
+// one group per batch
+[numthreads(GROUP_SIZE, 1, 1)]
+void main(uint3 groupID : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    IndirectBatch batch = gBatches[groupID.x];
+
+    // the same for every thread, so is the loop
+    uint written = 0;
+    for (uint first = 0; first < batch.InstanceCount; first += GROUP_SIZE)
+    {
+        IndirectInstance instance = (IndirectInstance)0;
+        uint visible = 0;
+        if (first + groupIndex < batch.InstanceCount)
+        {
+            instance = gInstances[batch.FirstInstance + first + groupIndex];
+            visible = IsVisible(instance) ? 1 : 0;
+        }
+
+        // inclusive prefix sum of the visible flags
+        gsPrefix[groupIndex] = visible;
+        GroupMemoryBarrierWithGroupSync();
+        [unroll]
+        for (uint offset = 1; offset < GROUP_SIZE; offset <<= 1)
+        {
+            uint add = groupIndex >= offset ? gsPrefix[groupIndex - offset] : 0;
+            GroupMemoryBarrierWithGroupSync();
+            gsPrefix[groupIndex] += add;
+            GroupMemoryBarrierWithGroupSync();
+        }
+
+        if (visible != 0)
+        {
+            uint address = (batch.FirstInstance + written + gsPrefix[groupIndex] - 1) * COMMAND_SIZE;
+            gCommands.Store3(address, uint3(instance.ObjectIndex, instance.IndexCount, 1));
+            gCommands.Store3(address + 12, uint3(instance.StartIndexLocation, asuint(instance.BaseVertexLocation), 0));
+        }
+
+        written += gsPrefix[GROUP_SIZE - 1];
+        // everyone has read the sum before the next chunk overwrites it
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (groupIndex == 0)
+        gCounts.Store(groupID.x * 4, written);
+}
@@ -236,12 +236,12 @@ float4 main(VertexOut input) : SV_TARGET
     
     input.normal = normalize(input.normal);
     
-    float4 normalMapSample = gNormalMap[normalMapIndex].Sample(gsamLinearClamp, input.tex);
+    float4 normalMapSample = gTextureMaps[normalMapIndex].Sample(gsamLinearClamp, input.tex);
     
     float3 normalW = TangentToWorldSpace(normalMapSample.rgb, input.tangentW, input.normal);
     //float normalW = input.normal;
     
-    diffuseAlbedo *= gDiffuseMap[diffuseMapIndex].Sample(gsamLinearClamp, input.tex);
+    diffuseAlbedo *= gTextureMaps[diffuseMapIndex].Sample(gsamLinearClamp, input.tex);
     
     // alpha tested
     clip(diffuseAlbedo.a - 0.1f);
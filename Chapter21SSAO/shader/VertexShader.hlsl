@@ -1,7 +1,13 @@
 #include "common.hlsli"
 
+#ifdef COMPACT_VERTEX
+VertexOut main(CompactVertexIn compact)
+{
+    VertexIn input = DecodeVertex(compact);
+#else
 VertexOut main(VertexIn input) 
 {
+#endif
     VertexOut output;
     
     //MaterialData matData = gMaterialData[objConstants.gMaterialIndex];
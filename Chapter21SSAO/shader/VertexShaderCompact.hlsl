@@ -0,0 +1,3 @@
+// VertexShader.hlsl for meshes stored as Utility::CompactVertex
+#define COMPACT_VERTEX
+#include "VertexShader.hlsl"
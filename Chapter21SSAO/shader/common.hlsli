@@ -13,6 +13,9 @@ struct ObjConstants
     uint gObjPad1;
     uint gObjPad2;
     uint gObjPad3;
+    // compact vertex positions decode to the unorm value * gPositionScale + gPositionBias
+    float4 gPositionScale;
+    float4 gPositionBias;
 };
 
 struct Light
@@ -53,12 +56,22 @@ struct MaterialData
     uint MatPad1;
 };
 
-ConstantBuffer<ObjConstants> objConstants : register(b0);
+// index of the object being drawn into gObjectData, set as a root constant per draw
+cbuffer cbObjectIndex : register(b0)
+{
+    uint gObjectIndex;
+};
+
+// constants of every render item, uploaded once per frame
+StructuredBuffer<ObjConstants> gObjectData : register(t0, space2);
+
+#define objConstants gObjectData[gObjectIndex]
+
 ConstantBuffer<PassConstants> passConstants : register(b1);
 
 TextureCube gCubeMap : register(t0);
-Texture2D gDiffuseMap[8] : register(t1);
-Texture2D gNormalMap[3] : register(t1, space1);
+// every persistent slot of the bindless heap, indexed by gDiffuseMapIndex and gNormalMapIndex
+Texture2D gTextureMaps[] : register(t0, space3);
 Texture2D gShadowMap : register(t1, space2);
 // structured buffer
 StructuredBuffer<MaterialData> gMaterialData : register(t0, space1);
@@ -73,6 +86,34 @@ struct VertexIn
     float3 tangentU : TANGENT;
 };
 
+// Utility::CompactVertex, see VertexQuantizer.h
+struct CompactVertexIn
+{
+    float4 position : POSITION;
+    float2 normal : NORMAL;
+    float2 tex : TEXCOORD;
+    float2 tangentU : TANGENT;
+};
+
+// unit vector from its octahedral encoding, the lower half of the sphere is folded over the corners
+float3 DecodeOctahedral(float2 e)
+{
+    float3 v = float3(e, 1.0 - abs(e.x) - abs(e.y));
+    float fold = saturate(-v.z);
+    v.xy += v.xy >= 0.0 ? -fold : fold;
+    return normalize(v);
+}
+
+VertexIn DecodeVertex(CompactVertexIn vin)
+{
+    VertexIn v;
+    v.position = vin.position.xyz * objConstants.gPositionScale.xyz + objConstants.gPositionBias.xyz;
+    v.normal = DecodeOctahedral(vin.normal);
+    v.tex = vin.tex;
+    v.tangentU = DecodeOctahedral(vin.tangentU);
+    return v;
+}
+
 struct VertexOut
 {
     float3 normal : NORMAL;
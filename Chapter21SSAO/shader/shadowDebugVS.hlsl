@@ -1,7 +1,13 @@
 #include "common.hlsli"
 
+#ifdef COMPACT_VERTEX
+VertexOut main(CompactVertexIn compact)
+{
+    VertexIn vin = DecodeVertex(compact);
+#else
 VertexOut main(VertexIn vin)
 {
+#endif
     VertexOut vout;
     
     vout.positionH = float4(vin.position, 1.0);
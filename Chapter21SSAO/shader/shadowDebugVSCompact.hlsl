@@ -0,0 +1,3 @@
+// shadowDebugVS.hlsl for meshes stored as Utility::CompactVertex
+#define COMPACT_VERTEX
+#include "shadowDebugVS.hlsl"
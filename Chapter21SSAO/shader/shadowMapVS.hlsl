@@ -1,7 +1,13 @@
 #include "common.hlsli"
 
+#ifdef COMPACT_VERTEX
+VertexOut main(CompactVertexIn compact)
+{
+    VertexIn vin = DecodeVertex(compact);
+#else
 VertexOut main(VertexIn vin)
 {
+#endif
     VertexOut vout;
     float4 posW = mul(float4(vin.position, 1.0), objConstants.gWorld);
     vout.positionW = posW.xyz;
@@ -0,0 +1,3 @@
+// shadowMapVS.hlsl for meshes stored as Utility::CompactVertex
+#define COMPACT_VERTEX
+#include "shadowMapVS.hlsl"